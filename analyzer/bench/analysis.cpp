@@ -0,0 +1,173 @@
+//===- analysis.cpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file benchmarks the end-to-end analysis of generated functions
+//  with deep loop nests, and the fixpoint engine alone on the synthetic
+//  functions scaled along each dimension of their shape.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/context.hpp"
+#include "analyzer/tooling/diagnostic.hpp"
+#include "analyzer/tooling/knight.hpp"
+#include "analyzer/tooling/options.hpp"
+#include "analyzer/tooling/stats.hpp"
+#include "common/util/vfs.hpp"
+#include "perf_scope.hpp"
+#include "synthetic.hpp"
+
+#include <benchmark/benchmark.h>
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+
+namespace knight::bench {
+
+namespace {
+
+constexpr llvm::StringLiteral BenchFile = "/knight-bench/loops.c";
+
+void bm_analyze_loop_nest(benchmark::State& state) {
+    SyntheticShape shape;
+    shape.depth = static_cast< unsigned >(state.range(0));
+    shape.blocks = 1U;
+    shape.vars = static_cast< unsigned >(state.range(1));
+    const auto code = generate_function(shape);
+    const clang::tooling::FixedCompilationDatabase cdb("/knight-bench",
+                                                       {"-std=c11"});
+
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        auto opts_provider =
+            std::make_unique< KnightOptionsCommandLineProvider >();
+        opts_provider->options.analyses = "*";
+        opts_provider->options.checkers = "-*";
+        KnightContext ctx(std::move(opts_provider));
+
+        auto base_fs = fs::create_base_vfs();
+        auto memory_fs =
+            llvm::makeIntrusiveRefCnt< llvm::vfs::InMemoryFileSystem >();
+        memory_fs->addFile(BenchFile,
+                           0,
+                           llvm::MemoryBuffer::getMemBufferCopy(code));
+        base_fs->pushOverlay(memory_fs);
+
+        KnightDriver driver(ctx, cdb, {BenchFile.str()}, base_fs);
+        auto diags = driver.run();
+        benchmark::DoNotOptimize(diags);
+    }
+}
+BENCHMARK(bm_analyze_loop_nest)
+    ->ArgNames({"depth", "vars"})
+    ->ArgsProduct({{1, 4, 8}, {4, 32}})
+    ->Unit(benchmark::kMillisecond);
+
+/// \brief A synthetic function parsed once, analyzed on each iteration by
+/// the analyses on a fresh consumer, as the workers of the driver do.
+class ParsedFunction {
+  private:
+    std::unique_ptr< clang::ASTUnit > m_ast;
+    KnightContext m_ctx;
+    KnightDiagnosticConsumer m_diag_consumer{m_ctx};
+    clang::DiagnosticsEngine m_diag_engine{new clang::DiagnosticIDs(),
+                                           new clang::DiagnosticOptions(),
+                                           &m_diag_consumer,
+                                           false};
+    KnightASTConsumerFactory m_factory{m_ctx};
+
+  public:
+    explicit ParsedFunction(const std::string& code)
+        : m_ast(clang::tooling::buildASTFromCodeWithArgs(code,
+                                                         {"-std=c11"},
+                                                         BenchFile)),
+          m_ctx(make_options_provider()) {
+        m_ctx.set_diagnostic_engine(&m_diag_engine);
+    }
+
+    void analyze() {
+        auto& ast_ctx = m_ast->getASTContext();
+        auto consumer = m_factory.create_ast_consumer(ast_ctx, BenchFile);
+        for (auto* decl : ast_ctx.getTranslationUnitDecl()->decls()) {
+            consumer->HandleTopLevelDecl(clang::DeclGroupRef(decl));
+        }
+        consumer->HandleTranslationUnit(ast_ctx);
+        m_diag_consumer.take_diags();
+    }
+
+  private:
+    static std::unique_ptr< KnightOptionsCommandLineProvider >
+    make_options_provider() {
+        auto opts_provider =
+            std::make_unique< KnightOptionsCommandLineProvider >();
+        opts_provider->options.analyses = "*";
+        opts_provider->options.checkers = "-*";
+        return opts_provider;
+    }
+}; // class ParsedFunction
+
+/// \brief Analyze the synthetic function whose dimension \p dim is the
+/// benchmark argument, the others keeping their default.
+///
+/// The parsing is left out of the measure, and the fixpoint iterations of
+/// one untimed analysis are reported along with the time.
+void bm_fixpoint(benchmark::State& state, unsigned SyntheticShape::*dim) {
+    SyntheticShape shape;
+    shape.*dim = static_cast< unsigned >(state.range(0));
+    ParsedFunction function(generate_function(shape));
+
+    auto& stats = Stats::get();
+    const bool is_stats_enabled = stats.is_enabled();
+    const auto iterations = stats.get_count(StatKind::CycleIterations);
+    stats.set_enabled(true);
+    function.analyze();
+    stats.set_enabled(is_stats_enabled);
+    state.counters["fixpoint_iterations"] = static_cast< double >(
+        stats.get_count(StatKind::CycleIterations) - iterations);
+
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        function.analyze();
+    }
+}
+BENCHMARK_CAPTURE(bm_fixpoint, depth, &SyntheticShape::depth)
+    ->ArgName("depth")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_fixpoint, blocks, &SyntheticShape::blocks)
+    ->ArgName("blocks")
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_fixpoint, cases, &SyntheticShape::cases)
+    ->ArgName("cases")
+    ->RangeMultiplier(4)
+    ->Range(2, 128)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_fixpoint, vars, &SyntheticShape::vars)
+    ->ArgName("vars")
+    ->RangeMultiplier(4)
+    ->Range(4, 256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_fixpoint, pointers, &SyntheticShape::pointers)
+    ->ArgName("pointers")
+    ->RangeMultiplier(4)
+    ->Range(2, 32)
+    ->Unit(benchmark::kMillisecond);
+
+} // anonymous namespace
+
+} // namespace knight::bench
@@ -0,0 +1,77 @@
+//===- bench_env.hpp --------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the environment shared by the analyzer benchmarks.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/core/location_manager.hpp"
+#include "analyzer/core/symbol_manager.hpp"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Tooling/Tooling.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace knight::bench {
+
+/// \brief A tiny parsed function whose stack frame hosts the conjured
+/// symbols of the numerical variables used by the benchmarks.
+class SymbolEnv {
+  private:
+    std::unique_ptr< clang::ASTUnit > m_ast;
+    const clang::FunctionDecl* m_function{};
+    llvm::BumpPtrAllocator m_alloc;
+    analyzer::SymbolManager m_sym_mgr{m_alloc};
+    analyzer::LocationManager m_loc_mgr;
+    const analyzer::StackFrame* m_frame{};
+    /// \brief The tags of the conjured variables, which keep them apart
+    /// since a statement conjures a single symbol per frame and tag.
+    std::deque< unsigned > m_tags;
+
+  public:
+    SymbolEnv()
+        : m_ast(clang::tooling::buildASTFromCode("int f(void) { return 0; }",
+                                                 "bench.c")) {
+        auto& ast_ctx = m_ast->getASTContext();
+        for (auto* decl : ast_ctx.getTranslationUnitDecl()->decls()) {
+            if (const auto* function =
+                    llvm::dyn_cast< clang::FunctionDecl >(decl)) {
+                m_function = function;
+            }
+        }
+        m_frame = m_loc_mgr.create_top_frame(m_function);
+    }
+
+    /// \brief Conjure \p num fresh integer variables.
+    [[nodiscard]] std::vector< analyzer::ZVariable > make_vars(unsigned num) {
+        std::vector< analyzer::ZVariable > vars;
+        vars.reserve(num);
+        const auto int_ty = m_ast->getASTContext().IntTy;
+        const auto* body = m_function->getBody();
+        for (unsigned i = 0U; i < num; ++i) {
+            m_tags.push_back(static_cast< unsigned >(m_tags.size()));
+            vars.emplace_back(m_sym_mgr.get_symbol_conjured(body,
+                                                            int_ty,
+                                                            m_frame,
+                                                            &m_tags.back()));
+        }
+        return vars;
+    }
+
+}; // class SymbolEnv
+
+} // namespace knight::bench
@@ -0,0 +1,687 @@
+//===- main.cpp -------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This is the main file of the knight corpus benchmark, running the
+//  analyzer over a pinned set of real projects and comparing the results
+//  against a baseline.
+//
+//===------------------------------------------------------------------===//
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/InitLLVM.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+using ErrCode = uint8_t;
+constexpr ErrCode NormalExit = 0U;
+constexpr ErrCode RegressionFound = 1U;
+constexpr ErrCode ManifestFailure = 2U;
+constexpr ErrCode BaselineFailure = 3U;
+constexpr ErrCode RunFailure = 4U;
+constexpr ErrCode OutputFailure = 5U;
+
+constexpr double MicrosPerMilli = 1e3;
+constexpr double Percent = 100.0;
+
+cl::OptionCategory corpus_category("knight-bench-corpus options");
+
+cl::opt< std::string > manifest_file(cl::Positional,
+                                     cl::desc("<corpus manifest>"),
+                                     cl::Required,
+                                     cl::cat(corpus_category));
+
+cl::opt< std::string > corpus_dir(
+    "corpus-dir",
+    cl::desc("Directory of the fetched projects, the one of the manifest "
+             "by default"),
+    cl::value_desc("directory"),
+    cl::cat(corpus_category));
+
+cl::opt< std::string > analyzer_path(
+    "analyzer",
+    cl::desc("Path of knight-analyzer, the one next to this tool by "
+             "default"),
+    cl::value_desc("path"),
+    cl::cat(corpus_category));
+
+cl::list< std::string > analyzer_args(
+    "analyzer-arg",
+    cl::desc("Pass the argument to the analyzer on every project"),
+    cl::ZeroOrMore,
+    cl::cat(corpus_category));
+
+cl::list< std::string > only_projects(
+    "project",
+    cl::desc("Only run the given projects of the manifest"),
+    cl::ZeroOrMore,
+    cl::CommaSeparated,
+    cl::cat(corpus_category));
+
+cl::opt< std::string > output_file(
+    "o",
+    cl::desc("Write the results to the given JSON file, which can be "
+             "kept as the baseline of the later runs"),
+    cl::value_desc("file"),
+    cl::init("knight-bench-corpus.json"),
+    cl::cat(corpus_category));
+
+cl::opt< std::string > baseline_file(
+    "baseline",
+    cl::desc("Compare the results against the given results file"),
+    cl::value_desc("file"),
+    cl::cat(corpus_category));
+
+cl::opt< double > threshold(
+    "threshold",
+    cl::desc("Relative increase in percent over the baseline reported as "
+             "a regression"),
+    cl::init(10.0),
+    cl::cat(corpus_category));
+
+cl::opt< double > min_time_ms(
+    "min-time-ms",
+    cl::desc("Ignore the times below the given milliseconds in both the "
+             "baseline and the results, as they are mostly noise"),
+    cl::init(100.0),
+    cl::cat(corpus_category));
+
+cl::opt< unsigned > repeat(
+    "repeat",
+    cl::desc("Run each project the given times and keep the minimum of "
+             "the times and of the peak RSS"),
+    cl::init(1U),
+    cl::cat(corpus_category));
+
+/// \brief A project of the corpus, fetched at a pinned revision into its
+/// directory of the corpus.
+struct Project {
+    std::string name;
+    /// \brief Directory of the `compile_commands.json`, relative to the
+    /// corpus directory.
+    std::string build_dir;
+    /// \brief Fixed compile flags, used instead of a compilation database
+    /// when not empty.
+    std::vector< std::string > compile_flags;
+    /// \brief Files to analyze, relative to the corpus directory. All the
+    /// files of the compilation database if empty.
+    std::vector< std::string > files;
+    std::vector< std::string > args;
+    /// \brief Shell commands fetching and configuring the project.
+    std::vector< std::string > setup;
+}; // struct Project
+
+/// \brief The measures of one project.
+struct ProjectResult {
+    std::string name;
+    int exit_code = 0;
+    double wall_ms = 0.0;
+    double user_ms = 0.0;
+    uint64_t peak_rss_kib = 0U;
+    uint64_t iterations = 0U;
+    uint64_t diagnostics = 0U;
+    /// \brief Wall time in milliseconds of the functions, analyses and
+    /// checkers in total, and of each analysis and checker.
+    llvm::StringMap< double > phases;
+}; // struct ProjectResult
+
+std::vector< std::string > get_strings(const json::Object& object,
+                                       StringRef key) {
+    std::vector< std::string > strings;
+    if (const auto* array = object.getArray(key)) {
+        for (const auto& value : *array) {
+            if (auto str = value.getAsString()) {
+                strings.push_back(str->str());
+            }
+        }
+    }
+    return strings;
+}
+
+std::optional< json::Value > read_json(StringRef file) {
+    auto buffer = MemoryBuffer::getFile(file);
+    if (!buffer) {
+        WithColor::error() << "Cannot read `" << file
+                           << "`: " << buffer.getError().message() << "\n";
+        return std::nullopt;
+    }
+    auto value = json::parse((*buffer)->getBuffer());
+    if (!value) {
+        WithColor::error() << "Invalid JSON in `" << file
+                           << "`: " << toString(value.takeError()) << "\n";
+        return std::nullopt;
+    }
+    return std::move(*value);
+}
+
+std::optional< std::vector< Project > > read_manifest(StringRef file) {
+    auto manifest = read_json(file);
+    if (!manifest) {
+        return std::nullopt;
+    }
+    const auto* root = manifest->getAsObject();
+    const auto* projects = root != nullptr ? root->getArray("projects")
+                                           : nullptr;
+    if (projects == nullptr) {
+        WithColor::error() << "The manifest `" << file
+                           << "` has no `projects` array.\n";
+        return std::nullopt;
+    }
+    const auto common_args = get_strings(*root, "args");
+    std::vector< Project > result;
+    for (const auto& value : *projects) {
+        const auto* object = value.getAsObject();
+        auto name = object != nullptr ? object->getString("name")
+                                      : std::nullopt;
+        if (!name) {
+            WithColor::error() << "A project of the manifest has no name.\n";
+            return std::nullopt;
+        }
+        Project project{name->str(),
+                        object->getString("build_dir").value_or("").str(),
+                        get_strings(*object, "compile_flags"),
+                        get_strings(*object, "files"),
+                        common_args,
+                        get_strings(*object, "setup")};
+        for (auto& arg : get_strings(*object, "args")) {
+            project.args.push_back(std::move(arg));
+        }
+        result.push_back(std::move(project));
+    }
+    return result;
+}
+
+/// \brief Split the concatenated JSON values of the report file.
+std::vector< StringRef > split_json_values(StringRef text) {
+    std::vector< StringRef > values;
+    unsigned depth = 0U;
+    bool is_in_string = false;
+    bool is_escaped = false;
+    std::size_t start = 0U;
+    for (std::size_t idx = 0U; idx < text.size(); ++idx) {
+        const char chr = text[idx];
+        if (is_in_string) {
+            if (is_escaped) {
+                is_escaped = false;
+            } else if (chr == '\\') {
+                is_escaped = true;
+            } else if (chr == '"') {
+                is_in_string = false;
+            }
+            continue;
+        }
+        if (chr == '"') {
+            is_in_string = true;
+        } else if (chr == '{' || chr == '[') {
+            if (depth++ == 0U) {
+                start = idx;
+            }
+        } else if ((chr == '}' || chr == ']') && depth > 0U &&
+                   --depth == 0U) {
+            values.push_back(text.slice(start, idx + 1U));
+        }
+    }
+    return values;
+}
+
+void read_time_report(const json::Object& report, ProjectResult& result) {
+    for (StringRef kind : {"functions", "analyses", "checkers"}) {
+        const auto* entries = report.getArray(kind);
+        if (entries == nullptr) {
+            continue;
+        }
+        double total = 0.0;
+        for (const auto& value : *entries) {
+            const auto* entry = value.getAsObject();
+            if (entry == nullptr) {
+                continue;
+            }
+            const double wall = entry->getNumber("wall_ms").value_or(0.0);
+            total += wall;
+            if (kind != "functions") {
+                result.phases[(kind + ":" +
+                               entry->getString("name").value_or(""))
+                                  .str()] = wall;
+            }
+        }
+        result.phases[kind] = total;
+    }
+}
+
+/// \brief Read the time report and the statistics of the analyzer,
+/// printed in this order to the report file.
+bool read_reports(StringRef file, ProjectResult& result) {
+    auto buffer = MemoryBuffer::getFile(file);
+    if (!buffer) {
+        return false;
+    }
+    for (const auto text : split_json_values((*buffer)->getBuffer())) {
+        auto value = json::parse(text);
+        if (!value) {
+            consumeError(value.takeError());
+            return false;
+        }
+        const auto* report = value->getAsObject();
+        if (report == nullptr) {
+            return false;
+        }
+        if (report->get("cycles") != nullptr) {
+            read_time_report(*report, result);
+        } else if (auto iterations = report->getInteger("cycle_iterations")) {
+            result.iterations = static_cast< uint64_t >(*iterations);
+        }
+    }
+    return true;
+}
+
+uint64_t count_diagnostics(StringRef file) {
+    auto buffer = MemoryBuffer::getFile(file);
+    if (!buffer) {
+        return 0U;
+    }
+    SmallVector< StringRef > lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    return lines.size();
+}
+
+/// \brief Whether the compilation database and the files of the project
+/// are in the corpus directory.
+bool is_set_up(const Project& project) {
+    if (project.compile_flags.empty()) {
+        SmallString< 128 > cdb(corpus_dir);
+        sys::path::append(cdb, project.build_dir, "compile_commands.json");
+        if (!sys::fs::exists(cdb)) {
+            return false;
+        }
+    }
+    return llvm::all_of(project.files, [](const std::string& file) {
+        SmallString< 128 > path(corpus_dir);
+        sys::path::append(path, file);
+        return sys::fs::exists(path);
+    });
+}
+
+std::optional< ProjectResult > run_project(const Project& project,
+                                           StringRef analyzer,
+                                           StringRef work_dir) {
+    SmallString< 128 > report_path(work_dir);
+    sys::path::append(report_path, project.name + ".report.json");
+    SmallString< 128 > diags_path(work_dir);
+    sys::path::append(diags_path, project.name + ".diags.jsonl");
+    SmallString< 128 > log_path(work_dir);
+    sys::path::append(log_path, project.name + ".log");
+    (void)sys::fs::remove(report_path);
+    (void)sys::fs::remove(diags_path);
+
+    std::vector< std::string > args{analyzer.str()};
+    if (project.compile_flags.empty()) {
+        SmallString< 128 > build_dir(corpus_dir);
+        sys::path::append(build_dir, project.build_dir);
+        args.push_back("-p=" + build_dir.str().str());
+    }
+    if (project.files.empty()) {
+        // The only shard holds all the files of the compilation database.
+        args.emplace_back("--shard=0/1");
+    }
+    for (const auto& file : project.files) {
+        SmallString< 128 > path(corpus_dir);
+        sys::path::append(path, file);
+        args.push_back(path.str().str());
+    }
+    args.insert(args.end(),
+                {"--quiet",
+                 "--time-report=json",
+                 "--analyzer-stats=json",
+                 "--report-file=" + report_path.str().str(),
+                 "--stream-diags=" + diags_path.str().str()});
+    args.insert(args.end(), project.args.begin(), project.args.end());
+    args.insert(args.end(), analyzer_args.begin(), analyzer_args.end());
+    if (!project.compile_flags.empty()) {
+        args.emplace_back("--");
+        args.insert(args.end(),
+                    project.compile_flags.begin(),
+                    project.compile_flags.end());
+    }
+
+    const std::vector< StringRef > arg_refs(args.begin(), args.end());
+    const std::optional< StringRef > redirects[] = {StringRef(""),
+                                                    log_path.str(),
+                                                    log_path.str()};
+    std::string err_msg;
+    bool is_failed = false;
+    std::optional< sys::ProcessStatistics > proc_stats;
+    ProjectResult result;
+    result.name = project.name;
+    result.exit_code = sys::ExecuteAndWait(analyzer,
+                                           arg_refs,
+                                           std::nullopt,
+                                           redirects,
+                                           0U,
+                                           0U,
+                                           &err_msg,
+                                           &is_failed,
+                                           &proc_stats);
+    if (is_failed) {
+        WithColor::error() << "Cannot run `" << analyzer
+                           << "`: " << err_msg << "\n";
+        return std::nullopt;
+    }
+    if (result.exit_code != 0) {
+        WithColor::warning() << project.name << ": the analyzer exited with "
+                             << result.exit_code << ", see `" << log_path
+                             << "`.\n";
+    }
+    if (proc_stats) {
+        result.wall_ms = static_cast< double >(proc_stats->TotalTime.count()) /
+                         MicrosPerMilli;
+        result.user_ms = static_cast< double >(proc_stats->UserTime.count()) /
+                         MicrosPerMilli;
+        result.peak_rss_kib = proc_stats->PeakMemory;
+    }
+    if (!read_reports(report_path, result)) {
+        WithColor::error() << project.name << ": cannot read the reports `"
+                           << report_path << "`.\n";
+        return std::nullopt;
+    }
+    result.diagnostics = count_diagnostics(diags_path);
+    return result;
+}
+
+/// \brief Keep the minimum of the times and of the peak RSS of two runs,
+/// the iterations and the diagnostics being the same.
+void merge_min(ProjectResult& result, const ProjectResult& other) {
+    result.wall_ms = std::min(result.wall_ms, other.wall_ms);
+    result.user_ms = std::min(result.user_ms, other.user_ms);
+    result.peak_rss_kib = std::min(result.peak_rss_kib, other.peak_rss_kib);
+    for (auto& phase : result.phases) {
+        auto it = other.phases.find(phase.getKey());
+        if (it != other.phases.end()) {
+            phase.second = std::min(phase.second, it->second);
+        }
+    }
+}
+
+json::Object to_json(const ProjectResult& result) {
+    json::Object phases;
+    for (const auto& phase : result.phases) {
+        phases[phase.getKey()] = phase.second;
+    }
+    return json::Object{{"name", result.name},
+                        {"exit_code", result.exit_code},
+                        {"wall_ms", result.wall_ms},
+                        {"user_ms", result.user_ms},
+                        {"peak_rss_kib", result.peak_rss_kib},
+                        {"iterations", result.iterations},
+                        {"diagnostics", result.diagnostics},
+                        {"phases", std::move(phases)}};
+}
+
+std::optional< ProjectResult > from_json(const json::Value& value) {
+    const auto* object = value.getAsObject();
+    auto name = object != nullptr ? object->getString("name") : std::nullopt;
+    if (!name) {
+        return std::nullopt;
+    }
+    ProjectResult result;
+    result.name = name->str();
+    result.exit_code =
+        static_cast< int >(object->getInteger("exit_code").value_or(0));
+    result.wall_ms = object->getNumber("wall_ms").value_or(0.0);
+    result.user_ms = object->getNumber("user_ms").value_or(0.0);
+    result.peak_rss_kib =
+        static_cast< uint64_t >(object->getInteger("peak_rss_kib")
+                                    .value_or(0));
+    result.iterations =
+        static_cast< uint64_t >(object->getInteger("iterations").value_or(0));
+    result.diagnostics =
+        static_cast< uint64_t >(object->getInteger("diagnostics")
+                                    .value_or(0));
+    if (const auto* phases = object->getObject("phases")) {
+        for (const auto& [key, phase] : *phases) {
+            result.phases[key.str()] = phase.getAsNumber().value_or(0.0);
+        }
+    }
+    return result;
+}
+
+std::optional< llvm::StringMap< ProjectResult > > read_baseline(
+    StringRef file) {
+    auto baseline = read_json(file);
+    if (!baseline) {
+        return std::nullopt;
+    }
+    const auto* root = baseline->getAsObject();
+    const auto* projects = root != nullptr ? root->getArray("projects")
+                                           : nullptr;
+    if (projects == nullptr) {
+        WithColor::error() << "The baseline `" << file
+                           << "` has no `projects` array.\n";
+        return std::nullopt;
+    }
+    llvm::StringMap< ProjectResult > results;
+    for (const auto& value : *projects) {
+        if (auto result = from_json(value)) {
+            results[result->name] = std::move(*result);
+        }
+    }
+    return results;
+}
+
+/// \brief Print the change of a metric, and whether it regressed.
+bool compare_metric(raw_ostream& os,
+                    StringRef project,
+                    StringRef metric,
+                    double baseline,
+                    double current,
+                    bool is_time) {
+    if (is_time && baseline < min_time_ms && current < min_time_ms) {
+        return false;
+    }
+    const double change =
+        baseline > 0.0 ? (current - baseline) / baseline * Percent
+                       : (current > 0.0 ? Percent : 0.0);
+    const bool is_regression = change > threshold;
+    os << format("%14.1f %14.1f %+9.1f%%  ", baseline, current, change)
+       << project << " " << metric << (is_regression ? "  REGRESSION" : "")
+       << "\n";
+    return is_regression;
+}
+
+/// \brief Compare the results against the baseline, returns whether any
+/// metric regressed. A change of the diagnostics is a regression, as they
+/// shall be reviewed before updating the baseline.
+bool compare(raw_ostream& os,
+             const std::vector< ProjectResult >& results,
+             const llvm::StringMap< ProjectResult >& baseline) {
+    os << "      Baseline        Current    Change  Project Metric\n";
+    bool is_regression = false;
+    for (const auto& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end()) {
+            os << "  " << result.name << " is not in the baseline\n";
+            continue;
+        }
+        const auto& base = it->second;
+        is_regression |= compare_metric(os,
+                                        result.name,
+                                        "wall_ms",
+                                        base.wall_ms,
+                                        result.wall_ms,
+                                        true);
+        is_regression |= compare_metric(os,
+                                        result.name,
+                                        "user_ms",
+                                        base.user_ms,
+                                        result.user_ms,
+                                        true);
+        for (const auto& phase : result.phases) {
+            is_regression |=
+                compare_metric(os,
+                               result.name,
+                               phase.getKey(),
+                               base.phases.lookup(phase.getKey()),
+                               phase.second,
+                               true);
+        }
+        is_regression |=
+            compare_metric(os,
+                           result.name,
+                           "peak_rss_kib",
+                           static_cast< double >(base.peak_rss_kib),
+                           static_cast< double >(result.peak_rss_kib),
+                           false);
+        is_regression |=
+            compare_metric(os,
+                           result.name,
+                           "iterations",
+                           static_cast< double >(base.iterations),
+                           static_cast< double >(result.iterations),
+                           false);
+        if (base.diagnostics != result.diagnostics ||
+            base.exit_code != result.exit_code) {
+            os << "  " << result.name << ": " << base.diagnostics << " -> "
+               << result.diagnostics << " diagnostics, exit code "
+               << base.exit_code << " -> " << result.exit_code
+               << "  REGRESSION\n";
+            is_regression = true;
+        }
+    }
+    return is_regression;
+}
+
+std::string get_default_analyzer(const char* argv0) {
+    static int anchor = 0;
+    SmallString< 128 > path(sys::path::parent_path(
+        sys::fs::getMainExecutable(argv0, &anchor)));
+    sys::path::append(path, "knight-analyzer");
+    return path.str().str();
+}
+
+bool write_results(const std::vector< ProjectResult >& results) {
+    json::Array projects;
+    for (const auto& result : results) {
+        projects.push_back(to_json(result));
+    }
+    std::error_code err;
+    raw_fd_ostream os(output_file, err, sys::fs::OF_Text);
+    if (err) {
+        WithColor::error() << "Cannot write `" << output_file
+                           << "`: " << err.message() << "\n";
+        return false;
+    }
+    os << formatv("{0:2}",
+                  json::Value(json::Object{{"projects",
+                                            std::move(projects)}}))
+       << "\n";
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    const InitLLVM llvm_setup(argc, argv);
+    cl::HideUnrelatedOptions(corpus_category);
+    cl::ParseCommandLineOptions(
+        argc,
+        argv,
+        "Run knight-analyzer over the projects of a corpus manifest, "
+        "record their time, fixpoint iterations, peak RSS and diagnostics, "
+        "and compare them against a baseline.\n");
+
+    auto projects = read_manifest(manifest_file);
+    if (!projects) {
+        return ManifestFailure;
+    }
+    std::optional< llvm::StringMap< ProjectResult > > baseline;
+    if (!baseline_file.empty()) {
+        baseline = read_baseline(baseline_file);
+        if (!baseline) {
+            return BaselineFailure;
+        }
+    }
+    if (corpus_dir.empty()) {
+        corpus_dir = sys::path::parent_path(manifest_file).str();
+    }
+    if (analyzer_path.empty()) {
+        analyzer_path = get_default_analyzer(argv[0]);
+    }
+    SmallString< 128 > work_dir;
+    if (auto err = sys::fs::createUniqueDirectory("knight-bench-corpus",
+                                                  work_dir)) {
+        WithColor::error() << "Cannot create the work directory: "
+                           << err.message() << "\n";
+        return RunFailure;
+    }
+
+    std::vector< ProjectResult > results;
+    for (const auto& project : *projects) {
+        if (!only_projects.empty() &&
+            llvm::find(only_projects, project.name) == only_projects.end()) {
+            continue;
+        }
+        if (!is_set_up(project)) {
+            WithColor::error() << project.name << " is not set up in `"
+                               << corpus_dir << "`, run:\n";
+            for (const auto& command : project.setup) {
+                errs() << "  " << command << "\n";
+            }
+            return RunFailure;
+        }
+        std::optional< ProjectResult > result;
+        for (unsigned run = 0U; run < std::max(repeat.getValue(), 1U);
+             ++run) {
+            auto run_result = run_project(project, analyzer_path, work_dir);
+            if (!run_result) {
+                return RunFailure;
+            }
+            if (result) {
+                merge_min(*result, *run_result);
+            } else {
+                result = std::move(run_result);
+            }
+        }
+        outs() << format("%-16s %10.1f ms %10llu KiB %10llu iterations "
+                         "%8llu diagnostics\n",
+                         result->name.c_str(),
+                         result->wall_ms,
+                         static_cast< unsigned long long >(
+                             result->peak_rss_kib),
+                         static_cast< unsigned long long >(result->iterations),
+                         static_cast< unsigned long long >(
+                             result->diagnostics));
+        results.push_back(std::move(*result));
+    }
+
+    if (!write_results(results)) {
+        return OutputFailure;
+    }
+    if (baseline && compare(outs(), results, *baseline)) {
+        return RegressionFound;
+    }
+    return NormalExit;
+}
@@ -0,0 +1,157 @@
+//===- domain.cpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file benchmarks the separate numerical domains and the linear
+//  constraint systems.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/core/domain/numerical/interval_dom.hpp"
+#include "bench_env.hpp"
+#include "perf_scope.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace knight::bench {
+
+namespace {
+
+using analyzer::ZIntervalDom;
+using analyzer::ZLinearConstraintSystem;
+using analyzer::ZLinearExpr;
+using analyzer::ZNum;
+using analyzer::ZVariable;
+
+/// \brief Interval domain where `vars[i]` is in `[i, i + offset]`.
+ZIntervalDom make_dom(const std::vector< ZVariable >& vars, int64_t offset) {
+    ZIntervalDom dom(false);
+    for (std::size_t i = 0U; i < vars.size(); ++i) {
+        const auto lb = static_cast< int64_t >(i);
+        dom.set_value(vars[i],
+                      ZIntervalDom::IntervalT(ZNum(lb), ZNum(lb + offset)));
+    }
+    return dom;
+}
+
+void bm_interval_dom_join(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    const auto lhs = make_dom(vars, 0);
+    const auto rhs = make_dom(vars, 1);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        auto dom = lhs;
+        dom.join_with(rhs);
+        benchmark::DoNotOptimize(dom);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_interval_dom_join)->Range(8, 4096);
+
+void bm_interval_dom_widen(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    const auto lhs = make_dom(vars, 0);
+    const auto rhs = make_dom(vars, 1);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        auto dom = lhs;
+        dom.widen_with(rhs);
+        benchmark::DoNotOptimize(dom);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_interval_dom_widen)->Range(8, 4096);
+
+void bm_interval_dom_leq(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    const auto lhs = make_dom(vars, 0);
+    const auto rhs = make_dom(vars, 1);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs.leq(rhs));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_interval_dom_leq)->Range(8, 4096);
+
+void bm_interval_dom_assign_linear_expr(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    auto dom = make_dom(vars, 1);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        for (std::size_t i = 1U; i < vars.size(); ++i) {
+            dom.assign_linear_expr(vars[i], vars[i - 1] + ZNum(1));
+        }
+        benchmark::DoNotOptimize(dom);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_interval_dom_assign_linear_expr)->Range(8, 1024);
+
+/// \brief Chain of constraints `vars[i] - vars[i + 1] <= i`.
+ZLinearConstraintSystem make_chain(const std::vector< ZVariable >& vars) {
+    ZLinearConstraintSystem csts;
+    for (std::size_t i = 0U; i + 1U < vars.size(); ++i) {
+        csts.add_linear_constraint(
+            ZLinearExpr(vars[i]) <=
+            ZLinearExpr(vars[i + 1]) + ZNum(static_cast< int64_t >(i)));
+    }
+    return csts;
+}
+
+void bm_constraint_system_build(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        auto csts = make_chain(vars);
+        benchmark::DoNotOptimize(csts);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_constraint_system_build)->Range(8, 4096);
+
+void bm_interval_dom_solve(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    const auto csts = make_chain(vars);
+    const auto init = make_dom(vars, static_cast< int64_t >(vars.size()));
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        auto dom = init;
+        dom.merge_with_linear_constraint_system(csts);
+        benchmark::DoNotOptimize(dom);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_interval_dom_solve)->Range(8, 512);
+
+void bm_interval_dom_to_constraints(benchmark::State& state) {
+    SymbolEnv env;
+    const auto vars = env.make_vars(static_cast< unsigned >(state.range(0)));
+    const auto dom = make_dom(vars, 1);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        auto csts = dom.to_linear_constraint_system();
+        benchmark::DoNotOptimize(csts);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_interval_dom_to_constraints)->Range(8, 4096);
+
+} // anonymous namespace
+
+} // namespace knight::bench
@@ -0,0 +1,126 @@
+//===- num.cpp --------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file benchmarks the numbers and the intervals.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/core/domain/num/fixed_machine_znum.hpp"
+#include "analyzer/core/domain/num/machine_znum.hpp"
+#include "analyzer/core/domain/num/znum.hpp"
+#include "perf_scope.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace knight::bench {
+
+namespace {
+
+using analyzer::MachineInt32;
+using analyzer::MachineZNum;
+using analyzer::SmallInterval;
+using analyzer::ZInterval;
+using analyzer::ZNum;
+
+constexpr uint64_t MachineBitWidth = 32U;
+
+void bm_znum_arith(benchmark::State& state) {
+    const auto num = state.range(0);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        ZNum acc(1);
+        for (int64_t i = 1; i <= num; ++i) {
+            acc += ZNum(i);
+            acc *= ZNum(3);
+            acc -= ZNum(i);
+        }
+        benchmark::DoNotOptimize(acc);
+    }
+    state.SetItemsProcessed(state.iterations() * num);
+}
+BENCHMARK(bm_znum_arith)->Range(8, 4096);
+
+void bm_machine_znum_arith(benchmark::State& state) {
+    const auto num = state.range(0);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        MachineZNum acc(1, MachineBitWidth, analyzer::Signed);
+        const MachineZNum three(3, MachineBitWidth, analyzer::Signed);
+        for (int64_t i = 1; i <= num; ++i) {
+            const MachineZNum n(i, MachineBitWidth, analyzer::Signed);
+            acc = acc + n;
+            acc = acc * three;
+            acc = acc - n;
+        }
+        benchmark::DoNotOptimize(acc);
+    }
+    state.SetItemsProcessed(state.iterations() * num);
+}
+BENCHMARK(bm_machine_znum_arith)->Range(8, 4096);
+
+void bm_fixed_machine_znum_arith(benchmark::State& state) {
+    const auto num = state.range(0);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        MachineInt32 acc(1);
+        const MachineInt32 three(3);
+        for (int64_t i = 1; i <= num; ++i) {
+            const MachineInt32 n(i);
+            acc = acc + n;
+            acc = acc * three;
+            acc = acc - n;
+        }
+        benchmark::DoNotOptimize(acc);
+    }
+    state.SetItemsProcessed(state.iterations() * num);
+}
+BENCHMARK(bm_fixed_machine_znum_arith)->Range(8, 4096);
+
+void bm_interval_join_widen(benchmark::State& state) {
+    const auto num = state.range(0);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        ZInterval joined = ZInterval::bottom();
+        ZInterval widened(ZNum(0), ZNum(0));
+        for (int64_t i = 0; i < num; ++i) {
+            const ZInterval itv(ZNum(-i), ZNum(i));
+            joined.join_with(itv);
+            widened.widen_with(itv);
+        }
+        benchmark::DoNotOptimize(joined);
+        benchmark::DoNotOptimize(widened);
+    }
+    state.SetItemsProcessed(state.iterations() * num);
+}
+BENCHMARK(bm_interval_join_widen)->Range(8, 4096);
+
+void bm_small_interval_join_widen(benchmark::State& state) {
+    const auto num = state.range(0);
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        SmallInterval joined = SmallInterval::bottom();
+        SmallInterval widened(int64_t(0), int64_t(0));
+        for (int64_t i = 0; i < num; ++i) {
+            const SmallInterval itv(-i, i);
+            joined.join_with(itv);
+            widened.widen_with(itv);
+        }
+        benchmark::DoNotOptimize(joined);
+        benchmark::DoNotOptimize(widened);
+    }
+    state.SetItemsProcessed(state.iterations() * num);
+}
+BENCHMARK(bm_small_interval_join_widen)->Range(8, 4096);
+
+} // anonymous namespace
+
+} // namespace knight::bench
@@ -0,0 +1,58 @@
+//===- perf_scope.hpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the hardware counters of the analyzer benchmarks.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/util/perf_counters.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace knight::bench {
+
+/// \brief Report the hardware counters of the benchmark loop following it,
+/// per iteration, next to its time.
+///
+/// Nothing is reported if the counters are not available, e.g. in a
+/// container without the `perf_event_open` permission.
+class PerfCounterScope {
+  private:
+    benchmark::State& m_state;
+    PerfCounterValues m_start;
+
+  public:
+    explicit PerfCounterScope(benchmark::State& state)
+        : m_state(state), m_start(PerfCounters::get_thread_counters().read()) {}
+
+    PerfCounterScope(const PerfCounterScope&) = delete;
+    PerfCounterScope(PerfCounterScope&&) = delete;
+    PerfCounterScope& operator=(const PerfCounterScope&) = delete;
+    PerfCounterScope& operator=(PerfCounterScope&&) = delete;
+
+    ~PerfCounterScope() {
+        const auto& counters = PerfCounters::get_thread_counters();
+        if (!counters.is_available()) {
+            return;
+        }
+        const auto values = counters.read() - m_start;
+        for (unsigned kind = 0U; kind < NumPerfCounterKinds; ++kind) {
+            m_state.counters[PerfCounters::get_name(
+                                 static_cast< PerfCounterKind >(kind))
+                                 .str()] =
+                benchmark::Counter(static_cast< double >(values[kind]),
+                                   benchmark::Counter::kAvgIterations);
+        }
+    }
+
+}; // class PerfCounterScope
+
+} // namespace knight::bench
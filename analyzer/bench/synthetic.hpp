@@ -0,0 +1,93 @@
+//===- synthetic.hpp --------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the generator of the synthetic functions stressing
+//  the fixpoint engine.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+
+namespace knight::bench {
+
+/// \brief The shape of a synthetic function, each dimension scaling one
+/// part of the fixpoint engine independently of the others.
+struct SyntheticShape {
+    /// \brief Nesting depth of the loops, i.e., of the WTO components.
+    unsigned depth = 2U;
+    /// \brief Branches in each loop body, two blocks and a join each.
+    unsigned blocks = 2U;
+    /// \brief Cases of the switch in each loop body, none if zero.
+    unsigned cases = 0U;
+    /// \brief Integer variables, at least one.
+    unsigned vars = 8U;
+    /// \brief Pointers to the variables, half of them aliasing another
+    /// pointer on some paths.
+    unsigned pointers = 0U;
+}; // struct SyntheticShape
+
+/// \brief Generate the function `int f(int n)` of the given shape.
+///
+/// The code only depends on the shape, so that the scaling curves are
+/// reproducible across runs and hosts.
+[[nodiscard]] inline std::string generate_function(
+    const SyntheticShape& shape) {
+    const unsigned vars = shape.vars > 0U ? shape.vars : 1U;
+    std::string code;
+    llvm::raw_string_ostream os(code);
+    os << "int f(int n) {\n";
+    for (unsigned v = 0U; v < vars; ++v) {
+        os << "  int v" << v << " = " << v << ";\n";
+    }
+    for (unsigned p = 0U; p < shape.pointers; ++p) {
+        os << "  int *p" << p << " = &v" << p % vars << ";\n";
+        if (p % 2U == 1U) {
+            os << "  if (n > " << p << ") p" << p << " = p" << p - 1U
+               << ";\n";
+        }
+    }
+
+    for (unsigned d = 0U; d < shape.depth; ++d) {
+        const std::string indent(2U * (d + 1U), ' ');
+        const std::string idx = "i" + std::to_string(d);
+        os << indent << "for (int " << idx << " = 0; " << idx << " < n; ++"
+           << idx << ") {\n";
+        for (unsigned b = 0U; b < shape.blocks; ++b) {
+            const unsigned lhs = (d + b + 1U) % vars;
+            const unsigned rhs = (d + b) % vars;
+            os << indent << "  if (v" << rhs << " < " << idx << ") v" << lhs
+               << " = v" << rhs << " + " << b + 1U << "; else v" << lhs
+               << " = v" << lhs << " - 1;\n";
+        }
+        if (shape.cases > 0U) {
+            os << indent << "  switch (" << idx << " % " << shape.cases
+               << ") {\n";
+            for (unsigned c = 0U; c < shape.cases; ++c) {
+                os << indent << "  case " << c << ": v" << (d + c) % vars
+                   << " += " << c + 1U << "; break;\n";
+            }
+            os << indent << "  default: break;\n" << indent << "  }\n";
+        }
+        for (unsigned p = 0U; p < shape.pointers; ++p) {
+            os << indent << "  *p" << p << " = *p"
+               << (p + 1U) % shape.pointers << " + " << idx << ";\n";
+        }
+    }
+    for (unsigned d = shape.depth; d > 0U; --d) {
+        os << std::string(2U * d, ' ') << "}\n";
+    }
+    os << "  return v0;\n}\n";
+    return code;
+}
+
+} // namespace knight::bench
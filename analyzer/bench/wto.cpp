@@ -0,0 +1,146 @@
+//===- wto.cpp --------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file benchmarks the weak topological ordering construction on
+//  synthetic control flow graphs.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/util/wto.hpp"
+#include "perf_scope.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+namespace knight::bench {
+
+namespace {
+
+struct SyntheticNode {
+    unsigned id;
+    std::vector< const SyntheticNode* > preds;
+    std::vector< const SyntheticNode* > succs;
+
+    void dump(llvm::raw_ostream& os) const { os << "B" << id; }
+}; // struct SyntheticNode
+
+/// \brief Control flow graph of nested loops, each loop body being a
+/// switch of `fanout` arms followed by a chain of blocks around its inner
+/// loop.
+class SyntheticCFG {
+  public:
+    using GraphRef = const SyntheticCFG*;
+    using NodeRef = const SyntheticNode*;
+    using SuccNodeIterator = std::vector< NodeRef >::const_iterator;
+    using PredNodeIterator = std::vector< NodeRef >::const_iterator;
+
+  private:
+    std::vector< std::unique_ptr< SyntheticNode > > m_nodes;
+    unsigned m_fanout;
+
+  public:
+    SyntheticCFG(unsigned depth, unsigned width, unsigned fanout = 1U)
+        : m_fanout(fanout) {
+        auto* entry = add_node();
+        (void)add_loop(entry, depth, width);
+    }
+
+    [[nodiscard]] std::size_t size() const { return m_nodes.size(); }
+
+    static NodeRef entry(GraphRef graph) { return graph->m_nodes[0].get(); }
+    static SuccNodeIterator succ_begin(NodeRef node) {
+        return node->succs.begin();
+    }
+    static SuccNodeIterator succ_end(NodeRef node) { return node->succs.end(); }
+    static PredNodeIterator pred_begin(NodeRef node) {
+        return node->preds.begin();
+    }
+    static PredNodeIterator pred_end(NodeRef node) { return node->preds.end(); }
+    static unsigned get_node_id(NodeRef node) { return node->id; }
+    static unsigned num_nodes(GraphRef graph) {
+        return static_cast< unsigned >(graph->m_nodes.size());
+    }
+
+  private:
+    SyntheticNode* add_node() {
+        m_nodes.push_back(std::make_unique< SyntheticNode >());
+        m_nodes.back()->id = static_cast< unsigned >(m_nodes.size() - 1U);
+        return m_nodes.back().get();
+    }
+
+    static void add_edge(SyntheticNode* src, SyntheticNode* dst) {
+        src->succs.push_back(dst);
+        dst->preds.push_back(src);
+    }
+
+    SyntheticNode* add_chain(SyntheticNode* from, unsigned width) {
+        for (unsigned i = 0U; i < width; ++i) {
+            auto* node = add_node();
+            add_edge(from, node);
+            from = node;
+        }
+        return from;
+    }
+
+    /// \returns the join block of the arms
+    SyntheticNode* add_switch(SyntheticNode* from) {
+        if (m_fanout <= 1U) {
+            return from;
+        }
+        std::vector< SyntheticNode* > arms;
+        arms.reserve(m_fanout);
+        for (unsigned i = 0U; i < m_fanout; ++i) {
+            arms.push_back(add_node());
+            add_edge(from, arms.back());
+        }
+        auto* join = add_node();
+        for (auto* arm : arms) {
+            add_edge(arm, join);
+        }
+        return join;
+    }
+
+    /// \returns the exit block of the loop
+    SyntheticNode* add_loop(SyntheticNode* pred,
+                            unsigned depth,
+                            unsigned width) {
+        auto* head = add_node();
+        add_edge(pred, head);
+        auto* tail = add_chain(add_switch(head), width);
+        if (depth > 1U) {
+            tail = add_chain(add_loop(tail, depth - 1U, width), width);
+        }
+        add_edge(tail, head);
+        auto* exit = add_node();
+        add_edge(head, exit);
+        return exit;
+    }
+}; // class SyntheticCFG
+
+void bm_wto_nested_loops(benchmark::State& state) {
+    const SyntheticCFG cfg(static_cast< unsigned >(state.range(0)),
+                           static_cast< unsigned >(state.range(1)),
+                           static_cast< unsigned >(state.range(2)));
+    const PerfCounterScope perf_scope(state);
+    for (auto _ : state) {
+        Wto< SyntheticCFG > wto(&cfg);
+        benchmark::DoNotOptimize(wto);
+    }
+    state.SetItemsProcessed(state.iterations() *
+                            static_cast< int64_t >(cfg.size()));
+}
+BENCHMARK(bm_wto_nested_loops)
+    ->ArgNames({"depth", "width", "fanout"})
+    ->ArgsProduct({{1, 4, 16, 64}, {1, 8, 64}, {1, 16}});
+
+} // anonymous namespace
+
+} // namespace knight::bench
@@ -0,0 +1,92 @@
+//===- alias_classes.hpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the alias classes of the variables of a function,
+//  computed by a unification-based pre-pass.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/proc_cfg.hpp"
+
+#include <llvm/ADT/DenseMap.h>
+
+#include <vector>
+
+namespace knight::analyzer {
+
+/// \brief The alias classes of the variables of a function, computed by
+/// the Steensgaard unification in near-linear time before the fixpoint.
+///
+/// Each variable has a location, and the locations a value may point to
+/// form a class, so that the pointers pointing to a common location
+/// point to the same class. The pass is flow-insensitive and
+/// field-insensitive: an assignment unifies the classes of its two
+/// sides, a field is its record and an element is its array.
+///
+/// The locations out of the function, i.e. those the parameters, the
+/// globals and the call results may point to, and the locations passed
+/// to a callee, are all in one external class pointing to itself. The
+/// `pure` and `const` callees returning no pointer keep their arguments.
+///
+/// The classes only serve the `may_alias` queries of the pointer analysis:
+/// two pointers in distinct classes never alias, and the other queries
+/// fall back to the points-to facts.
+class AliasClasses {
+  public:
+    using ClassID = unsigned;
+
+  private:
+    /// \brief The union-find parents of the classes.
+    mutable std::vector< ClassID > m_parents;
+    /// \brief The class each class points to, `NoClass` if none.
+    std::vector< ClassID > m_pointees;
+
+    llvm::DenseMap< const clang::VarDecl*, ClassID > m_var_locations;
+
+    static constexpr ClassID NoClass = ~0U;
+    static constexpr ClassID ExternalClass = 0U;
+
+  public:
+    explicit AliasClasses(ProcCFG::DeclRef decl);
+
+  public:
+    /// \brief Check if the pointers held by `p` and `q` may point to a
+    /// common location.
+    [[nodiscard]] bool may_alias(const clang::VarDecl* p,
+                                 const clang::VarDecl* q) const;
+
+    /// \brief Check if the pointer held by `p` may point to `var`.
+    [[nodiscard]] bool may_point_to(const clang::VarDecl* p,
+                                    const clang::VarDecl* var) const;
+
+    /// \brief Check if the pointer held by `p` may point out of the
+    /// function.
+    [[nodiscard]] bool may_point_to_external(const clang::VarDecl* p) const;
+
+    /// \brief Get the number of classes, the unified ones counted once.
+    [[nodiscard]] unsigned get_num_classes() const;
+
+  private:
+    friend class AliasClassBuilder;
+
+    [[nodiscard]] ClassID find(ClassID cls) const;
+    [[nodiscard]] ClassID create_class();
+    [[nodiscard]] ClassID get_location(const clang::VarDecl* var);
+    [[nodiscard]] ClassID get_pointee(ClassID cls);
+    void unify(ClassID a, ClassID b);
+
+    /// \brief Get the class the variable points to, `NoClass` if it never
+    /// holds a pointer.
+    [[nodiscard]] ClassID get_var_pointee(const clang::VarDecl* var) const;
+
+}; // class AliasClasses
+
+} // namespace knight::analyzer
@@ -268,6 +268,20 @@ class ConditionFilter {
 
 }; // class ConditionFilter
 
+/// \brief Build the CFGs with the optional elements of the given kinds,
+/// which the analysis handles.
+template < CFGElementKind... KINDS >
+class CFGElements {
+  public:
+    template < typename ANALYSIS >
+    static void register_callback([[maybe_unused]] ANALYSIS* analysis,
+                                  AnalysisManager& mgr) {
+        CFGElementSet elements;
+        (elements.set(static_cast< std::size_t >(KINDS)), ...);
+        mgr.register_for_cfg_elements(elements);
+    }
+}; // class CFGElements
+
 template < typename... EVENTS >
 class EventDispatcher {
   private:
@@ -73,12 +73,16 @@ class AssignResolver {
     [[nodiscard]] ProgramStateRef resolve(internal::AssignmentContext) const;
 
   private:
-    void handle_int_assign(internal::AssignmentContext assign_ctx,
-                           SymbolRef res_sym,
-                           bool is_direct_assign,
-                           clang::BinaryOperator::Opcode op,
-                           ProgramStateRef& state,
-                           SExprRef& binary_sexpr) const;
+    /// \brief Dispatch the assign event of an integer assignment.
+    ///
+    /// \return the equality constraint of the assigned symbol, if any.
+    [[nodiscard]] std::optional< ZLinearConstraint > handle_int_assign(
+        internal::AssignmentContext assign_ctx,
+        SymbolRef res_sym,
+        bool is_direct_assign,
+        clang::BinaryOperator::Opcode op,
+        ProgramStateRef& state,
+        SExprRef& binary_sexpr) const;
     void handle_ptr_assign(internal::AssignmentContext assign_ctx,
                            SymbolRef res_sym,
                            bool is_direct_assign,
@@ -104,7 +104,7 @@ inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
 }
 
 struct alignas(AssignEventAlignBigSize) LinearNumericalAssignEvent {
-    static EventKind get_kind() {
+    static constexpr EventKind get_kind() {
         return EventKind::LinearNumericalAssignEvent;
     }
 
@@ -160,7 +160,7 @@ inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
 }
 
 struct LinearNumericalAssumptionEvent { // NOLINT(altera-struct-pack-align)
-    static EventKind get_kind() {
+    static constexpr EventKind get_kind() {
         return EventKind::LinearNumericalAssumptionEvent;
     }
 
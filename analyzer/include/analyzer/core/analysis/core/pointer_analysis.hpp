@@ -31,6 +31,15 @@ class PointerAnalysis
 
     void analyze_begin_function([[maybe_unused]] AnalysisContext& ctx) const;
 
+    /// \brief Check if the pointers held by the variables `p` and `q` of
+    /// the function of the frame may point to a common location, by the
+    /// alias classes of the function and by the whole-program points-to
+    /// sets, those enabled.
+    [[nodiscard]] static bool may_alias(const KnightContext& ctx,
+                                        const StackFrame* frame,
+                                        const clang::VarDecl* p,
+                                        const clang::VarDecl* q);
+
     static void add_dependencies(AnalysisManager& mgr) {
         mgr.add_domain_dependency(get_analysis_id(get_kind()), PointerInfoID);
     }
@@ -19,7 +19,9 @@
 namespace knight::analyzer {
 
 struct PointerAssignEvent { // NOLINT(altera-struct-pack-align)
-    static EventKind get_kind() { return EventKind::PointerAssignEvent; }
+    static constexpr EventKind get_kind() {
+        return EventKind::PointerAssignEvent;
+    }
 
     RegionRef src_region;
     RegionRef dst_region;
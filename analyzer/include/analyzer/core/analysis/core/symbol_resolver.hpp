@@ -57,6 +57,7 @@ class SymbolResolver
     void VisitConditionalOperator(const clang::ConditionalOperator*) const;
     void VisitDeclStmt(const clang::DeclStmt*) const;
     void VisitCastExpr(const clang::CastExpr*) const;
+    void VisitCallExpr(const clang::CallExpr*) const;
 
     void analyze_stmt(const clang::Stmt*, AnalysisContext&) const;
     void filter_condition(const clang::Expr*, bool, AnalysisContext&) const;
@@ -75,6 +76,14 @@ class SymbolResolver
     void handle_int_cond_op(const clang::ConditionalOperator*) const;
 
     void handle_load(const clang::Expr* load_expr) const;
+
+    /// \brief Assume the non-linear constraint, bottom if the non-linear
+    /// solver of the function finds it infeasible with the ones of the
+    /// state.
+    [[nodiscard]] ProgramStateRef assume_non_linear_constraint(
+        const ProgramStateRef& state,
+        SExprRef constraint,
+        AnalysisContext& ctx) const;
 };
 
 } // namespace knight::analyzer
\ No newline at end of file
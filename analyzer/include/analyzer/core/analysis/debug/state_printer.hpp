@@ -19,13 +19,34 @@
 #include <clang/AST/Decl.h>
 #include <clang/AST/Expr.h>
 #include <clang/AST/Stmt.h>
+#include <llvm/Support/raw_ostream.h>
 #include "common/util/log.hpp"
 
+#include <memory>
+
 namespace knight::analyzer {
 
+/// \brief The buffer size of the state dump files.
+constexpr std::size_t StateDumpBufferSize = 1U << 16U;
+
+/// \brief Print the states before and after each stmt.
+///
+/// With a `state_dump_dir`, the states are written to one buffered file
+/// per function, and a state is only printed in full at the first program
+/// point of a block, the next ones only printing their changes from the
+/// previous one, see `ProgramState::get_changes`.
 class StatePrinter : public Analysis< StatePrinter,
                                       analyze::PreStmt< clang::Stmt >,
                                       analyze::PostStmt< clang::Stmt > > {
+  private:
+    /// \brief The dump file of the function being printed, if any.
+    mutable std::unique_ptr< llvm::raw_fd_ostream > m_os;
+    mutable const clang::Decl* m_function = nullptr;
+
+    /// \brief The last printed state and its block.
+    mutable ProgramStateRef m_previous;
+    mutable const clang::CFGBlock* m_previous_block = nullptr;
+
   public:
     explicit StatePrinter(KnightContext& ctx) : Analysis(ctx) {}
 
@@ -40,6 +61,18 @@ class StatePrinter : public Analysis< StatePrinter,
                                                KnightContext& ctx) {
         return mgr.register_analysis< StatePrinter >(ctx);
     }
+
+  private:
+    void print(const clang::Stmt* stmt,
+               AnalysisContext& ctx,
+               bool is_post) const;
+
+    /// \brief Get the dump file of the function of the current frame,
+    /// opened on its first state, or null to print on the stdout.
+    [[nodiscard]] llvm::raw_ostream* get_dump_file(AnalysisContext& ctx) const;
+
+    /// \brief Print the changes of the state from the previous one.
+    void print_delta(llvm::raw_ostream& os, const ProgramState& state) const;
 };
 
-} // namespace knight::analyzer
\ No newline at end of file
+} // namespace knight::analyzer
@@ -15,6 +15,10 @@
 
 #include <llvm/ADT/StringRef.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
 #ifdef EVENT_DEF
 #    undef EVENT_DEF
 #endif
@@ -54,7 +58,7 @@ inline llvm::StringRef get_event_desc(EventKind kind) {
     }
 }
 
-inline EventID get_event_id(EventKind kind) {
+constexpr EventID get_event_id(EventKind kind) {
     switch (kind) {
 #undef EVENT_DEF
 #define EVENT_DEF(KIND, NAME, ID, DESC) \
@@ -82,6 +86,15 @@ inline llvm::StringRef get_event_name_by_id(EventID id) {
     return get_event_name(get_event_kind(id));
 }
 
+/// \brief The number of event IDs, so that the per-event tables are
+/// plain arrays indexed by the IDs.
+constexpr std::size_t NumEvents = std::max({
+#undef EVENT_DEF
+#define EVENT_DEF(KIND, NAME, ID, DESC) static_cast< std::size_t >(ID),
+#include "analyzer/core/def/events.def"
+                                  }) +
+                                  1U;
+
 // NOLINTEND(cppcoreguidelines-macro-usage)
 
 } // namespace knight::analyzer
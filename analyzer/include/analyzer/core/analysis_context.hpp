@@ -58,6 +58,9 @@ class AnalysisContext {
     [[nodiscard]] const LocationContext* get_current_location_context() const;
     [[nodiscard]] ProgramStateRef get_state() const;
     void set_current_stack_frame(const StackFrame* frame);
+    void set_current_location_context(const LocationContext* loc_ctx) {
+        m_location_context = loc_ctx;
+    }
     void set_state(ProgramStateRef state);
     [[nodiscard]] bool is_state_changed() const { return m_is_state_changed; }
 }; // class AnalysisContext
@@ -15,6 +15,7 @@
 
 #include "analyzer/core/analysis/analyses.hpp"
 #include "analyzer/core/analysis/events.hpp"
+#include "analyzer/core/arena.hpp"
 #include "analyzer/core/domain/dom_base.hpp"
 #include "analyzer/core/proc_cfg.hpp"
 #include "analyzer/core/region/region.hpp"
@@ -24,10 +25,15 @@
 
 #include "common/util/log.hpp"
 
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/WithColor.h>
 
+#include <array>
 #include <memory>
+#include <optional>
 #include <unordered_set>
+#include <vector>
 
 namespace knight::analyzer {
 
@@ -79,8 +85,16 @@ using AnalyzeEndFunctionCallBack =
     AnalysisCallBack< void(ExitNodeRef, AnalysisContext&) >;
 
 using AnalyzeStmtCallBack = AnalysisCallBack< void(StmtRef, AnalysisContext&) >;
+/// \brief The match result shall only depend on the statement class, so
+/// that it can be cached per statement class.
 using MatchStmtCallBack = bool (*)(StmtRef S);
 enum class VisitStmtKind { Pre, Eval, Post };
+constexpr std::size_t NumVisitStmtKinds = 3U;
+constexpr std::size_t NumStmtClasses =
+    static_cast< std::size_t >(clang::Stmt::lastStmtConstant) + 1U;
+
+/// \brief Stmt callbacks of the required analyses in the analysis order.
+using StmtAnalysisCallBacks = std::vector< const AnalyzeStmtCallBack* >;
 
 using ConditionFilterCallback =
     AnalysisCallBack< void(ExprRef, bool, AnalysisContext&) >;
@@ -91,7 +105,7 @@ constexpr unsigned SmallAlignedSize = 32U;
 constexpr unsigned BigAlignedSize = 64U;
 
 struct alignas(SmallAlignedSize) EventInfo {
-    std::vector< EventListenerCallback > listeners;
+    llvm::SmallVector< EventListenerCallback, 2U > listeners;
     bool has_dispatcher = false;
 }; // struct EventInfo
 
@@ -113,6 +127,11 @@ class AnalysisManager {
 
   private:
     KnightContext& m_ctx;
+
+    /// \brief The arenas of the managers, declared first so that they
+    /// outlive them.
+    ArenaContextRef m_arenas;
+
     std::unique_ptr< analyzer::RegionManager > m_region_mgr;
     std::unique_ptr< analyzer::ProgramStateManager > m_state_mgr;
     std::unique_ptr< SymbolManager > m_sym_mgr;
@@ -145,11 +164,25 @@ class AnalysisManager {
     /// \brief condition filter callbacks
     std::vector< internal::ConditionFilterCallback > m_condition_filters;
 
-    using EventsTy = llvm::DenseMap< unsigned, internal::EventInfo >;
+    /// \brief The optional kinds of CFG elements handled by the enabled
+    /// analyses, the CFGs are built without the others.
+    CFGElementSet m_required_cfg_elements;
+
+    /// \brief statement callbacks dispatch table, indexed by the visit
+    /// kind and the statement class, and filled on the first statement of
+    /// each class.
+    std::vector< std::optional< internal::StmtAnalysisCallBacks > >
+        m_stmt_dispatch_table;
+
+    /// \brief The event listeners, indexed by the event IDs.
+    using EventsTy = std::array< internal::EventInfo, NumEvents >;
     EventsTy m_events;
 
   public:
-    explicit AnalysisManager(KnightContext& ctx);
+    /// \brief Create the managers on the given arenas, or on fresh ones
+    /// if null.
+    explicit AnalysisManager(KnightContext& ctx,
+                             ArenaContextRef arenas = nullptr);
     ~AnalysisManager() = default;
 
   public:
@@ -187,6 +220,7 @@ class AnalysisManager {
         auto analysis_id = get_analysis_id(Analysis::get_kind());
         m_privileged_analysis.insert(analysis_id);
         m_required_analyses.insert(analysis_id);
+        m_stmt_dispatch_table.clear();
     }
 
     void enable_analysis(std::unique_ptr< AnalysisBase > analysis);
@@ -224,30 +258,30 @@ class AnalysisManager {
                            internal::MatchStmtCallBack match_cb,
                            internal::VisitStmtKind kind);
     void register_for_condition_filter(internal::ConditionFilterCallback cb);
+    void register_for_cfg_elements(const CFGElementSet& elements) {
+        m_required_cfg_elements |= elements;
+    }
     template < event EVENT >
     void register_for_event_listener(internal::EventListenerCallback cb) {
-        auto kind = EVENT::get_kind();
-        internal::EventInfo& info = m_events[get_event_id(kind)];
-        info.listeners.push_back(cb);
+        constexpr auto id = get_event_id(EVENT::get_kind());
+        std::get< id >(m_events).listeners.push_back(cb);
     }
 
     template < event EVENT >
     void register_for_event_dispatcher() {
-        auto kind = EVENT::get_kind();
-        internal::EventInfo& info = m_events[get_event_id(kind)];
-        info.has_dispatcher = true;
+        constexpr auto id = get_event_id(EVENT::get_kind());
+        std::get< id >(m_events).has_dispatcher = true;
     }
     /// @}
 
     /// \brief event dispatching
+    ///
+    /// The listeners of the event are found at compile time, and the event
+    /// is passed to them by reference.
     template < event EVENT >
     void dispatch_event(EVENT& event) const {
-        auto kind = EVENT::get_kind();
-        auto it = m_events.find(get_event_id(kind));
-        if (it == m_events.end()) {
-            return;
-        }
-        for (const auto& listener : it->second.listeners) {
+        constexpr auto id = get_event_id(EVENT::get_kind());
+        for (const auto& listener : std::get< id >(m_events).listeners) {
             listener(&event);
         }
     }
@@ -271,12 +305,19 @@ class AnalysisManager {
         return m_required_analyses;
     }
 
+    [[nodiscard]] const CFGElementSet& get_required_cfg_elements() const {
+        return m_required_cfg_elements;
+    }
+
     [[nodiscard]] analyzer::RegionManager& get_region_manager() const {
         return *m_region_mgr;
     }
     [[nodiscard]] analyzer::SymbolManager& get_symbol_manager() const;
     [[nodiscard]] analyzer::ProgramStateManager& get_state_manager() const;
     [[nodiscard]] KnightContext& get_context() const { return m_ctx; }
+    [[nodiscard]] const ArenaContextRef& get_arenas() const {
+        return m_arenas;
+    }
 
     void compute_all_required_analyses_by_dependencies();
     void compute_full_order_analyses_after_registry();
@@ -286,6 +327,11 @@ class AnalysisManager {
     void run_analyses_for_stmt(AnalysisContext& analysis_ctx,
                                internal::StmtRef stmt,
                                internal::VisitStmtKind visit_kind);
+    /// \brief Run the given stmt callbacks, already resolved for the stmt.
+    void run_stmt_callbacks(
+        AnalysisContext& analysis_ctx,
+        internal::StmtRef stmt,
+        llvm::ArrayRef< const internal::AnalyzeStmtCallBack* > callbacks);
     void run_analyses_for_pre_stmt(AnalysisContext& analysis_ctx,
                                    internal::StmtRef stmt);
     void run_analyses_for_eval_stmt(AnalysisContext& analysis_ctx,
@@ -299,6 +345,15 @@ class AnalysisManager {
                                            internal::ExprRef expr,
                                            bool assertion_result);
 
+  private:
+    /// \brief Return the callbacks matching the stmt, in the analysis order.
+    ///
+    /// The matches are computed once per stmt class and visit kind, and
+    /// not once per stmt: the entry is shared by all the stmts of the
+    /// class, across the iterations and the analyzed functions.
+    [[nodiscard]] const internal::StmtAnalysisCallBacks& get_stmt_analyses_for(
+        internal::StmtRef stmt, internal::VisitStmtKind visit_kind);
+
 }; // class AnalysisManager
 
 } // namespace knight::analyzer
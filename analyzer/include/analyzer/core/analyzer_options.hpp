@@ -31,6 +31,46 @@ struct alignas(AnalyzerOptionsAlignment) AnalyzerOptions {
     /// \brief If true, do widening and narrowing with threshold
     bool analyze_with_threshold = false;
 
+    /// \brief Wall-clock budget of analyzing a function in milliseconds,
+    /// zero means unlimited.
+    unsigned max_function_millis = 0U;
+
+    /// \brief Budget of node transfers of analyzing a function,
+    /// zero means unlimited.
+    unsigned max_function_transfers = 0U;
+
+    /// \brief Maximum depth of the callee frames analyzed at their call
+    /// sites, zero disables the inlining.
+    unsigned max_call_depth = 0U;
+
+    /// \brief If true, only re-transfer the nodes of a cycle whose
+    /// predecessors changed since their last transfer.
+    bool sparse_fixpoint = false;
+
+    /// \brief If true, drop the dead variables and stmt values from the
+    /// states at the block exits.
+    bool prune_dead_values = true;
+
+    /// \brief Budget in MiB of the state, symbol and region arenas of a
+    /// worker, zero means unlimited. Past it, the function is widened
+    /// eagerly, and past twice it, the function is skipped.
+    unsigned max_memory_mb = 0U;
+
+    /// \brief Maximum number of states kept apart at the merge points out
+    /// of the cycle heads, one joins the states at every merge point.
+    unsigned max_disjuncts = 1U;
+
+    /// \brief If true, partition the variables of each function into
+    /// alias classes by a unification-based pre-pass, so that the
+    /// pointer analysis only tracks the pointers of the classes with
+    /// several locations.
+    bool alias_classes = false;
+
+    /// \brief If true, enlarge the counters of the counting loops to
+    /// their closed-form ranges after the first iteration at their heads,
+    /// instead of waiting for the widening.
+    bool accelerate_loops = false;
+
 }; // struct AnalyzerOptions
 
 } // namespace knight::analyzer
\ No newline at end of file
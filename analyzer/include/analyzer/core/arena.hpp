@@ -0,0 +1,44 @@
+//===- arena.hpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the arenas of the analysis managers.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/Support/Allocator.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace knight::analyzer {
+
+/// \brief The arenas of the symbols, the regions and the state maps of
+/// one worker, shared by its successive analysis managers.
+///
+/// An arena context is only used by one worker thread at a time and its
+/// arenas are reset between the analyzed functions, so the allocations
+/// take no lock and no atomic. The slabs are allocated and first touched
+/// by the worker, which places them on the NUMA node of the worker under
+/// the default first-touch policy of the multi-socket hosts.
+struct ArenaContext {
+    llvm::BumpPtrAllocator symbols;
+    llvm::BumpPtrAllocator regions;
+    llvm::BumpPtrAllocator states;
+
+    [[nodiscard]] std::size_t get_total_memory() const {
+        return symbols.getTotalMemory() + regions.getTotalMemory() +
+               states.getTotalMemory();
+    }
+}; // struct ArenaContext
+
+using ArenaContextRef = std::shared_ptr< ArenaContext >;
+
+} // namespace knight::analyzer
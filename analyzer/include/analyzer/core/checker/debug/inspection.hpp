@@ -14,6 +14,7 @@
 #pragma once
 
 #include "analyzer/core/analysis/core/numerical_analysis.hpp"
+#include "analyzer/core/analysis/core/pointer_analysis.hpp"
 #include "analyzer/core/checker/checker_base.hpp"
 #include "analyzer/core/checker_context.hpp"
 #include "analyzer/core/checker_manager.hpp"
@@ -30,6 +31,7 @@ class InspectionChecker
   private:
     static inline llvm::StringRef ZValDumper = "knight_dump_zval";
     static inline llvm::StringRef ReachabilityDumper = "knight_reachable";
+    static inline llvm::StringRef AliasDumper = "knight_may_alias";
 
   public:
     explicit InspectionChecker(KnightContext& C) : Checker(C) {}
@@ -46,6 +48,9 @@ class InspectionChecker
     void dump_reachability(const clang::CallExpr* call_expr,
                            CheckerContext& ctx) const;
 
+    void dump_alias(const clang::CallExpr* call_expr,
+                    CheckerContext& ctx) const;
+
     void check_begin_function(CheckerContext& C) const {}
 
     static void add_dependencies(CheckerManager& mgr) {
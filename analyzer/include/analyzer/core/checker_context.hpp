@@ -20,6 +20,10 @@
 #include "analyzer/core/program_state.hpp"
 #include "analyzer/core/symbol_manager.hpp"
 
+#include <llvm/ADT/DenseMap.h>
+
+#include <optional>
+
 namespace knight {
 
 class KnightContext;
@@ -28,6 +32,13 @@ namespace analyzer {
 
 class StackFrame;
 
+/// \brief The context of the checkers at a program point.
+///
+/// The values of the expressions queried by the checkers are cached for
+/// the current program point, so that the checkers of the same stmt
+/// evaluating the same operands, e.g. a divisor, only evaluate them once.
+/// The cache is cleared by the checker manager before each check point,
+/// since the scratch values of a state may change while it is kept.
 class CheckerContext {
   private:
     KnightContext& m_ctx;
@@ -37,6 +48,15 @@ class CheckerContext {
 
     SymbolManager& m_sym_manager;
 
+    /// \brief The queried values of the expressions in the current state,
+    /// none if unknown.
+    /// @{
+    llvm::DenseMap< const clang::Expr*, std::optional< ZInterval > >
+        m_zinterval_cache;
+    llvm::DenseMap< const clang::Expr*, std::optional< PointToSet > >
+        m_point_to_cache;
+    /// @}
+
   public:
     explicit CheckerContext(KnightContext& ctx,
                             const StackFrame* frame,
@@ -60,13 +80,39 @@ class CheckerContext {
         return m_sym_manager;
     }
 
+    /// \brief Get the interval of the integer expression in the current
+    /// state, none if unknown.
+    [[nodiscard]] std::optional< ZInterval > get_zinterval(
+        const clang::Expr* expr);
+
+    /// \brief Get the regions the pointer expression may point to in the
+    /// current state, none if unknown.
+    [[nodiscard]] std::optional< PointToSet > get_point_to_set(
+        const clang::Expr* expr);
+
     void set_current_state(ProgramStateRef state) {
+        if (state != m_state) {
+            clear_query_cache();
+        }
         m_state = std::move(state);
     }
     void set_current_stack_frame(const StackFrame* frame);
     void set_location_context(const LocationContext* loc_ctx) {
         m_location_context = loc_ctx;
     }
+
+    /// \brief Drop the queried values, before the checkers of another
+    /// program point.
+    void clear_query_cache() {
+        m_zinterval_cache.clear();
+        m_point_to_cache.clear();
+    }
+
+  private:
+    [[nodiscard]] std::optional< ZInterval > compute_zinterval(
+        const clang::Expr* expr) const;
+    [[nodiscard]] std::optional< PointToSet > compute_point_to_set(
+        const clang::Expr* expr) const;
 }; // class CheckerContext
 
 } // namespace analyzer
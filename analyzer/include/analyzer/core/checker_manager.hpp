@@ -26,7 +26,9 @@
 #include <llvm/Support/WithColor.h>
 
 #include <memory>
+#include <optional>
 #include <unordered_set>
+#include <vector>
 
 namespace knight::analyzer {
 
@@ -74,10 +76,16 @@ using CheckEndFunctionCallBack =
     CheckerCallBack< void(ExitNodeRef, CheckerContext&) >;
 
 using CheckStmtCallBack = CheckerCallBack< void(StmtRef, CheckerContext&) >;
+/// \brief The match result shall only depend on the statement class, so
+/// that it can be cached per statement class.
 using MatchStmtCallBack = bool (*)(StmtRef S);
 enum class CheckStmtKind { Pre, Post };
+constexpr std::size_t NumCheckStmtKinds = 2U;
 constexpr unsigned StmtCheckerInfoAlign = 64;
 
+/// \brief Stmt callbacks of the required checkers in registration order.
+using StmtCheckCallBacks = std::vector< const CheckStmtCallBack* >;
+
 struct alignas(StmtCheckerInfoAlign) StmtCheckerInfo {
     CheckStmtCallBack anz_cb;
     MatchStmtCallBack match_cb;
@@ -110,6 +118,12 @@ class CheckerManager {
     /// \brief visit statement callbacks
     std::vector< internal::StmtCheckerInfo > m_stmt_checks;
 
+    /// \brief statement callbacks dispatch table, indexed by the check
+    /// kind and the statement class, and filled on the first statement of
+    /// each class.
+    std::vector< std::optional< internal::StmtCheckCallBacks > >
+        m_stmt_dispatch_table;
+
   public:
     CheckerManager(KnightContext& ctx, AnalysisManager& analysis_mgr)
         : m_ctx(ctx), m_analysis_mgr(analysis_mgr) {}
@@ -182,6 +196,13 @@ class CheckerManager {
         return m_checker_dependencies;
     }
 
+    /// \brief Check if any required checker checks the given statement,
+    /// so that the statements no checker cares about can be skipped.
+    [[nodiscard]] bool has_checkers_for_stmt(
+        internal::StmtRef stmt, internal::CheckStmtKind check_kind) {
+        return !get_stmt_checks_for(stmt, check_kind).empty();
+    }
+
     void run_checkers_for_stmt(CheckerContext& checker_ctx,
                                internal::StmtRef stmt,
                                internal::CheckStmtKind check_kind);
@@ -194,6 +215,9 @@ class CheckerManager {
                                        ProcCFG::NodeRef node);
 
   private:
+    [[nodiscard]] const internal::StmtCheckCallBacks& get_stmt_checks_for(
+        internal::StmtRef stmt, internal::CheckStmtKind check_kind);
+
     static void log_checker_dependency(CheckerID id,
                                        AnalysisID required_analysis_id);
 
@@ -14,30 +14,72 @@
 #pragma once
 
 #include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/core/symbol.hpp"
 
 #include <llvm/ADT/FoldingSet.h>
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 namespace knight::analyzer {
 
+/// \brief The maximum number of linear constraints kept in a state.
+///
+/// Beyond it, the least recently inserted ones are evicted, so that the
+/// state size and interning cost do not grow with the loop iterations.
+constexpr std::size_t MaxZLinearConstraints = 64U;
+
+/// \brief The constraints of a state.
+///
+/// The non-linear constraints are interned symbolic expressions, kept in
+/// a flat vector sorted by their dense IDs without duplicates, so that
+/// equal sets profile the same and are merged or intersected in one pass.
+/// The linear constraints keep their recency order for the eviction.
+///
+/// The hash of the whole system is cached once the system is frozen in
+/// a state, and compared before the contents.
 class ConstraintSystem : public llvm::FoldingSetNode {
   public:
-    using NonLinearConstraintSet = std::unordered_set< SExprRef >;
+    using NonLinearConstraintSet = std::vector< SExprRef >;
 
   private:
     ZLinearConstraintSystem m_zlinear_constraint_system;
     NonLinearConstraintSet m_non_linear_constraint_set;
 
+    /// \brief The cached hash of the profile, only valid if `m_is_hashed`.
+    unsigned m_hash = 0U;
+    bool m_is_hashed = false;
+
   public:
     ConstraintSystem() = default;
 
     // NOLINTNEXTLINE
     void Profile(llvm::FoldingSetNodeID& id) const {
         m_zlinear_constraint_system.Profile(id);
-        for (const auto& constraint : m_non_linear_constraint_set) {
+        id.AddInteger(m_non_linear_constraint_set.size());
+        for (const auto* constraint : m_non_linear_constraint_set) {
             id.AddPointer(constraint);
         }
     }
 
+    /// \brief Cache the hash of the system, done before the system is
+    /// shared by an interned state.
+    void freeze() {
+        if (m_is_hashed) {
+            return;
+        }
+        llvm::FoldingSetNodeID id;
+        Profile(id);
+        m_hash = id.ComputeHash();
+        m_is_hashed = true;
+    }
+
+    [[nodiscard]] bool is_empty() const {
+        return m_zlinear_constraint_system.is_empty() &&
+               m_non_linear_constraint_set.empty();
+    }
+
   public:
     [[nodiscard]] const ZLinearConstraintSystem& get_zlinear_constraint_system()
         const {
@@ -49,9 +91,19 @@ class ConstraintSystem : public llvm::FoldingSetNode {
         return m_non_linear_constraint_set;
     }
 
+    [[nodiscard]] bool contains_non_linear_constraint(
+        SExprRef constraint) const {
+        return std::binary_search(m_non_linear_constraint_set.begin(),
+                                  m_non_linear_constraint_set.end(),
+                                  constraint,
+                                  is_before);
+    }
+
   public:
     void add_zlinear_constraint(const ZLinearConstraint& constraint) {
-        m_zlinear_constraint_system.add_linear_constraint(constraint);
+        m_is_hashed = false;
+        m_zlinear_constraint_system.insert_linear_constraint(constraint);
+        m_zlinear_constraint_system.evict_least_recent(MaxZLinearConstraints);
     }
 
     void merge(const ConstraintSystem& system) {
@@ -60,6 +112,10 @@ class ConstraintSystem : public llvm::FoldingSetNode {
     }
 
     void retain(const ConstraintSystem& system) {
+        // The joins of the states mostly meet the same constraints.
+        if (this == &system || *this == system) {
+            return;
+        }
         retain_zlinear_constraint_system(
             system.get_zlinear_constraint_system());
         retain_non_linear_constraint_set(
@@ -68,32 +124,65 @@ class ConstraintSystem : public llvm::FoldingSetNode {
 
     void merge_zlinear_constraint_system(
         const ZLinearConstraintSystem& system) {
-        m_zlinear_constraint_system.merge_linear_constraint_system(system);
+        if (system.is_empty()) {
+            return;
+        }
+        m_is_hashed = false;
+        m_zlinear_constraint_system.insert_linear_constraint_system(system);
+        m_zlinear_constraint_system.evict_least_recent(MaxZLinearConstraints);
     }
 
     void retain_zlinear_constraint_system(
         const ZLinearConstraintSystem& system) {
+        m_is_hashed = false;
         m_zlinear_constraint_system.retain_common_linear_constraint_system(
             system);
     }
 
     void add_non_linear_constraint(const SExprRef& constraint) {
-        m_non_linear_constraint_set.insert(constraint);
+        auto& set = m_non_linear_constraint_set;
+        auto it =
+            std::lower_bound(set.begin(), set.end(), constraint, is_before);
+        if (it == set.end() || *it != constraint) {
+            m_is_hashed = false;
+            set.insert(it, constraint);
+        }
     }
 
     void merge_non_linear_constraint_set(const NonLinearConstraintSet& set) {
-        m_non_linear_constraint_set.insert(set.begin(), set.end());
+        if (set.empty() || set == m_non_linear_constraint_set) {
+            return;
+        }
+        m_is_hashed = false;
+        NonLinearConstraintSet merged;
+        merged.reserve(m_non_linear_constraint_set.size() + set.size());
+        std::set_union(m_non_linear_constraint_set.begin(),
+                       m_non_linear_constraint_set.end(),
+                       set.begin(),
+                       set.end(),
+                       std::back_inserter(merged),
+                       is_before);
+        m_non_linear_constraint_set = std::move(merged);
     }
 
     void retain_non_linear_constraint_set(const NonLinearConstraintSet& set) {
-        auto it = m_non_linear_constraint_set.begin();
-        while (it != m_non_linear_constraint_set.end()) {
-            if (set.find(*it) == set.end()) {
-                it = m_non_linear_constraint_set.erase(it);
-            } else {
+        if (set == m_non_linear_constraint_set) {
+            return;
+        }
+        m_is_hashed = false;
+        // Intersect in place, the output never passes the input.
+        auto& own = m_non_linear_constraint_set;
+        auto out = own.begin();
+        auto it = set.begin();
+        for (auto* constraint : own) {
+            while (it != set.end() && is_before(*it, constraint)) {
                 ++it;
             }
+            if (it != set.end() && *it == constraint) {
+                *out++ = constraint;
+            }
         }
+        own.erase(out, own.end());
     }
 
     void dump(llvm::raw_ostream& os) const {
@@ -114,11 +203,23 @@ class ConstraintSystem : public llvm::FoldingSetNode {
     }
 
     bool operator==(const ConstraintSystem& other) const {
-        return m_zlinear_constraint_system.equals(
-                   other.m_zlinear_constraint_system) &&
-               m_non_linear_constraint_set == other.m_non_linear_constraint_set;
+        if (m_is_hashed && other.m_is_hashed && m_hash != other.m_hash) {
+            return false;
+        }
+        return m_non_linear_constraint_set ==
+                   other.m_non_linear_constraint_set &&
+               m_zlinear_constraint_system.equals(
+                   other.m_zlinear_constraint_system);
+    }
+
+  private:
+    /// \brief The order of the non-linear constraints, by the dense IDs of
+    /// the interned expressions, so that it does not depend on the
+    /// addresses.
+    [[nodiscard]] static bool is_before(SExprRef lhs, SExprRef rhs) {
+        return lhs->get_dense_id() < rhs->get_dense_id();
     }
 
 }; // class ConstraintSystem
 
-} // namespace knight::analyzer
\ No newline at end of file
+} // namespace knight::analyzer
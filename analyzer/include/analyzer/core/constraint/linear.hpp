@@ -18,14 +18,16 @@
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/FoldingSet.h>
+#include <llvm/ADT/SmallVector.h>
 #include "common/util/log.hpp"
 
 #include "analyzer/core/domain/num/znum.hpp"
 #include "common/support/dumpable.hpp"
 #include "common/util/assert.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <optional>
-#include <unordered_set>
 
 namespace knight::analyzer {
 
@@ -53,6 +55,11 @@ struct Variable : public llvm::FoldingSetNode {
         return m_symbol == other.m_symbol;
     }
 
+    /// \brief The order of the variables in the linear terms.
+    [[nodiscard]] inline bool less(const Variable< Num >& other) const {
+        return std::less< SymbolRef >()(m_symbol, other.m_symbol);
+    }
+
     void dump(llvm::raw_ostream& os) const { os << m_symbol; }
 
     // NOLINTNEXTLINE
@@ -118,23 +125,30 @@ class LinearExpr : public llvm::FoldingSetNode {
   public:
     using Var = Variable< Num >;
     using VarSet = llvm::DenseSet< Var >;
-    using Map = llvm::DenseMap< Var, Num >;
+    using Term = std::pair< Var, Num >;
+
+    /// \brief Flat terms sorted by variable, without zero factors.
+    ///
+    /// Most expressions met in the analysis have one or two variables,
+    /// which then live inline, and the sorted order makes the profile,
+    /// the equality and the addition linear scans instead of lookups.
+    using Terms = llvm::SmallVector< Term, 2U >;
 
   private:
-    Map m_terms;
+    Terms m_terms;
     Num m_constant;
 
   public:
     LinearExpr() = default;
     explicit LinearExpr(Num n) : m_constant(std::move(n)) {}
     explicit LinearExpr(Var var) : m_constant(Num(0.)) {
-        m_terms.try_emplace(var, Num(1.));
+        m_terms.emplace_back(var, Num(1.));
     }
 
     /// \brief k * var
     LinearExpr(Num k, Var var) {
         if (k != 0) {
-            m_terms.try_emplace(var, std::move(k));
+            m_terms.emplace_back(var, std::move(k));
         }
     }
 
@@ -154,8 +168,52 @@ class LinearExpr : public llvm::FoldingSetNode {
     }
 
   private:
-    LinearExpr(Map terms, Num constant)
-        : m_terms(std::move(terms)), m_constant(std::move(constant)) {}
+    [[nodiscard]] auto lower_bound(const Var& var) const {
+        return std::lower_bound(m_terms.begin(),
+                                m_terms.end(),
+                                var,
+                                [](const Term& term, const Var& v) {
+                                    return term.first.less(v);
+                                });
+    }
+
+    [[nodiscard]] auto lower_bound(const Var& var) {
+        return std::lower_bound(m_terms.begin(),
+                                m_terms.end(),
+                                var,
+                                [](const Term& term, const Var& v) {
+                                    return term.first.less(v);
+                                });
+    }
+
+    /// \brief Add `k * terms` by merging the two sorted term arrays.
+    void plus_terms(const Terms& terms, const Num& k) {
+        if (terms.empty()) {
+            return;
+        }
+        Terms merged;
+        merged.reserve(m_terms.size() + terms.size());
+        auto it = m_terms.begin();
+        auto other_it = terms.begin();
+        while (it != m_terms.end() || other_it != terms.end()) {
+            if (other_it == terms.end() ||
+                (it != m_terms.end() && it->first.less(other_it->first))) {
+                merged.emplace_back(std::move(*it++));
+            } else if (it == m_terms.end() ||
+                       other_it->first.less(it->first)) {
+                merged.emplace_back(other_it->first, other_it->second * k);
+                ++other_it;
+            } else {
+                Num factor = it->second + other_it->second * k;
+                if (factor != 0) {
+                    merged.emplace_back(it->first, std::move(factor));
+                }
+                ++it;
+                ++other_it;
+            }
+        }
+        m_terms = std::move(merged);
+    }
 
   public:
     /// \brief Plus constant
@@ -166,8 +224,8 @@ class LinearExpr : public llvm::FoldingSetNode {
 
     /// \brief Plus k * var
     void plus(const Num& factor, Var var) {
-        auto it = this->m_terms.find(var);
-        if (it != this->m_terms.end()) {
+        auto it = lower_bound(var);
+        if (it != this->m_terms.end() && it->first.equals(var)) {
             Num r = it->second + factor;
             if (r == 0) {
                 this->m_terms.erase(it);
@@ -176,20 +234,19 @@ class LinearExpr : public llvm::FoldingSetNode {
             }
         } else {
             if (factor != 0) {
-                this->m_terms.try_emplace(var, factor);
+                this->m_terms.insert(it, Term(var, factor));
             }
         }
     }
 
     void set_to_constant(Num cst) {
-        Map().swap(this->m_terms);
+        this->m_terms.clear();
         this->m_constant = cst;
     }
 
     void set_to_zero() { set_to_constant(0); }
 
-    [[nodiscard]] Map& get_terms() { return this->m_terms; }
-    [[nodiscard]] const Map& get_variable_terms() const {
+    [[nodiscard]] const Terms& get_variable_terms() const {
         return this->m_terms;
     }
     [[nodiscard]] std::size_t num_variable_terms() const {
@@ -206,8 +263,8 @@ class LinearExpr : public llvm::FoldingSetNode {
     }
 
     [[nodiscard]] Num get_factor_of(Var var) const {
-        auto it = this->m_terms.find(var);
-        if (it != this->m_terms.end()) {
+        auto it = lower_bound(var);
+        if (it != this->m_terms.end() && it->first.equals(var)) {
             return it->second;
         }
         return Num(0.);
@@ -218,9 +275,7 @@ class LinearExpr : public llvm::FoldingSetNode {
 
     /// \brief Plus a linear expression
     void operator+=(const LinearExpr& expr) {
-        for (const auto& [var, factor] : expr.get_variable_terms()) {
-            this->plus(factor, var);
-        }
+        this->plus_terms(expr.m_terms, Num(1));
         this->m_constant += expr.get_constant_term();
     }
 
@@ -233,9 +288,7 @@ class LinearExpr : public llvm::FoldingSetNode {
 
     /// \brief Subtract a linear expression
     void operator-=(const LinearExpr& expr) {
-        for (const auto& [var, factor] : expr.m_terms) {
-            this->plus(-factor, var);
-        }
+        this->plus_terms(expr.m_terms, Num(-1));
         this->m_constant -= expr.get_constant_term();
     }
 
@@ -301,16 +354,29 @@ class LinearExpr : public llvm::FoldingSetNode {
         }
     }
 
+    /// \brief Return true if both expressions have the same variable terms,
+    /// whatever their constants.
+    [[nodiscard]] bool has_same_terms(const LinearExpr& other) const {
+        return std::equal(this->m_terms.begin(),
+                          this->m_terms.end(),
+                          other.m_terms.begin(),
+                          other.m_terms.end(),
+                          [](const Term& a, const Term& b) {
+                              return a.first.equals(b.first) &&
+                                     a.second == b.second;
+                          });
+    }
+
     bool equals(const LinearExpr& other) const {
-        if (this->m_constant != other.m_constant || m_terms != other.m_terms) {
-            return false;
-        }
-        for (const auto& [var, factor] : this->m_terms) {
-            if (other.get_factor_of(var) != factor) {
-                return false;
-            }
-        }
-        return true;
+        return this->m_constant == other.m_constant &&
+               std::equal(this->m_terms.begin(),
+                          this->m_terms.end(),
+                          other.m_terms.begin(),
+                          other.m_terms.end(),
+                          [](const Term& a, const Term& b) {
+                              return a.first.equals(b.first) &&
+                                     a.second == b.second;
+                          });
     }
 }; // class LinearExpr
 
@@ -484,7 +550,7 @@ class LinearConstraint : public llvm::FoldingSetNode {
     using enum LinearConstraintKind;
     using LinearExpr = knight::analyzer::LinearExpr< Num >;
     using Var = Variable< Num >;
-    using VarSet = std::unordered_set< Var >;
+    using VarSet = typename LinearExpr::VarSet;
     using NumT = Num;
 
   private:
@@ -603,11 +669,8 @@ class LinearConstraint : public llvm::FoldingSetNode {
         return this->m_kind;
     }
 
-    [[nodiscard]] LinearExpr::Map& get_terms() {
-        return this->m_linear_expr.get_terms();
-    }
-
-    [[nodiscard]] const LinearExpr::Map& get_variable_terms() const {
+    [[nodiscard]] const typename LinearExpr::Terms& get_variable_terms()
+        const {
         return this->m_linear_expr.get_variable_terms();
     }
 
@@ -887,6 +950,53 @@ class LinearConstraintSystem : public llvm::FoldingSetNode {
         this->m_linear_csts.emplace_back(std::move(cst));
     }
 
+    /// \brief Add `cst` unless the system already implies it.
+    ///
+    /// Tautologies and duplicates are dropped, and of two inequalities
+    /// over the same terms only the tighter bound is kept. The constraint
+    /// inserted or found moves to the back, so that the system stays
+    /// ordered from the least to the most recently used constraint for
+    /// `evict_least_recent()`.
+    void insert_linear_constraint(LinearConstraintT cst) {
+        if (cst.is_tautology()) {
+            return;
+        }
+        auto& csts = this->m_linear_csts;
+        for (auto it = csts.begin(); it != csts.end(); ++it) {
+            if (it->equals(cst)) {
+                std::rotate(it, it + 1, csts.end());
+                return;
+            }
+            if (!it->is_inequality() || !cst.is_inequality() ||
+                !it->get_linear_expression().has_same_terms(
+                    cst.get_linear_expression())) {
+                continue;
+            }
+            if (it->get_constant_term() <= cst.get_constant_term()) {
+                std::rotate(it, it + 1, csts.end());
+                return;
+            }
+            csts.erase(it);
+            break;
+        }
+        csts.emplace_back(std::move(cst));
+    }
+
+    /// \brief Drop the least recently inserted constraints until at most
+    /// `max_size` remain.
+    ///
+    /// Dropping a constraint only loses precision, the remaining system
+    /// is still implied by the original one.
+    void evict_least_recent(std::size_t max_size) {
+        auto& csts = this->m_linear_csts;
+        if (csts.size() > max_size) {
+            csts.erase(csts.begin(),
+                       csts.begin() +
+                           static_cast< std::ptrdiff_t >(csts.size() -
+                                                         max_size));
+        }
+    }
+
     void merge_linear_constraint_system(const LinearConstraintSystem& csts) {
         this->m_linear_csts.reserve(this->m_linear_csts.size() + csts.size());
         this->m_linear_csts.insert(this->m_linear_csts.end(),
@@ -894,14 +1004,23 @@ class LinearConstraintSystem : public llvm::FoldingSetNode {
                                    csts.m_linear_csts.end());
     }
 
+    /// \brief Insert every constraint of `csts` through
+    /// `insert_linear_constraint()`.
+    void insert_linear_constraint_system(const LinearConstraintSystem& csts) {
+        for (const auto& cst : csts.m_linear_csts) {
+            insert_linear_constraint(cst);
+        }
+    }
+
+    /// \brief Keep only the constraints also found in `csts`.
     void retain_common_linear_constraint_system(
         const LinearConstraintSystem& csts) {
         auto it = this->m_linear_csts.begin();
         while (it != this->m_linear_csts.end()) {
-            if (llvm::any_of(csts.m_linear_csts,
-                             [&](const LinearConstraintT& cst) {
-                                 return cst.equals(*it);
-                             })) {
+            if (llvm::none_of(csts.m_linear_csts,
+                              [&](const LinearConstraintT& cst) {
+                                  return cst.equals(*it);
+                              })) {
                 it = this->m_linear_csts.erase(it);
             } else {
                 ++it;
@@ -926,8 +1045,8 @@ class LinearConstraintSystem : public llvm::FoldingSetNode {
     [[nodiscard]] VarSet get_var_set() const {
         VarSet vars;
         for (const LinearConstraintT& cst : this->m_linear_csts) {
-            for (const auto& term : cst) {
-                vars.insert(term.first);
+            for (const auto& [var, _] : cst.get_variable_terms()) {
+                vars.insert(var);
             }
         }
         return vars;
@@ -0,0 +1,94 @@
+//===- non_linear.hpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the feasibility checking of the non-linear
+//  constraints.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/constraint/constraint.hpp"
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/support/dense_id.hpp"
+
+#include <llvm/ADT/DenseMap.h>
+
+#include <map>
+#include <vector>
+
+namespace knight::analyzer {
+
+/// \brief The maximum number of rounds of the propagation of a scope.
+constexpr unsigned MaxNonLinearPropagationRounds = 8U;
+
+/// \brief The solver session of the non-linear constraints of a function,
+/// shared by all the fixpoint iterations of the function.
+///
+/// The constraints are comparisons of integer symbolic expressions, solved
+/// by interval constraint propagation: the intervals of the symbols are
+/// narrowed by each constraint until none narrows, and a constraint set
+/// of which a symbol gets no value is infeasible. The decision is sound
+/// but incomplete, i.e. `false` means infeasible.
+///
+/// The session is incremental: each asserted constraint is a scope keeping
+/// the intervals of its prefix, and a query only pops the scopes out of
+/// its sorted constraints and pushes the missing ones. The results are
+/// memoized on the interned constraints, so that the same branch queried
+/// again in a later iteration hits the cache. The decision only depends
+/// on the constraints, the symbols of which are free.
+class NonLinearSolver {
+  public:
+    using Env = llvm::DenseMap< SymbolRef, ZInterval >;
+
+  private:
+    struct Scope {
+        SExprRef constraint;
+        Env env;
+        bool is_feasible;
+    }; // struct Scope
+
+    std::vector< Scope > m_scopes;
+
+    /// \brief The feasibility of the queried sets, by the sorted dense IDs
+    /// of their constraints.
+    std::map< std::vector< DenseID >, bool > m_cache;
+
+  public:
+    /// \brief Check if the conjunction of the constraints may hold.
+    [[nodiscard]] bool is_feasible(
+        const ConstraintSystem::NonLinearConstraintSet& constraints);
+
+    /// \brief Check if the conjunction of the constraints and one more may
+    /// hold, e.g. a branch condition.
+    [[nodiscard]] bool is_feasible(
+        const ConstraintSystem::NonLinearConstraintSet& constraints,
+        SExprRef constraint);
+
+    /// \brief Assert the constraint in a new scope.
+    void push(SExprRef constraint);
+
+    /// \brief Drop the last scope.
+    void pop() { m_scopes.pop_back(); }
+
+    /// \brief Check if the asserted constraints may hold.
+    [[nodiscard]] bool check() const {
+        return m_scopes.empty() || m_scopes.back().is_feasible;
+    }
+
+    [[nodiscard]] std::size_t get_num_scopes() const {
+        return m_scopes.size();
+    }
+
+  private:
+    [[nodiscard]] bool solve(std::vector< SExprRef > constraints);
+
+}; // class NonLinearSolver
+
+} // namespace knight::analyzer
@@ -21,7 +21,10 @@
 #include "analyzer/core/domain/num/znum.hpp"
 #include "common/util/assert.hpp"
 
+#include <cstdint>
+#include <limits>
 #include <optional>
+#include <type_traits>
 
 namespace knight::analyzer {
 
@@ -29,6 +32,11 @@ namespace knight::analyzer {
 /// or a finite value.
 template < typename Num >
 class Bound {
+  public:
+    /// \brief Whether the finite results out of the range of the bound
+    /// saturate to the infinities.
+    static constexpr bool IsSaturating = false;
+
   private:
     bool m_is_inf;
     Num m_val;
@@ -379,6 +387,203 @@ inline Bound< Num > operator>>(const Bound< Num >& lhs,
     return BoundT(lhs.m_val >> rhs.m_val);
 }
 
+/// \brief Compact bound on a single 64-bit word, where the extreme values
+/// of int64_t are the infinities.
+///
+/// The finite bounds are in [INT64_MIN + 1, INT64_MAX - 1], so that the
+/// bounds are ordered as their words and the negation never overflows.
+/// The results out of this range saturate to the infinity of their sign,
+/// including the negation of INT64_MIN + 1, which is +oo.
+/// The bound is trivially copyable, and so are the arrays of them.
+template <>
+class Bound< int64_t > {
+  public:
+    static constexpr bool IsSaturating = true;
+
+  private:
+    static constexpr int64_t PInf = std::numeric_limits< int64_t >::max();
+    static constexpr int64_t NInf = std::numeric_limits< int64_t >::min();
+
+    int64_t m_val;
+
+  private:
+    struct RawTag {};
+
+    constexpr Bound(int64_t val, RawTag) : m_val(val) {}
+
+    /// \brief The infinity of the sign of `negative`.
+    [[nodiscard]] static constexpr Bound inf(bool negative) {
+        return {negative ? NInf : PInf, RawTag{}};
+    }
+
+  public:
+    Bound() = delete;
+
+    /// \brief The extreme values of int64_t read as the infinities, e.g.
+    /// `Bound(INT64_MAX)` is +oo and not a finite bound. A bound on an
+    /// exact extreme of int64_t is then widened to the infinity, which
+    /// stays sound for the intervals.
+    constexpr explicit Bound(int64_t val) : m_val(val) {}
+
+    constexpr Bound& operator=(int64_t n) {
+        this->m_val = n;
+        return *this;
+    }
+
+  public:
+    [[nodiscard]] static constexpr Bound pinf() { return {PInf, RawTag{}}; }
+    [[nodiscard]] static constexpr Bound ninf() { return {NInf, RawTag{}}; }
+
+    /// \brief The largest finite bound.
+    [[nodiscard]] static constexpr Bound max_finite() {
+        return {PInf - 1, RawTag{}};
+    }
+
+    /// \brief The smallest finite bound.
+    [[nodiscard]] static constexpr Bound min_finite() {
+        return {NInf + 1, RawTag{}};
+    }
+
+  public:
+    [[nodiscard]] constexpr bool is_pinf() const { return m_val == PInf; }
+    [[nodiscard]] constexpr bool is_ninf() const { return m_val == NInf; }
+    [[nodiscard]] constexpr bool is_inf() const {
+        return is_pinf() || is_ninf();
+    }
+    [[nodiscard]] constexpr bool is_finite() const { return !is_inf(); }
+
+    [[nodiscard]] constexpr bool is_num(int64_t n) const {
+        return is_finite() && m_val == n;
+    }
+    [[nodiscard]] constexpr bool is_zero() const { return m_val == 0; }
+    [[nodiscard]] constexpr bool is_one() const { return m_val == 1; }
+
+    [[nodiscard]] std::optional< int64_t > get_num_opt() const {
+        return is_inf() ? std::nullopt : std::make_optional(m_val);
+    }
+
+    [[nodiscard]] int64_t get_num() const {
+        knight_assert_msg(is_finite(), "Bound is inf");
+        return m_val;
+    }
+
+    /// \brief -b
+    constexpr Bound operator-() const {
+        return is_inf() ? inf(is_pinf()) : Bound(-m_val, RawTag{});
+    }
+
+    void operator+=(const Bound& b) { *this = *this + b; }
+    void operator-=(const Bound& b) { *this = *this - b; }
+    void operator*=(const Bound& b) { *this = *this * b; }
+
+    constexpr bool operator<=(const Bound& b) const { return m_val <= b.m_val; }
+    constexpr bool operator>=(const Bound& b) const { return m_val >= b.m_val; }
+    constexpr bool operator<(const Bound& b) const { return m_val < b.m_val; }
+    constexpr bool operator>(const Bound& b) const { return m_val > b.m_val; }
+    constexpr bool operator==(const Bound& b) const { return m_val == b.m_val; }
+    constexpr bool operator!=(const Bound& b) const { return m_val != b.m_val; }
+
+    void dump(llvm::raw_ostream& os) const {
+        if (is_pinf()) {
+            os << "+oo";
+        } else if (is_ninf()) {
+            os << "-oo";
+        } else {
+            os << m_val;
+        }
+    }
+
+    friend Bound operator+(const Bound& lhs, const Bound& rhs) {
+        if (lhs.is_finite() && rhs.is_finite()) {
+            // The sums out of the finite range either overflow, or land on
+            // a sentinel, i.e. saturate as is.
+            int64_t r = 0;
+            if (__builtin_add_overflow(lhs.m_val, rhs.m_val, &r)) {
+                return inf(lhs.m_val < 0);
+            }
+            return {r, RawTag{}};
+        }
+        if (lhs.is_inf() && rhs.is_inf() && lhs != rhs) {
+            knight_unreachable("undefined op on pinf + ninf");
+        }
+        return lhs.is_inf() ? lhs : rhs;
+    }
+
+    friend Bound operator-(const Bound& lhs, const Bound& rhs) {
+        if (lhs.is_finite() && rhs.is_finite()) {
+            int64_t r = 0;
+            if (__builtin_sub_overflow(lhs.m_val, rhs.m_val, &r)) {
+                return inf(lhs.m_val < 0);
+            }
+            return {r, RawTag{}};
+        }
+        if (lhs.is_inf() && rhs.is_inf() && lhs == rhs) {
+            knight_unreachable("undefined op on inf - inf");
+        }
+        return lhs.is_inf() ? lhs : -rhs;
+    }
+
+    friend Bound operator*(const Bound& lhs, const Bound& rhs) {
+        if (lhs.is_zero() || rhs.is_zero()) {
+            return Bound(0);
+        }
+        bool negative = (lhs.m_val < 0) != (rhs.m_val < 0);
+        int64_t r = 0;
+        if (lhs.is_inf() || rhs.is_inf() ||
+            __builtin_mul_overflow(lhs.m_val, rhs.m_val, &r)) {
+            return inf(negative);
+        }
+        return {r, RawTag{}};
+    }
+
+    friend Bound operator/(const Bound& lhs, const Bound& rhs) {
+        if (rhs.is_zero()) {
+            knight_unreachable("division by zero");
+        }
+        if (lhs.is_finite() && rhs.is_finite()) {
+            return {lhs.m_val / rhs.m_val, RawTag{}};
+        }
+        if (lhs.is_finite()) {
+            return Bound(0);
+        }
+        return inf((lhs.m_val < 0) != (rhs.m_val < 0));
+    }
+
+    friend Bound operator<<(const Bound& lhs, const Bound& rhs) {
+        knight_assert_msg(rhs >= Bound(0), "right hand side is negative");
+        if (lhs.is_zero() || lhs.is_inf()) {
+            return lhs;
+        }
+        constexpr int64_t MaxShift = std::numeric_limits< int64_t >::digits;
+        int64_t r = 0;
+        if (rhs.is_inf() || rhs.m_val >= MaxShift ||
+            __builtin_mul_overflow(lhs.m_val,
+                                   static_cast< int64_t >(1) << rhs.m_val,
+                                   &r)) {
+            return inf(lhs.m_val < 0);
+        }
+        return {r, RawTag{}};
+    }
+
+    friend Bound operator>>(const Bound& lhs, const Bound& rhs) {
+        knight_assert_msg(rhs >= Bound(0), "right hand side is negative");
+        if (lhs.is_zero() || lhs.is_inf()) {
+            return lhs;
+        }
+        constexpr int64_t MaxShift = std::numeric_limits< int64_t >::digits;
+        if (rhs.is_inf() || rhs.m_val >= MaxShift) {
+            return Bound(lhs.m_val >= 0 ? 0 : -1);
+        }
+        // NOLINTNEXTLINE(hicpp-signed-bitwise)
+        return {lhs.m_val >> rhs.m_val, RawTag{}};
+    }
+
+}; // class Bound<int64_t>
+
+static_assert(sizeof(Bound< int64_t >) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v< Bound< int64_t > >);
+
 using ZBound = Bound< ZNum >;
+using SmallBound = Bound< int64_t >;
 
 } // namespace knight::analyzer
\ No newline at end of file
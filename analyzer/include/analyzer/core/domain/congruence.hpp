@@ -0,0 +1,391 @@
+//===- congruence.hpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the congruence value domain
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/num/znum.hpp"
+
+#include <clang/AST/Type.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <optional>
+
+namespace knight::analyzer {
+
+/// \brief Congruence `aZ + b`, the integers equal to `b` modulo `a`.
+///
+/// The modulus is non-negative and the residue is reduced modulo a
+/// non-zero modulus: `0Z + b` is the singleton `b` and `1Z + 0` is top.
+/// The lattice has no infinite ascending chain, so the widening is the
+/// join.
+template < typename Num >
+class Congruence : public AbsDom< Congruence< Num > > {
+  private:
+    Num m_modulus;
+    Num m_residue;
+    bool m_is_bottom = false;
+
+  private:
+    struct Top {};
+    struct Bottom {};
+
+  public:
+    [[nodiscard]] static constexpr DomainKind get_kind() {
+        return DomainKind::ZCongruence;
+    }
+
+    Congruence() : Congruence(Top{}) {}
+    Congruence(Num modulus, Num residue)
+        : m_modulus(abs(modulus)), m_residue(std::move(residue)) {
+        if (m_modulus != 0) {
+            m_residue = mod(m_residue, m_modulus);
+        }
+    }
+    explicit Congruence(Num n) : Congruence(Num(0), std::move(n)) {}
+
+    Congruence(const Congruence&) = default;
+    Congruence(Congruence&&) noexcept = default;
+    Congruence& operator=(const Congruence&) = default;
+    Congruence& operator=(Congruence&&) noexcept = default;
+    ~Congruence() override = default;
+
+  private:
+    explicit Congruence(Top) // NOLINT(readability-named-parameter)
+        : m_modulus(1), m_residue(0) {}
+
+    explicit Congruence(Bottom) // NOLINT(readability-named-parameter)
+        : m_modulus(1), m_residue(0), m_is_bottom(true) {}
+
+  public:
+    [[nodiscard]] static Congruence top() { return Congruence(Top{}); }
+    [[nodiscard]] static Congruence bottom() { return Congruence(Bottom{}); }
+
+    [[nodiscard]] static SharedVal default_val() {
+        return std::make_shared< Congruence >();
+    }
+
+    [[nodiscard]] static SharedVal bottom_val() {
+        return std::make_shared< Congruence >(bottom());
+    }
+
+    [[nodiscard]] AbsDomBase* clone() const override {
+        return new Congruence(*this);
+    }
+
+    [[nodiscard]] const Num& get_modulus() const { return m_modulus; }
+    [[nodiscard]] const Num& get_residue() const { return m_residue; }
+
+    [[nodiscard]] std::optional< Num > get_singleton_opt() const {
+        if (!m_is_bottom && m_modulus == 0) {
+            return m_residue;
+        }
+        return std::nullopt;
+    }
+
+    /// \brief Return true if the congruence contains n
+    [[nodiscard]] bool contains(const Num& n) const {
+        if (m_is_bottom) {
+            return false;
+        }
+        if (m_modulus == 0) {
+            return n == m_residue;
+        }
+        return mod(n - m_residue, m_modulus) == 0;
+    }
+
+  public:
+    [[nodiscard]] bool is_bottom() const override { return m_is_bottom; }
+    [[nodiscard]] bool is_top() const override {
+        return !m_is_bottom && m_modulus == 1;
+    }
+
+    void set_to_bottom() override { *this = bottom(); }
+    void set_to_top() override { *this = top(); }
+
+    [[nodiscard]] bool leq(const Congruence& other) const {
+        if (m_is_bottom) {
+            return true;
+        }
+        if (other.m_is_bottom) {
+            return false;
+        }
+        if (other.m_modulus == 0) {
+            return m_modulus == 0 && m_residue == other.m_residue;
+        }
+        return mod(m_modulus, other.m_modulus) == 0 &&
+               other.contains(m_residue);
+    }
+
+    [[nodiscard]] bool equals(const Congruence& other) const {
+        if (m_is_bottom || other.m_is_bottom) {
+            return m_is_bottom == other.m_is_bottom;
+        }
+        return m_modulus == other.m_modulus && m_residue == other.m_residue;
+    }
+
+    void join_with(const Congruence& other) {
+        if (other.m_is_bottom) {
+            return;
+        }
+        if (m_is_bottom) {
+            *this = other;
+            return;
+        }
+        *this = Congruence(gcd(m_modulus,
+                               other.m_modulus,
+                               abs(m_residue - other.m_residue)),
+                           m_residue);
+    }
+
+    void widen_with(const Congruence& other) { join_with(other); }
+
+    /// \brief Solve the two congruences by the chinese remainder theorem.
+    void meet_with(const Congruence& other) {
+        if (m_is_bottom) {
+            return;
+        }
+        if (other.m_is_bottom) {
+            set_to_bottom();
+            return;
+        }
+        if (other.m_modulus == 0 || m_modulus == 0) {
+            const Congruence& singleton = m_modulus == 0 ? *this : other;
+            const Congruence& congruence = m_modulus == 0 ? other : *this;
+            if (congruence.contains(singleton.m_residue)) {
+                *this = singleton;
+            } else {
+                set_to_bottom();
+            }
+            return;
+        }
+
+        // a * u + a' * v = g, so b + a * u * (b' - b) / g solves both.
+        Num g;
+        Num u;
+        Num v;
+        gcd_extended(m_modulus, other.m_modulus, g, u, v);
+        Num diff = other.m_residue - m_residue;
+        if (mod(diff, g) != 0) {
+            set_to_bottom();
+            return;
+        }
+        Num modulus = m_modulus / g * other.m_modulus;
+        *this = Congruence(modulus, m_residue + m_modulus * u * (diff / g));
+    }
+
+    void narrow_with(const Congruence& other) { meet_with(other); }
+
+    void widen_with_threshold(const Congruence& other,
+                              llvm::ArrayRef< Num > /*thresholds*/) {
+        widen_with(other);
+    }
+
+    void narrow_with_threshold(const Congruence& other,
+                               llvm::ArrayRef< Num > /*thresholds*/) {
+        narrow_with(other);
+    }
+
+    void operator+=(const Congruence& other) { *this = *this + other; }
+
+    void operator-=(const Congruence& other) { *this = *this - other; }
+
+    void cast(clang::QualType type, unsigned bit_width) {}
+
+    void dump(llvm::raw_ostream& os) const override {
+        if (m_is_bottom) {
+            os << "⊥";
+        } else if (m_modulus == 0) {
+            os << m_residue;
+        } else if (m_modulus == 1) {
+            os << "Z";
+        } else {
+            os << m_modulus << "Z+" << m_residue;
+        }
+    }
+
+}; // class Congruence
+
+template < typename Num >
+inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                                     const Congruence< Num >& dom) {
+    dom.dump(os);
+    return os;
+}
+
+template < typename Num >
+inline Congruence< Num > operator+(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    return Congruence< Num >(gcd(lhs.get_modulus(), rhs.get_modulus()),
+                             lhs.get_residue() + rhs.get_residue());
+}
+
+template < typename Num >
+inline Congruence< Num > operator-(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    return Congruence< Num >(gcd(lhs.get_modulus(), rhs.get_modulus()),
+                             lhs.get_residue() - rhs.get_residue());
+}
+
+template < typename Num >
+inline Congruence< Num > operator*(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    const Num& a = lhs.get_modulus();
+    const Num& b = lhs.get_residue();
+    const Num& c = rhs.get_modulus();
+    const Num& d = rhs.get_residue();
+    return Congruence< Num >(gcd(a * c, a * d, b * c), b * d);
+}
+
+/// \brief The division is exact if the divisor divides the modulus and the
+/// residue, so that it is also exact for the truncating division of C.
+template < typename Num >
+inline Congruence< Num > operator/(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto d = rhs.get_singleton_opt();
+    if (!d) {
+        return Congruence< Num >::top();
+    }
+    if (*d == 0) {
+        return Congruence< Num >::bottom();
+    }
+    if (auto n = lhs.get_singleton_opt()) {
+        return Congruence< Num >(*n / *d);
+    }
+    if (mod(lhs.get_modulus(), *d) == 0 && mod(lhs.get_residue(), *d) == 0) {
+        return Congruence< Num >(lhs.get_modulus() / *d,
+                                 lhs.get_residue() / *d);
+    }
+    return Congruence< Num >::top();
+}
+
+/// \brief `x % y` is `x - q * y`, so it is congruent to `x` modulo every
+/// common divisor of the moduli and the residue of `y`.
+template < typename Num >
+inline Congruence< Num > operator%(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto n = lhs.get_singleton_opt();
+    auto d = rhs.get_singleton_opt();
+    if (d && *d == 0) {
+        return Congruence< Num >::bottom();
+    }
+    if (n && d) {
+        return Congruence< Num >(*n % *d);
+    }
+    return Congruence< Num >(gcd(lhs.get_modulus(),
+                                 rhs.get_modulus(),
+                                 rhs.get_residue()),
+                             lhs.get_residue());
+}
+
+template < typename Num >
+inline Congruence< Num > operator<<(const Congruence< Num >& lhs,
+                                    const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto shift = rhs.get_singleton_opt();
+    if (!shift || *shift < 0) {
+        return Congruence< Num >::top();
+    }
+    return Congruence< Num >(lhs.get_modulus() << *shift,
+                             lhs.get_residue() << *shift);
+}
+
+/// \brief Only the constants are shifted right, the other values lose
+/// their low bits.
+template < typename Num >
+inline Congruence< Num > operator>>(const Congruence< Num >& lhs,
+                                    const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto n = lhs.get_singleton_opt();
+    auto shift = rhs.get_singleton_opt();
+    if (!n || !shift || *shift < 0) {
+        return Congruence< Num >::top();
+    }
+    return Congruence< Num >(*n >> *shift);
+}
+
+/// \brief Masking the low bits is a reduction modulo a power of two, which
+/// keeps the residue of the moduli it divides.
+template < typename Num >
+inline Congruence< Num > operator&(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto n = lhs.get_singleton_opt();
+    auto mask = rhs.get_singleton_opt();
+    if (n && mask) {
+        return Congruence< Num >(*n & *mask);
+    }
+    if (!mask || *mask < 0 || (*mask & (*mask + 1)) != 0) {
+        return Congruence< Num >::top();
+    }
+    const Num pow = *mask + 1;
+    if (mod(lhs.get_modulus(), pow) == 0) {
+        return Congruence< Num >(mod(lhs.get_residue(), pow));
+    }
+    return Congruence< Num >::top();
+}
+
+template < typename Num >
+inline Congruence< Num > operator|(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto n = lhs.get_singleton_opt();
+    auto m = rhs.get_singleton_opt();
+    if (n && m) {
+        return Congruence< Num >(*n | *m);
+    }
+    return Congruence< Num >::top();
+}
+
+template < typename Num >
+inline Congruence< Num > operator^(const Congruence< Num >& lhs,
+                                   const Congruence< Num >& rhs) {
+    if (lhs.is_bottom() || rhs.is_bottom()) {
+        return Congruence< Num >::bottom();
+    }
+    auto n = lhs.get_singleton_opt();
+    auto m = rhs.get_singleton_opt();
+    if (n && m) {
+        return Congruence< Num >(*n ^ *m);
+    }
+    return Congruence< Num >::top();
+}
+
+using ZCongruence = Congruence< ZNum >;
+
+} // namespace knight::analyzer
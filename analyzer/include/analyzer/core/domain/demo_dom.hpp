@@ -44,7 +44,7 @@ class DemoItvDom : public AbsDom< DemoItvDom > {
         : m_lb(0), m_ub(0), m_is_bottom(true) {}
 
     /// \brief specify the domain kind
-    [[nodiscard]] static DomainKind get_kind() {
+    [[nodiscard]] static constexpr DomainKind get_kind() {
         return DomainKind::DemoItvDom;
     }
 
@@ -70,6 +70,10 @@ class DemoItvDom : public AbsDom< DemoItvDom > {
         }
     }
 
+    [[nodiscard]] bool is_normalized() const override {
+        return is_bottom() || m_lb <= m_ub;
+    }
+
     [[nodiscard]] bool is_bottom() const override { return m_is_bottom; }
 
     [[nodiscard]] bool is_top() const override {
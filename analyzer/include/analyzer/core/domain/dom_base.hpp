@@ -18,8 +18,11 @@
 
 #include "analyzer/core/domain/domains.hpp"
 #include "analyzer/support/dom.hpp"
+#include "analyzer/tooling/mem_report.hpp"
+#include "analyzer/tooling/stats.hpp"
 #include "common/util/log.hpp"
 
+#include <array>
 #include <memory>
 #include <unordered_set>
 
@@ -50,7 +53,10 @@ struct alignas(DomBaseAlignment) AbsDomBase {
     /// \brief Clone the abstract value
     [[nodiscard]] virtual AbsDomBase* clone() const = 0;
 
-    [[nodiscard]] SharedVal clone_shared() const { return SharedVal(clone()); }
+    [[nodiscard]] SharedVal clone_shared() const {
+        Stats::count(kind, DomainOpKind::Clone);
+        return SharedVal(clone());
+    }
 
     /// \brief Normalize the abstract value
     ///
@@ -58,6 +64,14 @@ struct alignas(DomBaseAlignment) AbsDomBase {
     /// Default impl is do nothing.
     virtual void normalize() {}
 
+    /// \brief Check if `normalize()` would leave the value unchanged
+    ///
+    /// Callers skip the normalization of the values which are already
+    /// normalized, so domains overriding `normalize()` shall track it,
+    /// e.g., by a dirty flag set by the operations breaking the normal
+    /// form. Default impl is always normalized.
+    [[nodiscard]] virtual bool is_normalized() const { return true; }
+
     /// \brief Check if the abstract value is bottom
     [[nodiscard]] virtual bool is_bottom() const = 0;
 
@@ -98,10 +112,65 @@ struct alignas(DomBaseAlignment) AbsDomBase {
         this->meet_with(other);
     }
 
+    /// \brief The upper bounds above which also tell if this value changed.
+    ///
+    /// The fixpoint iterator detects the stable heads by them instead of
+    /// checking the inclusion after the operation. An upper bound leaves
+    /// the value unchanged iff `other` is included in it, so the default
+    /// impls check it first and skip the operation on a stable value.
+    /// @{
+    [[nodiscard]] virtual bool join_with_changed(const AbsDomBase& other) {
+        if (other.leq(*this)) {
+            return false;
+        }
+        this->join_with(other);
+        return true;
+    }
+    [[nodiscard]] virtual bool join_with_at_loop_head_changed(
+        const AbsDomBase& other) {
+        if (other.leq(*this)) {
+            return false;
+        }
+        this->join_with_at_loop_head(other);
+        return true;
+    }
+    [[nodiscard]] virtual bool join_consecutive_iter_with_changed(
+        const AbsDomBase& other) {
+        if (other.leq(*this)) {
+            return false;
+        }
+        this->join_consecutive_iter_with(other);
+        return true;
+    }
+    [[nodiscard]] virtual bool widen_with_changed(const AbsDomBase& other) {
+        if (other.leq(*this)) {
+            return false;
+        }
+        this->widen_with(other);
+        return true;
+    }
+    /// @}
+
+    /// \brief Narrow with another abstract value, and tell if this value
+    /// may have changed.
+    ///
+    /// Unlike the upper bounds, `true` is only a hint, as the narrowing may
+    /// keep a value not included in `other`. Default impl skips the
+    /// operation on a value already included in `other`.
+    [[nodiscard]] virtual bool narrow_with_changed(const AbsDomBase& other) {
+        if (this->leq(other)) {
+            return false;
+        }
+        this->narrow_with(other);
+        return true;
+    }
+
     /// \brief Check the inclusion relation
     [[nodiscard]] virtual bool leq(const AbsDomBase& other) const = 0;
 
-    /// \brief Equality comparison
+    /// \brief Equality comparison, by default the inclusion both ways.
+    ///
+    /// The domains with a canonical form compare it directly instead.
     [[nodiscard]] virtual bool equals(const AbsDomBase& other) const {
         return leq(other) && other.leq(*this);
     }
@@ -129,38 +198,100 @@ inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
     return os;
 }
 
-using DomainDefaultValFn = std::function< SharedVal() >;
-using DomainBottomValFn = std::function< SharedVal() >;
+/// \brief Get the abstract value to be modified in place (copy-on-write)
+///
+/// The value is cloned first if it is shared with others, e.g., with an
+/// interned program state.
+[[nodiscard]] inline AbsValRef get_unique_val(SharedVal& val) {
+    if (val.use_count() > 1) {
+        val = val->clone_shared();
+    }
+    return val.get();
+}
 
-extern std::unordered_map< DomainKind, DomainDefaultValFn >
-    DefaultValFns; // NOLINT
-extern std::unordered_map< DomainKind, DomainBottomValFn >
-    BottomValFns; // NOLINT
+using DomainDefaultValFn = SharedVal (*)();
+using DomainBottomValFn = SharedVal (*)();
 
+/// \brief Get the interned default value of `Dom`.
+///
+/// The value is shared by all the states and shall never be modified in
+/// place, `get_unique_val()` clones it first.
 template < typename Dom >
-struct DomainRegistry {
-    DomainRegistry() {
-        DefaultValFns[Dom::get_kind()] = Dom::default_val;
-        BottomValFns[Dom::get_kind()] = Dom::bottom_val;
-    }
-};
+[[nodiscard]] SharedVal get_shared_default_val() {
+    static const SharedVal val = Dom::default_val();
+    return val;
+}
+
+/// \brief Get the interned bottom value of `Dom`.
+///
+/// \see get_shared_default_val
+template < typename Dom >
+[[nodiscard]] SharedVal get_shared_bottom_val() {
+    static const SharedVal val = Dom::bottom_val();
+    return val;
+}
+
+/// \brief The value constructors of a registered domain.
+///
+/// `default_val` and `bottom_val` create fresh values owned by the caller,
+/// `shared_default_val` and `shared_bottom_val` return the interned ones.
+struct DomainValFns {
+    DomainDefaultValFn default_val = nullptr;
+    DomainBottomValFn bottom_val = nullptr;
+    DomainDefaultValFn shared_default_val = nullptr;
+    DomainBottomValFn shared_bottom_val = nullptr;
+}; // struct DomainValFns
+
+using DomainValFnTable = std::array< DomainValFns, NumDomains >;
+
+/// \brief Build the constructor table of the given domains, indexed by
+/// their domain IDs.
+template < typename... Doms >
+[[nodiscard]] constexpr DomainValFnTable make_domain_val_fn_table() {
+    DomainValFnTable table{};
+    ((table[get_domain_id(Doms::get_kind())] =
+          DomainValFns{Doms::default_val,
+                       Doms::bottom_val,
+                       get_shared_default_val< Doms >,
+                       get_shared_bottom_val< Doms >}),
+     ...);
+    return table;
+}
+
+/// \brief The constructors of all the registered domains, constant
+/// initialized in dom_registry.cpp.
+extern const DomainValFnTable DomainValFnsTable;
+
+/// \return the default value constructor of the domain, or nullptr if
+/// the domain is not registered.
+[[nodiscard]] inline DomainDefaultValFn get_domain_default_val_fn(DomID id) {
+    return id < NumDomains ? DomainValFnsTable[id].default_val : nullptr;
+}
 
-[[nodiscard]] inline std::optional< DomainDefaultValFn >
-get_domain_default_val_fn(DomID id) {
-    auto it = DefaultValFns.find(get_domain_kind(id));
-    if (it == DefaultValFns.end()) {
-        return std::nullopt;
+/// \return the bottom value constructor of the domain, or nullptr if
+/// the domain is not registered.
+[[nodiscard]] inline DomainBottomValFn get_domain_bottom_val_fn(DomID id) {
+    return id < NumDomains ? DomainValFnsTable[id].bottom_val : nullptr;
+}
+
+/// \return the interned default value of the domain, or nullptr if the
+/// domain is not registered.
+[[nodiscard]] inline SharedVal get_domain_shared_default_val(DomID id) {
+    if (id >= NumDomains) {
+        return nullptr;
     }
-    return it->second;
+    auto fn = DomainValFnsTable[id].shared_default_val;
+    return fn == nullptr ? nullptr : fn();
 }
 
-[[nodiscard]] inline std::optional< DomainBottomValFn >
-get_domain_bottom_val_fn(DomID id) {
-    auto it = BottomValFns.find(get_domain_kind(id));
-    if (it == BottomValFns.end()) {
-        return std::nullopt;
+/// \return the interned bottom value of the domain, or nullptr if the
+/// domain is not registered.
+[[nodiscard]] inline SharedVal get_domain_shared_bottom_val(DomID id) {
+    if (id >= NumDomains) {
+        return nullptr;
     }
-    return it->second;
+    auto fn = DomainValFnsTable[id].shared_bottom_val;
+    return fn == nullptr ? nullptr : fn();
 }
 
 /// \brief Base wrapper class for all domains
@@ -178,29 +309,53 @@ get_domain_bottom_val_fn(DomID id) {
 /// - `leq(const Derived& other) const`
 ///
 /// `Derived` domain may also implement the following *optional* methods:
-/// - `normalize()`
+/// - `normalize()` and `is_normalized() const`
 /// - `join_with_at_loop_head(const Derived& other)`
 /// - `join_consecutive_iter_with(const Derived& other)`
 /// - `widen_with(const Derived& other)`
 /// - `meet_with(const Derived& other)`
 /// - `narrow_with(const Derived& other)`
+/// - `join_with_changed(const Derived& other)`, `widen_with_changed(const
+///   Derived& other)` and `narrow_with_changed(const Derived& other)`
+///   returning whether the value changed, see `AbsDomBase`
 /// - `equals(const Derived& other) const`
 /// - `dump(llvm::Derived& os) const`
 template < typename Derived >
 class AbsDom : public AbsDomBase {
   public:
-    AbsDom() : AbsDomBase(Derived::get_kind()) {}
+    /// \brief The class implementing the lattice operations of `Derived`,
+    /// which are `final` so that they can be called without the vtable.
+    using DomWrapper = AbsDom< Derived >;
+
+  public:
+    /// \brief The values are accounted in the memory report by their size.
+    /// @{
+    AbsDom() : AbsDomBase(Derived::get_kind()) {
+        MemReport::add_domain_value(sizeof(Derived));
+    }
+    AbsDom(const AbsDom& other) : AbsDomBase(other) {
+        MemReport::add_domain_value(sizeof(Derived));
+    }
+    AbsDom(AbsDom&& other) noexcept : AbsDomBase(other) {
+        MemReport::add_domain_value(sizeof(Derived));
+    }
+    AbsDom& operator=(const AbsDom&) = default;
+    AbsDom& operator=(AbsDom&&) noexcept = default;
+    ~AbsDom() override { MemReport::remove_domain_value(sizeof(Derived)); }
+    /// @}
 
-    void join_with(const AbsDomBase& other) override {
+    void join_with(const AbsDomBase& other) final {
         static_assert(does_derived_dom_can_join_with< Derived >::value,
                       "derived domain needs to implement `join_with` method");
+        Stats::count(Derived::get_kind(), DomainOpKind::Join);
         static_cast< Derived* >(this)->join_with(
             static_cast< const Derived& >(other));
     }
 
-    void join_with_at_loop_head(const AbsDomBase& other) override {
+    void join_with_at_loop_head(const AbsDomBase& other) final {
         if constexpr (does_derived_dom_can_join_with_at_loop_head<
                           Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Join);
             static_cast< Derived* >(this)->join_with_at_loop_head(
                 static_cast< const Derived& >(other));
         } else {
@@ -208,9 +363,10 @@ class AbsDom : public AbsDomBase {
         }
     }
 
-    void join_consecutive_iter_with(const AbsDomBase& other) override {
+    void join_consecutive_iter_with(const AbsDomBase& other) final {
         if constexpr (does_derived_dom_can_join_consecutive_iter_with<
                           Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Join);
             static_cast< Derived* >(this)->join_consecutive_iter_with(
                 static_cast< const Derived& >(other));
         } else {
@@ -218,7 +374,8 @@ class AbsDom : public AbsDomBase {
         }
     }
 
-    void widen_with(const AbsDomBase& other) override {
+    void widen_with(const AbsDomBase& other) final {
+        Stats::count(Derived::get_kind(), DomainOpKind::Widen);
         if constexpr (does_derived_dom_can_widen_with< Derived >::value) {
             static_cast< Derived* >(this)->widen_with(
                 static_cast< const Derived& >(other));
@@ -227,7 +384,7 @@ class AbsDom : public AbsDomBase {
         }
     }
 
-    void meet_with(const AbsDomBase& other) override {
+    void meet_with(const AbsDomBase& other) final {
         if constexpr (does_derived_dom_can_meet_with< Derived >::value) {
             static_cast< Derived* >(this)->meet_with(
                 static_cast< const Derived& >(other));
@@ -236,7 +393,8 @@ class AbsDom : public AbsDomBase {
         }
     }
 
-    void narrow_with(const AbsDomBase& other) override {
+    void narrow_with(const AbsDomBase& other) final {
+        Stats::count(Derived::get_kind(), DomainOpKind::Narrow);
         if constexpr (does_derived_dom_can_narrow_with< Derived >::value) {
             static_cast< Derived* >(this)->narrow_with(
                 static_cast< const Derived& >(other));
@@ -245,17 +403,50 @@ class AbsDom : public AbsDomBase {
         }
     }
 
-    [[nodiscard]] virtual bool leq(const AbsDomBase& other) const override {
+    [[nodiscard]] bool join_with_changed(const AbsDomBase& other) final {
+        if constexpr (does_derived_dom_can_join_with_changed<
+                          Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Join);
+            return static_cast< Derived* >(this)->join_with_changed(
+                static_cast< const Derived& >(other));
+        } else {
+            return AbsDomBase::join_with_changed(other);
+        }
+    }
+
+    [[nodiscard]] bool widen_with_changed(const AbsDomBase& other) final {
+        if constexpr (does_derived_dom_can_widen_with_changed<
+                          Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Widen);
+            return static_cast< Derived* >(this)->widen_with_changed(
+                static_cast< const Derived& >(other));
+        } else {
+            return AbsDomBase::widen_with_changed(other);
+        }
+    }
+
+    [[nodiscard]] bool narrow_with_changed(const AbsDomBase& other) final {
+        if constexpr (does_derived_dom_can_narrow_with_changed<
+                          Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Narrow);
+            return static_cast< Derived* >(this)->narrow_with_changed(
+                static_cast< const Derived& >(other));
+        } else {
+            return AbsDomBase::narrow_with_changed(other);
+        }
+    }
+
+    [[nodiscard]] bool leq(const AbsDomBase& other) const final {
         static_assert(does_derived_dom_can_leq< Derived >::value,
                       "derived domain needs to implement `leq` method");
-        return static_cast< const Derived& >(other).leq(
-            static_cast< const Derived& >(*this));
+        return static_cast< const Derived& >(*this).leq(
+            static_cast< const Derived& >(other));
     }
 
-    [[nodiscard]] virtual bool equals(const AbsDomBase& other) const override {
+    [[nodiscard]] bool equals(const AbsDomBase& other) const final {
         if constexpr (does_derived_dom_can_equals< Derived >::value) {
-            return static_cast< const Derived& >(other).equals(
-                static_cast< const Derived& >(*this));
+            return static_cast< const Derived& >(*this).equals(
+                static_cast< const Derived& >(other));
         } else {
             return AbsDomBase::equals(other);
         }
@@ -15,6 +15,9 @@
 
 #include <llvm/ADT/StringRef.h>
 
+#include <cstddef>
+#include <cstdint>
+
 #ifdef DOMAIN_DEF
 #    undef DOMAIN_DEF
 #endif
@@ -83,6 +86,14 @@ inline constexpr llvm::StringRef get_domain_name_by_id(DomID id) {
     return get_domain_name(get_domain_kind(id));
 }
 
+/// \brief The number of domains, the domain IDs are dense in
+/// `[0, NumDomains)`.
+constexpr std::size_t NumDomains = 0U
+#undef DOMAIN_DEF
+#define DOMAIN_DEF(KIND, NAME, ID, DESC) +1U
+#include "analyzer/core/def/domains.def"
+    ;
+
 // NOLINTEND(cppcoreguidelines-macro-usage)
 
 } // namespace knight::analyzer
@@ -21,9 +21,41 @@
 
 #include <clang/AST/Decl.h>
 #include <clang/AST/Type.h>
+#include <llvm/ADT/ArrayRef.h>
+
+#include <algorithm>
+#include <optional>
 
 namespace knight::analyzer {
 
+/// \brief The smallest of the sorted `thresholds` not below `n`.
+template < typename Num >
+[[nodiscard]] inline std::optional< Num > get_threshold_above(
+    llvm::ArrayRef< Num > thresholds, const Num& n) {
+    const auto* it = std::lower_bound(thresholds.begin(), thresholds.end(), n);
+    if (it == thresholds.end()) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+/// \brief The largest of the sorted `thresholds` not above `n`.
+template < typename Num >
+[[nodiscard]] inline std::optional< Num > get_threshold_below(
+    llvm::ArrayRef< Num > thresholds, const Num& n) {
+    const auto* it = std::upper_bound(thresholds.begin(), thresholds.end(), n);
+    if (it == thresholds.begin()) {
+        return std::nullopt;
+    }
+    return *std::prev(it);
+}
+
+template < typename Num >
+[[nodiscard]] inline bool is_threshold(llvm::ArrayRef< Num > thresholds,
+                                       const Num& n) {
+    return std::binary_search(thresholds.begin(), thresholds.end(), n);
+}
+
 template < typename Num >
 class Interval : public AbsDom< Interval< Num > > {
   public:
@@ -41,9 +73,12 @@ class Interval : public AbsDom< Interval< Num > > {
 
   public:
     /// \brief specify the domain kind
-    [[nodiscard]] static DomainKind get_kind() { return DomainKind::ZInterval; }
+    [[nodiscard]] static constexpr DomainKind get_kind() {
+        return DomainKind::ZInterval;
+    }
     Interval() : m_lb(BoundT::ninf()), m_ub(BoundT::pinf()) {}
     Interval(BoundT lb, BoundT ub) : m_lb(std::move(lb)), m_ub(std::move(ub)) {
+        round_saturated();
         knight_assert(m_lb.is_finite() || m_ub.is_finite() || m_lb != m_ub);
         if (this->m_lb > this->m_ub) {
             this->m_lb = Num(1.);
@@ -141,8 +176,14 @@ class Interval : public AbsDom< Interval< Num > > {
         if (other.is_bottom()) {
             return;
         }
-        m_lb = min(m_lb, other.m_lb);
-        m_ub = max(m_ub, other.m_ub);
+        // Only touch the bounds which move, most joins at a loop head are
+        // stable and then do not copy any number.
+        if (other.m_lb < m_lb) {
+            m_lb = other.m_lb;
+        }
+        if (other.m_ub > m_ub) {
+            m_ub = other.m_ub;
+        }
     }
 
     void widen_with(const Interval& other) {
@@ -153,11 +194,18 @@ class Interval : public AbsDom< Interval< Num > > {
         if (other.is_bottom()) {
             return;
         }
-        m_lb = other.m_lb < m_lb ? BoundT::ninf() : m_lb;
-        m_ub = other.m_ub > m_ub ? BoundT::pinf() : m_ub;
+        if (other.m_lb < m_lb) {
+            m_lb = BoundT::ninf();
+        }
+        if (other.m_ub > m_ub) {
+            m_ub = BoundT::pinf();
+        }
     }
 
-    void widen_with_threshold(const Interval& other, const Num& threshold) {
+    /// \brief Widen the unstable bounds to the nearest of the sorted
+    /// `thresholds`, or to infinity beyond them.
+    void widen_with_threshold(const Interval& other,
+                              llvm::ArrayRef< Num > thresholds) {
         if (is_bottom()) {
             *this = other;
             return;
@@ -165,25 +213,19 @@ class Interval : public AbsDom< Interval< Num > > {
         if (other.is_bottom()) {
             return;
         }
-        BoundT thr = BoundT(threshold);
-        BoundT one = BoundT(Num(1));
         if (m_lb > other.m_lb) {
-            if (other.m_lb >= thr) {
-                m_lb = thr;
-            } else if (other.m_lb == thr - one) {
-                m_lb = thr - one;
-            } else {
-                m_lb = BoundT::ninf();
+            std::optional< Num > thr;
+            if (auto lb = other.m_lb.get_num_opt()) {
+                thr = get_threshold_below(thresholds, *lb);
             }
+            m_lb = thr ? BoundT(*thr) : BoundT::ninf();
         }
         if (m_ub < other.m_ub) {
-            if (other.m_ub <= thr) {
-                m_ub = thr;
-            } else if (other.m_ub == thr + one) {
-                m_ub = thr + one;
-            } else {
-                m_ub = BoundT::pinf();
+            std::optional< Num > thr;
+            if (auto ub = other.m_ub.get_num_opt()) {
+                thr = get_threshold_above(thresholds, *ub);
             }
+            m_ub = thr ? BoundT(*thr) : BoundT::pinf();
         }
     }
 
@@ -195,8 +237,12 @@ class Interval : public AbsDom< Interval< Num > > {
             set_to_bottom();
             return;
         }
-        m_lb = max(m_lb, other.m_lb);
-        m_ub = min(m_ub, other.m_ub);
+        if (other.m_lb > m_lb) {
+            m_lb = other.m_lb;
+        }
+        if (other.m_ub < m_ub) {
+            m_ub = other.m_ub;
+        }
     }
 
     void narrow_with(const Interval& other) {
@@ -207,11 +253,18 @@ class Interval : public AbsDom< Interval< Num > > {
             set_to_bottom();
             return;
         }
-        m_lb = m_lb.is_inf() ? other.m_lb : m_lb;
-        m_ub = m_ub.is_inf() ? other.m_ub : m_ub;
+        if (m_lb.is_inf()) {
+            m_lb = other.m_lb;
+        }
+        if (m_ub.is_inf()) {
+            m_ub = other.m_ub;
+        }
     }
 
-    void narrow_with_threshold(const Interval& other, const Num& threshold) {
+    /// \brief Narrow the bounds which are infinite or one of the sorted
+    /// `thresholds`, i.e., the ones a widening may have introduced.
+    void narrow_with_threshold(const Interval& other,
+                               llvm::ArrayRef< Num > thresholds) {
         if (is_bottom()) {
             return;
         }
@@ -219,9 +272,12 @@ class Interval : public AbsDom< Interval< Num > > {
             set_to_bottom();
             return;
         }
-        BoundT thr = BoundT(threshold);
-        m_lb = m_lb.is_inf() ? other.m_lb : (m_lb == thr ? other.m_lb : m_lb);
-        m_ub = m_ub.is_inf() ? other.m_ub : (m_ub == thr ? other.m_ub : m_ub);
+        auto is_widened = [thresholds](const BoundT& bound) {
+            auto n = bound.get_num_opt();
+            return !n || is_threshold(thresholds, *n);
+        };
+        m_lb = is_widened(m_lb) ? other.m_lb : m_lb;
+        m_ub = is_widened(m_ub) ? other.m_ub : m_ub;
     }
 
     [[nodiscard]] bool equals(const Interval& other) const {
@@ -248,6 +304,7 @@ class Interval : public AbsDom< Interval< Num > > {
         }
         m_lb += other.m_lb;
         m_ub += other.m_ub;
+        round_saturated();
     }
 
     void operator-=(const Interval& other) {
@@ -260,6 +317,7 @@ class Interval : public AbsDom< Interval< Num > > {
         }
         m_lb -= other.m_ub;
         m_ub -= other.m_lb;
+        round_saturated();
     }
 
     /// \brief Return true if the interval contains n
@@ -285,6 +343,21 @@ class Interval : public AbsDom< Interval< Num > > {
         }
     }
 
+  private:
+    /// \brief Round the bounds which saturated on the same infinity, which
+    /// only a saturating bound yields, to the nearest finite bound that
+    /// keeps the interval sound: down for the lower bound, up for the upper
+    /// one.
+    void round_saturated() {
+        if constexpr (BoundT::IsSaturating) {
+            if (m_lb.is_pinf() && m_ub.is_pinf()) {
+                m_lb = BoundT::max_finite();
+            } else if (m_lb.is_ninf() && m_ub.is_ninf()) {
+                m_ub = BoundT::min_finite();
+            }
+        }
+    }
+
 }; // class Interval
 
 template < typename Num >
@@ -585,6 +658,7 @@ inline Interval< Num > operator^(const Interval< Num >& lhs,
 }
 
 using ZInterval = Interval< ZNum >;
+using SmallInterval = Interval< int64_t >;
 
 inline ZInterval trim_bound(const ZInterval& itv, const ZBound& b) {
     knight_assert(!itv.is_bottom());
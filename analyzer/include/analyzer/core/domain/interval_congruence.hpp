@@ -0,0 +1,347 @@
+//===- interval_congruence.hpp ----------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the reduced product of the interval and the
+//  congruence value domains
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/congruence.hpp"
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/interval.hpp"
+
+#include <clang/AST/Type.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace knight::analyzer {
+
+/// \brief Reduced product of an interval and a congruence.
+///
+/// The reduction is lazy: the operations combine the two components
+/// separately and only mark the value as not normalized. `normalize()`
+/// reduces it, which the engine does at the loop heads and when storing
+/// the invariants; the queries reduce a copy with `reduced()`. The
+/// transfer functions thus cost about as much as on the intervals.
+template < typename Num >
+class IntervalCongruence : public AbsDom< IntervalCongruence< Num > > {
+  public:
+    using BoundT = Bound< Num >;
+    using IntervalT = Interval< Num >;
+    using CongruenceT = Congruence< Num >;
+
+  private:
+    IntervalT m_itv;
+    CongruenceT m_cong;
+    bool m_is_reduced;
+
+  public:
+    [[nodiscard]] static constexpr DomainKind get_kind() {
+        return DomainKind::ZIntervalCongruence;
+    }
+
+    IntervalCongruence() : m_is_reduced(true) {}
+    IntervalCongruence(IntervalT itv, CongruenceT cong)
+        : m_itv(std::move(itv)), m_cong(std::move(cong)),
+          m_is_reduced(m_cong.is_top()) {}
+    explicit IntervalCongruence(IntervalT itv)
+        : m_itv(std::move(itv)), m_is_reduced(true) {}
+    explicit IntervalCongruence(Num n)
+        : m_itv(n), m_cong(std::move(n)), m_is_reduced(true) {}
+
+    IntervalCongruence(const IntervalCongruence&) = default;
+    IntervalCongruence(IntervalCongruence&&) noexcept = default;
+    IntervalCongruence& operator=(const IntervalCongruence&) = default;
+    IntervalCongruence& operator=(IntervalCongruence&&) noexcept = default;
+    ~IntervalCongruence() override = default;
+
+  public:
+    [[nodiscard]] static IntervalCongruence top() { return {}; }
+    [[nodiscard]] static IntervalCongruence bottom() {
+        return IntervalCongruence(IntervalT::bottom());
+    }
+
+    [[nodiscard]] static SharedVal default_val() {
+        return std::make_shared< IntervalCongruence >();
+    }
+
+    [[nodiscard]] static SharedVal bottom_val() {
+        return std::make_shared< IntervalCongruence >(bottom());
+    }
+
+    [[nodiscard]] AbsDomBase* clone() const override {
+        return new IntervalCongruence(*this);
+    }
+
+    [[nodiscard]] const IntervalT& get_interval() const { return m_itv; }
+    [[nodiscard]] const CongruenceT& get_congruence() const { return m_cong; }
+
+    /// \brief The value reduced, without reducing this one.
+    [[nodiscard]] IntervalCongruence reduced() const {
+        IntervalCongruence value = *this;
+        value.normalize();
+        return value;
+    }
+
+  public:
+    [[nodiscard]] bool is_bottom() const override {
+        return m_itv.is_bottom() || m_cong.is_bottom();
+    }
+
+    [[nodiscard]] bool is_top() const override {
+        return m_itv.is_top() && m_cong.is_top();
+    }
+
+    void set_to_bottom() override { *this = bottom(); }
+    void set_to_top() override { *this = top(); }
+
+    [[nodiscard]] bool is_normalized() const override { return m_is_reduced; }
+
+    /// \brief Tighten the interval bounds to the values of the congruence,
+    /// and the congruence to a singleton interval.
+    void normalize() override {
+        if (m_is_reduced) {
+            return;
+        }
+        m_is_reduced = true;
+        if (is_bottom()) {
+            set_to_bottom();
+            return;
+        }
+        if (auto n = m_cong.get_singleton_opt()) {
+            if (!m_itv.contains(*n)) {
+                set_to_bottom();
+                return;
+            }
+            m_itv = IntervalT(*n);
+            return;
+        }
+        const Num& modulus = m_cong.get_modulus();
+        const Num& residue = m_cong.get_residue();
+        BoundT lb = m_itv.get_lb();
+        BoundT ub = m_itv.get_ub();
+        if (auto n = lb.get_num_opt()) {
+            lb = BoundT(*n + mod(residue - *n, modulus));
+        }
+        if (auto n = ub.get_num_opt()) {
+            ub = BoundT(*n - mod(*n - residue, modulus));
+        }
+        if (lb > ub) {
+            set_to_bottom();
+            return;
+        }
+        m_itv = IntervalT(lb, ub);
+        if (auto n = m_itv.get_singleton_opt()) {
+            m_cong = CongruenceT(*n);
+        }
+    }
+
+    void join_with(const IntervalCongruence& other) {
+        apply(other, &IntervalT::join_with, &CongruenceT::join_with);
+    }
+
+    void widen_with(const IntervalCongruence& other) {
+        apply(other, &IntervalT::widen_with, &CongruenceT::widen_with);
+    }
+
+    void meet_with(const IntervalCongruence& other) {
+        apply(other, &IntervalT::meet_with, &CongruenceT::meet_with);
+    }
+
+    void narrow_with(const IntervalCongruence& other) {
+        apply(other, &IntervalT::narrow_with, &CongruenceT::narrow_with);
+    }
+
+    void widen_with_threshold(const IntervalCongruence& other,
+                              llvm::ArrayRef< Num > thresholds) {
+        m_itv.widen_with_threshold(other.m_itv, thresholds);
+        m_cong.widen_with(other.m_cong);
+        m_is_reduced = false;
+    }
+
+    void narrow_with_threshold(const IntervalCongruence& other,
+                               llvm::ArrayRef< Num > thresholds) {
+        m_itv.narrow_with_threshold(other.m_itv, thresholds);
+        m_cong.narrow_with(other.m_cong);
+        m_is_reduced = false;
+    }
+
+    /// \brief Compare the components, which may miss the order of two
+    /// values not reduced.
+    [[nodiscard]] bool leq(const IntervalCongruence& other) const {
+        if (is_bottom()) {
+            return true;
+        }
+        if (other.is_bottom()) {
+            return false;
+        }
+        return m_itv.leq(other.m_itv) && m_cong.leq(other.m_cong);
+    }
+
+    [[nodiscard]] bool equals(const IntervalCongruence& other) const {
+        if (is_bottom() || other.is_bottom()) {
+            return is_bottom() == other.is_bottom();
+        }
+        return m_itv.equals(other.m_itv) && m_cong.equals(other.m_cong);
+    }
+
+    void operator+=(const IntervalCongruence& other) {
+        *this = *this + other;
+    }
+
+    void operator-=(const IntervalCongruence& other) {
+        *this = *this - other;
+    }
+
+    void cast(clang::QualType type, unsigned bit_width) {
+        m_itv.cast(type, bit_width);
+        m_cong.cast(type, bit_width);
+    }
+
+    void dump(llvm::raw_ostream& os) const override {
+        if (is_bottom()) {
+            os << "⊥";
+            return;
+        }
+        m_itv.dump(os);
+        if (!m_cong.is_top() && !m_cong.get_singleton_opt()) {
+            os << " ∩ ";
+            m_cong.dump(os);
+        }
+    }
+
+  private:
+    void apply(const IntervalCongruence& other,
+               void (IntervalT::*itv_op)(const IntervalT&),
+               void (CongruenceT::*cong_op)(const CongruenceT&)) {
+        (m_itv.*itv_op)(other.m_itv);
+        (m_cong.*cong_op)(other.m_cong);
+        m_is_reduced = m_cong.is_top();
+    }
+
+}; // class IntervalCongruence
+
+template < typename Num >
+inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                                     const IntervalCongruence< Num >& dom) {
+    dom.dump(os);
+    return os;
+}
+
+namespace impl {
+
+/// \brief Apply the operator `op` on each component.
+template < typename Num, typename Op >
+inline IntervalCongruence< Num > combine(const IntervalCongruence< Num >& lhs,
+                                         const IntervalCongruence< Num >& rhs,
+                                         Op op) {
+    return IntervalCongruence< Num >(op(lhs.get_interval(),
+                                        rhs.get_interval()),
+                                     op(lhs.get_congruence(),
+                                        rhs.get_congruence()));
+}
+
+} // namespace impl
+
+template < typename Num >
+inline IntervalCongruence< Num > operator+(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x + y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator-(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x - y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator*(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x * y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator/(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x / y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator%(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x % y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator<<(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x << y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator>>(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x >> y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator&(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x & y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator|(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x | y;
+    });
+}
+
+template < typename Num >
+inline IntervalCongruence< Num > operator^(
+    const IntervalCongruence< Num >& lhs,
+    const IntervalCongruence< Num >& rhs) {
+    return impl::combine(lhs, rhs, [](const auto& x, const auto& y) {
+        return x ^ y;
+    });
+}
+
+using ZIntervalCongruence = IntervalCongruence< ZNum >;
+
+} // namespace knight::analyzer
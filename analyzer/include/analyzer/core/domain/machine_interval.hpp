@@ -0,0 +1,260 @@
+//===- machine_interval.hpp -------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the machine integer interval value domain
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/bound.hpp"
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/core/domain/num/machine_znum.hpp"
+#include "analyzer/core/domain/num/znum.hpp"
+
+#include <clang/AST/Type.h>
+#include <llvm/ADT/ArrayRef.h>
+
+#include <optional>
+
+namespace knight::analyzer {
+
+/// \brief The bit-width and the signedness of a C integer type.
+struct MachineIntType {
+    unsigned bit_width;
+    Signedness sign;
+}; // struct MachineIntType
+
+/// \brief The machine type of the integer or enumeration `type`, none for
+/// `bool`, the integers wider than 64 bits and the other types.
+///
+/// The analyzed target is assumed to share the data model of the host,
+/// i.e. the width of `long` and `wchar_t`.
+[[nodiscard]] std::optional< MachineIntType > get_machine_int_type(
+    clang::QualType type);
+
+/// \brief Interval of machine integers, on native 64-bit bounds.
+///
+/// The bounds are `SmallBound`s, so the arithmetic never allocates: the
+/// results out of the 64-bit range saturate to the infinities. `wrap`
+/// brings an interval back into the range of a C integer type, as the
+/// C conversions and the unsigned arithmetic wrap around.
+///
+/// The interface takes `ZNum`s, so that the value plugs into the
+/// `SeparateNumericalDom` of the `ZNum` variables.
+class MachineInterval : public AbsDom< MachineInterval > {
+  public:
+    using BoundT = SmallBound;
+    using IntervalT = SmallInterval;
+
+  private:
+    /// \brief The bounds, bottom if the lower one is above the upper one.
+    BoundT m_lb;
+    BoundT m_ub;
+
+  public:
+    MachineInterval() : m_lb(BoundT::ninf()), m_ub(BoundT::pinf()) {}
+    explicit MachineInterval(const IntervalT& itv)
+        : m_lb(itv.get_lb()), m_ub(itv.get_ub()) {}
+
+    /// \brief The bounds out of the 64-bit range saturate.
+    explicit MachineInterval(const ZNum& n)
+        : MachineInterval(IntervalT(to_small(ZBound(n)))) {}
+    explicit MachineInterval(const ZInterval& itv)
+        : MachineInterval(itv.is_bottom()
+                              ? IntervalT::bottom()
+                              : IntervalT(to_small(itv.get_lb()),
+                                          to_small(itv.get_ub()))) {}
+
+    MachineInterval(const MachineInterval&) = default;
+    MachineInterval(MachineInterval&&) = default;
+    MachineInterval& operator=(const MachineInterval&) = default;
+    MachineInterval& operator=(MachineInterval&&) = default;
+    ~MachineInterval() override = default;
+
+  public:
+    [[nodiscard]] static constexpr DomainKind get_kind() {
+        return DomainKind::MachineInterval;
+    }
+
+    [[nodiscard]] static SharedVal default_val() {
+        return std::make_shared< MachineInterval >();
+    }
+
+    [[nodiscard]] static SharedVal bottom_val() {
+        return std::make_shared< MachineInterval >(bottom());
+    }
+
+    [[nodiscard]] static MachineInterval top() { return {}; }
+    [[nodiscard]] static MachineInterval bottom() {
+        return MachineInterval(IntervalT::bottom());
+    }
+
+    [[nodiscard]] AbsDomBase* clone() const override {
+        return new MachineInterval(*this);
+    }
+
+    [[nodiscard]] static BoundT to_small(const ZBound& b);
+    [[nodiscard]] static ZBound to_z(const BoundT& b);
+
+    [[nodiscard]] IntervalT get_interval() const {
+        return is_bottom() ? IntervalT::bottom() : IntervalT(m_lb, m_ub);
+    }
+
+    [[nodiscard]] ZInterval to_z_interval() const {
+        if (is_bottom()) {
+            return ZInterval::bottom();
+        }
+        return {to_z(m_lb), to_z(m_ub)};
+    }
+
+    [[nodiscard]] const BoundT& get_lb() const { return m_lb; }
+    [[nodiscard]] const BoundT& get_ub() const { return m_ub; }
+
+  public:
+    [[nodiscard]] bool is_bottom() const override { return m_lb > m_ub; }
+    [[nodiscard]] bool is_top() const override {
+        return m_lb.is_ninf() && m_ub.is_pinf();
+    }
+
+    void set_to_bottom() override { *this = bottom(); }
+    void set_to_top() override { *this = top(); }
+
+    void join_with(const MachineInterval& other) {
+        *this = MachineInterval(apply(other, &IntervalT::join_with));
+    }
+
+    void widen_with(const MachineInterval& other) {
+        *this = MachineInterval(apply(other, &IntervalT::widen_with));
+    }
+
+    void meet_with(const MachineInterval& other) {
+        *this = MachineInterval(apply(other, &IntervalT::meet_with));
+    }
+
+    void narrow_with(const MachineInterval& other) {
+        *this = MachineInterval(apply(other, &IntervalT::narrow_with));
+    }
+
+    [[nodiscard]] bool leq(const MachineInterval& other) const {
+        return get_interval().leq(other.get_interval());
+    }
+
+    [[nodiscard]] bool equals(const MachineInterval& other) const {
+        return get_interval().equals(other.get_interval());
+    }
+
+    /// \brief Widen the unstable bounds to the nearest of the sorted
+    /// `thresholds`, or to infinity beyond them.
+    void widen_with_threshold(const MachineInterval& other,
+                              llvm::ArrayRef< ZNum > thresholds) {
+        auto itv = to_z_interval();
+        itv.widen_with_threshold(other.to_z_interval(), thresholds);
+        *this = MachineInterval(itv);
+    }
+
+    /// \brief Narrow the bounds which are infinite or one of the sorted
+    /// `thresholds`.
+    void narrow_with_threshold(const MachineInterval& other,
+                               llvm::ArrayRef< ZNum > thresholds) {
+        auto itv = to_z_interval();
+        itv.narrow_with_threshold(other.to_z_interval(), thresholds);
+        *this = MachineInterval(itv);
+    }
+
+    /// \brief Wrap the interval around the range of the machine integer
+    /// `type`, i.e. reduce it modulo 2^bit-width into the range.
+    ///
+    /// The interval becomes the whole range if its values do not wrap
+    /// onto a single interval of the range.
+    void wrap(MachineIntType type);
+
+    /// \brief Apply the C conversion to `type`, of `bit_width` bits.
+    void cast(clang::QualType type, unsigned bit_width);
+
+    void dump(llvm::raw_ostream& os) const override {
+        get_interval().dump(os);
+    }
+
+  public:
+    void operator+=(const MachineInterval& other) {
+        *this = *this + other;
+    }
+
+    void operator-=(const MachineInterval& other) {
+        *this = *this - other;
+    }
+
+    friend MachineInterval operator+(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.get_interval() + rhs.get_interval());
+    }
+
+    friend MachineInterval operator-(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.get_interval() - rhs.get_interval());
+    }
+
+    friend MachineInterval operator*(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.get_interval() * rhs.get_interval());
+    }
+
+    friend MachineInterval operator/(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.get_interval() / rhs.get_interval());
+    }
+
+    friend MachineInterval operator%(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.get_interval() % rhs.get_interval());
+    }
+
+    // The shifts and the bitwise operators compute powers of two which may
+    // exceed 64 bits, so they go through the unbounded intervals.
+
+    friend MachineInterval operator<<(const MachineInterval& lhs,
+                                      const MachineInterval& rhs) {
+        return MachineInterval(lhs.to_z_interval() << rhs.to_z_interval());
+    }
+
+    friend MachineInterval operator>>(const MachineInterval& lhs,
+                                      const MachineInterval& rhs) {
+        return MachineInterval(lhs.to_z_interval() >> rhs.to_z_interval());
+    }
+
+    friend MachineInterval operator&(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.to_z_interval() & rhs.to_z_interval());
+    }
+
+    friend MachineInterval operator|(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.to_z_interval() | rhs.to_z_interval());
+    }
+
+    friend MachineInterval operator^(const MachineInterval& lhs,
+                                     const MachineInterval& rhs) {
+        return MachineInterval(lhs.to_z_interval() ^ rhs.to_z_interval());
+    }
+
+  private:
+    [[nodiscard]] IntervalT apply(
+        const MachineInterval& other,
+        void (IntervalT::*op)(const IntervalT&)) const {
+        IntervalT itv = get_interval();
+        (itv.*op)(other.get_interval());
+        return itv;
+    }
+
+}; // class MachineInterval
+
+} // namespace knight::analyzer
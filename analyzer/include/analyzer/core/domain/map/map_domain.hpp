@@ -15,22 +15,35 @@
 
 #include "analyzer/core/domain/dom_base.hpp"
 #include "analyzer/core/domain/domains.hpp"
+#include "analyzer/util/patricia_tree.hpp"
 #include "common/support/dumpable.hpp"
 
+#include <optional>
+
 namespace knight::analyzer {
 
+/// \brief Map lattice from keys to separate abstract values.
+///
+/// The table is a persistent Patricia tree, so copying a map is O(1) and
+/// the binary operations skip the subtrees shared by both operands, e.g.,
+/// joining two states which only differ in a few keys is cheap even for
+/// large tables.
 template < typename Key, derived_dom SeparateValue, DomainKind domain_kind >
 class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
   public:
-    using Map = std::unordered_map< Key, SeparateValue >;
+    using Map = PatriciaTree< Key, SeparateValue >;
 
   private:
     Map m_table;
     bool m_is_bottom;
+    /// \brief Whether all the values are normalized.
+    bool m_is_normalized;
 
   public:
     explicit MapDom(bool is_bottom = false, Map table = {})
-        : m_is_bottom(is_bottom), m_table(std::move(table)) {}
+        : m_is_bottom(is_bottom),
+          m_table(std::move(table)),
+          m_is_normalized(m_table.empty()) {}
 
     MapDom(const MapDom&) = default;
     MapDom(MapDom&&) = default;
@@ -58,9 +71,8 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
                 SeparateValue::bottom_val().get()));
         }
 
-        auto it = m_table.find(key);
-        if (it != m_table.end()) {
-            return it->second;
+        if (const auto* value = m_table.find(key)) {
+            return *value;
         }
         return *(static_cast< const SeparateValue* >(
             SeparateValue::default_val().get()));
@@ -75,7 +87,8 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
         } else if (value.is_top()) {
             this->forget(key);
         } else {
-            this->m_table[key] = value;
+            this->m_table.insert_or_assign(key, value);
+            m_is_normalized = m_is_normalized && value.is_normalized();
         }
     }
 
@@ -86,46 +99,57 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
 
         if (value.is_bottom()) {
             this->set_to_bottom();
+            return;
         }
 
         if (value.is_top()) {
             return;
         }
 
-        auto it = m_table.find(key);
-        if (it != m_table.end()) {
-            it->second.meet_with(value);
+        const auto* old_value = m_table.find(key);
+        if (old_value == nullptr) {
+            m_table.insert_or_assign(key, value);
+            m_is_normalized = m_is_normalized && value.is_normalized();
             return;
         }
-        it->second.meet_with(value);
-        if (it->second.is_bottom()) {
+        SeparateValue new_value = *old_value;
+        new_value.meet_with(value);
+        if (new_value.is_bottom()) {
             this->set_to_bottom();
+            return;
         }
+        m_is_normalized = m_is_normalized && new_value.is_normalized();
+        m_table.insert_or_assign(key, std::move(new_value));
     }
 
   public:
-    static DomainKind get_kind() { return domain_kind; }
+    static constexpr DomainKind get_kind() { return domain_kind; }
 
     static SharedVal default_val() { return std::make_shared< MapDom >(false); }
     static SharedVal bottom_val() { return std::make_shared< MapDom >(true); }
 
     [[nodiscard]] AbsDomBase* clone() const override {
-        Map table;
-        for (auto& [key, value] : m_table) {
-            if constexpr (isa_abs_dom< Key >::value) {
-                table[*static_cast< Key* >(key.clone())] =
-                    *(static_cast< SeparateValue* >(value.clone()));
-            } else {
-                table[key] = *(static_cast< SeparateValue* >(value.clone()));
-            }
-        }
-        return new MapDom(m_is_bottom, table);
+        return new MapDom(*this);
     }
 
     void normalize() override {
-        for (auto& [_, value] : m_table) {
-            value.normalize();
+        if (m_is_normalized) {
+            return;
         }
+        m_table.transform([](const Key&, const SeparateValue& value)
+                              -> std::optional< SeparateValue > {
+            SeparateValue normalized = value;
+            normalized.normalize();
+            if (normalized.equals(value)) {
+                return std::nullopt;
+            }
+            return normalized;
+        });
+        m_is_normalized = true;
+    }
+
+    [[nodiscard]] bool is_normalized() const override {
+        return m_is_normalized;
     }
 
     [[nodiscard]] bool is_bottom() const override { return m_is_bottom; }
@@ -136,128 +160,68 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
 
     void set_to_bottom() override {
         m_is_bottom = true;
-        Map().swap(m_table);
+        m_is_normalized = true;
+        m_table.clear();
     }
 
     void set_to_top() override {
         m_is_bottom = false;
-        Map().swap(m_table);
+        m_is_normalized = true;
+        m_table.clear();
     }
 
-    void join_with(const MapDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.join_with(value);
-            }
-        }
+    void join_with(const MapDom& other) { (void)join_with_changed(other); }
+
+    [[nodiscard]] bool join_with_changed(const MapDom& other) {
+        return upper_bound_with(other,
+                                [](SeparateValue& value,
+                                   const SeparateValue& other_value) {
+                                    value.join_with(other_value);
+                                });
     }
 
     void join_with_at_loop_head(const MapDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.join_with_at_loop_head(value);
-            }
-        }
+        upper_bound_with(other,
+                         [](SeparateValue& value,
+                            const SeparateValue& other_value) {
+                             value.join_with_at_loop_head(other_value);
+                         });
     }
 
     void join_consecutive_iter_with(const MapDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.join_consecutive_iter_with(value);
-            }
-        }
+        upper_bound_with(other,
+                         [](SeparateValue& value,
+                            const SeparateValue& other_value) {
+                             value.join_consecutive_iter_with(other_value);
+                         });
     }
 
-    void widen_with(const MapDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.widen_with(value);
-            }
-        }
+    void widen_with(const MapDom& other) { (void)widen_with_changed(other); }
+
+    [[nodiscard]] bool widen_with_changed(const MapDom& other) {
+        return upper_bound_with(other,
+                                [](SeparateValue& value,
+                                   const SeparateValue& other_value) {
+                                    value.widen_with(other_value);
+                                });
     }
 
     void meet_with(const MapDom& other) {
-        if (this->is_bottom()) {
-            return;
-        }
-        if (other.is_bottom()) {
-            *this = other;
-            return;
-        }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.meet_with(value);
-                if (it->second.is_bottom()) {
-                    this->set_to_bottom();
-                    return;
-                }
-            }
-        }
+        (void)lower_bound_with(other,
+                               [](SeparateValue& value,
+                                  const SeparateValue& other_value) {
+                                   value.meet_with(other_value);
+                               });
     }
 
-    void narrow_with(const MapDom& other) {
-        if (this->is_bottom()) {
-            return;
-        }
-        if (other.is_bottom()) {
-            *this = other;
-            return;
-        }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.narrow_with(value);
-                if (it->second.is_bottom()) {
-                    this->set_to_bottom();
-                    return;
-                }
-            }
-        }
+    void narrow_with(const MapDom& other) { (void)narrow_with_changed(other); }
+
+    [[nodiscard]] bool narrow_with_changed(const MapDom& other) {
+        return lower_bound_with(other,
+                                [](SeparateValue& value,
+                                   const SeparateValue& other_value) {
+                                    value.narrow_with(other_value);
+                                });
     }
 
     [[nodiscard]] bool leq(const MapDom& other) const {
@@ -267,19 +231,11 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
         if (other.is_bottom()) {
             return false;
         }
-        if (this->m_table.size() > other.m_table.size()) {
-            return false;
-        }
-        for (auto& [key, value] : this->m_table) {
-            auto it = other.m_table.find(key);
-            if (it == other.m_table.end()) {
-                return false;
-            }
-            if (!value.leq(it->second)) {
-                return false;
-            }
-        }
-        return true;
+        return m_table.is_subset_of(other.m_table,
+                                    [](const SeparateValue& value,
+                                       const SeparateValue& other_value) {
+                                        return value.leq(other_value);
+                                    });
     }
 
     [[nodiscard]] bool equals(const MapDom& other) const {
@@ -289,19 +245,19 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
         if (other.is_bottom()) {
             return false;
         }
-        if (this->m_table.size() != other.m_table.size()) {
-            return false;
-        }
-        for (auto& [key, value] : this->m_table) {
-            auto it = other.m_table.find(key);
-            if (it == other.m_table.end()) {
-                return false;
-            }
-            if (!value.equals(it->second)) {
-                return false;
-            }
+        if (m_table.is_identical(other.m_table)) {
+            return true;
         }
-        return true;
+        return m_table.is_subset_of(other.m_table,
+                                    [](const SeparateValue& value,
+                                       const SeparateValue& other_value) {
+                                        return value.equals(other_value);
+                                    }) &&
+               other.m_table.is_subset_of(m_table,
+                                          [](const SeparateValue&,
+                                             const SeparateValue&) {
+                                              return true;
+                                          });
     }
 
     void dump(llvm::raw_ostream& os) const override {
@@ -310,7 +266,8 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
         } else {
             os << "{";
             bool first = true;
-            for (auto& [key, value] : m_table) {
+            m_table.for_each([&os, &first](const Key& key,
+                                           const SeparateValue& value) {
                 if (!first) {
                     os << ", ";
                 }
@@ -318,11 +275,88 @@ class MapDom : public AbsDom< MapDom< Key, SeparateValue, domain_kind > > {
                 os << ": ";
                 DumpableTrait< SeparateValue >::dump(os, value);
                 first = false;
-            }
+            });
             os << "}";
         }
     }
 
+  private:
+    /// \brief Combine the common values by an upper bound `op`.
+    ///
+    /// A value already above the other one is kept, so that the subtree
+    /// holding it stays shared.
+    ///
+    /// \returns true if the map changed, i.e. its tree was rebuilt.
+    template < typename Op >
+    bool upper_bound_with(const MapDom& other, Op op) {
+        if (other.is_bottom()) {
+            return false;
+        }
+        if (this->is_bottom()) {
+            *this = other;
+            return true;
+        }
+        const Map table = m_table;
+        m_is_normalized = m_is_normalized && other.m_is_normalized;
+        m_table.merge_with(other.m_table,
+                           [this, &op](const Key&,
+                                       const SeparateValue& value,
+                                       const SeparateValue& other_value)
+                               -> std::optional< SeparateValue > {
+                               if (other_value.leq(value)) {
+                                   return std::nullopt;
+                               }
+                               SeparateValue res = value;
+                               op(res, other_value);
+                               m_is_normalized =
+                                   m_is_normalized && res.is_normalized();
+                               return res;
+                           });
+        return !m_table.is_identical(table);
+    }
+
+    /// \brief Combine the common values by a lower bound `op`, the map
+    /// becomes bottom if any of the combined values is bottom.
+    ///
+    /// A value already below the other one is kept, as for the upper
+    /// bounds.
+    ///
+    /// \returns true if the map changed.
+    template < typename Op >
+    bool lower_bound_with(const MapDom& other, Op op) {
+        if (this->is_bottom()) {
+            return false;
+        }
+        if (other.is_bottom()) {
+            *this = other;
+            return true;
+        }
+        const Map table = m_table;
+        bool is_bottom = false;
+        m_is_normalized = m_is_normalized && other.m_is_normalized;
+        m_table.merge_with(other.m_table,
+                           [this, &op, &is_bottom](
+                               const Key&,
+                               const SeparateValue& value,
+                               const SeparateValue& other_value)
+                               -> std::optional< SeparateValue > {
+                               if (is_bottom || value.leq(other_value)) {
+                                   return std::nullopt;
+                               }
+                               SeparateValue res = value;
+                               op(res, other_value);
+                               is_bottom = res.is_bottom();
+                               m_is_normalized =
+                                   m_is_normalized && res.is_normalized();
+                               return res;
+                           });
+        if (is_bottom) {
+            this->set_to_bottom();
+            return true;
+        }
+        return !m_table.is_identical(table);
+    }
+
 }; // class MapDom
 
 } // namespace knight::analyzer
\ No newline at end of file
@@ -18,13 +18,20 @@
 #include "analyzer/core/domain/domains.hpp"
 #include "analyzer/core/domain/interval.hpp"
 #include "analyzer/core/domain/numerical/numerical_base.hpp"
+#include "analyzer/util/flat_map.hpp"
 #include "common/util/assert.hpp"
 
 #include <clang/AST/Expr.h>
 #include <clang/AST/OperationKinds.h>
-#include <llvm/ADT/DenseMap.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
 namespace knight::analyzer {
 
 template < typename Num,
@@ -35,7 +42,16 @@ class SeparateNumericalDom
           SeparateNumericalDom< Num, SeparateNumericalValue, DomKind > > {
   public:
     using Var = Variable< Num >;
-    using Map = llvm::DenseMap< Var, SeparateNumericalValue >;
+    /// \brief Order of the variables in the table, by their symbols.
+    struct VarLess {
+        bool operator()(const Var& lhs, const Var& rhs) const {
+            return std::less< SymbolRef >()(lhs.m_symbol, rhs.m_symbol);
+        }
+    }; // struct VarLess
+
+    /// \brief The variables are kept sorted, so that the lattice operations
+    /// are linear merges of two tables instead of a lookup per variable.
+    using Map = FlatMap< Var, SeparateNumericalValue, VarLess >;
     using LinearExprT = LinearExpr< Num >;
     using LinearConstraintT = LinearConstraint< Num >;
     using LinearConstraintSystemT = LinearConstraintSystem< Num >;
@@ -43,10 +59,31 @@ class SeparateNumericalDom
   private:
     Map m_table;
     bool m_is_bottom = false;
+    /// \brief Whether all the values are normalized, so that `normalize()`
+    /// does not need to walk the table.
+    bool m_is_normalized = true;
+
+    /// \brief The snapshot the table derives from. The copies keep the
+    /// stamp, so that the tables of a cycle head and of its iterations
+    /// share it.
+    std::uint64_t m_stamp;
+    /// \brief The sorted symbols of the variables which may differ from
+    /// the snapshot, the other ones being the same in all the tables of
+    /// the stamp.
+    ///
+    /// The lattice operations of two tables of the same stamp only visit
+    /// their dirty variables, e.g., the widening at a cycle head only
+    /// touches the variables changed by the iterations.
+    std::vector< SymbolRef > m_dirty;
 
   public:
     SeparateNumericalDom(bool is_bottom, Map table = {})
-        : m_is_bottom(is_bottom), m_table(std::move(table)) {}
+        : m_is_bottom(is_bottom), m_table(std::move(table)),
+          m_stamp(get_fresh_stamp()) {
+        for (const auto& [_, value] : m_table) {
+            note_value(value);
+        }
+    }
 
     SeparateNumericalDom(const SeparateNumericalDom&) = default;
     SeparateNumericalDom(SeparateNumericalDom&&) = default;
@@ -65,7 +102,9 @@ class SeparateNumericalDom
         if (this->is_bottom()) {
             return;
         }
-        this->m_table.erase(x);
+        if (this->m_table.erase(x) != 0U) {
+            mark_dirty(x);
+        }
     }
 
     SeparateNumericalValue get_value(const Var& key) const {
@@ -92,6 +131,8 @@ class SeparateNumericalDom
             this->forget(key);
         } else {
             this->m_table[key] = value;
+            note_value(value);
+            mark_dirty(key);
         }
     }
 
@@ -116,11 +157,207 @@ class SeparateNumericalDom
         it->second.meet_with(value);
         if (it->second.is_bottom()) {
             this->set_to_bottom();
+            return;
+        }
+        note_value(it->second);
+        mark_dirty(key);
+    }
+
+  private:
+    [[nodiscard]] static std::uint64_t get_fresh_stamp() {
+        static std::atomic< std::uint64_t > stamp_cnt{0U};
+        return ++stamp_cnt;
+    }
+
+    /// \brief Make the table its own snapshot.
+    void restamp() {
+        m_stamp = get_fresh_stamp();
+        m_dirty.clear();
+    }
+
+    /// \brief Whether the dirty variables are too many to be worth
+    /// tracking, i.e., about half of the table.
+    [[nodiscard]] bool has_many_dirty() const {
+        return 2U * m_dirty.size() > m_table.size() + 1U;
+    }
+
+    void mark_dirty(const Var& x) {
+        auto it = std::lower_bound(m_dirty.begin(),
+                                   m_dirty.end(),
+                                   x.m_symbol,
+                                   std::less< SymbolRef >());
+        if (it != m_dirty.end() && *it == x.m_symbol) {
+            return;
+        }
+        if (has_many_dirty()) {
+            restamp();
+            it = m_dirty.end();
+        }
+        m_dirty.insert(it, x.m_symbol);
+    }
+
+    /// \brief Get the sorted variables dirty in either table, the only
+    /// ones to visit for two tables of the same stamp.
+    [[nodiscard]] std::vector< SymbolRef > get_dirty_union(
+        const SeparateNumericalDom& other) const {
+        std::vector< SymbolRef > dirty;
+        dirty.reserve(m_dirty.size() + other.m_dirty.size());
+        std::set_union(m_dirty.begin(),
+                       m_dirty.end(),
+                       other.m_dirty.begin(),
+                       other.m_dirty.end(),
+                       std::back_inserter(dirty),
+                       std::less< SymbolRef >());
+        return dirty;
+    }
+
+    /// \brief Check the predicate on the possibly missing values of the
+    /// dirty variables of two tables of the same stamp.
+    template < typename Pred >
+    [[nodiscard]] bool all_dirty_values_of(const SeparateNumericalDom& other,
+                                           Pred pred) const {
+        for (auto* symbol : get_dirty_union(other)) {
+            const Var x(symbol);
+            auto it = m_table.find(x);
+            auto other_it = other.m_table.find(x);
+            if (!pred(it != m_table.end() ? &it->second : nullptr,
+                      other_it != other.m_table.end() ? &other_it->second
+                                                      : nullptr)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief Combine the dirty variables of the other table of the same
+    /// stamp, the other ones being the same in both.
+    template < typename Op >
+    bool merge_dirty_with(const SeparateNumericalDom& other, Op op) {
+        m_dirty = get_dirty_union(other);
+        for (auto* symbol : m_dirty) {
+            const Var x(symbol);
+            auto other_it = other.m_table.find(x);
+            if (other_it == other.m_table.end()) {
+                continue;
+            }
+            auto [it, inserted] = m_table.try_emplace(x, other_it->second);
+            if (!inserted && !op(it->second, other_it->second)) {
+                return false;
+            }
+            note_value(it->second);
+        }
+        if (has_many_dirty()) {
+            restamp();
+        }
+        return true;
+    }
+
+    void note_value(const SeparateNumericalValue& value) {
+        m_is_normalized = m_is_normalized && value.is_normalized();
+    }
+
+    /// \brief Combine the other table into this one in a linear pass.
+    ///
+    /// The variables only in the other table are copied, and the values of
+    /// the common ones are combined by `op`, which returns false if the
+    /// combined value is bottom. The table is updated in place as long as
+    /// the variables of the other table are present. The tables of the same
+    /// stamp only combine their dirty variables.
+    ///
+    /// \returns false if a combined value is bottom.
+    template < typename Op >
+    bool merge_table_with(const SeparateNumericalDom& other, Op op) {
+        if (m_stamp == other.m_stamp) {
+            return merge_dirty_with(other, op);
+        }
+        // Any value may change, the result is its own snapshot.
+        restamp();
+        const auto& other_table = other.m_table;
+        auto it = m_table.begin();
+        auto other_it = other_table.begin();
+        const auto other_end = other_table.end();
+        for (; other_it != other_end; ++other_it, ++it) {
+            while (it != m_table.end() &&
+                   Map::key_less(it->first, other_it->first)) {
+                ++it;
+            }
+            if (it == m_table.end() ||
+                Map::key_less(other_it->first, it->first)) {
+                break;
+            }
+            if (!op(it->second, other_it->second)) {
+                return false;
+            }
+            note_value(it->second);
+        }
+        if (other_it == other_end) {
+            return true;
+        }
+
+        // Some variables are missing, rebuild the rest of the table.
+        const auto pos = it - m_table.begin();
+        auto elems = m_table.take_elems();
+        typename Map::Container merged;
+        merged.reserve(elems.size() +
+                       static_cast< std::size_t >(other_end - other_it));
+        auto this_it = elems.begin() + pos;
+        std::move(elems.begin(), this_it, std::back_inserter(merged));
+        bool is_not_bottom = true;
+        while (is_not_bottom && this_it != elems.end() &&
+               other_it != other_end) {
+            if (Map::key_less(this_it->first, other_it->first)) {
+                merged.push_back(std::move(*this_it++));
+            } else if (Map::key_less(other_it->first, this_it->first)) {
+                note_value(other_it->second);
+                merged.push_back(*other_it++);
+            } else {
+                is_not_bottom = op(this_it->second, other_it->second);
+                note_value(this_it->second);
+                merged.push_back(std::move(*this_it++));
+                ++other_it;
+            }
+        }
+        if (is_not_bottom) {
+            std::move(this_it, elems.end(), std::back_inserter(merged));
+            for (; other_it != other_end; ++other_it) {
+                note_value(other_it->second);
+                merged.push_back(*other_it);
+            }
+        }
+        m_table = Map(std::move(merged));
+        return is_not_bottom;
+    }
+
+    /// \brief Combine the other table into this one by an upper bound
+    /// `op`, a value already above the other one being kept.
+    ///
+    /// \returns true if the table changed.
+    template < typename Op >
+    bool upper_bound_with(const SeparateNumericalDom& other, Op op) {
+        if (other.is_bottom()) {
+            return false;
+        }
+        if (this->is_bottom()) {
+            *this = other;
+            return true;
         }
+        const auto size = m_table.size();
+        bool is_changed = false;
+        (void)merge_table_with(other,
+                               [&op, &is_changed](
+                                   SeparateNumericalValue& value,
+                                   const SeparateNumericalValue& other_value) {
+                                   if (!other_value.leq(value)) {
+                                       op(value, other_value);
+                                       is_changed = true;
+                                   }
+                                   return true;
+                               });
+        return is_changed || m_table.size() != size;
     }
 
   public:
-    [[nodiscard]] static DomainKind get_kind() { return DomKind; }
+    [[nodiscard]] static constexpr DomainKind get_kind() { return DomKind; }
 
     [[nodiscard]] static SharedVal default_val() {
         return std::make_shared< SeparateNumericalDom >(false);
@@ -128,22 +365,30 @@ class SeparateNumericalDom
     [[nodiscard]] static SharedVal bottom_val() {
         return std::make_shared< SeparateNumericalDom >(true);
     }
-    [[nodiscard]] Map clone_table() const {
-        Map table;
-        for (auto& [key, value] : m_table) {
-            table[key] =
-                *(static_cast< SeparateNumericalValue* >(value.clone()));
-        }
-        return table;
-    }
+    [[nodiscard]] Map clone_table() const { return m_table; }
     [[nodiscard]] AbsDomBase* clone() const override {
-        return new SeparateNumericalDom(m_is_bottom, clone_table());
+        return new SeparateNumericalDom(*this);
     }
 
     void normalize() override {
+        if (m_is_normalized) {
+            return;
+        }
+        // A value may be found empty when normalized, e.g. reduced.
+        bool has_bottom = false;
         for (auto& [_, value] : m_table) {
             value.normalize();
+            has_bottom = has_bottom || value.is_bottom();
         }
+        if (has_bottom) {
+            this->set_to_bottom();
+            return;
+        }
+        m_is_normalized = true;
+    }
+
+    [[nodiscard]] bool is_normalized() const override {
+        return m_is_normalized;
     }
 
     [[nodiscard]] bool is_bottom() const override { return m_is_bottom; }
@@ -154,91 +399,57 @@ class SeparateNumericalDom
 
     void set_to_bottom() override {
         m_is_bottom = true;
+        m_is_normalized = true;
         Map().swap(m_table);
+        restamp();
     }
 
     void set_to_top() override {
         m_is_bottom = false;
+        m_is_normalized = true;
         Map().swap(m_table);
+        restamp();
     }
 
     void join_with(const SeparateNumericalDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
+        (void)join_with_changed(other);
+    }
 
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.join_with(value);
-            }
-        }
+    [[nodiscard]] bool join_with_changed(const SeparateNumericalDom& other) {
+        return upper_bound_with(other,
+                                [](SeparateNumericalValue& value,
+                                   const SeparateNumericalValue& other_value) {
+                                    value.join_with(other_value);
+                                });
     }
 
     void join_with_at_loop_head(const SeparateNumericalDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
-
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.join_with_at_loop_head(value);
-            }
-        }
+        (void)upper_bound_with(other,
+                               [](SeparateNumericalValue& value,
+                                  const SeparateNumericalValue& other_value) {
+                                   value.join_with_at_loop_head(other_value);
+                               });
     }
 
     void join_consecutive_iter_with(const SeparateNumericalDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
-
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.join_consecutive_iter_with(value);
-            }
-        }
+        (void)upper_bound_with(other,
+                               [](SeparateNumericalValue& value,
+                                  const SeparateNumericalValue& other_value) {
+                                   value.join_consecutive_iter_with(
+                                       other_value);
+                               });
     }
 
     void widen_with(const SeparateNumericalDom& other) {
-        if (other.is_bottom()) {
-            return;
-        }
-
-        if (this->is_bottom()) {
-            *this = other;
-            return;
-        }
+        (void)widen_with_changed(other);
+    }
 
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.widen_with(value);
-            }
-        }
+    [[nodiscard]] bool widen_with_changed(const SeparateNumericalDom& other) {
+        return upper_bound_with(other,
+                                [](SeparateNumericalValue& value,
+                                   const SeparateNumericalValue& other_value) {
+                                    value.widen_with(other_value);
+                                });
     }
 
     void meet_with(const SeparateNumericalDom& other) {
@@ -249,17 +460,13 @@ class SeparateNumericalDom
             *this = other;
             return;
         }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.meet_with(value);
-                if (it->second.is_bottom()) {
-                    this->set_to_bottom();
-                    return;
-                }
-            }
+        if (!merge_table_with(other,
+                              [](SeparateNumericalValue& value,
+                                 const SeparateNumericalValue& other_value) {
+                                  value.meet_with(other_value);
+                                  return !value.is_bottom();
+                              })) {
+            this->set_to_bottom();
         }
     }
 
@@ -272,38 +479,47 @@ class SeparateNumericalDom
             this->set_to_bottom();
         }
 
-        auto it = m_table.find(x);
-        if (it == m_table.end()) {
-            m_table[x] = value;
-        } else {
+        auto [it, inserted] = m_table.try_emplace(x, value);
+        if (!inserted) {
             it->second.meet_with(value);
             if (it->second.is_bottom()) {
                 this->set_to_bottom();
                 return;
             }
         }
+        note_value(it->second);
+        mark_dirty(x);
     }
 
     void narrow_with(const SeparateNumericalDom& other) {
+        (void)narrow_with_changed(other);
+    }
+
+    [[nodiscard]] bool narrow_with_changed(const SeparateNumericalDom& other) {
         if (this->is_bottom()) {
-            return;
+            return false;
         }
         if (other.is_bottom()) {
             *this = other;
-            return;
+            return true;
         }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.narrow_with(value);
-                if (it->second.is_bottom()) {
-                    this->set_to_bottom();
-                    return;
-                }
-            }
+        const auto size = m_table.size();
+        bool is_changed = false;
+        if (!merge_table_with(other,
+                              [&is_changed](
+                                  SeparateNumericalValue& value,
+                                  const SeparateNumericalValue& other_value) {
+                                  if (value.leq(other_value)) {
+                                      return true;
+                                  }
+                                  value.narrow_with(other_value);
+                                  is_changed = true;
+                                  return !value.is_bottom();
+                              })) {
+            this->set_to_bottom();
+            return true;
         }
+        return is_changed || m_table.size() != size;
     }
 
     bool leq(const SeparateNumericalDom& other) const {
@@ -313,18 +529,32 @@ class SeparateNumericalDom
         if (other.is_bottom()) {
             return false;
         }
-        // llvm::DenseSet< Var > this_keys;
-        bool need_to_check_other = this->m_table.size() != other.m_table.size();
-        for (auto& [key, value] : this->m_table) {
-            auto it = other.m_table.find(key);
-            if (it == other.m_table.end()) {
+        if (m_stamp == other.m_stamp) {
+            return all_dirty_values_of(
+                other,
+                [](const SeparateNumericalValue* value,
+                   const SeparateNumericalValue* other_value) {
+                    if (value == nullptr) {
+                        return true;
+                    }
+                    return other_value == nullptr ? value->is_bottom()
+                                                  : value->leq(*other_value);
+                });
+        }
+        auto other_it = other.m_table.begin();
+        const auto other_end = other.m_table.end();
+        for (const auto& [key, value] : this->m_table) {
+            while (other_it != other_end &&
+                   Map::key_less(other_it->first, key)) {
+                ++other_it;
+            }
+            if (other_it == other_end || Map::key_less(key, other_it->first)) {
                 if (value.is_bottom()) {
                     continue;
                 }
                 return false;
             }
-
-            if (!value.leq(it->second)) {
+            if (!value.leq(other_it->second)) {
                 return false;
             }
         }
@@ -338,23 +568,38 @@ class SeparateNumericalDom
         if (other.is_bottom()) {
             return false;
         }
-        llvm::DenseSet< Var > this_keys;
-        for (auto& [key, value] : this->m_table) {
-            this_keys.insert(key);
-            auto it = other.m_table.find(key);
-            if (it == other.m_table.end()) {
-                if (value.is_bottom()) {
-                    continue;
+        if (m_stamp == other.m_stamp) {
+            return all_dirty_values_of(
+                other,
+                [](const SeparateNumericalValue* value,
+                   const SeparateNumericalValue* other_value) {
+                    if (value != nullptr && other_value != nullptr) {
+                        return value->equals(*other_value);
+                    }
+                    const auto* present =
+                        value != nullptr ? value : other_value;
+                    return present == nullptr || present->is_bottom();
+                });
+        }
+        auto it = this->m_table.begin();
+        const auto end = this->m_table.end();
+        auto other_it = other.m_table.begin();
+        const auto other_end = other.m_table.end();
+        while (it != end || other_it != other_end) {
+            if (other_it == other_end ||
+                (it != end && Map::key_less(it->first, other_it->first))) {
+                if (!(it++)->second.is_bottom()) {
+                    return false;
+                }
+            } else if (it == end ||
+                       Map::key_less(other_it->first, it->first)) {
+                if (!(other_it++)->second.is_bottom()) {
+                    return false;
+                }
+            } else {
+                if (!(it++)->second.equals((other_it++)->second)) {
+                    return false;
                 }
-                return false;
-            }
-            if (!value.equals(it->second)) {
-                return false;
-            }
-        }
-        for (auto& [key, value] : other.m_table) {
-            if (!this_keys.contains(key) && !value.is_bottom()) {
-                return false;
             }
         }
         return true;
@@ -381,26 +626,26 @@ class SeparateNumericalDom
     }
 
     void widen_with_threshold(const SeparateNumericalDom& other,
-                              const Num& threshold) {
+                              llvm::ArrayRef< Num > thresholds) {
         if (other.is_bottom()) {
             return;
         }
         if (this->is_bottom()) {
             *this = other;
-        } else {
-            for (auto& [key, sep_num_value] : other.m_table) {
-                auto it = m_table.find(key);
-                if (it == m_table.end()) {
-                    m_table[key] = sep_num_value;
-                } else {
-                    it->second.widen_with_threshold(sep_num_value, threshold);
-                }
-            }
+            return;
         }
+        (void)merge_table_with(other,
+                               [thresholds](SeparateNumericalValue& value,
+                                            const SeparateNumericalValue&
+                                                other_value) {
+                                   value.widen_with_threshold(other_value,
+                                                              thresholds);
+                                   return true;
+                               });
     }
 
     void narrow_with_threshold(const SeparateNumericalDom& other,
-                               const Num& threshold) {
+                               llvm::ArrayRef< Num > thresholds) {
         if (this->is_bottom()) {
             return;
         }
@@ -408,17 +653,15 @@ class SeparateNumericalDom
             *this = other;
             return;
         }
-        for (auto& [key, value] : other.m_table) {
-            auto it = m_table.find(key);
-            if (it == m_table.end()) {
-                m_table[key] = value;
-            } else {
-                it->second.narrow_with_threshold(value, threshold);
-                if (it->second.is_bottom()) {
-                    this->set_to_bottom();
-                    return;
-                }
-            }
+        if (!merge_table_with(other,
+                              [thresholds](SeparateNumericalValue& value,
+                                           const SeparateNumericalValue&
+                                               other_value) {
+                                  value.narrow_with_threshold(other_value,
+                                                              thresholds);
+                                  return !value.is_bottom();
+                              })) {
+            this->set_to_bottom();
         }
     }
 
@@ -0,0 +1,480 @@
+//===- fixed_machine_znum.hpp -----------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the FixedMachineZNum class, the machine integers
+//  whose bit-width and signedness are known at compile time.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/num/machine_znum.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace knight::analyzer {
+
+/// \brief Machine integer of `Bits` <= 64 bits, wrapping around like the
+/// C integers of the same width.
+///
+/// Unlike `MachineZNum`, the bit-width and the signedness are template
+/// parameters, so the value takes 8 bytes, the masks are constants and the
+/// operations do not branch on the width. The value is stored masked to
+/// `Bits`, and sign-extended on the signed reads. `MachineZNum` remains
+/// for the wider integers.
+template < unsigned Bits, Signedness Sign >
+class FixedMachineZNum {
+    static_assert(Bits > 0U && Bits <= internal::K64Bits,
+                  "invalid bit width");
+
+  public:
+    static constexpr uint64_t BitWidth = Bits;
+    static constexpr uint64_t Mask = MaxU64 >> (internal::K64Bits - Bits);
+    static constexpr uint64_t SignBit = static_cast< uint64_t >(1)
+                                        << (Bits - 1U);
+
+  private:
+    struct NormalizedTag {};
+
+  private:
+    /// The integer value masked to `Bits`.
+    uint64_t m_value;
+
+  public:
+    FixedMachineZNum() = delete;
+
+    template < typename T,
+               class = std::enable_if_t< std::is_integral< T >::value > >
+    constexpr explicit FixedMachineZNum(T n)
+        : m_value(static_cast< uint64_t >(n) & Mask) {}
+
+    explicit FixedMachineZNum(const ZNum& n)
+        : m_value(mod(n, MachineZNum::power_2(BitWidth)).to< uint64_t >()) {}
+
+    explicit FixedMachineZNum(const MachineZNum& n)
+        : FixedMachineZNum(n.to_z_number()) {
+        knight_assert_msg(n.get_bit_width() == BitWidth &&
+                              n.get_sign() == Sign,
+                          "parameter has a different type");
+    }
+
+  private:
+    constexpr FixedMachineZNum(uint64_t n, NormalizedTag) : m_value(n) {}
+
+  public:
+    [[nodiscard]] static constexpr FixedMachineZNum min() {
+        return {Sign == Signed ? SignBit : 0U, NormalizedTag{}};
+    }
+
+    [[nodiscard]] static constexpr FixedMachineZNum max() {
+        return {Sign == Signed ? Mask >> 1U : Mask, NormalizedTag{}};
+    }
+
+    [[nodiscard]] static constexpr FixedMachineZNum zero() {
+        return {0U, NormalizedTag{}};
+    }
+
+    [[nodiscard]] static constexpr FixedMachineZNum ones() {
+        return {Mask, NormalizedTag{}};
+    }
+
+    /// \brief Build from bits which are already masked to `Bits`.
+    [[nodiscard]] static constexpr FixedMachineZNum from_bits(uint64_t bits) {
+        return {bits & Mask, NormalizedTag{}};
+    }
+
+    [[nodiscard]] static constexpr uint64_t get_bit_width() {
+        return BitWidth;
+    }
+    [[nodiscard]] static constexpr Signedness get_sign() { return Sign; }
+    [[nodiscard]] static constexpr bool is_signed() { return Sign == Signed; }
+    [[nodiscard]] static constexpr bool is_unsigned() {
+        return Sign == Unsigned;
+    }
+
+    /// \brief The value masked to `Bits`, i.e. its unsigned reading.
+    [[nodiscard]] constexpr uint64_t get_bits() const { return m_value; }
+
+    [[nodiscard]] constexpr bool is_zero() const { return m_value == 0U; }
+    [[nodiscard]] constexpr bool is_minimum() const { return *this == min(); }
+    [[nodiscard]] constexpr bool is_maximum() const { return *this == max(); }
+    [[nodiscard]] constexpr bool all_ones() const { return m_value == Mask; }
+
+    [[nodiscard]] constexpr bool high_bit() const {
+        return (m_value & SignBit) != 0U;
+    }
+
+    [[nodiscard]] constexpr bool is_negative() const {
+        return is_signed() && high_bit();
+    }
+
+    [[nodiscard]] constexpr bool is_non_negative() const {
+        return !is_negative();
+    }
+
+    [[nodiscard]] constexpr bool is_positive() const {
+        return !is_zero() && !is_negative();
+    }
+
+    /// \brief The value sign-extended to 64 bits if signed, as is otherwise.
+    [[nodiscard]] constexpr int64_t get_signed_value() const {
+        // NOLINTNEXTLINE(hicpp-signed-bitwise)
+        return static_cast< int64_t >(m_value << (internal::K64Bits - Bits)) >>
+               (internal::K64Bits - Bits);
+    }
+
+    /// \brief The order key of the value: flipping the sign bit of the
+    /// signed values maps their order onto the unsigned one.
+    [[nodiscard]] constexpr uint64_t get_order_key() const {
+        return m_value ^ (is_signed() ? SignBit : 0U);
+    }
+
+    [[nodiscard]] ZNum to_z_number() const {
+        if constexpr (Sign == Signed) {
+            return ZNum(get_signed_value());
+        } else {
+            return ZNum(m_value);
+        }
+    }
+
+    [[nodiscard]] MachineZNum to_machine_znum() const {
+        return {to_z_number(), BitWidth, Sign};
+    }
+
+    template < typename T,
+               class = std::enable_if_t< std::is_integral< T >::value > >
+    [[nodiscard]] constexpr bool fits() const {
+        if constexpr (Sign == Signed) {
+            int64_t n = get_signed_value();
+            if constexpr (std::numeric_limits< T >::is_signed) {
+                return int64_t(std::numeric_limits< T >::min()) <= n &&
+                       n <= int64_t(std::numeric_limits< T >::max());
+            } else {
+                return n >= 0 && static_cast< uint64_t >(n) <=
+                                     uint64_t(std::numeric_limits< T >::max());
+            }
+        } else {
+            return m_value <= uint64_t(std::numeric_limits< T >::max());
+        }
+    }
+
+    template < typename T,
+               class = std::enable_if_t< std::is_integral< T >::value > >
+    [[nodiscard]] constexpr T to() const {
+        knight_assert_msg(this->fits< T >(), "does not fit");
+        if constexpr (Sign == Signed) {
+            return static_cast< T >(get_signed_value());
+        } else {
+            return static_cast< T >(m_value);
+        }
+    }
+
+    [[nodiscard]] std::string str() const {
+        if constexpr (Sign == Signed) {
+            return std::to_string(get_signed_value());
+        } else {
+            return std::to_string(m_value);
+        }
+    }
+
+  public:
+    constexpr FixedMachineZNum operator+() const { return *this; }
+
+    constexpr FixedMachineZNum operator-() const {
+        return {(0U - m_value) & Mask, NormalizedTag{}};
+    }
+
+    constexpr FixedMachineZNum operator~() const {
+        return {~m_value & Mask, NormalizedTag{}};
+    }
+
+    constexpr FixedMachineZNum& operator+=(FixedMachineZNum x) {
+        m_value = (m_value + x.m_value) & Mask;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator-=(FixedMachineZNum x) {
+        m_value = (m_value - x.m_value) & Mask;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator*=(FixedMachineZNum x) {
+        m_value = (m_value * x.m_value) & Mask;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator&=(FixedMachineZNum x) {
+        m_value &= x.m_value;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator|=(FixedMachineZNum x) {
+        m_value |= x.m_value;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator^=(FixedMachineZNum x) {
+        m_value ^= x.m_value;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator++() {
+        m_value = (m_value + 1U) & Mask;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum& operator--() {
+        m_value = (m_value - 1U) & Mask;
+        return *this;
+    }
+
+    constexpr FixedMachineZNum operator++(int) { // NOLINT
+        FixedMachineZNum r(*this);
+        ++*this;
+        return r;
+    }
+
+    constexpr FixedMachineZNum operator--(int) { // NOLINT
+        FixedMachineZNum r(*this);
+        --*this;
+        return r;
+    }
+
+    /// \brief Add with wrapping, reporting whether the result wrapped.
+    [[nodiscard]] static constexpr FixedMachineZNum add(FixedMachineZNum lhs,
+                                                        FixedMachineZNum rhs,
+                                                        bool& overflow) {
+        uint64_t sum = lhs.m_value + rhs.m_value;
+        uint64_t result = sum & Mask;
+        if constexpr (Sign == Signed) {
+            // The operands have the same sign, which the result has not.
+            overflow = ((lhs.m_value ^ result) & (rhs.m_value ^ result) &
+                        SignBit) != 0U;
+        } else {
+            overflow = result < lhs.m_value;
+        }
+        return {result, NormalizedTag{}};
+    }
+
+    /// \brief Sub with wrapping, reporting whether the result wrapped.
+    [[nodiscard]] static constexpr FixedMachineZNum sub(FixedMachineZNum lhs,
+                                                        FixedMachineZNum rhs,
+                                                        bool& overflow) {
+        uint64_t result = (lhs.m_value - rhs.m_value) & Mask;
+        if constexpr (Sign == Signed) {
+            // The operands have different signs, and the result has not the
+            // sign of the left one.
+            overflow = ((lhs.m_value ^ rhs.m_value) &
+                        (lhs.m_value ^ result) & SignBit) != 0U;
+        } else {
+            overflow = rhs.m_value > lhs.m_value;
+        }
+        return {result, NormalizedTag{}};
+    }
+
+    /// \brief Mul with wrapping, reporting whether the result wrapped.
+    [[nodiscard]] static FixedMachineZNum mul(FixedMachineZNum lhs,
+                                              FixedMachineZNum rhs,
+                                              bool& overflow) {
+        FixedMachineZNum result = lhs;
+        result *= rhs;
+        if constexpr (Sign == Signed) {
+            int64_t product = 0;
+            overflow = __builtin_mul_overflow(lhs.get_signed_value(),
+                                              rhs.get_signed_value(),
+                                              &product) ||
+                       product != result.get_signed_value();
+        } else {
+            uint64_t product = 0;
+            overflow =
+                __builtin_mul_overflow(lhs.m_value, rhs.m_value, &product) ||
+                product != result.m_value;
+        }
+        return result;
+    }
+
+    /// \brief Div rounding towards zero, the minimum divided by -1 wraps.
+    [[nodiscard]] static constexpr FixedMachineZNum div(FixedMachineZNum lhs,
+                                                        FixedMachineZNum rhs) {
+        knight_assert_msg(!rhs.is_zero(), "division by zero");
+        if constexpr (Sign == Signed) {
+            if (rhs.all_ones()) {
+                return -lhs;
+            }
+            return FixedMachineZNum(lhs.get_signed_value() /
+                                    rhs.get_signed_value());
+        } else {
+            return {lhs.m_value / rhs.m_value, NormalizedTag{}};
+        }
+    }
+
+    /// \brief Remainder of `div`, with the sign of the left operand.
+    [[nodiscard]] static constexpr FixedMachineZNum rem(FixedMachineZNum lhs,
+                                                        FixedMachineZNum rhs) {
+        knight_assert_msg(!rhs.is_zero(), "division by zero");
+        if constexpr (Sign == Signed) {
+            if (rhs.all_ones()) {
+                return zero();
+            }
+            return FixedMachineZNum(lhs.get_signed_value() %
+                                    rhs.get_signed_value());
+        } else {
+            return {lhs.m_value % rhs.m_value, NormalizedTag{}};
+        }
+    }
+
+    [[nodiscard]] static constexpr FixedMachineZNum shl(FixedMachineZNum lhs,
+                                                        uint64_t shift) {
+        knight_assert_msg(shift < BitWidth, "shift count is too big");
+        return {(lhs.m_value << shift) & Mask, NormalizedTag{}};
+    }
+
+    [[nodiscard]] static constexpr FixedMachineZNum lshr(FixedMachineZNum lhs,
+                                                         uint64_t shift) {
+        knight_assert_msg(shift < BitWidth, "shift count is too big");
+        return {lhs.m_value >> shift, NormalizedTag{}};
+    }
+
+    [[nodiscard]] static constexpr FixedMachineZNum ashr(FixedMachineZNum lhs,
+                                                         uint64_t shift) {
+        knight_assert_msg(shift < BitWidth, "shift count is too big");
+        // NOLINTNEXTLINE(hicpp-signed-bitwise)
+        return FixedMachineZNum(lhs.get_signed_value() >>
+                                static_cast< int64_t >(shift));
+    }
+
+    friend constexpr FixedMachineZNum operator+(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr FixedMachineZNum operator-(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr FixedMachineZNum operator*(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return lhs *= rhs;
+    }
+
+    friend constexpr FixedMachineZNum operator/(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return div(lhs, rhs);
+    }
+
+    friend constexpr FixedMachineZNum operator%(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return rem(lhs, rhs);
+    }
+
+    friend constexpr FixedMachineZNum operator&(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return lhs &= rhs;
+    }
+
+    friend constexpr FixedMachineZNum operator|(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return lhs |= rhs;
+    }
+
+    friend constexpr FixedMachineZNum operator^(FixedMachineZNum lhs,
+                                                FixedMachineZNum rhs) {
+        return lhs ^= rhs;
+    }
+
+    friend constexpr bool operator==(FixedMachineZNum lhs,
+                                     FixedMachineZNum rhs) {
+        return lhs.m_value == rhs.m_value;
+    }
+
+    friend constexpr bool operator!=(FixedMachineZNum lhs,
+                                     FixedMachineZNum rhs) {
+        return lhs.m_value != rhs.m_value;
+    }
+
+    friend constexpr bool operator<(FixedMachineZNum lhs,
+                                    FixedMachineZNum rhs) {
+        return lhs.get_order_key() < rhs.get_order_key();
+    }
+
+    friend constexpr bool operator<=(FixedMachineZNum lhs,
+                                     FixedMachineZNum rhs) {
+        return lhs.get_order_key() <= rhs.get_order_key();
+    }
+
+    friend constexpr bool operator>(FixedMachineZNum lhs,
+                                    FixedMachineZNum rhs) {
+        return lhs.get_order_key() > rhs.get_order_key();
+    }
+
+    friend constexpr bool operator>=(FixedMachineZNum lhs,
+                                     FixedMachineZNum rhs) {
+        return lhs.get_order_key() >= rhs.get_order_key();
+    }
+
+    friend llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                                         FixedMachineZNum n) {
+        if constexpr (Sign == Signed) {
+            os << n.get_signed_value();
+        } else {
+            os << n.m_value;
+        }
+        return os;
+    }
+
+    friend std::size_t hash_value(FixedMachineZNum n) {
+        return std::hash< uint64_t >()(n.m_value);
+    }
+
+}; // class FixedMachineZNum
+
+template < unsigned Bits, Signedness Sign >
+constexpr FixedMachineZNum< Bits, Sign > min(FixedMachineZNum< Bits, Sign > a,
+                                             FixedMachineZNum< Bits, Sign > b) {
+    return (a < b) ? a : b;
+}
+
+template < unsigned Bits, Signedness Sign >
+constexpr FixedMachineZNum< Bits, Sign > max(FixedMachineZNum< Bits, Sign > a,
+                                             FixedMachineZNum< Bits, Sign > b) {
+    return (a < b) ? b : a;
+}
+
+template < unsigned Bits, Signedness Sign >
+constexpr FixedMachineZNum< Bits, Sign > abs(FixedMachineZNum< Bits, Sign > n) {
+    return n.is_negative() ? -n : n;
+}
+
+using MachineInt8 = FixedMachineZNum< 8U, Signed >;
+using MachineInt16 = FixedMachineZNum< 16U, Signed >;
+using MachineInt32 = FixedMachineZNum< 32U, Signed >;
+using MachineInt64 = FixedMachineZNum< 64U, Signed >;
+using MachineUInt8 = FixedMachineZNum< 8U, Unsigned >;
+using MachineUInt16 = FixedMachineZNum< 16U, Unsigned >;
+using MachineUInt32 = FixedMachineZNum< 32U, Unsigned >;
+using MachineUInt64 = FixedMachineZNum< 64U, Unsigned >;
+
+static_assert(sizeof(MachineInt64) == sizeof(uint64_t));
+
+} // namespace knight::analyzer
+
+namespace std {
+
+template < unsigned Bits, knight::analyzer::Signedness Sign >
+struct hash< knight::analyzer::FixedMachineZNum< Bits, Sign > > {
+    std::size_t operator()(
+        knight::analyzer::FixedMachineZNum< Bits, Sign > n) const {
+        return hash_value(n);
+    }
+};
+
+} // namespace std
@@ -0,0 +1,29 @@
+//===- gmp_pool.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the pooled memory functions for GMP.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+namespace knight::analyzer {
+
+/// \brief Install the pooled memory functions for GMP.
+///
+/// The small limb arrays are recycled through thread-local free lists of
+/// a few size classes, so that the temporaries of the ZNum and QNum
+/// operations do not go through malloc. Larger arrays use malloc.
+///
+/// \note It shall be called before any GMP number is allocated, since
+/// the blocks allocated by the default functions are not pooled. Calling
+/// it more than once has no effect.
+void install_gmp_pool();
+
+} // namespace knight::analyzer
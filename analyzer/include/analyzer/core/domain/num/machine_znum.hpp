@@ -141,6 +141,7 @@ class MachineZNum {
         if (this->is_small_num()) {
             uint64_t mask = MaxU64 >> (internal::K64Bits - this->m_bit_width);
             this->m_ap.i &= mask;
+            return;
         }
         if (*this->m_ap.p == 0) {
             return;
@@ -45,7 +45,7 @@ struct ZNumTransformer : public MpzTransformer< T > {};
 
 template <>
 struct ZNumTransformer< const ZNum& > {
-    const mpz_class& operator()(const ZNum& n) { return n.get_mpz(); }
+    mpz_class operator()(const ZNum& n) { return n.get_mpz(); }
 };
 
 } // namespace internal
@@ -70,8 +70,8 @@ class QNum : public llvm::FoldingSetNode {
     [[nodiscard]] const mpq_class& get_mpq() const { return this->m_mpq; }
 
     QNum() = default;
-    explicit QNum(const ZNum& n) : m_mpq(n.m_mpz) {}
-    explicit QNum(ZNum&& n) : m_mpq(std::move(n).m_mpz) {}
+    explicit QNum(const ZNum& n) : m_mpq(n.get_mpz()) {}
+    explicit QNum(ZNum&& n) : m_mpq(n.get_mpz()) {}
 
     template < typename N,
                class = std::enable_if_t< std::is_integral< N >::value > >
@@ -100,14 +100,15 @@ class QNum : public llvm::FoldingSetNode {
     }
 
     /// \brief Create a QNum from a numerator and a denominator
-    explicit QNum(const ZNum& n, const ZNum& d) : m_mpq(n.m_mpz, d.m_mpz) {
+    explicit QNum(const ZNum& n, const ZNum& d)
+        : m_mpq(n.get_mpz(), d.get_mpz()) {
         knight_assert_msg(this->m_mpq.get_den() != 0, "denominator is zero");
         this->m_mpq.canonicalize();
     }
 
     /// \brief Create a QNum from a numerator and a denominator
     explicit QNum(ZNum&& n, ZNum&& d)
-        : m_mpq(std::move(n).m_mpz, std::move(d).m_mpz) {
+        : m_mpq(n.get_mpz(), d.get_mpz()) {
         knight_assert_msg(this->m_mpq.get_den() != 0, "denominator is zero");
         this->m_mpq.canonicalize();
     }
@@ -124,12 +125,12 @@ class QNum : public llvm::FoldingSetNode {
     ~QNum() = default;
 
     QNum& operator=(const ZNum& n) {
-        this->m_mpq = n.m_mpz;
+        this->m_mpq = n.get_mpz();
         return *this;
     }
 
     QNum& operator=(ZNum&& n) noexcept {
-        this->m_mpq = std::move(n.m_mpz);
+        this->m_mpq = n.get_mpz();
         return *this;
     }
 
@@ -273,6 +274,12 @@ class QNum : public llvm::FoldingSetNode {
     return QNum(lhs.get_mpq() + rhs.get_mpq(), QNum::NormalizedTag{});
 }
 
+/// \brief Reuse the storage of the temporary left operand.
+[[nodiscard]] inline QNum operator+(QNum&& lhs, const QNum& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
 template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
 [[nodiscard]] inline QNum operator+(const QNum& lhs, T rhs) {
     return QNum(lhs.get_mpq() + internal::ZNumTransformer< T >()(rhs),
@@ -289,6 +296,12 @@ template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
     return QNum(lhs.get_mpq() - rhs.get_mpq(), QNum::NormalizedTag{});
 }
 
+/// \brief Reuse the storage of the temporary left operand.
+[[nodiscard]] inline QNum operator-(QNum&& lhs, const QNum& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
+}
+
 template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
 [[nodiscard]] inline QNum operator-(const QNum& lhs, T rhs) {
     return QNum(lhs.get_mpq() - internal::ZNumTransformer< T >()(rhs),
@@ -305,6 +318,12 @@ template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
     return QNum(lhs.get_mpq() * rhs.get_mpq(), QNum::NormalizedTag{});
 }
 
+/// \brief Reuse the storage of the temporary left operand.
+[[nodiscard]] inline QNum operator*(QNum&& lhs, const QNum& rhs) {
+    lhs *= rhs;
+    return std::move(lhs);
+}
+
 template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
 [[nodiscard]] inline QNum operator*(const QNum& lhs, T rhs) {
     return QNum(lhs.get_mpq() * internal::ZNumTransformer< T >()(rhs),
@@ -322,6 +341,12 @@ template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
     return QNum(lhs.get_mpq() / rhs.get_mpq(), QNum::NormalizedTag{});
 }
 
+/// \brief Reuse the storage of the temporary left operand.
+[[nodiscard]] inline QNum operator/(QNum&& lhs, const QNum& rhs) {
+    lhs /= rhs;
+    return std::move(lhs);
+}
+
 template < typename T, class = std::enable_if_t< ZNumOrIntegral< T >::value > >
 [[nodiscard]] inline QNum operator/(const QNum& lhs, T rhs) {
     knight_assert_msg(rhs != 0, "divided by zero");
@@ -7,8 +7,8 @@
 //
 //===------------------------------------------------------------------===//
 //
-//  This file defines the ZNum class, which is a wrapper around GMP's
-//  mpz_class
+//  This file defines the ZNum class, which is an int64_t promoted to
+//  GMP's mpz_class on overflow
 //
 //===------------------------------------------------------------------===//
 
@@ -19,7 +19,15 @@
 #include <llvm/ADT/FoldingSet.h>
 #include <llvm/Support/WithColor.h>
 
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -248,9 +256,22 @@ struct MpzTo< LL > : public MpzToLL< sizeof(LL) == sizeof(L) > {};
 } // namespace internal
 
 /// \brief Unlimited precision integer
+///
+/// The value is stored inline as an int64_t as long as it fits, and is
+/// only promoted to a GMP integer when an operation overflows. Since the
+/// representation is normalized, i.e., a GMP integer never holds a value
+/// which fits in 64 bits, the small cases never touch GMP at all.
 class ZNum : public llvm::FoldingSetNode {
   private:
-    mpz_class m_mpz;
+    using Small = int64_t;
+
+    static constexpr Small SmallMin = std::numeric_limits< Small >::min();
+    static constexpr Small SmallMax = std::numeric_limits< Small >::max();
+
+    /// \brief The value if it fits in 64 bits.
+    Small m_small = 0;
+    /// \brief The value if it does not fit in 64 bits, nullptr otherwise.
+    std::unique_ptr< mpz_class > m_big;
 
   public:
     /// \brief Create a ZNum from a string representation
@@ -269,24 +290,57 @@ class ZNum : public llvm::FoldingSetNode {
         }
     }
 
-    [[nodiscard]] const mpz_class& get_mpz() const { return this->m_mpz; }
+    /// \brief Get the GMP representation of the number.
+    [[nodiscard]] mpz_class get_mpz() const {
+        if (this->is_small()) {
+            return to_mpz(this->m_small);
+        }
+        return *this->m_big;
+    }
+
+    /// \brief Check whether the number is stored inline.
+    [[nodiscard]] bool is_small() const { return this->m_big == nullptr; }
 
     ZNum() = default;
-    explicit ZNum(const mpz_class& n) : m_mpz(n) {}
-    explicit ZNum(mpz_class&& n) : m_mpz(std::move(n)) {}
+    explicit ZNum(const mpz_class& n) { this->set_mpz(n); }
+    explicit ZNum(mpz_class&& n) { this->set_mpz(std::move(n)); }
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
-    explicit ZNum(T n) : m_mpz(internal::MpzTransformer< T >()(n)) {}
+    explicit ZNum(T n) {
+        *this = n;
+    }
 
-    ZNum(const ZNum&) = default;
-    ZNum(ZNum&&) = default;
-    ZNum& operator=(const ZNum&) = default;
+    ZNum(const ZNum& other)
+        : m_small(other.m_small),
+          m_big(other.is_small()
+                    ? nullptr
+                    : std::make_unique< mpz_class >(*other.m_big)) {}
+    ZNum(ZNum&&) noexcept = default;
+    ZNum& operator=(const ZNum& other) {
+        if (this == &other) {
+            return *this;
+        }
+        this->m_small = other.m_small;
+        if (other.is_small()) {
+            this->m_big.reset();
+        } else if (this->is_small()) {
+            this->m_big = std::make_unique< mpz_class >(*other.m_big);
+        } else {
+            *this->m_big = *other.m_big;
+        }
+        return *this;
+    }
     ZNum& operator=(ZNum&&) noexcept = default;
     ~ZNum() = default;
 
     // NOLINTNEXTLINE
     void Profile(llvm::FoldingSetNodeID& ID) const {
-        const mpz_class& m = this->m_mpz;
+        if (this->is_small()) {
+            ID.AddInteger(this->m_small);
+            return;
+        }
+
+        const mpz_class& m = *this->m_big;
 
         // Add the size of the mpz_t
         ID.AddInteger(m.get_mpz_t()[0]._mp_size);
@@ -300,141 +354,181 @@ class ZNum : public llvm::FoldingSetNode {
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator=(T n) {
-        this->m_mpz = internal::MpzTransformer< T >()(n);
+        if (std::in_range< Small >(n)) {
+            this->m_small = static_cast< Small >(n);
+            this->m_big.reset();
+        } else {
+            this->set_mpz(mpz_class(internal::MpzTransformer< T >()(n)));
+        }
         return *this;
     }
 
     ZNum& operator+=(const ZNum& x) {
-        this->m_mpz += x.m_mpz;
-        return *this;
+        Small r = 0;
+        if (this->is_small() && x.is_small() &&
+            !__builtin_add_overflow(this->m_small, x.m_small, &r)) {
+            this->m_small = r;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a += b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator+=(T x) {
-        this->m_mpz += internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this += ZNum(x);
     }
 
     ZNum& operator-=(const ZNum& x) {
-        this->m_mpz -= x.m_mpz;
-        return *this;
+        Small r = 0;
+        if (this->is_small() && x.is_small() &&
+            !__builtin_sub_overflow(this->m_small, x.m_small, &r)) {
+            this->m_small = r;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a -= b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator-=(T x) {
-        this->m_mpz -= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this -= ZNum(x);
     }
 
     ZNum& operator*=(const ZNum& x) {
-        this->m_mpz *= x.m_mpz;
-        return *this;
+        Small r = 0;
+        if (this->is_small() && x.is_small() &&
+            !__builtin_mul_overflow(this->m_small, x.m_small, &r)) {
+            this->m_small = r;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a *= b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator*=(T x) {
-        this->m_mpz *= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this *= ZNum(x);
     }
 
     ZNum& operator/=(const ZNum& x) {
-        knight_assert_msg(x.m_mpz != 0, "divided by zero");
-        this->m_mpz /= x.m_mpz;
-        return *this;
+        knight_assert_msg(x.sign() != 0, "divided by zero");
+        if (this->is_small() && x.is_small() &&
+            (this->m_small != SmallMin || x.m_small != -1)) {
+            this->m_small /= x.m_small;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a /= b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator/=(T x) {
         knight_assert_msg(x != 0, "divided by zero");
-        this->m_mpz /= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this /= ZNum(x);
     }
 
     /// 0 <= abs(r) < abs(x)
     ZNum& operator%=(const ZNum& x) {
-        knight_assert_msg(x.m_mpz != 0, "divided by zero");
-        this->m_mpz %= x.m_mpz;
-        return *this;
+        knight_assert_msg(x.sign() != 0, "divided by zero");
+        if (this->is_small() && x.is_small()) {
+            this->m_small = x.m_small == -1 ? 0 : this->m_small % x.m_small;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a %= b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator%=(T x) {
         knight_assert_msg(x != 0, "divided by zero");
-        this->m_mpz %= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this %= ZNum(x);
     }
 
     ZNum& operator&=(const ZNum& x) {
-        this->m_mpz &= x.m_mpz;
-        return *this;
+        if (this->is_small() && x.is_small()) {
+            this->m_small &= x.m_small;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a &= b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator&=(T x) {
-        this->m_mpz &= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this &= ZNum(x);
     }
 
     /// \brief Bitwise OR assignment
     ZNum& operator|=(const ZNum& x) {
-        this->m_mpz |= x.m_mpz;
-        return *this;
+        if (this->is_small() && x.is_small()) {
+            this->m_small |= x.m_small;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a |= b;
+        });
     }
 
     /// \brief Bitwise OR assignment with integral types
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator|=(T x) {
-        this->m_mpz |= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this |= ZNum(x);
     }
 
     ZNum& operator^=(const ZNum& x) {
-        this->m_mpz ^= x.m_mpz;
-        return *this;
+        if (this->is_small() && x.is_small()) {
+            this->m_small ^= x.m_small;
+            return *this;
+        }
+        return this->apply_mpz(x, [](mpz_class& a, const mpz_class& b) {
+            a ^= b;
+        });
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator^=(T x) {
-        this->m_mpz ^= internal::MpzTransformer< T >()(x);
-        return *this;
+        return *this ^= ZNum(x);
     }
 
     ZNum& operator<<=(const ZNum& x) {
-        knight_assert_msg(x.m_mpz >= 0, "shift count is negative");
-        knight_assert_msg(x.m_mpz.fits_ulong_p(), "shift count is too big");
-        this->m_mpz <<= x.m_mpz.get_ui();
-        return *this;
+        knight_assert_msg(x.sign() >= 0, "shift count is negative");
+        knight_assert_msg(x.fits< internal::ULI >(), "shift count is too big");
+        return this->shift_left(x.to< internal::ULI >());
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator<<=(T x) {
         knight_assert_msg(x >= 0, "shift count is negative");
-        this->m_mpz <<= static_cast< internal::ULI >(x);
-        return *this;
+        return this->shift_left(static_cast< internal::ULI >(x));
     }
 
     ZNum& operator>>=(const ZNum& x) {
-        knight_assert_msg(x.m_mpz >= 0, "shift count is negative");
-        knight_assert_msg(x.m_mpz.fits_ulong_p(), "shift count is too big");
-        this->m_mpz >>= x.m_mpz.get_ui();
-        return *this;
+        knight_assert_msg(x.sign() >= 0, "shift count is negative");
+        knight_assert_msg(x.fits< internal::ULI >(), "shift count is too big");
+        return this->shift_right(x.to< internal::ULI >());
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     ZNum& operator>>=(T x) {
         knight_assert_msg(x >= 0, "shift count is negative");
-        this->m_mpz >>= static_cast< internal::ULI >(x);
-        return *this;
+        return this->shift_right(static_cast< internal::ULI >(x));
     }
 
     /// \brief Unary plus
@@ -442,81 +536,152 @@ class ZNum : public llvm::FoldingSetNode {
 
     /// \brief Prefix increment
     ZNum& operator++() {
-        ++this->m_mpz;
-        return *this;
+        if (this->is_small() && this->m_small != SmallMax) {
+            ++this->m_small;
+            return *this;
+        }
+        return *this += ZNum(1);
     }
 
     /// \brief Postfix increment
     const ZNum operator++(int) { // NOLINT
         ZNum r(*this);
-        ++this->m_mpz;
+        ++(*this);
         return r;
     }
 
     /// \brief Unary minus
     const ZNum operator-() const { // NOLINT
-        return ZNum(-this->m_mpz);
+        if (this->is_small() && this->m_small != SmallMin) {
+            return ZNum(-this->m_small);
+        }
+        return ZNum(-this->get_mpz());
     }
 
     /// \brief Prefix decrement
     ZNum& operator--() {
-        --this->m_mpz;
-        return *this;
+        if (this->is_small() && this->m_small != SmallMin) {
+            --this->m_small;
+            return *this;
+        }
+        return *this -= ZNum(1);
     }
 
     /// \brief Postfix decrement
     const ZNum operator--(int) { // NOLINT
         ZNum r(*this);
-        --this->m_mpz;
+        --(*this);
         return r;
     }
 
+    /// \brief Returns -1, 0 or 1 as the number is negative, zero or positive.
+    [[nodiscard]] int sign() const {
+        if (this->is_small()) {
+            return (this->m_small > 0) - (this->m_small < 0);
+        }
+        return mpz_sgn(this->m_big->get_mpz_t());
+    }
+
+    /// \brief Three-way comparison, returns the sign of `*this - x`.
+    [[nodiscard]] int compare(const ZNum& x) const {
+        if (this->is_small() && x.is_small()) {
+            return (this->m_small > x.m_small) - (this->m_small < x.m_small);
+        }
+        // A big number is out of the range of the small ones.
+        if (this->is_small()) {
+            return -mpz_sgn(x.m_big->get_mpz_t());
+        }
+        if (x.is_small()) {
+            return mpz_sgn(this->m_big->get_mpz_t());
+        }
+        return mpz_cmp(this->m_big->get_mpz_t(), x.m_big->get_mpz_t());
+    }
+
+    [[nodiscard]] bool equals(const ZNum& x) const {
+        if (this->is_small() || x.is_small()) {
+            return this->is_small() == x.is_small() &&
+                   this->m_small == x.m_small;
+        }
+        return *this->m_big == *x.m_big;
+    }
+
     /// \brief Return the next power of 2 greater or equal to this number
     [[nodiscard]] ZNum next_power_of_2() const {
-        knight_assert(this->m_mpz >= 0);
+        knight_assert(this->sign() >= 0);
 
-        if (this->m_mpz <= 1) {
+        if (this->compare(ZNum(1)) <= 0) {
             return ZNum(1);
         }
 
-        ZNum n(this->m_mpz - 1);
-        return ZNum(mpz_class(1) << n.size_in_bits());
+        ZNum n(*this);
+        --n;
+        ZNum r(1);
+        r <<= n.size_in_bits();
+        return r;
     }
 
     [[nodiscard]] uint64_t trailing_zeros() const {
-        knight_assert(this->m_mpz != 0);
-        return mpz_scan1(this->m_mpz.get_mpz_t(), 0);
+        knight_assert(this->sign() != 0);
+        if (this->is_small()) {
+            return std::countr_zero(static_cast< uint64_t >(this->m_small));
+        }
+        return mpz_scan1(this->m_big->get_mpz_t(), 0);
     }
 
     [[nodiscard]] uint64_t trailing_ones() const {
-        knight_assert(this->m_mpz != -1);
-        return mpz_scan0(this->m_mpz.get_mpz_t(), 0);
+        knight_assert(!this->equals(ZNum(-1)));
+        if (this->is_small()) {
+            return std::countr_one(static_cast< uint64_t >(this->m_small));
+        }
+        return mpz_scan0(this->m_big->get_mpz_t(), 0);
     }
 
     [[nodiscard]] uint64_t size_in_bits() const {
-        return mpz_sizeinbase(this->m_mpz.get_mpz_t(), 2);
+        if (this->is_small()) {
+            if (this->m_small == 0) {
+                return 1U;
+            }
+            return std::bit_width(abs_small(this->m_small));
+        }
+        return mpz_sizeinbase(this->m_big->get_mpz_t(), 2);
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     [[nodiscard]] bool fits() const {
-        return internal::MpzFits< T >()(this->m_mpz);
+        if (this->is_small()) {
+            return std::in_range< T >(this->m_small);
+        }
+        return internal::MpzFits< T >()(*this->m_big);
     }
 
     template < typename T,
                class = std::enable_if_t< std::is_integral< T >::value > >
     T to() const {
-        knight_assert_msg(internal::MpzFits< T >()(this->m_mpz),
-                          "does not fit");
-        return internal::MpzTo< T >()(this->m_mpz);
+        knight_assert_msg(this->fits< T >(), "does not fit");
+        if (this->is_small()) {
+            return static_cast< T >(this->m_small);
+        }
+        return internal::MpzTo< T >()(*this->m_big);
     }
 
     [[nodiscard]] std::string str(int base = internal::K10Base) const {
-        return this->m_mpz.get_str(base);
+        if (this->is_small()) {
+            // 64 digits in base 2, plus the sign.
+            std::array< char, internal::K65Bits > buf{};
+            auto res = std::to_chars(buf.data(),
+                                     buf.data() + buf.size(),
+                                     this->m_small,
+                                     base);
+            return {buf.data(), res.ptr};
+        }
+        return this->m_big->get_str(base);
     }
 
     friend ZNum mod(const ZNum&, const ZNum&); // NOLINT
 
+    friend ZNum abs(const ZNum&); // NOLINT
+
     friend ZNum gcd(const ZNum&, const ZNum&); // NOLINT
 
     friend ZNum lcm(const ZNum&, const ZNum&); // NOLINT
@@ -524,6 +689,8 @@ class ZNum : public llvm::FoldingSetNode {
     friend void gcd_extended(
         const ZNum&, const ZNum&, ZNum&, ZNum&, ZNum&); // NOLINT
 
+    friend std::size_t hash_value(const ZNum&); // NOLINT
+
     friend ZNum single_mask(const ZNum& size);
 
     friend ZNum double_mask(const ZNum& low, const ZNum& high);
@@ -533,153 +700,290 @@ class ZNum : public llvm::FoldingSetNode {
                                   const ZNum& lower_clip,
                                   const ZNum& size_clip);
 
+  private:
+    [[nodiscard]] static mpz_class to_mpz(Small n) {
+        return mpz_class(internal::MpzTransformer< Small >()(n));
+    }
+
+    [[nodiscard]] static uint64_t abs_small(Small n) {
+        return n < 0 ? -static_cast< uint64_t >(n) : static_cast< uint64_t >(n);
+    }
+
+    template < typename Mpz >
+    void set_mpz(Mpz&& n) {
+        if (internal::MpzFits< Small >()(n)) {
+            this->m_small = internal::MpzTo< Small >()(n);
+            this->m_big.reset();
+        } else if (this->is_small()) {
+            this->m_big = std::make_unique< mpz_class >(std::forward< Mpz >(n));
+        } else {
+            *this->m_big = std::forward< Mpz >(n);
+        }
+    }
+
+    /// \brief Demote the GMP integer to the inline one if it fits.
+    void normalize() {
+        if (!this->is_small() && internal::MpzFits< Small >()(*this->m_big)) {
+            this->m_small = internal::MpzTo< Small >()(*this->m_big);
+            this->m_big.reset();
+        }
+    }
+
+    /// \brief Slow path: apply `op` on the GMP integers.
+    template < typename Op >
+    ZNum& apply_mpz(const ZNum& x, Op op) {
+        if (this->is_small()) {
+            this->m_big = std::make_unique< mpz_class >(to_mpz(this->m_small));
+        }
+        if (x.is_small()) {
+            op(*this->m_big, to_mpz(x.m_small));
+        } else {
+            op(*this->m_big, *x.m_big);
+        }
+        this->normalize();
+        return *this;
+    }
+
+    ZNum& shift_left(internal::ULI n) {
+        if (this->is_small()) {
+            if (this->m_small == 0) {
+                return *this;
+            }
+            if (n < static_cast< internal::ULI >(internal::K64Bits)) {
+                const auto r = static_cast< Small >(
+                    static_cast< uint64_t >(this->m_small) << n);
+                if ((r >> n) == this->m_small) {
+                    this->m_small = r;
+                    return *this;
+                }
+            }
+            this->m_big = std::make_unique< mpz_class >(to_mpz(this->m_small));
+        }
+        *this->m_big <<= n;
+        return *this;
+    }
+
+    ZNum& shift_right(internal::ULI n) {
+        if (this->is_small()) {
+            // Rounds towards negative infinity, as GMP does.
+            if (n >= static_cast< internal::ULI >(internal::K64Bits)) {
+                this->m_small = this->m_small < 0 ? -1 : 0;
+            } else {
+                this->m_small >>= n;
+            }
+            return *this;
+        }
+        *this->m_big >>= n;
+        this->normalize();
+        return *this;
+    }
+
 }; // end class ZNum
 
 inline ZNum operator+(const ZNum& lhs, const ZNum& rhs) {
-    return ZNum(lhs.get_mpz() + rhs.get_mpz());
+    ZNum r(lhs);
+    r += rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator+(ZNum&& lhs, const ZNum& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator+(const ZNum& lhs, T rhs) {
-    return ZNum(lhs.get_mpz() + internal::MpzTransformer< T >()(rhs));
+    return lhs + ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator+(T lhs, const ZNum& rhs) {
-    return ZNum(internal::MpzTransformer< T >()(lhs) + rhs.get_mpz());
+    return ZNum(lhs) + rhs;
 }
 
 inline ZNum operator-(const ZNum& lhs, const ZNum& rhs) {
-    return ZNum(lhs.get_mpz() - rhs.get_mpz());
+    ZNum r(lhs);
+    r -= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator-(ZNum&& lhs, const ZNum& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator-(const ZNum& lhs, T rhs) {
-    return ZNum(lhs.get_mpz() - internal::MpzTransformer< T >()(rhs));
+    return lhs - ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator-(T lhs, const ZNum& rhs) {
-    return ZNum(internal::MpzTransformer< T >()(lhs) - rhs.get_mpz());
+    return ZNum(lhs) - rhs;
 }
 
 inline ZNum operator*(const ZNum& lhs, const ZNum& rhs) {
-    return ZNum(lhs.get_mpz() * rhs.get_mpz());
+    ZNum r(lhs);
+    r *= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator*(ZNum&& lhs, const ZNum& rhs) {
+    lhs *= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator*(const ZNum& lhs, T rhs) {
-    return ZNum(lhs.get_mpz() * internal::MpzTransformer< T >()(rhs));
+    return lhs * ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator*(T lhs, const ZNum& rhs) {
-    return ZNum(internal::MpzTransformer< T >()(lhs) * rhs.get_mpz());
+    return ZNum(lhs) * rhs;
 }
 
 inline ZNum operator/(const ZNum& lhs, const ZNum& rhs) {
-    knight_assert_msg(rhs.get_mpz() != 0, "divided by zero");
-    return ZNum(lhs.get_mpz() / rhs.get_mpz());
+    ZNum r(lhs);
+    r /= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator/(ZNum&& lhs, const ZNum& rhs) {
+    lhs /= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator/(const ZNum& lhs, T rhs) {
-    knight_assert_msg(rhs != 0, "divided by zero");
-    return ZNum(lhs.get_mpz() / internal::MpzTransformer< T >()(rhs));
+    return lhs / ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator/(T lhs, const ZNum& rhs) {
-    knight_assert_msg(rhs.get_mpz() != 0, "divided by zero");
-    return ZNum(internal::MpzTransformer< T >()(lhs) / rhs.get_mpz());
+    return ZNum(lhs) / rhs;
 }
 
 inline ZNum operator%(const ZNum& lhs, const ZNum& rhs) {
-    knight_assert_msg(rhs.get_mpz() != 0, "divided by zero");
-    return ZNum(lhs.get_mpz() % rhs.get_mpz());
+    ZNum r(lhs);
+    r %= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator%(ZNum&& lhs, const ZNum& rhs) {
+    lhs %= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator%(const ZNum& lhs, T rhs) {
-    knight_assert_msg(rhs != 0, "divided by zero");
-    return ZNum(lhs.get_mpz() % internal::MpzTransformer< T >()(rhs));
+    return lhs % ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator%(T lhs, const ZNum& rhs) {
-    knight_assert_msg(rhs.get_mpz() != 0, "divided by zero");
-    return ZNum(internal::MpzTransformer< T >()(lhs) % rhs.get_mpz());
+    return ZNum(lhs) % rhs;
 }
 
 inline ZNum operator&(const ZNum& lhs, const ZNum& rhs) {
-    return ZNum(lhs.get_mpz() & rhs.get_mpz());
+    ZNum r(lhs);
+    r &= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator&(ZNum&& lhs, const ZNum& rhs) {
+    lhs &= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator&(const ZNum& lhs, T rhs) {
-    return ZNum(lhs.get_mpz() & internal::MpzTransformer< T >()(rhs));
+    return lhs & ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator&(T lhs, const ZNum& rhs) {
-    return ZNum(internal::MpzTransformer< T >()(lhs) & rhs.get_mpz());
+    return ZNum(lhs) & rhs;
 }
 
 inline ZNum operator|(const ZNum& lhs, const ZNum& rhs) {
-    return ZNum(lhs.get_mpz() | rhs.get_mpz());
+    ZNum r(lhs);
+    r |= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator|(ZNum&& lhs, const ZNum& rhs) {
+    lhs |= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator|(const ZNum& lhs, T rhs) {
-    return ZNum(lhs.get_mpz() | internal::MpzTransformer< T >()(rhs));
+    return lhs | ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator|(T lhs, const ZNum& rhs) {
-    return ZNum(internal::MpzTransformer< T >()(lhs) | rhs.get_mpz());
+    return ZNum(lhs) | rhs;
 }
 
 inline ZNum operator^(const ZNum& lhs, const ZNum& rhs) {
-    return ZNum(lhs.get_mpz() ^ rhs.get_mpz());
+    ZNum r(lhs);
+    r ^= rhs;
+    return r;
+}
+
+/// \brief Reuse the storage of the temporary left operand.
+inline ZNum operator^(ZNum&& lhs, const ZNum& rhs) {
+    lhs ^= rhs;
+    return std::move(lhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator^(const ZNum& lhs, T rhs) {
-    return ZNum(lhs.get_mpz() ^ internal::MpzTransformer< T >()(rhs));
+    return lhs ^ ZNum(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator^(T lhs, const ZNum& rhs) {
-    return ZNum(internal::MpzTransformer< T >()(lhs) ^ rhs.get_mpz());
+    return ZNum(lhs) ^ rhs;
 }
 
 inline ZNum operator<<(const ZNum& lhs, const ZNum& rhs) {
-    knight_assert_msg(rhs.get_mpz() >= 0, "shift count is negative");
-    knight_assert_msg(rhs.get_mpz().fits_ulong_p(), "shift count is too big");
-    return ZNum(lhs.get_mpz() << rhs.get_mpz().get_ui());
+    ZNum r(lhs);
+    r <<= rhs;
+    return r;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator<<(const ZNum& lhs, T rhs) {
-    knight_assert_msg(rhs >= 0, "shift count is negative");
-    return ZNum(lhs.get_mpz() << static_cast< internal::ULI >(rhs));
+    ZNum r(lhs);
+    r <<= rhs;
+    return r;
 }
 
 template < typename T,
@@ -690,16 +994,17 @@ inline ZNum operator<<(T lhs, const ZNum& rhs) {
 }
 
 inline ZNum operator>>(const ZNum& lhs, const ZNum& rhs) {
-    knight_assert_msg(rhs.get_mpz() >= 0, "shift count is negative");
-    knight_assert_msg(rhs.get_mpz().fits_ulong_p(), "shift count is too big");
-    return ZNum(lhs.get_mpz() >> rhs.get_mpz().get_ui());
+    ZNum r(lhs);
+    r >>= rhs;
+    return r;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline ZNum operator>>(const ZNum& lhs, T rhs) {
-    knight_assert_msg(rhs >= 0, "shift count is negative");
-    return ZNum(lhs.get_mpz() >> static_cast< internal::ULI >(rhs));
+    ZNum r(lhs);
+    r >>= rhs;
+    return r;
 }
 
 template < typename T,
@@ -711,99 +1016,99 @@ inline ZNum operator>>(T lhs, const ZNum& rhs) {
 }
 
 inline bool operator==(const ZNum& lhs, const ZNum& rhs) {
-    return lhs.get_mpz() == rhs.get_mpz();
+    return lhs.equals(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator==(const ZNum& lhs, T rhs) {
-    return lhs.get_mpz() == internal::MpzTransformer< T >()(rhs);
+    return lhs.equals(ZNum(rhs));
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator==(T lhs, const ZNum& rhs) {
-    return internal::MpzTransformer< T >()(lhs) == rhs.get_mpz();
+    return ZNum(lhs).equals(rhs);
 }
 
 inline bool operator!=(const ZNum& lhs, const ZNum& rhs) {
-    return lhs.get_mpz() != rhs.get_mpz();
+    return !lhs.equals(rhs);
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator!=(const ZNum& lhs, T rhs) {
-    return lhs.get_mpz() != internal::MpzTransformer< T >()(rhs);
+    return !lhs.equals(ZNum(rhs));
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator!=(T lhs, const ZNum& rhs) {
-    return internal::MpzTransformer< T >()(lhs) != rhs.get_mpz();
+    return !ZNum(lhs).equals(rhs);
 }
 
 inline bool operator<(const ZNum& lhs, const ZNum& rhs) {
-    return lhs.get_mpz() < rhs.get_mpz();
+    return lhs.compare(rhs) < 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator<(const ZNum& lhs, T rhs) {
-    return lhs.get_mpz() < internal::MpzTransformer< T >()(rhs);
+    return lhs.compare(ZNum(rhs)) < 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator<(T lhs, const ZNum& rhs) {
-    return internal::MpzTransformer< T >()(lhs) < rhs.get_mpz();
+    return ZNum(lhs).compare(rhs) < 0;
 }
 
 inline bool operator<=(const ZNum& lhs, const ZNum& rhs) {
-    return lhs.get_mpz() <= rhs.get_mpz();
+    return lhs.compare(rhs) <= 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator<=(const ZNum& lhs, T rhs) {
-    return lhs.get_mpz() <= internal::MpzTransformer< T >()(rhs);
+    return lhs.compare(ZNum(rhs)) <= 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator<=(T lhs, const ZNum& rhs) {
-    return internal::MpzTransformer< T >()(lhs) <= rhs.get_mpz();
+    return ZNum(lhs).compare(rhs) <= 0;
 }
 
 inline bool operator>(const ZNum& lhs, const ZNum& rhs) {
-    return lhs.get_mpz() > rhs.get_mpz();
+    return lhs.compare(rhs) > 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator>(const ZNum& lhs, T rhs) {
-    return lhs.get_mpz() > internal::MpzTransformer< T >()(rhs);
+    return lhs.compare(ZNum(rhs)) > 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator>(T lhs, const ZNum& rhs) {
-    return internal::MpzTransformer< T >()(lhs) > rhs.get_mpz();
+    return ZNum(lhs).compare(rhs) > 0;
 }
 
 inline bool operator>=(const ZNum& lhs, const ZNum& rhs) {
-    return lhs.get_mpz() >= rhs.get_mpz();
+    return lhs.compare(rhs) >= 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator>=(const ZNum& lhs, T rhs) {
-    return lhs.get_mpz() >= internal::MpzTransformer< T >()(rhs);
+    return lhs.compare(ZNum(rhs)) >= 0;
 }
 
 template < typename T,
            class = std::enable_if_t< std::is_integral< T >::value > >
 inline bool operator>=(T lhs, const ZNum& rhs) {
-    return internal::MpzTransformer< T >()(lhs) >= rhs.get_mpz();
+    return ZNum(lhs).compare(rhs) >= 0;
 }
 
 inline const ZNum& min(const ZNum& a, const ZNum& b) {
@@ -837,20 +1142,35 @@ inline const ZNum& max(const ZNum& a,
 }
 
 inline ZNum mod(const ZNum& n, const ZNum& d) {
-    knight_assert_msg(d.get_mpz() != 0, "divided by zero");
-    ZNum r;
-    mpz_mod(r.m_mpz.get_mpz_t(), n.m_mpz.get_mpz_t(), d.m_mpz.get_mpz_t());
-    return r;
+    knight_assert_msg(d != 0, "divided by zero");
+    if (n.is_small() && d.is_small()) {
+        ZNum::Small r = d.m_small == -1 ? 0 : n.m_small % d.m_small;
+        if (r < 0) {
+            r = d.m_small > 0 ? r + d.m_small : r - d.m_small;
+        }
+        return ZNum(r);
+    }
+    mpz_class r;
+    mpz_mod(r.get_mpz_t(), n.get_mpz().get_mpz_t(), d.get_mpz().get_mpz_t());
+    return ZNum(std::move(r));
 }
 
 inline ZNum abs(const ZNum& n) {
+    if (n.is_small() && n.m_small != ZNum::SmallMin) {
+        return ZNum(n.m_small < 0 ? -n.m_small : n.m_small);
+    }
     return ZNum(abs(n.get_mpz()));
 }
 
 inline ZNum gcd(const ZNum& a, const ZNum& b) {
-    ZNum r;
-    mpz_gcd(r.m_mpz.get_mpz_t(), a.m_mpz.get_mpz_t(), b.m_mpz.get_mpz_t());
-    return r;
+    if (a.is_small() && b.is_small() && a.m_small != ZNum::SmallMin &&
+        b.m_small != ZNum::SmallMin) {
+        return ZNum(std::gcd(ZNum::abs_small(a.m_small),
+                             ZNum::abs_small(b.m_small)));
+    }
+    mpz_class r;
+    mpz_gcd(r.get_mpz_t(), a.get_mpz().get_mpz_t(), b.get_mpz().get_mpz_t());
+    return ZNum(std::move(r));
 }
 
 inline ZNum gcd(const ZNum& a, const ZNum& b, const ZNum& c) {
@@ -858,22 +1178,28 @@ inline ZNum gcd(const ZNum& a, const ZNum& b, const ZNum& c) {
 }
 
 inline ZNum lcm(const ZNum& a, const ZNum& b) {
-    ZNum r;
-    mpz_lcm(r.m_mpz.get_mpz_t(), a.m_mpz.get_mpz_t(), b.m_mpz.get_mpz_t());
-    return r;
+    mpz_class r;
+    mpz_lcm(r.get_mpz_t(), a.get_mpz().get_mpz_t(), b.get_mpz().get_mpz_t());
+    return ZNum(std::move(r));
 }
 
 inline void gcd_extended(
     const ZNum& a, const ZNum& b, ZNum& g, ZNum& u, ZNum& v) {
-    mpz_gcdext(g.m_mpz.get_mpz_t(),
-               u.m_mpz.get_mpz_t(),
-               v.m_mpz.get_mpz_t(),
-               a.m_mpz.get_mpz_t(),
-               b.m_mpz.get_mpz_t());
+    mpz_class mg;
+    mpz_class mu;
+    mpz_class mv;
+    mpz_gcdext(mg.get_mpz_t(),
+               mu.get_mpz_t(),
+               mv.get_mpz_t(),
+               a.get_mpz().get_mpz_t(),
+               b.get_mpz().get_mpz_t());
+    g = ZNum(std::move(mg));
+    u = ZNum(std::move(mu));
+    v = ZNum(std::move(mv));
 }
 
 inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os, const ZNum& n) {
-    return os << n.get_mpz().get_str();
+    return os << n.str();
 }
 
 inline void hash_combine(std::size_t& seed, std::size_t value) {
@@ -881,7 +1207,10 @@ inline void hash_combine(std::size_t& seed, std::size_t value) {
 }
 
 inline std::size_t hash_value(const ZNum& n) {
-    const mpz_class& m = n.get_mpz();
+    if (n.is_small()) {
+        return std::hash< ZNum::Small >()(n.m_small);
+    }
+    const mpz_class& m = *n.m_big;
     std::size_t result = 0;
     hash_combine(result, std::hash< int >()(m.get_mpz_t()[0]._mp_size));
     for (int i = 0, e = std::abs(m.get_mpz_t()[0]._mp_size); i < e; ++i) {
@@ -0,0 +1,257 @@
+//===- dbm_dom.hpp ----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the difference-bound matrix (zone) domain.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/bound.hpp"
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/core/domain/numerical/interval_dom.hpp"
+#include "analyzer/core/domain/numerical/numerical_base.hpp"
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <optional>
+#include <vector>
+
+namespace knight::analyzer {
+
+/// \brief Zone domain over `x - y <= c` constraints.
+///
+/// The matrix is stored as a sparse graph: an edge `i -> j` with weight
+/// `w` stands for `v_j - v_i <= w`, and a missing edge stands for `+oo`.
+/// The vertex `0` is the constant zero, so that `x <= c` and `x >= c`
+/// are edges from and to it.
+///
+/// The graph is kept closed (all edges are shortest paths) by every
+/// operation except widening. Adding one edge to a closed graph only
+/// relaxes the paths going through that edge, which is what makes the
+/// transfer functions cheap on the sparse graphs met in practice.
+template < typename Num, DomainKind Kind >
+class DBMDom : public NumericalDom< DBMDom< Num, Kind >, Num > {
+  public:
+    using Base = NumericalDom< DBMDom< Num, Kind >, Num >;
+    using DBMDomT = DBMDom< Num, Kind >;
+    using Var = Variable< Num >;
+    using BoundT = Bound< Num >;
+    using IntervalT = Interval< Num >;
+    using LinearExprT = LinearExpr< Num >;
+    using LinearConstraintT = LinearConstraint< Num >;
+    using LinearConstraintSystemT = LinearConstraintSystem< Num >;
+    using Solver = impl::IntervalSolver< Num, DBMDomT >;
+    using Index = unsigned;
+    using Row = llvm::DenseMap< Index, Num >;
+    using Edge = std::pair< Index, Num >;
+
+  private:
+    static constexpr Index ZeroIndex = 0U;
+
+    bool m_is_bottom;
+    bool m_is_closed = true;
+
+    llvm::DenseMap< Var, Index > m_var_index;
+    std::vector< std::optional< Var > > m_index_var{std::nullopt};
+    std::vector< Index > m_free_indices;
+
+    /// `m_succ[i][j] = w` means `v_j - v_i <= w`, `m_pred` is the mirror.
+    std::vector< Row > m_succ{Row{}};
+    std::vector< Row > m_pred{Row{}};
+
+  public:
+    explicit DBMDom(bool is_bottom) : m_is_bottom(is_bottom) {}
+
+  public:
+    [[nodiscard]] static constexpr DomainKind get_kind() { return Kind; }
+    [[nodiscard]] static SharedVal default_val() {
+        return std::static_pointer_cast< AbsDomBase >(
+            std::make_shared< DBMDom >(false));
+    }
+    [[nodiscard]] static SharedVal bottom_val() {
+        return std::static_pointer_cast< AbsDomBase >(
+            std::make_shared< DBMDom >(true));
+    }
+
+    [[nodiscard]] AbsDomBase* clone() const override {
+        return new DBMDom(*this);
+    }
+
+    void normalize() override {
+        if (!m_is_bottom && !m_is_closed) {
+            close();
+        }
+    }
+
+    [[nodiscard]] bool is_normalized() const override {
+        return m_is_bottom || m_is_closed;
+    }
+
+    [[nodiscard]] bool is_bottom() const override { return m_is_bottom; }
+
+    [[nodiscard]] bool is_top() const override {
+        return !m_is_bottom && m_var_index.empty();
+    }
+
+    void set_to_bottom() override {
+        clear();
+        m_is_bottom = true;
+    }
+
+    void set_to_top() override {
+        clear();
+        m_is_bottom = false;
+    }
+
+    void forget(const Var& x) override;
+
+    void join_with(const DBMDomT& other);
+
+    void widen_with(const DBMDomT& other);
+
+    void meet_with(const DBMDomT& other);
+
+    void narrow_with(const DBMDomT& other);
+
+    [[nodiscard]] bool leq(const DBMDomT& other) const;
+
+    /// \brief Compare the edges of the closed graphs, which are the same
+    /// for the same constraints.
+    [[nodiscard]] bool equals(const DBMDomT& other) const;
+
+    /// \brief Refine the bounds of `x` with `itv`, used by the solver.
+    void meet_value(const Var& x, const IntervalT& itv);
+
+    void dump(llvm::raw_ostream& os) const override;
+
+  public:
+    void widen_with_threshold(const DBMDomT& other,
+                              llvm::ArrayRef< Num > thresholds);
+
+    void narrow_with_threshold(const DBMDomT& other,
+                               llvm::ArrayRef< Num > thresholds);
+
+    void assign_num(const Var& x, const Num& n) override;
+
+    void assign_var(const Var& x, const Var& y) override {
+        assign_var_plus_num(x, y, Num(0));
+    }
+
+    void assign_linear_expr(const Var& x, const LinearExprT& e) override;
+
+    void assign_binary_var_var(clang::BinaryOperatorKind op,
+                               const Var& x,
+                               const Var& y,
+                               const Var& z) override;
+
+    void assign_binary_var_num(clang::BinaryOperatorKind op,
+                               const Var& x,
+                               const Var& y,
+                               const Num& z) override;
+
+    void assign_cast(clang::QualType dst_type,
+                     unsigned dst_bit_width,
+                     const Var& x,
+                     const Var& y) override;
+
+    [[nodiscard]] IntervalT to_interval(const Var& x) const override;
+
+    void apply_linear_constraint(const LinearConstraintT& cst) override;
+
+    void merge_with_linear_constraint_system(
+        const LinearConstraintSystemT& csts) override;
+
+    [[nodiscard]] LinearConstraintSystemT to_linear_constraint_system()
+        const override;
+
+  private:
+    void clear();
+
+    [[nodiscard]] std::optional< Index > get_index(const Var& x) const;
+
+    [[nodiscard]] Index get_or_create_index(const Var& x);
+
+    /// \brief Map the vertex `idx` of `other` to the vertex of `this`.
+    [[nodiscard]] std::optional< Index > translate(const DBMDomT& other,
+                                                   Index idx) const;
+
+    [[nodiscard]] Index translate_or_create(const DBMDomT& other, Index idx);
+
+    [[nodiscard]] const Num* get_edge(Index i, Index j) const;
+
+    void set_edge(Index i, Index j, const Num& w);
+
+    void remove_edge(Index i, Index j);
+
+    /// \return true if the edge is tightened.
+    bool tighten_edge(Index i, Index j, const Num& w);
+
+    /// \brief Add `v_j - v_i <= w` and restore the closure incrementally.
+    ///
+    /// \note The graph shall be closed.
+    void add_edge_and_close(Index i, Index j, const Num& w);
+
+    /// \brief Full sparse Floyd-Warshall closure.
+    void close();
+
+    void forget_index(Index i);
+
+    /// \brief Release the vertices which are no longer constrained.
+    void release_isolated_indices();
+
+    /// \brief Assign `x = y + n`.
+    void assign_var_plus_num(const Var& x, const Var& y, const Num& n);
+
+    /// \brief Assign `x = x + n`, which keeps the graph closed.
+    void shift(const Var& x, const Num& n);
+
+    /// \brief Assign `x` to the interval `itv`, `x` shall be unconstrained.
+    void set_interval(const Var& x, const IntervalT& itv);
+
+    /// \brief The bounds of `y - z` implied by the matrix.
+    [[nodiscard]] IntervalT get_difference(const Var& y, const Var& z) const;
+
+    /// \brief Apply the comparison `x = y op z` through both branches.
+    void assign_comparison(const Var& x,
+                           const LinearConstraintT& cst,
+                           const LinearConstraintT& negated_cst);
+
+    /// \brief Try to apply a unit two-variable constraint as edges.
+    ///
+    /// \return false if the constraint is not of the zone form.
+    bool apply_zone_constraint(const LinearConstraintT& cst);
+
+    /// \brief Widen the weight of an edge bounding a variable.
+    ///
+    /// \param is_lower_bound true for the edges to the zero vertex, whose
+    /// weights are the negated lower bounds.
+    [[nodiscard]] static std::optional< Num > widen_weight(
+        const Num& w,
+        const Num& other_w,
+        llvm::ArrayRef< Num > thresholds,
+        bool is_lower_bound);
+
+}; // class DBMDom
+
+using ZDBMDom = DBMDom< ZNum, DomainKind::ZDBMDomain >;
+
+template < typename Num, DomainKind Kind >
+inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                                     const DBMDom< Num, Kind >& dom) {
+    dom.dump(os);
+    return os;
+}
+
+} // namespace knight::analyzer
+
+#include "dbm_dom.tpp"
@@ -0,0 +1,907 @@
+//===- dbm_dom.tpp ----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header implements the difference-bound matrix (zone) domain.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/numerical/dbm_dom.hpp"
+#include "common/util/log.hpp"
+
+#ifdef DEBUG_TYPE
+#    define DEBUG_TYPE_BACKUP DEBUG_TYPE
+#    undef DEBUG_TYPE
+#endif
+
+#define DEBUG_TYPE "dbm-dom"
+
+namespace knight::analyzer {
+
+namespace impl {
+
+template < typename Num >
+[[nodiscard]] inline Interval< Num > compute_dbm_binary(
+    clang::BinaryOperatorKind op,
+    const Interval< Num >& y,
+    const Interval< Num >& z) {
+    switch (op) {
+        using enum clang::BinaryOperatorKind;
+        case BO_Add:
+            return y + z;
+        case BO_Sub:
+            return y - z;
+        case BO_Mul:
+            return y * z;
+        case BO_Div:
+            return y / z;
+        case BO_Rem:
+            return y % z;
+        case BO_Shl:
+            return y << z;
+        case BO_Shr:
+            return y >> z;
+        case BO_And:
+            return y & z;
+        case BO_Or:
+            return y | z;
+        case BO_Xor:
+            return y ^ z;
+        default:
+            break;
+    }
+    knight_unreachable("Unsupported binary operator");
+}
+
+} // namespace impl
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::clear() {
+    m_is_closed = true;
+    m_var_index.clear();
+    m_index_var.assign(1, std::nullopt);
+    m_free_indices.clear();
+    m_succ.assign(1, Row{});
+    m_pred.assign(1, Row{});
+}
+
+template < typename Num, DomainKind Kind >
+std::optional< typename DBMDom< Num, Kind >::Index > DBMDom< Num, Kind >::
+    get_index(const Var& x) const {
+    auto it = m_var_index.find(x);
+    if (it == m_var_index.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+template < typename Num, DomainKind Kind >
+typename DBMDom< Num, Kind >::Index DBMDom< Num, Kind >::get_or_create_index(
+    const Var& x) {
+    auto it = m_var_index.find(x);
+    if (it != m_var_index.end()) {
+        return it->second;
+    }
+    Index idx = 0U;
+    if (!m_free_indices.empty()) {
+        idx = m_free_indices.back();
+        m_free_indices.pop_back();
+        m_index_var[idx] = x;
+    } else {
+        idx = static_cast< Index >(m_index_var.size());
+        m_index_var.emplace_back(x);
+        m_succ.emplace_back();
+        m_pred.emplace_back();
+    }
+    m_var_index.try_emplace(x, idx);
+    return idx;
+}
+
+template < typename Num, DomainKind Kind >
+std::optional< typename DBMDom< Num, Kind >::Index > DBMDom< Num, Kind >::
+    translate(const DBMDomT& other, Index idx) const {
+    if (idx == ZeroIndex) {
+        return ZeroIndex;
+    }
+    return get_index(*other.m_index_var[idx]);
+}
+
+template < typename Num, DomainKind Kind >
+typename DBMDom< Num, Kind >::Index DBMDom< Num, Kind >::translate_or_create(
+    const DBMDomT& other, Index idx) {
+    if (idx == ZeroIndex) {
+        return ZeroIndex;
+    }
+    return get_or_create_index(*other.m_index_var[idx]);
+}
+
+template < typename Num, DomainKind Kind >
+const Num* DBMDom< Num, Kind >::get_edge(Index i, Index j) const {
+    auto it = m_succ[i].find(j);
+    return it == m_succ[i].end() ? nullptr : &it->second;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::set_edge(Index i, Index j, const Num& w) {
+    m_succ[i][j] = w;
+    m_pred[j][i] = w;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::remove_edge(Index i, Index j) {
+    m_succ[i].erase(j);
+    m_pred[j].erase(i);
+}
+
+template < typename Num, DomainKind Kind >
+bool DBMDom< Num, Kind >::tighten_edge(Index i, Index j, const Num& w) {
+    const Num* old_w = get_edge(i, j);
+    if (old_w != nullptr && *old_w <= w) {
+        return false;
+    }
+    set_edge(i, j, w);
+    return true;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::add_edge_and_close(Index i, Index j, const Num& w) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (i == j) {
+        if (w < 0) {
+            set_to_bottom();
+        }
+        return;
+    }
+    if (const Num* old_w = get_edge(i, j); old_w != nullptr && *old_w <= w) {
+        return;
+    }
+    if (const Num* back_w = get_edge(j, i);
+        back_w != nullptr && *back_w + w < 0) {
+        set_to_bottom();
+        return;
+    }
+
+    // Every new shortest path `k -> l` goes through `i -> j` exactly once,
+    // so in a closed graph only `k -> i -> j -> l` needs to be relaxed.
+    std::vector< Edge > srcs{{i, Num(0)}};
+    std::vector< Edge > dsts{{j, Num(0)}};
+    for (const auto& [k, wk] : m_pred[i]) {
+        srcs.emplace_back(k, wk);
+    }
+    for (const auto& [l, wl] : m_succ[j]) {
+        dsts.emplace_back(l, wl);
+    }
+    for (const auto& [k, wk] : srcs) {
+        const Num wki = wk + w;
+        for (const auto& [l, wl] : dsts) {
+            if (k == l) {
+                if (wki + wl < 0) {
+                    set_to_bottom();
+                    return;
+                }
+                continue;
+            }
+            (void)tighten_edge(k, l, wki + wl);
+        }
+    }
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::close() {
+    std::vector< Edge > preds;
+    std::vector< Edge > succs;
+    for (Index k = 0U; k < m_succ.size(); ++k) {
+        if (m_pred[k].empty() || m_succ[k].empty()) {
+            continue;
+        }
+        preds.assign(m_pred[k].begin(), m_pred[k].end());
+        succs.assign(m_succ[k].begin(), m_succ[k].end());
+        for (const auto& [i, wi] : preds) {
+            for (const auto& [j, wj] : succs) {
+                if (i == j) {
+                    if (wi + wj < 0) {
+                        set_to_bottom();
+                        return;
+                    }
+                    continue;
+                }
+                (void)tighten_edge(i, j, wi + wj);
+            }
+        }
+    }
+    m_is_closed = true;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::forget_index(Index i) {
+    for (const auto& [j, _] : m_succ[i]) {
+        m_pred[j].erase(i);
+    }
+    for (const auto& [j, _] : m_pred[i]) {
+        m_succ[j].erase(i);
+    }
+    m_succ[i].clear();
+    m_pred[i].clear();
+    m_var_index.erase(*m_index_var[i]);
+    m_index_var[i] = std::nullopt;
+    m_free_indices.push_back(i);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::release_isolated_indices() {
+    for (Index i = 1U; i < m_index_var.size(); ++i) {
+        if (m_index_var[i] && m_succ[i].empty() && m_pred[i].empty()) {
+            forget_index(i);
+        }
+    }
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::forget(const Var& x) {
+    if (m_is_bottom) {
+        return;
+    }
+    auto idx = get_index(x);
+    if (!idx) {
+        return;
+    }
+    // The implied constraints between the other variables shall be kept.
+    normalize();
+    forget_index(*idx);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::join_with(const DBMDomT& other) {
+    if (other.m_is_bottom) {
+        return;
+    }
+    if (m_is_bottom) {
+        *this = other;
+        return;
+    }
+    normalize();
+    DBMDomT closed_other = other;
+    closed_other.normalize();
+
+    // The pointwise max of two closed matrices is closed.
+    std::vector< std::pair< Index, Index > > to_remove;
+    for (Index i = 0U; i < m_succ.size(); ++i) {
+        for (auto& [j, w] : m_succ[i]) {
+            auto oi = closed_other.translate(*this, i);
+            auto oj = closed_other.translate(*this, j);
+            const Num* ow =
+                oi && oj ? closed_other.get_edge(*oi, *oj) : nullptr;
+            if (ow == nullptr) {
+                to_remove.emplace_back(i, j);
+            } else if (w < *ow) {
+                w = *ow;
+                m_pred[j][i] = *ow;
+            }
+        }
+    }
+    for (const auto& [i, j] : to_remove) {
+        remove_edge(i, j);
+    }
+    release_isolated_indices();
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::widen_with(const DBMDomT& other) {
+    if (other.m_is_bottom) {
+        return;
+    }
+    if (m_is_bottom) {
+        *this = other;
+        return;
+    }
+
+    // Only the stable edges are kept, and the result is not closed
+    // again, otherwise the widening sequence may not terminate.
+    std::vector< std::pair< Index, Index > > to_remove;
+    for (Index i = 0U; i < m_succ.size(); ++i) {
+        for (const auto& [j, w] : m_succ[i]) {
+            auto oi = other.translate(*this, i);
+            auto oj = other.translate(*this, j);
+            const Num* ow = oi && oj ? other.get_edge(*oi, *oj) : nullptr;
+            if (ow == nullptr || w < *ow) {
+                to_remove.emplace_back(i, j);
+            }
+        }
+    }
+    for (const auto& [i, j] : to_remove) {
+        remove_edge(i, j);
+    }
+    release_isolated_indices();
+    m_is_closed = false;
+}
+
+template < typename Num, DomainKind Kind >
+std::optional< Num > DBMDom< Num, Kind >::widen_weight(
+    const Num& w,
+    const Num& other_w,
+    llvm::ArrayRef< Num > thresholds,
+    bool is_lower_bound) {
+    if (other_w <= w) {
+        return w;
+    }
+    if (!is_lower_bound) {
+        return get_threshold_above(thresholds, other_w);
+    }
+    if (auto threshold = get_threshold_below(thresholds, -other_w)) {
+        return -*threshold;
+    }
+    return std::nullopt;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::widen_with_threshold(
+    const DBMDomT& other, llvm::ArrayRef< Num > thresholds) {
+    if (other.m_is_bottom) {
+        return;
+    }
+    if (m_is_bottom) {
+        *this = other;
+        return;
+    }
+
+    // The thresholds bound the variables, i.e., the edges from and to
+    // the zero vertex, and the difference edges are widened as usual.
+    std::vector< std::pair< Index, Index > > to_remove;
+    std::vector< std::pair< std::pair< Index, Index >, Num > > to_set;
+    for (Index i = 0U; i < m_succ.size(); ++i) {
+        for (const auto& [j, w] : m_succ[i]) {
+            auto oi = other.translate(*this, i);
+            auto oj = other.translate(*this, j);
+            const Num* ow = oi && oj ? other.get_edge(*oi, *oj) : nullptr;
+            if (ow == nullptr) {
+                to_remove.emplace_back(i, j);
+                continue;
+            }
+            std::optional< Num > new_w;
+            if (i == ZeroIndex) {
+                new_w = widen_weight(w, *ow, thresholds, false);
+            } else if (j == ZeroIndex) {
+                new_w = widen_weight(w, *ow, thresholds, true);
+            } else if (*ow <= w) {
+                new_w = w;
+            }
+            if (!new_w) {
+                to_remove.emplace_back(i, j);
+            } else if (*new_w != w) {
+                to_set.emplace_back(std::make_pair(i, j), *new_w);
+            }
+        }
+    }
+    for (const auto& [i, j] : to_remove) {
+        remove_edge(i, j);
+    }
+    for (const auto& [ij, w] : to_set) {
+        set_edge(ij.first, ij.second, w);
+    }
+    release_isolated_indices();
+    m_is_closed = false;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::meet_with(const DBMDomT& other) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (other.m_is_bottom) {
+        set_to_bottom();
+        return;
+    }
+    for (Index i = 0U; i < other.m_succ.size(); ++i) {
+        if (other.m_succ[i].empty()) {
+            continue;
+        }
+        Index ti = translate_or_create(other, i);
+        for (const auto& [j, w] : other.m_succ[i]) {
+            (void)tighten_edge(ti, translate_or_create(other, j), w);
+        }
+    }
+    close();
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::narrow_with(const DBMDomT& other) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (other.m_is_bottom) {
+        set_to_bottom();
+        return;
+    }
+    for (Index i = 0U; i < other.m_succ.size(); ++i) {
+        if (other.m_succ[i].empty()) {
+            continue;
+        }
+        Index ti = translate_or_create(other, i);
+        for (const auto& [j, w] : other.m_succ[i]) {
+            Index tj = translate_or_create(other, j);
+            if (get_edge(ti, tj) == nullptr) {
+                set_edge(ti, tj, w);
+            }
+        }
+    }
+    close();
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::narrow_with_threshold(
+    const DBMDomT& other, llvm::ArrayRef< Num > thresholds) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (other.m_is_bottom) {
+        set_to_bottom();
+        return;
+    }
+    for (Index i = 0U; i < other.m_succ.size(); ++i) {
+        if (other.m_succ[i].empty()) {
+            continue;
+        }
+        Index ti = translate_or_create(other, i);
+        for (const auto& [j, w] : other.m_succ[i]) {
+            Index tj = translate_or_create(other, j);
+            const Num* old_w = get_edge(ti, tj);
+            const bool is_threshold =
+                old_w != nullptr &&
+                ((ti == ZeroIndex && is_threshold(thresholds, *old_w)) ||
+                 (tj == ZeroIndex && is_threshold(thresholds, -*old_w)));
+            if (old_w == nullptr || is_threshold) {
+                set_edge(ti, tj, w);
+            }
+        }
+    }
+    close();
+}
+
+template < typename Num, DomainKind Kind >
+bool DBMDom< Num, Kind >::leq(const DBMDomT& other) const {
+    if (m_is_bottom) {
+        return true;
+    }
+    if (other.m_is_bottom) {
+        return false;
+    }
+    if (!m_is_closed) {
+        DBMDomT closed = *this;
+        closed.normalize();
+        return closed.leq(other);
+    }
+    for (Index i = 0U; i < other.m_succ.size(); ++i) {
+        for (const auto& [j, ow] : other.m_succ[i]) {
+            auto ti = translate(other, i);
+            auto tj = translate(other, j);
+            const Num* w = ti && tj ? get_edge(*ti, *tj) : nullptr;
+            if (w == nullptr || ow < *w) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template < typename Num, DomainKind Kind >
+bool DBMDom< Num, Kind >::equals(const DBMDomT& other) const {
+    if (m_is_bottom || other.m_is_bottom) {
+        return m_is_bottom == other.m_is_bottom;
+    }
+    if (!m_is_closed) {
+        DBMDomT closed = *this;
+        closed.normalize();
+        return closed.equals(other);
+    }
+    if (!other.m_is_closed) {
+        DBMDomT closed = other;
+        closed.normalize();
+        return equals(closed);
+    }
+    auto num_edges = [](const DBMDomT& dbm) {
+        std::size_t num = 0U;
+        for (const auto& row : dbm.m_succ) {
+            num += row.size();
+        }
+        return num;
+    };
+    if (num_edges(*this) != num_edges(other)) {
+        return false;
+    }
+    for (Index i = 0U; i < other.m_succ.size(); ++i) {
+        for (const auto& [j, ow] : other.m_succ[i]) {
+            auto ti = translate(other, i);
+            auto tj = translate(other, j);
+            const Num* w = ti && tj ? get_edge(*ti, *tj) : nullptr;
+            if (w == nullptr || *w != ow) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::meet_value(const Var& x, const IntervalT& itv) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (itv.is_bottom()) {
+        set_to_bottom();
+        return;
+    }
+    normalize();
+    Index idx = get_or_create_index(x);
+    if (auto ub = itv.get_ub().get_num_opt()) {
+        add_edge_and_close(ZeroIndex, idx, *ub);
+    }
+    if (auto lb = itv.get_lb().get_num_opt()) {
+        add_edge_and_close(idx, ZeroIndex, -*lb);
+    }
+}
+
+template < typename Num, DomainKind Kind >
+typename DBMDom< Num, Kind >::IntervalT DBMDom< Num, Kind >::to_interval(
+    const Var& x) const {
+    if (m_is_bottom) {
+        return IntervalT::bottom();
+    }
+    if (!m_is_closed) {
+        DBMDomT closed = *this;
+        closed.normalize();
+        return closed.to_interval(x);
+    }
+    auto idx = get_index(x);
+    if (!idx) {
+        return IntervalT::top();
+    }
+    const Num* ub = get_edge(ZeroIndex, *idx);
+    const Num* neg_lb = get_edge(*idx, ZeroIndex);
+    return IntervalT(neg_lb != nullptr ? BoundT(-*neg_lb) : BoundT::ninf(),
+                     ub != nullptr ? BoundT(*ub) : BoundT::pinf());
+}
+
+template < typename Num, DomainKind Kind >
+typename DBMDom< Num, Kind >::IntervalT DBMDom< Num, Kind >::get_difference(
+    const Var& y, const Var& z) const {
+    if (y.equals(z)) {
+        return IntervalT(Num(0));
+    }
+    IntervalT itv = to_interval(y) - to_interval(z);
+    auto iy = get_index(y);
+    auto iz = get_index(z);
+    if (!m_is_closed || !iy || !iz) {
+        return itv;
+    }
+    const Num* ub = get_edge(*iz, *iy);
+    const Num* neg_lb = get_edge(*iy, *iz);
+    itv.meet_with(
+        IntervalT(neg_lb != nullptr ? BoundT(-*neg_lb) : BoundT::ninf(),
+                  ub != nullptr ? BoundT(*ub) : BoundT::pinf()));
+    return itv;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::set_interval(const Var& x, const IntervalT& itv) {
+    if (itv.is_bottom()) {
+        set_to_bottom();
+        return;
+    }
+    if (itv.is_top()) {
+        return;
+    }
+    meet_value(x, itv);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_num(const Var& x, const Num& n) {
+    if (m_is_bottom) {
+        return;
+    }
+    forget(x);
+    set_interval(x, IntervalT(n));
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::shift(const Var& x, const Num& n) {
+    auto idx = get_index(x);
+    if (!idx) {
+        return;
+    }
+    // `v_j - x' <= w - n` and `x' - v_i <= w + n` for `x' = x + n`.
+    std::vector< Edge > succs(m_succ[*idx].begin(), m_succ[*idx].end());
+    std::vector< Edge > preds(m_pred[*idx].begin(), m_pred[*idx].end());
+    for (const auto& [j, w] : succs) {
+        set_edge(*idx, j, w - n);
+    }
+    for (const auto& [i, w] : preds) {
+        set_edge(i, *idx, w + n);
+    }
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_var_plus_num(const Var& x,
+                                              const Var& y,
+                                              const Num& n) {
+    if (m_is_bottom) {
+        return;
+    }
+    normalize();
+    if (x.equals(y)) {
+        shift(x, n);
+        return;
+    }
+    forget(x);
+    Index iy = get_or_create_index(y);
+    Index ix = get_or_create_index(x);
+    add_edge_and_close(iy, ix, n);
+    add_edge_and_close(ix, iy, -n);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_linear_expr(const Var& x,
+                                             const LinearExprT& e) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (e.is_constant()) {
+        assign_num(x, e.get_constant_term());
+        return;
+    }
+    if (e.num_variable_terms() == 1U) {
+        const auto& [y, coeff] = *e.get_variable_terms().begin();
+        if (coeff == 1) {
+            assign_var_plus_num(x, y, e.get_constant_term());
+            return;
+        }
+    }
+
+    normalize();
+    IntervalT itv(e.get_constant_term());
+    for (const auto& [var, coeff] : e.get_variable_terms()) {
+        itv += IntervalT(coeff) * to_interval(var);
+    }
+    forget(x);
+    set_interval(x, itv);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_comparison(
+    const Var& x,
+    const LinearConstraintT& cst,
+    const LinearConstraintT& negated_cst) {
+    DBMDomT dom_pos = *this;
+    DBMDomT dom_neg = *this;
+    dom_pos.apply_linear_constraint(cst);
+    dom_neg.apply_linear_constraint(negated_cst);
+
+    IntervalT res = IntervalT::unknown_bool();
+    if (dom_pos.is_bottom() && !dom_neg.is_bottom()) {
+        res = IntervalT::false_val();
+    } else if (!dom_pos.is_bottom() && dom_neg.is_bottom()) {
+        res = IntervalT::true_val();
+    }
+    forget(x);
+    set_interval(x, res);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_binary_var_var(clang::BinaryOperatorKind op,
+                                                const Var& x,
+                                                const Var& y,
+                                                const Var& z) {
+    knight_assert(!clang::BinaryOperator::isAssignmentOp(op));
+    if (m_is_bottom) {
+        return;
+    }
+    normalize();
+    if (clang::BinaryOperator::isComparisonOp(op)) {
+        LinearConstraintT cst = Base::construct_constraint(op, y, z);
+        assign_comparison(x, cst, cst.negate());
+        return;
+    }
+
+    IntervalT itv = op == clang::BO_Sub
+                        ? get_difference(y, z)
+                        : impl::compute_dbm_binary(op,
+                                                   to_interval(y),
+                                                   to_interval(z));
+    forget(x);
+    set_interval(x, itv);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_binary_var_num(clang::BinaryOperatorKind op,
+                                                const Var& x,
+                                                const Var& y,
+                                                const Num& z) {
+    knight_assert(!clang::BinaryOperator::isAssignmentOp(op));
+    if (m_is_bottom) {
+        return;
+    }
+    normalize();
+    if (clang::BinaryOperator::isComparisonOp(op)) {
+        LinearConstraintT cst = Base::construct_constraint(op, y, z);
+        assign_comparison(x, cst, cst.negate());
+        return;
+    }
+    if (op == clang::BO_Add) {
+        assign_var_plus_num(x, y, z);
+        return;
+    }
+    if (op == clang::BO_Sub) {
+        assign_var_plus_num(x, y, -z);
+        return;
+    }
+
+    IntervalT itv =
+        impl::compute_dbm_binary(op, to_interval(y), IntervalT(z));
+    forget(x);
+    set_interval(x, itv);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::assign_cast(clang::QualType dst_type,
+                                      unsigned dst_bit_width,
+                                      const Var& x,
+                                      const Var& y) {
+    if (m_is_bottom) {
+        return;
+    }
+    normalize();
+    IntervalT itv = to_interval(y);
+    IntervalT casted = itv;
+    casted.cast(dst_type, dst_bit_width);
+    if (casted.equals(itv)) {
+        assign_var(x, y);
+        return;
+    }
+    forget(x);
+    set_interval(x, casted);
+}
+
+template < typename Num, DomainKind Kind >
+bool DBMDom< Num, Kind >::apply_zone_constraint(const LinearConstraintT& cst) {
+    if (cst.is_disequation() || cst.num_variable_terms() > 2U) {
+        return false;
+    }
+
+    // `sum(a_i * x_i) <= k` with `a_i` in {1, -1} and at most one of each.
+    std::optional< Var > pos;
+    std::optional< Var > neg;
+    for (const auto& [var, coeff] : cst.get_variable_terms()) {
+        if (coeff == 1 && !pos) {
+            pos = var;
+        } else if (coeff == -1 && !neg) {
+            neg = var;
+        } else {
+            return false;
+        }
+    }
+
+    Index ip = pos ? get_or_create_index(*pos) : ZeroIndex;
+    Index in = neg ? get_or_create_index(*neg) : ZeroIndex;
+    Num k = cst.get_constant_term();
+    add_edge_and_close(in, ip, k);
+    if (cst.is_equality()) {
+        add_edge_and_close(ip, in, -k);
+    }
+    return true;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::apply_linear_constraint(
+    const LinearConstraintT& cst) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (cst.is_contradiction()) {
+        set_to_bottom();
+        return;
+    }
+    if (cst.is_tautology()) {
+        return;
+    }
+    normalize();
+    if (apply_zone_constraint(cst)) {
+        return;
+    }
+    Solver solver;
+    solver.add(cst);
+    solver.run(*this);
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::merge_with_linear_constraint_system(
+    const LinearConstraintSystemT& csts) {
+    if (m_is_bottom) {
+        return;
+    }
+    normalize();
+    Solver solver;
+    for (const LinearConstraintT& cst : csts.get_linear_constraints()) {
+        if (cst.is_contradiction()) {
+            set_to_bottom();
+            return;
+        }
+        if (cst.is_tautology() || apply_zone_constraint(cst)) {
+            continue;
+        }
+        solver.add(cst);
+    }
+    if (!m_is_bottom) {
+        solver.run(*this);
+    }
+}
+
+template < typename Num, DomainKind Kind >
+typename DBMDom< Num, Kind >::LinearConstraintSystemT DBMDom< Num, Kind >::
+    to_linear_constraint_system() const {
+    if (m_is_bottom) {
+        return LinearConstraintSystemT(LinearConstraintT::contradiction());
+    }
+
+    LinearConstraintSystemT csts;
+    for (Index i = 0U; i < m_succ.size(); ++i) {
+        for (const auto& [j, w] : m_succ[i]) {
+            if (i == ZeroIndex) {
+                csts.add_linear_constraint(*m_index_var[j] <= w);
+            } else if (j == ZeroIndex) {
+                csts.add_linear_constraint(*m_index_var[i] >= -w);
+            } else {
+                csts.add_linear_constraint(
+                    (*m_index_var[j] - *m_index_var[i]) <= w);
+            }
+        }
+    }
+    return csts;
+}
+
+template < typename Num, DomainKind Kind >
+void DBMDom< Num, Kind >::dump(llvm::raw_ostream& os) const {
+    if (is_bottom()) {
+        os << "⊥";
+        return;
+    }
+    if (is_top()) {
+        os << "T";
+        return;
+    }
+    os << "{";
+    bool first = true;
+    for (Index i = 0U; i < m_succ.size(); ++i) {
+        for (const auto& [j, w] : m_succ[i]) {
+            if (!first) {
+                os << ", ";
+            }
+            first = false;
+            if (i == ZeroIndex) {
+                os << *m_index_var[j] << " <= " << w;
+            } else if (j == ZeroIndex) {
+                os << *m_index_var[i] << " >= " << -w;
+            } else {
+                os << *m_index_var[j] << " - " << *m_index_var[i]
+                   << " <= " << w;
+            }
+        }
+    }
+    os << "}";
+}
+
+} // namespace knight::analyzer
+
+#ifdef DEBUG_TYPE_BACKUP
+#    define DEBUG_TYPE DEBUG_TYPE_BACKUP
+#    undef DEBUG_TYPE_BACKUP
+#else
+#    undef DEBUG_TYPE
+#endif
@@ -0,0 +1,223 @@
+//===- interval_congruence_dom.hpp ------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the interval and congruence reduced product domain
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/core/domain/interval_congruence.hpp"
+#include "analyzer/core/domain/map/separate_numerical_domain.hpp"
+#include "analyzer/core/domain/numerical/numerical_base.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+namespace knight::analyzer {
+
+/// \brief Reduced product of the intervals and the congruences of the
+/// `ZNum` variables, for the strides of the array indexes.
+///
+/// The values are reduced lazily, see `IntervalCongruence`: the
+/// intervals given to the constraint solver and the other queries are
+/// reduced on the fly, and the stored values at the normalization of the
+/// state, at the loop heads.
+///
+/// The constraints are solved on the intervals by the interval solver,
+/// then the equalities refine the congruences.
+class ZIntervalCongruenceDom
+    : public NumericalDom< ZIntervalCongruenceDom, ZNum > {
+  public:
+    using Base = NumericalDom< ZIntervalCongruenceDom, ZNum >;
+    using Var = Variable< ZNum >;
+    using LinearExprT = LinearExpr< ZNum >;
+    using LinearConstraintT = LinearConstraint< ZNum >;
+    using LinearConstraintSystemT = LinearConstraintSystem< ZNum >;
+    using SeparateNumericalDomT =
+        SeparateNumericalDom< ZNum,
+                              ZIntervalCongruence,
+                              DomainKind::ZIntervalCongruenceSeparate >;
+    using Map = typename SeparateNumericalDomT::Map;
+
+  private:
+    SeparateNumericalDomT m_sep_dom;
+
+  public:
+    explicit ZIntervalCongruenceDom(bool is_bottom, Map table = {})
+        : m_sep_dom(SeparateNumericalDomT(is_bottom, std::move(table))) {}
+
+  public:
+    [[nodiscard]] static constexpr DomainKind get_kind() {
+        return DomainKind::ZIntervalCongruenceDomain;
+    }
+    [[nodiscard]] static SharedVal default_val() {
+        return std::static_pointer_cast< AbsDomBase >(
+            std::make_shared< ZIntervalCongruenceDom >(false, Map{}));
+    }
+    [[nodiscard]] static SharedVal bottom_val() {
+        return std::static_pointer_cast< AbsDomBase >(
+            std::make_shared< ZIntervalCongruenceDom >(true, Map{}));
+    }
+
+    [[nodiscard]] AbsDomBase* clone() const override {
+        return new ZIntervalCongruenceDom(*this);
+    }
+
+    void normalize() override { m_sep_dom.normalize(); }
+
+    [[nodiscard]] bool is_normalized() const override {
+        return m_sep_dom.is_normalized();
+    }
+
+    [[nodiscard]] bool is_bottom() const override {
+        return m_sep_dom.is_bottom();
+    }
+
+    [[nodiscard]] bool is_top() const override { return m_sep_dom.is_top(); }
+
+    void set_to_bottom() override { m_sep_dom.set_to_bottom(); }
+
+    void set_to_top() override { m_sep_dom.set_to_top(); }
+
+    void forget(const Var& x) override { m_sep_dom.forget(x); }
+
+    void join_with(const ZIntervalCongruenceDom& other) {
+        m_sep_dom.join_with(other.m_sep_dom);
+    }
+
+    [[nodiscard]] bool join_with_changed(const ZIntervalCongruenceDom& other) {
+        return m_sep_dom.join_with_changed(other.m_sep_dom);
+    }
+
+    void join_with_at_loop_head(const ZIntervalCongruenceDom& other) {
+        m_sep_dom.join_with_at_loop_head(other.m_sep_dom);
+    }
+
+    void join_consecutive_iter_with(const ZIntervalCongruenceDom& other) {
+        m_sep_dom.join_consecutive_iter_with(other.m_sep_dom);
+    }
+
+    void widen_with(const ZIntervalCongruenceDom& other) {
+        m_sep_dom.widen_with(other.m_sep_dom);
+    }
+
+    [[nodiscard]] bool widen_with_changed(const ZIntervalCongruenceDom& other) {
+        return m_sep_dom.widen_with_changed(other.m_sep_dom);
+    }
+
+    void meet_with(const ZIntervalCongruenceDom& other) {
+        m_sep_dom.meet_with(other.m_sep_dom);
+    }
+
+    void meet_value(const Var& x, const ZInterval& itv) {
+        m_sep_dom.meet_value(x, ZIntervalCongruence(itv));
+    }
+
+    void meet_value(const Var& x, const ZIntervalCongruence& value) {
+        m_sep_dom.meet_value(x, value);
+    }
+
+    void narrow_with(const ZIntervalCongruenceDom& other) {
+        m_sep_dom.narrow_with(other.m_sep_dom);
+    }
+
+    [[nodiscard]] bool narrow_with_changed(
+        const ZIntervalCongruenceDom& other) {
+        return m_sep_dom.narrow_with_changed(other.m_sep_dom);
+    }
+
+    bool leq(const ZIntervalCongruenceDom& other) const {
+        return m_sep_dom.leq(other.m_sep_dom);
+    }
+
+    bool equals(const ZIntervalCongruenceDom& other) const {
+        return m_sep_dom.equals(other.m_sep_dom);
+    }
+
+    ZIntervalCongruence get_value(const Var& key) const {
+        return m_sep_dom.get_value(key);
+    }
+
+    void set_value(const Var& key, const ZIntervalCongruence& value) {
+        return m_sep_dom.set_value(key, value);
+    }
+
+    void dump(llvm::raw_ostream& os) const override { m_sep_dom.dump(os); }
+
+  public:
+    void widen_with_threshold(const ZIntervalCongruenceDom& other,
+                              llvm::ArrayRef< ZNum > thresholds) {
+        m_sep_dom.widen_with_threshold(other.m_sep_dom, thresholds);
+    }
+
+    void narrow_with_threshold(const ZIntervalCongruenceDom& other,
+                               llvm::ArrayRef< ZNum > thresholds) {
+        m_sep_dom.narrow_with_threshold(other.m_sep_dom, thresholds);
+    }
+
+    void assign_num(const Var& x, const ZNum& n) override {
+        m_sep_dom.assign_num(x, n);
+    }
+
+    void assign_var(const Var& x, const Var& y) override {
+        m_sep_dom.assign_var(x, y);
+    }
+
+    void assign_linear_expr(const Var& x, const LinearExprT& e) override {
+        m_sep_dom.assign_linear_expr(x, e);
+    }
+
+    void assign_binary_var_var(clang::BinaryOperatorKind op,
+                               const Var& x,
+                               const Var& y,
+                               const Var& z) override;
+
+    void assign_binary_var_num(clang::BinaryOperatorKind op,
+                               const Var& x,
+                               const Var& y,
+                               const ZNum& z) override;
+
+    void assign_cast(clang::QualType dst_type,
+                     unsigned dst_bit_width,
+                     const Var& x,
+                     const Var& y) override {
+        m_sep_dom.assign_cast(dst_type, dst_bit_width, x, y);
+    }
+
+    ZInterval to_interval(const Var& x) const override {
+        return m_sep_dom.get_value(x).reduced().get_interval();
+    }
+
+    void apply_linear_constraint(const LinearConstraintT& cst) override;
+
+    void merge_with_linear_constraint_system(
+        const LinearConstraintSystemT& csts) override;
+
+    [[nodiscard]] LinearConstraintSystemT to_linear_constraint_system()
+        const override;
+
+  private:
+    /// \brief Refine the congruences of the variables of the equality `cst`.
+    void refine_congruences(const LinearConstraintT& cst);
+
+    /// \brief Set `x` to the truth value of the comparison `cst`.
+    void assign_comparison(const Var& x, const LinearConstraintT& cst);
+
+}; // class ZIntervalCongruenceDom
+
+inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                                     const ZIntervalCongruenceDom& dom) {
+    dom.dump(os);
+    return os;
+}
+
+} // namespace knight::analyzer
@@ -55,7 +55,7 @@ class IntervalDom
         : m_sep_dom(SeparateNumericalDomT(is_bottom, table)) {}
 
   public:
-    [[nodiscard]] static DomainKind get_kind() { return Kind; }
+    [[nodiscard]] static constexpr DomainKind get_kind() { return Kind; }
     [[nodiscard]] static SharedVal default_val() {
         return std::static_pointer_cast< AbsDomBase >(
             std::make_shared< IntervalDom >(false, Map{}));
@@ -66,11 +66,15 @@ class IntervalDom
     }
 
     [[nodiscard]] AbsDomBase* clone() const override {
-        return new IntervalDom(m_sep_dom.is_bottom(), m_sep_dom.clone_table());
+        return new IntervalDom(*this);
     }
 
     void normalize() override { m_sep_dom.normalize(); }
 
+    [[nodiscard]] bool is_normalized() const override {
+        return m_sep_dom.is_normalized();
+    }
+
     [[nodiscard]] bool is_bottom() const override {
         return m_sep_dom.is_bottom();
     }
@@ -87,6 +91,10 @@ class IntervalDom
         m_sep_dom.join_with(other.m_sep_dom);
     }
 
+    [[nodiscard]] bool join_with_changed(const IntervalDomT& other) {
+        return m_sep_dom.join_with_changed(other.m_sep_dom);
+    }
+
     void join_with_at_loop_head(const IntervalDomT& other) {
         m_sep_dom.join_with_at_loop_head(other.m_sep_dom);
     }
@@ -99,6 +107,10 @@ class IntervalDom
         m_sep_dom.widen_with(other.m_sep_dom);
     }
 
+    [[nodiscard]] bool widen_with_changed(const IntervalDomT& other) {
+        return m_sep_dom.widen_with_changed(other.m_sep_dom);
+    }
+
     void meet_with(const IntervalDomT& other) {
         m_sep_dom.meet_with(other.m_sep_dom);
     }
@@ -111,6 +123,10 @@ class IntervalDom
         m_sep_dom.narrow_with(other.m_sep_dom);
     }
 
+    [[nodiscard]] bool narrow_with_changed(const IntervalDomT& other) {
+        return m_sep_dom.narrow_with_changed(other.m_sep_dom);
+    }
+
     bool leq(const IntervalDomT& other) const {
         return m_sep_dom.leq(other.m_sep_dom);
     }
@@ -130,13 +146,14 @@ class IntervalDom
     void dump(llvm::raw_ostream& os) const override { m_sep_dom.dump(os); }
 
   public:
-    void widen_with_threshold(const IntervalDomT& other, const Num& threshold) {
-        m_sep_dom.widen_with_threshold(other.m_sep_dom, threshold);
+    void widen_with_threshold(const IntervalDomT& other,
+                              llvm::ArrayRef< Num > thresholds) {
+        m_sep_dom.widen_with_threshold(other.m_sep_dom, thresholds);
     }
 
     void narrow_with_threshold(const IntervalDomT& other,
-                               const Num& threshold) {
-        m_sep_dom.narrow_with_threshold(other.m_sep_dom, threshold);
+                               llvm::ArrayRef< Num > thresholds) {
+        m_sep_dom.narrow_with_threshold(other.m_sep_dom, thresholds);
     }
 
     void assign_num(const Var& x, const Num& n) override {
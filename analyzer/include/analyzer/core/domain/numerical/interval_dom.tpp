@@ -16,6 +16,11 @@
 #include "analyzer/core/domain/numerical/interval_dom.hpp"
 #include "common/util/log.hpp"
 
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <deque>
+
 #ifdef DEBUG_TYPE
 #    define DEBUG_TYPE_BACKUP DEBUG_TYPE
 #    undef DEBUG_TYPE
@@ -133,6 +138,7 @@ IntervalDom< Num, Kind, SepKind >::to_linear_constraint_system() const {
 
 namespace impl {
 
+/// \brief The default refinement budget, in rounds over the whole system.
 constexpr std::size_t MaxCycles = 10U;
 constexpr std::size_t LargeSystemCstThreshold = 3;
 constexpr std::size_t LargeSystemOpThreshold = 27;
@@ -155,13 +161,18 @@ class IntervalSolver {
         std::reference_wrapper< const LinearConstraintSystemT >;
 
     using LinearConstraintSet = std::vector< LinearConstraintRef >;
-    using TriggerTable = llvm::DenseMap< Var, LinearConstraintSet >;
+    using ConstraintIndex = unsigned;
+
+    /// \brief The constraints each variable occurs in.
+    using TriggerTable =
+        llvm::DenseMap< Var, llvm::SmallVector< ConstraintIndex, 4U > >;
 
   private:
     VarSet m_refined_vars;
     LinearConstraintSet m_csts;
     TriggerTable m_trigger_table;
 
+    std::size_t m_max_cycles;
     std::size_t m_op_cnt = 0U;
     std::size_t m_op_per_cycle = 0U;
     std::size_t m_max_op = 0U;
@@ -170,7 +181,10 @@ class IntervalSolver {
     bool m_is_large_system = false;
 
   public:
-    IntervalSolver() = default;
+    /// \param max_cycles the refinement budget, as the number of rounds
+    /// over the whole system the solver may spend.
+    explicit IntervalSolver(std::size_t max_cycles = MaxCycles)
+        : m_max_cycles(max_cycles) {}
 
   public:
     /// \brief Add a constraint
@@ -204,6 +218,12 @@ class IntervalSolver {
 
     void build_trigger_table();
 
+    /// \brief Propagate the constraints from a worklist.
+    ///
+    /// Only the constraints over a variable refined since their last visit
+    /// are queued again, until the worklist is empty or the budget runs
+    /// out.
+    ///
     /// \return true if the value is bottom, false otherwise
     [[nodiscard]] bool solve_large_system(NumericalDom& numerical);
 
@@ -256,7 +276,7 @@ void IntervalSolver< Num, NumericalDom >::run(NumericalDom& numerical) {
         return;
     }
 
-    this->m_max_op = this->m_op_per_cycle * MaxCycles;
+    this->m_max_op = this->m_op_per_cycle * this->m_max_cycles;
 
     this->m_is_large_system = this->m_csts.size() > LargeSystemCstThreshold ||
                               this->m_op_per_cycle > LargeSystemOpThreshold;
@@ -324,20 +344,20 @@ bool IntervalSolver< Num, NumericalDom >::propagate(
         IntervalT rhs =
             compute_residual(cst, pivot, numerical) / IntervalT(coeff);
         if (cst.is_equality()) {
-            return this->refine_to_numerical(pivot, rhs, numerical);
+            if (this->refine_to_numerical(pivot, rhs, numerical)) {
+                return true;
+            }
+            continue;
         }
 
         if (cst.is_inequality()) {
-            if (coeff > 0) {
-                return this->refine_to_numerical(pivot,
-                                                 IntervalT(BoundT::ninf(),
-                                                           rhs.get_ub()),
-                                                 numerical);
+            IntervalT itv = coeff > 0
+                                ? IntervalT(BoundT::ninf(), rhs.get_ub())
+                                : IntervalT(rhs.get_lb(), BoundT::pinf());
+            if (this->refine_to_numerical(pivot, itv, numerical)) {
+                return true;
             }
-            return this->refine_to_numerical(pivot,
-                                             IntervalT(rhs.get_lb(),
-                                                       BoundT::pinf()),
-                                             numerical);
+            continue;
         }
         // cst as disequation
         auto k = rhs.get_singleton_opt();
@@ -359,9 +379,10 @@ bool IntervalSolver< Num, NumericalDom >::propagate(
 
 template < typename Num, typename NumericalDom >
 void IntervalSolver< Num, NumericalDom >::build_trigger_table() {
-    for (LinearConstraintRef cst : this->m_csts) {
-        for (const auto& [var, _] : cst.get().get_variable_terms()) {
-            this->m_trigger_table[var].push_back(cst);
+    for (ConstraintIndex idx = 0U; idx < this->m_csts.size(); ++idx) {
+        const LinearConstraintT& cst = this->m_csts[idx];
+        for (const auto& [var, _] : cst.get_variable_terms()) {
+            this->m_trigger_table[var].push_back(idx);
         }
     }
 }
@@ -370,23 +391,31 @@ template < typename Num, typename NumericalDom >
 bool IntervalSolver< Num, NumericalDom >::solve_large_system(
     NumericalDom& numerical) {
     this->m_op_cnt = 0;
-    VarSet().swap(m_refined_vars);
-    for (const LinearConstraintT& cst : this->m_csts) {
-        if (this->propagate(cst, numerical)) {
+    std::deque< ConstraintIndex > worklist;
+    llvm::BitVector in_worklist(static_cast< unsigned >(this->m_csts.size()),
+                                true);
+    for (ConstraintIndex idx = 0U; idx < this->m_csts.size(); ++idx) {
+        worklist.push_back(idx);
+    }
+
+    while (!worklist.empty() && this->m_op_cnt <= this->m_max_op) {
+        ConstraintIndex idx = worklist.front();
+        worklist.pop_front();
+        in_worklist.reset(idx);
+
+        this->m_refined_vars.clear();
+        if (this->propagate(this->m_csts[idx], numerical)) {
             return true;
         }
-    }
-    do {
-        VarSet vars_to_process(this->m_refined_vars);
-        VarSet().swap(m_refined_vars);
-        for (Var var : vars_to_process) {
-            for (const LinearConstraintT& cst : this->m_trigger_table[var]) {
-                if (this->propagate(cst, numerical)) {
-                    return true;
+        for (const Var& var : this->m_refined_vars) {
+            for (ConstraintIndex triggered : this->m_trigger_table[var]) {
+                if (!in_worklist.test(triggered)) {
+                    in_worklist.set(triggered);
+                    worklist.push_back(triggered);
                 }
             }
         }
-    } while (!this->m_refined_vars.empty() && this->m_op_cnt <= this->m_max_op);
+    }
 
     return false;
 }
@@ -403,7 +432,7 @@ bool IntervalSolver< Num, NumericalDom >::solve_small_system(
                 return true;
             }
         }
-    } while (!this->m_refined_vars.empty() && cycle <= MaxCycles);
+    } while (!this->m_refined_vars.empty() && cycle <= this->m_max_cycles);
 
     return false;
 }
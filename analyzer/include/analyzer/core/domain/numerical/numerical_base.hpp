@@ -16,6 +16,8 @@
 #include "analyzer/core/constraint/linear.hpp"
 #include "analyzer/core/domain/dom_base.hpp"
 #include "analyzer/core/domain/interval.hpp"
+#include "analyzer/tooling/mem_report.hpp"
+#include "analyzer/tooling/stats.hpp"
 
 #include <clang/AST/Expr.h>
 #include <clang/AST/OperationKinds.h>
@@ -34,13 +36,13 @@ struct NumericalDomBase : AbsDomBase {
 
     ~NumericalDomBase() override = default;
 
-    /// \brief Widen with a threshold num
+    /// \brief Widen with sorted threshold nums
     virtual void widen_with_threshold(const NumericalDomBase& other,
-                                      const Num& threshold) = 0;
+                                      llvm::ArrayRef< Num > thresholds) = 0;
 
-    /// \brief Narrow with a threshold num
+    /// \brief Narrow with sorted threshold nums
     virtual void narrow_with_threshold(const NumericalDomBase& other,
-                                       const Num& threshold) = 0;
+                                       llvm::ArrayRef< Num > thresholds) = 0;
 
     /// \brief Assign `x = n`
     virtual void assign_num(const Var& x, const Num& n) = 0;
@@ -160,8 +162,8 @@ struct NumericalDomBase : AbsDomBase {
 /// Base for all numerical domains. (Linear for currently);
 /// Except for the `AbsDom` requirements for `Derived` domain,
 /// it should also implement the following *required* methods:
-/// - `widen_with_threshold(const Derived&, const Num&)`
-/// - `narrow_with_threshold(const Derived&, const Num&)`
+/// - `widen_with_threshold(const Derived&, llvm::ArrayRef< Num >)`
+/// - `narrow_with_threshold(const Derived&, llvm::ArrayRef< Num >)`
 /// - `assign_num(const Var &, const Num &)`
 /// - `assign_var(const Var &, const Var &)`
 /// - `assign_linear_expr(const Var &, const LinearExpr&)`
@@ -182,19 +184,41 @@ class NumericalDom : public NumericalDomBase< Num > {
     using LinearConstraintSystemT = LinearConstraintSystem< Num >;
     using Var = Variable< Num >;
 
+    /// \brief The class implementing the lattice operations of `Derived`,
+    /// which are `final` so that they can be called without the vtable.
+    using DomWrapper = NumericalDom< Derived, Num >;
+
   public:
-    NumericalDom() : NumericalDomBaseT(Derived::get_kind()) {}
+    /// \brief The values are accounted in the memory report by their size.
+    /// @{
+    NumericalDom() : NumericalDomBaseT(Derived::get_kind()) {
+        MemReport::add_domain_value(sizeof(Derived));
+    }
+    NumericalDom(const NumericalDom& other) : NumericalDomBaseT(other) {
+        MemReport::add_domain_value(sizeof(Derived));
+    }
+    NumericalDom(NumericalDom&& other) noexcept : NumericalDomBaseT(other) {
+        MemReport::add_domain_value(sizeof(Derived));
+    }
+    NumericalDom& operator=(const NumericalDom&) = default;
+    NumericalDom& operator=(NumericalDom&&) noexcept = default;
+    ~NumericalDom() override {
+        MemReport::remove_domain_value(sizeof(Derived));
+    }
+    /// @}
 
-    void join_with(const AbsDomBase& other) override {
+    void join_with(const AbsDomBase& other) final {
         static_assert(does_derived_dom_can_join_with< Derived >::value,
                       "derived domain needs to implement `join_with` method");
+        Stats::count(Derived::get_kind(), DomainOpKind::Join);
         static_cast< Derived* >(this)->join_with(
             static_cast< const Derived& >(other));
     }
 
-    void join_with_at_loop_head(const AbsDomBase& other) override {
+    void join_with_at_loop_head(const AbsDomBase& other) final {
         if constexpr (does_derived_dom_can_join_with_at_loop_head<
                           Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Join);
             static_cast< Derived* >(this)->join_with_at_loop_head(
                 static_cast< const Derived& >(other));
         } else {
@@ -202,9 +226,10 @@ class NumericalDom : public NumericalDomBase< Num > {
         }
     }
 
-    void join_consecutive_iter_with(const AbsDomBase& other) override {
+    void join_consecutive_iter_with(const AbsDomBase& other) final {
         if constexpr (does_derived_dom_can_join_consecutive_iter_with<
                           Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Join);
             static_cast< Derived* >(this)->join_consecutive_iter_with(
                 static_cast< const Derived& >(other));
         } else {
@@ -212,7 +237,8 @@ class NumericalDom : public NumericalDomBase< Num > {
         }
     }
 
-    void widen_with(const AbsDomBase& other) override {
+    void widen_with(const AbsDomBase& other) final {
+        Stats::count(Derived::get_kind(), DomainOpKind::Widen);
         if constexpr (does_derived_dom_can_widen_with< Derived >::value) {
             static_cast< Derived* >(this)->widen_with(
                 static_cast< const Derived& >(other));
@@ -221,7 +247,7 @@ class NumericalDom : public NumericalDomBase< Num > {
         }
     }
 
-    void meet_with(const AbsDomBase& other) override {
+    void meet_with(const AbsDomBase& other) final {
         if constexpr (does_derived_dom_can_meet_with< Derived >::value) {
             static_cast< Derived* >(this)->meet_with(
                 static_cast< const Derived& >(other));
@@ -230,7 +256,8 @@ class NumericalDom : public NumericalDomBase< Num > {
         }
     }
 
-    void narrow_with(const AbsDomBase& other) override {
+    void narrow_with(const AbsDomBase& other) final {
+        Stats::count(Derived::get_kind(), DomainOpKind::Narrow);
         if constexpr (does_derived_dom_can_narrow_with< Derived >::value) {
             static_cast< Derived* >(this)->narrow_with(
                 static_cast< const Derived& >(other));
@@ -239,14 +266,47 @@ class NumericalDom : public NumericalDomBase< Num > {
         }
     }
 
-    [[nodiscard]] bool leq(const AbsDomBase& other) const override {
+    [[nodiscard]] bool join_with_changed(const AbsDomBase& other) final {
+        if constexpr (does_derived_dom_can_join_with_changed<
+                          Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Join);
+            return static_cast< Derived* >(this)->join_with_changed(
+                static_cast< const Derived& >(other));
+        } else {
+            return AbsDomBase::join_with_changed(other);
+        }
+    }
+
+    [[nodiscard]] bool widen_with_changed(const AbsDomBase& other) final {
+        if constexpr (does_derived_dom_can_widen_with_changed<
+                          Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Widen);
+            return static_cast< Derived* >(this)->widen_with_changed(
+                static_cast< const Derived& >(other));
+        } else {
+            return AbsDomBase::widen_with_changed(other);
+        }
+    }
+
+    [[nodiscard]] bool narrow_with_changed(const AbsDomBase& other) final {
+        if constexpr (does_derived_dom_can_narrow_with_changed<
+                          Derived >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Narrow);
+            return static_cast< Derived* >(this)->narrow_with_changed(
+                static_cast< const Derived& >(other));
+        } else {
+            return AbsDomBase::narrow_with_changed(other);
+        }
+    }
+
+    [[nodiscard]] bool leq(const AbsDomBase& other) const final {
         static_assert(does_derived_dom_can_leq< Derived >::value,
                       "derived domain needs to implement `leq` method");
         return static_cast< const Derived& >(*this).leq(
             static_cast< const Derived& >(other));
     }
 
-    [[nodiscard]] bool equals(const AbsDomBase& other) const override {
+    [[nodiscard]] bool equals(const AbsDomBase& other) const final {
         if constexpr (does_derived_dom_can_equals< Derived >::value) {
             return static_cast< const Derived& >(*this).equals(
                 static_cast< const Derived& >(other));
@@ -255,29 +315,31 @@ class NumericalDom : public NumericalDomBase< Num > {
         }
     }
 
-    /// \brief Widen with a threshold num
+    /// \brief Widen with sorted threshold nums
     void widen_with_threshold(const NumericalDomBaseT& other,
-                              const Num& threshold) override {
+                              llvm::ArrayRef< Num > thresholds) final {
         if constexpr (does_derived_numerical_dom_can_widen_with_threshold<
                           Derived,
                           Num >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Widen);
             static_cast< Derived* >(this)
                 ->widen_with_threshold(static_cast< const Derived& >(other),
-                                       threshold);
+                                       thresholds);
         } else {
             widen_with(other);
         }
     }
 
-    /// \brief Narrow with a threshold num
+    /// \brief Narrow with sorted threshold nums
     void narrow_with_threshold(const NumericalDomBaseT& other,
-                               const Num& threshold) override {
+                               llvm::ArrayRef< Num > thresholds) final {
         if constexpr (does_derived_numerical_dom_can_narrow_with_threshold<
                           Derived,
                           Num >::value) {
+            Stats::count(Derived::get_kind(), DomainOpKind::Narrow);
             static_cast< Derived* >(this)
                 ->narrow_with_threshold(static_cast< const Derived& >(other),
-                                        threshold);
+                                        thresholds);
         } else {
             narrow_with(other);
         }
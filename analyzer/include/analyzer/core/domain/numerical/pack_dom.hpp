@@ -0,0 +1,252 @@
+//===- pack_dom.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the variable packing domain.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/core/domain/numerical/dbm_dom.hpp"
+#include "analyzer/core/domain/numerical/interval_dom.hpp"
+#include "analyzer/core/domain/numerical/numerical_base.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+
+namespace knight::analyzer {
+
+/// \brief The maximum number of variables in one relational pack.
+///
+/// Beyond it, the transfer functions fall back to the non-relational
+/// semantics instead of merging the packs.
+constexpr std::size_t MaxPackSize = 32U;
+
+/// \brief Decompose a relational domain into packs of related variables.
+///
+/// Variables co-occurring in a relational assignment or constraint are
+/// merged into one pack, which owns a small `RelDom` value. All the other
+/// variables live in `SingletonDom`, an `IntervalDom` over the separate
+/// numerical domain, so that the relational cost only grows with the size
+/// of the packs rather than with the whole function.
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+class PackDom
+    : public NumericalDom< PackDom< Num, Kind, RelDom, SingletonDom >, Num > {
+  public:
+    using Base = NumericalDom< PackDom< Num, Kind, RelDom, SingletonDom >,
+                               Num >;
+    using PackDomT = PackDom< Num, Kind, RelDom, SingletonDom >;
+    using Var = Variable< Num >;
+    using IntervalT = Interval< Num >;
+    using LinearExprT = LinearExpr< Num >;
+    using LinearConstraintT = LinearConstraint< Num >;
+    using LinearConstraintSystemT = LinearConstraintSystem< Num >;
+    using Solver = impl::IntervalSolver< Num, PackDomT >;
+    using PackID = unsigned;
+
+    struct Pack {
+        RelDom dom{false};
+        llvm::SmallVector< Var, 4U > vars;
+    }; // struct Pack
+
+  private:
+    bool m_is_bottom;
+    SingletonDom m_singletons{false};
+    llvm::DenseMap< Var, PackID > m_pack_of;
+    std::map< PackID, Pack > m_packs;
+    PackID m_next_pack_id = 0U;
+
+  public:
+    explicit PackDom(bool is_bottom)
+        : m_is_bottom(is_bottom), m_singletons(is_bottom) {}
+
+  public:
+    [[nodiscard]] static constexpr DomainKind get_kind() { return Kind; }
+    [[nodiscard]] static SharedVal default_val() {
+        return std::static_pointer_cast< AbsDomBase >(
+            std::make_shared< PackDom >(false));
+    }
+    [[nodiscard]] static SharedVal bottom_val() {
+        return std::static_pointer_cast< AbsDomBase >(
+            std::make_shared< PackDom >(true));
+    }
+
+    [[nodiscard]] AbsDomBase* clone() const override {
+        return new PackDom(*this);
+    }
+
+    void normalize() override;
+
+    [[nodiscard]] bool is_normalized() const override {
+        return m_is_bottom ||
+               (m_singletons.is_normalized() &&
+                llvm::all_of(m_packs, [](const auto& id_pack) {
+                    return id_pack.second.dom.is_normalized();
+                }));
+    }
+
+    [[nodiscard]] bool is_bottom() const override { return m_is_bottom; }
+
+    [[nodiscard]] bool is_top() const override {
+        return !m_is_bottom && m_packs.empty() && m_singletons.is_top();
+    }
+
+    void set_to_bottom() override {
+        reset();
+        m_is_bottom = true;
+        m_singletons.set_to_bottom();
+    }
+
+    void set_to_top() override {
+        reset();
+        m_is_bottom = false;
+        m_singletons.set_to_top();
+    }
+
+    void forget(const Var& x) override;
+
+    void join_with(const PackDomT& other);
+
+    void widen_with(const PackDomT& other);
+
+    void meet_with(const PackDomT& other);
+
+    void narrow_with(const PackDomT& other);
+
+    [[nodiscard]] bool leq(const PackDomT& other) const;
+
+    [[nodiscard]] bool equals(const PackDomT& other) const;
+
+    /// \brief Refine the bounds of `x` with `itv`, used by the solver.
+    void meet_value(const Var& x, const IntervalT& itv);
+
+    void dump(llvm::raw_ostream& os) const override;
+
+  public:
+    void widen_with_threshold(const PackDomT& other,
+                              llvm::ArrayRef< Num > thresholds);
+
+    void narrow_with_threshold(const PackDomT& other,
+                               llvm::ArrayRef< Num > thresholds);
+
+    void assign_num(const Var& x, const Num& n) override {
+        transfer(x, {}, false, [&](auto& dom) { dom.assign_num(x, n); });
+    }
+
+    void assign_var(const Var& x, const Var& y) override {
+        transfer(x, {y}, true, [&](auto& dom) { dom.assign_var(x, y); });
+    }
+
+    void assign_linear_expr(const Var& x, const LinearExprT& e) override;
+
+    void assign_binary_var_var(clang::BinaryOperatorKind op,
+                               const Var& x,
+                               const Var& y,
+                               const Var& z) override;
+
+    void assign_binary_var_num(clang::BinaryOperatorKind op,
+                               const Var& x,
+                               const Var& y,
+                               const Num& z) override;
+
+    void assign_cast(clang::QualType dst_type,
+                     unsigned dst_bit_width,
+                     const Var& x,
+                     const Var& y) override {
+        transfer(x, {y}, true, [&](auto& dom) {
+            dom.assign_cast(dst_type, dst_bit_width, x, y);
+        });
+    }
+
+    [[nodiscard]] IntervalT to_interval(const Var& x) const override;
+
+    void apply_linear_constraint(const LinearConstraintT& cst) override;
+
+    void merge_with_linear_constraint_system(
+        const LinearConstraintSystemT& csts) override;
+
+    [[nodiscard]] LinearConstraintSystemT to_linear_constraint_system()
+        const override;
+
+  private:
+    void reset();
+
+    [[nodiscard]] const Pack* get_pack(const Var& x) const;
+
+    [[nodiscard]] Pack* get_pack(const Var& x);
+
+    [[nodiscard]] bool in_same_pack(llvm::ArrayRef< Var > vars) const;
+
+    [[nodiscard]] bool is_same_partition(const PackDomT& other) const;
+
+    /// \brief Merge the packs of `vars` into one.
+    ///
+    /// \return true if all the variables share one pack afterwards, false
+    /// if there are fewer than two of them or the pack would exceed
+    /// `MaxPackSize` while `bounded`.
+    bool unify(llvm::ArrayRef< Var > vars, bool bounded);
+
+    /// \brief Coarsen the partitions of `a` and `b` until they are equal.
+    static void align(PackDomT& a, PackDomT& b);
+
+    /// \brief Apply `op` on the aligned packs and singletons of `this`
+    /// and `other`.
+    template < typename PackOp, typename SingletonOp >
+    void apply_pointwise(const PackDomT& other,
+                         PackOp pack_op,
+                         SingletonOp singleton_op);
+
+    /// \brief Apply a transfer function assigning `x` from `operands`.
+    ///
+    /// Relational transfers run in the pack of `x` and `operands`, the
+    /// other ones run on the intervals of the operands.
+    template < typename Op >
+    void transfer(const Var& x,
+                  llvm::ArrayRef< Var > operands,
+                  bool is_relational,
+                  Op op);
+
+    void check_bottom(const AbsDomBase& dom) {
+        if (dom.is_bottom()) {
+            set_to_bottom();
+        }
+    }
+
+}; // class PackDom
+
+using ZPackDBMDom =
+    PackDom< ZNum, DomainKind::ZPackDBMDomain, ZDBMDom, ZIntervalDom >;
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+inline llvm::raw_ostream& operator<<(
+    llvm::raw_ostream& os,
+    const PackDom< Num, Kind, RelDom, SingletonDom >& dom) {
+    dom.dump(os);
+    return os;
+}
+
+} // namespace knight::analyzer
+
+#include "pack_dom.tpp"
@@ -0,0 +1,691 @@
+//===- pack_dom.tpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header implements the variable packing domain.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/numerical/pack_dom.hpp"
+#include "common/util/log.hpp"
+
+#ifdef DEBUG_TYPE
+#    define DEBUG_TYPE_BACKUP DEBUG_TYPE
+#    undef DEBUG_TYPE
+#endif
+
+#define DEBUG_TYPE "pack-dom"
+
+namespace knight::analyzer {
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::reset() {
+    m_pack_of.clear();
+    m_packs.clear();
+    m_next_pack_id = 0U;
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+const typename PackDom< Num, Kind, RelDom, SingletonDom >::Pack* PackDom<
+    Num,
+    Kind,
+    RelDom,
+    SingletonDom >::get_pack(const Var& x) const {
+    auto it = m_pack_of.find(x);
+    if (it == m_pack_of.end()) {
+        return nullptr;
+    }
+    return &m_packs.at(it->second);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+typename PackDom< Num, Kind, RelDom, SingletonDom >::Pack* PackDom<
+    Num,
+    Kind,
+    RelDom,
+    SingletonDom >::get_pack(const Var& x) {
+    auto it = m_pack_of.find(x);
+    if (it == m_pack_of.end()) {
+        return nullptr;
+    }
+    return &m_packs.at(it->second);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+bool PackDom< Num, Kind, RelDom, SingletonDom >::in_same_pack(
+    llvm::ArrayRef< Var > vars) const {
+    std::optional< PackID > id;
+    for (const Var& var : vars) {
+        auto it = m_pack_of.find(var);
+        if (it == m_pack_of.end() || (id && *id != it->second)) {
+            return false;
+        }
+        id = it->second;
+    }
+    return true;
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+bool PackDom< Num, Kind, RelDom, SingletonDom >::is_same_partition(
+    const PackDomT& other) const {
+    if (m_pack_of.size() != other.m_pack_of.size() ||
+        m_packs.size() != other.m_packs.size()) {
+        return false;
+    }
+    return llvm::all_of(m_packs, [&other](const auto& id_pack) {
+        return other.in_same_pack(id_pack.second.vars);
+    });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+bool PackDom< Num, Kind, RelDom, SingletonDom >::unify(
+    llvm::ArrayRef< Var > vars, bool bounded) {
+    llvm::SmallVector< PackID, 4U > ids;
+    llvm::SmallVector< Var, 4U > singletons;
+    std::size_t size = 0U;
+    for (const Var& var : vars) {
+        auto it = m_pack_of.find(var);
+        if (it != m_pack_of.end()) {
+            if (!llvm::is_contained(ids, it->second)) {
+                ids.push_back(it->second);
+                size += m_packs.at(it->second).vars.size();
+            }
+        } else if (llvm::none_of(singletons, [&var](const Var& v) {
+                       return v.equals(var);
+                   })) {
+            singletons.push_back(var);
+            ++size;
+        }
+    }
+    if (size < 2U) {
+        return false;
+    }
+    if (ids.size() == 1U && singletons.empty()) {
+        return true;
+    }
+    if (bounded && size > MaxPackSize) {
+        return false;
+    }
+
+    // Merge into the largest pack, the variables of the merged packs are
+    // disjoint so the meet is their conjunction.
+    PackID target_id = m_next_pack_id;
+    if (ids.empty()) {
+        m_packs.try_emplace(m_next_pack_id++);
+    } else {
+        target_id =
+            *std::max_element(ids.begin(),
+                              ids.end(),
+                              [this](PackID a, PackID b) {
+                                  return m_packs.at(a).vars.size() <
+                                         m_packs.at(b).vars.size();
+                              });
+    }
+    Pack& target = m_packs.at(target_id);
+    for (PackID id : ids) {
+        if (id == target_id) {
+            continue;
+        }
+        Pack& pack = m_packs.at(id);
+        target.dom.meet_with(pack.dom);
+        for (const Var& var : pack.vars) {
+            target.vars.push_back(var);
+            m_pack_of[var] = target_id;
+        }
+        m_packs.erase(id);
+    }
+    for (const Var& var : singletons) {
+        IntervalT itv = m_singletons.to_interval(var);
+        m_singletons.forget(var);
+        if (!itv.is_top()) {
+            target.dom.merge_with_linear_constraint_system(
+                m_singletons.within_interval(var, itv));
+        }
+        target.vars.push_back(var);
+        m_pack_of[var] = target_id;
+    }
+    check_bottom(target.dom);
+    return true;
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::align(PackDomT& a,
+                                                       PackDomT& b) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& [_, pack] : a.m_packs) {
+            if (!b.in_same_pack(pack.vars)) {
+                (void)b.unify(pack.vars, false);
+                changed = true;
+            }
+        }
+        for (const auto& [_, pack] : b.m_packs) {
+            if (!a.in_same_pack(pack.vars)) {
+                (void)a.unify(pack.vars, false);
+                changed = true;
+            }
+        }
+    }
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+template < typename PackOp, typename SingletonOp >
+void PackDom< Num, Kind, RelDom, SingletonDom >::apply_pointwise(
+    const PackDomT& other, PackOp pack_op, SingletonOp singleton_op) {
+    auto apply = [&](const PackDomT& aligned) {
+        for (auto& [_, pack] : m_packs) {
+            pack_op(pack.dom, aligned.get_pack(pack.vars.front())->dom);
+        }
+        singleton_op(m_singletons, aligned.m_singletons);
+    };
+    if (is_same_partition(other)) {
+        apply(other);
+    } else {
+        PackDomT aligned = other;
+        align(*this, aligned);
+        apply(aligned);
+    }
+    if (m_singletons.is_bottom() ||
+        llvm::any_of(m_packs, [](const auto& id_pack) {
+            return id_pack.second.dom.is_bottom();
+        })) {
+        set_to_bottom();
+    }
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+template < typename Op >
+void PackDom< Num, Kind, RelDom, SingletonDom >::transfer(
+    const Var& x, llvm::ArrayRef< Var > operands, bool is_relational, Op op) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (is_relational) {
+        // The old relations of `x` are killed anyway, so do not let them
+        // drag the pack of `x` into the pack of the operands.
+        if (llvm::none_of(operands, [&x](const Var& y) {
+                return y.equals(x);
+            })) {
+            forget(x);
+        }
+        llvm::SmallVector< Var, 4U > vars{x};
+        vars.append(operands.begin(), operands.end());
+        if (unify(vars, true)) {
+            Pack* pack = get_pack(x);
+            op(pack->dom);
+            check_bottom(pack->dom);
+            return;
+        }
+        if (m_is_bottom) {
+            return;
+        }
+    }
+
+    auto is_var_packed = [this](const Var& y) {
+        return m_pack_of.count(y) != 0U;
+    };
+    const bool is_packed =
+        is_var_packed(x) || llvm::any_of(operands, is_var_packed);
+    if (!is_packed) {
+        op(m_singletons);
+        check_bottom(m_singletons);
+        return;
+    }
+
+    // Evaluate on the intervals of the operands, then drop `x` from its
+    // pack since it is no longer related to the others.
+    SingletonDom dom(false);
+    for (const Var& y : operands) {
+        dom.set_value(y, to_interval(y));
+    }
+    op(dom);
+    if (dom.is_bottom()) {
+        set_to_bottom();
+        return;
+    }
+    IntervalT itv = dom.to_interval(x);
+    forget(x);
+    m_singletons.set_value(x, itv);
+    check_bottom(m_singletons);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::normalize() {
+    if (m_is_bottom) {
+        return;
+    }
+    m_singletons.normalize();
+    for (auto& [_, pack] : m_packs) {
+        pack.dom.normalize();
+        check_bottom(pack.dom);
+        if (m_is_bottom) {
+            return;
+        }
+    }
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::forget(const Var& x) {
+    if (m_is_bottom) {
+        return;
+    }
+    auto it = m_pack_of.find(x);
+    if (it == m_pack_of.end()) {
+        m_singletons.forget(x);
+        return;
+    }
+    PackID id = it->second;
+    Pack& pack = m_packs.at(id);
+    m_pack_of.erase(it);
+    pack.dom.forget(x);
+    llvm::erase_if(pack.vars, [&x](const Var& v) { return v.equals(x); });
+    if (pack.vars.size() > 1U) {
+        return;
+    }
+
+    // A pack of one variable is dissolved back into the singletons.
+    if (!pack.vars.empty()) {
+        const Var& last = pack.vars.front();
+        m_singletons.set_value(last, pack.dom.to_interval(last));
+        m_pack_of.erase(last);
+    }
+    m_packs.erase(id);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::join_with(
+    const PackDomT& other) {
+    if (other.m_is_bottom) {
+        return;
+    }
+    if (m_is_bottom) {
+        *this = other;
+        return;
+    }
+    apply_pointwise(
+        other,
+        [](RelDom& dom, const RelDom& o) { dom.join_with(o); },
+        [](SingletonDom& dom, const SingletonDom& o) { dom.join_with(o); });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::widen_with(
+    const PackDomT& other) {
+    if (other.m_is_bottom) {
+        return;
+    }
+    if (m_is_bottom) {
+        *this = other;
+        return;
+    }
+    apply_pointwise(
+        other,
+        [](RelDom& dom, const RelDom& o) { dom.widen_with(o); },
+        [](SingletonDom& dom, const SingletonDom& o) { dom.widen_with(o); });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::widen_with_threshold(
+    const PackDomT& other, llvm::ArrayRef< Num > thresholds) {
+    if (other.m_is_bottom) {
+        return;
+    }
+    if (m_is_bottom) {
+        *this = other;
+        return;
+    }
+    apply_pointwise(
+        other,
+        [thresholds](RelDom& dom, const RelDom& o) {
+            dom.widen_with_threshold(o, thresholds);
+        },
+        [thresholds](SingletonDom& dom, const SingletonDom& o) {
+            dom.widen_with_threshold(o, thresholds);
+        });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::meet_with(
+    const PackDomT& other) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (other.m_is_bottom) {
+        set_to_bottom();
+        return;
+    }
+    apply_pointwise(
+        other,
+        [](RelDom& dom, const RelDom& o) { dom.meet_with(o); },
+        [](SingletonDom& dom, const SingletonDom& o) { dom.meet_with(o); });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::narrow_with(
+    const PackDomT& other) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (other.m_is_bottom) {
+        set_to_bottom();
+        return;
+    }
+    apply_pointwise(
+        other,
+        [](RelDom& dom, const RelDom& o) { dom.narrow_with(o); },
+        [](SingletonDom& dom, const SingletonDom& o) { dom.narrow_with(o); });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::narrow_with_threshold(
+    const PackDomT& other, llvm::ArrayRef< Num > thresholds) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (other.m_is_bottom) {
+        set_to_bottom();
+        return;
+    }
+    apply_pointwise(
+        other,
+        [thresholds](RelDom& dom, const RelDom& o) {
+            dom.narrow_with_threshold(o, thresholds);
+        },
+        [thresholds](SingletonDom& dom, const SingletonDom& o) {
+            dom.narrow_with_threshold(o, thresholds);
+        });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+bool PackDom< Num, Kind, RelDom, SingletonDom >::leq(
+    const PackDomT& other) const {
+    if (m_is_bottom) {
+        return true;
+    }
+    if (other.m_is_bottom) {
+        return false;
+    }
+    auto check = [](const PackDomT& lhs, const PackDomT& rhs) {
+        return lhs.m_singletons.leq(rhs.m_singletons) &&
+               llvm::all_of(lhs.m_packs, [&rhs](const auto& id_pack) {
+                   const auto& [_, pack] = id_pack;
+                   return pack.dom.leq(
+                       rhs.get_pack(pack.vars.front())->dom);
+               });
+    };
+    if (is_same_partition(other)) {
+        return check(*this, other);
+    }
+    PackDomT lhs = *this;
+    PackDomT rhs = other;
+    align(lhs, rhs);
+    return check(lhs, rhs);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+bool PackDom< Num, Kind, RelDom, SingletonDom >::equals(
+    const PackDomT& other) const {
+    if (m_is_bottom || other.m_is_bottom) {
+        return m_is_bottom == other.m_is_bottom;
+    }
+    auto check = [](const PackDomT& lhs, const PackDomT& rhs) {
+        return lhs.m_singletons.equals(rhs.m_singletons) &&
+               llvm::all_of(lhs.m_packs, [&rhs](const auto& id_pack) {
+                   const auto& [_, pack] = id_pack;
+                   return pack.dom.equals(
+                       rhs.get_pack(pack.vars.front())->dom);
+               });
+    };
+    if (is_same_partition(other)) {
+        return check(*this, other);
+    }
+    PackDomT lhs = *this;
+    PackDomT rhs = other;
+    align(lhs, rhs);
+    return check(lhs, rhs);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::meet_value(
+    const Var& x, const IntervalT& itv) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (Pack* pack = get_pack(x)) {
+        pack->dom.merge_with_linear_constraint_system(
+            m_singletons.within_interval(x, itv));
+        check_bottom(pack->dom);
+        return;
+    }
+    m_singletons.meet_value(x, itv);
+    check_bottom(m_singletons);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+typename PackDom< Num, Kind, RelDom, SingletonDom >::IntervalT PackDom<
+    Num,
+    Kind,
+    RelDom,
+    SingletonDom >::to_interval(const Var& x) const {
+    if (m_is_bottom) {
+        return IntervalT::bottom();
+    }
+    if (const Pack* pack = get_pack(x)) {
+        return pack->dom.to_interval(x);
+    }
+    return m_singletons.to_interval(x);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::assign_linear_expr(
+    const Var& x, const LinearExprT& e) {
+    llvm::SmallVector< Var, 4U > operands;
+    for (const auto& [var, _] : e.get_variable_terms()) {
+        operands.push_back(var);
+    }
+    transfer(x, operands, true, [&](auto& dom) {
+        dom.assign_linear_expr(x, e);
+    });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::assign_binary_var_var(
+    clang::BinaryOperatorKind op, const Var& x, const Var& y, const Var& z) {
+    const bool is_relational =
+        op == clang::BO_Sub || clang::BinaryOperator::isComparisonOp(op);
+    transfer(x, {y, z}, is_relational, [&](auto& dom) {
+        dom.assign_binary_var_var(op, x, y, z);
+    });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::assign_binary_var_num(
+    clang::BinaryOperatorKind op, const Var& x, const Var& y, const Num& z) {
+    const bool is_relational = op == clang::BO_Add || op == clang::BO_Sub;
+    transfer(x, {y}, is_relational, [&](auto& dom) {
+        dom.assign_binary_var_num(op, x, y, z);
+    });
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::apply_linear_constraint(
+    const LinearConstraintT& cst) {
+    if (m_is_bottom) {
+        return;
+    }
+    if (cst.is_contradiction()) {
+        set_to_bottom();
+        return;
+    }
+    if (cst.is_tautology()) {
+        return;
+    }
+
+    llvm::SmallVector< Var, 4U > vars;
+    for (const auto& [var, _] : cst.get_variable_terms()) {
+        vars.push_back(var);
+    }
+    if (vars.size() == 1U || unify(vars, true)) {
+        if (Pack* pack = get_pack(vars.front())) {
+            pack->dom.apply_linear_constraint(cst);
+            check_bottom(pack->dom);
+        } else {
+            m_singletons.apply_linear_constraint(cst);
+            check_bottom(m_singletons);
+        }
+        return;
+    }
+    if (m_is_bottom) {
+        return;
+    }
+
+    // The pack would be too large, propagate on the intervals instead.
+    Solver solver;
+    solver.add(cst);
+    solver.run(*this);
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::
+    merge_with_linear_constraint_system(const LinearConstraintSystemT& csts) {
+    for (const LinearConstraintT& cst : csts.get_linear_constraints()) {
+        apply_linear_constraint(cst);
+        if (m_is_bottom) {
+            return;
+        }
+    }
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+typename PackDom< Num, Kind, RelDom, SingletonDom >::LinearConstraintSystemT
+PackDom< Num, Kind, RelDom, SingletonDom >::to_linear_constraint_system()
+    const {
+    if (m_is_bottom) {
+        return LinearConstraintSystemT(LinearConstraintT::contradiction());
+    }
+    LinearConstraintSystemT csts = m_singletons.to_linear_constraint_system();
+    for (const auto& [_, pack] : m_packs) {
+        csts.merge_linear_constraint_system(
+            pack.dom.to_linear_constraint_system());
+    }
+    return csts;
+}
+
+template < typename Num,
+           DomainKind Kind,
+           typename RelDom,
+           typename SingletonDom >
+void PackDom< Num, Kind, RelDom, SingletonDom >::dump(
+    llvm::raw_ostream& os) const {
+    if (is_bottom()) {
+        os << "⊥";
+        return;
+    }
+    if (is_top()) {
+        os << "T";
+        return;
+    }
+    m_singletons.dump(os);
+    for (const auto& [_, pack] : m_packs) {
+        os << " ∧ ";
+        pack.dom.dump(os);
+    }
+}
+
+} // namespace knight::analyzer
+
+#ifdef DEBUG_TYPE_BACKUP
+#    define DEBUG_TYPE DEBUG_TYPE_BACKUP
+#    undef DEBUG_TYPE_BACKUP
+#else
+#    undef DEBUG_TYPE
+#endif
@@ -122,8 +122,15 @@ class PointerInfo : public AbsDom< PointerInfo > {
         m_stmt_alias = std::move(stmt_alias);
     }
 
+    /// \brief Check if the pointers held by the regions `a` and `b` may
+    /// point to a common region definition.
+    [[nodiscard]] bool may_point_to_same(RegionRef a, RegionRef b) const {
+        return m_region_point_to.get_value(a).intersects(
+            m_region_point_to.get_value(b));
+    }
+
   public:
-    [[nodiscard]] static DomainKind get_kind() {
+    [[nodiscard]] static constexpr DomainKind get_kind() {
         return DomainKind::PointerInfo;
     }
 
@@ -172,17 +179,31 @@ class PointerInfo : public AbsDom< PointerInfo > {
     }
 
     void join_with(const PointerInfo& other) {
-        m_region_point_to.join_with(other.m_region_point_to);
-        m_stmt_point_to.join_with(other.m_stmt_point_to);
-        m_region_alias.join_with(other.m_region_alias);
-        m_stmt_alias.join_with(other.m_stmt_alias);
+        (void)join_with_changed(other);
+    }
+
+    [[nodiscard]] bool join_with_changed(const PointerInfo& other) {
+        bool is_changed = false;
+        is_changed |=
+            m_region_point_to.join_with_changed(other.m_region_point_to);
+        is_changed |= m_stmt_point_to.join_with_changed(other.m_stmt_point_to);
+        is_changed |= m_region_alias.join_with_changed(other.m_region_alias);
+        is_changed |= m_stmt_alias.join_with_changed(other.m_stmt_alias);
+        return is_changed;
     }
 
     void widen_with(const PointerInfo& other) {
-        m_region_point_to.widen_with(other.m_region_point_to);
-        m_stmt_point_to.widen_with(other.m_stmt_point_to);
-        m_region_alias.widen_with(other.m_region_alias);
-        m_stmt_alias.widen_with(other.m_stmt_alias);
+        (void)widen_with_changed(other);
+    }
+
+    [[nodiscard]] bool widen_with_changed(const PointerInfo& other) {
+        bool is_changed = false;
+        is_changed |=
+            m_region_point_to.widen_with_changed(other.m_region_point_to);
+        is_changed |= m_stmt_point_to.widen_with_changed(other.m_stmt_point_to);
+        is_changed |= m_region_alias.widen_with_changed(other.m_region_alias);
+        is_changed |= m_stmt_alias.widen_with_changed(other.m_stmt_alias);
+        return is_changed;
     }
 
     void meet_with(const PointerInfo& other) {
@@ -193,10 +214,18 @@ class PointerInfo : public AbsDom< PointerInfo > {
     }
 
     void narrow_with(const PointerInfo& other) {
-        m_region_point_to.narrow_with(other.m_region_point_to);
-        m_stmt_point_to.narrow_with(other.m_stmt_point_to);
-        m_region_alias.narrow_with(other.m_region_alias);
-        m_stmt_alias.narrow_with(other.m_stmt_alias);
+        (void)narrow_with_changed(other);
+    }
+
+    [[nodiscard]] bool narrow_with_changed(const PointerInfo& other) {
+        bool is_changed = false;
+        is_changed |=
+            m_region_point_to.narrow_with_changed(other.m_region_point_to);
+        is_changed |=
+            m_stmt_point_to.narrow_with_changed(other.m_stmt_point_to);
+        is_changed |= m_region_alias.narrow_with_changed(other.m_region_alias);
+        is_changed |= m_stmt_alias.narrow_with_changed(other.m_stmt_alias);
+        return is_changed;
     }
 
     [[nodiscard]] bool leq(const PointerInfo& other) const {
@@ -0,0 +1,86 @@
+//===- registered_domains.hpp -----------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the closed set of the registered domains.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/demo_dom.hpp"
+#include "analyzer/core/domain/dom_base.hpp"
+#include "analyzer/core/domain/numerical/dbm_dom.hpp"
+#include "analyzer/core/domain/numerical/interval_congruence_dom.hpp"
+#include "analyzer/core/domain/numerical/interval_dom.hpp"
+#include "analyzer/core/domain/numerical/machine_interval_dom.hpp"
+#include "analyzer/core/domain/numerical/pack_dom.hpp"
+#include "analyzer/core/domain/pointer.hpp"
+
+#include <type_traits>
+
+namespace knight::analyzer {
+
+template < typename... Doms >
+struct DomainList {
+    /// \brief Build the value constructor table of the domains.
+    [[nodiscard]] static constexpr DomainValFnTable make_val_fn_table() {
+        return make_domain_val_fn_table< Doms... >();
+    }
+
+    /// \brief Call `fn` with `val` downcast to the `DomWrapper` of its
+    /// domain, or with `val` itself if its domain is not in the list.
+    template < typename Val, typename Fn >
+    static decltype(auto) visit(Val& val, Fn&& fn) {
+        return visit_impl< Val, Fn, Doms... >(val, fn);
+    }
+
+  private:
+    template < typename Val, typename Fn, typename Dom, typename... Rest >
+    static decltype(auto) visit_impl(Val& val, Fn& fn) {
+        if (val.kind == Dom::get_kind()) {
+            using Wrapper = std::conditional_t< std::is_const_v< Val >,
+                                                const typename Dom::DomWrapper,
+                                                typename Dom::DomWrapper >;
+            return fn(static_cast< Wrapper& >(val));
+        }
+        if constexpr (sizeof...(Rest) == 0U) {
+            return fn(val);
+        } else {
+            return visit_impl< Val, Fn, Rest... >(val, fn);
+        }
+    }
+}; // struct DomainList
+
+using RegisteredDomains = DomainList< ZIntervalDom,
+                                      DemoItvDom,
+                                      DemoMapDomain,
+                                      PointToSet,
+                                      PointerInfo,
+                                      ZDBMDom,
+                                      ZPackDBMDom,
+                                      MachineIntervalDom,
+                                      ZIntervalCongruenceDom >;
+
+/// \brief Call `fn` on the abstract value `val`.
+///
+/// When built with `KNIGHT_DEVIRTUALIZE_DOMAINS`, `fn` gets the value
+/// as the `DomWrapper` of its registered domain, so that the lattice
+/// operations it calls are bound statically and can be inlined. Otherwise
+/// `fn` gets `val` and goes through the vtable, which is also the fallback
+/// for the domains out of `RegisteredDomains`.
+template < typename Val, typename Fn >
+decltype(auto) visit_dom(Val& val, Fn&& fn) {
+#ifdef KNIGHT_DEVIRTUALIZE_DOMAINS
+    return RegisteredDomains::visit(val, std::forward< Fn >(fn));
+#else
+    return std::forward< Fn >(fn)(val);
+#endif
+}
+
+} // namespace knight::analyzer
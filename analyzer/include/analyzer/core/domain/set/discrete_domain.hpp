@@ -13,18 +13,49 @@
 
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <optional>
 
 #include "analyzer/core/domain/dom_base.hpp"
 #include "analyzer/core/domain/domains.hpp"
+#include "analyzer/support/dense_id.hpp"
 #include "common/support/dumpable.hpp"
 
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/SparseBitVector.h>
+
 namespace knight::analyzer {
+
+/// \brief The number of elements of a discrete set stored inline.
+///
+/// Point-to and alias sets rarely hold more than a few regions.
+constexpr unsigned DiscreteSetInlineSize = 4U;
+
+/// \brief The size beyond which a discrete set of elements with dense IDs
+/// also keeps a bitset of the IDs.
+constexpr std::size_t DiscreteSetIndexThreshold = 16U;
+
+/// \brief Discrete powerset domain, with top as the universe.
+///
+/// The elements are kept in a sorted small vector, so that small sets do
+/// not allocate and the lattice operations are linear merge loops. Large
+/// sets of elements with dense IDs, e.g., the region definitions of the
+/// point-to sets, are also indexed by a sparse bitset: membership, subset
+/// and intersection tests are then bitset operations.
 template < typename Key,
            DomainKind domain_kind > // NOLINT(readability-identifier-naming)
 class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
   public:
-    using Set = std::unordered_set< Key >;
+    using Set = llvm::SmallVector< Key, DiscreteSetInlineSize >;
+    using Compare = DenseIDLess< Key >;
+    using Bits = llvm::SparseBitVector<>;
+
+    /// \brief Whether large sets are indexed by the dense IDs.
+    static constexpr bool IsIndexable =
+        std::is_pointer_v< Key > &&
+        has_dense_id< std::remove_pointer_t< Key > >;
 
   private:
     struct Top {};
@@ -34,11 +65,19 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
     Set m_set;
     bool m_is_top;
 
+    /// \brief The dense IDs of the elements, only kept when the set is
+    /// indexable and larger than `DiscreteSetIndexThreshold`.
+    Bits m_bits;
+
   public:
     explicit DiscreteDom(bool is_top = true, Set set = Set{})
-        : m_is_top(is_top), m_set(std::move(set)) {}
+        : m_set(std::move(set)), m_is_top(is_top) {
+        llvm::sort(m_set, Compare());
+        m_set.erase(std::unique(m_set.begin(), m_set.end()), m_set.end());
+        reindex();
+    }
     DiscreteDom(std::initializer_list< Key > elements)
-        : DiscreteDom(false, elements) {}
+        : DiscreteDom(false, Set(elements)) {}
 
     DiscreteDom(const DiscreteDom&) = default;
     DiscreteDom(DiscreteDom&&) = default;
@@ -51,6 +90,7 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
 
     [[nodiscard]] static DiscreteDom bottom() { return DiscreteDom(false); }
 
+    /// \brief Get the elements in sorted order.
     [[nodiscard]] const Set& get_set() const { return m_set; }
 
     [[nodiscard]] std::size_t size() const { return m_set.size(); }
@@ -59,18 +99,59 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
         if (this->is_top()) {
             return;
         }
-        this->m_set.insert(key);
+        auto it = lower_bound(key);
+        if (it == m_set.end() || Compare()(key, *it)) {
+            m_set.insert(it, key);
+            if (is_indexed()) {
+                m_bits.set(get_id(key));
+            } else {
+                reindex();
+            }
+        }
     }
 
     void remove(const Key& key) {
         if (this->is_bottom()) {
             return;
         }
-        this->m_set.erase(key);
+        auto it = lower_bound(key);
+        if (it != m_set.end() && !Compare()(key, *it)) {
+            m_set.erase(it);
+            if (m_set.size() <= DiscreteSetIndexThreshold) {
+                m_bits.clear();
+            } else {
+                m_bits.reset(get_id(key));
+            }
+        }
     }
 
     [[nodiscard]] bool contains(const Key& key) const {
-        return this->is_top() || m_set.contains(key);
+        return this->is_top() || contains_element(key);
+    }
+
+    /// \brief Check if the two sets share an element.
+    [[nodiscard]] bool intersects(const DiscreteDom& other) const {
+        if (this->is_top()) {
+            return !other.is_bottom();
+        }
+        if (other.is_top()) {
+            return !this->is_bottom();
+        }
+        if (is_indexed() && other.is_indexed()) {
+            return m_bits.intersects(other.m_bits);
+        }
+        auto it = m_set.begin();
+        auto other_it = other.m_set.begin();
+        while (it != m_set.end() && other_it != other.m_set.end()) {
+            if (Compare()(*it, *other_it)) {
+                ++it;
+            } else if (Compare()(*other_it, *it)) {
+                ++other_it;
+            } else {
+                return true;
+            }
+        }
+        return false;
     }
 
     [[nodiscard]] DiscreteDom diff(const DiscreteDom& other) const {
@@ -87,7 +168,7 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
     }
 
   public:
-    static DomainKind get_kind() { return domain_kind; }
+    static constexpr DomainKind get_kind() { return domain_kind; }
 
     static SharedVal default_val() {
         return std::make_shared< DiscreteDom >(true);
@@ -100,11 +181,11 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
         if constexpr (isa_abs_dom< Key >::value) {
             Set set;
             for (auto& key : m_set) {
-                set.insert(*(static_cast< Key* >(key.clone())));
+                set.push_back(*(static_cast< Key* >(key.clone())));
             }
-            return new DiscreteDom(m_is_top, set);
+            return new DiscreteDom(m_is_top, std::move(set));
         }
-        return new DiscreteDom(m_is_top, m_set);
+        return new DiscreteDom(*this);
     }
 
     void normalize() override {}
@@ -118,49 +199,84 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
     void set_to_bottom() override {
         m_is_top = false;
         Set().swap(m_set);
+        m_bits.clear();
     }
 
     void set_to_top() override {
         m_is_top = true;
         Set().swap(m_set);
+        m_bits.clear();
     }
 
     void join_with(const DiscreteDom& other) {
+        (void)join_with_changed(other);
+    }
+
+    [[nodiscard]] bool join_with_changed(const DiscreteDom& other) {
         if (this->is_top()) {
-            return;
+            return false;
         }
         if (other.is_top()) {
             set_to_top();
-            return;
+            return true;
+        }
+        if (other.m_set.empty() || other.leq_elements(*this)) {
+            return false;
+        }
+        Set merged;
+        merged.reserve(m_set.size() + other.m_set.size());
+        std::set_union(m_set.begin(),
+                       m_set.end(),
+                       other.m_set.begin(),
+                       other.m_set.end(),
+                       std::back_inserter(merged),
+                       Compare());
+        m_set = std::move(merged);
+        if (is_indexed() && other.is_indexed()) {
+            m_bits |= other.m_bits;
+        } else {
+            reindex();
         }
-        this->m_set.insert(other.m_set.begin(), other.m_set.end());
+        return true;
     }
 
     void widen_with(const DiscreteDom& other) { join_with(other); }
 
+    [[nodiscard]] bool widen_with_changed(const DiscreteDom& other) {
+        return join_with_changed(other);
+    }
+
     void meet_with(const DiscreteDom& other) {
+        (void)meet_with_changed(other);
+    }
+
+    [[nodiscard]] bool meet_with_changed(const DiscreteDom& other) {
         if (this->is_bottom() || other.is_top()) {
-            return;
+            return false;
         }
         if (other.is_bottom()) {
             set_to_bottom();
-            return;
+            return true;
         }
         if (this->is_top()) {
             *this = other;
-            return;
+            return true;
         }
-        for (auto it = m_set.begin(); it != m_set.end();) {
-            if (!other.m_set.contains(*it)) {
-                it = this->m_set.erase(it);
-            } else {
-                it++;
-            }
+        const auto size = m_set.size();
+        retain_if_in(other.m_set, true);
+        if (m_set.size() == size) {
+            return false;
         }
+        reindex();
+        return true;
     }
 
     void narrow_with(const DiscreteDom& other) { meet_with(other); }
 
+    [[nodiscard]] bool narrow_with_changed(const DiscreteDom& other) {
+        return meet_with_changed(other);
+    }
+
     void diff_with(const DiscreteDom& other) {
         if (other.is_top()) {
             set_to_bottom();
@@ -170,13 +286,8 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
             return;
         }
 
-        for (auto it = m_set.begin(); it != m_set.end();) {
-            if (other.m_set.contains(*it)) {
-                it = this->m_set.erase(it);
-            } else {
-                it++;
-            }
-        }
+        retain_if_in(other.m_set, false);
+        reindex();
     }
 
     [[nodiscard]] bool leq(const DiscreteDom& other) const {
@@ -186,9 +297,7 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
         if (this->is_top()) {
             return false;
         }
-        return llvm::all_of(this->m_set, [&](const auto& key) {
-            return other.m_set.contains(key);
-        });
+        return leq_elements(other);
     }
 
     [[nodiscard]] bool equals(const DiscreteDom& other) const {
@@ -198,12 +307,7 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
         if (other.is_top()) {
             return false;
         }
-        if (this->m_set.size() != other.m_set.size()) {
-            return false;
-        }
-        return llvm::all_of(this->m_set, [&](const auto& key) {
-            return other.m_set.contains(key);
-        });
+        return this->m_set == other.m_set;
     }
 
     void dump(llvm::raw_ostream& os) const override {
@@ -223,6 +327,79 @@ class DiscreteDom : public AbsDom< DiscreteDom< Key, domain_kind > > {
         }
     }
 
+  private:
+    [[nodiscard]] typename Set::const_iterator lower_bound(
+        const Key& key) const {
+        return std::lower_bound(m_set.begin(), m_set.end(), key, Compare());
+    }
+
+    [[nodiscard]] typename Set::iterator lower_bound(const Key& key) {
+        return std::lower_bound(m_set.begin(), m_set.end(), key, Compare());
+    }
+
+    [[nodiscard]] bool contains_element(const Key& key) const {
+        if (is_indexed()) {
+            return m_bits.test(get_id(key));
+        }
+        auto it = lower_bound(key);
+        return it != m_set.end() && !Compare()(key, *it);
+    }
+
+    /// \return true if the elements are a subset of the ones of `other`.
+    [[nodiscard]] bool leq_elements(const DiscreteDom& other) const {
+        if (m_set.size() > other.m_set.size()) {
+            return false;
+        }
+        if (is_indexed() && other.is_indexed()) {
+            return other.m_bits.contains(m_bits);
+        }
+        return std::includes(other.m_set.begin(),
+                             other.m_set.end(),
+                             m_set.begin(),
+                             m_set.end(),
+                             Compare());
+    }
+
+    [[nodiscard]] bool is_indexed() const { return !m_bits.empty(); }
+
+    [[nodiscard]] static DenseID get_id(const Key& key) {
+        if constexpr (IsIndexable) {
+            return key->get_dense_id();
+        } else {
+            return 0U;
+        }
+    }
+
+    /// \brief Rebuild or drop the bitset according to the size of the set.
+    void reindex() {
+        m_bits.clear();
+        if constexpr (IsIndexable) {
+            if (m_set.size() <= DiscreteSetIndexThreshold) {
+                return;
+            }
+            for (const auto& key : m_set) {
+                m_bits.set(get_id(key));
+            }
+        }
+    }
+
+    /// \brief Keep the elements which are in `set` iff `in`, by one merge
+    /// pass over both sorted sets.
+    void retain_if_in(const Set& set, bool in) {
+        auto other_it = set.begin();
+        auto out = m_set.begin();
+        for (auto it = m_set.begin(); it != m_set.end(); ++it) {
+            while (other_it != set.end() && Compare()(*other_it, *it)) {
+                ++other_it;
+            }
+            bool found = other_it != set.end() && !Compare()(*it, *other_it);
+            if (found == in) {
+                *out++ = *it;
+            }
+        }
+        m_set.erase(out, m_set.end());
+    }
+
 }; // class DiscreteDom
 
 } // namespace knight::analyzer
\ No newline at end of file
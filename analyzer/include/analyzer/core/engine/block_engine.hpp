@@ -13,7 +13,10 @@
 
 #pragma once
 
+#include "analyzer/core/analysis_context.hpp"
 #include "analyzer/core/analysis_manager.hpp"
+#include "analyzer/core/checker_manager.hpp"
+#include "analyzer/core/engine/block_program.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/location_manager.hpp"
 #include "analyzer/core/proc_cfg.hpp"
@@ -23,9 +26,29 @@
 
 #include <clang/AST/DeclCXX.h>
 #include <clang/AST/ExprCXX.h>
+#include <llvm/ADT/ArrayRef.h>
+
+#include <vector>
 
 namespace knight::analyzer {
 
+/// \brief A stmt to be checked along with the state to check it on.
+struct StmtCheckPoint {
+    ProcCFG::StmtRef stmt;
+    internal::CheckStmtKind kind;
+    ProgramStateRef state;
+    const LocationContext* loc_ctx;
+}; // struct StmtCheckPoint
+
+using StmtCheckPoints = std::vector< StmtCheckPoint >;
+
+/// \brief Execution engine for one node of the procedure CFG.
+///
+/// When a checker manager is given, the stmt checkers are run inline on
+/// each stmt with its pre and post state, which is used to replay the node
+/// from its converged invariant after the fixpoint is reached. If the
+/// check points are also given, the stmts to check are only recorded
+/// there, so that the checkers can be run later on other threads.
 class BlockExecutionEngine {
   public:
     using GraphRef = typename ProcCFG::GraphRef;
@@ -35,7 +58,6 @@ class BlockExecutionEngine {
     using ExprRef = ProcCFG::ExprRef;
     using DeclRef = ProcCFG::DeclRef;
     using VarDeclRef = ProcCFG::VarDeclRef;
-    using StmtResultCache = std::unordered_map< StmtRef, ProgramStateRef >;
 
   private:
     GraphRef m_cfg;
@@ -45,12 +67,31 @@ class BlockExecutionEngine {
     LocationManager& m_location_manager;
 
     ProgramStateRef m_state;
-    StmtResultCache& m_stmt_pre;
-    StmtResultCache& m_stmt_post;
     const StackFrame* m_frame;
+    CheckerManager* m_checker_manager;
+    StmtCheckPoints* m_check_points;
+
+    /// \brief The lowered stmts of the block, executed instead of the
+    /// elements during the fixpoint iteration when the block is lowered.
+    const BlockProgram* m_program = nullptr;
 
     int m_current_elem_idx = -1;
 
+    /// \brief Location contexts of the block start and elements, shared
+    /// by every transfer of the block in the frame.
+    llvm::ArrayRef< const LocationContext* > m_location_contexts;
+
+    /// \brief Analysis context reused across the elements of the block.
+    AnalysisContext m_analysis_ctx;
+
+    /// \brief The stmt values of the block, only used during the fixpoint
+    /// iteration, see `StmtSExprScratch`.
+    StmtSExprScratch m_stmt_scratch;
+
+    /// \brief The numerical value of the block, only used during the
+    /// fixpoint iteration, see `ZDomScratch`.
+    ZDomScratch m_zdom_scratch;
+
   public:
     BlockExecutionEngine(GraphRef cfg,
                          NodeRef node,
@@ -58,18 +99,25 @@ class BlockExecutionEngine {
                          SymbolManager& symbol_manager,
                          LocationManager& location_manager,
                          ProgramStateRef in_state,
-                         StmtResultCache& stmt_pre,
-                         StmtResultCache& stmt_post,
-                         const StackFrame* frame)
+                         const StackFrame* frame,
+                         CheckerManager* checker_manager = nullptr,
+                         StmtCheckPoints* check_points = nullptr)
         : m_cfg(cfg),
           m_node(node),
           m_analysis_manager(analysis_manager),
           m_sym_manager(symbol_manager),
           m_location_manager(location_manager),
           m_state(std::move(in_state)),
-          m_stmt_pre(stmt_pre),
-          m_stmt_post(stmt_post),
-          m_frame(frame) {}
+          m_frame(frame),
+          m_checker_manager(checker_manager),
+          m_check_points(check_points),
+          m_location_contexts(
+              location_manager.get_block_location_contexts(frame, node)),
+          m_analysis_ctx(analysis_manager.get_context(),
+                         analysis_manager.get_region_manager(),
+                         frame,
+                         symbol_manager,
+                         m_location_contexts.front()) {}
 
   public:
     /// \brief General transformer for all nodes.
@@ -77,10 +125,30 @@ class BlockExecutionEngine {
 
     [[nodiscard]] ProgramStateRef get_state() const { return m_state; }
 
+    /// \brief Execute the lowered `program` of the block, which shall
+    /// outlive the engine, instead of its elements.
+    void set_program(const BlockProgram* program) { m_program = program; }
+
   private:
-    [[nodiscard]] const LocationContext* get_location_context() const;
+    /// \brief Transfer the elements of the block.
+    void exec_elements();
+
+    /// \brief Run the analyses recorded in the lowered program.
+    void exec_program();
+
+    /// \brief Store the scratch stmt values read by the later blocks in
+    /// the state.
+    void persist_stmt_scratch();
 
-    ProgramStateRef exec_branch_condition(ProgramStateRef state);
+    /// \brief Store the scratch numerical value in the state.
+    void persist_zdom_scratch();
+
+    [[nodiscard]] const LocationContext* get_location_context() const {
+        return m_location_contexts[m_current_elem_idx + 1];
+    }
+
+    /// \brief Reset the reused analysis context on the current element.
+    AnalysisContext& get_analysis_context(ProgramStateRef state);
 
     /// \brief Transfer C++ base or member initializer from constructor's
     /// initialization list.
@@ -108,6 +176,12 @@ class BlockExecutionEngine {
     /// \brief Transfer the stmt
     ProgramStateRef exec_cfg_stmt(StmtRef stmt, const ProgramStateRef& state);
 
+    /// \brief Run or record the pre/post stmt checkers on the given state
+    /// if the checker manager is provided.
+    void check_stmt(StmtRef stmt,
+                    const ProgramStateRef& state,
+                    internal::CheckStmtKind kind);
+
 }; // class BlockExecutionEngine
 
 } // namespace knight::analyzer
\ No newline at end of file
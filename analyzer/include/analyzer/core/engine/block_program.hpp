@@ -0,0 +1,73 @@
+//===- block_program.hpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the lowered form of the Basic Block executed by
+//  the block engine during the fixpoint iteration.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/analysis_manager.hpp"
+#include "analyzer/core/proc_cfg.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+
+#include <array>
+#include <vector>
+
+namespace knight::analyzer {
+
+/// \brief A stmt element of a block along with the analyses to run on it.
+struct LoweredStmt {
+    ProcCFG::StmtRef stmt;
+    int elem_idx;
+    /// \brief The range of the callbacks of the stmt in the callbacks of
+    /// the program, ending with the pre, eval and post ones in turn.
+    unsigned callback_begin;
+    std::array< unsigned, internal::NumVisitStmtKinds > callback_ends;
+}; // struct LoweredStmt
+
+/// \brief The stmts of a block lowered once with their analyses.
+///
+/// The elements of the block are walked and dispatched to the analyses
+/// once, then the fixpoint iterations only run the recorded callbacks.
+/// The stmts without any analysis are dropped, as their transfer is the
+/// identity. A block with elements other than stmts is not lowered, and
+/// is executed element by element.
+class BlockProgram {
+  public:
+    using NodeRef = ProcCFG::NodeRef;
+    using AnalyzeStmtCallBacks =
+        llvm::ArrayRef< const internal::AnalyzeStmtCallBack* >;
+
+  private:
+    std::vector< LoweredStmt > m_stmts;
+    std::vector< const internal::AnalyzeStmtCallBack* > m_callbacks;
+    bool m_is_lowered = false;
+
+  public:
+    /// \brief Lower the elements of `node` with the analyses required by
+    /// the analysis manager.
+    [[nodiscard]] static BlockProgram lower(NodeRef node,
+                                            AnalysisManager& analysis_mgr);
+
+    [[nodiscard]] bool is_lowered() const { return m_is_lowered; }
+
+    [[nodiscard]] llvm::ArrayRef< LoweredStmt > get_stmts() const {
+        return m_stmts;
+    }
+
+    /// \brief The callbacks of the given visit kind of the lowered stmt.
+    [[nodiscard]] AnalyzeStmtCallBacks get_callbacks(
+        const LoweredStmt& stmt, internal::VisitStmtKind visit_kind) const;
+
+}; // class BlockProgram
+
+} // namespace knight::analyzer
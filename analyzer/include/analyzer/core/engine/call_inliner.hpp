@@ -0,0 +1,114 @@
+//===- call_inliner.hpp -----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the call inliner of the analyzer engine.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/analysis_context.hpp"
+#include "analyzer/core/domain/interval.hpp"
+#include "analyzer/core/location_manager.hpp"
+#include "analyzer/core/stack_frame.hpp"
+
+#include <clang/AST/Decl.h>
+#include <clang/AST/Expr.h>
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace knight {
+
+class KnightContext;
+
+} // namespace knight
+
+namespace knight::analyzer {
+
+class AnalysisManager;
+class CheckerManager;
+
+/// \brief Analyze the callees at their call sites, up to `max_call_depth`
+/// frames below the top-level function.
+///
+/// The callee is analyzed in a new stack frame from the values of the
+/// arguments, and its return values flow back to the call site. The
+/// results are memoized per callee and argument values, so that a callee
+/// called again with the same values, from any call site, is not
+/// analyzed again.
+class CallInliner {
+  private:
+    /// \brief A callee along with the values of its integral arguments,
+    /// top for the other ones.
+    struct CallKey {
+        const clang::FunctionDecl* callee;
+        std::vector< ZInterval > args;
+
+        [[nodiscard]] bool operator==(const CallKey& other) const {
+            return callee == other.callee &&
+                   std::equal(args.begin(),
+                              args.end(),
+                              other.args.begin(),
+                              other.args.end(),
+                              [](const auto& lhs, const auto& rhs) {
+                                  return lhs.equals(rhs);
+                              });
+        }
+    }; // struct CallKey
+
+    struct CallKeyHash {
+        [[nodiscard]] std::size_t operator()(const CallKey& key) const;
+    }; // struct CallKeyHash
+
+  private:
+    KnightContext& m_ctx;
+    AnalysisManager& m_analysis_mgr;
+    CheckerManager& m_checker_mgr;
+    LocationManager& m_location_mgr;
+
+    /// \brief The return values of the analyzed calls.
+    std::unordered_map< CallKey, ZInterval, CallKeyHash > m_results;
+
+  public:
+    CallInliner(KnightContext& ctx,
+                AnalysisManager& analysis_mgr,
+                CheckerManager& checker_mgr,
+                LocationManager& location_mgr)
+        : m_ctx(ctx),
+          m_analysis_mgr(analysis_mgr),
+          m_checker_mgr(checker_mgr),
+          m_location_mgr(location_mgr) {}
+
+    /// \brief Analyze the callee of the call from the current state.
+    ///
+    /// The CFG of the callee is built on the first call, possibly on a
+    /// function worker, under the AST mutex, see `LocationManager::get_cfg`.
+    ///
+    /// \return the values returned by the callee, or std::nullopt if the
+    /// callee has no body, is recursive, or is beyond the call depth.
+    [[nodiscard]] std::optional< ZInterval > inline_call(
+        const clang::CallExpr* call_expr, const AnalysisContext& ctx);
+
+  private:
+    [[nodiscard]] std::vector< ZInterval > get_arg_values(
+        const clang::CallExpr* call_expr,
+        const clang::FunctionDecl* callee,
+        const AnalysisContext& ctx) const;
+
+    /// \brief Get the entry state of the callee frame, where the integral
+    /// parameters are bound to the argument values.
+    [[nodiscard]] ProgramStateRef get_entry_state(
+        const StackFrame* callee_frame, llvm::ArrayRef< ZInterval > args);
+
+}; // class CallInliner
+
+} // namespace knight::analyzer
@@ -0,0 +1,65 @@
+//===- disjunctive_state.hpp ------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the bounded disjunction of the program states kept
+//  apart at the merge points.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/location_context.hpp"
+#include "analyzer/core/program_state.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+
+namespace knight::analyzer {
+
+/// \brief At most `max_width` program states kept apart instead of joined.
+///
+/// Adding a state past the width joins the two most similar states, so
+/// that the cost of a node is bounded by the width times the cost of a
+/// single state. A width of one joins every state added.
+class DisjunctiveState {
+  public:
+    using Disjuncts = llvm::SmallVector< ProgramStateRef, 4U >;
+
+  private:
+    unsigned m_max_width;
+    ProgramStateRef m_bottom;
+    Disjuncts m_disjuncts;
+
+  public:
+    DisjunctiveState(unsigned max_width, ProgramStateRef bottom)
+        : m_max_width(max_width == 0U ? 1U : max_width),
+          m_bottom(std::move(bottom)) {}
+
+  public:
+    /// \brief Add a disjunct, the bottom and the already present
+    /// disjuncts are dropped.
+    void add(ProgramStateRef state, const LocationContext* loc_ctx);
+
+    /// \brief The join of the disjuncts.
+    [[nodiscard]] ProgramStateRef collapse(
+        const LocationContext* loc_ctx) const;
+
+    [[nodiscard]] llvm::ArrayRef< ProgramStateRef > get_disjuncts() const {
+        return m_disjuncts;
+    }
+
+    [[nodiscard]] Disjuncts take_disjuncts() { return std::move(m_disjuncts); }
+
+  private:
+    /// \brief Join the two disjuncts sharing the most values.
+    void merge_most_similar(const LocationContext* loc_ctx);
+
+}; // class DisjunctiveState
+
+} // namespace knight::analyzer
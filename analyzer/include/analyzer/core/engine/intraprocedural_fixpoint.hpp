@@ -15,15 +15,35 @@
 #pragma once
 
 #include "analyzer/core/checker_manager.hpp"
+#include "analyzer/core/engine/block_engine.hpp"
 #include "analyzer/core/engine/wto_iterator.hpp"
 #include "analyzer/core/proc_cfg.hpp"
 #include "analyzer/core/program_state.hpp"
 #include "analyzer/core/stack_frame.hpp"
+#include "analyzer/core/summary.hpp"
 #include "analyzer/core/symbol_manager.hpp"
+#include "analyzer/util/node_table.hpp"
 #include "common/support/graph.hpp"
 
+#include <llvm/ADT/DenseMap.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace knight::analyzer {
 
+/// \brief A worker thread running the checkers on the converged
+/// invariants.
+///
+/// The worker owns its context and checkers, so that the diagnostics
+/// reported by the checkers are captured by its own diagnostic consumer.
+struct CheckWorker {
+    KnightContext& ctx;
+    CheckerManager& checker_mgr;
+}; // struct CheckWorker
+
 class IntraProceduralFixpointIterator final
     : public WtoBasedFixPointIterator< ProcCFG, GraphTrait< ProcCFG > > {
   private:
@@ -33,7 +53,9 @@ class IntraProceduralFixpointIterator final
     using FunctionRef = ProcCFG::FunctionRef;
     using NodeRef = typename FixPointIterator::NodeRef;
     using StmtRef = ProcCFG::StmtRef;
-    using StmtResultCache = std::unordered_map< StmtRef, ProgramStateRef >;
+    using TransferMemo =
+        NodeTable< GraphTraitT, std::pair< ProgramStateRef, ProgramStateRef > >;
+    using BlockPrograms = NodeTable< GraphTraitT, BlockProgram >;
 
   private:
     KnightContext& m_ctx;
@@ -44,8 +66,30 @@ class IntraProceduralFixpointIterator final
     ProgramStateManager& m_state_mgr;
     const StackFrame* m_frame;
 
-    StmtResultCache m_stmt_pre;
-    StmtResultCache m_stmt_post;
+    /// \brief Workers of the checker phase, empty to run the checkers on
+    /// the current thread.
+    std::vector< CheckWorker > m_check_workers;
+
+    /// \brief The nodes replayed in the checker phase along with their
+    /// recorded check points, only used with the check workers.
+    std::vector< std::pair< NodeRef, StmtCheckPoints > > m_node_check_points;
+
+    /// \brief The last pre state transferred through each node, along with
+    /// its post state. The states are interned, so a node transferred again
+    /// from the same pre state pointer reuses its post state.
+    TransferMemo m_transfer_memo;
+
+    /// \brief The blocks lowered on their first transfer, and executed
+    /// from their lowered stmts on the later iterations.
+    BlockPrograms m_block_programs;
+
+    /// \brief The iterations of the cycles being visited, only recorded
+    /// for the time report.
+    llvm::DenseMap< NodeRef, uint64_t > m_cycle_iterations;
+
+    /// \brief The function name, only set for the time report and the
+    /// widening trace.
+    std::string m_function_name;
 
   public:
     IntraProceduralFixpointIterator(knight::KnightContext& ctx,
@@ -53,7 +97,9 @@ class IntraProceduralFixpointIterator final
                                     CheckerManager& checker_mgr,
                                     LocationManager& location_mgr,
                                     ProgramStateManager& state_mgr,
-                                    const StackFrame* frame);
+                                    const StackFrame* frame,
+                                    std::vector< CheckWorker > check_workers =
+                                        {});
 
     /// \brief transfer function for a graph node.
     ///
@@ -63,18 +109,115 @@ class IntraProceduralFixpointIterator final
 
     /// \brief transfer function for a graph edge.
     ///
+    /// The edges out of a branch assume the outcome of its condition, and
+    /// the edges out of a switch the value of their case, so that the
+    /// infeasible edges give bottom before the join of the destination.
+    ///
     /// \return the out program state after transferring to the given edge,
     ///         to the in state of the destination node.
     [[nodiscard]] ProgramStateRef transfer_edge(
         NodeRef src, NodeRef dst, ProgramStateRef src_post_state) override;
 
     /// \brief check the precondition of a node.
+    ///
+    /// The node is replayed once from its converged pre state, running
+    /// the pre and post stmt checkers along the way.
     void check_pre(NodeRef, const ProgramStateRef&) override;
 
     /// \brief check the postcondition of a node.
+    ///
+    /// Only the end function checkers are run here, the post stmt checkers
+    /// are run by the replay in `check_pre`.
     void check_post(NodeRef, const ProgramStateRef&) override;
 
-    void run();
+    /// \brief Count the cycle iterations for the time report.
+    /// @{
+    void notify_enter_cycle(NodeRef head) override;
+    void notify_each_cycle_iteration(NodeRef head,
+                                     unsigned iter_cnt,
+                                     IterationKind kind) override;
+    void notify_exit_cycle(NodeRef head) override;
+    /// @}
+
+    /// \brief Combine the iterations at a cycle head, and record them to
+    /// the widening trace if enabled.
+    /// @{
+    [[nodiscard]] ProgramStateRef enlarge_at_head_when_increasing(
+        NodeRef head,
+        unsigned iter_cnt,
+        const ProgramStateRef& state_before,
+        const ProgramStateRef& state_after,
+        const LocationContext* loc_ctx,
+        std::optional< bool >& is_changed) override;
+    [[nodiscard]] ProgramStateRef refine_at_loop_head_when_decreasing(
+        NodeRef head,
+        unsigned iter_cnt,
+        const ProgramStateRef& state_before,
+        const ProgramStateRef& state_after,
+        std::optional< bool >& is_changed) override;
+    /// @}
+
+    /// \brief Compute the fixpoint from the entry state and check it.
+    ///
+    /// \param entry_state the default state if null. The checkers only run
+    /// in the top-level frames, the inlined callees being checked as
+    /// top-level functions on their own.
+    void run(ProgramStateRef entry_state = nullptr);
+
+    /// \brief Summarize the converged invariants for the callers.
+    ///
+    /// \note Shall be called after `run`.
+    [[nodiscard]] FunctionSummary build_summary() const;
+
+  private:
+    /// \brief Get the qualified name of the function, computed once.
+    [[nodiscard]] const std::string& get_function_name();
+
+    /// \brief Enlarge the counter of a counting loop at its head to its
+    /// closed-form range, from its step over the first iteration.
+    ///
+    /// The loops exiting on `i < n`, `i <= n`, `i > n` or `i >= n` by any
+    /// constant step, or on `i != n` by a step of one, are recognized, `n`
+    /// being a constant or a variable unchanged by the iteration. The
+    /// accelerated state is only a guess, checked by the next iteration as
+    /// any enlarged one.
+    ///
+    /// \param state the combined state at the head after the first
+    /// iteration, in which the counter is enlarged
+    /// \return null if the head is not the one of a counting loop.
+    [[nodiscard]] ProgramStateRef accelerate_counting_loop(
+        NodeRef head,
+        const ProgramStateRef& state_before,
+        const ProgramStateRef& state_after,
+        const ProgramStateRef& state) const;
+
+    /// \brief Record the changes of the state at the head from the
+    /// previous iteration to the widening trace.
+    void trace_head_iteration(NodeRef head,
+                              unsigned iter_cnt,
+                              IterationKind kind,
+                              HeadOpKind op,
+                              const ProgramState& state_before,
+                              const ProgramState& state);
+
+    /// \brief Assume the truth value `is_true_branch` of the branch
+    /// condition `cond` on the edge to `dst`.
+    [[nodiscard]] ProgramStateRef filter_branch(NodeRef dst,
+                                                ProcCFG::ExprRef cond,
+                                                bool is_true_branch,
+                                                ProgramStateRef state);
+
+    /// \brief Assume the value of the switch condition `cond` on the edge
+    /// to the case or default `dst`.
+    [[nodiscard]] ProgramStateRef filter_switch_case(
+        const clang::SwitchStmt* switch_stmt,
+        NodeRef dst,
+        ProcCFG::ExprRef cond,
+        ProgramStateRef state) const;
+
+    /// \brief Run the recorded check points of the nodes on the check
+    /// workers, and merge their diagnostics by the node order.
+    void run_checkers_in_parallel();
 
 }; // class IntraProceduralFixpointIterator
 
@@ -22,6 +22,16 @@ namespace knight::analyzer {
 
 enum class IterationKind { Increasing, Decreasing };
 
+/// \brief The operation combining the states of two iterations at a cycle
+/// head.
+enum class HeadOpKind {
+    Join,
+    Widen,
+    WidenWithThreshold,
+    Narrow,
+    NarrowWithThreshold
+};
+
 template < graph G, typename GraphTrait = GraphTrait< G > >
 class FixPointIterator {
   public:
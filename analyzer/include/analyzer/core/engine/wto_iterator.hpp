@@ -14,13 +14,24 @@
 #pragma once
 
 #include "analyzer/core/analyzer_options.hpp"
+#include "analyzer/core/engine/disjunctive_state.hpp"
 #include "analyzer/core/engine/iterator.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/program_state.hpp"
 #include "analyzer/core/stack_frame.hpp"
+#include "analyzer/util/node_table.hpp"
 #include "analyzer/util/wto.hpp"
 #include "common/support/graph.hpp"
 
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/TimeProfiler.h>
+
+#include <chrono>
+#include <optional>
+#include <string>
+
 namespace knight::analyzer {
 
 namespace impl {
@@ -40,33 +51,96 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
     using Base = FixPointIterator< CFG, GraphTrait >;
     using GraphRef = typename Base::GraphRef;
     using NodeRef = typename Base::NodeRef;
-    using InvariantMap = typename Base::InvariantMap;
+    using InvariantTable = NodeTable< GraphTrait, ProgramStateRef >;
     using WtoT = Wto< CFG, GraphTrait >;
     using WtoIterator = impl::WtoIterator< CFG, GraphTrait >;
     using WtoChecker = impl::WtoChecker< CFG, GraphTrait >;
-    using HeadThresholdMap = llvm::DenseMap< NodeRef, std::optional< ZNum > >;
+    using Thresholds = llvm::SmallVector< ZNum, 4U >;
+    using HeadThresholdMap = NodeTable< GraphTrait, Thresholds >;
+    using StampTable = NodeTable< GraphTrait, unsigned >;
+    using WtoCycleT = WtoCycle< CFG, GraphTrait >;
+    using CycleInputTable =
+        NodeTable< GraphTrait, llvm::SmallVector< NodeRef, 4U > >;
+    using DisjunctTable = NodeTable< GraphTrait, DisjunctiveState::Disjuncts >;
 
   protected:
     AnalyzerOptions m_analyzer_opts;
 
     GraphRef m_cfg;
-    WtoT m_wto;
 
-    InvariantMap m_pre;
-    InvariantMap m_post;
+    /// \brief The WTO of the CFG, owned by the location manager and shared
+    /// by every run over the same CFG.
+    const WtoT* m_wto;
+
+    /// \brief Invariants of the nodes, indexed by the block IDs.
+    InvariantTable m_pre;
+    InvariantTable m_post;
+
+    /// \brief The post states of the nodes kept apart, when more than one
+    /// disjunct is allowed. `m_post` holds their join.
+    DisjunctTable m_post_disjuncts;
+
+    /// \brief Sorted widening thresholds of each cycle head, extracted
+    /// once from the comparisons of the cycle.
     HeadThresholdMap m_head_thresholds;
     bool m_converged{};
 
+    /// \brief Change stamps of the sparse mode: the stamp of the last
+    /// change of the post state of each node, and the stamp at the last
+    /// transfer of each node. A node whose predecessors did not change
+    /// since its last transfer keeps its invariants.
+    /// @{
+    StampTable m_post_stamps;
+    StampTable m_transfer_stamps;
+    unsigned m_stamp{};
+    /// @}
+
+    /// \brief The stamp at the start of the last visit of each cycle, and
+    /// the nodes out of each cycle flowing into it, by the cycle heads.
+    StampTable m_cycle_stamps;
+    CycleInputTable m_cycle_inputs;
+
+    /// \brief Start time and node transfers of the current run, checked
+    /// against the per-function budgets.
+    std::chrono::steady_clock::time_point m_start_time;
+    unsigned m_num_transfers{};
+
+    /// \brief If true, the budget is exceeded and the remaining cycles
+    /// are widened eagerly without narrowing.
+    bool m_degraded{};
+
+    /// \brief If true, the arenas exceeded twice the memory budget even
+    /// with the eager widening, so the nodes are no longer transferred and
+    /// the results are dropped.
+    bool m_aborted{};
+
     ProgramStateRef m_bottom;
 
+  public:
+    /// \brief The node transfers between two checks of the arenas.
+    static constexpr unsigned MemoryCheckInterval = 64U;
+    static constexpr unsigned MiBShift = 20U;
+
   public:
     WtoBasedFixPointIterator(AnalyzerOptions analyzer_opts,
                              const StackFrame* frame,
                              ProgramStateRef bottom)
         : m_analyzer_opts(analyzer_opts),
           m_cfg(frame->get_cfg()),
-          m_wto(frame->get_cfg()),
-          m_bottom(std::move(bottom)) {}
+          m_wto(&frame->get_wto()),
+          m_pre(m_cfg),
+          m_post(m_cfg),
+          m_post_disjuncts(m_cfg),
+          m_head_thresholds(m_cfg),
+          m_post_stamps(m_cfg),
+          m_transfer_stamps(m_cfg),
+          m_cycle_stamps(m_cfg),
+          m_cycle_inputs(m_cfg),
+          m_bottom(std::move(bottom)) {
+        if (m_analyzer_opts.analyze_with_threshold) {
+            build_thresholds();
+        }
+    }
     WtoBasedFixPointIterator(const WtoBasedFixPointIterator&) = delete;
     WtoBasedFixPointIterator& operator=(const WtoBasedFixPointIterator&) =
         delete;
@@ -79,8 +153,10 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
         return m_analyzer_opts;
     }
     [[nodiscard]] bool is_converged() const override { return m_converged; }
+    [[nodiscard]] bool is_degraded() const { return m_degraded; }
+    [[nodiscard]] bool is_aborted() const { return m_aborted; }
     [[nodiscard]] GraphRef get_cfg() const override { return m_cfg; }
-    [[nodiscard]] const WtoT& get_wto() const { return m_wto; }
+    [[nodiscard]] const WtoT& get_wto() const { return *m_wto; }
     [[nodiscard]] const ProgramStateRef& get_bottom() const { return m_bottom; }
 
   public:
@@ -92,7 +168,117 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
         return get(m_post, node);
     }
 
-    [[nodiscard]] std::optional< ZNum > get_threshold(NodeRef head) const;
+    /// \brief Return the sorted widening thresholds of a cycle head.
+    [[nodiscard]] llvm::ArrayRef< ZNum > get_thresholds(NodeRef head) const {
+        if (const auto* thresholds = m_head_thresholds.find(head)) {
+            return *thresholds;
+        }
+        return {};
+    }
+
+    /// \brief Check if the per-function budget is exceeded
+    ///
+    /// Once exceeded, the iterator is degraded till the end of the run.
+    [[nodiscard]] bool is_budget_exceeded() {
+        if (m_degraded) {
+            return true;
+        }
+        if (m_analyzer_opts.max_function_transfers > 0U &&
+            m_num_transfers >= m_analyzer_opts.max_function_transfers) {
+            m_degraded = true;
+        } else if (is_memory_exceeded(1U)) {
+            m_degraded = true;
+        } else if (m_analyzer_opts.max_function_millis > 0U) {
+            auto elapsed = std::chrono::steady_clock::now() - m_start_time;
+            m_degraded =
+                std::chrono::duration_cast< std::chrono::milliseconds >(
+                    elapsed)
+                    .count() >= m_analyzer_opts.max_function_millis;
+        }
+        return m_degraded;
+    }
+
+    /// \brief Check if the arenas of the worker exceed `factor` times the
+    /// memory budget.
+    [[nodiscard]] bool is_memory_exceeded(std::size_t factor) const {
+        if (m_analyzer_opts.max_memory_mb == 0U) {
+            return false;
+        }
+        return m_bottom->get_state_manager().get_arena_size() >=
+               (factor * m_analyzer_opts.max_memory_mb << MiBShift);
+    }
+
+    /// \brief Get the operation enlarging the state at a cycle head after
+    /// the given increasing iteration.
+    [[nodiscard]] HeadOpKind get_increasing_head_op(NodeRef head,
+                                                    unsigned iter_cnt) {
+        if (is_budget_exceeded()) {
+            return HeadOpKind::Widen;
+        }
+        if (iter_cnt < m_analyzer_opts.widening_delay + 1) {
+            return HeadOpKind::Join;
+        }
+        return get_thresholds(head).empty() ? HeadOpKind::Widen
+                                            : HeadOpKind::WidenWithThreshold;
+    }
+
+    /// \brief Get the operation refining the state at a loop head after a
+    /// decreasing iteration.
+    [[nodiscard]] HeadOpKind get_decreasing_head_op(NodeRef head) const {
+        return get_thresholds(head).empty() ? HeadOpKind::Narrow
+                                            : HeadOpKind::NarrowWithThreshold;
+    }
+
+    /// \brief Combine the states before and after an iteration at a cycle
+    /// head by the given operation.
+    ///
+    /// \param loc_ctx the location context of the head, only used by the
+    /// join and the widenings.
+    /// \param is_changed set to whether the state before changed, if the
+    /// operation tells it, see `ProgramState::widen`, or to std::nullopt.
+    [[nodiscard]] ProgramStateRef apply_head_op(
+        HeadOpKind op,
+        NodeRef head,
+        const ProgramStateRef& state_before,
+        const ProgramStateRef& state_after,
+        const LocationContext* loc_ctx,
+        std::optional< bool >& is_changed) const {
+        is_changed = std::nullopt;
+        bool is_op_changed = false;
+        ProgramStateRef state = state_after;
+        switch (op) {
+            case HeadOpKind::Join:
+                state = state_before->join_consecutive_iter(state_after,
+                                                            loc_ctx,
+                                                            is_op_changed);
+                is_changed = is_op_changed;
+                break;
+            case HeadOpKind::Widen:
+                state =
+                    state_before->widen(state_after, loc_ctx, is_op_changed);
+                is_changed = is_op_changed;
+                break;
+            case HeadOpKind::WidenWithThreshold:
+                state = state_before->widen_with_threshold(state_after,
+                                                           loc_ctx,
+                                                           get_thresholds(
+                                                               head));
+                break;
+            case HeadOpKind::Narrow:
+                state = state_before->narrow(state_after, is_op_changed);
+                // Only an unchanged state is known, see `narrow_with_changed`.
+                if (!is_op_changed) {
+                    is_changed = false;
+                }
+                break;
+            case HeadOpKind::NarrowWithThreshold:
+                state = state_before->narrow_with_threshold(state_after,
+                                                            get_thresholds(
+                                                                head));
+                break;
+        }
+        return state;
+    }
 
     /// \brief Enlarge the state at cycle head after an increasing iteration
     ///
@@ -100,26 +286,20 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
     /// \param iteration Iteration number
     /// \param state_before State before the iteration
     /// \param state_after State after the iteration
+    /// \param is_changed Whether the state before changed, if known
     [[nodiscard]] virtual ProgramStateRef enlarge_at_head_when_increasing(
-        [[maybe_unused]] NodeRef head,
+        NodeRef head,
         unsigned iter_cnt,
         const ProgramStateRef& state_before,
         const ProgramStateRef& state_after,
-        const LocationContext* loc_ctx) {
-        if (iter_cnt < m_analyzer_opts.widening_delay + 1) {
-            return state_before->join_consecutive_iter(state_after, loc_ctx);
-        }
-        if (m_analyzer_opts.analyze_with_threshold) {
-            if (!m_head_thresholds.contains(head)) {
-                m_head_thresholds[head] = get_threshold(head);
-            }
-            if (auto threshold = m_head_thresholds[head]) {
-                return state_before->widen_with_threshold(state_after,
-                                                          loc_ctx,
-                                                          *threshold);
-            }
-        }
-        return state_before->widen(state_after, loc_ctx);
+        const LocationContext* loc_ctx,
+        std::optional< bool >& is_changed) {
+        return apply_head_op(get_increasing_head_op(head, iter_cnt),
+                             head,
+                             state_before,
+                             state_after,
+                             loc_ctx,
+                             is_changed);
     }
 
     /// \brief Check if the increasing iterations fixpoint is reached
@@ -128,13 +308,22 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
     /// \param iter_cnt Iteration count
     /// \param state_before State before the iteration
     /// \param state_after State after the iteration
+    /// \param is_changed Whether the enlargement changed the state before,
+    /// the inclusion being checked if unknown
     [[nodiscard]] virtual bool is_increasing_fixpoint_reached(
         [[maybe_unused]] NodeRef head,
         [[maybe_unused]] unsigned iter_cnt,
         const ProgramStateRef& state_before,
-        const ProgramStateRef& state_after) {
-        return iter_cnt == m_analyzer_opts.max_widening_iterations ||
-               state_after->leq(*state_before);
+        const ProgramStateRef& state_after,
+        std::optional< bool > is_changed) {
+        if (iter_cnt == m_analyzer_opts.max_widening_iterations) {
+            return true;
+        }
+        if (is_changed) {
+            return !*is_changed;
+        }
+        // The states are interned, so a stable head is the same pointer.
+        return state_after == state_before || state_after->leq(*state_before);
     }
 
     /// \brief Narrow the state at loop head after a decreasing iteration
@@ -144,20 +333,17 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
     /// \param state_before State before the iteration
     /// \param state_after State after the iteration
     [[nodiscard]] virtual ProgramStateRef refine_at_loop_head_when_decreasing(
-        [[maybe_unused]] NodeRef head,
+        NodeRef head,
         [[maybe_unused]] unsigned iter_cnt,
-        [[maybe_unused]] const ProgramStateRef& state_before,
-        [[maybe_unused]] const ProgramStateRef& state_after) {
-        if (m_analyzer_opts.analyze_with_threshold) {
-            if (!m_head_thresholds.contains(head)) {
-                m_head_thresholds[head] = get_threshold(head);
-            }
-            if (auto threshold = m_head_thresholds[head]) {
-                return state_before->narrow_with_threshold(state_after,
-                                                           *threshold);
-            }
-        }
-        return state_before->narrow(state_after);
+        const ProgramStateRef& state_before,
+        const ProgramStateRef& state_after,
+        std::optional< bool >& is_changed) {
+        return apply_head_op(get_decreasing_head_op(head),
+                             head,
+                             state_before,
+                             state_after,
+                             nullptr,
+                             is_changed);
     }
 
     /// \brief Check if the decreasing iterations fixpoint is reached
@@ -166,13 +352,22 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
     /// \param iter_cnt Iteration count
     /// \param state_before State before the iteration
     /// \param state_after State after the iteration
+    /// \param is_changed Whether the refinement changed the state before,
+    /// the inclusion being checked if unknown
     virtual bool is_decreasing_fixpoint_reached(
         [[maybe_unused]] NodeRef head,
         [[maybe_unused]] unsigned iter_cnt,
         [[maybe_unused]] const ProgramStateRef& state_before,
-        [[maybe_unused]] const ProgramStateRef& state_after) {
-        return iter_cnt == m_analyzer_opts.max_narrowing_iterations ||
-               state_before->leq(*state_after);
+        [[maybe_unused]] const ProgramStateRef& state_after,
+        std::optional< bool > is_changed) {
+        if (iter_cnt == m_analyzer_opts.max_narrowing_iterations ||
+            is_budget_exceeded()) {
+            return true;
+        }
+        if (is_changed) {
+            return !*is_changed;
+        }
+        return state_before == state_after || state_before->leq(*state_after);
     }
 
     /// \brief Notify the beginning of handling a cycle
@@ -191,44 +386,142 @@ class WtoBasedFixPointIterator : public FixPointIterator< CFG, GraphTrait > {
              LocationManager& loc_mgr,
              const StackFrame* frame) override {
         this->clear();
+        this->m_start_time = std::chrono::steady_clock::now();
+        this->m_num_transfers = 0U;
+        this->m_degraded = false;
+        this->m_aborted = false;
         this->set_pre(GraphTrait::entry(this->m_cfg), std::move(init_state));
 
         // Compute the fixpoint
         WtoIterator iterator(*this, loc_mgr, frame);
-        this->m_wto.accept(iterator);
+        this->m_wto->accept(iterator);
         this->m_converged = true;
+        if (this->m_aborted) {
+            return;
+        }
 
         WtoChecker checker(*this, loc_mgr, frame);
-        this->m_wto.accept(checker);
+        this->m_wto->accept(checker);
     }
 
     /// \brief Clear the current fixpoint
     void clear() override {
         this->m_converged = false;
-        InvariantMap().swap(this->m_pre);
-        InvariantMap().swap(this->m_post);
+        this->m_pre.clear();
+        this->m_post.clear();
+        this->m_post_disjuncts.clear();
+        this->m_post_stamps.clear();
+        this->m_transfer_stamps.clear();
+        this->m_cycle_stamps.clear();
+        this->m_stamp = 0U;
     }
 
   private:
-    void set(InvariantMap& inv_map,
+    /// \brief Collect the thresholds of every cycle of the WTO.
+    ///
+    /// The constants compared in the conditions of a cycle, and their
+    /// neighbours for the strict comparisons, are the thresholds of its
+    /// head and of the heads of the enclosing cycles.
+    void build_thresholds();
+
+    /// \brief Append the thresholds found in the condition of `node`.
+    void collect_thresholds(NodeRef node, Thresholds& thresholds) const;
+
+    [[nodiscard]] ProgramStateRef transfer_node_in_budget(
+        NodeRef node, ProgramStateRef state) {
+        const llvm::TimeTraceScope scope("transfer_node", [node] {
+            return "B" + std::to_string(node->getBlockID());
+        });
+        if (!m_aborted && ++m_num_transfers % MemoryCheckInterval == 0U &&
+            is_memory_exceeded(2U)) {
+            m_aborted = true;
+            m_degraded = true;
+        }
+        // Bottom stops the propagation, so that the cycles converge
+        // without allocating.
+        if (m_aborted) {
+            return m_bottom;
+        }
+        return this->transfer_node(node, std::move(state));
+    }
+
+    void set(InvariantTable& inv_table,
              const NodeRef& node,
              ProgramStateRef state) {
         state = state->normalize();
-        inv_map[node] = std::move(state);
+        inv_table[node] = std::move(state);
     }
 
     void set_pre(NodeRef node, ProgramStateRef state) {
         set(m_pre, node, std::move(state));
     }
 
+    /// \brief Get the post states of the node kept apart, or its single
+    /// post state.
+    [[nodiscard]] llvm::ArrayRef< ProgramStateRef > get_post_disjuncts(
+        NodeRef node) const {
+        if (const auto* disjuncts = m_post_disjuncts.find(node);
+            disjuncts != nullptr && !disjuncts->empty()) {
+            return *disjuncts;
+        }
+        return get(m_post, node);
+    }
+
     void set_post(NodeRef node, ProgramStateRef state) {
-        set(m_post, node, std::move(state));
+        state = state->normalize();
+        // The states are interned, so an unchanged post state is the same
+        // pointer.
+        if (const auto* post = m_post.find(node);
+            post == nullptr || *post != state) {
+            m_post_stamps[node] = ++m_stamp;
+        }
+        m_post[node] = std::move(state);
     }
 
-    [[nodiscard]] const ProgramStateRef& get(const InvariantMap& inv_map,
+    /// \brief Set the post states of the node kept apart. The successors
+    /// read them apart, so a change of the disjuncts under an unchanged join
+    /// is still a change for the sparse mode.
+    void set_post_disjuncts(NodeRef node,
+                            DisjunctiveState::Disjuncts disjuncts) {
+        auto& post_disjuncts = m_post_disjuncts[node];
+        if (post_disjuncts != disjuncts) {
+            m_post_stamps[node] = ++m_stamp;
+        }
+        post_disjuncts = std::move(disjuncts);
+    }
+
+    /// \brief Check if none of the predecessors of the node changed since
+    /// its last transfer, in which case its invariants still hold.
+    [[nodiscard]] bool is_stable(NodeRef node) const {
+        const auto* transfer_stamp = m_transfer_stamps.find(node);
+        if (transfer_stamp == nullptr) {
+            return false;
+        }
+        for (auto it = GraphTrait::pred_begin(node),
+                  end = GraphTrait::pred_end(node);
+             it != end;
+             ++it) {
+            const auto* post_stamp = m_post_stamps.find(*it);
+            if (post_stamp != nullptr && *post_stamp > *transfer_stamp) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief Check if none of the nodes flowing into the cycle changed
+    /// since its last visit, in which case the invariants of the whole
+    /// cycle still hold.
+    [[nodiscard]] bool is_stable(const WtoCycleT& cycle);
+
+    /// \brief Get the nodes out of the cycle with an edge into it.
+    [[nodiscard]] llvm::ArrayRef< NodeRef > get_cycle_inputs(
+        const WtoCycleT& cycle);
+
+    [[nodiscard]] const ProgramStateRef& get(const InvariantTable& inv_table,
                                              const NodeRef& node) const {
-        auto it = inv_map.find(node);
-        return it == inv_map.end() ? m_bottom : it->second;
+        const auto* state = inv_table.find(node);
+        return state == nullptr ? m_bottom : *state;
     }
 
 }; // class WtoBasedFixPointIterator
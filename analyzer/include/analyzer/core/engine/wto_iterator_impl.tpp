@@ -6,7 +6,10 @@
 #include "wto_iterator.hpp"
 
 #include <clang/AST/Expr.h>
+#include <llvm/ADT/APSInt.h>
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
 
 #ifdef DEBUG_TYPE
@@ -19,68 +22,153 @@
 namespace knight::analyzer {
 
 template < graph CFG, typename GraphTrait >
-std::optional< ZNum > WtoBasedFixPointIterator< CFG, GraphTrait >::
-    get_threshold(NodeRef head) const {
-    if (const auto* cond = head->getLastCondition()) {
-        if (cond == nullptr) {
-            return std::nullopt;
+void WtoBasedFixPointIterator< CFG, GraphTrait >::collect_thresholds(
+    NodeRef node, Thresholds& thresholds) const {
+    const auto* cond = node->getLastCondition();
+    if (cond == nullptr) {
+        return;
+    }
+    cond = cond->IgnoreParenImpCasts();
+
+    if (llvm::isa< clang::DeclRefExpr >(cond)) {
+        thresholds.emplace_back(0);
+        return;
+    }
+    if (const auto* unary_cond = llvm::dyn_cast< clang::UnaryOperator >(cond)) {
+        if (unary_cond->getOpcode() == clang::UO_LNot) {
+            thresholds.emplace_back(0);
         }
-        cond = cond->IgnoreParenImpCasts();
+        return;
+    }
+    const auto* binary_cond = llvm::dyn_cast< clang::BinaryOperator >(cond);
+    if (binary_cond == nullptr || !binary_cond->isComparisonOp()) {
+        return;
+    }
+    auto& ast_ctx = get_cfg()->get_proc()->getASTContext();
+    clang::Expr::EvalResult res;
+    if (!binary_cond->getLHS()->EvaluateAsInt(res, ast_ctx) &&
+        !binary_cond->getRHS()->EvaluateAsInt(res, ast_ctx)) {
+        return;
+    }
+    // The strict comparisons and the exit edges bound the variables by
+    // the neighbours of the constant, the unsigned ones out of int64_t
+    // read with their signedness.
+    const auto& value = res.Val.getInt();
+    auto small = value.tryExtValue();
+    ZNum cst =
+        small ? ZNum(*small)
+              : *ZNum::from_string(llvm::toString(value, internal::K10Base));
+    thresholds.push_back(cst - 1);
+    thresholds.push_back(cst);
+    thresholds.push_back(cst + 1);
+}
 
-        if (llvm::isa< clang::DeclRefExpr >(cond)) {
-            return ZNum(0);
+template < graph CFG, typename GraphTrait >
+void WtoBasedFixPointIterator< CFG, GraphTrait >::build_thresholds() {
+    class ThresholdCollector final
+        : public WtoComponentVisitor< CFG, GraphTrait > {
+      private:
+        const WtoBasedFixPointIterator& m_iterator;
+        HeadThresholdMap& m_head_thresholds;
+        llvm::SmallVector< NodeRef, 4U > m_heads;
+
+      public:
+        ThresholdCollector(const WtoBasedFixPointIterator& iterator,
+                           HeadThresholdMap& head_thresholds)
+            : m_iterator(iterator), m_head_thresholds(head_thresholds) {}
+
+        void visit(const WtoVertex< CFG, GraphTrait >& vertex) override {
+            add(vertex.get_node());
         }
-        if (const auto* unary_cond =
-                llvm::dyn_cast_or_null< clang::UnaryOperator >(cond)) {
-            if (unary_cond->getOpcode() == clang::UO_LNot) {
-                return ZNum(0);
+
+        void visit(const WtoCycle< CFG, GraphTrait >& cycle) override {
+            m_heads.push_back(cycle.get_head());
+            add(cycle.get_head());
+            for (const auto* component : cycle.components()) {
+                component->accept(*this);
             }
+            m_heads.pop_back();
         }
-        if (const auto* binary_cond =
-                llvm::dyn_cast_or_null< clang::BinaryOperator >(cond);
-            binary_cond != nullptr && binary_cond->isComparisonOp()) {
-            bool lhs_cst = false;
-            std::optional< ZNum > cst = std::nullopt;
-            clang::Expr::EvalResult res;
-            if (binary_cond->getLHS()
-                    ->EvaluateAsInt(res,
-                                    get_cfg()->get_proc()->getASTContext())) {
-                cst = res.Val.getInt().getZExtValue();
-                lhs_cst = true;
-            } else if (binary_cond->getRHS()
-                           ->EvaluateAsInt(res,
-                                           get_cfg()
-                                               ->get_proc()
-                                               ->getASTContext())) {
-                cst = res.Val.getInt().getZExtValue();
+
+      private:
+        void add(NodeRef node) {
+            if (m_heads.empty()) {
+                return;
             }
-            if (!cst.has_value()) {
-                return std::nullopt;
+            Thresholds thresholds;
+            m_iterator.collect_thresholds(node, thresholds);
+            for (NodeRef head : m_heads) {
+                auto& head_thresholds = m_head_thresholds[head];
+                head_thresholds.append(thresholds.begin(), thresholds.end());
             }
-            ZNum threshold = *cst;
-            switch (binary_cond->getOpcode()) {
-                case clang::BO_LT: {
-                    if (lhs_cst) {
-                        threshold++;
-                    } else {
-                        threshold--;
-                    }
-                } break;
-
-                case clang::BO_GT: {
-                    if (lhs_cst) {
-                        threshold--;
-                    } else {
-                        threshold++;
-                    }
-                } break;
-                default:
-                    break;
+        }
+    }; // class ThresholdCollector
+
+    ThresholdCollector collector(*this, m_head_thresholds);
+    m_wto->accept(collector);
+    m_head_thresholds.for_each([](Thresholds& thresholds) {
+        llvm::sort(thresholds);
+        thresholds.erase(std::unique(thresholds.begin(), thresholds.end()),
+                         thresholds.end());
+    });
+}
+
+template < graph CFG, typename GraphTrait >
+llvm::ArrayRef< typename GraphTrait::NodeRef > WtoBasedFixPointIterator<
+    CFG,
+    GraphTrait >::get_cycle_inputs(const WtoCycleT& cycle) {
+    if (const auto* inputs = m_cycle_inputs.find(cycle.get_head())) {
+        return *inputs;
+    }
+
+    class NodeCollector final : public WtoComponentVisitor< CFG, GraphTrait > {
+      public:
+        llvm::SmallVector< NodeRef, 16U > nodes;
+
+        void visit(const WtoVertex< CFG, GraphTrait >& vertex) override {
+            nodes.push_back(vertex.get_node());
+        }
+
+        void visit(const WtoCycle< CFG, GraphTrait >& cycle) override {
+            nodes.push_back(cycle.get_head());
+            for (const auto* component : cycle.components()) {
+                component->accept(*this);
+            }
+        }
+    }; // class NodeCollector
+
+    NodeCollector collector;
+    collector.visit(cycle);
+    const llvm::DenseSet< NodeRef > in_cycle(collector.nodes.begin(),
+                                             collector.nodes.end());
+    llvm::DenseSet< NodeRef > seen;
+    auto& inputs = m_cycle_inputs[cycle.get_head()];
+    for (NodeRef node : collector.nodes) {
+        for (auto it = GraphTrait::pred_begin(node),
+                  end = GraphTrait::pred_end(node);
+             it != end;
+             ++it) {
+            if (!in_cycle.contains(*it) && seen.insert(*it).second) {
+                inputs.push_back(*it);
             }
-            return threshold;
         }
     }
-    return std::nullopt;
+    return inputs;
+}
+
+template < graph CFG, typename GraphTrait >
+bool WtoBasedFixPointIterator< CFG, GraphTrait >::is_stable(
+    const WtoCycleT& cycle) {
+    const auto* cycle_stamp = m_cycle_stamps.find(cycle.get_head());
+    if (cycle_stamp == nullptr) {
+        return false;
+    }
+    // The nodes out of the cycle are not transferred while visiting it,
+    // so their stamps are compared with the start of the last visit.
+    return llvm::all_of(get_cycle_inputs(cycle), [&](NodeRef input) {
+        const auto* post_stamp = m_post_stamps.find(input);
+        return post_stamp == nullptr || *post_stamp <= *cycle_stamp;
+    });
 }
 
 namespace impl {
@@ -130,6 +218,14 @@ class WtoIterator final : public WtoComponentVisitor< G, GraphTrait > {
 
     const LocationContext* get_location_context(const NodeRef& node) const;
 
+  private:
+    /// \brief Update the pre and post states of a WTO vertex keeping
+    /// apart up to `max_disjuncts` states from the predecessors.
+    ///
+    /// Each disjunct is transferred through the node separately, and the
+    /// invariants of the node are their join.
+    void visit_disjunctive(NodeRef node);
+
 }; // class WtoIterator
 template < graph G, typename GraphTrait >
 class WtoChecker final : public WtoComponentVisitor< G, GraphTrait > {
@@ -167,6 +263,18 @@ template < graph G, typename GraphTrait >
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void WtoIterator< G, GraphTrait >::visit(const WtoVertexT& vertex) {
     auto node = vertex.get_node();
+    if (this->m_fp_iterator.get_analyzer_options().sparse_fixpoint &&
+        this->m_fp_iterator.is_stable(node)) {
+        knight_log(llvm::outs()
+                   << "skip stable node: " << node->getBlockID() << "\n");
+        return;
+    }
+    // The stamp covering the predecessors joined below.
+    this->m_fp_iterator.m_transfer_stamps[node] = this->m_fp_iterator.m_stamp;
+    if (this->m_fp_iterator.get_analyzer_options().max_disjuncts > 1U) {
+        visit_disjunctive(node);
+        return;
+    }
     ProgramStateRef state_pre = this->m_fp_iterator.get_pre(node);
 
     knight_log(llvm::outs()
@@ -201,13 +309,70 @@ void WtoIterator< G, GraphTrait >::visit(const WtoVertexT& vertex) {
     this->m_fp_iterator.set_pre(node, state_pre);
     this->m_fp_iterator
         .set_post(node,
-                  this->m_fp_iterator.transfer_node(node,
-                                                    std::move(state_pre)));
+                  this->m_fp_iterator
+                      .transfer_node_in_budget(node, std::move(state_pre)));
+}
+
+template < graph G, typename GraphTrait >
+void WtoIterator< G, GraphTrait >::visit_disjunctive(NodeRef node) {
+    const auto* loc_ctx = get_location_context(node);
+    const unsigned max_disjuncts =
+        this->m_fp_iterator.get_analyzer_options().max_disjuncts;
+    const auto& bottom = this->m_fp_iterator.get_bottom();
+
+    // The inputs are recomputed from the predecessors at each visit, the
+    // entry has none but its initial state.
+    DisjunctiveState state_pre(max_disjuncts, bottom);
+    if (node == m_entry) {
+        state_pre.add(this->m_fp_iterator.get_pre(node), loc_ctx);
+    }
+    for (auto it = GraphTrait::pred_begin(node),
+              end = GraphTrait::pred_end(node);
+         it != end;
+         ++it) {
+        auto pred = *it;
+        for (const auto& post :
+             this->m_fp_iterator.get_post_disjuncts(pred)) {
+            state_pre.add(this->m_fp_iterator.transfer_edge(pred, node, post),
+                          loc_ctx);
+        }
+    }
+
+    knight_log(llvm::outs() << "wto visit node: " << node->getBlockID()
+                            << " with " << state_pre.get_disjuncts().size()
+                            << " disjuncts\n");
+
+    this->m_fp_iterator.set_pre(node, state_pre.collapse(loc_ctx));
+    if (state_pre.get_disjuncts().empty()) {
+        this->m_fp_iterator.set_post(node,
+                                     this->m_fp_iterator
+                                         .transfer_node_in_budget(node,
+                                                                  bottom));
+        this->m_fp_iterator.set_post_disjuncts(node, {});
+        return;
+    }
+
+    DisjunctiveState state_post(max_disjuncts, bottom);
+    for (const auto& pre : state_pre.get_disjuncts()) {
+        state_post.add(this->m_fp_iterator.transfer_node_in_budget(node, pre),
+                       loc_ctx);
+    }
+    this->m_fp_iterator.set_post(node, state_post.collapse(loc_ctx));
+    this->m_fp_iterator.set_post_disjuncts(node,
+                                           state_post.take_disjuncts());
 }
 
 template < graph G, typename GraphTrait >
 void WtoIterator< G, GraphTrait >::visit(const WtoCycleT& cycle) {
     auto head = cycle.get_head();
+    if (this->m_fp_iterator.is_stable(cycle)) {
+        // Typically a nested cycle visited again by the narrowing of an
+        // enclosing cycle which did not change its entry states.
+        knight_log(llvm::outs()
+                   << "skip stable cycle: " << head->getBlockID() << "\n");
+        return;
+    }
+    this->m_fp_iterator.m_cycle_stamps[head] = this->m_fp_iterator.m_stamp;
     ProgramStateRef state_pre = this->m_fp_iterator.get_bottom();
     auto& wto = this->m_fp_iterator.get_wto();
     const auto& nesting = wto.get_nesting(head);
@@ -236,13 +401,22 @@ void WtoIterator< G, GraphTrait >::visit(const WtoCycleT& cycle) {
     for (unsigned iter_cnt = 1;; ++iter_cnt) {
         knight_log(llvm::outs() << "iteration#" << iter_cnt << "\n");
 
+        const llvm::TimeTraceScope iteration_scope(
+            kind == IterationKind::Increasing ? "widening pass"
+                                              : "narrowing pass",
+            [&head, iter_cnt] {
+                return "B" + std::to_string(head->getBlockID()) + "#" +
+                       std::to_string(iter_cnt);
+            });
+
         this->m_fp_iterator.notify_each_cycle_iteration(head, iter_cnt, kind);
         state_pre = state_pre->normalize();
         knight_log(llvm::outs() << "set for head pre: " << *state_pre << "\n");
 
         this->m_fp_iterator.set_pre(head, state_pre);
 
-        auto state_post = this->m_fp_iterator.transfer_node(head, state_pre);
+        auto state_post =
+            this->m_fp_iterator.transfer_node_in_budget(head, state_pre);
         knight_log(llvm::outs()
                    << "set for head post: " << *state_post << "\n");
 
@@ -282,6 +456,7 @@ void WtoIterator< G, GraphTrait >::visit(const WtoCycleT& cycle) {
                           << "in increasing stage, head state_pre: "
                           << *state_pre
                           << "\nnew_state_front: " << *new_state_front << "\n");
+            std::optional< bool > is_changed;
             ProgramStateRef increased =
                 this->m_fp_iterator
                     .enlarge_at_head_when_increasing(head,
@@ -289,20 +464,23 @@ void WtoIterator< G, GraphTrait >::visit(const WtoCycleT& cycle) {
                                                      state_pre,
                                                      new_state_front,
                                                      get_location_context(
-                                                         head));
+                                                         head),
+                                                     is_changed);
             increased = increased->normalize();
 
             knight_log_nl(llvm::outs()
                           << "head increased state: " << *increased << "\n"
                           << "state_pre: " << *state_pre << "\n");
 
-            if (this->m_fp_iterator.is_increasing_fixpoint_reached(head,
-                                                                   iter_cnt,
-                                                                   state_pre,
-                                                                   increased)) {
+            if (this->m_fp_iterator.is_increasing_fixpoint_reached(
+                    head, iter_cnt, state_pre, increased, is_changed)) {
                 knight_log(llvm::outs() << "increasing fixpoint reached, turn "
                                            "to decreasing stage\n");
                 // Increasing fixpoint is reached
+                if (this->m_fp_iterator.is_degraded()) {
+                    // Out of budget, skip the narrowing.
+                    break;
+                }
                 kind = IterationKind::Decreasing;
                 iter_cnt = 1U;
             } else {
@@ -313,20 +491,20 @@ void WtoIterator< G, GraphTrait >::visit(const WtoCycleT& cycle) {
         }
 
         if (kind == IterationKind::Decreasing) {
+            std::optional< bool > is_changed;
             ProgramStateRef refined =
                 this->m_fp_iterator
                     .refine_at_loop_head_when_decreasing(head,
                                                          iter_cnt,
                                                          state_pre,
-                                                         new_state_front);
+                                                         new_state_front,
+                                                         is_changed);
             refined = refined->normalize();
             knight_log_nl(llvm::outs()
                           << "head refined state: " << *refined << "\n"
                           << "state_pre: " << *state_pre << "\n");
-            if (this->m_fp_iterator.is_decreasing_fixpoint_reached(head,
-                                                                   iter_cnt,
-                                                                   state_pre,
-                                                                   refined)) {
+            if (this->m_fp_iterator.is_decreasing_fixpoint_reached(
+                    head, iter_cnt, state_pre, refined, is_changed)) {
                 knight_log(llvm::outs() << "decreasing fixpoint reached\n");
                 // Decreasing fixpoint is reached
                 this->m_fp_iterator.set_pre(head, std::move(refined));
@@ -344,7 +522,7 @@ void WtoIterator< G, GraphTrait >::visit(const WtoCycleT& cycle) {
 template < graph G, typename GraphTrait >
 const LocationContext* WtoIterator< G, GraphTrait >::get_location_context(
     const NodeRef& node) const {
-    return m_loc_mgr.create_location_context(m_frame, -1, node);
+    return m_loc_mgr.get_block_location_contexts(m_frame, node).front();
 }
 
 template < graph G, typename GraphTrait >
@@ -0,0 +1,69 @@
+//===- liveness.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the liveness of the local variables and of the
+//  stmt values over a procedural CFG.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/proc_cfg.hpp"
+
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include <vector>
+
+namespace knight::analyzer {
+
+/// \brief Liveness of the local variables and of the stmt values at the
+/// exit of each block, used to drop the dead values from the states.
+///
+/// A stmt value is live if a later block reads it, i.e. the stmt is a
+/// sub-expression of a stmt evaluated there, a branch condition filtered
+/// in a successor or a returned value. A variable is live if a later
+/// block refers to it before declaring it again.
+///
+/// Only the local scalar variables which never escape, i.e. whose
+/// references are only loaded, assigned or incremented, are tracked.
+/// The other ones are always live.
+class Liveness {
+  private:
+    llvm::DenseMap< const clang::VarDecl*, unsigned > m_var_index;
+    llvm::DenseMap< ProcCFG::StmtRef, unsigned > m_stmt_index;
+
+    /// \brief The live variables and stmts at the block exits, by the
+    /// block IDs.
+    std::vector< llvm::BitVector > m_live_vars;
+    std::vector< llvm::BitVector > m_live_stmts;
+
+  public:
+    explicit Liveness(const ProcCFG& cfg);
+
+  public:
+    /// \brief Check if the variable may be read after the block.
+    [[nodiscard]] bool is_live_out(ProcCFG::NodeRef node,
+                                   const clang::VarDecl* var) const {
+        auto it = m_var_index.find(var);
+        return it == m_var_index.end() ||
+               m_live_vars[node->getBlockID()].test(it->second);
+    }
+
+    /// \brief Check if the value of the stmt may be read after the block.
+    [[nodiscard]] bool is_live_out(ProcCFG::NodeRef node,
+                                   ProcCFG::StmtRef stmt) const {
+        auto it = m_stmt_index.find(stmt);
+        return it != m_stmt_index.end() &&
+               m_live_stmts[node->getBlockID()].test(it->second);
+    }
+
+}; // class Liveness
+
+} // namespace knight::analyzer
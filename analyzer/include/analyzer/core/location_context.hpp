@@ -16,17 +16,100 @@
 
 #include "analyzer/core/stack_frame.hpp"
 
-#include <llvm/ADT/FoldingSet.h>
+#include <llvm/ADT/DenseMapInfo.h>
+
+#include <cstdint>
 
 namespace knight::analyzer {
 
-class LocationContext : public llvm::FoldingSetNode {
+/// \brief A location encoded in 64 bits, i.e. the dense ID of its stack
+/// frame, the ID of its block and the index of its element, -1 for the
+/// start point of the block.
+///
+/// Unlike a location context, it is a value that needs no interning nor
+/// allocation, and is decoded back by the location manager when the full
+/// frame is needed.
+class EncodedLocation {
+  public:
+    static constexpr unsigned FrameBits = 24U;
+    static constexpr unsigned BlockBits = 20U;
+    static constexpr unsigned ElementBits = 20U;
+
+  private:
+    static constexpr uint64_t BlockMask = (uint64_t{1} << BlockBits) - 1U;
+    static constexpr uint64_t ElementMask = (uint64_t{1} << ElementBits) - 1U;
+
+    uint64_t m_bits = 0U;
+
+    explicit constexpr EncodedLocation(uint64_t bits) : m_bits(bits) {}
+
+  public:
+    constexpr EncodedLocation() = default;
+
+    /// \brief Encode the location, the IDs fitting in their bits.
+    [[nodiscard]] static EncodedLocation get(DenseID frame_id,
+                                             unsigned block_id,
+                                             int element_id) {
+        // The highest frame ID is kept for the keys of the dense maps.
+        knight_assert_msg(uint64_t{frame_id} + 1U < (uint64_t{1} << FrameBits),
+                          "too many stack frames to encode");
+        knight_assert_msg(block_id <= BlockMask, "too many blocks to encode");
+        knight_assert_msg(element_id >= -1 &&
+                              static_cast< uint64_t >(element_id) + 1U <=
+                                  ElementMask,
+                          "too many elements to encode");
+        return EncodedLocation(
+            (uint64_t{frame_id} << (BlockBits + ElementBits)) |
+            (uint64_t{block_id} << ElementBits) |
+            static_cast< uint64_t >(element_id + 1));
+    }
+
+    [[nodiscard]] static constexpr EncodedLocation from_raw(uint64_t bits) {
+        return EncodedLocation(bits);
+    }
+
+    [[nodiscard]] constexpr uint64_t get_raw() const { return m_bits; }
+
+    [[nodiscard]] constexpr DenseID get_frame_id() const {
+        return static_cast< DenseID >(m_bits >> (BlockBits + ElementBits));
+    }
+
+    [[nodiscard]] constexpr unsigned get_block_id() const {
+        return static_cast< unsigned >((m_bits >> ElementBits) & BlockMask);
+    }
+
+    [[nodiscard]] constexpr int get_element_id() const {
+        return static_cast< int >(m_bits & ElementMask) - 1;
+    }
+
+    [[nodiscard]] constexpr bool is_block_start() const {
+        return (m_bits & ElementMask) == 0U;
+    }
+
+    [[nodiscard]] constexpr bool is_element() const {
+        return !is_block_start();
+    }
+
+    /// \brief The order of the frames, then of the blocks, then of the
+    /// elements.
+    [[nodiscard]] constexpr bool operator<(const EncodedLocation& other) const {
+        return m_bits < other.m_bits;
+    }
+
+    [[nodiscard]] constexpr bool operator==(
+        const EncodedLocation& other) const = default;
+}; // class EncodedLocation
+
+class LocationContext {
+    friend class LocationManager;
+
   private:
     const LocationManager* m_location_manager;
     const StackFrame* m_stack_frame;
     /// \brief -1 or >= 0, -1 means the start point of the block
     int m_element_id;
     const clang::CFGBlock* m_block;
+    DenseID m_dense_id = 0U;
 
   public:
     LocationContext(const LocationManager* manager,
@@ -44,6 +127,16 @@ class LocationContext : public llvm::FoldingSetNode {
 
     [[gnu::returns_nonnull, nodiscard]] const LocationManager*
     get_location_manager() const;
+
+    /// \brief Get the dense ID given by the location manager.
+    [[nodiscard]] DenseID get_dense_id() const { return m_dense_id; }
+
+    [[nodiscard]] EncodedLocation get_encoded_location() const {
+        return EncodedLocation::get(m_stack_frame->get_dense_id(),
+                                    m_block->getBlockID(),
+                                    m_element_id);
+    }
+
     [[nodiscard]] bool is_element() const { return m_element_id >= 0; }
     [[nodiscard]] bool is_block_start() const { return m_element_id == -1; }
     [[nodiscard]] int get_element_id() const { return m_element_id; }
@@ -93,14 +186,37 @@ class LocationContext : public llvm::FoldingSetNode {
         return std::nullopt;
     }
 
-    static void profile(llvm::FoldingSetNodeID& id,
-                        const StackFrame* stack_frame,
-                        unsigned element_id,
-                        const clang::CFGBlock* block);
-
-    void Profile(llvm::FoldingSetNodeID& id) const; // NOLINT
-
     void dump(llvm::raw_ostream& os) const;
 }; // class LocationContext
 
-} // namespace knight::analyzer
\ No newline at end of file
+} // namespace knight::analyzer
+
+namespace llvm {
+
+template <>
+struct DenseMapInfo< knight::analyzer::EncodedLocation > {
+    using EncodedLocation = knight::analyzer::EncodedLocation;
+
+    // NOLINTNEXTLINE
+    static inline EncodedLocation getEmptyKey() {
+        return EncodedLocation::from_raw(~uint64_t{0});
+    }
+
+    // NOLINTNEXTLINE
+    static inline EncodedLocation getTombstoneKey() {
+        return EncodedLocation::from_raw(~uint64_t{0} - 1U);
+    }
+
+    // NOLINTNEXTLINE
+    static unsigned getHashValue(const EncodedLocation& loc) {
+        return DenseMapInfo< uint64_t >::getHashValue(loc.get_raw());
+    }
+
+    // NOLINTNEXTLINE
+    static bool isEqual(const EncodedLocation& lhs,
+                        const EncodedLocation& rhs) {
+        return lhs == rhs;
+    }
+};
+
+} // namespace llvm
\ No newline at end of file
@@ -13,32 +13,175 @@
 
 #pragma once
 
+#include "analyzer/core/alias_classes.hpp"
+#include "analyzer/core/constraint/non_linear.hpp"
+#include "analyzer/core/liveness.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/stack_frame.hpp"
+#include "analyzer/util/wto.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include <vector>
 
 namespace knight::analyzer {
 
+/// \brief The stack frames and location contexts of the analyzed
+/// functions, along with the CFGs and the per-CFG caches they refer to.
+///
+/// A location manager belongs to one AST consumer, and its caches are only
+/// filled by the thread running that consumer, e.g. a function worker
+/// under `function_jobs`. The workers share the AST though, so the CFGs
+/// built on request take the AST mutex, see `get_cfg`.
 class LocationManager {
   private:
     std::unordered_map< const clang::Decl*, ProcCFG::GraphUniqueRef >
         m_decl_to_cfg;
 
+    /// \brief The WTOs of the CFGs above, shared by all their frames.
+    WtoCache< ProcCFG > m_wto_cache;
+
+    /// \brief The liveness of the CFGs above, computed on first request.
+    llvm::DenseMap< ProcCFG::GraphRef, std::unique_ptr< Liveness > >
+        m_liveness;
+
+    /// \brief The alias classes of the declarations above, computed on
+    /// first request.
+    llvm::DenseMap< ProcCFG::DeclRef, std::unique_ptr< AliasClasses > >
+        m_alias_classes;
+
+    /// \brief The non-linear solver sessions of the declarations above,
+    /// their caches only valid with the symbols of the function.
+    llvm::DenseMap< ProcCFG::DeclRef, std::unique_ptr< NonLinearSolver > >
+        m_non_linear_solvers;
+
+    /// \brief The optional kinds of elements of the CFGs built here.
+    CFGElementSet m_cfg_elements;
+
     llvm::BumpPtrAllocator m_allocator;
     llvm::FoldingSet< StackFrame > m_stack_frames;
-    llvm::FoldingSet< LocationContext > m_location_contexts;
+
+    /// \brief The stack frames by their dense IDs, to decode the encoded
+    /// locations.
+    std::vector< const StackFrame* > m_frames;
+
+    /// \brief The location contexts interned on their encoded locations.
+    llvm::DenseMap< EncodedLocation, const LocationContext* >
+        m_location_contexts;
+
+    /// \brief The location contexts of the elements of each block in each
+    /// frame, see `get_block_location_contexts`.
+    llvm::DenseMap< std::pair< const StackFrame*, const clang::CFGBlock* >,
+                    llvm::ArrayRef< const LocationContext* > >
+        m_block_location_contexts;
+
+    /// \brief The numbers of stack frames and location contexts, i.e. the
+    /// next dense IDs.
+    DenseID m_frame_cnt = 0U;
+    DenseID m_location_cnt = 0U;
 
   public:
     LocationManager() = default;
 
   public:
-    ProcCFG::GraphRef get_cfg(const clang::Decl* decl) const {
-        auto it = m_decl_to_cfg.find(decl);
-        if (it == m_decl_to_cfg.end()) {
-            return nullptr;
+    /// \brief Get the CFG of the given declaration, built on the first
+    /// request and shared by all its frames.
+    ///
+    /// The top-level functions of the workers come with their CFGs, see
+    /// `add_cfg`, while the callees are built here from the workers, under
+    /// the AST mutex since the CFG builder updates the AST context.
+    ProcCFG::GraphRef get_cfg(ProcCFG::DeclRef decl);
+
+    /// \brief Get the WTO of the CFG of the given declaration.
+    const Wto< ProcCFG >& get_wto(ProcCFG::DeclRef decl) {
+        return m_wto_cache.get(get_cfg(decl));
+    }
+
+    /// \brief Get the liveness over the CFG of the given declaration.
+    const Liveness& get_liveness(ProcCFG::DeclRef decl) {
+        auto* cfg = get_cfg(decl);
+        auto& liveness = m_liveness[cfg];
+        if (liveness == nullptr) {
+            liveness = std::make_unique< Liveness >(*cfg);
+        }
+        return *liveness;
+    }
+
+    /// \brief Get the alias classes of the variables of the given
+    /// declaration.
+    const AliasClasses& get_alias_classes(ProcCFG::DeclRef decl) {
+        auto& alias_classes = m_alias_classes[decl];
+        if (alias_classes == nullptr) {
+            alias_classes = std::make_unique< AliasClasses >(decl);
+        }
+        return *alias_classes;
+    }
+
+    /// \brief Get the non-linear solver session of the given declaration.
+    NonLinearSolver& get_non_linear_solver(ProcCFG::DeclRef decl) {
+        auto& solver = m_non_linear_solvers[decl];
+        if (solver == nullptr) {
+            solver = std::make_unique< NonLinearSolver >();
+        }
+        return *solver;
+    }
+
+    /// \brief Set the optional kinds of elements of the CFGs built from
+    /// now on.
+    void set_cfg_elements(const CFGElementSet& elements) {
+        m_cfg_elements = elements;
+    }
+
+    /// \brief Adopt a CFG built elsewhere for the given declaration.
+    void add_cfg(ProcCFG::DeclRef decl, ProcCFG::GraphUniqueRef cfg) {
+        auto& old_cfg = m_decl_to_cfg[decl];
+        if (old_cfg != nullptr) {
+            m_wto_cache.erase(old_cfg.get());
+            m_liveness.erase(old_cfg.get());
         }
-        return it->second.get();
+        old_cfg = std::move(cfg);
+    }
+
+    /// \brief Drop all the CFGs, stack frames and location contexts once
+    /// the analysis of a top-level function is finished.
+    void reset() {
+        m_stack_frames.clear();
+        m_frames.clear();
+        m_location_contexts.clear();
+        m_block_location_contexts.clear();
+        m_frame_cnt = 0U;
+        m_location_cnt = 0U;
+        m_allocator.Reset();
+        m_wto_cache.clear();
+        m_liveness.clear();
+        m_alias_classes.clear();
+        m_non_linear_solvers.clear();
+        m_decl_to_cfg.clear();
+    }
+
+    /// \brief Get the memory of the arena of the stack frames and the
+    /// location contexts.
+    [[nodiscard]] std::size_t get_arena_size() const {
+        return m_allocator.getTotalMemory();
     }
 
+    /// \brief Get the memory of the CFGs built so far.
+    [[nodiscard]] std::size_t get_cfg_memory_size() const {
+        std::size_t size = 0U;
+        for (const auto& [decl, cfg] : m_decl_to_cfg) {
+            size += cfg->get_memory_size();
+        }
+        return size;
+    }
+
+    /// \brief Get the number of stack frames, which bounds their dense IDs.
+    [[nodiscard]] DenseID get_frame_count() const { return m_frame_cnt; }
+
+    /// \brief Get the number of location contexts, which bounds their
+    /// dense IDs.
+    [[nodiscard]] DenseID get_location_count() const { return m_location_cnt; }
+
     const StackFrame* create_top_frame(ProcCFG::DeclRef decl);
     const StackFrame* create_from_node(StackFrame* parent,
                                        ProcCFG::NodeRef node,
@@ -53,8 +196,26 @@ class LocationManager {
         return create_location_context(stack_frame, -1, block);
     }
 
-  private:
-    void ensure_cfg_created(ProcCFG::DeclRef decl);
+    /// \brief Get the stack frame of the encoded location.
+    [[gnu::returns_nonnull, nodiscard]] const StackFrame* get_stack_frame(
+        EncodedLocation loc) const {
+        knight_assert_msg(loc.get_frame_id() < m_frames.size(),
+                          "unknown frame of the encoded location");
+        return m_frames[loc.get_frame_id()];
+    }
+
+    /// \brief Decode the location into its location context, which is only
+    /// needed for the full frame, e.g. to create symbols.
+    const LocationContext* get_location_context(EncodedLocation loc);
+
+    /// \brief Get the location contexts of the start point and of every
+    /// element of the block, the context of the element `i` being at the
+    /// index `i + 1`.
+    ///
+    /// The contexts are created once per frame and block, so that the
+    /// block transfers only index them.
+    llvm::ArrayRef< const LocationContext* > get_block_location_contexts(
+        const StackFrame* stack_frame, const clang::CFGBlock* block);
 }; // class LocationManager
 
 } // namespace knight::analyzer
\ No newline at end of file
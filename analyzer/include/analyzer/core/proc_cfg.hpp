@@ -17,13 +17,44 @@
 #include <clang/Analysis/CFG.h>
 
 #include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/STLExtras.h>
 #include "common/util/log.hpp"
 
 #include "common/support/dumpable.hpp"
 #include "common/support/graph.hpp"
+#include "common/util/assert.hpp"
+
+#include <bitset>
+#include <vector>
 
 namespace knight::analyzer {
 
+/// \brief The optional kinds of CFG elements, only built when an enabled
+/// analysis handles them.
+enum class CFGElementKind {
+    /// The base and member initializers of the constructors.
+    Initializer,
+    /// The begin and end of the variable scopes.
+    Scope,
+    /// The end of the lifetime of the automatic variables.
+    LifetimeEnds,
+    /// The implicit destructors of the automatic objects, including the
+    /// destructors of the bases and members.
+    ImplicitDtor,
+    /// The destructors of the temporaries.
+    TemporaryDtor,
+    /// The exits of the loops.
+    LoopExit,
+    /// The allocator calls of the `new` expressions.
+    NewAllocator,
+    /// The constructors, with their construction contexts.
+    Constructor,
+    NumKinds
+}; // enum class CFGElementKind
+
+using CFGElementSet =
+    std::bitset< static_cast< std::size_t >(CFGElementKind::NumKinds) >;
+
 /// \brief The simple procedural CFG wrapper of a clang::CFG.
 class ProcCFG {
   public:
@@ -36,8 +67,13 @@ class ProcCFG {
     using ExprRef = const clang::Expr*;
     using DeclRef = const clang::Decl*;
     using VarDeclRef = const clang::VarDecl*;
-    using PredNodeIterator = clang::CFGBlock::const_pred_iterator;
-    using SuccNodeIterator = clang::CFGBlock::const_succ_iterator;
+    using AdjacentFilter = bool (*)(const clang::CFGBlock::AdjacentBlock&);
+    using PredNodeIterator =
+        llvm::filter_iterator< clang::CFGBlock::const_pred_iterator,
+                               AdjacentFilter >;
+    using SuccNodeIterator =
+        llvm::filter_iterator< clang::CFGBlock::const_succ_iterator,
+                               AdjacentFilter >;
     using StmtToBlockMap = std::unordered_map< StmtRef, NodeRef >;
 
   private:
@@ -49,15 +85,22 @@ class ProcCFG {
     StmtToBlockMap m_stmt_to_block;
     /// \brief the cfg-syntax-level reachable blocks
     llvm::BitVector m_reachable_block;
+    /// \brief the blocks by their IDs
+    std::vector< NodeRef > m_nodes;
 
   public:
     /// \brief build a procedural CFG from a clang function declaration.
-    static GraphUniqueRef build(const clang::Decl* function);
+    ///
+    /// \param elements the optional kinds of elements to build, the
+    /// others are left out of the CFG.
+    static GraphUniqueRef build(const clang::Decl* function,
+                                const CFGElementSet& elements = {});
 
     /// \brief build a procedural CFG from a clang declaration and its body.
     static GraphUniqueRef build(FunctionRef function,
                                 clang::Stmt* build_scope,
-                                clang::ASTContext& ctx);
+                                clang::ASTContext& ctx,
+                                const CFGElementSet& elements = {});
 
   public:
     /// \brief get the entry node of the CFG.
@@ -67,21 +110,44 @@ class ProcCFG {
     static NodeRef exit(GraphRef cfg);
 
     /// \brief iterate over all the nodes of the CFG.
+    ///
+    /// The edges pruned by clang, e.g. the false edges of the constant
+    /// conditions, are skipped.
     /// @{
     static PredNodeIterator pred_begin(NodeRef node) {
-        return node->pred_begin();
+        return llvm::make_filter_range(node->preds(), &is_reachable_adjacent)
+            .begin();
+    }
+    static PredNodeIterator pred_end(NodeRef node) {
+        return llvm::make_filter_range(node->preds(), &is_reachable_adjacent)
+            .end();
     }
-    static PredNodeIterator pred_end(NodeRef node) { return node->pred_end(); }
     static NodeRef get_unique_pred(NodeRef node) {
         if (std::distance(pred_begin(node), pred_end(node)) != 1) {
             return nullptr;
         }
-        return *node->pred_begin();
+        return *pred_begin(node);
     }
     static SuccNodeIterator succ_begin(NodeRef node) {
-        return node->succ_begin();
+        return llvm::make_filter_range(node->succs(), &is_reachable_adjacent)
+            .begin();
+    }
+    static SuccNodeIterator succ_end(NodeRef node) {
+        return llvm::make_filter_range(node->succs(), &is_reachable_adjacent)
+            .end();
+    }
+    /// }@
+
+    /// \brief dense block IDs, used to index the per-block tables.
+    /// @{
+    static unsigned get_node_id(NodeRef node) { return node->getBlockID(); }
+    static unsigned num_nodes(GraphRef cfg) {
+        return cfg->m_cfg->getNumBlockIDs();
+    }
+    static NodeRef get_node(GraphRef cfg, unsigned id) {
+        knight_assert_msg(id < cfg->m_nodes.size(), "invalid block ID");
+        return cfg->m_nodes[id];
     }
-    static SuccNodeIterator succ_end(NodeRef node) { return node->succ_end(); }
     /// }@
 
     /// \brief dump the procedural CFG for debugging.
@@ -90,7 +156,19 @@ class ProcCFG {
 
     FunctionRef get_proc() const { return m_proc; }
 
+    /// \brief get the underlying clang cfg.
+    const clang::CFG& get_clang_cfg() const { return *m_cfg; }
+
+    /// \brief get the memory of the CFG, i.e., the arena of the clang cfg
+    /// and the tables of this wrapper.
+    [[nodiscard]] std::size_t get_memory_size() const;
+
   private:
+    static bool is_reachable_adjacent(
+        const clang::CFGBlock::AdjacentBlock& block) {
+        return block.getReachableBlock() != nullptr;
+    }
+
     /// \brief private constructor
     ProcCFG(FunctionRef proc,
             ClangCFGRef cfg,
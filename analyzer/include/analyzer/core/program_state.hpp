@@ -20,6 +20,7 @@
 #include "analyzer/core/domain/domains.hpp"
 #include "analyzer/core/domain/numerical/numerical_base.hpp"
 #include "analyzer/core/domain/pointer.hpp"
+#include "analyzer/core/liveness.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/proc_cfg.hpp"
 #include "analyzer/core/region/region.hpp"
@@ -27,12 +28,18 @@
 #include "analyzer/core/stack_frame.hpp"
 #include "analyzer/core/symbol.hpp"
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/ImmutableMap.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallVector.h>
+#include "common/util/lock.hpp"
 #include "common/util/log.hpp"
 
 namespace knight::analyzer {
@@ -64,11 +71,40 @@ namespace knight::analyzer {
 
 using ProgramStateRef = llvm::IntrusiveRefCntPtr< const ProgramState >;
 using DomValMap = llvm::DenseMap< DomID, SharedVal >;
-using RegionDefMap = llvm::DenseMap< std::pair< RegionRef, const StackFrame* >,
-                                     const RegionDef* >;
+
+/// \brief The region def map and the stmt sexpr map grow with the analyzed
+/// function, so they are persistent maps sharing their structure between
+/// states, and a single update only costs O(log n).
+///
+/// The domain value map only holds one value per enabled domain, and its
+/// reference counted values are not released by the immutable map nodes,
+/// so it stays a plain map.
+using RegionDefMap =
+    llvm::ImmutableMap< std::pair< RegionRef, const StackFrame* >,
+                        const RegionDef* >;
 using StmtSExprMap =
+    llvm::ImmutableMap< std::pair< ProcCFG::StmtRef, const StackFrame* >,
+                        SExprRef >;
+
+/// \brief The values of the stmts evaluated in the block being transferred.
+///
+/// Most stmt values are only read by the following stmts of their block,
+/// so during the fixpoint iteration they are kept in this table rather
+/// than in the states, and only the ones read by later blocks are stored
+/// in the state at the block exit.
+using StmtSExprScratch =
     llvm::DenseMap< std::pair< ProcCFG::StmtRef, const StackFrame* >,
                     SExprRef >;
+using StmtSExprEntry =
+    std::pair< std::pair< ProcCFG::StmtRef, const StackFrame* >, SExprRef >;
+
+/// \brief The numerical value of the block being transferred.
+///
+/// The numerical events of a block are applied in place on this value,
+/// instead of on a clone interned in a new state per event, and it is
+/// stored in the state once at the block exit. It is null until the
+/// first numerical update of the block.
+using ZDomScratch = SharedZNumericalVal;
 
 namespace internal {
 
@@ -77,8 +113,27 @@ ProgramStateRef get_persistent_state_with_copy_and_dom_val_map(
 
 } // namespace internal
 
+/// \brief The changes of a state from a previous one at the same program
+/// point, e.g. between two iterations at a cycle head.
+struct StateChanges {
+    /// \brief A region whose value changed, along with its previous and
+    /// new values in the numerical domain. They are top if the region is
+    /// not numerical, and the previous one is bottom if it was undefined.
+    struct RegionChange {
+        RegionRef region;
+        const StackFrame* frame;
+        ZInterval previous;
+        ZInterval value;
+    }; // struct RegionChange
+
+    /// \brief The domains whose values changed, sorted by their IDs.
+    llvm::SmallVector< DomID, 4U > domains;
+    std::vector< RegionChange > regions;
+}; // struct StateChanges
+
 class ProgramState : public llvm::FoldingSetNode {
     friend class ProgramStateManager;
+    friend class ProgramStateBuilder;
 
   public:
     using ValRefSet = std::unordered_set< AbsValRef >;
@@ -87,6 +142,9 @@ class ProgramState : public llvm::FoldingSetNode {
     /// \brief used in the refeference counting.
     unsigned m_ref_cnt;
 
+    /// \brief cached hash of the profile, computed once when interned.
+    unsigned m_hash;
+
     /// \brief domain value map. (domain id -> abstract value)
     DomValMap m_dom_val;
 
@@ -142,6 +200,43 @@ class ProgramState : public llvm::FoldingSetNode {
         return get_domain_id(m_zdom_kind);
     }
 
+    /// \brief Return the cached hash of the interned state.
+    [[nodiscard]] unsigned get_hash() const { return m_hash; }
+
+  private:
+    /// \brief A region defined differently in two merged states, bound to
+    /// `new_def` in the merged state.
+    struct DivergingDef {
+        const RegionDef* new_def;
+        const RegionDef* this_def;
+        const RegionDef* other_def;
+    }; // struct DivergingDef
+
+    /// \brief Merge the stmt sexprs of `other` into the ones of this state,
+    /// the ones of `other` taking precedence.
+    [[nodiscard]] StmtSExprMap merge_stmt_sexprs(
+        const ProgramState& other) const;
+
+    /// \brief Merge the region defs of `other` into the ones of this state
+    /// in one pass over both sorted maps.
+    ///
+    /// The regions defined differently get a new def at `loc_ctx`, and are
+    /// appended to `diverging_defs`.
+    [[nodiscard]] RegionDefMap merge_region_defs(
+        const ProgramState& other,
+        const LocationContext* loc_ctx,
+        llvm::SmallVectorImpl< DivergingDef >& diverging_defs) const;
+
+    /// \brief Bind the new defs to the defs of this state and of the other
+    /// one in two copies of the numerical domain, then merge them by `op`.
+    ///
+    /// \returns false if the numerical domain of this state is unchanged,
+    /// `op` telling if the merge changed it.
+    template < typename Op >
+    bool rebind_diverging_defs(DomValMap& dom_val,
+                               llvm::ArrayRef< DivergingDef > diverging_defs,
+                               Op op) const;
+
   public:
     [[nodiscard]] std::optional< RegionRef > get_region(
         ProcCFG::DeclRef decl, const StackFrame*) const;
@@ -154,11 +249,19 @@ class ProgramState : public llvm::FoldingSetNode {
     [[nodiscard]] ProgramStateRef set_region_def(RegionRef region,
                                                  const StackFrame* frame,
                                                  const RegionDef* def) const;
+    /// \brief Set the value of the stmt, into the scratch table of the
+    /// state manager if any, in which case the state is kept as is.
     [[nodiscard]] ProgramStateRef set_stmt_sexpr(ProcCFG::StmtRef stmt,
                                                  const StackFrame* frame,
                                                  SExprRef sexpr) const;
+    /// \brief Store the stmt values in the state at once.
+    [[nodiscard]] ProgramStateRef set_stmt_sexprs(
+        llvm::ArrayRef< StmtSExprEntry > entries) const;
     [[nodiscard]] ProgramStateRef set_constraint_system(
-        const ConstraintSystem& cst_system) const;
+        ConstraintSystem cst_system) const;
+    [[nodiscard]] const ConstraintSystem& get_constraint_system() const {
+        return m_constraint_system;
+    }
 
     [[nodiscard]] std::optional< const RegionDef* > get_region_def(
         RegionRef region, const StackFrame* frame) const;
@@ -178,30 +281,39 @@ class ProgramState : public llvm::FoldingSetNode {
   public:
     [[nodiscard]] ProgramStateRef add_zlinear_constraint(
         const ZLinearConstraint& constraint) const {
-        auto cst_system = m_constraint_system;
-        cst_system.add_zlinear_constraint(constraint);
-        return set_constraint_system(cst_system);
+        return add_zlinear_constraints(constraint);
     }
 
+    /// \brief Add the constraints to the constraint system at once.
+    [[nodiscard]] ProgramStateRef add_zlinear_constraints(
+        llvm::ArrayRef< ZLinearConstraint > constraints) const;
+
+    /// \brief Apply the constraints on the numerical domain and add them
+    /// to the constraint system, interning only the final state.
+    ///
+    /// \return the bottom state if the constraints are unsatisfiable.
+    [[nodiscard]] ProgramStateRef assume_zlinear_constraints(
+        llvm::ArrayRef< ZLinearConstraint > constraints) const;
+
     [[nodiscard]] ProgramStateRef merge_zlinear_constraint_system(
         const ZLinearConstraintSystem& system) const {
         auto cst_system = m_constraint_system;
         cst_system.merge_zlinear_constraint_system(system);
-        return set_constraint_system(cst_system);
+        return set_constraint_system(std::move(cst_system));
     }
 
     [[nodiscard]] ProgramStateRef add_non_linear_constraint(
         const SExprRef& constraint) const {
         auto cst_system = m_constraint_system;
         cst_system.add_non_linear_constraint(constraint);
-        return set_constraint_system(cst_system);
+        return set_constraint_system(std::move(cst_system));
     }
 
     [[nodiscard]] ProgramStateRef merge_non_linear_constraint_set(
         const ConstraintSystem::NonLinearConstraintSet& set) const {
         auto cst_system = m_constraint_system;
         cst_system.merge_non_linear_constraint_set(set);
-        return set_constraint_system(cst_system);
+        return set_constraint_system(std::move(cst_system));
     }
 
   public:
@@ -224,17 +336,10 @@ class ProgramState : public llvm::FoldingSetNode {
             static_cast< const Domain* >(it->second.get()));
     }
 
-    /// \brief Get the znumerical value reference.
+    /// \brief Get the znumerical value reference, which is the scratch
+    /// value of the state manager if any.
     [[nodiscard]] std::optional< const ZNumericalDomBase* > get_zdom_ref()
-        const {
-        auto it = m_dom_val.find(get_domain_id(m_zdom_kind));
-        if (it == m_dom_val.end()) {
-            return std::nullopt;
-        }
-        return std::make_optional(
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-static-cast-downcast)
-            static_cast< const ZNumericalDomBase* >(it->second.get()));
-    }
+        const;
 
     /// \brief Get the pointer domain reference.
     [[nodiscard]] std::optional< const PointerInfo* > get_pointer_dom_ref()
@@ -259,21 +364,14 @@ class ProgramState : public llvm::FoldingSetNode {
         if (it == m_dom_val.end()) {
             return std::static_pointer_cast< Domain >(Domain::default_val());
         }
-        std::shared_ptr< AbsDomBase > base_ptr(it->second->clone());
-        return std::static_pointer_cast< Domain >(base_ptr);
+        return std::static_pointer_cast< Domain >(it->second->clone_shared());
     }
 
     /// \brief Get the cloned znumerical value.
-    [[nodiscard]] SharedZNumericalVal get_zdom_clone() const {
-        auto it = m_dom_val.find(get_zdom_id());
-        if (it == m_dom_val.end()) {
-            auto default_fn = get_domain_default_val_fn(get_zdom_id());
-            return std::static_pointer_cast< ZNumericalDomBase >(
-                (*default_fn)());
-        }
-        std::shared_ptr< AbsDomBase > base_ptr(it->second->clone());
-        return std::static_pointer_cast< ZNumericalDomBase >(base_ptr);
-    }
+    ///
+    /// If the state manager has a scratch value, it is returned instead,
+    /// to be updated in place.
+    [[nodiscard]] SharedZNumericalVal get_zdom_clone() const;
 
     /// \brief Get the cloned pointer domain value.
     [[nodiscard]] std::shared_ptr< PointerInfo > get_pointer_dom_clone() const {
@@ -309,14 +407,9 @@ class ProgramState : public llvm::FoldingSetNode {
                                                            std::move(dom_val));
     }
 
-    [[nodiscard]] ProgramStateRef set_zdom(SharedZNumericalVal val) const {
-        auto dom_val = m_dom_val;
-        dom_val[get_zdom_id()] = std::move(val);
-        return internal::
-            get_persistent_state_with_copy_and_dom_val_map(get_state_manager(),
-                                                           *this,
-                                                           std::move(dom_val));
-    }
+    /// \brief Set the znumerical value, into the scratch value of the
+    /// state manager if any, in which case the state is kept as is.
+    [[nodiscard]] ProgramStateRef set_zdom(SharedZNumericalVal val) const;
 
     [[nodiscard]] ProgramStateRef set_pointer_dom(
         std::shared_ptr< PointerInfo > val) const {
@@ -328,6 +421,15 @@ class ProgramState : public llvm::FoldingSetNode {
                                                            std::move(dom_val));
     }
 
+    /// \brief Drop the stmt values and the defs of the variables of the
+    /// frame which are dead at the exit of the given block.
+    ///
+    /// The numerical values of the dropped defs are forgotten as well.
+    [[nodiscard]] ProgramStateRef remove_dead_values(
+        const StackFrame* frame,
+        const Liveness& liveness,
+        ProcCFG::NodeRef node) const;
+
   public:
     [[nodiscard]] ProgramStateRef normalize() const;
 
@@ -337,28 +439,84 @@ class ProgramState : public llvm::FoldingSetNode {
     [[nodiscard]] ProgramStateRef set_to_top() const;
 
     [[nodiscard]] ProgramStateRef join(const ProgramStateRef& other,
-                                       const LocationContext* loc_ctx) const;
+                                       const LocationContext* loc_ctx) const {
+        bool is_changed = false;
+        return join(other, loc_ctx, is_changed);
+    }
     [[nodiscard]] ProgramStateRef join_at_loop_head(
-        const ProgramStateRef& other, const LocationContext* loc_ctx) const;
+        const ProgramStateRef& other, const LocationContext* loc_ctx) const {
+        bool is_changed = false;
+        return join_at_loop_head(other, loc_ctx, is_changed);
+    }
     [[nodiscard]] ProgramStateRef join_consecutive_iter(
-        const ProgramStateRef& other, const LocationContext* loc_ctx) const;
+        const ProgramStateRef& other, const LocationContext* loc_ctx) const {
+        bool is_changed = false;
+        return join_consecutive_iter(other, loc_ctx, is_changed);
+    }
 
     [[nodiscard]] ProgramStateRef widen(const ProgramStateRef& other,
-                                        const LocationContext* loc_ctx) const;
+                                        const LocationContext* loc_ctx) const {
+        bool is_changed = false;
+        return widen(other, loc_ctx, is_changed);
+    }
+
+    /// \brief The upper bounds which also set `is_changed` if an abstract
+    /// value of this state changed, i.e. if the result is not included in
+    /// this state, so that a stable cycle head needs no inclusion check.
+    /// @{
+    [[nodiscard]] ProgramStateRef join(const ProgramStateRef& other,
+                                       const LocationContext* loc_ctx,
+                                       bool& is_changed) const;
+    [[nodiscard]] ProgramStateRef join_at_loop_head(
+        const ProgramStateRef& other,
+        const LocationContext* loc_ctx,
+        bool& is_changed) const;
+    [[nodiscard]] ProgramStateRef join_consecutive_iter(
+        const ProgramStateRef& other,
+        const LocationContext* loc_ctx,
+        bool& is_changed) const;
+    [[nodiscard]] ProgramStateRef widen(const ProgramStateRef& other,
+                                        const LocationContext* loc_ctx,
+                                        bool& is_changed) const;
+    /// @}
 
     [[nodiscard]] ProgramStateRef widen_with_threshold(
         const ProgramStateRef& other,
         const LocationContext* loc_ctx,
-        const ZNum& threshold) const;
+        llvm::ArrayRef< ZNum > thresholds) const;
 
     [[nodiscard]] ProgramStateRef meet(const ProgramStateRef& other) const;
-    [[nodiscard]] ProgramStateRef narrow(const ProgramStateRef& other) const;
+    [[nodiscard]] ProgramStateRef narrow(const ProgramStateRef& other) const {
+        bool is_changed = false;
+        return narrow(other, is_changed);
+    }
+
+    /// \brief The narrowing which also sets `is_changed` if an abstract
+    /// value of this state may have changed.
+    [[nodiscard]] ProgramStateRef narrow(const ProgramStateRef& other,
+                                         bool& is_changed) const;
     [[nodiscard]] ProgramStateRef narrow_with_threshold(
-        const ProgramStateRef& other, const ZNum& threshold) const;
+        const ProgramStateRef& other, llvm::ArrayRef< ZNum > thresholds) const;
 
     [[nodiscard]] bool leq(const ProgramState& other) const;
     [[nodiscard]] bool equals(const ProgramState& other) const;
 
+    /// \brief The number of domain values, region definitions and stmt
+    /// values shared with the other state, which ranks the states to join
+    /// first when too many are kept apart.
+    [[nodiscard]] unsigned get_similarity(const ProgramState& other) const;
+
+    /// \brief Get the changes of this state from the `previous` one.
+    ///
+    /// A region changed if its numerical value changed, or if it is bound
+    /// to another def without a numerical value.
+    [[nodiscard]] StateChanges get_changes(const ProgramState& previous) const;
+
+    /// \brief Get the numerical values of the defined regions, top if not
+    /// numerical, as the changes from an empty state.
+    [[nodiscard]] std::vector< StateChanges::RegionChange > get_region_values()
+        const;
+
     [[nodiscard]] bool operator==(const ProgramState& other) const {
         return equals(other);
     }
@@ -377,16 +535,10 @@ class ProgramState : public llvm::FoldingSetNode {
             id.AddInteger(dom_id);
             id.AddPointer(val.get());
         }
-        for (const auto& [region_frame_pair, def] : s->m_region_defs) {
-            id.AddPointer(region_frame_pair.first);
-            id.AddPointer(region_frame_pair.second);
-            id.AddPointer(def);
-        }
-        for (const auto& [stmt_frame_pair, sexpr] : s->m_stmt_sexpr) {
-            id.AddPointer(stmt_frame_pair.first);
-            id.AddPointer(stmt_frame_pair.second);
-            id.AddPointer(sexpr);
-        }
+        // The persistent maps are canonicalized by their factories, so
+        // equal maps share the same root.
+        RegionDefMap::Profile(id, s->m_region_defs);
+        StmtSExprMap::Profile(id, s->m_stmt_sexpr);
         s->m_constraint_system.Profile(id);
     }
 
@@ -404,11 +556,66 @@ inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
     return os;
 }
 
+} // namespace knight::analyzer
+
+namespace llvm {
+
+/// \brief Use the cached hash of the interned states, so that looking up
+/// or rehashing the state set only profiles the states on hash collision.
+template <>
+struct FoldingSetTrait< knight::analyzer::ProgramState >
+    : DefaultFoldingSetTrait< knight::analyzer::ProgramState > {
+    static bool Equals(knight::analyzer::ProgramState& state, // NOLINT
+                       const FoldingSetNodeID& id,
+                       unsigned id_hash,
+                       FoldingSetNodeID& temp_id) {
+        if (state.get_hash() != id_hash) {
+            return false;
+        }
+        state.Profile(temp_id);
+        return temp_id == id;
+    }
+
+    static unsigned ComputeHash(knight::analyzer::ProgramState& state, // NOLINT
+                                FoldingSetNodeID& /*temp_id*/) {
+        return state.get_hash();
+    }
+}; // struct FoldingSetTrait
+
+} // namespace llvm
+
+namespace knight::analyzer {
+
+/// \brief The number of the shards of the interned states, a power of two.
+constexpr unsigned StateShardNum = 16U;
+
 class ProgramStateManager {
     friend class ProgramState;
+    friend class ProgramStateBuilder;
 
     using ValRefSet = ProgramState::ValRefSet;
 
+  private:
+    /// \brief A stripe of the interned states, selected by the state hash.
+    ///
+    /// Each shard owns the arena and the free list of its states, so that
+    /// the threads interning or releasing states of different shards do
+    /// not contend on the same lock.
+    struct StateShard {
+        /// \brief The interned states of the shard.
+        llvm::FoldingSet< ProgramState > states;
+
+        /// \brief The arena of the states of the shard.
+        llvm::BumpPtrAllocator alloc;
+
+        /// \brief The dead states of the shard that we can reuse.
+        std::vector< ProgramState* > free_states;
+
+        /// \brief Guards the shard and the reference counts of its states
+        /// in the concurrent mode.
+        OptionalMutex mutex;
+    }; // struct StateShard
+
   private:
     /// \brief enabled domain IDs.
     DomIDs m_ids;
@@ -422,15 +629,26 @@ class ProgramStateManager {
     /// \brief Symbol manager.
     SymbolManager& m_symbol_mgr;
 
-    /// \brief  FoldingSet containing all the states created for analyzing
-    ///  a particular function.  This is used to unique states.
-    llvm::FoldingSet< ProgramState > m_state_set;
+    /// \brief The states created for analyzing a particular function,
+    /// uniqued in the shard of their hash.
+    std::array< StateShard, StateShardNum > m_shards;
 
-    /// \brief A BumpPtrAllocator to allocate states.
+    /// \brief A BumpPtrAllocator to allocate the nodes of the state maps,
+    /// which is reset once a function is analyzed. It is owned by the
+    /// arena context of the worker.
     llvm::BumpPtrAllocator& m_alloc;
 
-    /// \brief A vector of ProgramStates that we can reuse.
-    std::vector< ProgramState* > m_free_states;
+    /// \brief Factory of the region def maps.
+    std::unique_ptr< RegionDefMap::Factory > m_region_defs_factory;
+
+    /// \brief Factory of the stmt sexpr maps.
+    std::unique_ptr< StmtSExprMap::Factory > m_stmt_sexpr_factory;
+
+    /// \brief The stmt values of the block being transferred, if any.
+    StmtSExprScratch* m_stmt_scratch = nullptr;
+
+    /// \brief The numerical value of the block being transferred, if any.
+    ZDomScratch* m_zdom_scratch = nullptr;
 
   public:
     ProgramStateManager(AnalysisManager& analysis_mgr,
@@ -440,13 +658,64 @@ class ProgramStateManager {
         : m_analysis_mgr(analysis_mgr),
           m_region_mgr(region_mgr),
           m_symbol_mgr(symbol_mgr),
-          m_alloc(alloc) {}
+          m_alloc(alloc),
+          m_region_defs_factory(
+              std::make_unique< RegionDefMap::Factory >(m_alloc)),
+          m_stmt_sexpr_factory(
+              std::make_unique< StmtSExprMap::Factory >(m_alloc)) {}
 
   public:
     [[nodiscard]] const DomIDs& dom_ids() const { return m_ids; }
 
     [[nodiscard]] llvm::BumpPtrAllocator& get_allocator() { return m_alloc; }
 
+    [[nodiscard]] RegionDefMap::Factory& get_region_defs_factory() {
+        return *m_region_defs_factory;
+    }
+
+    [[nodiscard]] StmtSExprMap::Factory& get_stmt_sexpr_factory() {
+        return *m_stmt_sexpr_factory;
+    }
+
+    /// \brief The memory allocated by the arenas of the states, the symbols
+    /// and the regions, checked against the memory budget.
+    [[nodiscard]] std::size_t get_arena_size() const;
+
+    /// \brief The memory allocated by the arenas of the states only.
+    [[nodiscard]] std::size_t get_state_arena_size() const;
+
+    /// \brief Drop the arena of the states once the analysis of a function
+    /// is finished.
+    ///
+    /// Dead states are already removed from the state set and recycled on
+    /// release, so only the memory of the arena is reclaimed here. Nothing
+    /// is done if some states are still alive.
+    void reset();
+
+    /// \brief Redirect the stmt values set on the states to the given
+    /// scratch table, or back to the states if null.
+    ///
+    /// \return the previous scratch table, to be restored by the caller.
+    StmtSExprScratch* set_stmt_scratch(StmtSExprScratch* scratch) {
+        return std::exchange(m_stmt_scratch, scratch);
+    }
+
+    /// \brief Redirect the numerical values of the states to the given
+    /// scratch value, or back to the states if null.
+    ///
+    /// \return the previous scratch value, to be restored by the caller.
+    ZDomScratch* set_zdom_scratch(ZDomScratch* scratch) {
+        return std::exchange(m_zdom_scratch, scratch);
+    }
+
+    /// \brief Switch the concurrent mode, in which the states can be
+    /// retained, released and interned from multiple threads.
+    void set_concurrent(bool is_concurrent) {
+        for (auto& shard : m_shards) {
+            shard.mutex.set_concurrent(is_concurrent);
+        }
+    }
+
   public:
     [[nodiscard]] DomainKind get_zdom_kind() const {
         return m_analysis_mgr.get_context().get_current_options().zdom;
@@ -482,6 +751,73 @@ class ProgramStateManager {
   private:
     friend void retain_state(const ProgramState* state);
     friend void release_state(const ProgramState* state);
+
+    [[nodiscard]] StateShard& get_shard(unsigned hash) {
+        return m_shards[hash & (StateShardNum - 1U)];
+    }
+
+    /// \brief The number of the interned states over all the shards.
+    [[nodiscard]] std::size_t get_num_states();
 }; // class ProgramStateManager
 
+/// \brief A transient and mutable copy of a state, edited in place during
+/// the transfer of a stmt and interned once by `freeze()`.
+///
+/// The domain values and the constraint system are only copied on their
+/// first update. The stmt values and the numerical value still go to the
+/// scratches of the state manager if any, as on the states.
+class ProgramStateBuilder {
+  private:
+    ProgramStateRef m_base;
+    std::optional< DomValMap > m_dom_val;
+    RegionDefMap m_region_defs;
+    StmtSExprMap m_stmt_sexpr;
+    std::optional< ConstraintSystem > m_constraint_system;
+    bool m_is_changed = false;
+
+  public:
+    explicit ProgramStateBuilder(ProgramStateRef base);
+
+    ProgramStateBuilder(const ProgramStateBuilder&) = delete;
+    ProgramStateBuilder& operator=(const ProgramStateBuilder&) = delete;
+
+  public:
+    ProgramStateBuilder& set_region_def(RegionRef region,
+                                        const StackFrame* frame,
+                                        const RegionDef* def);
+    ProgramStateBuilder& set_stmt_sexpr(ProcCFG::StmtRef stmt,
+                                        const StackFrame* frame,
+                                        SExprRef sexpr);
+
+    ProgramStateBuilder& add_zlinear_constraint(
+        const ZLinearConstraint& constraint) {
+        return add_zlinear_constraints(constraint);
+    }
+    ProgramStateBuilder& add_zlinear_constraints(
+        llvm::ArrayRef< ZLinearConstraint > constraints);
+
+    /// \brief Set the given domain to the given abstract val.
+    template < typename Domain >
+    ProgramStateBuilder& set(SharedVal val) {
+        get_dom_val()[get_domain_id(Domain::get_kind())] = std::move(val);
+        return *this;
+    }
+
+    ProgramStateBuilder& set_zdom(SharedZNumericalVal val);
+
+    /// \brief Intern the edited state.
+    ///
+    /// \return the base state if nothing was changed. The builder can be
+    /// edited further on top of the returned state.
+    [[nodiscard]] ProgramStateRef freeze();
+
+  private:
+    [[nodiscard]] ProgramStateManager& get_state_manager() const {
+        return m_base->get_state_manager();
+    }
+
+    [[nodiscard]] DomValMap& get_dom_val();
+
+}; // class ProgramStateBuilder
+
 } // namespace knight::analyzer
@@ -19,15 +19,24 @@
 #include <clang/AST/Expr.h>
 #include <clang/AST/Type.h>
 
+#include <cstdint>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/FoldingSet.h>
 #include <llvm/ADT/PointerIntPair.h>
+#include <llvm/ADT/SmallVector.h>
+#include "common/util/lock.hpp"
 #include "common/util/log.hpp"
 
 #include "analyzer/core/constraint/linear.hpp"
 #include "analyzer/core/region/regions.hpp"
 #include "analyzer/core/stack_frame.hpp"
 #include "analyzer/core/symbol.hpp"
+#include "analyzer/support/dense_id.hpp"
 #include "analyzer/tooling/diagnostic.hpp"
+#include "analyzer/tooling/stats.hpp"
 
 namespace knight::analyzer {
 
@@ -279,6 +288,8 @@ class UnknownSpaceRegion : public MemSpaceRegion {
 /// \brief Base class for all memory regions.
 
 class TypedRegion : public llvm::FoldingSetNode {
+    friend class RegionManager;
+
   protected:
     TypedRegion(RegionKind kind, MemSpaceRegionRef space, RegionRef parent)
         : m_kind(kind), m_space(space), m_parent(parent) {}
@@ -292,9 +303,15 @@ class TypedRegion : public llvm::FoldingSetNode {
     MemSpaceRegionRef m_space;
     RegionRef m_parent;
 
+  private:
+    DenseID m_dense_id = 0U;
+
   public:
     [[nodiscard]] RegionKind get_kind() const { return m_kind; }
 
+    /// \brief Get the dense ID given by the region manager.
+    [[nodiscard]] DenseID get_dense_id() const { return m_dense_id; }
+
     [[nodiscard]] RegionManager& get_manager() const;
     [[nodiscard]] clang::ASTContext& get_ast_ctx() const;
     [[nodiscard]] MemSpaceRegionRef get_memory_space() const { return m_space; }
@@ -870,10 +887,22 @@ class SymbolicRegion : public TypedRegion {
 
 }; // class SymbolicRegion
 
+/// \brief The layout of a field in its record.
+struct FieldLayout {
+    const clang::FieldDecl* field;
+
+    /// \brief The offset of the field in its record, in bits.
+    uint64_t offset;
+
+    clang::QualType type;
+}; // struct FieldLayout
+
 class RegionManager {
   private:
-    clang::ASTContext* m_ast_ctx;
+    clang::ASTContext* m_ast_ctx{};
 
+    /// \brief The arena of the regions, owned by the arena context of the
+    /// worker.
     llvm::BumpPtrAllocator& m_allocator;
     llvm::FoldingSet< TypedRegion > m_region_set;
 
@@ -889,23 +918,63 @@ class RegionManager {
     std::unordered_map< const StackFrame*, const StackArgSpaceRegion* >
         m_stack_arg_space_regions;
 
+    /// \brief The regions of the variables in their frames, resolved on
+    /// every variable reference, so they skip the region profiling.
+    llvm::DenseMap< std::pair< const clang::VarDecl*, const StackFrame* >,
+                    RegionRef >
+        m_var_regions;
+
+    /// \brief The field layouts of the records, only queried once from the
+    /// AST context. They outlive the regions, but not the AST context.
+    llvm::DenseMap< const clang::RecordDecl*, std::vector< FieldLayout > >
+        m_record_layouts;
+
+    /// \brief The number of typed regions, i.e. the next dense ID.
+    DenseID m_region_cnt = 0U;
+
+    /// \brief Guards the regions when they are created by concurrent
+    /// checkers.
+    OptionalMutex m_mutex;
+
   public:
     explicit RegionManager(llvm::BumpPtrAllocator& allocator)
-
         : m_allocator(allocator) {}
 
+    /// \brief Switch the concurrent mode, in which the regions can be
+    /// created from multiple threads.
+    void set_concurrent(bool is_concurrent) {
+        m_mutex.set_concurrent(is_concurrent);
+    }
+
   public:
-    void set_ast_ctx(clang::ASTContext& ast_ctx) { m_ast_ctx = &ast_ctx; }
+    void set_ast_ctx(clang::ASTContext& ast_ctx) {
+        if (m_ast_ctx != &ast_ctx) {
+            m_record_layouts.clear();
+        }
+        m_ast_ctx = &ast_ctx;
+    }
 
     [[nodiscard]] clang::ASTContext& get_ast_ctx() const {
         knight_assert_msg(m_ast_ctx != nullptr, "ast context is not set");
         return *m_ast_ctx;
     }
 
-    [[nodiscard]] llvm::BumpPtrAllocator& get_allocator() const {
+    [[nodiscard]] llvm::BumpPtrAllocator& get_allocator() {
         return m_allocator;
     }
 
+    /// \brief The memory allocated by the arena of the regions.
+    [[nodiscard]] std::size_t get_arena_size() const {
+        return m_allocator.getTotalMemory();
+    }
+
+    /// \brief Drop all the regions once the analysis of a top-level
+    /// function is finished.
+    void reset();
+
+    /// \brief Get the number of typed regions, which bounds their dense IDs.
+    [[nodiscard]] DenseID get_region_count() const { return m_region_cnt; }
+
     /// \brief Get a memory space region
     const StackLocalSpaceRegion* get_stack_local_space_region(
         const StackFrame* frame);
@@ -960,13 +1029,27 @@ class RegionManager {
         StackArgSpaceRegion* arg_space,
         RegionRef parent);
 
+    /// \brief Get the layout of the fields of a record in their declaration
+    /// order, which is empty if the record is incomplete.
+    [[nodiscard]] llvm::ArrayRef< FieldLayout > get_record_layout(
+        const clang::RecordDecl* record);
+
+    /// \brief Get the regions of the fields of a record region, in the
+    /// order of the record layout.
+    [[nodiscard]] llvm::SmallVector< const FieldRegion*, 4U > get_field_regions(
+        RegionRef record_region);
+
   public:
     RegionRef get_region(const clang::VarDecl* var_decl,
                          const StackFrame* frame);
 
   private:
+    RegionRef resolve_region(const clang::VarDecl* var_decl,
+                             const StackFrame* frame);
+
     template < typename Space, typename... Args >
     const Space* get_persistent_space(Space*& region, Args&&... args) {
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
         if (region == nullptr) {
             region = new (m_allocator) // NOLINT
                 Space(*this, std::forward< Args >(args)...);
@@ -977,6 +1060,7 @@ class RegionManager {
 
     template < typename Region, typename... Args >
     const Region* get_persistent_region(Args&&... args) {
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
         llvm::FoldingSetNodeID id;
         Region::profile(id, std::forward< Args >(args)...);
 
@@ -986,6 +1070,8 @@ class RegionManager {
         if (region == nullptr) {
             region = new (m_allocator) // NOLINT
                 Region(std::forward< Args >(args)...);
+            region->m_dense_id = m_region_cnt++;
+            Stats::count(StatKind::RegionsCreated);
             m_region_set.InsertNode(region, insert_pos);
         }
         return region;
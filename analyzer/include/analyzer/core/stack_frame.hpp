@@ -20,6 +20,8 @@
 #include "common/util/log.hpp"
 
 #include "analyzer/core/proc_cfg.hpp"
+#include "analyzer/util/wto.hpp"
+#include "analyzer/support/dense_id.hpp"
 #include "common/util/assert.hpp"
 
 namespace knight::analyzer {
@@ -38,11 +40,14 @@ struct alignas(CallSiteInfoAlignment) CallSiteInfo {
 }; // struct CallSiteInfo
 
 class StackFrame : public llvm::FoldingSetNode {
+    friend class LocationManager;
+
   private:
     LocationManager* m_manager;
     const clang::Decl* m_decl;
     StackFrame* m_parent{};
     CallSiteInfo m_call_site_info;
+    DenseID m_dense_id = 0U;
 
   public:
     StackFrame(LocationManager* manager,
@@ -55,6 +60,7 @@ class StackFrame : public llvm::FoldingSetNode {
 
   public:
     [[nodiscard]] ProcCFG::GraphRef get_cfg() const;
+    [[nodiscard]] const Wto< ProcCFG >& get_wto() const;
     [[nodiscard]] const LocationContext* get_entry_location() const;
 
     [[nodiscard]] clang::ASTContext& get_ast_context() const {
@@ -67,6 +73,9 @@ class StackFrame : public llvm::FoldingSetNode {
 
     [[gnu::returns_nonnull, nodiscard]] LocationManager* get_manager() const;
 
+    /// \brief Get the dense ID given by the location manager.
+    [[nodiscard]] DenseID get_dense_id() const { return m_dense_id; }
+
     [[nodiscard]] StackFrame* get_parent() const { return m_parent; }
     [[nodiscard]] bool is_top_frame() const { return m_parent == nullptr; }
 
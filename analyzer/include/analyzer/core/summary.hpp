@@ -0,0 +1,121 @@
+//===- summary.hpp ----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the function summaries of the bottom-up
+//  interprocedural analysis.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/interval.hpp"
+#include "common/util/lock.hpp"
+
+#include <clang/AST/Decl.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace knight::analyzer {
+
+/// \brief Summary of a function, applied at its call sites instead of
+/// leaving the result of the call unconstrained.
+struct FunctionSummary {
+    /// \brief Values returned by the function, top if unknown.
+    ZInterval return_values = ZInterval::top();
+}; // struct FunctionSummary
+
+/// \brief The summaries of the functions of a translation unit.
+///
+/// The functions are analyzed callees first, so that a call site finds
+/// the summary of its callee unless both are in the same recursive
+/// component, in which case the call stays unconstrained.
+class SummaryManager {
+  private:
+    using FunctionRefs = std::vector< const clang::FunctionDecl* >;
+
+    std::unordered_map< const clang::FunctionDecl*, FunctionSummary >
+        m_summaries;
+
+    /// \brief The analyzed callees of each function.
+    std::unordered_map< const clang::FunctionDecl*, FunctionRefs > m_callees;
+
+    /// \brief Guards the summaries when the functions are analyzed by
+    /// concurrent workers.
+    mutable OptionalMutex m_mutex;
+
+  public:
+    /// \brief Switch the concurrent mode, in which the summaries can be
+    /// published and queried from multiple threads.
+    void set_concurrent(bool is_concurrent) {
+        m_mutex.set_concurrent(is_concurrent);
+    }
+
+    /// \brief Get the summary of the function, or null if not analyzed.
+    [[nodiscard]] const FunctionSummary* get_summary(
+        const clang::FunctionDecl* function) const {
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
+        auto it = m_summaries.find(function->getCanonicalDecl());
+        // The elements of the map are stable across insertions.
+        return it == m_summaries.end() ? nullptr : &it->second;
+    }
+
+    void set_summary(const clang::FunctionDecl* function,
+                     FunctionSummary summary) {
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
+        m_summaries.insert_or_assign(function->getCanonicalDecl(),
+                                     std::move(summary));
+    }
+
+    /// \brief Record the callees of the function, whose summaries the
+    /// analysis of the function depends on.
+    ///
+    /// \note Shall be called before the analysis, in the sequential mode.
+    void set_callees(const clang::FunctionDecl* function,
+                     FunctionRefs callees) {
+        m_callees.insert_or_assign(function->getCanonicalDecl(),
+                                   std::move(callees));
+    }
+
+    /// \brief Get a digest of the current summaries of the callees.
+    ///
+    /// Together with the body of the function, it identifies the result
+    /// of the analysis of the function, so that a change of a callee
+    /// summary invalidates the cached results of its callers.
+    [[nodiscard]] std::string get_callee_digest(
+        const clang::FunctionDecl* function) const {
+        auto it = m_callees.find(function->getCanonicalDecl());
+        if (it == m_callees.end()) {
+            return {};
+        }
+        std::string digest;
+        llvm::raw_string_ostream os(digest);
+        for (const auto* callee : it->second) {
+            os << callee->getQualifiedNameAsString() << "=";
+            if (const auto* summary = get_summary(callee)) {
+                os << summary->return_values;
+            } else {
+                os << "?";
+            }
+            os << ";";
+        }
+        return os.str();
+    }
+
+    void reset() {
+        m_summaries.clear();
+        m_callees.clear();
+    }
+
+}; // class SummaryManager
+
+} // namespace knight::analyzer
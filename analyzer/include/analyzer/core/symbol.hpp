@@ -13,7 +13,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <optional>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -21,6 +23,7 @@
 #include "analyzer/core/domain/num/znum.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/stack_frame.hpp"
+#include "analyzer/support/dense_id.hpp"
 #include "analyzer/support/symbol.hpp"
 #include "common/support/dumpable.hpp"
 #include "common/util/log.hpp"
@@ -30,12 +33,13 @@
 #include <clang/AST/Type.h>
 #include <clang/Basic/SourceLocation.h>
 #include <llvm/ADT/APSInt.h>
+#include <llvm/ADT/FoldingSet.h>
 #include <llvm/ADT/StringRef.h>
 
 namespace knight::analyzer {
 
 /// \brief The kind of symbol expression.
-enum class SymExprKind {
+enum class SymExprKind : uint8_t {
     None,
 
     SCALAR_BEGIN,
@@ -90,11 +94,20 @@ class SymIterator {
 }; // class SymIterator
 
 /// Numerical symbol(Integer for now).
-class SymExpr : public llvm::FoldingSetNode {
+///
+/// The symbolic expressions are hash-consed by the symbol manager on the
+/// structural keys of their subclasses, i.e. the `Key` tuple returned by
+/// `get_key()`, whose kind is given by `get_key_kind()`.
+class SymExpr {
+    friend class SymbolManager;
+
   protected:
     SymExprKind m_kind;
     mutable unsigned m_complexity{0U};
 
+  private:
+    DenseID m_dense_id = 0U;
+
   protected:
     explicit SymExpr(SymExprKind kind) : m_kind(kind) {}
 
@@ -103,6 +116,9 @@ class SymExpr : public llvm::FoldingSetNode {
 
     [[nodiscard]] SymExprKind get_kind() const { return m_kind; }
 
+    /// \brief Get the dense ID given by the symbol manager.
+    [[nodiscard]] DenseID get_dense_id() const { return m_dense_id; }
+
     [[nodiscard]] virtual clang::QualType get_type() const = 0;
 
     [[nodiscard]] virtual unsigned get_worst_complexity() const = 0;
@@ -180,6 +196,18 @@ class ScalarInt : public Scalar {
 
     void dump(llvm::raw_ostream& os) const override { os << m_value; }
 
+    using Key = std::tuple< const ZNum&, clang::QualType >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::Int;
+    }
+
+    [[nodiscard]] static Key get_key(const ZNum& value, clang::QualType type) {
+        return {value, type};
+    }
+
+    [[nodiscard]] Key get_key() const { return {m_value, m_type}; }
+
     static void profile(llvm::FoldingSetNodeID& id,
                         const ZNum& value,
                         clang::QualType type) {
@@ -215,6 +243,18 @@ class RegionAddr : public Scalar {
 
     void dump(llvm::raw_ostream& os) const override;
 
+    using Key = std::tuple< const TypedRegion* >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::Region;
+    }
+
+    [[nodiscard]] static Key get_key(const TypedRegion* region) {
+        return Key{region};
+    }
+
+    [[nodiscard]] Key get_key() const { return Key{m_region}; }
+
     static void profile(llvm::FoldingSetNodeID& id, const TypedRegion* region) {
         id.AddInteger(static_cast< unsigned >(SymExprKind::Region));
         id.AddPointer(region);
@@ -273,6 +313,25 @@ class RegionDef : public Sym {
     [[gnu::returns_nonnull]] RegionRef get_region() const;
     [[nodiscard]] bool is_external() const { return m_is_external; }
 
+    /// \brief The symbol ID is not part of the key, so a region has one
+    /// def per location context.
+    using Key = std::tuple< RegionRef, const LocationContext*, bool >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::RegionSymbolVal;
+    }
+
+    [[nodiscard]] static Key get_key([[maybe_unused]] SymID sid,
+                                     RegionRef region,
+                                     const LocationContext* loc_ctx,
+                                     bool is_external) {
+        return {region, loc_ctx, is_external};
+    }
+
+    [[nodiscard]] Key get_key() const {
+        return {m_region, m_loc_ctx, m_is_external};
+    }
+
     static void profile(llvm::FoldingSetNodeID& id,
                         [[maybe_unused]] SymID sid,
                         RegionRef region,
@@ -325,6 +384,19 @@ class RegionSymExtent : public Sym {
 
     [[gnu::returns_nonnull]] const TypedRegion* get_region() const;
 
+    using Key = std::tuple< const TypedRegion* >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::RegionSymbolExtent;
+    }
+
+    [[nodiscard]] static Key get_key([[maybe_unused]] SymID sid,
+                                     const TypedRegion* region) {
+        return Key{region};
+    }
+
+    [[nodiscard]] Key get_key() const { return Key{m_region}; }
+
     static void profile(llvm::FoldingSetNodeID& id, const TypedRegion* region) {
         id.AddInteger(static_cast< unsigned >(SymExprKind::RegionSymbolExtent));
         id.AddPointer(region);
@@ -386,6 +458,35 @@ class SymbolConjured : public Sym {
 
     [[nodiscard]] const void* get_tag() const { return m_tag; }
 
+    /// \brief The symbol ID is not part of the key, and the type is keyed
+    /// without its sugar and qualifiers, so a statement has one conjured
+    /// symbol per frame and tag.
+    using Key = std::tuple< const clang::Stmt*,
+                            clang::QualType,
+                            const StackFrame*,
+                            const void* >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::SymbolConjured;
+    }
+
+    [[nodiscard]] static clang::QualType get_key_type(clang::QualType type) {
+        return type.isNull() ? type
+                             : type.getCanonicalType().getUnqualifiedType();
+    }
+
+    [[nodiscard]] static Key get_key([[maybe_unused]] SymID sid,
+                                     const clang::Stmt* stmt,
+                                     clang::QualType type,
+                                     const StackFrame* frame,
+                                     const void* tag = nullptr) {
+        return {stmt, get_key_type(type), frame, tag};
+    }
+
+    [[nodiscard]] Key get_key() const {
+        return {m_stmt, get_key_type(m_type), m_frame, m_tag};
+    }
+
     static void profile(llvm::FoldingSetNodeID& id,
                         [[maybe_unused]] SymID sid,
                         const clang::Stmt* stmt,
@@ -394,7 +495,7 @@ class SymbolConjured : public Sym {
                         const void* tag = nullptr) {
         id.AddInteger(static_cast< unsigned >(SymExprKind::SymbolConjured));
         id.AddPointer(stmt);
-        id.Add(type);
+        id.Add(get_key_type(type));
         id.AddPointer(frame);
         id.AddPointer(tag);
     }
@@ -461,6 +562,20 @@ class CastSymExpr : public SymExpr {
 
     void dump(llvm::raw_ostream& os) const override;
 
+    using Key = std::tuple< const SymExpr*, clang::QualType, clang::QualType >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::CastSym;
+    }
+
+    [[nodiscard]] static Key get_key(const SymExpr* operand,
+                                     clang::QualType src,
+                                     clang::QualType dst) {
+        return {operand, src, dst};
+    }
+
+    [[nodiscard]] Key get_key() const { return {m_operand, m_src, m_dst}; }
+
     static void profile(llvm::FoldingSetNodeID& id,
                         const SymExpr* operand,
                         clang::QualType src,
@@ -552,6 +667,33 @@ class BinarySymExpr : public SymExpr {
 
     [[nodiscard]] bool is_leaf() const override { return true; }
 
+    /// \brief Get the linear expression of `lhs op rhs` from the ones of
+    /// the operands, if it is linear.
+    [[nodiscard]] static std::optional< ZLinearExpr > fold_zexpr(
+        clang::BinaryOperator::Opcode opcode,
+        const std::optional< ZLinearExpr >& lhs,
+        const std::optional< ZLinearExpr >& rhs);
+
+    using Key = std::tuple< const SymExpr*,
+                            const SymExpr*,
+                            clang::BinaryOperator::Opcode,
+                            clang::QualType >;
+
+    [[nodiscard]] static constexpr SymExprKind get_key_kind() {
+        return SymExprKind::BinarySymEx;
+    }
+
+    [[nodiscard]] static Key get_key(const SymExpr* lhs,
+                                     const SymExpr* rhs,
+                                     clang::BinaryOperator::Opcode opcode,
+                                     clang::QualType type) {
+        return {lhs, rhs, opcode, type};
+    }
+
+    [[nodiscard]] Key get_key() const {
+        return {m_lhs, m_rhs, m_opcode, m_type};
+    }
+
     static void profile(llvm::FoldingSetNodeID& id,
                         const SymExpr* lhs,
                         const SymExpr* rhs,
@@ -17,20 +17,195 @@
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/region/region.hpp"
 #include "analyzer/core/stack_frame.hpp"
+#include "analyzer/tooling/stats.hpp"
+#include "common/util/lock.hpp"
 #include "symbol.hpp"
 
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Hashing.h>
+#include <llvm/Support/Allocator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
 namespace knight::analyzer {
 
+namespace internal {
+
+[[nodiscard]] inline llvm::hash_code hash_key_field(clang::QualType type) {
+    return llvm::hash_value(type.getAsOpaquePtr());
+}
+
+[[nodiscard]] inline llvm::hash_code hash_key_field(const ZNum& num) {
+    return llvm::hash_value(hash_value(num));
+}
+
+template < typename T >
+[[nodiscard]] llvm::hash_code hash_key_field(const T& field) {
+    return llvm::hash_value(field);
+}
+
+/// \brief Hash the structural key of a symbolic expression.
+template < typename Key >
+[[nodiscard]] uint64_t hash_sexpr_key(SymExprKind kind, const Key& key) {
+    return std::apply(
+        [kind](const auto&... fields) {
+            return static_cast< uint64_t >(
+                llvm::hash_combine(kind, hash_key_field(fields)...));
+        },
+        key);
+}
+
+} // namespace internal
+
+/// \brief An open-addressing table hash-consing the symbolic expressions
+/// on the precomputed hashes of their structural keys.
+///
+/// A lookup probes a flat array of hashes and never builds a profile, the
+/// keys are only compared on the matching hashes.
+class SExprTable {
+  private:
+    struct Entry {
+        uint64_t hash = 0U;
+        SymExprKind key_kind = SymExprKind::None;
+        SymExpr* sexpr = nullptr;
+    }; // struct Entry
+
+    /// \brief The slots, whose number is zero or a power of two.
+    std::vector< Entry > m_entries;
+    std::size_t m_size = 0U;
+
+    static constexpr std::size_t MinCapacity = 256U;
+
+  public:
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
+    template < typename STy >
+    [[nodiscard]] STy* find(uint64_t hash, const typename STy::Key& key) const {
+        if (m_entries.empty()) {
+            return nullptr;
+        }
+        const std::size_t mask = m_entries.size() - 1U;
+        for (std::size_t i = hash & mask;; i = (i + 1U) & mask) {
+            const auto& entry = m_entries[i];
+            if (entry.sexpr == nullptr) {
+                return nullptr;
+            }
+            // The key kinds tell the subclasses apart, so the cast is safe.
+            if (entry.hash == hash && entry.key_kind == STy::get_key_kind()) {
+                auto* sexpr = static_cast< STy* >(entry.sexpr);
+                if (sexpr->get_key() == key) {
+                    return sexpr;
+                }
+            }
+        }
+    }
+
+    void insert(uint64_t hash, SymExprKind key_kind, SymExpr* sexpr) {
+        // Keep the load factor under 3/4.
+        if ((m_size + 1U) * 4U > m_entries.size() * 3U) {
+            grow();
+        }
+        place(m_entries, {hash, key_kind, sexpr});
+        ++m_size;
+    }
+
+    template < typename Fn >
+    void for_each(Fn fn) const {
+        for (const auto& entry : m_entries) {
+            if (entry.sexpr != nullptr) {
+                fn(entry.sexpr);
+            }
+        }
+    }
+
+    /// \brief Empty the table, keeping its slots for the next function.
+    void clear() {
+        std::fill(m_entries.begin(), m_entries.end(), Entry{});
+        m_size = 0U;
+    }
+
+  private:
+    static void place(std::vector< Entry >& entries, const Entry& entry) {
+        const std::size_t mask = entries.size() - 1U;
+        std::size_t i = entry.hash & mask;
+        while (entries[i].sexpr != nullptr) {
+            i = (i + 1U) & mask;
+        }
+        entries[i] = entry;
+    }
+
+    void grow() {
+        std::vector< Entry > entries(
+            std::max(MinCapacity, m_entries.size() * 2U));
+        for (const auto& entry : m_entries) {
+            if (entry.sexpr != nullptr) {
+                place(entries, entry);
+            }
+        }
+        m_entries = std::move(entries);
+    }
+}; // class SExprTable
+
 class SymbolManager {
   private:
+    /// \brief The arena of the symbols, owned by the arena context of the
+    /// worker.
     llvm::BumpPtrAllocator& m_allocator;
-    llvm::FoldingSet< SymExpr > m_sexpr_set;
+    SExprTable m_sexpr_table;
+
+    /// \brief The number of symbols, i.e. the last symbol ID. Only the
+    /// created symbols take an ID, so that the symbol reused by a later
+    /// fixpoint iteration keeps the same name.
     SymID m_sym_cnt = 0U;
 
+    /// \brief The number of symbolic expressions, i.e. the next dense ID.
+    DenseID m_sexpr_cnt = 0U;
+
+    /// \brief The linear expressions of the binary expressions, which are
+    /// interned on (op, lhs, rhs, type) and linearized again at every
+    /// fixpoint iteration.
+    llvm::DenseMap< const BinarySymExpr*, std::optional< ZLinearExpr > >
+        m_zexpr_cache;
+
+    /// \brief Guards the symbols when they are created by concurrent
+    /// checkers.
+    OptionalMutex m_mutex;
+
   public:
     explicit SymbolManager(llvm::BumpPtrAllocator& allocator)
         : m_allocator(allocator) {}
 
+    /// \brief Switch the concurrent mode, in which the symbols can be
+    /// created from multiple threads.
+    void set_concurrent(bool is_concurrent) {
+        m_mutex.set_concurrent(is_concurrent);
+    }
+
+    /// \brief Drop all the symbols once the analysis of a top-level
+    /// function is finished.
+    void reset() {
+        // Some symbols own memory, e.g., the value of the scalar integers.
+        m_sexpr_table.for_each([](SymExpr* sexpr) { sexpr->~SymExpr(); });
+        m_sexpr_table.clear();
+        m_zexpr_cache.clear();
+        m_sym_cnt = 0U;
+        m_sexpr_cnt = 0U;
+        m_allocator.Reset();
+    }
+
+    /// \brief The memory allocated by the arena of the symbols.
+    [[nodiscard]] std::size_t get_arena_size() const {
+        return m_allocator.getTotalMemory();
+    }
+
+    /// \brief Get the number of symbolic expressions, which bounds their
+    /// dense IDs.
+    [[nodiscard]] DenseID get_sexpr_count() const { return m_sexpr_cnt; }
+
     [[nodiscard]] const ScalarInt* get_scalar_int(const ZNum& value,
                                                   clang::QualType type) {
         return get_persistent_sexpr< ScalarInt >(value, type);
@@ -40,28 +215,26 @@ class SymbolManager {
         return get_persistent_sexpr< RegionAddr >(region);
     }
 
+    /// \brief Get the def of the region at the location, e.g. the def
+    /// merging the diverging defs of a join, which is the same one at every
+    /// fixpoint iteration.
     [[nodiscard]] const RegionDef* get_region_def(
         const TypedRegion* typed_region, const LocationContext* loc_ctx) {
-        m_sym_cnt++;
         const auto* space = typed_region->get_memory_space();
         bool is_external = space == nullptr || space->is_stack_arg();
-        return get_persistent_sexpr< RegionDef >(m_sym_cnt,
-                                                 typed_region,
-                                                 loc_ctx,
-                                                 is_external);
+        return get_persistent_sym< RegionDef >(typed_region,
+                                               loc_ctx,
+                                               is_external);
     }
 
+    /// \brief Get the symbol conjured for the value of the statement,
+    /// which is the same one at every fixpoint iteration.
     [[nodiscard]] const SymbolConjured* get_symbol_conjured(
         const clang::Stmt* stmt,
         clang::QualType type,
         const StackFrame* frame,
         const void* tag = nullptr) {
-        m_sym_cnt++;
-        return get_persistent_sexpr< SymbolConjured >(m_sym_cnt,
-                                                      stmt,
-                                                      type,
-                                                      frame,
-                                                      tag);
+        return get_persistent_sym< SymbolConjured >(stmt, type, frame, tag);
     }
 
     [[nodiscard]] const SymbolConjured* get_symbol_conjured(
@@ -79,21 +252,59 @@ class SymbolManager {
         return get_persistent_sexpr< BinarySymExpr >(lhs, rhs, op, type);
     }
 
+    /// \brief Get the linear expression of `sexpr`, memoized on the binary
+    /// expressions.
+    [[nodiscard]] std::optional< ZLinearExpr > get_zexpr(SExprRef sexpr) {
+        const auto* binary = llvm::dyn_cast< BinarySymExpr >(sexpr);
+        if (binary == nullptr) {
+            return sexpr->get_as_zexpr();
+        }
+
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
+        if (auto it = m_zexpr_cache.find(binary); it != m_zexpr_cache.end()) {
+            return it->second;
+        }
+        std::optional< ZLinearExpr > zexpr;
+        if (binary->get_type()->isIntegralOrEnumerationType()) {
+            zexpr = BinarySymExpr::fold_zexpr(binary->get_opcode(),
+                                              get_zexpr(binary->get_lhs()),
+                                              get_zexpr(binary->get_rhs()));
+        }
+        return m_zexpr_cache.try_emplace(binary, std::move(zexpr))
+            .first->second;
+    }
+
   private:
+    /// \brief Get the interned symbol, giving the next symbol ID to the
+    /// symbol only if it is created.
+    template < typename STy, typename... Args >
+    [[nodiscard]] const STy* get_persistent_sym(Args&&... args) {
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
+        const auto* sym =
+            get_persistent_sexpr< STy >(m_sym_cnt + 1U,
+                                        std::forward< Args >(args)...);
+        if (sym->get_id() == m_sym_cnt + 1U) {
+            ++m_sym_cnt;
+        }
+        return sym;
+    }
+
     template < typename STy, typename... Args >
     [[nodiscard]] const STy* get_persistent_sexpr(Args&&... args) {
-        llvm::FoldingSetNodeID id;
-        STy::profile(id, std::forward< Args >(args)...);
-
-        void* insert_pos; // NOLINT
-        auto* region = cast_or_null< STy >(
-            m_sexpr_set.FindNodeOrInsertPos(id, insert_pos));
-        if (region == nullptr) {
-            region = new (m_allocator) // NOLINT
-                STy(std::forward< Args >(args)...);
-            m_sexpr_set.InsertNode(region, insert_pos);
+        const std::lock_guard< OptionalMutex > lock(m_mutex);
+        const typename STy::Key key = STy::get_key(args...);
+        const uint64_t hash =
+            internal::hash_sexpr_key(STy::get_key_kind(), key);
+        if (const auto* sexpr = m_sexpr_table.find< STy >(hash, key)) {
+            return sexpr;
         }
-        return static_cast< const STy* >(region);
+
+        auto* sexpr = new (m_allocator) // NOLINT
+            STy(std::forward< Args >(args)...);
+        sexpr->m_dense_id = m_sexpr_cnt++;
+        Stats::count(StatKind::SymbolsCreated);
+        m_sexpr_table.insert(hash, STy::get_key_kind(), sexpr);
+        return sexpr;
     }
 }; // class SymbolManager
 
@@ -0,0 +1,46 @@
+//===- dense_id.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the dense IDs of the interned objects.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+namespace knight::analyzer {
+
+/// \brief The ID of an interned object, dense in `[0, count)` among the
+/// objects of its manager, so that it can index vectors and bitsets.
+using DenseID = uint32_t;
+
+template < typename T >
+concept has_dense_id = requires(const T& obj) {
+    { obj.get_dense_id() } -> std::same_as< DenseID >;
+};
+
+/// \brief Order the references by the dense IDs of the referred objects,
+/// which unlike their addresses do not vary from run to run.
+template < typename Ref >
+struct DenseIDLess {
+    [[nodiscard]] bool operator()(const Ref& lhs, const Ref& rhs) const {
+        if constexpr (std::is_pointer_v< Ref > &&
+                      has_dense_id< std::remove_pointer_t< Ref > >) {
+            return lhs->get_dense_id() < rhs->get_dense_id();
+        } else {
+            return std::less< Ref >()(lhs, rhs);
+        }
+    }
+}; // struct DenseIDLess
+
+} // namespace knight::analyzer
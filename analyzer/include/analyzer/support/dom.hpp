@@ -91,6 +91,45 @@ struct does_derived_dom_can_narrow_with // NOLINT
     : std::bool_constant< derived_dom_has_narrow_with_method< DerivedDom > > {
 }; // struct does_derived_dom_can_narrow_with
 
+template < typename DerivedDom >
+concept derived_dom_has_join_with_changed_method = requires {
+    {
+        &DerivedDom::join_with_changed
+    } -> std::same_as< bool (DerivedDom::*)(const DerivedDom&) >;
+};
+
+template < typename DerivedDom >
+struct does_derived_dom_can_join_with_changed // NOLINT
+    : std::bool_constant<
+          derived_dom_has_join_with_changed_method< DerivedDom > > {
+}; // struct does_derived_dom_can_join_with_changed
+
+template < typename DerivedDom >
+concept derived_dom_has_widen_with_changed_method = requires {
+    {
+        &DerivedDom::widen_with_changed
+    } -> std::same_as< bool (DerivedDom::*)(const DerivedDom&) >;
+};
+
+template < typename DerivedDom >
+struct does_derived_dom_can_widen_with_changed // NOLINT
+    : std::bool_constant<
+          derived_dom_has_widen_with_changed_method< DerivedDom > > {
+}; // struct does_derived_dom_can_widen_with_changed
+
+template < typename DerivedDom >
+concept derived_dom_has_narrow_with_changed_method = requires {
+    {
+        &DerivedDom::narrow_with_changed
+    } -> std::same_as< bool (DerivedDom::*)(const DerivedDom&) >;
+};
+
+template < typename DerivedDom >
+struct does_derived_dom_can_narrow_with_changed // NOLINT
+    : std::bool_constant<
+          derived_dom_has_narrow_with_changed_method< DerivedDom > > {
+}; // struct does_derived_dom_can_narrow_with_changed
+
 template < typename DerivedDom >
 concept derived_dom_has_leq_method = requires {
     {
@@ -0,0 +1,231 @@
+//===- cache.hpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the persistent per-function analysis result cache.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/summary.hpp"
+#include "analyzer/tooling/diagnostic.hpp"
+#include "analyzer/tooling/options.hpp"
+#include "common/util/sqlite3.hpp"
+
+#include <clang/AST/Decl.h>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace knight {
+
+constexpr unsigned DefaultCacheBusyTimeoutMills = 5000U;
+
+/// \brief The persistent cache of the diagnostics reported on a function.
+///
+/// The cache lives in `<knight_dir>/analysis_cache.db`. A function is keyed
+/// by its location, its ODR hash, and the options affecting the analysis
+/// result, so any change of the body or of the enabled analyses and
+/// checkers invalidates the entry.
+class AnalysisCache {
+  private:
+    sqlite::Database m_db;
+
+  public:
+    explicit AnalysisCache(const std::string& knight_dir,
+                           int busy_time_mills =
+                               DefaultCacheBusyTimeoutMills) noexcept(false);
+
+    /// \brief Open the cache in the given directory.
+    ///
+    /// \returns nullptr if the cache database cannot be opened.
+    [[nodiscard]] static std::unique_ptr< AnalysisCache > open(
+        const std::string& knight_dir);
+
+  public:
+    /// \brief Get the cache key of the given function under the options.
+    [[nodiscard]] static std::string get_key(
+        const clang::FunctionDecl* function, const KnightOptions& opts);
+
+    /// \brief Get the part of the cache keys covering the options
+    /// affecting the analysis results.
+    [[nodiscard]] static std::string get_options_key(
+        const KnightOptions& opts);
+
+    /// \brief Serialize the diagnostics to the stored text.
+    [[nodiscard]] static std::string serialize_diags(
+        const std::vector< KnightDiagnostic >& diags);
+
+    /// \brief Deserialize the stored text of diagnostics.
+    ///
+    /// \returns std::nullopt if the text is malformed.
+    [[nodiscard]] static std::optional< std::vector< KnightDiagnostic > >
+    deserialize_diags(llvm::StringRef text);
+
+    /// \brief Get the cached diagnostics of the given key.
+    ///
+    /// \returns std::nullopt if the key is not cached.
+    [[nodiscard]] std::optional< std::vector< KnightDiagnostic > > lookup(
+        const std::string& key) const;
+
+    /// \brief Store the diagnostics of the given key.
+    void store(const std::string& key,
+               const std::vector< KnightDiagnostic >& diags);
+
+    /// \brief Get the cached summary of the given key.
+    ///
+    /// \returns std::nullopt if the key is not cached.
+    [[nodiscard]] std::optional< analyzer::FunctionSummary > lookup_summary(
+        const std::string& key) const;
+
+    /// \brief Store the summary of the given key.
+    void store_summary(const std::string& key,
+                       const analyzer::FunctionSummary& summary);
+
+  private:
+    void create_table_if_not_exist() const noexcept;
+
+}; // class AnalysisCache
+
+/// \brief The version of the layout of the checkpoint table, stored as the
+/// `user_version` of its database. An older checkpoint is dropped.
+constexpr int CheckpointSchemaVersion = 1;
+
+/// \brief The translation units completed by a run, so that an
+/// interrupted run is resumed by `--resume` instead of restarting.
+///
+/// The checkpoint lives in `<knight_dir>/checkpoint.db`. A TU is marked
+/// completed along with its diagnostics as soon as it is analyzed, under
+/// the modification time and size of its main file, the hash of its
+/// compile commands and the options affecting the results, along with the
+/// modification times and sizes of the files it included. A resumed run
+/// only replays the TUs none of them changed since, and a file which
+/// cannot be stat counts as changed.
+///
+/// \note The checkpoint is thread-safe, the TUs being completed by
+/// several workers.
+class RunCheckpoint {
+  private:
+    sqlite::Database m_db;
+    std::mutex m_mutex;
+
+  public:
+    explicit RunCheckpoint(const std::string& knight_dir,
+                           int busy_time_mills =
+                               DefaultCacheBusyTimeoutMills) noexcept(false);
+
+    /// \brief Open the checkpoint in the given directory.
+    ///
+    /// \returns nullptr if the checkpoint database cannot be opened.
+    [[nodiscard]] static std::unique_ptr< RunCheckpoint > open(
+        const std::string& knight_dir);
+
+  public:
+    /// \brief Forget the completed TUs, when a run starts from scratch.
+    void clear();
+
+    /// \brief Get the diagnostics of the TU if it was completed under the
+    /// same compile command and options, and its files are unchanged.
+    ///
+    /// \returns std::nullopt if the TU shall be analyzed.
+    [[nodiscard]] std::optional< std::vector< KnightDiagnostic > > lookup(
+        const std::string& file,
+        const std::string& command,
+        const KnightOptions& opts);
+
+    /// \brief Mark the TU completed along with its diagnostics.
+    ///
+    /// \param dependencies the files read by the TU. The TU is left not
+    /// completed if one of them cannot be stat.
+    void complete(const std::string& file,
+                  const std::string& command,
+                  const std::vector< std::string >& dependencies,
+                  const KnightOptions& opts,
+                  const std::vector< KnightDiagnostic >& diags);
+
+  private:
+    /// \brief Get the modification time and size of the file.
+    ///
+    /// \returns std::nullopt if the file cannot be stat.
+    [[nodiscard]] static std::optional< std::string > get_stamp(
+        const std::string& file);
+
+    /// \returns std::nullopt if the main file cannot be stat.
+    [[nodiscard]] static std::optional< std::string > get_key(
+        const std::string& file,
+        const std::string& command,
+        const KnightOptions& opts);
+
+}; // class RunCheckpoint
+
+/// \brief The result of claiming a header definition.
+enum class DefinitionClaim {
+    /// \brief The caller shall analyze the definition and then publish its
+    /// diagnostics.
+    Claimed,
+    /// \brief The diagnostics of the first analysis are reused.
+    Published,
+    /// \brief The first analysis is still running or was skipped, so the
+    /// caller analyzes the definition on its own.
+    Pending,
+};
+
+/// \brief The header function definitions already analyzed by the process.
+///
+/// A header definition, e.g., an inline function or a template
+/// instantiation, is seen by every TU including it. The first TU reaching
+/// it claims it and publishes its diagnostics once analyzed, and the other
+/// TUs and workers reuse them instead of analyzing it again. The claims never
+/// wait for the first analysis to publish, so that the TUs claiming the
+/// definitions of each other cannot deadlock.
+class AnalyzedDefinitions {
+  private:
+    std::mutex m_mutex;
+
+    /// \brief The diagnostics of the claimed definitions, none while the
+    /// definition is being analyzed.
+    std::unordered_map< std::string,
+                        std::optional< std::vector< KnightDiagnostic > > >
+        m_diags;
+
+  public:
+    [[nodiscard]] static AnalyzedDefinitions& get();
+
+    /// \brief Check if the function is defined out of the main file, and
+    /// may thus be analyzed by several TUs.
+    [[nodiscard]] static bool is_shared(const clang::FunctionDecl* function);
+
+    /// \brief Get the key of the given definition under the options.
+    ///
+    /// The key is the cache key along with the template arguments of the
+    /// instantiations, which share the location and the ODR hash of their
+    /// pattern.
+    [[nodiscard]] static std::string get_key(
+        const clang::FunctionDecl* function, const KnightOptions& opts);
+
+    /// \brief Claim the definition of the given key.
+    ///
+    /// \p diags gets the diagnostics of the first analysis if they are
+    /// published.
+    [[nodiscard]] DefinitionClaim try_claim(
+        const std::string& key, std::vector< KnightDiagnostic >& diags);
+
+    /// \brief Publish the diagnostics of a claimed definition.
+    ///
+    /// The analyses of a pending definition publish it as well, which
+    /// keeps the same diagnostics under the same key.
+    void publish(const std::string& key, std::vector< KnightDiagnostic > diags);
+
+}; // class AnalyzedDefinitions
+
+} // namespace knight
@@ -20,6 +20,10 @@
 #include <llvm/Support/Debug.h>
 
 #include "analyzer/core/domain/domains.hpp"
+#include "analyzer/tooling/mem_report.hpp"
+#include "analyzer/tooling/stats.hpp"
+#include "analyzer/tooling/time_report.hpp"
+#include "common/util/progress.hpp"
 
 namespace knight::cl_opts {
 
@@ -61,7 +65,26 @@ Choose the znumerical domain.
             cl::values(clEnumValN(analyzer::DomainKind::ZIntervalDomain,
                                   "itv",
                                   analyzer::get_domain_desc(
-                                      analyzer::DomainKind::ZIntervalDomain))),
+                                      analyzer::DomainKind::ZIntervalDomain)),
+                       clEnumValN(analyzer::DomainKind::ZDBMDomain,
+                                  "dbm",
+                                  analyzer::get_domain_desc(
+                                      analyzer::DomainKind::ZDBMDomain)),
+                       clEnumValN(analyzer::DomainKind::ZPackDBMDomain,
+                                  "pack-dbm",
+                                  analyzer::get_domain_desc(
+                                      analyzer::DomainKind::ZPackDBMDomain)),
+                       clEnumValN(
+                           analyzer::DomainKind::MachineIntervalDomain,
+                           "machine-itv",
+                           analyzer::get_domain_desc(
+                               analyzer::DomainKind::MachineIntervalDomain)),
+                       clEnumValN(
+                           analyzer::DomainKind::ZIntervalCongruenceDomain,
+                           "itv-cong",
+                           analyzer::get_domain_desc(
+                               analyzer::DomainKind::
+                                   ZIntervalCongruenceDomain))),
             cl::init(analyzer::DomainKind::ZIntervalDomain));
 
 inline cl::opt< std::string > checkers("checkers",
@@ -73,6 +96,40 @@ checker names.
                                        cl::init("-*"),
                                        cl::cat(knight_category));
 
+inline cl::opt< std::string > include_functions("include-functions",
+                                                desc(R"(
+Only analyze the functions of which the qualified names
+match the comma-separated glob list, with the `-` prefix
+to exclude, e.g. `ns::*,-ns::detail::*`.
+)"),
+                                                cl::init("*"),
+                                                cl::value_desc("globs"),
+                                                cl::cat(knight_category));
+
+inline cl::opt< std::string > exclude_paths("exclude-paths",
+                                            desc(R"(
+Skip the functions defined in the files of which the
+paths match the comma-separated glob list, with the `-`
+prefix to include back, e.g. `*/third_party/*`.
+)"),
+                                            cl::value_desc("globs"),
+                                            cl::cat(knight_category));
+
+inline cl::opt< bool > skip_system_header("skip-system-header",
+                                          desc(R"(
+Skip the functions defined in the system headers.
+)"),
+                                          cl::init(false),
+                                          cl::cat(knight_category));
+
+inline cl::opt< bool > skip_implicit_code("skip-implicit-code",
+                                          desc(R"(
+Skip the implicit functions, e.g. the defaulted special
+members.
+)"),
+                                          cl::init(false),
+                                          cl::cat(knight_category));
+
 inline cl::opt< bool > list_checkers("list-checkers",
                                      desc(R"(
 list enabled checkers and exit program. Use with
@@ -103,6 +160,27 @@ Use colors in output.
                                  cl::init(true),
                                  cl::cat(knight_category));
 
+inline cl::opt< ProgressMode > progress(
+    "progress",
+    desc(R"(
+How to report the analyzed functions on the stdout.
+)"),
+    cl::values(clEnumValN(ProgressMode::List, "list", "list every function"),
+               clEnumValN(ProgressMode::Summary,
+                          "summary",
+                          "refresh a status line with the functions/sec, "
+                          "the TUs done and the ETA"),
+               clEnumValN(ProgressMode::Quiet, "quiet", "print nothing")),
+    cl::init(ProgressMode::List),
+    cl::cat(knight_category));
+
+inline cl::opt< bool > quiet("quiet",
+                             desc(R"(
+Do not report the analyzed functions, same as --progress=quiet.
+)"),
+                             cl::init(false),
+                             cl::cat(knight_category));
+
 inline cl::opt< bool > try_fix("fix",
                                desc(R"(
 Try to apply suggested fixes.
@@ -124,6 +202,296 @@ Dump the control flow graph of the analyzed function.
                                 cl::init(false),
                                 cl::cat(knight_category));
 
+inline cl::opt< std::string > knight_dir("dir",
+                                         desc(R"(
+The directory to store the knight intermediate files.
+When set, the analysis results of the functions are cached
+there and reused by the later runs, and the compilation
+database is indexed there.
+)"),
+                                         cl::value_desc("directory"),
+                                         cl::cat(knight_category));
+
+inline cl::opt< std::string > pch_header("pch-header",
+                                         desc(R"(
+Precompile the given header once for each group of TUs
+sharing a compile command, and reuse it when parsing
+them. The TUs are expected to include it first.
+)"),
+                                         cl::value_desc("header"),
+                                         cl::cat(knight_category));
+
+inline cl::opt< std::string > diag_stream("stream-diags",
+                                          desc(R"(
+Write the diagnostics of each TU as JSON lines to the
+given file, `-` for the stdout, as soon as the TU is
+analyzed. Only the compile errors are kept for the
+final report then.
+)"),
+                                          cl::value_desc("file"),
+                                          cl::cat(knight_category));
+
+inline cl::opt< std::string > state_dump_dir("state-dump-dir",
+                                             desc(R"(
+Write the states printed by the debug-state-printer
+analysis to one file per function in the given
+directory, each state only printed as its changes from
+the previous program point of the same block.
+)"),
+                                             cl::value_desc("directory"),
+                                             cl::cat(knight_category));
+
+inline cl::opt< bool > store_invariants("store-invariants",
+                                        desc(R"(
+Store the converged invariants of the blocks of the
+analyzed functions in the knight directory, to be looked
+up by the source offsets without analyzing them again.
+Requires `--dir`.
+)"),
+                                        cl::init(false),
+                                        cl::cat(knight_category));
+
+inline cl::opt< bool > resume("resume",
+                              desc(R"(
+Resume an interrupted run: the TUs completed by the last
+run, unchanged since, are not analyzed again and their
+diagnostics are replayed from the checkpoint of the
+knight directory. Requires `--dir`.
+)"),
+                              cl::init(false),
+                              cl::cat(knight_category));
+
+inline cl::opt< std::string > sarif_file("sarif",
+                                         desc(R"(
+Write the final diagnostics as a SARIF log to the given
+file, `-` for the stdout, instead of printing them. The
+results are rendered in parallel by `-j` workers.
+)"),
+                                         cl::value_desc("file"),
+                                         cl::cat(knight_category));
+
+inline cl::opt< std::string > shard_spec("shard",
+                                         desc(R"(
+Only analyze the i-th of N shards of the input files, or
+of all the files of the compilation database if none is
+given, with 0 <= i < N. The shards are balanced by the
+file sizes and are the same on every machine.
+)"),
+                                         cl::value_desc("i/N"),
+                                         cl::cat(knight_category));
+
+inline cl::list< std::string > merge_diags("merge-diags",
+                                           desc(R"(
+Merge the diagnostic streams of the shards into the
+`--stream-diags` file, or the stdout, and exit. The
+duplicated diagnostics are only written once.
+)"),
+                                           cl::CommaSeparated,
+                                           cl::value_desc("files"),
+                                           cl::cat(knight_category));
+
+inline cl::opt< unsigned > jobs("j",
+                                desc(R"(
+Number of translation units analyzed in parallel.
+Use 0 to run one worker per hardware thread.
+)"),
+                                cl::init(1U),
+                                cl::value_desc("N"),
+                                cl::cat(knight_category));
+
+inline cl::opt< bool > with_cg("cg",
+                               desc(R"(
+Also extract the call graph of the translation units into
+the database of `--dir`, as knight-cg does, so that each
+unit is only parsed once for both tools.
+)"),
+                               cl::init(false),
+                               cl::cat(knight_category));
+
+inline cl::opt< std::string > changes("changes",
+                                      desc(R"(
+Only analyze the units and the functions impacted by the
+changes of the given file, `-` for the stdin: a unified
+diff such as `git diff -U0`, or `file[:first[-last]]`
+lines. The changes are mapped to the call graph and the
+includes of the cg.db of `--dir`, and the callers of the
+changed functions are analyzed too.
+)"),
+                                      cl::value_desc("filename"),
+                                      cl::cat(knight_category));
+
+inline cl::opt< bool > points_to("points-to",
+                                 desc(R"(
+Load the whole-program points-to sets solved by
+`knight-cg --points-to` from the cg.db of `--dir`, and
+refine the aliasing of the pointer analysis with them.
+)"),
+                                 cl::init(false),
+                                 cl::cat(knight_category));
+
+inline cl::opt< unsigned > pipeline_depth("pipeline-depth",
+                                          desc(R"(
+Number of parsed translation units queued for the analysis
+workers, so that the parsing of the next units overlaps the
+analysis of the parsed ones. It bounds the number of ASTs
+kept in memory. Use 0 to parse and analyze each unit in turn.
+)"),
+                                          cl::init(0U),
+                                          cl::value_desc("N"),
+                                          cl::cat(knight_category));
+
+inline cl::opt< unsigned > function_jobs("function-jobs",
+                                         desc(R"(
+Number of functions analyzed in parallel inside a
+translation unit.
+)"),
+                                         cl::init(1U),
+                                         cl::value_desc("N"),
+                                         cl::cat(knight_category));
+
+inline cl::opt< unsigned > check_jobs("check-jobs",
+                                      desc(R"(
+Number of threads running the checkers on the converged
+invariants of the blocks of a function.
+)"),
+                                      cl::init(1U),
+                                      cl::value_desc("N"),
+                                      cl::cat(knight_category));
+
+inline cl::opt< bool > retain_symbols("retain-symbols",
+                                      desc(R"(
+Keep the symbols, regions and locations across the analyzed
+functions instead of dropping them after each function.
+)"),
+                                      cl::init(false),
+                                      cl::cat(knight_category));
+
+inline cl::opt< bool > dedup_definitions("dedup-definitions",
+                                         desc(R"(
+Analyze the function definitions of the headers once, by
+the first translation unit reaching them, and reuse their
+diagnostics in the other units. Not applied with
+`--bottom-up`, which needs the summaries of each unit.
+)"),
+                                         cl::init(true),
+                                         cl::cat(knight_category));
+
+inline cl::opt< bool > dedup_structural("dedup-structural",
+                                        desc(R"(
+Analyze the structurally identical functions of a
+translation unit once, e.g., the instantiations of a
+template on the same types, and move the diagnostics of
+the first one to the others. Not applied with
+`--bottom-up` nor `--function-jobs`.
+)"),
+                                        cl::init(true),
+                                        cl::cat(knight_category));
+
+inline cl::opt< bool > bottom_up("bottom-up",
+                                 desc(R"(
+Analyze the functions of a translation unit callees first,
+and apply the summaries of the callees at the call sites.
+)"),
+                                 cl::init(false),
+                                 cl::cat(knight_category));
+
+inline cl::opt< TimeReportFormat > time_report(
+    "time-report",
+    desc(R"(
+Print the wall and CPU time spent per function, analysis and
+checker, and the fixpoint iterations per cycle, to the stderr
+at exit.
+)"),
+    cl::values(clEnumValN(TimeReportFormat::Table,
+                          "table",
+                          "tables sorted by the descending time"),
+               clEnumValN(TimeReportFormat::Json, "json", "a JSON object")),
+    cl::init(TimeReportFormat::None),
+    cl::cat(knight_category));
+
+inline cl::opt< bool > time_report_perf_counters("time-report-perf-counters",
+                                                 desc(R"(
+Add the instructions, cycles, cache misses and branch misses
+of the hardware counters to the time report, when available.
+)"),
+                                                 cl::init(false),
+                                                 cl::cat(knight_category));
+
+// `-stats` is the option of the LLVM statistics.
+inline cl::opt< StatsFormat > analyzer_stats(
+    "analyzer-stats",
+    desc(R"(
+Print the hot path counters, i.e., the states interned and
+reused, the symbols, regions and location contexts created,
+the fixpoint iterations, and the clones, joins, widens and
+narrows per domain, to the stderr at exit.
+)"),
+    cl::values(clEnumValN(StatsFormat::Table, "table", "a table"),
+               clEnumValN(StatsFormat::Json, "json", "a JSON object")),
+    cl::init(StatsFormat::None),
+    cl::cat(knight_category));
+
+inline cl::opt< MemReportFormat > mem_report(
+    "mem-report",
+    desc(R"(
+Print the peak and current memory of the states, symbols,
+regions, location contexts, CFGs and domain values per
+function and per TU, to the stderr at exit.
+)"),
+    cl::values(clEnumValN(MemReportFormat::Table,
+                          "table",
+                          "tables sorted by the descending peak"),
+               clEnumValN(MemReportFormat::Json, "json", "a JSON object")),
+    cl::init(MemReportFormat::None),
+    cl::cat(knight_category));
+
+inline cl::opt< std::string > report_file("report-file",
+                                          desc(R"(
+Print the time report, the statistics and the memory report to
+the given file instead of the stderr, e.g. for the corpus
+benchmarks.
+)"),
+                                          cl::value_desc("file"),
+                                          cl::cat(knight_category));
+
+inline cl::opt< std::string > trace_file("trace",
+                                         desc(R"(
+Write the spans of the parsing, CFG and WTO building, node transfers
+and widening/narrowing passes to the given file in the Chrome trace
+event format, viewable in chrome://tracing or Perfetto.
+)"),
+                                         cl::value_desc("file"),
+                                         cl::cat(knight_category));
+
+inline cl::opt< std::string > widening_trace_file("widening-trace",
+                                                  desc(R"(
+Write the iterations at the cycle heads to the given file as JSON
+lines, with the domains and the variables changed from the previous
+iteration, and whether it was joined, widened or narrowed.
+)"),
+                                                  cl::value_desc("file"),
+                                                  cl::cat(knight_category));
+
+inline cl::opt< std::string > serve_socket("serve",
+                                           desc(R"(
+Serve the analysis requests on the given unix socket, keeping
+the compilation database, the PCHs and the set-up checkers and
+analyses warm between them. A request lists the files to analyze,
+one per line, ended by an empty line; the response is their
+diagnostics as JSON lines, ended by an empty line. The request
+`!shutdown` stops the server.
+)"),
+                                           cl::value_desc("socket"),
+                                           cl::cat(knight_category));
+
+inline cl::opt< unsigned > trace_granularity(
+    "trace-granularity",
+    desc(R"(
+Minimum duration in microseconds of the spans written to the trace.
+)"),
+    cl::init(0U),
+    cl::cat(knight_category));
+
 inline cl::list< std::string > XcArgs(
     "Xc",
     cl::desc("Pass the following argument to the analyzer options"),
@@ -155,6 +523,74 @@ inline cl::opt< bool > analyze_with_threshold(
     cl::init(false),
     cl::cat(knight_analyzer_category));
 
+inline cl::opt< unsigned > max_function_millis(
+    "max-function-millis",
+    cl::desc("wall-clock budget in milliseconds of analyzing a function, "
+             "0 means unlimited"),
+    cl::init(0U),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< unsigned > max_function_transfers(
+    "max-function-transfers",
+    cl::desc("budget of node transfers of analyzing a function, "
+             "0 means unlimited"),
+    cl::init(0U),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< unsigned > max_memory_per_worker(
+    "max-memory-per-worker",
+    cl::desc("budget in MiB of the state, symbol and region arenas of a "
+             "worker: past it the function is widened eagerly, past twice "
+             "it the function is skipped, 0 means unlimited"),
+    cl::init(0U),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< unsigned > max_call_depth(
+    "max-call-depth",
+    cl::desc("maximum depth of the callees analyzed at their call sites, "
+             "0 disables the inlining"),
+    cl::init(0U),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< bool > sparse_fixpoint(
+    "sparse-fixpoint",
+    cl::desc("only re-transfer the nodes of a cycle whose predecessors "
+             "changed since their last transfer"),
+    cl::init(false),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< unsigned > max_disjuncts(
+    "max-disjuncts",
+    cl::desc("maximum number of states kept apart at the merge points, "
+             "the most similar ones are joined past it and the cycle "
+             "heads always join, 1 means join at every merge point"),
+    cl::init(1U),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< bool > alias_classes(
+    "alias-classes",
+    cl::desc("partition the variables of each function into alias classes "
+             "by a unification-based pre-pass, such that the pointer "
+             "analysis only tracks the pointers whose class has several "
+             "locations"),
+    cl::init(false),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< bool > accelerate_loops(
+    "accelerate-loops",
+    cl::desc("enlarge the counters of the counting loops, e.g. "
+             "`for (i = a; i < n; i += c)`, to their closed-form ranges "
+             "after the first iteration at their heads"),
+    cl::init(false),
+    cl::cat(knight_analyzer_category));
+
+inline cl::opt< bool > prune_dead_values(
+    "prune-dead-values",
+    cl::desc("drop the dead variables and stmt values from the states at "
+             "the block exits"),
+    cl::init(true),
+    cl::cat(knight_analyzer_category));
+
 // NOLINTEND(readability-identifier-naming,cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-interfaces-global-init,fuchsia-statically-constructed-objects)
 
 } // namespace knight::cl_opts
\ No newline at end of file
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include "analyzer/core/analysis/analyses.hpp"
+#include "analyzer/core/checker/checkers.hpp"
 #include "analyzer/tooling/options.hpp"
 #include "common/util/globs.hpp"
 
@@ -24,13 +26,62 @@
 #include <clang/Basic/SourceManager.h>
 #include <clang/Tooling/Core/Diagnostic.h>
 
+#include <bitset>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace knight {
 
+namespace analyzer {
+
+class CallInliner;
+class SummaryManager;
+
+} // namespace analyzer
+
 class KnightContext {
+  public:
+    static_assert(sizeof(analyzer::CheckerID) == sizeof(analyzer::AnalysisID));
+    static constexpr std::size_t MaxModuleIDs =
+        std::numeric_limits< analyzer::CheckerID >::max() + 1U;
+
+    /// \brief A set of checker or analysis IDs.
+    using ModuleIDSet = std::bitset< MaxModuleIDs >;
+
+    /// \brief The checkers and analyses enabled by a configuration.
+    struct EnabledModules {
+        ModuleIDSet checkers;
+        ModuleIDSet directly_enabled_analyses;
+        ModuleIDSet core_analyses;
+    }; // struct EnabledModules
+
+    /// \brief The options of a configuration along with their matchers,
+    /// resolved once and shared by the files of the configuration.
+    struct ResolvedOptions {
+        KnightOptions options;
+        Globs check_matcher;
+        Globs analysis_matcher;
+        Globs function_matcher;
+        Globs excluded_path_matcher;
+
+        /// \brief Filled by the first AST consumer factory creating a
+        /// consumer for the configuration.
+        std::optional< EnabledModules > enabled_modules;
+
+        explicit ResolvedOptions(KnightOptions opts)
+            : options(std::move(opts)),
+              check_matcher(options.checkers),
+              analysis_matcher(options.analyses),
+              function_matcher(options.include_functions),
+              excluded_path_matcher(options.exclude_paths) {}
+    }; // struct ResolvedOptions
+
   private:
     /// \brief The diagnostic engine used to diagnose errors.
     clang::DiagnosticsEngine* m_diag_engine{};
@@ -39,12 +90,25 @@ class KnightContext {
 
     /// \brief The current file context.
     std::string m_current_file;
-    KnightOptions m_current_options;
+    ResolvedOptions* m_current_options{};
     clang::ASTContext* m_current_ast_ctx{};
-    std::unique_ptr< Globs > m_current_check_matcher;
-    std::unique_ptr< Globs > m_current_analysis_matcher;
     std::string m_current_build_dir;
 
+    /// \brief The files read by the current TU, i.e., its main file and
+    /// its includes, std::nullopt until the TU is parsed.
+    std::optional< std::vector< std::string > > m_current_dependencies;
+
+    /// \brief The resolved options by the configuration keys.
+    std::unordered_map< std::string, std::unique_ptr< ResolvedOptions > >
+        m_resolved_options;
+
+    /// \brief The function summaries of the bottom-up analysis, null if
+    /// the functions are analyzed independently.
+    analyzer::SummaryManager* m_summary_mgr{};
+
+    /// \brief The inliner of the callees, null if the inlining is disabled.
+    analyzer::CallInliner* m_call_inliner{};
+
     llvm::BumpPtrAllocator m_alloc;
 
   public:
@@ -64,6 +128,10 @@ class KnightContext {
     /// \brief Get the external diagnostic engine.
     void set_diagnostic_engine(clang::DiagnosticsEngine* external_diag_engine);
 
+    /// \brief Get the mutex serializing the accesses to the caches of the
+    /// shared clang AST and source manager from concurrent workers.
+    [[nodiscard]] static std::mutex& get_ast_mutex();
+
     /// \brief Get the allocator.
     llvm::BumpPtrAllocator& get_allocator() { return m_alloc; }
 
@@ -95,8 +163,16 @@ class KnightContext {
     }
 
     /// \breif Get the current options
+    ///
+    /// \note The files sharing a configuration get the same object, so
+    /// its address identifies the configuration.
     [[nodiscard]] const KnightOptions& get_current_options() const {
-        return m_current_options;
+        return m_current_options->options;
+    }
+
+    /// \brief Get the resolved options of the current configuration.
+    [[nodiscard]] ResolvedOptions& get_current_resolved_options() {
+        return *m_current_options;
     }
 
     /// \brief Set the current clang AST context
@@ -107,6 +183,39 @@ class KnightContext {
         m_current_build_dir = build_dir;
     }
 
+    /// \brief Set the files read by the current TU once it is parsed.
+    void set_current_dependencies(std::vector< std::string > files) {
+        m_current_dependencies = std::move(files);
+    }
+
+    /// \brief Take the files read by the current TU.
+    ///
+    /// \returns std::nullopt if the TU was not parsed.
+    [[nodiscard]] std::optional< std::vector< std::string > >
+    take_current_dependencies() {
+        return std::exchange(m_current_dependencies, std::nullopt);
+    }
+
+    /// \brief Get the function summaries, null if not analyzing bottom-up.
+    [[nodiscard]] analyzer::SummaryManager* get_summary_manager() const {
+        return m_summary_mgr;
+    }
+
+    /// \brief Set the function summaries applied at the call sites.
+    void set_summary_manager(analyzer::SummaryManager* summary_mgr) {
+        m_summary_mgr = summary_mgr;
+    }
+
+    /// \brief Get the inliner of the callees, null if disabled.
+    [[nodiscard]] analyzer::CallInliner* get_call_inliner() const {
+        return m_call_inliner;
+    }
+
+    /// \brief Set the inliner analyzing the callees at the call sites.
+    void set_call_inliner(analyzer::CallInliner* call_inliner) {
+        m_call_inliner = call_inliner;
+    }
+
     /// \brief Get the enabled status of checker.
     /// \returns \c true if the checker is enabled, \c false otherwise.
     [[nodiscard]] bool is_check_enabled(llvm::StringRef checker) const;
@@ -117,6 +226,14 @@ class KnightContext {
     [[nodiscard]] bool is_analysis_directly_enabled(
         llvm::StringRef analysis) const;
 
+    /// \brief Check if the function of the qualified name is analyzed by
+    /// the `--include-functions` globs.
+    [[nodiscard]] bool is_function_included(llvm::StringRef function) const;
+
+    /// \brief Check if the functions of the file are skipped by the
+    /// `--exclude-paths` globs.
+    [[nodiscard]] bool is_path_excluded(llvm::StringRef file) const;
+
     /// \breif Get the enabled status of core analyses
     ///
     /// \returns \c true if the analysis is enabled, \c false otherwise.
@@ -130,6 +247,12 @@ class KnightContext {
     /// \brief Get the options for the given file.
     [[nodiscard]] KnightOptions get_options_for(llvm::StringRef file) const;
 
+    /// \brief Clone the options provider for a new context.
+    [[nodiscard]] std::unique_ptr< KnightOptionsProvider >
+    clone_options_provider() const {
+        return m_opts_provider->clone();
+    }
+
     /// \brief Diagnosing methods.
     /// @{
     clang::DiagnosticBuilder diagnose(
@@ -0,0 +1,63 @@
+//===- diag_stream.hpp ------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the streaming writer of the knight diagnostics.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/tooling/diagnostic.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace knight {
+
+/// \brief Writer streaming the diagnostics as JSON lines, one diagnostic
+/// per line, as soon as a translation unit is analyzed.
+///
+/// \note The writer is thread-safe, the lines of a batch are written
+/// together and flushed at once.
+class DiagnosticStreamWriter {
+  private:
+    std::unique_ptr< llvm::raw_fd_ostream > m_os;
+    std::mutex m_mutex;
+
+  public:
+    explicit DiagnosticStreamWriter(std::unique_ptr< llvm::raw_fd_ostream > os)
+        : m_os(std::move(os)) {}
+
+    /// \brief Open the writer on the given file, `-` for the stdout.
+    ///
+    /// \returns nullptr if the file cannot be opened.
+    [[nodiscard]] static std::unique_ptr< DiagnosticStreamWriter > open(
+        const std::string& file);
+
+    /// \brief Write the diagnostics of a translation unit.
+    void write(const std::vector< KnightDiagnostic >& diags);
+
+    /// \brief Write the diagnostic lines of the given streams, e.g. the
+    /// ones of the shards of a project, once each in their first order.
+    ///
+    /// \returns false if a stream cannot be read.
+    [[nodiscard]] bool merge(const std::vector< std::string >& files);
+
+    /// \brief Serialize the diagnostics to JSON lines, each one ended by
+    /// a newline.
+    [[nodiscard]] static std::string to_json_lines(
+        const std::vector< KnightDiagnostic >& diags);
+
+}; // class DiagnosticStreamWriter
+
+} // namespace knight
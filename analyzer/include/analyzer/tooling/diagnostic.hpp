@@ -19,6 +19,12 @@
 
 #include "common/util/assert.hpp"
 
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 namespace knight {
 
 class KnightContext;
@@ -30,6 +36,63 @@ struct KnightDiagnostic : clang::tooling::Diagnostic {
                      llvm::StringRef build_dir);
 }; // struct KnightDiagnostic
 
+/// \brief Sort the diagnostics by location and remove the duplicated ones.
+void sort_and_unique_diags(std::vector< KnightDiagnostic >& diags);
+
+/// \brief Merge the sorted and unique diagnostics of multiple sinks, e.g.,
+/// one per input or worker, into one sorted and unique list.
+///
+/// The runs are merged pairwise, with the large pairs merged in parallel.
+/// The result only depends on the contents of the runs, not on which
+/// thread produced them.
+std::vector< KnightDiagnostic > merge_sorted_diags(
+    std::vector< std::vector< KnightDiagnostic > > runs);
+
+/// \brief Number of stripes of the reported diagnostic keys, a power of 2.
+constexpr unsigned ReportedDiagShardNum = 32U;
+
+/// \brief The keys of the diagnostics kept by the translation units of a
+/// run, so that a finding of a header seen by several TUs is only kept by
+/// the first TU reaching it.
+///
+/// The key is the check, the level, the location and the hash of the
+/// message, the one the final merge deduplicates by. The set is striped by
+/// the key hash, so that the TUs finishing together seldom contend on the
+/// same lock.
+class ReportedDiagnostics {
+  private:
+    struct Key {
+        std::uint64_t check_hash;
+        std::uint64_t file_hash;
+        std::uint64_t message_hash;
+        unsigned offset;
+        unsigned level;
+
+        [[nodiscard]] bool operator==(const Key& other) const = default;
+    }; // struct Key
+
+    struct KeyHash {
+        [[nodiscard]] std::size_t operator()(const Key& key) const;
+    }; // struct KeyHash
+
+    struct KeyShard {
+        std::mutex mutex;
+        std::unordered_set< Key, KeyHash > keys;
+    }; // struct KeyShard
+
+    std::array< KeyShard, ReportedDiagShardNum > m_shards;
+
+  public:
+    /// \brief Record the diagnostic.
+    ///
+    /// \returns false if an equal one was already recorded.
+    [[nodiscard]] bool insert(const KnightDiagnostic& diag);
+
+    /// \brief Forget the recorded diagnostics, e.g., for the next run.
+    void clear();
+
+}; // class ReportedDiagnostics
+
 // NOLINTNEXTLINE(altera-struct-pack-align)
 struct KnightDiagnosticConsumer : public clang::DiagnosticConsumer {
     explicit KnightDiagnosticConsumer(KnightContext& context);
@@ -37,12 +100,54 @@ struct KnightDiagnosticConsumer : public clang::DiagnosticConsumer {
     void HandleDiagnostic(clang::DiagnosticsEngine::Level diag_level,
                           const clang::Diagnostic& diagnostic) override;
 
+    /// \brief Keep the language options of the file being parsed, which
+    /// render its diagnostics before the AST context is set, e.g., when
+    /// the file is parsed ahead of its analysis.
+    void BeginSourceFile(const clang::LangOptions& lang_opts,
+                         const clang::Preprocessor* pp) override;
+    void EndSourceFile() override;
+
     // Retrieve the diagnostics that were captured.
     std::vector< KnightDiagnostic > take_diags();
 
+    // Get the number of diagnostics captured so far.
+    [[nodiscard]] std::size_t get_num_diags() const { return m_diags.size(); }
+
+    // Get a copy of the diagnostics captured since the given index.
+    [[nodiscard]] std::vector< KnightDiagnostic > get_diags_from(
+        std::size_t idx) const {
+        return {m_diags.begin() + static_cast< std::ptrdiff_t >(idx),
+                m_diags.end()};
+    }
+
+    // Add the diagnostics captured by another consumer.
+    void add_diags(std::vector< KnightDiagnostic > diags);
+
+    /// \brief Drop the diagnostics already kept by another TU of the run,
+    /// once the file is analyzed, i.e., at the end of each source file and
+    /// when the diagnostics are taken. Only the consumers of the TUs are
+    /// given the set, the ones of their workers keep all.
+    void set_reported_diags(ReportedDiagnostics* reported) {
+        m_reported = reported;
+    }
+
+  private:
+    /// \brief Drop the reported ones of the diagnostics captured since the
+    /// last call.
+    void drop_reported_diags();
+
   private:
     KnightContext& m_context;
     std::vector< KnightDiagnostic > m_diags;
+
+    /// \brief The diagnostics kept by the TUs of the run, if deduplicated.
+    ReportedDiagnostics* m_reported = nullptr;
+    /// \brief The number of leading diagnostics already checked against
+    /// \p m_reported.
+    std::size_t m_num_checked = 0U;
+
+    /// \brief The language options of the file being parsed, if any.
+    const clang::LangOptions* m_lang_opts = nullptr;
 }; // struct KnightDiagnosticConsumer
 
 class KnightDiagnosticRenderer : public clang::DiagnosticRenderer {
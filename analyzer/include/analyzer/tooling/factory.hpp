@@ -47,6 +47,11 @@ class CheckerManager;
 ///
 /// All knight modules register their check factories with an instance of
 /// this object.
+///
+/// The registrations are lightweight descriptors: the modules are only
+/// instantiated once per process, see `get_module_factory()`, and the
+/// dependencies and instances of the checkers and analyses are only set up
+/// on the managers of the configurations enabling them.
 class KnightFactory {
   public:
     using Analysis = analyzer::AnalysisBase;
@@ -65,6 +70,8 @@ class KnightFactory {
     using CheckerRegistryFn =
         std::function< UniqueCheckerRef(analyzer::CheckerManager&,
                                         KnightContext&) >;
+    using AnalysisDependencyFn = void (*)(analyzer::AnalysisManager&);
+    using CheckerDependencyFn = void (*)(analyzer::CheckerManager&);
 
     using AnalysisRegistryFnMap =
         llvm::DenseMap< std::pair< analyzer::AnalysisID, llvm::StringRef >,
@@ -76,12 +83,15 @@ class KnightFactory {
   private:
     AnalysisRegistryFnMap m_analysis_registry;
     CheckerRegistryFnMap m_checker_registry;
-    analyzer::AnalysisManager& m_analysis_mgr;
-    analyzer::CheckerManager& m_checker_mgr;
+    llvm::DenseMap< analyzer::AnalysisID, AnalysisDependencyFn >
+        m_analysis_dependency_fns;
+    llvm::DenseMap< analyzer::CheckerID, CheckerDependencyFn >
+        m_checker_dependency_fns;
 
   public:
-    KnightFactory(analyzer::AnalysisManager& analysis_mgr,
-                  analyzer::CheckerManager& checker_mgr);
+    /// \brief Get the factory of all the registered modules, which are
+    /// instantiated on the first call.
+    [[nodiscard]] static const KnightFactory& get_module_factory();
 
   public:
     /// \brief Add analysis registry function with analysis id and name.
@@ -100,7 +110,8 @@ class KnightFactory {
     void register_analysis() {
         analyzer::AnalysisKind kind = ANALYSIS::get_kind();
         if constexpr (analyzer::is_dependent_analysis< ANALYSIS >::value) {
-            ANALYSIS::add_dependencies(m_analysis_mgr);
+            m_analysis_dependency_fns[analyzer::get_analysis_id(kind)] =
+                &ANALYSIS::add_dependencies;
         }
         add_analysis_create_fn(analyzer::get_analysis_id(kind),
                                analyzer::get_analysis_name(kind),
@@ -113,13 +124,21 @@ class KnightFactory {
     void register_checker() {
         analyzer::CheckerKind kind = CHECKER::get_kind();
         if constexpr (analyzer::is_dependent_checker< CHECKER >::value) {
-            CHECKER::add_dependencies(m_checker_mgr);
+            m_checker_dependency_fns[analyzer::get_checker_id(kind)] =
+                &CHECKER::add_dependencies;
         }
         add_checker_create_fn(analyzer::get_checker_id(kind),
                               analyzer::get_checker_name(kind),
                               CHECKER::register_checker);
     }
 
+    /// \brief Add the dependencies of the required checkers.
+    void add_checker_dependencies(analyzer::CheckerManager& mgr) const;
+
+    /// \brief Add the dependencies of the required analyses and of the
+    /// analyses they depend on, transitively.
+    void add_analysis_dependencies(analyzer::AnalysisManager& mgr) const;
+
     /// \brief Create instances of analyses that are required.
     AnalysisRefs create_analyses(analyzer::AnalysisManager& mgr,
                                  KnightContext* context) const;
@@ -0,0 +1,133 @@
+//===- invariant_store.hpp --------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the store of the converged per-block invariants,
+//  persisted in the knight directory, and its lazy reader.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace knight {
+
+/// \brief The file of the invariant store in the knight directory.
+constexpr llvm::StringLiteral InvariantStoreFile = "invariants.bin";
+
+/// \brief The converged invariants of a block, as the printed values of
+/// the regions, along with the file offsets of its stmts.
+struct BlockInvariants {
+    using Values = std::vector< std::pair< std::string, std::string > >;
+
+    unsigned block_id = 0U;
+    unsigned begin_offset = 0U;
+    unsigned end_offset = 0U;
+    Values pre;
+    Values post;
+}; // struct BlockInvariants
+
+/// \brief The converged invariants of the blocks of a function, sorted by
+/// their IDs, along with the file offsets of the function.
+struct FunctionInvariants {
+    std::string file;
+    unsigned begin_offset = 0U;
+    unsigned end_offset = 0U;
+    std::vector< BlockInvariants > blocks;
+}; // struct FunctionInvariants
+
+/// \brief Process-wide store of the invariants of the analyzed functions,
+/// written to the knight directory at the end of the run.
+///
+/// The file is an index followed by the records of the blocks, so that a
+/// reader only decodes the block it looks up:
+///
+///   header:    "KINV", version, number of functions
+///   functions: file offset and size of the path, begin and end offsets,
+///              offset of the block entries and number of blocks, sorted
+///              by the path and the begin offset
+///   blocks:    ID, begin and end offsets, offset and size of the record,
+///              sorted by the ID
+///   records:   one `pre|post \t region \t value` line per region
+///
+/// The integers are 32-bit little-endian.
+///
+/// \note The store is thread-safe, a function shared by several TUs is
+/// only kept once.
+class InvariantStore {
+  private:
+    std::mutex m_mutex;
+    std::vector< FunctionInvariants > m_functions;
+
+  public:
+    /// \brief Get the process-wide store.
+    [[nodiscard]] static InvariantStore& get();
+
+    void add_function(FunctionInvariants function);
+
+    /// \brief Write the store to the file of the knight directory.
+    ///
+    /// \return the error message if the file cannot be written, empty on
+    /// success.
+    [[nodiscard]] std::string write(llvm::StringRef knight_dir);
+
+}; // class InvariantStore
+
+/// \brief Reader of the invariant store, mapping the file once and
+/// decoding the record of a block on each lookup.
+class InvariantStoreReader {
+  private:
+    std::unique_ptr< llvm::MemoryBuffer > m_buffer;
+    unsigned m_num_functions = 0U;
+
+  public:
+    /// \brief Map the store of the knight directory.
+    ///
+    /// \return null if the store is missing or malformed.
+    [[nodiscard]] static std::unique_ptr< InvariantStoreReader > open(
+        llvm::StringRef knight_dir);
+
+    [[nodiscard]] unsigned get_num_functions() const {
+        return m_num_functions;
+    }
+
+    /// \brief Get the invariants of the innermost block covering the
+    /// offset of the file, e.g. the one hovered in an editor.
+    [[nodiscard]] std::optional< BlockInvariants > lookup(
+        llvm::StringRef file, unsigned offset) const;
+
+    /// \brief Get the invariants of the block of the function beginning
+    /// at the offset of the file.
+    [[nodiscard]] std::optional< BlockInvariants > lookup_block(
+        llvm::StringRef file,
+        unsigned function_begin,
+        unsigned block_id) const;
+
+  private:
+    explicit InvariantStoreReader(std::unique_ptr< llvm::MemoryBuffer > buf)
+        : m_buffer(std::move(buf)) {}
+
+    [[nodiscard]] uint32_t read(uint64_t pos) const;
+    [[nodiscard]] llvm::StringRef get_function_file(unsigned idx) const;
+    [[nodiscard]] uint64_t get_function_entry(unsigned idx) const;
+    [[nodiscard]] std::optional< BlockInvariants > decode_block(
+        uint64_t entry) const;
+
+}; // class InvariantStoreReader
+
+} // namespace knight
@@ -20,38 +20,57 @@
 #include "analyzer/core/proc_cfg.hpp"
 #include "analyzer/core/program_state.hpp"
 #include "analyzer/core/region/region.hpp"
+#include "analyzer/core/engine/call_inliner.hpp"
+#include "analyzer/core/summary.hpp"
 #include "analyzer/core/symbol_manager.hpp"
+#include "analyzer/tooling/cache.hpp"
 #include "analyzer/tooling/context.hpp"
+#include "analyzer/tooling/diag_stream.hpp"
 #include "analyzer/tooling/diagnostic.hpp"
 #include "analyzer/tooling/factory.hpp"
+#include "analyzer/tooling/structural_dedup.hpp"
+#include "common/util/progress.hpp"
 #include "common/util/vfs.hpp"
 
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/DeclGroup.h>
+#include <clang/AST/Mangle.h>
 #include <clang/Basic/Diagnostic.h>
 #include <clang/Basic/LLVM.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
 #include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
 #include <llvm/Support/Casting.h>
 #include "common/util/log.hpp"
 
+#include <functional>
 #include <memory>
 #include <utility>
 
 namespace knight {
 
+struct CheckWorkerEnv;
+struct CallSCC;
+
 class KnightASTConsumer : public clang::ASTConsumer {
   public:
     KnightASTConsumer(KnightContext& ctx,
                       analyzer::AnalysisManager& analysis_manager,
                       analyzer::CheckerManager& checker_manager,
                       KnightFactory::CheckerRefs checkers,
-                      KnightFactory::AnalysisRefs analysis)
+                      KnightFactory::AnalysisRefs analysis,
+                      AnalysisCache* cache = nullptr)
         : m_ctx(ctx),
           m_analysis_manager(analysis_manager),
           m_checker_manager(checker_manager),
           m_checkers(std::move(checkers)),
-          m_analysis(std::move(analysis)) {}
+          m_analysis(std::move(analysis)),
+          m_cache(cache) {
+        m_location_manager.set_cfg_elements(
+            analysis_manager.get_required_cfg_elements());
+    }
+    ~KnightASTConsumer() override;
 
     // TODO(engine): add datadflow engine to run analysis and checkers here? on
     // the decl_group or tu?
@@ -59,52 +78,117 @@ class KnightASTConsumer : public clang::ASTConsumer {
         for (auto* decl : decl_group) {
             auto* function =
                 llvm::dyn_cast_or_null< clang::FunctionDecl >(decl);
-            if (function == nullptr || !function->hasBody()) {
+            if (function == nullptr || !function->hasBody() ||
+                !is_selected(function) || !is_impacted(function)) {
                 continue;
             }
 
-            llvm::outs() << "[*] Processing function: ";
-            if (m_ctx.get_current_options().use_color) {
-                llvm::outs().changeColor(llvm::raw_ostream::Colors::GREEN);
-            }
-            function->printName(llvm::outs());
-            llvm::outs().resetColor();
-            llvm::outs() << "\n";
-
-            const auto* frame = m_location_manager.create_top_frame(function);
-            if (m_ctx.get_current_options().view_cfg) {
-                if (m_ctx.get_current_options().use_color) {
-                    llvm::outs().changeColor(llvm::raw_ostream::Colors::RED);
-                }
-                llvm::outs() << "viewing CFG:\n";
-                llvm::outs().resetColor();
-                frame->get_cfg()->view();
-            }
-
-            if (m_ctx.get_current_options().dump_cfg) {
-                if (m_ctx.get_current_options().use_color) {
-                    llvm::outs().changeColor(llvm::raw_ostream::Colors::RED);
-                }
-                llvm::outs() << "dumping CFG:\n";
-                llvm::outs().resetColor();
-
-                frame->get_cfg()->dump(llvm::outs(),
-                                       m_ctx.get_current_options().use_color);
+            const auto& opts = m_ctx.get_current_options();
+            if (opts.bottom_up || opts.function_jobs > 1U) {
+                m_functions.push_back(function);
+                continue;
             }
-
-            analyzer::IntraProceduralFixpointIterator
-                engine(m_ctx,
-                       m_analysis_manager,
-                       m_checker_manager,
-                       m_location_manager,
-                       m_analysis_manager.get_state_manager(),
-                       frame);
-            engine.run();
+            analyze_function(function);
         }
 
         return true;
     }
 
+    void HandleTranslationUnit(clang::ASTContext& ast_ctx) override {
+        record_dependencies(ast_ctx.getSourceManager());
+        if (m_functions.empty()) {
+            ProgressReporter::get().add_unit();
+            return;
+        }
+        if (m_ctx.get_current_options().bottom_up) {
+            analyze_functions_bottom_up(ast_ctx);
+        } else {
+            analyze_functions_in_parallel(ast_ctx);
+        }
+        ProgressReporter::get().add_unit();
+    }
+
+  private:
+    void print_processing_function(const clang::FunctionDecl* function) const;
+
+    /// \brief Record the files read by the TU, checked by the checkpoint
+    /// before replaying it.
+    void record_dependencies(const clang::SourceManager& src_mgr) const;
+
+    /// \brief Analyze the given function on the current thread, unless
+    /// its diagnostics are cached.
+    void analyze_function(const clang::FunctionDecl* function);
+
+    /// \brief View or dump the CFG if required by the options.
+    void show_cfg(analyzer::ProcCFG::GraphRef cfg) const;
+
+    /// \brief Get the cache key of the given function.
+    ///
+    /// In the bottom-up mode, the key also covers the summaries of the
+    /// callees, so that the callers of a changed function are analyzed
+    /// again once its summary changes.
+    [[nodiscard]] std::string get_cache_key(
+        const clang::FunctionDecl* function) const;
+
+    /// \brief Replay the cached diagnostics of the given function, along
+    /// with its cached summary in the bottom-up mode.
+    ///
+    /// \returns true if the function hits the cache and needs no analysis.
+    bool replay_cached_diags(const clang::FunctionDecl* function);
+
+    /// \brief Check if the given function passes the file and function
+    /// filters, checked before building its CFG.
+    [[nodiscard]] bool is_selected(const clang::FunctionDecl* function) const;
+
+    /// \brief Check if the given function is impacted by the `--changes`,
+    /// always true without them.
+    [[nodiscard]] bool is_impacted(const clang::FunctionDecl* function);
+
+    /// \brief Check if the given function is analyzed once per process,
+    /// see `AnalyzedDefinitions`.
+    [[nodiscard]] bool is_deduplicated(
+        const clang::FunctionDecl* function) const;
+
+    /// \brief Run the intra-procedural fixpoint on the given function,
+    /// and store the reported diagnostics in the cache if enabled.
+    void run_fixpoint(const clang::FunctionDecl* function);
+
+    /// \brief Get the diagnostic consumer of the current context.
+    [[nodiscard]] KnightDiagnosticConsumer& get_diag_consumer() const;
+
+    /// \brief Run the fixpoints of the collected functions on
+    /// `function_jobs` worker threads.
+    ///
+    /// The CFGs are built upfront on the current thread since building
+    /// them touches the AST. The CFGs of the callees inlined by the
+    /// workers are built on request under the AST mutex instead. Each
+    /// worker owns its context, managers and diagnostic consumer, and the
+    /// resulting diagnostics are handed back to the diagnostic consumer of
+    /// the current context.
+    void analyze_functions_in_parallel(clang::ASTContext& ast_ctx);
+
+    /// \brief Analyze the collected functions by the strongly connected
+    /// components of the call graph of the TU, callees first, and record
+    /// the summary of each function for its callers.
+    ///
+    /// With `function_jobs`, the components are scheduled in parallel.
+    void analyze_functions_bottom_up(clang::ASTContext& ast_ctx);
+
+    /// \brief Run the fixpoints of the given SCCs on `function_jobs`
+    /// worker threads.
+    ///
+    /// An SCC becomes ready once the summaries of all its callees are
+    /// published, i.e., when its counter of pending callee SCCs drops to
+    /// zero, and is then picked up by the first idle worker.
+    void analyze_sccs_in_parallel(clang::ASTContext& ast_ctx,
+                                  const std::vector< CallSCC >& sccs);
+
+    /// \brief Get the workers running the checkers of a function on
+    /// `check_jobs` threads, which are created on the first use.
+    ///
+    /// \returns empty if the checkers run on the current thread.
+    [[nodiscard]] std::vector< analyzer::CheckWorker > get_check_workers();
+
   private:
     KnightContext& m_ctx;
     analyzer::AnalysisManager& m_analysis_manager;
@@ -112,14 +196,47 @@ class KnightASTConsumer : public clang::ASTConsumer {
     KnightFactory::CheckerRefs m_checkers;
     KnightFactory::AnalysisRefs m_analysis;
     analyzer::LocationManager m_location_manager;
+
+    /// \brief The analysis result cache, nullptr if disabled.
+    AnalysisCache* m_cache;
+
+    /// \brief The functions of the TU analyzed sequentially, by their
+    /// structure.
+    StructuralDedup m_structural_dedup;
+
+    /// \brief The mangler of the names checked against the `--changes`,
+    /// created on the first use.
+    std::unique_ptr< clang::MangleContext > m_mangler;
+
+    /// \brief Functions collected for the parallel or bottom-up analysis.
+    std::vector< const clang::FunctionDecl* > m_functions;
+
+    /// \brief Summaries of the functions analyzed bottom-up.
+    analyzer::SummaryManager m_summary_manager;
+
+    /// \brief The inliner of the callees, created on the first function
+    /// analyzed with `max_call_depth`.
+    std::unique_ptr< analyzer::CallInliner > m_call_inliner;
+
+    /// \brief Contexts and checkers of the check workers.
+    std::vector< std::unique_ptr< CheckWorkerEnv > > m_check_worker_envs;
 }; // class KnightASTConsumer
 
 class KnightASTConsumerFactory {
   private:
     KnightContext& m_ctx;
-    std::unique_ptr< KnightFactory > m_factory;
+    /// \brief The descriptors of the registered modules, shared by all the
+    /// factories of the process.
+    const KnightFactory* m_factory;
     std::unique_ptr< analyzer::AnalysisManager > m_analysis_manager;
     std::unique_ptr< analyzer::CheckerManager > m_checker_manager;
+    std::unique_ptr< AnalysisCache > m_cache;
+
+    /// \brief The options the checkers and analyses are set up for, and
+    /// the instances reused by the TUs of their configuration.
+    const KnightOptions* m_setup_options = nullptr;
+    KnightFactory::CheckerRefs m_checkers;
+    KnightFactory::AnalysisRefs m_analyses;
 
   public:
     explicit KnightASTConsumerFactory(
@@ -133,6 +250,10 @@ class KnightASTConsumerFactory {
     [[nodiscard]] std::unique_ptr< clang::ASTConsumer > create_ast_consumer(
         clang::CompilerInstance& ci, llvm::StringRef file);
 
+    /// \brief Create an AST consumer for the given file on a parsed AST.
+    [[nodiscard]] std::unique_ptr< KnightASTConsumer > create_ast_consumer(
+        clang::ASTContext& ast_ctx, llvm::StringRef file);
+
     /// \brief Get the list of enabled checks.
     [[nodiscard]] std::vector<
         std::pair< analyzer::CheckerID, llvm::StringRef > >
@@ -148,8 +269,23 @@ class KnightASTConsumerFactory {
         std::pair< analyzer::AnalysisID, llvm::StringRef > >
     get_enabled_core_analyses() const;
 
+  private:
+    /// \brief Create the checkers and analyses enabled by the current
+    /// configuration, and compute the order of their dependencies.
+    void set_up_modules();
+
+    /// \brief Get the checkers and analyses enabled by the current
+    /// configuration, matched against the registries once per
+    /// configuration.
+    [[nodiscard]] const KnightContext::EnabledModules& get_enabled_modules();
+
 }; // class KnightASTConsumerFactory
 
+/// \brief Create the consumer of another tool run on the AST of the given
+/// file next to the analyzer, so that the file is only parsed once.
+using ExtraConsumerFactory = std::function< std::unique_ptr<
+    clang::ASTConsumer >(clang::ASTContext& ast_ctx, llvm::StringRef file) >;
+
 class KnightDriver {
   private:
     KnightContext& m_ctx;
@@ -157,23 +293,121 @@ class KnightDriver {
     std::vector< std::string > m_input_files;
     llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > m_base_fs;
 
+    /// \brief Number of translation units analyzed in parallel.
+    unsigned m_jobs;
+
+    /// \brief Adjuster making the TUs reuse the PCH of their group.
+    clang::tooling::ArgumentsAdjuster m_pch_adjuster;
+
+    /// \brief Writer of the streamed diagnostics, nullptr if disabled.
+    std::unique_ptr< DiagnosticStreamWriter > m_diag_stream;
+
+    /// \brief The TUs completed by the current run, nullptr if there is
+    /// no knight directory.
+    std::unique_ptr< RunCheckpoint > m_checkpoint;
+
+    /// \brief The diagnostics kept by the TUs of the current run.
+    ReportedDiagnostics m_reported_diags;
+
+    /// \brief The action factory kept by `run_warm`, along with its
+    /// checker and analysis instances and analysis cache.
+    std::unique_ptr< clang::tooling::FrontendActionFactory > m_warm_factory;
+
+    /// \brief The factory of the consumer run next to the analyzer on each
+    /// TU, empty if none. It may be called by several workers at once.
+    ExtraConsumerFactory m_extra_consumer_factory;
+
   public:
     KnightDriver(
         KnightContext& ctx,
         const clang::tooling::CompilationDatabase& cdb,
         std::vector< std::string > input_files,
-        llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > base_fs)
+        llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > base_fs,
+        unsigned jobs = 1U)
         : m_ctx(ctx),
           m_cdb(cdb),
           m_input_files(std::move(input_files)),
-          m_base_fs(std::move(base_fs)) {}
+          m_base_fs(std::move(base_fs)),
+          m_jobs(jobs) {}
 
   public:
+    ~KnightDriver();
+
     std::vector< KnightDiagnostic > run();
 
+    /// \brief Analyze the given files sequentially, reusing the PCHs, the
+    /// set-up checkers and analyses and the analysis cache of the previous
+    /// calls, used by the server mode.
+    std::vector< KnightDiagnostic > run_warm(
+        const std::vector< std::string >& files);
+
     void handle_diagnostics(const std::vector< KnightDiagnostic >& diagnostics,
                             bool try_fix);
 
+    void set_extra_consumer_factory(ExtraConsumerFactory factory) {
+        m_extra_consumer_factory = std::move(factory);
+    }
+
+  private:
+    /// \brief Build the PCHs of the `pch_header` option if any.
+    void prepare_pch();
+
+    /// \brief Analyze the remaining input files as configured.
+    std::vector< KnightDiagnostic > run_on_input_files();
+
+    /// \brief Stream the diagnostics of a TU if enabled.
+    ///
+    /// \returns the diagnostics kept for the final report, i.e., all of
+    /// them if the streaming is disabled, only the errors otherwise.
+    std::vector< KnightDiagnostic > stream_diags(
+        std::vector< KnightDiagnostic > diags);
+
+    /// \brief Mark the TU completed in the checkpoint if any, and stream
+    /// its diagnostics.
+    ///
+    /// \param ctx the context which analyzed the TU, holding the files it
+    /// read.
+    /// \returns the diagnostics kept for the final report.
+    std::vector< KnightDiagnostic > finish_unit(
+        KnightContext& ctx,
+        const std::string& file,
+        std::vector< KnightDiagnostic > diags);
+
+    /// \brief Get the compile commands of the file as one string, which
+    /// is part of its checkpoint key.
+    [[nodiscard]] std::string get_compile_command(
+        const std::string& file) const;
+
+    /// \brief Drop the input files completed by the interrupted run from
+    /// the checkpoint, or forget them if the run is not resumed.
+    ///
+    /// \returns the replayed diagnostics kept for the final report.
+    std::vector< KnightDiagnostic > resume_from_checkpoint();
+
+    /// \brief Analyze the given files sequentially with the given context.
+    ///
+    /// \param action_factory the factory of the actions, null to create
+    /// one on fresh managers for the call.
+    std::vector< KnightDiagnostic > run_on_files(
+        KnightContext& ctx,
+        const std::vector< std::string >& files,
+        llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > fs,
+        clang::tooling::FrontendActionFactory* action_factory = nullptr);
+
+    /// \brief Analyze the input files on \p jobs worker threads.
+    ///
+    /// Each worker owns its context, managers and diagnostic consumer,
+    /// and the diagnostics are merged when all workers are done.
+    std::vector< KnightDiagnostic > run_in_parallel(unsigned jobs);
+
+    /// \brief Parse the input files on \p jobs threads into a queue of at
+    /// most \p depth ASTs, which \p jobs analysis workers consume.
+    ///
+    /// The I/O bound parsing of the next files thus overlaps the fixpoints
+    /// of the parsed ones, while the queue bounds the ASTs in memory.
+    std::vector< KnightDiagnostic > run_pipelined(unsigned jobs,
+                                                  unsigned depth);
+
 }; // class KnightDriver
 
 } // namespace knight
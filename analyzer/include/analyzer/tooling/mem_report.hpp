@@ -0,0 +1,109 @@
+//===- mem_report.hpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the memory report of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace knight {
+
+enum class MemKind { States, Symbols, Regions, Locations, CFGs, DomainValues };
+
+constexpr unsigned NumMemKinds = 6U;
+
+/// \brief The bytes used by each subsystem.
+using MemUsage = std::array< std::size_t, NumMemKinds >;
+
+enum class MemReportFormat { None, Table, Json };
+
+/// \brief Process-wide accounting of the memory used by the subsystems of
+/// the analyzer, per analyzed function and per translation unit.
+///
+/// The states, symbols, regions and location contexts are measured by
+/// their arenas, and the CFGs by the arenas of their blocks. The domain
+/// values are counted by their own size when they are constructed and
+/// destroyed, on the calling thread, without the heap memory they own.
+///
+/// The peak of a function is the usage at the end of its analysis,
+/// before its arenas are reset, as the arenas only grow meanwhile, and
+/// its current usage is the one kept after the reset. The peak of a unit
+/// is the largest peak of its functions.
+class MemReport {
+  public:
+    struct MemEntry {
+        MemUsage peak{};
+        MemUsage current{};
+        uint64_t count = 0U;
+    }; // struct MemEntry
+
+  private:
+    std::atomic< bool > m_is_enabled{false};
+    mutable std::mutex m_mutex;
+    llvm::StringMap< MemEntry > m_functions;
+    llvm::StringMap< MemEntry > m_units;
+
+  public:
+    /// \brief Get the process-wide report.
+    [[nodiscard]] static MemReport& get();
+
+    [[nodiscard]] bool is_enabled() const {
+        return m_is_enabled.load(std::memory_order_relaxed);
+    }
+    void set_enabled(bool is_enabled) {
+        m_is_enabled.store(is_enabled, std::memory_order_relaxed);
+    }
+
+    /// \brief Account the construction and the destruction of a domain
+    /// value of `size` bytes on the calling thread.
+    /// @{
+    static void add_domain_value(std::size_t size);
+    static void remove_domain_value(std::size_t size);
+    /// @}
+
+    /// \brief Start measuring the peak of the domain values of a function
+    /// analyzed by the calling thread.
+    static void begin_function();
+
+    /// \brief Get the peak bytes of the domain values of the calling
+    /// thread since `begin_function()`, above the ones live before, and
+    /// the bytes live now above them.
+    [[nodiscard]] static std::pair< std::size_t, std::size_t >
+    get_function_domain_values();
+
+    /// \brief Record the memory used by one analysis of the function of a
+    /// unit.
+    void add_function(llvm::StringRef unit,
+                      llvm::StringRef function,
+                      const MemUsage& peak,
+                      const MemUsage& current);
+
+    /// \brief Print the units and the functions sorted by the descending
+    /// total peak.
+    void print(llvm::raw_ostream& os, MemReportFormat format) const;
+
+  private:
+    void print_table(llvm::raw_ostream& os) const;
+    void print_json(llvm::raw_ostream& os) const;
+
+}; // class MemReport
+
+} // namespace knight
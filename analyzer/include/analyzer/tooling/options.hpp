@@ -15,6 +15,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
@@ -25,6 +26,13 @@
 
 namespace knight {
 
+namespace cg {
+
+class ChangeImpact;
+class PointsToFacts;
+
+} // namespace cg
+
 enum class OptionSource { Default, CommandLine, ConfigFile };
 
 const char* option_src_to_string(OptionSource source);
@@ -44,6 +52,18 @@ struct alignas(KnightOptionsAlignment) KnightOptions {
     /// \brief Analyses filter.
     std::string analyses;
 
+    /// \brief Functions filter, on the qualified names of the functions.
+    std::string include_functions = "*";
+
+    /// \brief Paths filter, on the files of the functions skipped.
+    std::string exclude_paths;
+
+    /// \brief skip the functions of the system headers
+    bool skip_system_header = false;
+
+    /// \brief skip the implicit functions, e.g. the defaulted members
+    bool skip_implicit_code = false;
+
     /// \brief ZNumerical domain.
     analyzer::DomainKind zdom = analyzer::DomainKind::ZIntervalDomain;
 
@@ -68,6 +88,71 @@ struct alignas(KnightOptionsAlignment) KnightOptions {
     /// \brief dump control flow graph
     bool dump_cfg = false;
 
+    /// \brief directory to store the knight intermediate files, such as
+    /// the analysis cache. Empty to disable the cache.
+    std::string knight_dir;
+
+    /// \brief header precompiled once per compile command group and
+    /// reused by the TUs of the group. Empty to disable.
+    std::string pch_header;
+
+    /// \brief file to stream the diagnostics of each TU to as JSON lines
+    /// once the TU is analyzed, `-` for the stdout. Empty to report all the
+    /// diagnostics when the analysis is finished.
+    std::string diag_stream;
+
+    /// \brief directory to write the states printed by the state printer
+    /// analysis to, one buffered file per function, each state only
+    /// printed as its changes from the previous one of the block. Empty to
+    /// print the full states on the stdout.
+    std::string state_dump_dir;
+
+    /// \brief store the converged invariants of the blocks of the analyzed
+    /// functions in the knight directory, to be looked up without
+    /// analyzing the functions again.
+    bool store_invariants = false;
+
+    /// \brief resume an interrupted run from the checkpoint of the knight
+    /// directory, replaying the diagnostics of the TUs it completed instead
+    /// of analyzing them again.
+    bool resume = false;
+
+    /// \brief number of parsed TUs queued for the analysis workers, so
+    /// that the parsing of the next TUs overlaps the analysis of the
+    /// parsed ones. 0 to parse and analyze each TU in turn.
+    unsigned pipeline_depth = 0U;
+
+    /// \brief number of functions analyzed in parallel in a TU
+    unsigned function_jobs = 1U;
+
+    /// \brief number of threads running the checkers on the converged
+    /// invariants of a function
+    unsigned check_jobs = 1U;
+
+    /// \brief keep the symbols, regions and locations across the analyzed
+    /// functions instead of dropping them after each function.
+    bool retain_symbols = false;
+
+    /// \brief analyze the header function definitions once per process,
+    /// the other TUs reusing the diagnostics of the first analysis.
+    bool dedup_definitions = true;
+
+    /// \brief reuse the diagnostics of an analyzed function of the TU for
+    /// the functions of the same structure, see `StructuralDedup`.
+    bool dedup_structural = true;
+
+    /// \brief analyze the functions of a TU callees first, and apply the
+    /// summaries of the callees at the call sites.
+    bool bottom_up = false;
+
+    /// \brief the impact of the `--changes`, only the impacted functions
+    /// are analyzed. nullptr to analyze all the functions.
+    std::shared_ptr< const cg::ChangeImpact > change_impact;
+
+    /// \brief the whole-program points-to sets of the cg.db, queried by
+    /// the pointer analysis. nullptr if not `--points-to`.
+    std::shared_ptr< const cg::PointsToFacts > points_to;
+
     /// \brief analyzer options
     analyzer::AnalyzerOptions analyzer_opts;
 
@@ -82,8 +167,22 @@ struct KnightOptionsProvider {
     [[nodiscard]] virtual KnightOptions get_options_for(
         const std::string& file) const = 0;
 
+    /// \brief Get the key of the configuration of the file, the files with
+    /// the same key shall get the same options.
+    ///
+    /// The options are resolved once per key, by default once per file.
+    [[nodiscard]] virtual std::string get_config_key(
+        const std::string& file) const {
+        return file;
+    }
+
     virtual void set_checker_option(const std::string& option,
                                     CheckerOptVal value) = 0;
+
+    /// \brief Clone the provider, used to give each analysis worker
+    /// its own options provider.
+    [[nodiscard]] virtual std::unique_ptr< KnightOptionsProvider > clone()
+        const = 0;
 }; // struct KnightOptionsProvider
 
 struct alignas(KnightOptionsProviderBigAlignment)
@@ -101,9 +200,18 @@ struct alignas(KnightOptionsProviderBigAlignment)
     [[nodiscard]] KnightOptions get_options_for(
         const std::string& file) const override;
 
+    /// \brief The options do not depend on the file.
+    [[nodiscard]] std::string get_config_key(
+        [[maybe_unused]] const std::string& file) const override {
+        return {};
+    }
+
     void set_checker_option(const std::string& option,
                             CheckerOptVal value) override;
 
+    [[nodiscard]] std::unique_ptr< KnightOptionsProvider > clone()
+        const override;
+
   protected:
     void set_default_options();
 
@@ -124,6 +232,9 @@ struct alignas(KnightOptionsProviderBigAlignment)
     void set_checker_option(const std::string& option,
                             CheckerOptVal value) override;
 
+    [[nodiscard]] std::unique_ptr< KnightOptionsProvider > clone()
+        const override;
+
 }; // class KnightOptionsCommandLineProvider
 
 // TODO(config-file): add config file support
@@ -39,9 +39,10 @@ class DiagnosticReporter {
     clang::SourceManager m_source_manager;
 
     FixKind m_fix_kind;
-    llvm::StringMap<
-        std::pair< llvm::StringRef, clang::tooling::Replacements > >
-        m_file_to_build_dir_and_replaces;
+
+    /// \brief The replacements to apply, keyed by the absolute file path,
+    /// so that the files of all the build directories are grouped together.
+    llvm::StringMap< clang::tooling::Replacements > m_file_to_replaces;
 
     clang::LangOptions m_lang_opts;
 
@@ -58,6 +59,8 @@ class DiagnosticReporter {
 
     void report(const KnightDiagnostic& diagnostic);
 
+    /// \brief Apply the collected replacements, rewriting the files in
+    /// parallel with a single write per file.
     void apply_fixes();
 
   private:
@@ -76,6 +79,12 @@ class DiagnosticReporter {
                         file_replacements);
 
     void report_note(const clang::tooling::DiagnosticMessage& diag_msg);
+
+    /// \brief Apply the replacements to the file with a single write.
+    ///
+    /// \returns the error message, empty on success.
+    static std::string rewrite_file(
+        llvm::StringRef file, const clang::tooling::Replacements& replaces);
 }; // class DiagnosticReporter
 
 } // namespace knight
@@ -0,0 +1,46 @@
+//===- sarif.hpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the SARIF writer of the knight diagnostics.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/tooling/diagnostic.hpp"
+
+#include <string>
+#include <vector>
+
+namespace knight {
+
+/// \brief Writer of the final diagnostics as a SARIF 2.1.0 log.
+///
+/// Unlike the text report, no source manager is involved: the sources are
+/// mapped once each, the results, with the line of their location as the
+/// snippet, are rendered by chunks on `jobs` threads, and the chunks are
+/// streamed to the output in the order of the diagnostics.
+class SarifWriter {
+  public:
+    /// \brief Number of diagnostics rendered by a worker at a time.
+    static constexpr std::size_t ChunkSize = 256U;
+
+  public:
+    /// \brief Write the diagnostics to the given file, `-` for the stdout,
+    /// on `jobs` threads, 0 for one per hardware thread.
+    ///
+    /// \returns the error message, empty on success.
+    [[nodiscard]] static std::string write(
+        const std::string& file,
+        const std::vector< KnightDiagnostic >& diags,
+        unsigned jobs);
+
+}; // class SarifWriter
+
+} // namespace knight
@@ -0,0 +1,60 @@
+//===- server.hpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the server mode of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/tooling/knight.hpp"
+
+#include <llvm/ADT/StringRef.h>
+
+#include <string>
+#include <vector>
+
+namespace knight {
+
+/// \brief Server analyzing the files requested on a local socket, on the
+/// state kept warm by the driver between the requests: the compilation
+/// database, the PCHs, the set-up checkers and analyses, the resolved
+/// options and the analysis cache.
+///
+/// A request is a list of files, one per line, ended by an empty line.
+/// The response is the diagnostics of the files as JSON lines, in the
+/// format of `--stream-diags`, ended by an empty line. The request
+/// `ShutdownRequest` stops the server.
+///
+/// \note The requests are served one at a time.
+class KnightServer {
+  public:
+    static constexpr llvm::StringRef ShutdownRequest = "!shutdown";
+
+  private:
+    KnightDriver& m_driver;
+
+  public:
+    explicit KnightServer(KnightDriver& driver) : m_driver(driver) {}
+
+    /// \brief Serve the requests on the unix socket, replacing a stale
+    /// socket file, until the shutdown request.
+    ///
+    /// \returns false if the socket cannot be listened on.
+    [[nodiscard]] bool serve(const std::string& socket_path);
+
+  private:
+    /// \brief Analyze the files of the request.
+    ///
+    /// \returns the response, empty for the shutdown request.
+    [[nodiscard]] std::string handle(llvm::StringRef request);
+
+}; // class KnightServer
+
+} // namespace knight
@@ -0,0 +1,120 @@
+//===- stats.hpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the hot path statistics of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/domain/domains.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace knight {
+
+enum class StatKind {
+    StatesInterned,
+    StatesReused,
+    SymbolsCreated,
+    RegionsCreated,
+    LocationContextsCreated,
+    CycleVisits,
+    CycleIterations,
+    NonLinearQueries,
+    NonLinearCacheHits,
+    CheckerQueries,
+    CheckerQueryCacheHits,
+    AcceleratedCycles,
+};
+
+constexpr unsigned NumStatKinds = 12U;
+
+enum class DomainOpKind { Clone, Join, Widen, Narrow };
+
+constexpr unsigned NumDomainOpKinds = 4U;
+
+enum class StatsFormat { None, Table, Json };
+
+/// \brief Process-wide counters of the hot path of the analyzer: the
+/// interned states, the created symbols, regions and location contexts,
+/// the fixpoint iterations, the non-linear feasibility queries, and the
+/// clones and lattice operations of each domain.
+///
+/// It tells whether an option or a code change improved the hot path,
+/// next to the time report.
+///
+/// \note The counters are relaxed atomics, only incremented when the
+/// statistics are enabled, so they cost one load otherwise.
+class Stats {
+  private:
+    std::atomic< bool > m_is_enabled{false};
+    std::array< std::atomic< uint64_t >, NumStatKinds > m_counters{};
+    std::array< std::array< std::atomic< uint64_t >, NumDomainOpKinds >,
+                analyzer::NumDomains >
+        m_domain_ops{};
+
+  public:
+    /// \brief Get the process-wide statistics.
+    [[nodiscard]] static Stats& get();
+
+    [[nodiscard]] bool is_enabled() const {
+        return m_is_enabled.load(std::memory_order_relaxed);
+    }
+    void set_enabled(bool is_enabled) {
+        m_is_enabled.store(is_enabled, std::memory_order_relaxed);
+    }
+
+    /// \brief Count `n` events of the given kind if enabled.
+    static void count(StatKind kind, uint64_t n = 1U) {
+        auto& stats = get();
+        if (stats.is_enabled()) {
+            stats.m_counters[static_cast< unsigned >(kind)]
+                .fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    /// \brief Count one operation on a value of the given domain if
+    /// enabled.
+    static void count(analyzer::DomainKind dom, DomainOpKind kind) {
+        auto& stats = get();
+        if (stats.is_enabled()) {
+            stats.m_domain_ops[analyzer::get_domain_id(dom)]
+                              [static_cast< unsigned >(kind)]
+                                  .fetch_add(1U, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] uint64_t get_count(StatKind kind) const {
+        return m_counters[static_cast< unsigned >(kind)].load(
+            std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t get_count(analyzer::DomainKind dom,
+                                     DomainOpKind kind) const {
+        return m_domain_ops[analyzer::get_domain_id(dom)]
+                           [static_cast< unsigned >(kind)]
+                               .load(std::memory_order_relaxed);
+    }
+
+    /// \brief Print the counters, and the domains of which any operation
+    /// was counted.
+    void print(llvm::raw_ostream& os, StatsFormat format) const;
+
+  private:
+    void print_table(llvm::raw_ostream& os) const;
+    void print_json(llvm::raw_ostream& os) const;
+
+}; // class Stats
+
+} // namespace knight
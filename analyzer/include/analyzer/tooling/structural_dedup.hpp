@@ -0,0 +1,81 @@
+//===- structural_dedup.hpp -------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the deduplication of the structurally identical
+//  functions of a translation unit.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/tooling/diagnostic.hpp"
+
+#include <clang/AST/Decl.h>
+#include <clang/Basic/LangOptions.h>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace knight {
+
+/// \brief The functions of a TU analyzed so far, by their structure.
+///
+/// Two functions have the same structure when their bodies are the same
+/// modulo the names of the functions and the layout of the source: same
+/// stmt kinds, operators and constants, same types, the same non-local
+/// declarations referenced, and their own parameters and locals used at
+/// the same places. A function of the same structure as an analyzed one
+/// gets its diagnostics, moved to the corresponding locations, instead of
+/// being analyzed again.
+///
+/// \note The TU shall be analyzed under the same options, as the entries
+/// refer to the types and declarations of its AST.
+class StructuralDedup {
+  public:
+    /// \brief The structure of a function, along with the file offsets of
+    /// its stmts in the order of the structure.
+    struct Shape {
+        std::string key;
+        std::string file;
+        std::vector< unsigned > offsets;
+    }; // struct Shape
+
+  private:
+    /// \brief The shapes of the analyzed functions, with their
+    /// diagnostics.
+    std::unordered_map< std::string,
+                        std::pair< Shape, std::vector< KnightDiagnostic > > >
+        m_functions;
+
+  public:
+    /// \brief Compute the shape of the given function.
+    ///
+    /// \returns std::nullopt if the body is not in a file or is expanded
+    /// from macros, as its diagnostics cannot be moved then.
+    [[nodiscard]] static std::optional< Shape > compute(
+        const clang::FunctionDecl* function,
+        const clang::LangOptions& lang_opts);
+
+    /// \brief Get the diagnostics of the analyzed function of the given
+    /// shape, moved to the function of the shape.
+    ///
+    /// \returns std::nullopt if no function of the shape is analyzed yet,
+    /// or if some of its diagnostics cannot be moved.
+    [[nodiscard]] std::optional< std::vector< KnightDiagnostic > > lookup(
+        const Shape& shape) const;
+
+    /// \brief Record the diagnostics of the analyzed function of the given
+    /// shape.
+    void record(Shape shape, std::vector< KnightDiagnostic > diags);
+
+}; // class StructuralDedup
+
+} // namespace knight
@@ -0,0 +1,129 @@
+//===- time_report.hpp ------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the time report of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/util/perf_counters.hpp"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace knight {
+
+enum class TimeReportKind { Function, Analysis, Checker };
+
+constexpr unsigned NumTimeReportKinds = 3U;
+
+enum class TimeReportFormat { None, Table, Json };
+
+/// \brief Process-wide profile of the wall and CPU time spent in the
+/// analyzed functions, analyses and checkers, along with the fixpoint
+/// iterations of each WTO cycle.
+///
+/// The hardware counters of the calling thread can be recorded next to
+/// the times when they are available, at the cost of two system calls
+/// per measured scope.
+///
+/// \note The report is thread-safe. The CPU time is the one of the calling
+/// thread, so it stays meaningful with the parallel jobs.
+class TimeReport {
+  public:
+    struct TimeEntry {
+        std::chrono::nanoseconds wall{};
+        std::chrono::nanoseconds cpu{};
+        PerfCounterValues perf{};
+        uint64_t count = 0U;
+    }; // struct TimeEntry
+
+    struct CycleEntry {
+        uint64_t iterations = 0U;
+        uint64_t visits = 0U;
+    }; // struct CycleEntry
+
+    /// \brief Measure the time of a scope, does nothing if the report
+    /// is disabled.
+    class Scope {
+      private:
+        TimeReportKind m_kind;
+        llvm::StringRef m_name;
+        bool m_is_enabled;
+        std::chrono::steady_clock::time_point m_wall_start;
+        std::chrono::nanoseconds m_cpu_start{};
+        PerfCounterValues m_perf_start{};
+
+      public:
+        Scope(TimeReportKind kind, llvm::StringRef name);
+        Scope(const Scope&) = delete;
+        Scope(Scope&&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        Scope& operator=(Scope&&) = delete;
+        ~Scope();
+    }; // class Scope
+
+  private:
+    std::atomic< bool > m_is_enabled{false};
+    std::atomic< bool > m_is_perf_enabled{false};
+    mutable std::mutex m_mutex;
+    std::array< llvm::StringMap< TimeEntry >, NumTimeReportKinds > m_times;
+    llvm::StringMap< CycleEntry > m_cycles;
+
+  public:
+    /// \brief Get the process-wide report.
+    [[nodiscard]] static TimeReport& get();
+
+    [[nodiscard]] bool is_enabled() const {
+        return m_is_enabled.load(std::memory_order_relaxed);
+    }
+    void set_enabled(bool is_enabled) {
+        m_is_enabled.store(is_enabled, std::memory_order_relaxed);
+    }
+
+    /// \brief Whether the hardware counters are recorded.
+    [[nodiscard]] bool is_perf_enabled() const {
+        return m_is_perf_enabled.load(std::memory_order_relaxed);
+    }
+    void set_perf_enabled(bool is_enabled) {
+        m_is_perf_enabled.store(is_enabled, std::memory_order_relaxed);
+    }
+
+    /// \brief Get the CPU time consumed by the calling thread.
+    [[nodiscard]] static std::chrono::nanoseconds get_thread_cpu_time();
+
+    /// \brief Record the time spent once in the named entry.
+    void add_time(TimeReportKind kind,
+                  llvm::StringRef name,
+                  std::chrono::nanoseconds wall,
+                  std::chrono::nanoseconds cpu,
+                  const PerfCounterValues& perf = {});
+
+    /// \brief Record the iterations of one visit of the named cycle.
+    void add_cycle_iterations(llvm::StringRef cycle, uint64_t iterations);
+
+    /// \brief Print the entries sorted by the descending wall time, and
+    /// the cycles by the descending iterations.
+    void print(llvm::raw_ostream& os, TimeReportFormat format) const;
+
+  private:
+    void print_table(llvm::raw_ostream& os) const;
+    void print_json(llvm::raw_ostream& os) const;
+
+}; // class TimeReport
+
+} // namespace knight
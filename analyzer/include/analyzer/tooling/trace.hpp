@@ -0,0 +1,54 @@
+//===- trace.hpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the helpers of the Chrome trace export, built on
+//  the LLVM time trace profiler.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+
+namespace knight::trace {
+
+/// \brief Enable the tracing and start the profiler of the main thread.
+///
+/// \param granularity_us Minimum duration in microseconds of the recorded
+/// events.
+void initialize(unsigned granularity_us);
+
+/// \brief Check if the tracing is enabled.
+[[nodiscard]] bool is_enabled();
+
+/// \brief Write the trace events of all the threads to the given file in
+/// the Chrome trace event format, and stop the profiler.
+///
+/// \returns false if the trace cannot be written.
+bool finish(llvm::StringRef file);
+
+/// \brief Start the profiler of a worker thread for the scope, does
+/// nothing if the tracing is disabled.
+///
+/// The events of the thread are handed to the main thread profiler when
+/// the scope exits, so it shall exit before `finish`.
+class ThreadScope {
+  private:
+    bool m_is_started = false;
+
+  public:
+    ThreadScope();
+    ThreadScope(const ThreadScope&) = delete;
+    ThreadScope(ThreadScope&&) = delete;
+    ThreadScope& operator=(const ThreadScope&) = delete;
+    ThreadScope& operator=(ThreadScope&&) = delete;
+    ~ThreadScope();
+}; // class ThreadScope
+
+} // namespace knight::trace
@@ -0,0 +1,80 @@
+//===- widening_trace.hpp ---------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the trace of the fixpoint iterations at the cycle
+//  heads.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/engine/iterator.hpp"
+#include "analyzer/core/program_state.hpp"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace knight {
+
+/// \brief Process-wide trace of the iterations at the cycle heads, as JSON
+/// lines, one line per iteration, e.g.
+///
+///   {"function":"f","head":3,"iteration":2,"kind":"increasing",
+///    "op":"widen","domains":["ZIntervalDomain"],
+///    "changed":[{"region":"i","previous":"[0, 1]","value":"[0, +oo]"}]}
+///
+/// Each line lists the domains and the regions changed at the head from
+/// the previous iteration, and the operation combining both iterations,
+/// so that the variables still changing after the widening delay can be
+/// found to tune the delay and the thresholds.
+///
+/// \note The trace is thread-safe, the lines of the functions analyzed in
+/// parallel are interleaved.
+class WideningTrace {
+  private:
+    std::atomic< bool > m_is_enabled{false};
+    std::mutex m_mutex;
+    std::unique_ptr< llvm::raw_fd_ostream > m_os;
+
+  public:
+    /// \brief Get the process-wide trace.
+    [[nodiscard]] static WideningTrace& get();
+
+    [[nodiscard]] bool is_enabled() const {
+        return m_is_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Start tracing to the given file.
+    ///
+    /// \return the error message if the file cannot be opened, empty on
+    /// success.
+    [[nodiscard]] std::string open(llvm::StringRef file);
+
+    /// \brief Stop tracing and flush the file.
+    void close();
+
+    /// \brief Record an iteration at the head of a cycle of the function.
+    ///
+    /// \param changes the changes of the state at the head, combined by
+    /// `op`, from the one of the previous iteration
+    void add_iteration(llvm::StringRef function,
+                       unsigned head,
+                       unsigned iteration,
+                       analyzer::IterationKind kind,
+                       analyzer::HeadOpKind op,
+                       const analyzer::StateChanges& changes);
+
+}; // class WideningTrace
+
+} // namespace knight
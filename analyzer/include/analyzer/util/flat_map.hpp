@@ -0,0 +1,130 @@
+//===- flat_map.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines a map stored as a vector sorted by the keys.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace knight {
+
+/// \brief Map stored as a vector of pairs sorted by the keys.
+///
+/// The elements are contiguous, so iterating two maps side by side is a
+/// linear merge instead of a lookup per key. Inserting a new key moves
+/// the greater elements, so it suits the maps mostly updated in place.
+template < typename Key, typename Value, typename Compare = std::less< Key > >
+class FlatMap {
+  public:
+    using value_type = std::pair< Key, Value >;
+    using Container = std::vector< value_type >;
+    using iterator = typename Container::iterator;
+    using const_iterator = typename Container::const_iterator;
+    using size_type = typename Container::size_type;
+
+  private:
+    Container m_elems;
+
+  public:
+    FlatMap() = default;
+
+    /// \brief Adopt elements already sorted by unique keys.
+    explicit FlatMap(Container sorted_elems)
+        : m_elems(std::move(sorted_elems)) {}
+
+  public:
+    [[nodiscard]] static bool key_less(const Key& lhs, const Key& rhs) {
+        return Compare()(lhs, rhs);
+    }
+
+    [[nodiscard]] iterator begin() { return m_elems.begin(); }
+    [[nodiscard]] iterator end() { return m_elems.end(); }
+    [[nodiscard]] const_iterator begin() const { return m_elems.begin(); }
+    [[nodiscard]] const_iterator end() const { return m_elems.end(); }
+
+    [[nodiscard]] size_type size() const { return m_elems.size(); }
+    [[nodiscard]] bool empty() const { return m_elems.empty(); }
+    void reserve(size_type size) { m_elems.reserve(size); }
+    void clear() { m_elems.clear(); }
+    void swap(FlatMap& other) noexcept { m_elems.swap(other.m_elems); }
+
+    [[nodiscard]] iterator lower_bound(const Key& key) {
+        return std::lower_bound(m_elems.begin(),
+                                m_elems.end(),
+                                key,
+                                [](const value_type& elem, const Key& k) {
+                                    return key_less(elem.first, k);
+                                });
+    }
+
+    [[nodiscard]] const_iterator lower_bound(const Key& key) const {
+        return std::lower_bound(m_elems.begin(),
+                                m_elems.end(),
+                                key,
+                                [](const value_type& elem, const Key& k) {
+                                    return key_less(elem.first, k);
+                                });
+    }
+
+    [[nodiscard]] iterator find(const Key& key) {
+        auto it = lower_bound(key);
+        return it != m_elems.end() && !key_less(key, it->first) ? it
+                                                                : m_elems.end();
+    }
+
+    [[nodiscard]] const_iterator find(const Key& key) const {
+        auto it = lower_bound(key);
+        return it != m_elems.end() && !key_less(key, it->first) ? it
+                                                                : m_elems.end();
+    }
+
+    [[nodiscard]] bool contains(const Key& key) const {
+        return find(key) != m_elems.end();
+    }
+
+    template < typename... Args >
+    std::pair< iterator, bool > try_emplace(const Key& key, Args&&... args) {
+        auto it = lower_bound(key);
+        if (it != m_elems.end() && !key_less(key, it->first)) {
+            return {it, false};
+        }
+        it = m_elems.emplace(it,
+                             std::piecewise_construct,
+                             std::forward_as_tuple(key),
+                             std::forward_as_tuple(
+                                 std::forward< Args >(args)...));
+        return {it, true};
+    }
+
+    Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    iterator erase(const_iterator it) { return m_elems.erase(it); }
+
+    size_type erase(const Key& key) {
+        auto it = find(key);
+        if (it == m_elems.end()) {
+            return 0U;
+        }
+        m_elems.erase(it);
+        return 1U;
+    }
+
+    /// \brief Take the underlying sorted elements.
+    [[nodiscard]] Container take_elems() { return std::move(m_elems); }
+
+}; // class FlatMap
+
+} // namespace knight
@@ -0,0 +1,109 @@
+//===- node_table.hpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines a table of values attached to graph nodes.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/support/graph.hpp"
+
+#include <llvm/ADT/BitVector.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace knight {
+
+/// \brief Table of values attached to the nodes of one graph.
+///
+/// When the graph trait provides dense node IDs, the values are stored
+/// in a vector indexed by the IDs, with a bit per node telling if it has
+/// a value, so that the lookups are array accesses. Otherwise they are
+/// stored in a hash map keyed by the nodes.
+template < typename GraphTrait, typename T >
+class NodeTable {
+  public:
+    using GraphRef = typename GraphTrait::GraphRef;
+    using NodeRef = typename GraphTrait::NodeRef;
+
+    static constexpr bool HasNodeID = graph_with_node_id< GraphTrait >;
+
+  private:
+    std::vector< T > m_by_id;
+    llvm::BitVector m_is_set;
+    std::unordered_map< NodeRef, T > m_by_node;
+
+  public:
+    explicit NodeTable(GraphRef graph) {
+        if constexpr (HasNodeID) {
+            const unsigned num_nodes = GraphTrait::num_nodes(graph);
+            m_by_id.resize(num_nodes);
+            m_is_set.resize(num_nodes);
+        }
+    }
+
+  public:
+    /// \brief Return the value of the node, or null if it has none.
+    [[nodiscard]] const T* find(NodeRef node) const {
+        if constexpr (HasNodeID) {
+            const unsigned id = GraphTrait::get_node_id(node);
+            return m_is_set.test(id) ? &m_by_id[id] : nullptr;
+        } else {
+            auto it = m_by_node.find(node);
+            return it == m_by_node.end() ? nullptr : &it->second;
+        }
+    }
+
+    [[nodiscard]] bool contains(NodeRef node) const {
+        return find(node) != nullptr;
+    }
+
+    /// \brief Return the value of the node, default constructed if it
+    /// has none.
+    T& operator[](NodeRef node) {
+        if constexpr (HasNodeID) {
+            const unsigned id = GraphTrait::get_node_id(node);
+            m_is_set.set(id);
+            return m_by_id[id];
+        } else {
+            return m_by_node[node];
+        }
+    }
+
+    /// \brief Remove all the values, keeping the storage.
+    void clear() {
+        if constexpr (HasNodeID) {
+            for (const unsigned id : m_is_set.set_bits()) {
+                m_by_id[id] = T();
+            }
+            m_is_set.reset();
+        } else {
+            m_by_node.clear();
+        }
+    }
+
+    /// \brief Apply `fn` on every value.
+    template < typename Fn >
+    void for_each(Fn fn) {
+        if constexpr (HasNodeID) {
+            for (const unsigned id : m_is_set.set_bits()) {
+                fn(m_by_id[id]);
+            }
+        } else {
+            for (auto& [_, value] : m_by_node) {
+                fn(value);
+            }
+        }
+    }
+
+}; // class NodeTable
+
+} // namespace knight
@@ -0,0 +1,478 @@
+//===- patricia_tree.hpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines a persistent map implemented as a Patricia tree.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace knight {
+
+/// \brief Map the keys of a Patricia tree to unique integer indices.
+///
+/// Pointers and integers are supported out of the box, other keys shall
+/// specialize this trait with an injective `index()`.
+template < typename Key >
+struct PatriciaIndexTrait;
+
+template < typename T >
+struct PatriciaIndexTrait< T* > {
+    [[nodiscard]] static uint64_t index(T* key) {
+        return static_cast< uint64_t >(reinterpret_cast< uintptr_t >(key));
+    }
+}; // struct PatriciaIndexTrait< T* >
+
+template < std::integral T >
+struct PatriciaIndexTrait< T > {
+    [[nodiscard]] static uint64_t index(T key) {
+        return static_cast< uint64_t >(key);
+    }
+}; // struct PatriciaIndexTrait< std::integral >
+
+/// \brief Persistent map implemented as a big-endian Patricia tree.
+///
+/// Nodes are immutable and shared between the copies of a tree, so
+/// copying is O(1) and an update only rebuilds the path to the key.
+/// Binary operations skip the physically shared subtrees, hence two maps
+/// which derive from each other by a few updates are merged or compared
+/// in time proportional to their differences.
+///
+/// See "Fast Mergeable Integer Maps" by Okasaki and Gill.
+template < typename Key, typename Value >
+class PatriciaTree {
+  public:
+    using Index = uint64_t;
+
+  private:
+    struct Node {
+        /// \brief The key index for a leaf, the common prefix for a branch.
+        Index m_prefix;
+        /// \brief The branching bit of a branch, zero for a leaf.
+        Index m_branch_bit;
+
+        Node(Index prefix, Index branch_bit)
+            : m_prefix(prefix), m_branch_bit(branch_bit) {}
+
+        [[nodiscard]] bool is_leaf() const { return m_branch_bit == 0U; }
+    }; // struct Node
+
+    using NodeRef = std::shared_ptr< const Node >;
+
+    struct Leaf : Node {
+        Key m_key;
+        Value m_value;
+
+        Leaf(Index index, Key key, Value value)
+            : Node(index, 0U), m_key(std::move(key)),
+              m_value(std::move(value)) {}
+    }; // struct Leaf
+
+    struct Branch : Node {
+        NodeRef m_left;
+        NodeRef m_right;
+
+        Branch(Index prefix, Index branch_bit, NodeRef left, NodeRef right)
+            : Node(prefix, branch_bit), m_left(std::move(left)),
+              m_right(std::move(right)) {}
+    }; // struct Branch
+
+  private:
+    NodeRef m_root;
+
+  public:
+    PatriciaTree() = default;
+
+  public:
+    [[nodiscard]] static Index get_index(const Key& key) {
+        return PatriciaIndexTrait< Key >::index(key);
+    }
+
+    [[nodiscard]] bool empty() const { return m_root == nullptr; }
+
+    void clear() { m_root.reset(); }
+
+    /// \brief Check whether both trees share the same root.
+    [[nodiscard]] bool is_identical(const PatriciaTree& other) const {
+        return m_root == other.m_root;
+    }
+
+    /// \returns the value of the key, or nullptr if it is absent.
+    [[nodiscard]] const Value* find(const Key& key) const {
+        const Index index = get_index(key);
+        const Node* node = m_root.get();
+        while (node != nullptr && !node->is_leaf()) {
+            if (!match_prefix(index, node->m_prefix, node->m_branch_bit)) {
+                return nullptr;
+            }
+            const auto* branch = as_branch(node);
+            node = is_zero_bit(index, node->m_branch_bit)
+                       ? branch->m_left.get()
+                       : branch->m_right.get();
+        }
+        if (node == nullptr || node->m_prefix != index) {
+            return nullptr;
+        }
+        return &as_leaf(node)->m_value;
+    }
+
+    [[nodiscard]] bool contains(const Key& key) const {
+        return find(key) != nullptr;
+    }
+
+    void insert_or_assign(const Key& key, Value value) {
+        const Index index = get_index(key);
+        auto leaf = make_leaf(index, key, std::move(value));
+        auto replace = [&leaf](const NodeRef&) { return leaf; };
+        m_root = insert_with(m_root, index, leaf, replace);
+    }
+
+    void erase(const Key& key) { m_root = remove(m_root, get_index(key)); }
+
+    /// \brief Visit the bindings in the increasing order of the indices.
+    template < typename F >
+    void for_each(F&& f) const {
+        visit(m_root.get(), f);
+    }
+
+    /// \brief Replace the values by `f(key, value)`.
+    ///
+    /// `f` returns std::nullopt to keep a value, so that the subtrees
+    /// without any change stay shared.
+    template < typename F >
+    void transform(F&& f) {
+        m_root = transform(m_root, f);
+    }
+
+    /// \brief Merge the other tree into this one.
+    ///
+    /// The bindings present on one side are kept, and the values of the
+    /// common keys are combined by `op(key, value, other_value)`, which
+    /// returns std::nullopt to keep `value` as is.
+    ///
+    /// \note `op` shall be idempotent: shared subtrees are kept as is.
+    template < typename Op >
+    void merge_with(const PatriciaTree& other, Op&& op) {
+        m_root = merge(m_root, other.m_root, op);
+    }
+
+    /// \brief Check whether every key of this tree is in the other one,
+    /// with `pred(value, other_value)` holding on its values.
+    ///
+    /// \note `pred` shall be reflexive: shared subtrees are not visited.
+    template < typename Pred >
+    [[nodiscard]] bool is_subset_of(const PatriciaTree& other,
+                                    Pred&& pred) const {
+        return is_subset(m_root, other.m_root, pred);
+    }
+
+  private:
+    [[nodiscard]] static const Leaf* as_leaf(const Node* node) {
+        return static_cast< const Leaf* >(node);
+    }
+
+    [[nodiscard]] static const Branch* as_branch(const Node* node) {
+        return static_cast< const Branch* >(node);
+    }
+
+    [[nodiscard]] static NodeRef make_leaf(Index index,
+                                           const Key& key,
+                                           Value value) {
+        return std::make_shared< const Leaf >(index, key, std::move(value));
+    }
+
+    [[nodiscard]] static NodeRef make_branch(Index prefix,
+                                             Index branch_bit,
+                                             NodeRef left,
+                                             NodeRef right) {
+        if (left == nullptr) {
+            return right;
+        }
+        if (right == nullptr) {
+            return left;
+        }
+        return std::make_shared< const Branch >(prefix,
+                                                branch_bit,
+                                                std::move(left),
+                                                std::move(right));
+    }
+
+    /// \brief Rebuild the branch only if one of its children changed.
+    [[nodiscard]] static NodeRef rebuild_branch(const NodeRef& node,
+                                                NodeRef left,
+                                                NodeRef right) {
+        const auto* branch = as_branch(node.get());
+        if (left == branch->m_left && right == branch->m_right) {
+            return node;
+        }
+        return make_branch(node->m_prefix,
+                           node->m_branch_bit,
+                           std::move(left),
+                           std::move(right));
+    }
+
+    [[nodiscard]] static Index mask(Index index, Index branch_bit) {
+        return (index | (branch_bit - 1U)) & ~branch_bit;
+    }
+
+    [[nodiscard]] static bool match_prefix(Index index,
+                                           Index prefix,
+                                           Index branch_bit) {
+        return mask(index, branch_bit) == prefix;
+    }
+
+    [[nodiscard]] static bool is_zero_bit(Index index, Index branch_bit) {
+        return (index & branch_bit) == 0U;
+    }
+
+    /// \brief Check whether the branching bit `m` is above `n`, i.e., the
+    /// prefix of `m` is shorter.
+    [[nodiscard]] static bool is_shorter(Index m, Index n) { return m > n; }
+
+    /// \brief Join two trees with disjoint prefixes.
+    [[nodiscard]] static NodeRef join(Index p0,
+                                      NodeRef t0,
+                                      Index p1,
+                                      NodeRef t1) {
+        const Index branch_bit = std::bit_floor(p0 ^ p1);
+        if (is_zero_bit(p0, branch_bit)) {
+            return make_branch(mask(p0, branch_bit),
+                               branch_bit,
+                               std::move(t0),
+                               std::move(t1));
+        }
+        return make_branch(mask(p0, branch_bit),
+                           branch_bit,
+                           std::move(t1),
+                           std::move(t0));
+    }
+
+    /// \brief Insert `leaf` of `index` into the tree, or replace the
+    /// existing leaf by `combine(existing_leaf)`.
+    template < typename F >
+    [[nodiscard]] static NodeRef insert_with(const NodeRef& node,
+                                             Index index,
+                                             const NodeRef& leaf,
+                                             F& combine) {
+        if (node == nullptr) {
+            return leaf;
+        }
+        if (node->is_leaf()) {
+            if (node->m_prefix == index) {
+                return combine(node);
+            }
+            return join(index, leaf, node->m_prefix, node);
+        }
+        if (!match_prefix(index, node->m_prefix, node->m_branch_bit)) {
+            return join(index, leaf, node->m_prefix, node);
+        }
+        const auto* branch = as_branch(node.get());
+        if (is_zero_bit(index, node->m_branch_bit)) {
+            return rebuild_branch(node,
+                                  insert_with(branch->m_left,
+                                              index,
+                                              leaf,
+                                              combine),
+                                  branch->m_right);
+        }
+        return rebuild_branch(node,
+                              branch->m_left,
+                              insert_with(branch->m_right,
+                                          index,
+                                          leaf,
+                                          combine));
+    }
+
+    [[nodiscard]] static NodeRef remove(const NodeRef& node, Index index) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        if (node->is_leaf()) {
+            return node->m_prefix == index ? nullptr : node;
+        }
+        if (!match_prefix(index, node->m_prefix, node->m_branch_bit)) {
+            return node;
+        }
+        const auto* branch = as_branch(node.get());
+        if (is_zero_bit(index, node->m_branch_bit)) {
+            return rebuild_branch(node,
+                                  remove(branch->m_left, index),
+                                  branch->m_right);
+        }
+        return rebuild_branch(node,
+                              branch->m_left,
+                              remove(branch->m_right, index));
+    }
+
+    template < typename F >
+    static void visit(const Node* node, F& f) {
+        if (node == nullptr) {
+            return;
+        }
+        if (node->is_leaf()) {
+            const auto* leaf = as_leaf(node);
+            f(leaf->m_key, leaf->m_value);
+            return;
+        }
+        visit(as_branch(node)->m_left.get(), f);
+        visit(as_branch(node)->m_right.get(), f);
+    }
+
+    template < typename F >
+    [[nodiscard]] static NodeRef transform(const NodeRef& node, F& f) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        if (node->is_leaf()) {
+            const auto* leaf = as_leaf(node.get());
+            std::optional< Value > value = f(leaf->m_key, leaf->m_value);
+            if (!value) {
+                return node;
+            }
+            return make_leaf(node->m_prefix, leaf->m_key, std::move(*value));
+        }
+        const auto* branch = as_branch(node.get());
+        return rebuild_branch(node,
+                              transform(branch->m_left, f),
+                              transform(branch->m_right, f));
+    }
+
+    template < typename Op >
+    [[nodiscard]] static NodeRef merge(const NodeRef& s,
+                                       const NodeRef& t,
+                                       Op& op) {
+        if (s == t || t == nullptr) {
+            return s;
+        }
+        if (s == nullptr) {
+            return t;
+        }
+        if (s->is_leaf()) {
+            const auto* s_leaf = as_leaf(s.get());
+            auto combine = [&](const NodeRef& t_node) -> NodeRef {
+                const auto* t_leaf = as_leaf(t_node.get());
+                std::optional< Value > value =
+                    op(s_leaf->m_key, s_leaf->m_value, t_leaf->m_value);
+                if (!value) {
+                    return s;
+                }
+                return make_leaf(s->m_prefix, s_leaf->m_key, std::move(*value));
+            };
+            return insert_with(t, s->m_prefix, s, combine);
+        }
+        if (t->is_leaf()) {
+            const auto* t_leaf = as_leaf(t.get());
+            auto combine = [&](const NodeRef& s_node) -> NodeRef {
+                const auto* s_leaf = as_leaf(s_node.get());
+                std::optional< Value > value =
+                    op(s_leaf->m_key, s_leaf->m_value, t_leaf->m_value);
+                if (!value) {
+                    return s_node;
+                }
+                return make_leaf(t->m_prefix, t_leaf->m_key, std::move(*value));
+            };
+            return insert_with(s, t->m_prefix, t, combine);
+        }
+
+        const auto* s_branch = as_branch(s.get());
+        const auto* t_branch = as_branch(t.get());
+        const Index p = s->m_prefix;
+        const Index m = s->m_branch_bit;
+        const Index q = t->m_prefix;
+        const Index n = t->m_branch_bit;
+        if (m == n && p == q) {
+            return rebuild_branch(s,
+                                  merge(s_branch->m_left, t_branch->m_left, op),
+                                  merge(s_branch->m_right,
+                                        t_branch->m_right,
+                                        op));
+        }
+        if (is_shorter(m, n) && match_prefix(q, p, m)) {
+            if (is_zero_bit(q, m)) {
+                return rebuild_branch(s,
+                                      merge(s_branch->m_left, t, op),
+                                      s_branch->m_right);
+            }
+            return rebuild_branch(s,
+                                  s_branch->m_left,
+                                  merge(s_branch->m_right, t, op));
+        }
+        if (is_shorter(n, m) && match_prefix(p, q, n)) {
+            if (is_zero_bit(p, n)) {
+                return make_branch(q,
+                                   n,
+                                   merge(s, t_branch->m_left, op),
+                                   t_branch->m_right);
+            }
+            return make_branch(q,
+                               n,
+                               t_branch->m_left,
+                               merge(s, t_branch->m_right, op));
+        }
+        return join(p, s, q, t);
+    }
+
+    template < typename Pred >
+    [[nodiscard]] static bool is_subset(const NodeRef& s,
+                                        const NodeRef& t,
+                                        Pred& pred) {
+        if (s == t || s == nullptr) {
+            return true;
+        }
+        if (t == nullptr) {
+            return false;
+        }
+        if (s->is_leaf()) {
+            const Node* node = t.get();
+            const Index index = s->m_prefix;
+            while (!node->is_leaf()) {
+                if (!match_prefix(index, node->m_prefix, node->m_branch_bit)) {
+                    return false;
+                }
+                node = is_zero_bit(index, node->m_branch_bit)
+                           ? as_branch(node)->m_left.get()
+                           : as_branch(node)->m_right.get();
+            }
+            return node->m_prefix == index &&
+                   pred(as_leaf(s.get())->m_value, as_leaf(node)->m_value);
+        }
+        if (t->is_leaf()) {
+            // A branch holds at least two bindings.
+            return false;
+        }
+
+        const auto* s_branch = as_branch(s.get());
+        const auto* t_branch = as_branch(t.get());
+        const Index p = s->m_prefix;
+        const Index m = s->m_branch_bit;
+        const Index q = t->m_prefix;
+        const Index n = t->m_branch_bit;
+        if (m == n && p == q) {
+            return is_subset(s_branch->m_left, t_branch->m_left, pred) &&
+                   is_subset(s_branch->m_right, t_branch->m_right, pred);
+        }
+        if (is_shorter(n, m) && match_prefix(p, q, n)) {
+            return is_zero_bit(p, n)
+                       ? is_subset(s, t_branch->m_left, pred)
+                       : is_subset(s, t_branch->m_right, pred);
+        }
+        return false;
+    }
+
+}; // class PatriciaTree
+
+} // namespace knight
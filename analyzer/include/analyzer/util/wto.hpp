@@ -19,8 +19,15 @@
 
 #include "common/util/log.hpp"
 
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/TimeProfiler.h>
+
 #include <climits>
-#include <list>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace knight {
 
@@ -159,6 +166,9 @@ class WtoComponent {
     /// \brief Accept the given visitor
     virtual void accept(WtoComponentVisitor< G, GraphTrait >&) const = 0;
 
+    /// \brief Dump the component, for debugging purpose
+    virtual void dump(llvm::raw_ostream& os) const = 0;
+
 }; // class WtoComponent
 
 template < graph G, typename GraphTrait = GraphTrait< G > >
@@ -181,7 +191,7 @@ class WtoVertex final : public WtoComponent< G, GraphTrait > {
         v.visit(*this);
     }
 
-    void dump(llvm::raw_ostream& os) const {
+    void dump(llvm::raw_ostream& os) const override {
         DumpableTrait< NodeRef >::dump(os, this->m_node);
     }
 
@@ -189,33 +199,28 @@ class WtoVertex final : public WtoComponent< G, GraphTrait > {
 
 template < graph G, typename GraphTrait = GraphTrait< G > >
 class WtoCycle final : public WtoComponent< G, GraphTrait > {
+    friend class Wto< G, GraphTrait >;
+
   public:
     using NodeRef = typename GraphTrait::NodeRef;
     using WtoComponentT = WtoComponent< G, GraphTrait >;
-    using WtoComponentPtr = std::unique_ptr< WtoComponentT >;
-    using WtoComponentList = std::list< WtoComponentPtr >;
+    using WtoComponentRange = llvm::ArrayRef< const WtoComponentT* >;
 
   private:
     /// \brief Head of the cycle
     NodeRef m_head;
 
-    /// \brief List of components
-    WtoComponentList m_components;
+    /// \brief Components of the cycle, a range of the flat component
+    /// array of the order
+    WtoComponentRange m_components;
 
   public:
-    WtoCycle(NodeRef head, WtoComponentList components)
-        : m_head(head), m_components(std::move(components)) {}
+    explicit WtoCycle(NodeRef head) : m_head(head) {}
 
     /// \brief Return the head of the cycle
     NodeRef get_head() const { return this->m_head; }
 
-    std::list< WtoComponentT* > components() const {
-        std::list< WtoComponentT* > res;
-        for (const auto& c : this->m_components) {
-            res.push_back(c.get());
-        }
-        return res;
-    }
+    WtoComponentRange components() const { return this->m_components; }
 
     /// \brief Accept the given visitor
     void accept(WtoComponentVisitor< G, GraphTrait >& v) const override {
@@ -223,10 +228,10 @@ class WtoCycle final : public WtoComponent< G, GraphTrait > {
     }
 
     /// \brief Dump the cycle, for debugging purpose
-    void dump(llvm::raw_ostream& o) const {
+    void dump(llvm::raw_ostream& o) const override {
         o << "(";
         DumpableTrait< NodeRef >::dump(o, this->m_head);
-        for (const auto& c : this->m_components) {
+        for (const auto* c : this->m_components) {
             o << " ";
             c->dump(o);
         }
@@ -259,40 +264,96 @@ class WtoComponentVisitor {
 }; // class WtoComponentVisitor
 
 /// \brief Weak Topological Ordering
+///
+/// The order is built with an iterative version of Bourdoncle's
+/// algorithm, so that its depth is not bounded by the native stack.
+/// The components are stored flat: vertices and cycles are allocated in
+/// chunked arrays, and the components of each cycle are a contiguous
+/// range of one component array.
 template < graph G, typename GraphTrait = GraphTrait< G > >
 class Wto {
   public:
     using GraphRef = G::GraphRef;
     using NodeRef = typename GraphTrait::NodeRef;
+    using SuccNodeIterator = typename GraphTrait::SuccNodeIterator;
     using WtoNestingT = WtoNesting< G, GraphTrait >;
     using WtoComponentT = WtoComponent< G, GraphTrait >;
     using WtoVertexT = WtoVertex< G, GraphTrait >;
     using WtoCycleT = WtoCycle< G, GraphTrait >;
 
   private:
-    using WtoComponentPtr = std::unique_ptr< WtoComponentT >;
-    using WtoComponentList = std::list< WtoComponentPtr >;
-    using WtoComponentListConstIterator =
-        typename WtoComponentList::const_iterator;
+    using WtoComponentRange = llvm::ArrayRef< const WtoComponentT* >;
+    using WtoComponentListConstIterator = const WtoComponentT* const*;
     using Dfn = int;
-    using DfnTable = std::unordered_map< NodeRef, Dfn >;
     using Stack = std::vector< NodeRef >;
     using WtoNestingPtr = std::shared_ptr< WtoNestingT >;
     using NestingTable = std::unordered_map< NodeRef, WtoNestingPtr >;
+    using Partition = std::vector< const WtoComponentT* >;
+
+    /// \brief Depth-first numbers, indexed by node ID when the graph has
+    /// dense node IDs.
+    class DfnTable {
+      private:
+        std::vector< Dfn > m_by_id;
+        std::unordered_map< NodeRef, Dfn > m_by_node;
+
+      public:
+        explicit DfnTable(GraphRef graph) {
+            if constexpr (graph_with_node_id< GraphTrait >) {
+                m_by_id.resize(GraphTrait::num_nodes(graph), 0);
+            }
+        }
+
+        [[nodiscard]] Dfn get(NodeRef n) const {
+            if constexpr (graph_with_node_id< GraphTrait >) {
+                return m_by_id[GraphTrait::get_node_id(n)];
+            } else {
+                auto it = m_by_node.find(n);
+                return it == m_by_node.end() ? 0 : it->second;
+            }
+        }
+
+        void set(NodeRef n, Dfn dfn) {
+            if constexpr (graph_with_node_id< GraphTrait >) {
+                m_by_id[GraphTrait::get_node_id(n)] = dfn;
+            } else {
+                m_by_node[n] = dfn;
+            }
+        }
+    }; // class DfnTable
+
+    /// \brief A pending call of the recursive formulation.
+    ///
+    /// A visit frame returns the lowest depth-first number reachable from
+    /// its vertex. A component frame collects the components of the cycle
+    /// headed by its vertex, then returns the result of the visit it
+    /// replaced.
+    struct Frame {
+        NodeRef vertex;
+        SuccNodeIterator succ_it;
+        SuccNodeIterator succ_end;
+        bool is_component;
+        bool loop;
+        Dfn head;
+        /// The partition the result of the frame goes to.
+        std::size_t partition;
+    }; // struct Frame
 
   private:
-    WtoComponentList m_components;
+    std::deque< WtoVertexT > m_vertices;
+    std::deque< WtoCycleT > m_cycles;
+
+    /// \brief Components of all the cycles and of the top level, each
+    /// being a contiguous range.
+    std::vector< const WtoComponentT* > m_flat_components;
+    WtoComponentRange m_components;
     NestingTable m_nesting_table;
-    DfnTable m_dfn_table;
-    Dfn m_num{0};
-    Stack m_stack;
 
   public:
     /// \brief Compute the weak topological order of the given graph
     explicit Wto(GraphRef cfg) {
-        this->visit(GraphTrait::entry(cfg), this->m_components);
-        this->m_dfn_table.clear();
-        this->m_stack.clear();
+        const llvm::TimeTraceScope scope("Wto::build");
+        this->build(cfg);
         this->build_nesting();
     }
 
@@ -320,7 +381,7 @@ class Wto {
             this->m_nesting_table.insert(std::make_pair(head, this->m_nesting));
             this->m_nesting = std::make_shared< WtoNestingT >(*this->m_nesting);
             this->m_nesting->add(head);
-            for (auto* component : cycle.components()) {
+            for (const auto* component : cycle.components()) {
                 component->accept(*this);
             }
             this->m_nesting = previous_nesting;
@@ -334,98 +395,138 @@ class Wto {
     }; // end class NestingBuilder
 
   private:
-    /// \brief Return the depth-first number of the given node
-    Dfn dfn(NodeRef n) const {
-        auto it = this->m_dfn_table.find(n);
-        if (it != this->m_dfn_table.end()) {
-            return it->second;
-        }
-        return 0;
-    }
-
-    /// \brief Set the depth-first number of the given node
-    void set_dfn(NodeRef n, const Dfn& dfn) {
-        auto res = this->m_dfn_table.insert(std::make_pair(n, dfn));
-        if (!res.second) {
-            (res.first)->second = dfn;
-        }
-    }
-
-    /// \brief Pop a node from the stack
-    NodeRef pop() {
-        knight_assert_msg(!this->m_stack.empty(), "empty stack");
-        NodeRef top = this->m_stack.back();
-        this->m_stack.pop_back();
-        return top;
-    }
+    /// \brief Build the components with an explicit stack of frames.
+    void build(GraphRef cfg) {
+        DfnTable dfn_table(cfg);
+        Dfn num = 0;
+        Stack stack;
+        std::vector< Frame > frames;
+        std::vector< Partition > partitions(1U);
+        /// Offsets of the cycles components in `m_flat_components`.
+        std::vector< std::pair< std::size_t, std::size_t > > cycle_ranges;
+        std::optional< Dfn > result;
+
+        auto start_visit = [&](NodeRef vertex, std::size_t partition) {
+            stack.push_back(vertex);
+            dfn_table.set(vertex, ++num);
+            frames.push_back(Frame{vertex,
+                                   GraphTrait::succ_begin(vertex),
+                                   GraphTrait::succ_end(vertex),
+                                   false,
+                                   false,
+                                   num,
+                                   partition});
+        };
+
+        start_visit(GraphTrait::entry(cfg), 0U);
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            if (frame.is_component) {
+                // The result of the visits of the cycle body is unused.
+                result.reset();
+                bool descended = false;
+                while (frame.succ_it != frame.succ_end) {
+                    NodeRef succ = *frame.succ_it++;
+                    if (dfn_table.get(succ) == 0) {
+                        start_visit(succ, partitions.size() - 1U);
+                        descended = true;
+                        break;
+                    }
+                }
+                if (descended) {
+                    continue;
+                }
+                // The cycle is complete.
+                const Partition& body = partitions.back();
+                m_cycles.emplace_back(frame.vertex);
+                cycle_ranges.emplace_back(m_flat_components.size(),
+                                          body.size());
+                m_flat_components.insert(m_flat_components.end(),
+                                         body.rbegin(),
+                                         body.rend());
+                partitions.pop_back();
+                partitions[frame.partition].push_back(&m_cycles.back());
+                result = frame.head;
+                frames.pop_back();
+                continue;
+            }
 
-    /// \brief Push a node on the stack
-    void push(NodeRef n) { this->m_stack.push_back(n); }
-
-    /// \brief Create the cycle component for the given vertex
-    WtoComponentPtr component(NodeRef vertex) {
-        WtoComponentList partition;
-        for (auto it = GraphTrait::succ_begin(vertex),
-                  et = GraphTrait::succ_end(vertex);
-             it != et;
-             ++it) {
-            NodeRef succ = *it;
-            if (this->dfn(succ) == 0) {
-                this->visit(succ, partition);
+            if (result) {
+                // Back from the visit of `*succ_it`.
+                if (*result <= frame.head) {
+                    frame.head = *result;
+                    frame.loop = true;
+                }
+                result.reset();
+                ++frame.succ_it;
+            }
+            bool descended = false;
+            while (frame.succ_it != frame.succ_end) {
+                NodeRef succ = *frame.succ_it;
+                Dfn succ_dfn = dfn_table.get(succ);
+                if (succ_dfn == 0) {
+                    start_visit(succ, frame.partition);
+                    descended = true;
+                    break;
+                }
+                if (succ_dfn <= frame.head) {
+                    frame.head = succ_dfn;
+                    frame.loop = true;
+                }
+                ++frame.succ_it;
+            }
+            if (descended) {
+                continue;
             }
-        }
-        return std::make_unique< WtoCycleT >(vertex, std::move(partition));
-    }
 
-    /// \brief Visit the given node
-    ///
-    /// Algorithm to build a weak topological order of a graph
-    Dfn visit(NodeRef vertex, WtoComponentList& partition) {
-        Dfn head(0);
-        Dfn min(0);
-
-        this->push(vertex);
-        this->m_num += 1;
-        head = this->m_num;
-        this->set_dfn(vertex, head);
-        bool loop = false;
-        for (auto it = GraphTrait::succ_begin(vertex),
-                  et = GraphTrait::succ_end(vertex);
-             it != et;
-             ++it) {
-            NodeRef succ = *it;
-            Dfn succ_dfn = this->dfn(succ);
-            if (succ_dfn == 0) {
-                min = this->visit(succ, partition);
-            } else {
-                min = succ_dfn;
+            NodeRef vertex = frame.vertex;
+            if (frame.head != dfn_table.get(vertex)) {
+                result = frame.head;
+                frames.pop_back();
+                continue;
             }
-            if (min <= head) {
-                head = min;
-                loop = true;
+            dfn_table.set(vertex, INT_MAX);
+            NodeRef element = stack.back();
+            stack.pop_back();
+            if (!frame.loop) {
+                m_vertices.emplace_back(vertex);
+                partitions[frame.partition].push_back(&m_vertices.back());
+                result = frame.head;
+                frames.pop_back();
+                continue;
             }
-        }
-        if (head == this->dfn(vertex)) {
-            this->set_dfn(vertex, INT_MAX);
-            NodeRef element = this->pop();
-            if (loop) {
-                while (element != vertex) {
-                    this->set_dfn(element, 0);
-                    element = this->pop();
-                }
-                partition.push_front(this->component(vertex));
-            } else {
-                partition.push_front(std::make_unique< WtoVertexT >(vertex));
+            while (element != vertex) {
+                dfn_table.set(element, 0);
+                element = stack.back();
+                stack.pop_back();
             }
+            // Turn the frame into the component frame of the cycle.
+            frame.is_component = true;
+            frame.succ_it = GraphTrait::succ_begin(vertex);
+            frame.succ_end = GraphTrait::succ_end(vertex);
+            partitions.emplace_back();
         }
-        return head;
+
+        const Partition& top = partitions.front();
+        const std::size_t top_offset = m_flat_components.size();
+        m_flat_components.insert(m_flat_components.end(),
+                                 top.rbegin(),
+                                 top.rend());
+
+        // The flat array does not grow anymore, resolve the ranges.
+        const WtoComponentRange flat(m_flat_components);
+        for (std::size_t i = 0U; i < cycle_ranges.size(); ++i) {
+            const auto& [offset, size] = cycle_ranges[i];
+            m_cycles[i].m_components = flat.slice(offset, size);
+        }
+        m_components = flat.drop_front(top_offset);
     }
 
     /// \brief Build the nesting table
     void build_nesting() {
         NestingBuilder builder(this->m_nesting_table);
-        for (auto& unique_component : m_components) {
-            unique_component.get()->accept(builder);
+        for (const auto* component : m_components) {
+            component->accept(builder);
         }
     }
 
@@ -438,24 +539,24 @@ class Wto {
     }
 
     /// \brief Accept the given visitor
-    void accept(WtoComponentVisitor< G, GraphTrait >& v) {
-        for (const auto& c : this->m_components) {
+    void accept(WtoComponentVisitor< G, GraphTrait >& v) const {
+        for (const auto* c : this->m_components) {
             c->accept(v);
         }
     }
 
     WtoComponentListConstIterator begin() const {
-        return this->m_components.cbegin();
+        return this->m_components.begin();
     }
 
     WtoComponentListConstIterator end() const {
-        return this->m_components.cend();
+        return this->m_components.end();
     }
 
     /// \brief Dump the order, for debugging purpose
     void dump(llvm::raw_ostream& o) const {
         for (auto it = this->begin(), et = this->end(); it != et;) {
-            it->dump(o);
+            (*it)->dump(o);
             ++it;
             if (it != et) {
                 o << " ";
@@ -465,4 +566,34 @@ class Wto {
 
 }; // end class Wto
 
+/// \brief Weak topological orders of graphs, each built once and shared
+/// by all the runs over the same graph.
+template < graph G, typename GraphTrait = GraphTrait< G > >
+class WtoCache {
+  public:
+    using GraphRef = G::GraphRef;
+    using WtoT = Wto< G, GraphTrait >;
+
+  private:
+    std::unordered_map< GraphRef, std::unique_ptr< WtoT > > m_wtos;
+
+  public:
+    /// \brief Return the WTO of `cfg`, built on the first request.
+    [[nodiscard]] const WtoT& get(GraphRef cfg) {
+        auto& wto = m_wtos[cfg];
+        if (wto == nullptr) {
+            wto = std::make_unique< WtoT >(cfg);
+        }
+        return *wto;
+    }
+
+    /// \brief Drop the WTO of `cfg`, which shall not be used anymore.
+    void erase(GraphRef cfg) { m_wtos.erase(cfg); }
+
+    void clear() { m_wtos.clear(); }
+
+    [[nodiscard]] std::size_t size() const { return m_wtos.size(); }
+
+}; // class WtoCache
+
 } // namespace knight
\ No newline at end of file
@@ -0,0 +1,434 @@
+//===- alias_classes.cpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the alias classes of the variables of a function,
+//  computed by a unification-based pre-pass.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/alias_classes.hpp"
+#include "common/util/log.hpp"
+
+#include <clang/AST/Attr.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/Stmt.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/TimeProfiler.h>
+
+#include <algorithm>
+#include <utility>
+
+#define DEBUG_TYPE "alias_classes"
+
+namespace knight::analyzer {
+
+using namespace clang;
+
+/// \brief The constraints of the statements of a function, each unifying
+/// the classes of its two sides as soon as it is visited.
+class AliasClassBuilder {
+  private:
+    using ClassID = AliasClasses::ClassID;
+    static constexpr ClassID NoClass = AliasClasses::NoClass;
+    static constexpr ClassID ExternalClass = AliasClasses::ExternalClass;
+
+    AliasClasses& m_classes;
+
+  public:
+    explicit AliasClassBuilder(AliasClasses& classes) : m_classes(classes) {}
+
+  public:
+    void add_params(const FunctionDecl* function) {
+        for (const auto* param : function->parameters()) {
+            const auto loc = m_classes.get_location(param);
+            if (param->getType()->isReferenceType()) {
+                m_classes.unify(loc, ExternalClass);
+            } else {
+                m_classes.unify(m_classes.get_pointee(loc), ExternalClass);
+            }
+        }
+    }
+
+    void add_body(const Stmt* body) {
+        llvm::SmallVector< const Stmt*, 32U > worklist{body};
+        while (!worklist.empty()) {
+            const auto* stmt = worklist.pop_back_val();
+            if (stmt == nullptr) {
+                continue;
+            }
+            add_stmt(stmt);
+            for (const auto* child : stmt->children()) {
+                worklist.push_back(child);
+            }
+        }
+    }
+
+  private:
+    void add_stmt(const Stmt* stmt) {
+        if (const auto* binary = llvm::dyn_cast< BinaryOperator >(stmt)) {
+            if (binary->isAssignmentOp()) {
+                add_assign(binary->getLHS(), binary->getRHS());
+            }
+        } else if (const auto* decl_stmt = llvm::dyn_cast< DeclStmt >(stmt)) {
+            for (const auto* decl : decl_stmt->decls()) {
+                if (const auto* var = llvm::dyn_cast< VarDecl >(decl)) {
+                    add_var(var);
+                }
+            }
+        } else if (const auto* call = llvm::dyn_cast< CallExpr >(stmt)) {
+            if (is_reading_only(call)) {
+                return;
+            }
+            // The callee may store or update anything its arguments
+            // point to.
+            for (const auto* arg : call->arguments()) {
+                m_classes.unify(get_value(arg), ExternalClass);
+            }
+        }
+    }
+
+    /// \brief Check if the call neither writes the memory nor returns a
+    /// pointer, e.g. a `pure` or `const` function returning an integer,
+    /// so that its arguments do not escape.
+    [[nodiscard]] static bool is_reading_only(const CallExpr* call) {
+        const auto* callee = call->getDirectCallee();
+        if (callee == nullptr || (!callee->hasAttr< PureAttr >() &&
+                                  !callee->hasAttr< ConstAttr >())) {
+            return false;
+        }
+        const auto type = call->getType();
+        return !type->isAnyPointerType() && !type->isRecordType() &&
+               !type->isReferenceType();
+    }
+
+    void add_assign(const Expr* lhs, const Expr* rhs) {
+        const auto value = get_value(rhs);
+        if (value != NoClass) {
+            m_classes.unify(m_classes.get_pointee(get_location(lhs)), value);
+        }
+    }
+
+    void add_var(const VarDecl* var) {
+        const auto loc = m_classes.get_location(var);
+        const auto* init = var->getInit();
+        if (init == nullptr) {
+            return;
+        }
+        if (var->getType()->isReferenceType()) {
+            m_classes.unify(loc, get_location(init));
+            return;
+        }
+        const auto value = get_value(init);
+        if (value != NoClass) {
+            m_classes.unify(m_classes.get_pointee(loc), value);
+        }
+    }
+
+    [[nodiscard]] ClassID merge(ClassID a, ClassID b) {
+        if (a == NoClass) {
+            return b;
+        }
+        m_classes.unify(a, b);
+        return m_classes.find(a);
+    }
+
+    /// \brief Get the class of the locations the glvalue designates.
+    [[nodiscard]] ClassID get_location(const Expr* expr) {
+        expr = expr->IgnoreParens();
+        if (const auto* ref = llvm::dyn_cast< DeclRefExpr >(expr)) {
+            if (const auto* var = llvm::dyn_cast< VarDecl >(ref->getDecl())) {
+                return m_classes.get_location(var);
+            }
+            return ExternalClass;
+        }
+        if (const auto* unary = llvm::dyn_cast< UnaryOperator >(expr)) {
+            if (unary->getOpcode() == UO_Deref) {
+                return get_pointed_location(unary->getSubExpr());
+            }
+            if (unary->isPrefix() && unary->isIncrementDecrementOp()) {
+                return get_location(unary->getSubExpr());
+            }
+        }
+        if (const auto* member = llvm::dyn_cast< MemberExpr >(expr)) {
+            return member->isArrow()
+                       ? get_pointed_location(member->getBase())
+                       : get_location(member->getBase());
+        }
+        if (const auto* subscript =
+                llvm::dyn_cast< ArraySubscriptExpr >(expr)) {
+            return get_pointed_location(subscript->getBase());
+        }
+        if (const auto* binary = llvm::dyn_cast< BinaryOperator >(expr)) {
+            if (binary->isAssignmentOp()) {
+                return get_location(binary->getLHS());
+            }
+            if (binary->isCommaOp()) {
+                return get_location(binary->getRHS());
+            }
+        }
+        if (const auto* cond =
+                llvm::dyn_cast< AbstractConditionalOperator >(expr)) {
+            return merge(get_location(cond->getTrueExpr()),
+                         get_location(cond->getFalseExpr()));
+        }
+        if (const auto* cast = llvm::dyn_cast< CastExpr >(expr)) {
+            return get_location(cast->getSubExpr());
+        }
+        if (const auto* full = llvm::dyn_cast< FullExpr >(expr)) {
+            return get_location(full->getSubExpr());
+        }
+        if (const auto* opaque = llvm::dyn_cast< OpaqueValueExpr >(expr)) {
+            if (const auto* source = opaque->getSourceExpr()) {
+                return get_location(source);
+            }
+        }
+        if (llvm::isa< StringLiteral,
+                       CompoundLiteralExpr,
+                       MaterializeTemporaryExpr >(expr)) {
+            return m_classes.create_class();
+        }
+        // The calls returning a reference, and the glvalues not modeled.
+        return ExternalClass;
+    }
+
+    /// \brief Get the class of the locations the pointer value points to,
+    /// a fresh one if it points to none so far.
+    [[nodiscard]] ClassID get_pointed_location(const Expr* pointer) {
+        const auto value = get_value(pointer);
+        return value != NoClass ? value : m_classes.create_class();
+    }
+
+    /// \brief Get the class of the locations the value may point to,
+    /// `NoClass` if it cannot hold a pointer.
+    [[nodiscard]] ClassID get_value(const Expr* expr) {
+        expr = expr->IgnoreParens();
+        if (expr->isGLValue()) {
+            return m_classes.get_pointee(get_location(expr));
+        }
+        if (const auto* cast = llvm::dyn_cast< CastExpr >(expr)) {
+            return get_cast_value(cast);
+        }
+        if (const auto* unary = llvm::dyn_cast< UnaryOperator >(expr)) {
+            if (unary->getOpcode() == UO_AddrOf) {
+                return get_location(unary->getSubExpr());
+            }
+            if (unary->isIncrementDecrementOp()) {
+                return get_value(unary->getSubExpr());
+            }
+            return NoClass;
+        }
+        if (const auto* binary = llvm::dyn_cast< BinaryOperator >(expr)) {
+            if (binary->isAssignmentOp()) {
+                return get_value(binary->getLHS());
+            }
+            if (binary->isCommaOp()) {
+                return get_value(binary->getRHS());
+            }
+            if (binary->isComparisonOp() || binary->isLogicalOp()) {
+                return NoClass;
+            }
+            // The pointer arithmetic stays in the class of its pointer.
+            return merge(get_value(binary->getLHS()),
+                         get_value(binary->getRHS()));
+        }
+        if (const auto* cond =
+                llvm::dyn_cast< AbstractConditionalOperator >(expr)) {
+            return merge(get_value(cond->getTrueExpr()),
+                         get_value(cond->getFalseExpr()));
+        }
+        if (const auto* init_list = llvm::dyn_cast< InitListExpr >(expr)) {
+            ClassID value = NoClass;
+            for (const auto* init : init_list->inits()) {
+                value = merge(value, get_value(init));
+            }
+            return value;
+        }
+        if (const auto* full = llvm::dyn_cast< FullExpr >(expr)) {
+            return get_value(full->getSubExpr());
+        }
+        if (const auto* opaque = llvm::dyn_cast< OpaqueValueExpr >(expr)) {
+            if (const auto* source = opaque->getSourceExpr()) {
+                return get_value(source);
+            }
+        }
+        if (llvm::isa< CXXNullPtrLiteralExpr, GNUNullExpr >(expr)) {
+            return NoClass;
+        }
+        // The call results and the values not modeled may point anywhere.
+        const auto type = expr->getType();
+        return type->isAnyPointerType() || type->isRecordType()
+                   ? ExternalClass
+                   : NoClass;
+    }
+
+    [[nodiscard]] ClassID get_cast_value(const CastExpr* cast) {
+        const auto* sub = cast->getSubExpr();
+        switch (cast->getCastKind()) {
+            case CK_LValueToRValue:
+                return m_classes.get_pointee(get_location(sub));
+            case CK_ArrayToPointerDecay:
+            case CK_FunctionToPointerDecay:
+                return get_location(sub);
+            case CK_NullToPointer:
+                return NoClass;
+            case CK_IntegralToPointer:
+                return ExternalClass;
+            case CK_PointerToIntegral:
+                // The integers are not tracked, so that the pointer
+                // escapes.
+                m_classes.unify(get_value(sub), ExternalClass);
+                return NoClass;
+            case CK_PointerToBoolean:
+                return NoClass;
+            default:
+                return get_value(sub);
+        }
+    }
+
+}; // class AliasClassBuilder
+
+AliasClasses::AliasClasses(ProcCFG::DeclRef decl) {
+    const llvm::TimeTraceScope scope("AliasClasses");
+
+    // The external class points to itself.
+    (void)create_class();
+    m_pointees[ExternalClass] = ExternalClass;
+
+    AliasClassBuilder builder(*this);
+    if (const auto* function = decl->getAsFunction()) {
+        builder.add_params(function);
+    }
+    if (const auto* body = decl->getBody()) {
+        builder.add_body(body);
+    }
+
+    knight_log(llvm::outs() << "alias classes: " << get_num_classes()
+                            << " for " << m_var_locations.size()
+                            << " variables\n");
+}
+
+AliasClasses::ClassID AliasClasses::find(ClassID cls) const {
+    ClassID root = cls;
+    while (m_parents[root] != root) {
+        root = m_parents[root];
+    }
+    while (m_parents[cls] != root) {
+        cls = std::exchange(m_parents[cls], root);
+    }
+    return root;
+}
+
+AliasClasses::ClassID AliasClasses::create_class() {
+    const auto cls = static_cast< ClassID >(m_parents.size());
+    m_parents.push_back(cls);
+    m_pointees.push_back(NoClass);
+    return cls;
+}
+
+AliasClasses::ClassID AliasClasses::get_location(const clang::VarDecl* var) {
+    if (!var->hasLocalStorage()) {
+        return ExternalClass;
+    }
+    auto [it, inserted] = m_var_locations.try_emplace(var, NoClass);
+    if (inserted) {
+        it->second = create_class();
+    }
+    return it->second;
+}
+
+AliasClasses::ClassID AliasClasses::get_pointee(ClassID cls) {
+    if (cls == NoClass) {
+        return NoClass;
+    }
+    auto root = find(cls);
+    if (m_pointees[root] == NoClass) {
+        const auto pointee = create_class();
+        m_pointees[root] = pointee;
+    }
+    return find(m_pointees[root]);
+}
+
+void AliasClasses::unify(ClassID a, ClassID b) {
+    llvm::SmallVector< std::pair< ClassID, ClassID >, 8U > worklist;
+    worklist.emplace_back(a, b);
+    while (!worklist.empty()) {
+        auto [lhs, rhs] = worklist.pop_back_val();
+        if (lhs == NoClass || rhs == NoClass) {
+            continue;
+        }
+        lhs = find(lhs);
+        rhs = find(rhs);
+        if (lhs == rhs) {
+            continue;
+        }
+        // The smaller ID is kept as the root, so that the external class
+        // stays its own root.
+        const auto root = std::min(lhs, rhs);
+        const auto child = std::max(lhs, rhs);
+        m_parents[child] = root;
+
+        const auto root_pointee = m_pointees[root];
+        const auto child_pointee = m_pointees[child];
+        if (root_pointee == NoClass) {
+            m_pointees[root] = child_pointee;
+        } else {
+            worklist.emplace_back(root_pointee, child_pointee);
+        }
+    }
+}
+
+AliasClasses::ClassID AliasClasses::get_var_pointee(
+    const clang::VarDecl* var) const {
+    if (!var->hasLocalStorage()) {
+        return ExternalClass;
+    }
+    auto it = m_var_locations.find(var);
+    if (it == m_var_locations.end()) {
+        return NoClass;
+    }
+    const auto pointee = m_pointees[find(it->second)];
+    return pointee != NoClass ? find(pointee) : NoClass;
+}
+
+bool AliasClasses::may_alias(const clang::VarDecl* p,
+                             const clang::VarDecl* q) const {
+    const auto p_pointee = get_var_pointee(p);
+    return p_pointee != NoClass && p_pointee == get_var_pointee(q);
+}
+
+bool AliasClasses::may_point_to(const clang::VarDecl* p,
+                                const clang::VarDecl* var) const {
+    const auto p_pointee = get_var_pointee(p);
+    if (p_pointee == NoClass) {
+        return false;
+    }
+    if (!var->hasLocalStorage()) {
+        return p_pointee == ExternalClass;
+    }
+    auto it = m_var_locations.find(var);
+    return it != m_var_locations.end() && find(it->second) == p_pointee;
+}
+
+bool AliasClasses::may_point_to_external(const clang::VarDecl* p) const {
+    return get_var_pointee(p) == ExternalClass;
+}
+
+unsigned AliasClasses::get_num_classes() const {
+    unsigned num_classes = 0U;
+    for (ClassID cls = 0U; cls < m_parents.size(); ++cls) {
+        if (m_parents[cls] == cls) {
+            ++num_classes;
+        }
+    }
+    return num_classes;
+}
+
+} // namespace knight::analyzer
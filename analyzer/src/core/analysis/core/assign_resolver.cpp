@@ -19,6 +19,42 @@
 
 namespace knight::analyzer {
 
+namespace {
+
+/// \brief The `y op c` of an integral rhs, where `op` is `+` or `-`.
+struct VarPlusNum {
+    clang::BinaryOperator::Opcode op;
+    ZVariable y;
+    ZNum c;
+}; // struct VarPlusNum
+
+/// \brief Match `y + c`, `c + y` or `y - c` on the symbolic expression,
+/// without folding it into a linear expression.
+std::optional< VarPlusNum > get_as_var_plus_num(SExprRef sexpr) {
+    const auto* binary = dyn_cast< BinarySymExpr >(sexpr);
+    if (binary == nullptr) {
+        return std::nullopt;
+    }
+    const auto op = binary->get_opcode();
+    if (op != clang::BO_Add && op != clang::BO_Sub) {
+        return std::nullopt;
+    }
+    const auto* lhs = binary->get_lhs();
+    const auto* rhs = binary->get_rhs();
+    if (op == clang::BO_Add && isa< ScalarInt >(lhs)) {
+        std::swap(lhs, rhs);
+    }
+    const auto* y = dyn_cast< Sym >(lhs);
+    const auto* c = dyn_cast< ScalarInt >(rhs);
+    if (y == nullptr || c == nullptr ||
+        !y->get_type()->isIntegralOrEnumerationType()) {
+        return std::nullopt;
+    }
+    return VarPlusNum{op, ZVariable(y), c->get_value()};
+}
+
+} // anonymous namespace
+
 void AssignResolver::handle_ptr_assign(internal::AssignmentContext assign_ctx,
                                        SymbolRef res_sym,
                                        bool is_direct_assign,
@@ -43,12 +79,13 @@ void AssignResolver::handle_ptr_assign(internal::AssignmentContext assign_ctx,
     // auto region_addr_val = llvm::dyn_cast< RegionAddr >(binary_sexpr);
 }
 
-void AssignResolver::handle_int_assign(internal::AssignmentContext assign_ctx,
-                                       SymbolRef res_sym,
-                                       bool is_direct_assign,
-                                       clang::BinaryOperator::Opcode op,
-                                       ProgramStateRef& state,
-                                       SExprRef& binary_sexpr) const {
+std::optional< ZLinearConstraint > AssignResolver::handle_int_assign(
+    internal::AssignmentContext assign_ctx,
+    SymbolRef res_sym,
+    bool is_direct_assign,
+    clang::BinaryOperator::Opcode op,
+    ProgramStateRef& state,
+    SExprRef& binary_sexpr) const {
     auto type = assign_ctx.rhs_sexpr->get_type();
     auto& sym_mgr = m_ctx->get_symbol_manager();
     ZVariable x(res_sym);
@@ -58,14 +95,56 @@ void AssignResolver::handle_int_assign(internal::AssignmentContext assign_ctx,
 
     knight_log_nl(llvm::outs() << "zvar x: "; x.dump(llvm::outs());
                   llvm::outs() << "\n";);
-    auto lhs_var = assign_ctx.lhs_sexpr != nullptr
-                       ? assign_ctx.lhs_sexpr->get_as_zvariable()
-                       : std::nullopt;
-    auto lhs_num = assign_ctx.lhs_sexpr != nullptr
-                       ? assign_ctx.lhs_sexpr->get_as_znum()
-                       : std::nullopt;
-    auto rhs_var = assign_ctx.rhs_sexpr->get_as_zvariable();
-    auto rhs_num = assign_ctx.rhs_sexpr->get_as_znum();
+    // The constant propagation `x = c`, `x = y` and `x = y +/- c` is
+    // matched on the leaves of the rhs, so that the common assignments
+    // neither fold nor allocate a linear expression.
+    if (is_direct_assign) {
+        const auto* rhs = assign_ctx.rhs_sexpr;
+        if (const auto* scalar_int = dyn_cast< ScalarInt >(rhs)) {
+            const auto& znum = scalar_int->get_value();
+            LinearNumericalAssignEvent event(ZVarAssignZNum{x, znum}, state);
+            m_sym_resolver->dispatch_event(event);
+
+            cstr -= znum;
+            return ZLinearConstraint(cstr,
+                                     LinearConstraintKind::LCK_Equality);
+        }
+        if (const auto* sym = dyn_cast< Sym >(rhs)) {
+            ZVariable y(sym);
+            LinearNumericalAssignEvent event(ZVarAssignZVar{x, y}, state);
+            m_sym_resolver->dispatch_event(event);
+
+            cstr -= y;
+            return ZLinearConstraint(cstr,
+                                     LinearConstraintKind::LCK_Equality);
+        }
+        if (auto var_plus_num = get_as_var_plus_num(rhs)) {
+            const auto& [bop, y, c] = *var_plus_num;
+            ZVarAssignBinaryVarNum assign{bop, x, y, c};
+            LinearNumericalAssignEvent event(assign, state);
+            m_sym_resolver->dispatch_event(event);
+
+            cstr -= y;
+            if (bop == clang::BO_Add) {
+                cstr -= c;
+            } else {
+                cstr += c;
+            }
+            return ZLinearConstraint(cstr,
+                                     LinearConstraintKind::LCK_Equality);
+        }
+    }
+
+    std::optional< ZVariable > lhs_var;
+    std::optional< ZNum > lhs_num;
+    std::optional< ZVariable > rhs_var;
+    std::optional< ZNum > rhs_num;
+    if (!is_direct_assign) {
+        lhs_var = assign_ctx.lhs_sexpr->get_as_zvariable();
+        lhs_num = lhs_var ? std::nullopt : assign_ctx.lhs_sexpr->get_as_znum();
+        rhs_var = assign_ctx.rhs_sexpr->get_as_zvariable();
+        rhs_num = rhs_var ? std::nullopt : assign_ctx.rhs_sexpr->get_as_znum();
+    }
     if (!is_direct_assign && lhs_var && rhs_var) {
         LinearNumericalAssignEvent
             event(ZVarAssignBinaryVarVar{op, x, *lhs_var, *rhs_var}, state);
@@ -81,14 +160,15 @@ void AssignResolver::handle_int_assign(internal::AssignmentContext assign_ctx,
         m_sym_resolver->dispatch_event(event);
 
         cstr -= (y + z);
-    } else if (auto zexpr = binary_sexpr->get_as_zexpr()) {
-        if (auto znum = binary_sexpr->get_as_znum()) {
-            LinearNumericalAssignEvent event(ZVarAssignZNum{x, *znum}, state);
+    } else if (auto zexpr = sym_mgr.get_zexpr(binary_sexpr)) {
+        if (zexpr->is_constant()) {
+            const auto& znum = zexpr->get_constant_term();
+            LinearNumericalAssignEvent event(ZVarAssignZNum{x, znum}, state);
             m_sym_resolver->dispatch_event(event);
 
-            binary_sexpr = sym_mgr.get_scalar_int(*znum, type);
-            cstr -= *znum;
-        } else if (auto zvar = binary_sexpr->get_as_zvariable()) {
+            binary_sexpr = sym_mgr.get_scalar_int(znum, type);
+            cstr -= znum;
+        } else if (auto zvar = zexpr->get_as_single_variable()) {
             LinearNumericalAssignEvent event(ZVarAssignZVar{x, *zvar}, state);
             m_sym_resolver->dispatch_event(event);
 
@@ -109,10 +189,9 @@ void AssignResolver::handle_int_assign(internal::AssignmentContext assign_ctx,
         cstr -= y;
     } else {
         knight_log(llvm::outs() << "unhandled case!\n");
-        return;
+        return std::nullopt;
     }
-    state = state->add_zlinear_constraint(
-        ZLinearConstraint(cstr, LinearConstraintKind::LCK_Equality));
+    return ZLinearConstraint(cstr, LinearConstraintKind::LCK_Equality);
 }
 
 ProgramStateRef AssignResolver::resolve(
@@ -163,6 +242,7 @@ ProgramStateRef AssignResolver::resolve(
                        << *assign_ctx.rhs_sexpr << "\n";
         llvm::outs() << "binary_sexpr: " << *binary_sexpr << "\n";);
 
+    std::optional< ZLinearConstraint > cstr;
     if (type->isPointerType()) {
         handle_ptr_assign(assign_ctx,
                           res_sym,
@@ -171,12 +251,19 @@ ProgramStateRef AssignResolver::resolve(
                           state,
                           binary_sexpr);
     } else if (type->isIntegralOrEnumerationType()) {
-        handle_int_assign(assign_ctx,
-                          res_sym,
-                          is_direct_assign,
-                          op,
-                          state,
-                          binary_sexpr);
+        cstr = handle_int_assign(assign_ctx,
+                                 res_sym,
+                                 is_direct_assign,
+                                 op,
+                                 state,
+                                 binary_sexpr);
+    }
+
+    // The listeners of the assign events are done with the state, the
+    // constraint and the new value are interned in a single state.
+    ProgramStateBuilder builder(state);
+    if (cstr) {
+        builder.add_zlinear_constraint(*cstr);
     }
 
     if (assign_ctx.treg) {
@@ -186,16 +273,16 @@ ProgramStateRef AssignResolver::resolve(
                       res_sym->dump(llvm::outs());
                       llvm::outs() << "\n");
 
-        state = state->set_region_def(*assign_ctx.treg,
-                                      m_ctx->get_current_stack_frame(),
-                                      cast< RegionDef >(res_sym));
+        builder.set_region_def(*assign_ctx.treg,
+                               m_ctx->get_current_stack_frame(),
+                               cast< RegionDef >(res_sym));
     } else {
-        state = state->set_stmt_sexpr(*assign_ctx.stmt,
-                                      m_ctx->get_current_stack_frame(),
-                                      res_sym);
+        builder.set_stmt_sexpr(*assign_ctx.stmt,
+                               m_ctx->get_current_stack_frame(),
+                               res_sym);
     }
 
-    return state;
+    return builder.freeze();
 }
 
 } // namespace knight::analyzer
\ No newline at end of file
@@ -141,10 +141,11 @@ void BinaryOpResolver::handle_int_non_assign_binary_operation(
                   llvm::outs() << "\n";);
 
     ZLinearExpr cstr(x);
+    std::optional< ZLinearConstraint > assign_cstr;
     auto lhs_var = lhs_sexpr->get_as_zvariable();
-    auto lhs_num = lhs_sexpr->get_as_znum();
+    auto lhs_num = lhs_var ? std::nullopt : lhs_sexpr->get_as_znum();
     auto rhs_var = rhs_sexpr->get_as_zvariable();
-    auto rhs_num = rhs_sexpr->get_as_znum();
+    auto rhs_num = rhs_var ? std::nullopt : rhs_sexpr->get_as_znum();
     if (lhs_var && rhs_var) {
         LinearNumericalAssignEvent
             event(ZVarAssignBinaryVarVar{op, x, *lhs_var, *rhs_var}, state);
@@ -159,14 +160,15 @@ void BinaryOpResolver::handle_int_non_assign_binary_operation(
         m_sym_resolver->dispatch_event(event);
 
         cstr -= (y + z);
-    } else if (auto zexpr = binary_sexpr->get_as_zexpr()) {
-        if (auto znum = binary_sexpr->get_as_znum()) {
-            LinearNumericalAssignEvent event(ZVarAssignZNum{x, *znum}, state);
+    } else if (auto zexpr = sym_mgr.get_zexpr(binary_sexpr)) {
+        if (zexpr->is_constant()) {
+            const auto& znum = zexpr->get_constant_term();
+            LinearNumericalAssignEvent event(ZVarAssignZNum{x, znum}, state);
             m_sym_resolver->dispatch_event(event);
 
-            binary_sexpr = sym_mgr.get_scalar_int(*znum, bo_ctx.result_type);
-            cstr -= *znum;
-        } else if (auto zvar = binary_sexpr->get_as_zvariable()) {
+            binary_sexpr = sym_mgr.get_scalar_int(znum, bo_ctx.result_type);
+            cstr -= znum;
+        } else if (auto zvar = zexpr->get_as_single_variable()) {
             LinearNumericalAssignEvent event(ZVarAssignZVar{x, *zvar}, state);
             m_sym_resolver->dispatch_event(event);
 
@@ -178,8 +180,13 @@ void BinaryOpResolver::handle_int_non_assign_binary_operation(
 
             cstr -= *zexpr;
         }
-        state = state->add_zlinear_constraint(
-            ZLinearConstraint(cstr, LinearConstraintKind::LCK_Equality));
+        assign_cstr =
+            ZLinearConstraint(cstr, LinearConstraintKind::LCK_Equality);
+    }
+
+    ProgramStateBuilder builder(state);
+    if (assign_cstr) {
+        builder.add_zlinear_constraint(*assign_cstr);
     }
 
     knight_log(llvm::outs()
@@ -187,22 +194,23 @@ void BinaryOpResolver::handle_int_non_assign_binary_operation(
                << binary_sexpr->get_worst_complexity() << "\n");
 
     if (binary_sexpr->get_worst_complexity() > 1U) {
-        state = state->set_stmt_sexpr(bo_ctx.result_stmt,
-                                      m_ctx->get_current_stack_frame(),
-                                      binary_conjured_sym);
+        builder.set_stmt_sexpr(bo_ctx.result_stmt,
+                               m_ctx->get_current_stack_frame(),
+                               binary_conjured_sym);
 
         knight_log_nl(llvm::outs() << "set binary conjured: ";
                       binary_conjured_sym->dump(llvm::outs());
                       llvm::outs() << "\n");
     } else {
-        state = state->set_stmt_sexpr(bo_ctx.result_stmt,
-                                      m_ctx->get_current_stack_frame(),
-                                      binary_sexpr);
+        builder.set_stmt_sexpr(bo_ctx.result_stmt,
+                               m_ctx->get_current_stack_frame(),
+                               binary_sexpr);
 
         knight_log_nl(llvm::outs() << "set binary binary_sexpr: ";
                       binary_sexpr->dump(llvm::outs());
                       llvm::outs() << "\n");
     }
+    state = builder.freeze();
     knight_log(llvm::outs()
                << "after transfer binary here state: " << *state << "\n");
 
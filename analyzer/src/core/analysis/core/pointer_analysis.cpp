@@ -12,11 +12,70 @@
 //===------------------------------------------------------------------===//
 
 #include "analyzer/core/analysis/core/pointer_analysis.hpp"
+#include "analyzer/core/location_manager.hpp"
+#include "analyzer/core/stack_frame.hpp"
+#include "analyzer/tooling/context.hpp"
+#include "cg/core/andersen.hpp"
+#include "common/util/clang.hpp"
+
+#include <clang/Basic/SourceManager.h>
 
 namespace knight::analyzer {
 
-void PointerAnalysis::analyze_begin_function(AnalysisContext& ctx) const {
-    // Placeholder for future implementation
+namespace {
+
+/// \brief Get the node of the variable in the points-to constraints of
+/// knight-cg, see `cg::PointsToExtractor`.
+std::string get_points_to_node(const clang::VarDecl* var,
+                               const clang::Decl* function) {
+    if (!var->hasLocalStorage() && !var->isStaticLocal()) {
+        return clang_util::get_mangled_name(var);
+    }
+    const auto* named_function =
+        llvm::dyn_cast_or_null< clang::NamedDecl >(function);
+    auto owner = named_function != nullptr
+                     ? clang_util::get_mangled_name(named_function)
+                     : std::string();
+    if (const auto* param = llvm::dyn_cast< clang::ParmVarDecl >(var)) {
+        return cg::get_param_node(owner, param->getFunctionScopeIndex());
+    }
+    auto& sm = var->getASTContext().getSourceManager();
+    auto presumed_loc = sm.getPresumedLoc(var->getLocation());
+    if (presumed_loc.isInvalid()) {
+        return cg::get_local_node(owner, var->getNameAsString(), 0U, 0U);
+    }
+    return cg::get_local_node(owner,
+                              var->getNameAsString(),
+                              presumed_loc.getLine(),
+                              presumed_loc.getColumn());
+}
+
+} // anonymous namespace
+
+void PointerAnalysis::analyze_begin_function(
+    [[maybe_unused]] AnalysisContext& ctx) const {
+    // Placeholder for future implementation. The alias classes are built
+    // on the first query, see `may_alias`.
+}
+
+bool PointerAnalysis::may_alias(const KnightContext& ctx,
+                                const StackFrame* frame,
+                                const clang::VarDecl* p,
+                                const clang::VarDecl* q) {
+    const auto& opts = ctx.get_current_options();
+    if (opts.analyzer_opts.alias_classes &&
+        !frame->get_manager()
+             ->get_alias_classes(frame->get_decl())
+             .may_alias(p, q)) {
+        return false;
+    }
+    if (opts.points_to != nullptr) {
+        return opts.points_to->may_alias(get_points_to_node(p,
+                                                            frame->get_decl()),
+                                         get_points_to_node(q,
+                                                            frame->get_decl()));
+    }
+    return true;
 }
 
 } // namespace knight::analyzer
\ No newline at end of file
@@ -18,8 +18,11 @@
 #include "analyzer/core/analysis/core/unary_op_resolver.hpp"
 #include "analyzer/core/analysis_manager.hpp"
 #include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/core/engine/call_inliner.hpp"
+#include "analyzer/core/location_manager.hpp"
 #include "analyzer/core/program_state.hpp"
 #include "analyzer/core/region/region.hpp"
+#include "analyzer/core/summary.hpp"
 #include "analyzer/core/symbol.hpp"
 #include "common/util/log.hpp"
 #include "llvm/ADT/APInt.h"
@@ -30,7 +33,9 @@
 #include <llvm/Support/WithColor.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <mutex>
 #include <optional>
+#include <vector>
 
 #define DEBUG_TYPE "SymbolResolver"
 
@@ -288,6 +293,23 @@ void SymbolResolver::analyze_stmt(const clang::Stmt* stmt,
     const_cast< SymbolResolver* >(this)->Visit(stmt);
 }
 
+ProgramStateRef SymbolResolver::assume_non_linear_constraint(
+    const ProgramStateRef& state,
+    SExprRef constraint,
+    AnalysisContext& ctx) const {
+    const auto* frame = ctx.get_current_stack_frame();
+    auto& solver =
+        frame->get_manager()->get_non_linear_solver(frame->get_decl());
+    const auto& constraints =
+        state->get_constraint_system().get_non_linear_constraint_set();
+    if (!solver.is_feasible(constraints, constraint)) {
+        knight_log(llvm::outs() << "infeasible non-linear constraint: "
+                                << constraint << "\n");
+        return state->set_to_bottom();
+    }
+    return state->add_non_linear_constraint(constraint);
+}
+
 void SymbolResolver::filter_condition(const clang::Expr* condition,
                                       bool assertion_result,
                                       AnalysisContext& ctx) const {
@@ -345,7 +367,35 @@ void SymbolResolver::filter_condition(const clang::Expr* condition,
             LinearNumericalAssumptionEvent event(PredicateZVarZNum{op, l, r},
                                                  state);
             dispatch_event(event);
+        } else if (auto cstr = binary_sexpr->get_as_zconstraint()) {
+            state = state->assume_zlinear_constraints(
+                assertion_result ? *cstr : cstr->negate());
+        } else if (lhs->get_type()->isIntegralOrEnumerationType()) {
+            const auto* constraint =
+                assertion_result
+                    ? binary_sexpr
+                    : sym_mgr.get_binary_sym_expr(
+                          lhs,
+                          rhs,
+                          clang::BinaryOperator::negateComparisonOp(op),
+                          binary_sexpr->get_type());
+            state = assume_non_linear_constraint(state, constraint, ctx);
         }
+    } else if (const auto* binary_sexpr =
+                   llvm::dyn_cast< BinarySymExpr >(stmt_sexpr);
+               binary_sexpr != nullptr &&
+               binary_sexpr->get_type()->isIntegralOrEnumerationType() &&
+               !stmt_sexpr->get_as_zexpr()) {
+        // A non-linear value is compared against zero.
+        const auto* zero =
+            sym_mgr.get_scalar_int(ZNum(0), binary_sexpr->get_type());
+        const auto* constraint =
+            sym_mgr.get_binary_sym_expr(binary_sexpr,
+                                        zero,
+                                        assertion_result ? clang::BO_NE
+                                                         : clang::BO_EQ,
+                                        condition->getType());
+        state = assume_non_linear_constraint(state, constraint, ctx);
     }
 
     const auto* bool_assertion =
@@ -385,8 +435,15 @@ void SymbolResolver::VisitCastExpr(const clang::CastExpr* cast_expr) const {
     }
 
     auto& ast_ctx = m_ctx->get_ast_context();
-    auto src_type_size = ast_ctx.getTypeSize(src_type);
-    auto dst_type_size = ast_ctx.getTypeSize(dst_type);
+    uint64_t src_type_size = 0U;
+    uint64_t dst_type_size = 0U;
+    {
+        // The type info is memoized in the AST context.
+        const std::lock_guard< std::mutex > lock(
+            KnightContext::get_ast_mutex());
+        src_type_size = ast_ctx.getTypeSize(src_type);
+        dst_type_size = ast_ctx.getTypeSize(dst_type);
+    }
 
     SExprRef src_sexpr =
         state
@@ -424,4 +481,59 @@ void SymbolResolver::VisitCastExpr(const clang::CastExpr* cast_expr) const {
                                            dst_sexpr));
 }
 
+void SymbolResolver::VisitCallExpr(const clang::CallExpr* call_expr) const {
+    const auto* callee = call_expr->getDirectCallee();
+    auto type = call_expr->getType();
+    if (callee == nullptr || !type->isIntegralOrEnumerationType()) {
+        return;
+    }
+
+    auto& knight_ctx = m_ctx->get_knight_context();
+    std::optional< ZInterval > values;
+    if (auto* call_inliner = knight_ctx.get_call_inliner()) {
+        // The callee is analyzed with the same analyses, this one included.
+        auto* ctx = m_ctx;
+        values = call_inliner->inline_call(call_expr, *ctx);
+        m_ctx = ctx;
+    }
+    if (!values) {
+        if (const auto* summary_mgr = knight_ctx.get_summary_manager()) {
+            if (const auto* summary = summary_mgr->get_summary(callee)) {
+                values = summary->return_values;
+            }
+        }
+    }
+    if (!values || values->is_top()) {
+        return;
+    }
+
+    knight_log_nl(llvm::outs() << "apply the return values of callee `"
+                               << callee->getQualifiedNameAsString()
+                               << "`: " << *values << "\n");
+
+    auto state = m_ctx->get_state();
+    const auto* frame = m_ctx->get_current_stack_frame();
+    if (auto value = values->get_singleton_opt()) {
+        const auto* scalar =
+            m_ctx->get_symbol_manager().get_scalar_int(*value, type);
+        m_ctx->set_state(state->set_stmt_sexpr(call_expr, frame, scalar));
+        return;
+    }
+
+    SExprRef call_sexpr = state->get_stmt_sexpr_or_conjured(
+        call_expr, m_ctx->get_current_location_context());
+    state = state->set_stmt_sexpr(call_expr, frame, call_sexpr);
+    if (auto zvar = call_sexpr->get_as_zvariable()) {
+        std::vector< ZLinearConstraint > constraints;
+        if (values->get_lb().is_finite()) {
+            constraints.push_back(*zvar >= values->get_lb().get_num());
+        }
+        if (values->get_ub().is_finite()) {
+            constraints.push_back(*zvar <= values->get_ub().get_num());
+        }
+        state = state->assume_zlinear_constraints(constraints);
+    }
+    m_ctx->set_state(state);
+}
+
 } // namespace knight::analyzer
\ No newline at end of file
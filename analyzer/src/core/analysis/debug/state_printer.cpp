@@ -12,38 +12,150 @@
 //===------------------------------------------------------------------===//
 
 #include "analyzer/core/analysis/debug/state_printer.hpp"
+#include "analyzer/core/domain/domains.hpp"
+#include "analyzer/tooling/context.hpp"
 #include "common/util/log.hpp"
 
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/WithColor.h>
+
 namespace knight::analyzer {
 
-void StatePrinter::pre_analyze_stmt(const clang::Stmt* stmt,
-                                    AnalysisContext& ctx) const {
-    llvm::outs().changeColor(llvm::raw_ostream::Colors::BLUE);
-    llvm::outs() << "STATE-BEFORE(" << stmt->getStmtClassName() << "): ";
-    stmt->printPretty(llvm::outs(),
-                      nullptr,
-                      ctx.get_ast_context().getPrintingPolicy());
-    llvm::outs().resetColor();
-    llvm::outs() << "\n";
+namespace {
+
+constexpr unsigned StateDumpPathMaxLen = 256U;
 
-    ctx.get_state()->dump(llvm::outs());
+} // anonymous namespace
 
-    llvm::outs() << "\n";
+void StatePrinter::pre_analyze_stmt(const clang::Stmt* stmt,
+                                    AnalysisContext& ctx) const {
+    print(stmt, ctx, /*is_post=*/false);
 }
 
 void StatePrinter::post_analyze_stmt(const clang::Stmt* stmt,
                                      AnalysisContext& ctx) const {
-    llvm::outs().changeColor(llvm::raw_ostream::Colors::GREEN);
-    llvm::outs() << "STATE-AFTER(" << stmt->getStmtClassName() << "): ";
-    stmt->printPretty(llvm::outs(),
-                      nullptr,
-                      ctx.get_ast_context().getPrintingPolicy());
-    llvm::outs().resetColor();
-    llvm::outs() << "\n";
+    print(stmt, ctx, /*is_post=*/true);
+}
+
+void StatePrinter::print(const clang::Stmt* stmt,
+                         AnalysisContext& ctx,
+                         bool is_post) const {
+    auto* file = get_dump_file(ctx);
+    auto& os = file != nullptr ? *file : llvm::outs();
+    os.changeColor(is_post ? llvm::raw_ostream::Colors::GREEN
+                           : llvm::raw_ostream::Colors::BLUE);
+    os << (is_post ? "STATE-AFTER(" : "STATE-BEFORE(")
+       << stmt->getStmtClassName() << "): ";
+    stmt->printPretty(os, nullptr, ctx.get_ast_context().getPrintingPolicy());
+    os.resetColor();
+    os << "\n";
 
-    ctx.get_state()->dump(llvm::outs());
+    auto state = ctx.get_state();
+    if (file == nullptr) {
+        state->dump(os);
+        os << "\n";
+        return;
+    }
+
+    const auto* loc_ctx = ctx.get_current_location_context();
+    const auto* block = loc_ctx != nullptr ? loc_ctx->get_block() : nullptr;
+    if (m_previous == nullptr || block == nullptr ||
+        block != m_previous_block) {
+        state->dump(os);
+    } else if (m_previous == state) {
+        os << "Delta:{}";
+    } else {
+        print_delta(os, *state);
+    }
+    os << "\n";
+    m_previous = std::move(state);
+    m_previous_block = block;
+    // The state after the last element of the block is not kept, so that
+    // the states can be released and their arena reset past the function.
+    if (is_post && block != nullptr &&
+        loc_ctx->get_element_id() + 1 == static_cast< int >(block->size())) {
+        m_previous = nullptr;
+    }
+}
+
+llvm::raw_ostream* StatePrinter::get_dump_file(AnalysisContext& ctx) const {
+    const auto& dir =
+        ctx.get_knight_context().get_current_options().state_dump_dir;
+    if (dir.empty()) {
+        return nullptr;
+    }
+    // The states of the inlined callees go to the file of the caller.
+    const auto* frame = ctx.get_current_stack_frame();
+    while (!frame->is_top_frame()) {
+        frame = frame->get_parent();
+    }
+    const auto* function = frame->get_decl();
+    if (function == m_function) {
+        // Null if the file cannot be opened.
+        return m_os.get();
+    }
+
+    m_os.reset();
+    m_function = function;
+    m_previous = nullptr;
+    m_previous_block = nullptr;
+
+    std::string name = "function";
+    if (const auto* named = llvm::dyn_cast< clang::NamedDecl >(function)) {
+        name = named->getQualifiedNameAsString();
+    }
+    for (auto& c : name) {
+        if (!llvm::isAlnum(c)) {
+            c = '_';
+        }
+    }
+    llvm::SmallString< StateDumpPathMaxLen > path(dir);
+    llvm::sys::path::append(path,
+                            name + "-" + std::to_string(function->getID()) +
+                                ".states");
+
+    std::error_code err = llvm::sys::fs::create_directories(dir);
+    if (!err) {
+        // The functions analyzed again, e.g. by another TU, append to
+        // their file.
+        m_os = std::make_unique< llvm::raw_fd_ostream >(
+            path,
+            err,
+            llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text);
+    }
+    if (err) {
+        llvm::WithColor::warning() << "cannot open the state dump file `"
+                                   << path << "`: " << err.message()
+                                   << ", the states are printed on the "
+                                      "stdout\n";
+        m_os.reset();
+        return nullptr;
+    }
+    m_os->SetBufferSize(StateDumpBufferSize);
+    return m_os.get();
+}
 
-    llvm::outs() << "\n";
+void StatePrinter::print_delta(llvm::raw_ostream& os,
+                               const ProgramState& state) const {
+    const auto changes = state.get_changes(*m_previous);
+    os << "Delta:{";
+    for (const auto& id : changes.domains) {
+        if (&id != changes.domains.begin()) {
+            os << ", ";
+        }
+        os << get_domain_name_by_id(id);
+    }
+    for (const auto& change : changes.regions) {
+        os << "\n  " << change.region->to_string() << ": " << change.previous
+           << " -> " << change.value;
+    }
+    if (!changes.regions.empty()) {
+        os << "\n";
+    }
+    os << "}";
 }
 
-} // namespace knight::analyzer
\ No newline at end of file
+} // namespace knight::analyzer
@@ -19,6 +19,7 @@
 #include "analyzer/core/domain/domains.hpp"
 #include "analyzer/core/program_state.hpp"
 #include "analyzer/core/symbol_manager.hpp"
+#include "analyzer/tooling/time_report.hpp"
 #include "common/util/assert.hpp"
 
 #include "common/util/log.hpp"
@@ -99,17 +100,18 @@ std::vector< AnalysisID > get_subset_order(
 
 } // anonymous namespace
 
-AnalysisManager::AnalysisManager(KnightContext& ctx) : m_ctx(ctx) {
-    m_sym_mgr =
-        std::make_unique< analyzer::SymbolManager >(m_ctx.get_allocator());
+AnalysisManager::AnalysisManager(KnightContext& ctx, ArenaContextRef arenas)
+    : m_ctx(ctx),
+      m_arenas(arenas != nullptr ? std::move(arenas)
+                                 : std::make_shared< ArenaContext >()) {
+    m_sym_mgr = std::make_unique< analyzer::SymbolManager >(m_arenas->symbols);
     m_region_mgr =
-        std::make_unique< analyzer::RegionManager >(m_ctx.get_allocator());
+        std::make_unique< analyzer::RegionManager >(m_arenas->regions);
     m_state_mgr =
         std::make_unique< analyzer::ProgramStateManager >(*this,
                                                           *m_region_mgr,
                                                           *m_sym_mgr,
-                                                          m_ctx
-                                                              .get_allocator());
+                                                          m_arenas->states);
 }
 
 bool AnalysisManager::is_analysis_required(AnalysisID id) const {
@@ -118,6 +120,7 @@ bool AnalysisManager::is_analysis_required(AnalysisID id) const {
 
 void AnalysisManager::add_required_analysis(AnalysisID id) {
     m_required_analyses.insert(id);
+    m_stmt_dispatch_table.clear();
 }
 
 void AnalysisManager::add_analysis_dependency(AnalysisID id,
@@ -173,6 +176,7 @@ void AnalysisManager::compute_full_order_analyses_after_registry() {
     m_analysis_full_order = compute_topological_order(m_analysis_dependencies,
                                                       m_analyses,
                                                       m_privileged_analysis);
+    m_stmt_dispatch_table.clear();
 }
 
 void AnalysisManager::enable_analysis(
@@ -218,6 +222,7 @@ void AnalysisManager::register_for_stmt(internal::AnalyzeStmtCallBack cb,
                                         internal::MatchStmtCallBack match_cb,
                                         internal::VisitStmtKind kind) {
     m_stmt_analyses.push_back({cb, match_cb, kind});
+    m_stmt_dispatch_table.clear();
 }
 
 void AnalysisManager::register_for_begin_function(
@@ -230,17 +235,28 @@ void AnalysisManager::register_for_end_function(
     m_end_function_analyses.emplace_back(cb);
 }
 
-void AnalysisManager::run_analyses_for_stmt(
-    AnalysisContext& analysis_ctx,
-    internal::StmtRef stmt,
-    internal::VisitStmtKind visit_kind) {
+const internal::StmtAnalysisCallBacks& AnalysisManager::get_stmt_analyses_for(
+    internal::StmtRef stmt, internal::VisitStmtKind visit_kind) {
+    if (m_stmt_dispatch_table.empty()) {
+        m_stmt_dispatch_table.resize(internal::NumVisitStmtKinds *
+                                     internal::NumStmtClasses);
+    }
+    auto& entry =
+        m_stmt_dispatch_table[(static_cast< std::size_t >(visit_kind) *
+                               internal::NumStmtClasses) +
+                              static_cast< std::size_t >(stmt->getStmtClass())];
+    if (entry.has_value()) {
+        return *entry;
+    }
+
     AnalysisIDSet tgt_ids;
-    std::unordered_map< AnalysisID, internal::AnalyzeStmtCallBack* > callbacks;
-    for (auto& info : m_stmt_analyses) {
+    std::unordered_map< AnalysisID, const internal::AnalyzeStmtCallBack* >
+        callbacks;
+    for (const auto& info : m_stmt_analyses) {
         if (info.kind != visit_kind || !info.match_cb(stmt)) {
             continue;
         }
-        auto& callback = info.anz_cb;
+        const auto& callback = info.anz_cb;
         auto id = callback.get_id();
         if (is_analysis_required(id)) {
             tgt_ids.insert(id);
@@ -248,8 +264,31 @@ void AnalysisManager::run_analyses_for_stmt(
         }
     }
 
+    auto& ordered_callbacks = entry.emplace();
     for (auto id : get_subset_order(m_analysis_full_order, tgt_ids)) {
-        (*callbacks[id])(stmt, analysis_ctx);
+        ordered_callbacks.push_back(callbacks[id]);
+    }
+    return ordered_callbacks;
+}
+
+void AnalysisManager::run_analyses_for_stmt(
+    AnalysisContext& analysis_ctx,
+    internal::StmtRef stmt,
+    internal::VisitStmtKind visit_kind) {
+    run_stmt_callbacks(analysis_ctx,
+                       stmt,
+                       get_stmt_analyses_for(stmt, visit_kind));
+}
+
+void AnalysisManager::run_stmt_callbacks(
+    AnalysisContext& analysis_ctx,
+    internal::StmtRef stmt,
+    llvm::ArrayRef< const internal::AnalyzeStmtCallBack* > callbacks) {
+    for (const auto* callback : callbacks) {
+        const TimeReport::Scope scope(TimeReportKind::Analysis,
+                                      get_analysis_name_by_id(
+                                          callback->get_id()));
+        (*callback)(stmt, analysis_ctx);
     }
 }
 
@@ -279,6 +318,8 @@ void AnalysisManager::run_analyses_for_begin_function(
         }
     }
     for (auto id : get_subset_order(m_analysis_full_order, tgt_ids)) {
+        const TimeReport::Scope scope(TimeReportKind::Analysis,
+                                      get_analysis_name_by_id(id));
         (*callbacks[id])(analysis_ctx);
     }
 }
@@ -295,6 +336,8 @@ void AnalysisManager::run_analyses_for_end_function(
         }
     }
     for (auto id : get_subset_order(m_analysis_full_order, tgt_ids)) {
+        const TimeReport::Scope scope(TimeReportKind::Analysis,
+                                      get_analysis_name_by_id(id));
         (*callbacks[id])(node, analysis_ctx);
     }
 }
@@ -306,6 +349,8 @@ void AnalysisManager::run_analyses_for_condition_filter(
     for (auto& cb : m_condition_filters) {
         auto id = cb.get_id();
         if (is_analysis_required(id)) {
+            const TimeReport::Scope scope(TimeReportKind::Analysis,
+                                          get_analysis_name_by_id(id));
             cb(expr, assertion_result, analysis_ctx);
         }
     }
@@ -37,6 +37,8 @@ void InspectionChecker::post_check_stmt(const clang::CallExpr* call_expr,
         dump_zval(call_expr->getArg(0), ctx);
     } else if (name == ReachabilityDumper) {
         dump_reachability(call_expr, ctx);
+    } else if (name == AliasDumper) {
+        dump_alias(call_expr, ctx);
     }
 }
 
@@ -48,53 +50,26 @@ void InspectionChecker::dump_zval(const clang::Expr* expr,
     auto state = ctx.get_state();
     knight_log_nl(llvm::outs() << "state: "; state->dump(llvm::outs()));
 
-    if (expr == nullptr || !expr->getType()->isIntegralOrEnumerationType()) {
+    if (expr == nullptr || !expr->getType()->isIntegralOrEnumerationType() ||
+        !state->get_zdom_ref()) {
         return;
     }
-    auto zdom = state->get_zdom_ref();
-    if (!zdom) {
-        return;
-    }
-    if (zdom.value()->is_bottom()) {
-        diagnose(expr->getExprLoc(), "⊥");
-        return;
-    }
-
-    auto sexpr = state->get_stmt_sexpr(expr, ctx.get_current_stack_frame());
-    if (!sexpr) {
-        if (auto reg = state->get_region(expr, ctx.get_current_stack_frame())) {
-            sexpr = state->get_region_def(*reg, ctx.get_current_stack_frame());
-        }
-        if (!sexpr) {
-            diagnose(expr->getExprLoc(), "T");
-            return;
-        }
-    }
 
-    knight_log_nl(llvm::outs() << "sexpr: "; sexpr.value()->dump(llvm::outs());
-                  llvm::outs() << "\n";);
-
-    if (auto znum = sexpr.value()->get_as_znum()) {
-        knight_log(llvm::outs() << "return znum: " << *znum << "\n";);
+    auto zitv = ctx.get_zinterval(expr);
+    if (!zitv) {
+        diagnose(expr->getExprLoc(), "T");
         return;
     }
-
-    auto zvar = sexpr.value()->get_as_zvariable();
-    if (!zvar) {
+    if (zitv->is_bottom()) {
+        diagnose(expr->getExprLoc(), "⊥");
         return;
     }
 
-    knight_log_nl(llvm::outs() << "zvar: " << *zvar << "\n";);
-
-    auto zitv = zdom.value()->to_interval(*zvar);
-    knight_log_nl(llvm::outs() << "zdom: "; zdom.value()->dump(llvm::outs());
-                  llvm::outs() << "\n";
-                  llvm::outs() << "zitv: ";
-                  zitv.dump(llvm::outs());
+    knight_log_nl(llvm::outs() << "zitv: "; zitv->dump(llvm::outs());
                   llvm::outs() << "\n";);
     llvm::SmallString< ZValStrMaxLen > zval_str;
     llvm::raw_svector_ostream os(zval_str);
-    zitv.dump(os);
+    zitv->dump(os);
     if (!zval_str.empty()) {
         diagnose(expr->getExprLoc(), zval_str);
     }
@@ -113,4 +88,34 @@ void InspectionChecker::dump_reachability(const clang::CallExpr* call_expr,
              state->is_bottom() ? "Unreachable" : "Reachable");
 }
 
+void InspectionChecker::dump_alias(const clang::CallExpr* call_expr,
+                                   CheckerContext& ctx) const {
+    if (call_expr->getNumArgs() != 2U) {
+        return;
+    }
+    auto get_var = [](const clang::Expr* arg) -> const clang::VarDecl* {
+        const auto* ref =
+            llvm::dyn_cast< clang::DeclRefExpr >(arg->IgnoreParenImpCasts());
+        if (ref == nullptr) {
+            return nullptr;
+        }
+        return llvm::dyn_cast< clang::VarDecl >(ref->getDecl());
+    };
+    const auto* p = get_var(call_expr->getArg(0));
+    const auto* q = get_var(call_expr->getArg(1));
+    if (p == nullptr || q == nullptr) {
+        return;
+    }
+    knight_log_nl(llvm::outs() << "dump alias: " << p->getName() << ", "
+                               << q->getName() << "\n";);
+
+    diagnose(call_expr->getExprLoc(),
+             PointerAnalysis::may_alias(ctx.get_knight_context(),
+                                        ctx.get_current_stack_frame(),
+                                        p,
+                                        q)
+                 ? "MayAlias"
+                 : "NoAlias");
+}
+
 } // namespace knight::analyzer
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include "analyzer/core/checker_context.hpp"
 #include "analyzer/core/stack_frame.hpp"
 #include "analyzer/tooling/context.hpp"
+#include "analyzer/tooling/stats.hpp"
 
 namespace knight::analyzer {
 
@@ -34,7 +35,83 @@ const StackFrame* CheckerContext::get_current_stack_frame() const {
 }
 
 void CheckerContext::set_current_stack_frame(const StackFrame* frame) {
+    if (frame != m_frame) {
+        clear_query_cache();
+    }
     m_frame = frame;
 }
 
+std::optional< ZInterval > CheckerContext::get_zinterval(
+    const clang::Expr* expr) {
+    Stats::count(StatKind::CheckerQueries);
+    if (auto it = m_zinterval_cache.find(expr);
+        it != m_zinterval_cache.end()) {
+        Stats::count(StatKind::CheckerQueryCacheHits);
+        return it->second;
+    }
+    auto zinterval = compute_zinterval(expr);
+    m_zinterval_cache.try_emplace(expr, zinterval);
+    return zinterval;
+}
+
+std::optional< PointToSet > CheckerContext::get_point_to_set(
+    const clang::Expr* expr) {
+    Stats::count(StatKind::CheckerQueries);
+    if (auto it = m_point_to_cache.find(expr); it != m_point_to_cache.end()) {
+        Stats::count(StatKind::CheckerQueryCacheHits);
+        return it->second;
+    }
+    auto point_to = compute_point_to_set(expr);
+    m_point_to_cache.try_emplace(expr, point_to);
+    return point_to;
+}
+
+std::optional< ZInterval > CheckerContext::compute_zinterval(
+    const clang::Expr* expr) const {
+    if (m_state == nullptr || expr == nullptr ||
+        !expr->getType()->isIntegralOrEnumerationType()) {
+        return std::nullopt;
+    }
+    auto zdom = m_state->get_zdom_ref();
+    if (!zdom) {
+        return std::nullopt;
+    }
+    if ((*zdom)->is_bottom()) {
+        return ZInterval::bottom();
+    }
+    auto sexpr = m_state->get_stmt_sexpr(expr, m_frame);
+    if (!sexpr) {
+        if (auto region = m_state->get_region(expr, m_frame)) {
+            sexpr = m_state->get_region_def(*region, m_frame);
+        }
+        if (!sexpr) {
+            return std::nullopt;
+        }
+    }
+    if (auto znum = (*sexpr)->get_as_znum()) {
+        return ZInterval(*znum);
+    }
+    if (auto zvar = (*sexpr)->get_as_zvariable()) {
+        return (*zdom)->to_interval(*zvar);
+    }
+    return std::nullopt;
+}
+
+std::optional< PointToSet > CheckerContext::compute_point_to_set(
+    const clang::Expr* expr) const {
+    if (m_state == nullptr || expr == nullptr ||
+        !expr->getType()->isPointerType()) {
+        return std::nullopt;
+    }
+    auto pointer_dom = m_state->get_pointer_dom_ref();
+    if (!pointer_dom) {
+        return std::nullopt;
+    }
+    auto region = m_state->get_region(expr->IgnoreParenImpCasts(), m_frame);
+    if (!region) {
+        return std::nullopt;
+    }
+    return (*pointer_dom)->get_region_point_to().get_value(*region);
+}
+
 } // namespace knight::analyzer
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include "analyzer/core/analysis/analysis_base.hpp"
 #include "analyzer/core/checker/checker_base.hpp"
 #include "analyzer/core/checker/checkers.hpp"
+#include "analyzer/tooling/time_report.hpp"
 #include "common/util/assert.hpp"
 #include "common/util/log.hpp"
 
@@ -27,6 +28,7 @@ namespace knight::analyzer {
 
 void CheckerManager::add_required_checker(CheckerID id) {
     m_required_checkers.emplace(id);
+    m_stmt_dispatch_table.clear();
 }
 
 bool CheckerManager::is_checker_required(CheckerID id) const {
@@ -50,6 +52,7 @@ void CheckerManager::register_for_stmt(internal::CheckStmtCallBack cb,
                                        internal::MatchStmtCallBack match_fn,
                                        internal::CheckStmtKind kind) {
     m_stmt_checks.push_back({cb, match_fn, kind});
+    m_stmt_dispatch_table.clear();
 }
 
 void CheckerManager::register_for_begin_function(
@@ -62,19 +65,42 @@ void CheckerManager::register_for_end_function(
     m_end_function_checks.emplace_back(cb);
 }
 
-void CheckerManager::run_checkers_for_stmt(CheckerContext& checker_ctx,
-                                           internal::StmtRef stmt,
-                                           internal::CheckStmtKind check_kind) {
-    for (auto& info : m_stmt_checks) {
+const internal::StmtCheckCallBacks& CheckerManager::get_stmt_checks_for(
+    internal::StmtRef stmt, internal::CheckStmtKind check_kind) {
+    if (m_stmt_dispatch_table.empty()) {
+        m_stmt_dispatch_table.resize(internal::NumCheckStmtKinds *
+                                     internal::NumStmtClasses);
+    }
+    auto& entry =
+        m_stmt_dispatch_table[(static_cast< std::size_t >(check_kind) *
+                               internal::NumStmtClasses) +
+                              static_cast< std::size_t >(stmt->getStmtClass())];
+    if (entry.has_value()) {
+        return *entry;
+    }
+
+    auto& callbacks = entry.emplace();
+    for (const auto& info : m_stmt_checks) {
         if (info.kind != check_kind || !info.match_cb(stmt)) {
             continue;
         }
-        auto& callback = info.anz_cb;
-        auto id = callback.get_id();
-        if (is_checker_required(id)) {
-            callback(stmt, checker_ctx);
+        if (is_checker_required(info.anz_cb.get_id())) {
+            callbacks.push_back(&info.anz_cb);
         }
     }
+    return callbacks;
+}
+
+void CheckerManager::run_checkers_for_stmt(CheckerContext& checker_ctx,
+                                           internal::StmtRef stmt,
+                                           internal::CheckStmtKind check_kind) {
+    checker_ctx.clear_query_cache();
+    for (const auto* callback : get_stmt_checks_for(stmt, check_kind)) {
+        const TimeReport::Scope scope(TimeReportKind::Checker,
+                                      get_checker_name_by_id(
+                                          callback->get_id()));
+        (*callback)(stmt, checker_ctx);
+    }
 }
 
 void CheckerManager::run_checkers_for_pre_stmt(CheckerContext& checker_ctx,
@@ -89,9 +115,12 @@ void CheckerManager::run_checkers_for_post_stmt(CheckerContext& checker_ctx,
 
 void CheckerManager::run_checkers_for_begin_function(
     CheckerContext& checker_ctx) {
+    checker_ctx.clear_query_cache();
     for (auto& callback : m_begin_function_checks) {
         auto id = callback.get_id();
         if (is_checker_required(id)) {
+            const TimeReport::Scope scope(TimeReportKind::Checker,
+                                          get_checker_name_by_id(id));
             callback(checker_ctx);
         }
     }
@@ -99,9 +128,12 @@ void CheckerManager::run_checkers_for_begin_function(
 
 void CheckerManager::run_checkers_for_end_function(CheckerContext& checker_ctx,
                                                    ProcCFG::NodeRef node) {
+    checker_ctx.clear_query_cache();
     for (auto& callback : m_end_function_checks) {
         auto id = callback.get_id();
         if (is_checker_required(id)) {
+            const TimeReport::Scope scope(TimeReportKind::Checker,
+                                          get_checker_name_by_id(id));
             callback(node, checker_ctx);
         }
     }
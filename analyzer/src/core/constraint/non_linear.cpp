@@ -0,0 +1,256 @@
+//===- non_linear.cpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the feasibility checking of the non-linear
+//  constraints.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/constraint/non_linear.hpp"
+#include "analyzer/core/symbol.hpp"
+#include "analyzer/tooling/stats.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/STLExtras.h>
+
+namespace knight::analyzer {
+
+namespace {
+
+/// \brief The interval propagation of the constraints over the intervals
+/// of the symbols.
+class Propagator {
+  private:
+    NonLinearSolver::Env& m_env;
+    bool m_is_changed = false;
+
+  public:
+    explicit Propagator(NonLinearSolver::Env& env) : m_env(env) {}
+
+    /// \brief Narrow the intervals by the constraints until none narrows.
+    ///
+    /// \return false if the constraints cannot hold.
+    [[nodiscard]] bool propagate(llvm::ArrayRef< SExprRef > constraints) {
+        for (unsigned round = 0U; round < MaxNonLinearPropagationRounds;
+             ++round) {
+            m_is_changed = false;
+            for (const auto* constraint : constraints) {
+                if (!apply(constraint)) {
+                    return false;
+                }
+            }
+            if (!m_is_changed) {
+                break;
+            }
+        }
+        return true;
+    }
+
+  private:
+    [[nodiscard]] ZInterval evaluate(SExprRef sexpr) const {
+        if (const auto* scalar = llvm::dyn_cast< ScalarInt >(sexpr)) {
+            return ZInterval(scalar->get_value());
+        }
+        if (const auto* sym = llvm::dyn_cast< Sym >(sexpr)) {
+            auto it = m_env.find(sym);
+            return it != m_env.end() ? it->second : ZInterval::top();
+        }
+        const auto* binary = llvm::dyn_cast< BinarySymExpr >(sexpr);
+        if (binary == nullptr ||
+            !binary->get_type()->isIntegralOrEnumerationType()) {
+            return ZInterval::top();
+        }
+        if (clang::BinaryOperator::isComparisonOp(binary->get_opcode())) {
+            return ZInterval::unknown_bool();
+        }
+        auto lhs = evaluate(binary->get_lhs());
+        auto rhs = evaluate(binary->get_rhs());
+        switch (binary->get_opcode()) {
+            case clang::BO_Add:
+                return lhs + rhs;
+            case clang::BO_Sub:
+                return lhs - rhs;
+            case clang::BO_Mul:
+                return lhs * rhs;
+            case clang::BO_Div:
+                return lhs / rhs;
+            case clang::BO_Rem:
+                return lhs % rhs;
+            default:
+                return ZInterval::top();
+        }
+    }
+
+    /// \brief Narrow the intervals of the symbols of `sexpr` so that its
+    /// value may be in `itv`.
+    ///
+    /// \return false if its value cannot be in `itv`.
+    [[nodiscard]] bool refine(SExprRef sexpr, const ZInterval& itv) {
+        if (itv.is_bottom()) {
+            return false;
+        }
+        if (const auto* sym = llvm::dyn_cast< Sym >(sexpr)) {
+            auto [it, inserted] = m_env.try_emplace(sym, ZInterval::top());
+            auto narrowed = it->second;
+            narrowed.meet_with(itv);
+            if (!narrowed.equals(it->second)) {
+                it->second = narrowed;
+                m_is_changed = true;
+            }
+            return !narrowed.is_bottom();
+        }
+        const auto* binary = llvm::dyn_cast< BinarySymExpr >(sexpr);
+        if (binary != nullptr &&
+            binary->get_type()->isIntegralOrEnumerationType()) {
+            auto lhs = evaluate(binary->get_lhs());
+            auto rhs = evaluate(binary->get_rhs());
+            // Only the additions are inverted, the other operations are
+            // checked forward.
+            switch (binary->get_opcode()) {
+                case clang::BO_Add:
+                    return refine(binary->get_lhs(), itv - rhs) &&
+                           refine(binary->get_rhs(), itv - lhs);
+                case clang::BO_Sub:
+                    return refine(binary->get_lhs(), itv + rhs) &&
+                           refine(binary->get_rhs(), lhs - itv);
+                default:
+                    break;
+            }
+        }
+        auto value = evaluate(sexpr);
+        value.meet_with(itv);
+        return !value.is_bottom();
+    }
+
+    /// \brief Narrow the intervals by the comparison.
+    [[nodiscard]] bool apply(SExprRef constraint) {
+        const auto* binary = llvm::dyn_cast< BinarySymExpr >(constraint);
+        if (binary == nullptr ||
+            !clang::BinaryOperator::isComparisonOp(binary->get_opcode())) {
+            return true;
+        }
+        const auto* lhs_sexpr = binary->get_lhs();
+        const auto* rhs_sexpr = binary->get_rhs();
+        auto lhs = evaluate(lhs_sexpr);
+        auto rhs = evaluate(rhs_sexpr);
+        // An undefined operation, e.g. a division by zero, assumes nothing.
+        if (lhs.is_bottom() || rhs.is_bottom()) {
+            return true;
+        }
+        const ZBound one(ZNum(1));
+        switch (binary->get_opcode()) {
+            case clang::BO_LT:
+                return refine(lhs_sexpr,
+                              ZInterval(ZBound::ninf(), rhs.get_ub() - one)) &&
+                       refine(rhs_sexpr,
+                              ZInterval(lhs.get_lb() + one, ZBound::pinf()));
+            case clang::BO_LE:
+                return refine(lhs_sexpr,
+                              ZInterval(ZBound::ninf(), rhs.get_ub())) &&
+                       refine(rhs_sexpr,
+                              ZInterval(lhs.get_lb(), ZBound::pinf()));
+            case clang::BO_GT:
+                return refine(lhs_sexpr,
+                              ZInterval(rhs.get_lb() + one, ZBound::pinf())) &&
+                       refine(rhs_sexpr,
+                              ZInterval(ZBound::ninf(), lhs.get_ub() - one));
+            case clang::BO_GE:
+                return refine(lhs_sexpr,
+                              ZInterval(rhs.get_lb(), ZBound::pinf())) &&
+                       refine(rhs_sexpr,
+                              ZInterval(ZBound::ninf(), lhs.get_ub()));
+            case clang::BO_EQ:
+                return refine(lhs_sexpr, rhs) && refine(rhs_sexpr, lhs);
+            case clang::BO_NE:
+                if (auto value = rhs.get_singleton_opt()) {
+                    if (!refine(lhs_sexpr, trim_bound(lhs, ZBound(*value)))) {
+                        return false;
+                    }
+                }
+                if (auto value = lhs.get_singleton_opt()) {
+                    return refine(rhs_sexpr, trim_bound(rhs, ZBound(*value)));
+                }
+                return true;
+            default:
+                return true;
+        }
+    }
+}; // class Propagator
+
+} // anonymous namespace
+
+bool NonLinearSolver::is_feasible(
+    const ConstraintSystem::NonLinearConstraintSet& constraints) {
+    return solve({constraints.begin(), constraints.end()});
+}
+
+bool NonLinearSolver::is_feasible(
+    const ConstraintSystem::NonLinearConstraintSet& constraints,
+    SExprRef constraint) {
+    std::vector< SExprRef > all_constraints(constraints.begin(),
+                                            constraints.end());
+    all_constraints.push_back(constraint);
+    return solve(std::move(all_constraints));
+}
+
+void NonLinearSolver::push(SExprRef constraint) {
+    Scope scope{constraint,
+                m_scopes.empty() ? Env{} : m_scopes.back().env,
+                check()};
+    if (scope.is_feasible) {
+        std::vector< SExprRef > constraints;
+        constraints.reserve(m_scopes.size() + 1U);
+        for (const auto& prefix : m_scopes) {
+            constraints.push_back(prefix.constraint);
+        }
+        constraints.push_back(constraint);
+        scope.is_feasible = Propagator(scope.env).propagate(constraints);
+    }
+    m_scopes.push_back(std::move(scope));
+}
+
+bool NonLinearSolver::solve(std::vector< SExprRef > constraints) {
+    if (constraints.empty()) {
+        return true;
+    }
+    llvm::sort(constraints, [](SExprRef lhs, SExprRef rhs) {
+        return lhs->get_dense_id() < rhs->get_dense_id();
+    });
+    constraints.erase(std::unique(constraints.begin(), constraints.end()),
+                      constraints.end());
+
+    Stats::count(StatKind::NonLinearQueries);
+    std::vector< DenseID > key;
+    key.reserve(constraints.size());
+    for (const auto* constraint : constraints) {
+        key.push_back(constraint->get_dense_id());
+    }
+    auto [it, inserted] = m_cache.try_emplace(std::move(key), true);
+    if (!inserted) {
+        Stats::count(StatKind::NonLinearCacheHits);
+        return it->second;
+    }
+
+    // Keep the scopes of the common prefix of the last query.
+    std::size_t prefix = 0U;
+    while (prefix < m_scopes.size() && prefix < constraints.size() &&
+           m_scopes[prefix].constraint == constraints[prefix]) {
+        ++prefix;
+    }
+    while (m_scopes.size() > prefix) {
+        pop();
+    }
+    for (auto idx = prefix; idx < constraints.size() && check(); ++idx) {
+        push(constraints[idx]);
+    }
+    it->second = check();
+    return it->second;
+}
+
+} // namespace knight::analyzer
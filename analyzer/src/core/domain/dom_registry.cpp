@@ -11,21 +11,11 @@
 //
 //===------------------------------------------------------------------===//
 
-#include "analyzer/core/domain/demo_dom.hpp"
-#include "analyzer/core/domain/numerical/interval_dom.hpp"
-#include "analyzer/core/domain/pointer.hpp"
+#include "analyzer/core/domain/registered_domains.hpp"
 
 namespace knight::analyzer {
 
-// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables,fuchsia-statically-constructed-objects)
-std::unordered_map< DomainKind, DomainDefaultValFn > DefaultValFns;
-std::unordered_map< DomainKind, DomainBottomValFn > BottomValFns;
-
-DomainRegistry< ZIntervalDom > A;
-DomainRegistry< DemoItvDom > B;
-DomainRegistry< DemoMapDomain > C;
-DomainRegistry< PointToSet > D;
-DomainRegistry< PointerInfo > E;
-// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables,fuchsia-statically-constructed-objects)
+extern constexpr DomainValFnTable DomainValFnsTable =
+    RegisteredDomains::make_val_fn_table();
 
 } // namespace knight::analyzer
\ No newline at end of file
@@ -0,0 +1,174 @@
+//===- machine_interval.cpp -------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the machine integer interval value domain
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/domain/machine_interval.hpp"
+
+#include <clang/AST/Decl.h>
+#include <clang/AST/Type.h>
+
+#include <climits>
+#include <cstdint>
+
+namespace knight::analyzer {
+
+namespace {
+
+constexpr unsigned MaxBitWidth = 64U;
+
+template < typename T >
+constexpr unsigned bit_width_of() {
+    return static_cast< unsigned >(sizeof(T) * CHAR_BIT);
+}
+
+} // anonymous namespace
+
+std::optional< MachineIntType > get_machine_int_type(clang::QualType type) {
+    if (type.isNull()) {
+        return std::nullopt;
+    }
+    type = type.getCanonicalType();
+    if (const auto* enum_type = type->getAs< clang::EnumType >()) {
+        type = enum_type->getDecl()->getIntegerType();
+        if (type.isNull()) {
+            return std::nullopt;
+        }
+        type = type.getCanonicalType();
+    }
+    const auto* builtin = type->getAs< clang::BuiltinType >();
+    if (builtin == nullptr) {
+        return std::nullopt;
+    }
+    Signedness sign = builtin->isUnsignedInteger() ? Unsigned : Signed;
+    switch (builtin->getKind()) {
+        case clang::BuiltinType::Char_S:
+        case clang::BuiltinType::Char_U:
+        case clang::BuiltinType::SChar:
+        case clang::BuiltinType::UChar:
+        case clang::BuiltinType::Char8:
+            return MachineIntType{bit_width_of< char >(), sign};
+        case clang::BuiltinType::Short:
+        case clang::BuiltinType::UShort:
+        case clang::BuiltinType::Char16:
+            return MachineIntType{bit_width_of< int16_t >(), sign};
+        case clang::BuiltinType::Int:
+        case clang::BuiltinType::UInt:
+        case clang::BuiltinType::Char32:
+            return MachineIntType{bit_width_of< int32_t >(), sign};
+        case clang::BuiltinType::WChar_S:
+        case clang::BuiltinType::WChar_U:
+            return MachineIntType{bit_width_of< wchar_t >(), sign};
+        case clang::BuiltinType::Long:
+        case clang::BuiltinType::ULong:
+            return MachineIntType{bit_width_of< long >(), sign};
+        case clang::BuiltinType::LongLong:
+        case clang::BuiltinType::ULongLong:
+            return MachineIntType{bit_width_of< int64_t >(), sign};
+        default:
+            break;
+    }
+    return std::nullopt;
+}
+
+MachineInterval::BoundT MachineInterval::to_small(const ZBound& b) {
+    if (b.is_pinf()) {
+        return BoundT::pinf();
+    }
+    if (b.is_ninf()) {
+        return BoundT::ninf();
+    }
+    const ZNum& n = b.get_num();
+    if (n.fits< int64_t >()) {
+        // The sentinels are the infinities, the saturation of the bound.
+        return BoundT(n.to< int64_t >());
+    }
+    return n > 0 ? BoundT::pinf() : BoundT::ninf();
+}
+
+ZBound MachineInterval::to_z(const BoundT& b) {
+    if (b.is_pinf()) {
+        return ZBound::pinf();
+    }
+    if (b.is_ninf()) {
+        return ZBound::ninf();
+    }
+    return ZBound(ZNum(b.get_num()));
+}
+
+void MachineInterval::wrap(MachineIntType type) {
+    if (is_bottom()) {
+        return;
+    }
+    if (type.bit_width >= MaxBitWidth - 1U) {
+        // The native bounds cannot hold the range of the unsigned 64-bit
+        // integers, so only the negative values are wrapped away.
+        if (type.sign == Unsigned && m_lb < BoundT(0)) {
+            m_lb = BoundT(0);
+            m_ub = BoundT::pinf();
+        }
+        return;
+    }
+
+    const int64_t modulus = int64_t(1) << type.bit_width;
+    const int64_t type_min = type.sign == Signed ? -(modulus / 2) : 0;
+    const int64_t type_max = type_min + (modulus - 1);
+    const BoundT min(type_min);
+    const BoundT max(type_max);
+    if (m_lb >= min && m_ub <= max) {
+        return;
+    }
+    if (m_lb.is_inf() || m_ub.is_inf() || m_ub - m_lb >= BoundT(modulus)) {
+        m_lb = min;
+        m_ub = max;
+        return;
+    }
+
+    // The unsigned words wrap modulo 2^64, a multiple of the modulus, so
+    // the reduction is done on them without overflowing.
+    const int64_t width = (m_ub - m_lb).get_num();
+    const auto offset = static_cast< uint64_t >(m_lb.get_num()) -
+                        static_cast< uint64_t >(type_min);
+    const int64_t lb =
+        type_min +
+        static_cast< int64_t >(offset & static_cast< uint64_t >(modulus - 1));
+    if (lb + width > type_max) {
+        // The values wrap across the bounds of the range.
+        m_lb = min;
+        m_ub = max;
+        return;
+    }
+    m_lb = BoundT(lb);
+    m_ub = BoundT(lb + width);
+}
+
+void MachineInterval::cast(clang::QualType type, unsigned bit_width) {
+    if (is_bottom() || type.isNull()) {
+        return;
+    }
+    if (type->isBooleanType()) {
+        const BoundT zero(0);
+        if (m_lb == zero && m_ub == zero) {
+            return;
+        }
+        const bool has_zero = m_lb <= zero && m_ub >= zero;
+        m_lb = has_zero ? zero : BoundT(1);
+        m_ub = BoundT(1);
+        return;
+    }
+    auto int_type = get_machine_int_type(type);
+    if (!int_type) {
+        return;
+    }
+    wrap(MachineIntType{bit_width, int_type->sign});
+}
+
+} // namespace knight::analyzer
@@ -0,0 +1,187 @@
+//===- gmp_pool.cpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the pooled memory functions for GMP.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/domain/num/gmp_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <gmp.h>
+
+namespace knight::analyzer {
+
+namespace {
+
+/// \brief Size classes are the powers of two from 16 to 512 bytes.
+constexpr std::size_t MinClassShift = 4U;
+constexpr std::size_t NumSizeClasses = 6U;
+constexpr std::size_t MaxPooledSize = std::size_t{1U}
+                                      << (MinClassShift + NumSizeClasses - 1U);
+
+/// \brief Cap of the cached blocks per size class and thread.
+constexpr std::size_t MaxCachedBlocks = 256U;
+
+constexpr std::size_t NotPooled = NumSizeClasses;
+
+constexpr std::size_t get_size_class(std::size_t size) {
+    if (size > MaxPooledSize) {
+        return NotPooled;
+    }
+    constexpr std::size_t MinClassSize = std::size_t{1U} << MinClassShift;
+    return std::bit_width(std::max(size, MinClassSize) - 1U) - MinClassShift;
+}
+
+constexpr std::size_t get_class_size(std::size_t size_class) {
+    return std::size_t{1U} << (size_class + MinClassShift);
+}
+
+struct FreeBlock {
+    FreeBlock* next;
+}; // struct FreeBlock
+
+/// \brief Whether the pool of the current thread is alive.
+///
+/// GMP numbers may still be freed while the thread-local objects are
+/// destroyed, the blocks then go back to malloc directly.
+thread_local bool IsPoolAlive = false; // NOLINT
+
+/// \brief Thread-local free lists of the recycled blocks.
+///
+/// A block may be freed by another thread than the one which allocated
+/// it, it then joins the free list of the freeing thread.
+class BlockPool {
+  private:
+    struct FreeList {
+        FreeBlock* head = nullptr;
+        std::size_t size = 0U;
+    }; // struct FreeList
+
+    std::array< FreeList, NumSizeClasses > m_free_lists{};
+
+  public:
+    BlockPool() { IsPoolAlive = true; }
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+    BlockPool(BlockPool&&) = delete;
+    BlockPool& operator=(BlockPool&&) = delete;
+    ~BlockPool();
+
+    [[nodiscard]] void* allocate(std::size_t size_class) {
+        auto& list = m_free_lists[size_class]; // NOLINT
+        if (list.head == nullptr) {
+            return std::malloc(get_class_size(size_class)); // NOLINT
+        }
+        FreeBlock* block = list.head;
+        list.head = block->next;
+        --list.size;
+        return block;
+    }
+
+    void deallocate(void* ptr, std::size_t size_class) {
+        auto& list = m_free_lists[size_class]; // NOLINT
+        if (list.size >= MaxCachedBlocks) {
+            std::free(ptr); // NOLINT
+            return;
+        }
+        auto* block = static_cast< FreeBlock* >(ptr);
+        block->next = list.head;
+        list.head = block;
+        ++list.size;
+    }
+
+}; // class BlockPool
+
+BlockPool::~BlockPool() {
+    IsPoolAlive = false;
+    for (auto& list : m_free_lists) {
+        while (list.head != nullptr) {
+            FreeBlock* next = list.head->next;
+            std::free(list.head); // NOLINT
+            list.head = next;
+        }
+    }
+}
+
+BlockPool* get_pool() {
+    thread_local BlockPool Pool;
+    return IsPoolAlive ? &Pool : nullptr;
+}
+
+[[noreturn]] void report_out_of_memory() {
+    throw std::bad_alloc();
+}
+
+void* pooled_allocate(std::size_t size) {
+    const std::size_t size_class = get_size_class(size);
+    void* ptr = nullptr;
+    if (size_class == NotPooled) {
+        ptr = std::malloc(size); // NOLINT
+    } else if (auto* pool = get_pool()) {
+        ptr = pool->allocate(size_class);
+    } else {
+        ptr = std::malloc(get_class_size(size_class)); // NOLINT
+    }
+    if (ptr == nullptr) {
+        report_out_of_memory();
+    }
+    return ptr;
+}
+
+void pooled_free(void* ptr, std::size_t size) {
+    const std::size_t size_class = get_size_class(size);
+    if (size_class == NotPooled) {
+        std::free(ptr); // NOLINT
+    } else if (auto* pool = get_pool()) {
+        pool->deallocate(ptr, size_class);
+    } else {
+        std::free(ptr); // NOLINT
+    }
+}
+
+void* pooled_reallocate(void* ptr, std::size_t old_size, std::size_t new_size) {
+    const std::size_t old_class = get_size_class(old_size);
+    const std::size_t new_class = get_size_class(new_size);
+    if (old_class == NotPooled && new_class == NotPooled) {
+        void* res = std::realloc(ptr, new_size); // NOLINT
+        if (res == nullptr) {
+            report_out_of_memory();
+        }
+        return res;
+    }
+    if (old_class == new_class) {
+        return ptr;
+    }
+    void* res = pooled_allocate(new_size);
+    std::memcpy(res, ptr, std::min(old_size, new_size));
+    pooled_free(ptr, old_size);
+    return res;
+}
+
+} // anonymous namespace
+
+void install_gmp_pool() {
+    static std::once_flag Flag;
+    std::call_once(Flag, [] {
+        mp_set_memory_functions(pooled_allocate,
+                                pooled_reallocate,
+                                pooled_free);
+    });
+}
+
+} // namespace knight::analyzer
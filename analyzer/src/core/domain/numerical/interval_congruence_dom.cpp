@@ -0,0 +1,132 @@
+//===- interval_congruence_dom.cpp ------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the interval and congruence reduced product domain
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/domain/numerical/interval_congruence_dom.hpp"
+#include "analyzer/core/domain/numerical/interval_dom.hpp"
+
+namespace knight::analyzer {
+
+namespace {
+
+using Solver = impl::IntervalSolver< ZNum, ZIntervalCongruenceDom >;
+
+} // anonymous namespace
+
+void ZIntervalCongruenceDom::refine_congruences(const LinearConstraintT& cst) {
+    for (const auto& [pivot, coeff] : cst.get_variable_terms()) {
+        // coeff * pivot = constant - sum of the other terms
+        ZCongruence rhs(cst.get_constant_term());
+        for (const auto& [var, other_coeff] : cst.get_variable_terms()) {
+            if (!var.equals(pivot)) {
+                rhs -= ZCongruence(other_coeff) *
+                       m_sep_dom.get_value(var).get_congruence();
+            }
+        }
+        rhs = rhs / ZCongruence(coeff);
+        if (rhs.is_top()) {
+            continue;
+        }
+        m_sep_dom.meet_value(pivot, ZIntervalCongruence(ZInterval::top(), rhs));
+        if (m_sep_dom.is_bottom()) {
+            return;
+        }
+    }
+}
+
+void ZIntervalCongruenceDom::assign_comparison(const Var& x,
+                                               const LinearConstraintT& cst) {
+    ZIntervalCongruenceDom dom_pos = *this;
+    ZIntervalCongruenceDom dom_neg = *this;
+    dom_pos.apply_linear_constraint(cst);
+    dom_neg.apply_linear_constraint(cst.negate());
+    // Whether a branch is feasible is a query, reduce the values.
+    dom_pos.normalize();
+    dom_neg.normalize();
+    if (dom_pos.is_bottom() && !dom_neg.is_bottom()) {
+        this->set_value(x, ZIntervalCongruence(ZInterval::false_val()));
+    } else if (!dom_pos.is_bottom() && dom_neg.is_bottom()) {
+        this->set_value(x, ZIntervalCongruence(ZInterval::true_val()));
+    } else {
+        this->set_value(x, ZIntervalCongruence(ZInterval::unknown_bool()));
+    }
+}
+
+void ZIntervalCongruenceDom::assign_binary_var_var(
+    clang::BinaryOperatorKind op, const Var& x, const Var& y, const Var& z) {
+    knight_assert(!clang::BinaryOperator::isAssignmentOp(op));
+    if (clang::BinaryOperator::isComparisonOp(op)) {
+        assign_comparison(x, Base::construct_constraint(op, y, z));
+        return;
+    }
+    m_sep_dom.assign_binary_var_var_for_non_assign_rel_op(op, x, y, z);
+}
+
+void ZIntervalCongruenceDom::assign_binary_var_num(
+    clang::BinaryOperatorKind op, const Var& x, const Var& y, const ZNum& z) {
+    knight_assert(!clang::BinaryOperator::isAssignmentOp(op));
+    if (clang::BinaryOperator::isComparisonOp(op)) {
+        assign_comparison(x, Base::construct_constraint(op, y, z));
+        return;
+    }
+    m_sep_dom.assign_binary_var_num_for_non_assign_rel_op(op, x, y, z);
+}
+
+void ZIntervalCongruenceDom::apply_linear_constraint(
+    const LinearConstraintT& cst) {
+    Solver solver;
+    solver.add(cst);
+    solver.run(*this);
+    if (!is_bottom() && cst.is_equality()) {
+        refine_congruences(cst);
+    }
+}
+
+void ZIntervalCongruenceDom::merge_with_linear_constraint_system(
+    const LinearConstraintSystemT& csts) {
+    Solver solver;
+    solver.add(csts);
+    solver.run(*this);
+    for (const LinearConstraintT& cst : csts.get_linear_constraints()) {
+        if (is_bottom()) {
+            return;
+        }
+        if (cst.is_equality()) {
+            refine_congruences(cst);
+        }
+    }
+}
+
+ZIntervalCongruenceDom::LinearConstraintSystemT ZIntervalCongruenceDom::
+    to_linear_constraint_system() const {
+    if (m_sep_dom.is_bottom()) {
+        return LinearConstraintSystemT(LinearConstraintT::contradiction());
+    }
+
+    LinearConstraintSystemT csts;
+    for (const auto& [var, value] : m_sep_dom.get_table()) {
+        ZInterval itv = value.reduced().get_interval();
+        if (itv.is_bottom()) {
+            csts.add_linear_constraint(LinearConstraintT::contradiction());
+            continue;
+        }
+        if (auto lb = itv.get_lb().get_num_opt()) {
+            csts.add_linear_constraint(LinearExprT(var) >= *lb);
+        }
+        if (auto ub = itv.get_ub().get_num_opt()) {
+            csts.add_linear_constraint(LinearExprT(var) <= *ub);
+        }
+    }
+    return csts;
+}
+
+} // namespace knight::analyzer
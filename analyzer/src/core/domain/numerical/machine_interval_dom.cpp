@@ -0,0 +1,115 @@
+//===- machine_interval_dom.cpp ---------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the machine integer interval domain
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/domain/numerical/machine_interval_dom.hpp"
+#include "analyzer/core/domain/numerical/interval_dom.hpp"
+#include "analyzer/core/symbol.hpp"
+
+namespace knight::analyzer {
+
+namespace {
+
+using Solver = impl::IntervalSolver< ZNum, MachineIntervalDom >;
+
+} // anonymous namespace
+
+void MachineIntervalDom::wrap_to_type(const Var& x) {
+    if (m_sep_dom.is_bottom() || x.m_symbol == nullptr) {
+        return;
+    }
+    auto type = get_machine_int_type(x.m_symbol->get_type());
+    if (!type) {
+        return;
+    }
+    auto value = m_sep_dom.get_value(x);
+    value.wrap(*type);
+    m_sep_dom.set_value(x, value);
+}
+
+void MachineIntervalDom::assign_comparison(const Var& x,
+                                           const LinearConstraintT& cst) {
+    MachineIntervalDom dom_pos = *this;
+    MachineIntervalDom dom_neg = *this;
+    dom_pos.apply_linear_constraint(cst);
+    dom_neg.apply_linear_constraint(cst.negate());
+    if (dom_pos.is_bottom() && !dom_neg.is_bottom()) {
+        this->set_value(x, MachineInterval(ZInterval::false_val()));
+    } else if (!dom_pos.is_bottom() && dom_neg.is_bottom()) {
+        this->set_value(x, MachineInterval(ZInterval::true_val()));
+    } else {
+        this->set_value(x, MachineInterval(ZInterval::unknown_bool()));
+    }
+}
+
+void MachineIntervalDom::assign_binary_var_var(clang::BinaryOperatorKind op,
+                                               const Var& x,
+                                               const Var& y,
+                                               const Var& z) {
+    knight_assert(!clang::BinaryOperator::isAssignmentOp(op));
+    if (clang::BinaryOperator::isComparisonOp(op)) {
+        assign_comparison(x, Base::construct_constraint(op, y, z));
+        return;
+    }
+    m_sep_dom.assign_binary_var_var_for_non_assign_rel_op(op, x, y, z);
+    wrap_to_type(x);
+}
+
+void MachineIntervalDom::assign_binary_var_num(clang::BinaryOperatorKind op,
+                                               const Var& x,
+                                               const Var& y,
+                                               const ZNum& z) {
+    knight_assert(!clang::BinaryOperator::isAssignmentOp(op));
+    if (clang::BinaryOperator::isComparisonOp(op)) {
+        assign_comparison(x, Base::construct_constraint(op, y, z));
+        return;
+    }
+    m_sep_dom.assign_binary_var_num_for_non_assign_rel_op(op, x, y, z);
+    wrap_to_type(x);
+}
+
+void MachineIntervalDom::apply_linear_constraint(const LinearConstraintT& cst) {
+    Solver solver;
+    solver.add(cst);
+    solver.run(*this);
+}
+
+void MachineIntervalDom::merge_with_linear_constraint_system(
+    const LinearConstraintSystemT& csts) {
+    Solver solver;
+    solver.add(csts);
+    solver.run(*this);
+}
+
+MachineIntervalDom::LinearConstraintSystemT MachineIntervalDom::
+    to_linear_constraint_system() const {
+    if (m_sep_dom.is_bottom()) {
+        return LinearConstraintSystemT(LinearConstraintT::contradiction());
+    }
+
+    LinearConstraintSystemT csts;
+    for (const auto& [var, value] : m_sep_dom.get_table()) {
+        if (value.is_bottom()) {
+            csts.add_linear_constraint(LinearConstraintT::contradiction());
+            continue;
+        }
+        if (auto lb = value.get_lb().get_num_opt()) {
+            csts.add_linear_constraint(LinearExprT(var) >= ZNum(*lb));
+        }
+        if (auto ub = value.get_ub().get_num_opt()) {
+            csts.add_linear_constraint(LinearExprT(var) <= ZNum(*ub));
+        }
+    }
+    return csts;
+}
+
+} // namespace knight::analyzer
@@ -13,25 +13,78 @@
 
 #include "analyzer/core/engine/block_engine.hpp"
 #include "analyzer/core/analysis/analysis_base.hpp"
+#include "analyzer/core/checker_context.hpp"
 #include "analyzer/core/proc_cfg.hpp"
 #include "analyzer/core/program_state.hpp"
 #include "common/util/assert.hpp"
 
 #include <clang/Analysis/CFG.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/Casting.h>
 
+#include <utility>
+
 #define DEBUG_TYPE "block_engine"
 
 namespace knight::analyzer {
 
 void BlockExecutionEngine::exec() {
-    ProgramStateRef state = m_state;
+    // The replay of the checkers keeps every stmt value in the states, as
+    // the check points may be checked after the block transfer.
+    if (m_checker_manager != nullptr) {
+        exec_elements();
+        return;
+    }
+
+    auto& state_mgr = m_analysis_manager.get_state_manager();
+    auto* prev_stmt_scratch = state_mgr.set_stmt_scratch(&m_stmt_scratch);
+    auto* prev_zdom_scratch = state_mgr.set_zdom_scratch(&m_zdom_scratch);
+    if (m_program != nullptr && m_program->is_lowered()) {
+        exec_program();
+    } else {
+        exec_elements();
+    }
+    state_mgr.set_zdom_scratch(prev_zdom_scratch);
+    state_mgr.set_stmt_scratch(prev_stmt_scratch);
+    persist_zdom_scratch();
+    persist_stmt_scratch();
+}
+
+void BlockExecutionEngine::persist_zdom_scratch() {
+    SharedZNumericalVal zdom = std::exchange(m_zdom_scratch, nullptr);
+    if (zdom == nullptr || m_state->is_bottom()) {
+        return;
+    }
+    if (zdom->is_bottom()) {
+        m_state = m_state->get_state_manager().get_bottom_state();
+        return;
+    }
+    m_state = m_state->set_zdom(std::move(zdom));
+}
 
-    state = exec_branch_condition(state);
-    if (state->is_bottom()) {
-        m_state = state;
+void BlockExecutionEngine::persist_stmt_scratch() {
+    if (m_stmt_scratch.empty() || m_state->is_bottom()) {
         return;
     }
+    const bool prune_dead_values = m_analysis_manager.get_context()
+                                       .get_current_options()
+                                       .analyzer_opts.prune_dead_values;
+    const auto& liveness =
+        m_location_manager.get_liveness(m_frame->get_decl());
+    llvm::SmallVector< StmtSExprEntry, 8U > live_entries;
+    for (const auto& [stmt_frame_pair, sexpr] : m_stmt_scratch) {
+        const auto& [stmt, frame] = stmt_frame_pair;
+        if (!prune_dead_values || frame != m_frame ||
+            liveness.is_live_out(m_node, stmt)) {
+            live_entries.emplace_back(stmt_frame_pair, sexpr);
+        }
+    }
+    m_stmt_scratch.clear();
+    m_state = m_state->set_stmt_sexprs(live_entries);
+}
+
+void BlockExecutionEngine::exec_elements() {
+    ProgramStateRef state = m_state;
     for (const auto& elem : m_node->Elements) {
         m_current_elem_idx++;
         switch (elem.getKind()) {
@@ -93,47 +146,28 @@ void BlockExecutionEngine::exec() {
     m_state = state;
 }
 
-[[nodiscard]] const LocationContext* BlockExecutionEngine::
-    get_location_context() const {
-    return m_location_manager.create_location_context(m_frame,
-                                                      m_current_elem_idx,
-                                                      m_node);
-}
-
-// TODO(condition): only support successor size 2 for now
-
-ProgramStateRef BlockExecutionEngine::exec_branch_condition(
-    ProgramStateRef state) {
-    if (NodeRef pred = ProcCFG::get_unique_pred(m_node);
-        pred != nullptr && pred->succ_size() == 2U) {
-        if (ExprRef cond = pred->getLastCondition()) {
-            bool is_true_branch = *(pred->succ_begin()) == m_node;
-
-            if (const auto* scalar_int = llvm::dyn_cast_or_null< ScalarInt >(
-                    state->get_stmt_sexpr(cond, m_frame).value_or(nullptr))) {
-                knight_log(llvm::outs() << "condition as scalar int: "
-                                        << *scalar_int << "\n");
-                if ((is_true_branch && scalar_int->get_value() == 0) ||
-                    (!is_true_branch && scalar_int->get_value() != 1)) {
-                    return state->get_state_manager().get_bottom_state();
-                }
-            }
-            AnalysisContext analysis_ctx(m_analysis_manager.get_context(),
-                                         m_analysis_manager
-                                             .get_region_manager(),
-                                         m_frame,
-                                         m_sym_manager,
-                                         get_location_context());
-            analysis_ctx.set_state(state);
+void BlockExecutionEngine::exec_program() {
+    using enum internal::VisitStmtKind;
+    ProgramStateRef state = m_state;
+    for (const auto& lowered : m_program->get_stmts()) {
+        m_current_elem_idx = lowered.elem_idx;
+        auto& analysis_ctx = get_analysis_context(state);
+        for (auto kind : {Pre, Eval, Post}) {
             m_analysis_manager
-                .run_analyses_for_condition_filter(analysis_ctx,
-                                                   cond,
-                                                   is_true_branch);
-
-            return analysis_ctx.get_state();
+                .run_stmt_callbacks(analysis_ctx,
+                                    lowered.stmt,
+                                    m_program->get_callbacks(lowered, kind));
         }
+        state = analysis_ctx.get_state();
     }
-    return state;
+    m_state = state;
+}
+
+AnalysisContext& BlockExecutionEngine::get_analysis_context(
+    ProgramStateRef state) {
+    m_analysis_ctx.set_current_location_context(get_location_context());
+    m_analysis_ctx.set_state(std::move(state));
+    return m_analysis_ctx;
 }
 
 /// \brief Transfer C++ base or member initializer from constructor's
@@ -177,21 +211,39 @@ void BlockExecutionEngine::exec_lifetime_ends(StmtRef trigger_stmt,
 /// \brief Transfer the stmt
 ProgramStateRef BlockExecutionEngine::exec_cfg_stmt(
     StmtRef stmt, const ProgramStateRef& state) {
-    AnalysisContext analysis_ctx(m_analysis_manager.get_context(),
-                                 m_analysis_manager.get_region_manager(),
-                                 m_frame,
-                                 m_sym_manager,
-                                 get_location_context());
-    analysis_ctx.set_state(state);
-    m_stmt_pre[stmt] = state;
+    auto& analysis_ctx = get_analysis_context(state);
+    check_stmt(stmt, state, internal::CheckStmtKind::Pre);
 
     m_analysis_manager.run_analyses_for_pre_stmt(analysis_ctx, stmt);
     m_analysis_manager.run_analyses_for_eval_stmt(analysis_ctx, stmt);
     m_analysis_manager.run_analyses_for_post_stmt(analysis_ctx, stmt);
 
     auto post_state = analysis_ctx.get_state();
-    m_stmt_post[stmt] = post_state;
+    check_stmt(stmt, post_state, internal::CheckStmtKind::Post);
     return std::move(post_state);
 }
 
+void BlockExecutionEngine::check_stmt(StmtRef stmt,
+                                      const ProgramStateRef& state,
+                                      internal::CheckStmtKind kind) {
+    if (m_checker_manager == nullptr ||
+        !m_checker_manager->has_checkers_for_stmt(stmt, kind)) {
+        return;
+    }
+    if (m_check_points != nullptr) {
+        m_check_points->push_back({stmt, kind, state, get_location_context()});
+        return;
+    }
+    CheckerContext checker_ctx(m_analysis_manager.get_context(),
+                               m_frame,
+                               m_sym_manager,
+                               get_location_context());
+    checker_ctx.set_current_state(state);
+    if (kind == internal::CheckStmtKind::Pre) {
+        m_checker_manager->run_checkers_for_pre_stmt(checker_ctx, stmt);
+    } else {
+        m_checker_manager->run_checkers_for_post_stmt(checker_ctx, stmt);
+    }
+}
+
 } // namespace knight::analyzer
\ No newline at end of file
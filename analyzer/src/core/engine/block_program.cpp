@@ -0,0 +1,72 @@
+//===- block_program.cpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the lowered form of the Basic Block executed by
+//  the block engine during the fixpoint iteration.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/engine/block_program.hpp"
+
+#include <clang/Analysis/CFG.h>
+
+#include <cstddef>
+
+namespace knight::analyzer {
+
+namespace {
+
+constexpr std::array< internal::VisitStmtKind, internal::NumVisitStmtKinds >
+    VisitStmtKinds = {internal::VisitStmtKind::Pre,
+                      internal::VisitStmtKind::Eval,
+                      internal::VisitStmtKind::Post};
+
+} // anonymous namespace
+
+BlockProgram BlockProgram::lower(NodeRef node, AnalysisManager& analysis_mgr) {
+    BlockProgram program;
+    int elem_idx = -1;
+    for (const auto& elem : node->Elements) {
+        elem_idx++;
+        auto cfg_stmt = elem.getAs< clang::CFGStmt >();
+        if (!cfg_stmt) {
+            return {};
+        }
+        const auto* stmt = cfg_stmt->getStmt();
+        const auto begin =
+            static_cast< unsigned >(program.m_callbacks.size());
+        LoweredStmt lowered{stmt, elem_idx, begin, {}};
+        for (std::size_t kind = 0U; kind < internal::NumVisitStmtKinds;
+             ++kind) {
+            const auto& callbacks =
+                analysis_mgr.get_stmt_analyses_for(stmt, VisitStmtKinds[kind]);
+            program.m_callbacks.insert(program.m_callbacks.end(),
+                                       callbacks.begin(),
+                                       callbacks.end());
+            lowered.callback_ends[kind] =
+                static_cast< unsigned >(program.m_callbacks.size());
+        }
+        if (lowered.callback_ends.back() != begin) {
+            program.m_stmts.push_back(lowered);
+        }
+    }
+    program.m_is_lowered = true;
+    return program;
+}
+
+BlockProgram::AnalyzeStmtCallBacks BlockProgram::get_callbacks(
+    const LoweredStmt& stmt, internal::VisitStmtKind visit_kind) const {
+    const auto kind = static_cast< std::size_t >(visit_kind);
+    const unsigned begin =
+        kind == 0U ? stmt.callback_begin : stmt.callback_ends[kind - 1U];
+    return AnalyzeStmtCallBacks(m_callbacks)
+        .slice(begin, stmt.callback_ends[kind] - begin);
+}
+
+} // namespace knight::analyzer
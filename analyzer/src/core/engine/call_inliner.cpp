@@ -0,0 +1,190 @@
+//===- call_inliner.cpp -----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the call inliner of the analyzer engine.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/engine/call_inliner.hpp"
+#include "analyzer/core/analysis_manager.hpp"
+#include "analyzer/core/checker_manager.hpp"
+#include "analyzer/core/engine/intraprocedural_fixpoint.hpp"
+#include "analyzer/core/program_state.hpp"
+#include "analyzer/core/region/region.hpp"
+#include "analyzer/core/symbol_manager.hpp"
+#include "analyzer/tooling/context.hpp"
+#include "common/util/log.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#define DEBUG_TYPE "call-inliner"
+
+namespace knight::analyzer {
+
+namespace {
+
+void hash_bound(std::size_t& seed, const ZBound& bound) {
+    if (bound.is_finite()) {
+        hash_combine(seed, hash_value(bound.get_num()));
+    } else {
+        hash_combine(seed, bound.is_pinf() ? 1U : 2U);
+    }
+}
+
+/// \brief Get the depth of the frame below the top-level function.
+unsigned get_call_depth(const StackFrame* frame) {
+    unsigned depth = 0U;
+    for (; !frame->is_top_frame(); frame = frame->get_parent()) {
+        ++depth;
+    }
+    return depth;
+}
+
+bool is_on_call_stack(const clang::FunctionDecl* callee,
+                      const StackFrame* frame) {
+    for (; frame != nullptr; frame = frame->get_parent()) {
+        if (frame->get_decl()->getCanonicalDecl() == callee) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+std::size_t CallInliner::CallKeyHash::operator()(const CallKey& key) const {
+    std::size_t seed = std::hash< const void* >()(key.callee);
+    for (const auto& arg : key.args) {
+        hash_bound(seed, arg.get_lb());
+        hash_bound(seed, arg.get_ub());
+    }
+    return seed;
+}
+
+std::optional< ZInterval > CallInliner::inline_call(
+    const clang::CallExpr* call_expr, const AnalysisContext& ctx) {
+    const auto* callee = call_expr->getDirectCallee();
+    if (callee == nullptr || callee->getDefinition() == nullptr) {
+        return std::nullopt;
+    }
+    const auto* frame = ctx.get_current_stack_frame();
+    const auto max_depth =
+        m_ctx.get_current_options().analyzer_opts.max_call_depth;
+    if (get_call_depth(frame) >= max_depth ||
+        is_on_call_stack(callee->getCanonicalDecl(), frame)) {
+        return std::nullopt;
+    }
+
+    CallKey key{callee->getCanonicalDecl(),
+                get_arg_values(call_expr, callee->getDefinition(), ctx)};
+    if (auto it = m_results.find(key); it != m_results.end()) {
+        knight_log(llvm::outs() << "reuse the inlined result of `"
+                                << callee->getQualifiedNameAsString()
+                                << "`: " << it->second << "\n";);
+        return it->second;
+    }
+
+    const auto* loc_ctx = ctx.get_current_location_context();
+    const auto* callee_frame = m_location_mgr.create_from_node(
+        const_cast< StackFrame* >(frame), // NOLINT
+        loc_ctx->get_block(),
+        call_expr,
+        static_cast< unsigned >(loc_ctx->get_element_id()));
+
+    ZInterval values = ZInterval::top();
+    {
+        // The stmt and numerical values of the caller block are not
+        // visible to the callee, which is transferred out of that block.
+        auto& state_mgr = m_analysis_mgr.get_state_manager();
+        auto* caller_scratch = state_mgr.set_stmt_scratch(nullptr);
+        auto* caller_zdom_scratch = state_mgr.set_zdom_scratch(nullptr);
+        IntraProceduralFixpointIterator engine(m_ctx,
+                                               m_analysis_mgr,
+                                               m_checker_mgr,
+                                               m_location_mgr,
+                                               state_mgr,
+                                               callee_frame);
+        engine.run(get_entry_state(callee_frame, key.args));
+        values = engine.build_summary().return_values;
+        state_mgr.set_zdom_scratch(caller_zdom_scratch);
+        state_mgr.set_stmt_scratch(caller_scratch);
+    }
+
+    knight_log(llvm::outs() << "inlined `"
+                            << callee->getQualifiedNameAsString()
+                            << "`: " << values << "\n";);
+    m_results.emplace(std::move(key), values);
+    return values;
+}
+
+std::vector< ZInterval > CallInliner::get_arg_values(
+    const clang::CallExpr* call_expr,
+    const clang::FunctionDecl* callee,
+    const AnalysisContext& ctx) const {
+    auto state = ctx.get_state();
+    const auto* frame = ctx.get_current_stack_frame();
+    const auto num_args =
+        std::min< unsigned >(call_expr->getNumArgs(), callee->getNumParams());
+
+    std::vector< ZInterval > args(num_args, ZInterval::top());
+    for (unsigned idx = 0U; idx < num_args; ++idx) {
+        const auto* arg = call_expr->getArg(idx)->IgnoreParens();
+        if (!callee->getParamDecl(idx)
+                 ->getType()
+                 ->isIntegralOrEnumerationType() ||
+            !arg->getType()->isIntegralOrEnumerationType()) {
+            continue;
+        }
+        auto sexpr = state->get_stmt_sexpr(arg, frame);
+        if (!sexpr) {
+            continue;
+        }
+        if (auto znum = (*sexpr)->get_as_znum()) {
+            args[idx] = ZInterval(*znum);
+        } else if (auto zvar = (*sexpr)->get_as_zvariable()) {
+            if (auto zdom = state->get_zdom_ref()) {
+                args[idx] = (*zdom)->to_interval(*zvar);
+            }
+        }
+    }
+    return args;
+}
+
+ProgramStateRef CallInliner::get_entry_state(
+    const StackFrame* callee_frame, llvm::ArrayRef< ZInterval > args) {
+    const auto* callee = llvm::cast< clang::FunctionDecl >(
+        callee_frame->get_decl());
+    auto& region_mgr = m_analysis_mgr.get_region_manager();
+    auto& sym_mgr = m_analysis_mgr.get_symbol_manager();
+    const auto* entry_loc = callee_frame->get_entry_location();
+
+    auto state = m_analysis_mgr.get_state_manager().get_default_state();
+    std::vector< ZLinearConstraint > constraints;
+    for (unsigned idx = 0U; idx < args.size(); ++idx) {
+        const auto& arg = args[idx];
+        if (arg.is_top()) {
+            continue;
+        }
+        const auto* param = callee->getParamDecl(idx);
+        auto region = region_mgr.get_region(param, callee_frame);
+        const auto* def = sym_mgr.get_region_def(region, entry_loc);
+        state = state->set_region_def(region, callee_frame, def);
+
+        ZVariable param_var(def);
+        if (arg.get_lb().is_finite()) {
+            constraints.push_back(param_var >= arg.get_lb().get_num());
+        }
+        if (arg.get_ub().is_finite()) {
+            constraints.push_back(param_var <= arg.get_ub().get_num());
+        }
+    }
+    return state->assume_zlinear_constraints(constraints);
+}
+
+} // namespace knight::analyzer
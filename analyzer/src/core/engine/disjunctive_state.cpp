@@ -0,0 +1,70 @@
+//===- disjunctive_state.cpp ------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the bounded disjunction of the program states.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/engine/disjunctive_state.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+
+namespace knight::analyzer {
+
+void DisjunctiveState::add(ProgramStateRef state,
+                           const LocationContext* loc_ctx) {
+    if (state->is_bottom()) {
+        return;
+    }
+    // The states are interned, so a duplicate is the same pointer.
+    if (llvm::is_contained(m_disjuncts, state)) {
+        return;
+    }
+    m_disjuncts.push_back(std::move(state));
+    if (m_disjuncts.size() > m_max_width) {
+        merge_most_similar(loc_ctx);
+    }
+}
+
+ProgramStateRef DisjunctiveState::collapse(
+    const LocationContext* loc_ctx) const {
+    if (m_disjuncts.empty()) {
+        return m_bottom;
+    }
+    ProgramStateRef state = m_disjuncts.front();
+    for (const auto& disjunct : llvm::drop_begin(m_disjuncts)) {
+        state = state->join(disjunct, loc_ctx);
+    }
+    return state;
+}
+
+void DisjunctiveState::merge_most_similar(const LocationContext* loc_ctx) {
+    unsigned lhs = 0U;
+    unsigned rhs = 1U;
+    unsigned best = 0U;
+    for (unsigned i = 0U; i < m_disjuncts.size(); ++i) {
+        for (unsigned j = i + 1U; j < m_disjuncts.size(); ++j) {
+            unsigned similarity = m_disjuncts[i]->get_similarity(
+                *m_disjuncts[j]);
+            if (similarity > best) {
+                best = similarity;
+                lhs = i;
+                rhs = j;
+            }
+        }
+    }
+    m_disjuncts[lhs] = m_disjuncts[lhs]->join(m_disjuncts[rhs], loc_ctx);
+    m_disjuncts.erase(m_disjuncts.begin() + rhs);
+    // The join may give back another disjunct.
+    if (llvm::count(m_disjuncts, m_disjuncts[lhs]) > 1) {
+        m_disjuncts.erase(m_disjuncts.begin() + lhs);
+    }
+}
+
+} // namespace knight::analyzer
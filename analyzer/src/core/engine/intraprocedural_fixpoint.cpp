@@ -19,19 +19,95 @@
 #include "analyzer/core/engine/block_engine.hpp"
 #include "analyzer/core/proc_cfg.hpp"
 #include "analyzer/core/program_state.hpp"
+#include "analyzer/core/symbol.hpp"
+#include "analyzer/tooling/diagnostic.hpp"
+#include "analyzer/tooling/stats.hpp"
+#include "analyzer/tooling/time_report.hpp"
+#include "analyzer/tooling/trace.hpp"
+#include "analyzer/tooling/widening_trace.hpp"
 #include "common/util/log.hpp"
 
+#include <clang/AST/Stmt.h>
+#include <llvm/ADT/APSInt.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/WithColor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
 #define DEBUG_TYPE "intra-fixpoint"
 
 namespace knight::analyzer {
 
+namespace {
+
+/// \brief A loop exiting on the comparison `counter op bound` at its
+/// head, the counter being an integer local variable.
+struct CountingLoop {
+    const clang::VarDecl* counter;
+    clang::BinaryOperatorKind op;
+    const clang::Expr* bound;
+}; // struct CountingLoop
+
+const clang::VarDecl* get_integer_var(const clang::Expr* expr) {
+    const auto* ref =
+        llvm::dyn_cast< clang::DeclRefExpr >(expr->IgnoreParenImpCasts());
+    const auto* var =
+        ref == nullptr ? nullptr
+                       : llvm::dyn_cast< clang::VarDecl >(ref->getDecl());
+    if (var == nullptr || !var->hasLocalStorage() ||
+        !var->getType()->isIntegerType()) {
+        return nullptr;
+    }
+    return var;
+}
+
+std::optional< CountingLoop > get_counting_loop(ProcCFG::NodeRef head) {
+    const auto* cond = head->getLastCondition();
+    const auto* binary =
+        cond == nullptr ? nullptr
+                        : llvm::dyn_cast< clang::BinaryOperator >(
+                              cond->IgnoreParenImpCasts());
+    if (binary == nullptr || (!binary->isRelationalOp() &&
+                              binary->getOpcode() != clang::BO_NE)) {
+        return std::nullopt;
+    }
+    if (const auto* counter = get_integer_var(binary->getLHS())) {
+        return CountingLoop{counter, binary->getOpcode(), binary->getRHS()};
+    }
+    if (const auto* counter = get_integer_var(binary->getRHS())) {
+        return CountingLoop{counter,
+                            clang::BinaryOperator::reverseComparisonOp(
+                                binary->getOpcode()),
+                            binary->getLHS()};
+    }
+    return std::nullopt;
+}
+
+std::optional< ZInterval > get_var_interval(const ProgramState& state,
+                                            const clang::VarDecl* var,
+                                            const StackFrame* frame) {
+    auto zvar = state.try_get_zvariable(var, frame);
+    auto zdom = state.get_zdom_ref();
+    if (!zvar || !zdom) {
+        return std::nullopt;
+    }
+    return (*zdom)->to_interval(*zvar);
+}
+
+} // anonymous namespace
+
 IntraProceduralFixpointIterator::IntraProceduralFixpointIterator(
     knight::KnightContext& ctx,
     AnalysisManager& analysis_mgr,
     CheckerManager& checker_mgr,
     LocationManager& location_mgr,
     ProgramStateManager& state_mgr,
-    const StackFrame* frame)
+    const StackFrame* frame,
+    std::vector< CheckWorker > check_workers)
     : m_frame(frame),
       m_ctx(ctx),
       m_analysis_mgr(analysis_mgr),
@@ -39,12 +115,19 @@ IntraProceduralFixpointIterator::IntraProceduralFixpointIterator(
       m_symbol_mgr(analysis_mgr.get_symbol_manager()),
       m_location_mgr(location_mgr),
       m_state_mgr(state_mgr),
+      m_check_workers(std::move(check_workers)),
+      m_transfer_memo(frame->get_cfg()),
+      m_block_programs(frame->get_cfg()),
       WtoBasedFixPointIterator(ctx.get_current_options().analyzer_opts,
                                frame,
                                state_mgr.get_bottom_state()) {}
 
 ProgramStateRef IntraProceduralFixpointIterator::transfer_node(
     NodeRef node, ProgramStateRef pre_state) {
+    // The unreachable nodes stay unreachable without building the engine.
+    if (pre_state->is_bottom()) {
+        return pre_state;
+    }
     if (ProcCFG::entry(get_cfg()) == node) {
         AnalysisContext analysis_ctx(m_ctx,
                                      m_analysis_mgr.get_region_manager(),
@@ -70,127 +153,591 @@ ProgramStateRef IntraProceduralFixpointIterator::transfer_node(
         m_analysis_mgr.run_analyses_for_end_function(analysis_ctx, node);
     }
 
+    if (const auto* memo = m_transfer_memo.find(node);
+        memo != nullptr && memo->first == pre_state) {
+        knight_log(llvm::outs() << "reuse the post state of node: "
+                                << node->getBlockID() << "\n");
+        return memo->second;
+    }
+
     BlockExecutionEngine engine(get_cfg(),
                                 node,
                                 m_analysis_mgr,
                                 m_symbol_mgr,
                                 m_location_mgr,
                                 pre_state,
-                                m_stmt_pre,
-                                m_stmt_post,
                                 m_frame);
+    if (!m_block_programs.contains(node)) {
+        m_block_programs[node] = BlockProgram::lower(node, m_analysis_mgr);
+    }
+    engine.set_program(m_block_programs.find(node));
     engine.exec();
 
+    // The exit state is kept whole for the end function checkers.
+    auto post_state = engine.get_state();
+    if (m_analyzer_opts.prune_dead_values &&
+        ProcCFG::exit(get_cfg()) != node && !post_state->is_bottom()) {
+        post_state = post_state->remove_dead_values(
+            m_frame,
+            m_location_mgr.get_liveness(m_frame->get_decl()),
+            node);
+    }
+
     knight_log_nl(llvm::outs()
                       << "after transfer node: " << node->getBlockID() << " "
                       << "state: ";
-                  engine.get_state()->dump(llvm::outs());
+                  post_state->dump(llvm::outs());
                   llvm::outs() << "\n";);
 
-    return engine.get_state();
+    m_transfer_memo[node] = {std::move(pre_state), post_state};
+    return post_state;
 }
 
 ProgramStateRef IntraProceduralFixpointIterator::transfer_edge(
-    [[maybe_unused]] NodeRef src,
-    [[maybe_unused]] NodeRef dst,
-    ProgramStateRef src_post_state) {
-    // TODO(branch): add transfer logic for condition filter
-    return src_post_state;
+    NodeRef src, NodeRef dst, ProgramStateRef src_post_state) {
+    const auto* cond = src->getLastCondition();
+    if (cond == nullptr || src_post_state->is_bottom()) {
+        return src_post_state;
+    }
+    // An edge taken for several outcomes, e.g. both edges of an empty
+    // `if`, assumes nothing.
+    unsigned num_edges = 0U;
+    for (const auto& succ : src->succs()) {
+        if (succ == dst) {
+            ++num_edges;
+        }
+    }
+    if (num_edges != 1U) {
+        return src_post_state;
+    }
+
+    if (const auto* switch_stmt =
+            llvm::dyn_cast_or_null< clang::SwitchStmt >(
+                src->getTerminatorStmt())) {
+        return filter_switch_case(switch_stmt,
+                                  dst,
+                                  cond,
+                                  std::move(src_post_state));
+    }
+    if (src->succ_size() != 2U) {
+        return src_post_state;
+    }
+    // The first successor of a branch, including the `&&` and `||`
+    // operands, is taken when the condition holds.
+    return filter_branch(dst,
+                         cond,
+                         *(src->succ_begin()) == dst,
+                         std::move(src_post_state));
+}
+
+ProgramStateRef IntraProceduralFixpointIterator::filter_branch(
+    NodeRef dst,
+    ProcCFG::ExprRef cond,
+    bool is_true_branch,
+    ProgramStateRef state) {
+    if (const auto* scalar_int = llvm::dyn_cast_or_null< ScalarInt >(
+            state->get_stmt_sexpr(cond, m_frame).value_or(nullptr))) {
+        knight_log(llvm::outs()
+                   << "condition as scalar int: " << *scalar_int << "\n");
+        if ((scalar_int->get_value() != 0) != is_true_branch) {
+            return m_state_mgr.get_bottom_state();
+        }
+    }
+    AnalysisContext analysis_ctx(m_ctx,
+                                 m_analysis_mgr.get_region_manager(),
+                                 m_frame,
+                                 m_symbol_mgr,
+                                 m_location_mgr
+                                     .get_block_location_contexts(m_frame,
+                                                                  dst)
+                                     .front());
+    analysis_ctx.set_state(std::move(state));
+    m_analysis_mgr.run_analyses_for_condition_filter(analysis_ctx,
+                                                     cond,
+                                                     is_true_branch);
+    return analysis_ctx.get_state();
 }
 
-void IntraProceduralFixpointIterator::check_pre(
-    NodeRef node, [[maybe_unused]] const ProgramStateRef& state) {
-    CheckerContext checker_ctx(m_ctx, m_frame, m_symbol_mgr, nullptr);
-    int elem_idx = -1;
+ProgramStateRef IntraProceduralFixpointIterator::filter_switch_case(
+    const clang::SwitchStmt* switch_stmt,
+    NodeRef dst,
+    ProcCFG::ExprRef cond,
+    ProgramStateRef state) const {
+    auto sexpr = state->get_stmt_sexpr(cond, m_frame);
+    if (!sexpr) {
+        return state;
+    }
+    auto znum = (*sexpr)->get_as_znum();
+    auto zvar = (*sexpr)->get_as_zvariable();
+    if (!znum && !zvar) {
+        return state;
+    }
 
-    auto set_loc = [&]() {
-        checker_ctx.set_location_context(
-            m_location_mgr.create_location_context(m_frame, elem_idx, node));
+    auto& ast_ctx = m_frame->get_decl()->getASTContext();
+    // The labels out of int64_t, e.g. the unsigned ones above INT64_MAX,
+    // are read with the signedness of their type.
+    auto get_case_value = [&ast_ctx](const clang::Expr* expr) {
+        auto value = expr->EvaluateKnownConstInt(ast_ctx);
+        if (auto small = value.tryExtValue()) {
+            return ZNum(*small);
+        }
+        return *ZNum::from_string(llvm::toString(value, internal::K10Base));
     };
 
+    // The block after a switch without default may be labeled by a case
+    // of an enclosing switch, which is the default edge of this one.
+    const clang::CaseStmt* case_stmt = nullptr;
+    for (const auto* switch_case = switch_stmt->getSwitchCaseList();
+         switch_case != nullptr;
+         switch_case = switch_case->getNextSwitchCase()) {
+        if (switch_case == dst->getLabel()) {
+            case_stmt = llvm::dyn_cast< clang::CaseStmt >(switch_case);
+            break;
+        }
+    }
+
+    if (case_stmt != nullptr) {
+        ZNum lb = get_case_value(case_stmt->getLHS());
+        ZNum ub = case_stmt->getRHS() != nullptr
+                      ? get_case_value(case_stmt->getRHS())
+                      : lb;
+        if (znum) {
+            return lb <= *znum && *znum <= ub
+                       ? state
+                       : m_state_mgr.get_bottom_state();
+        }
+        if (lb == ub) {
+            return state->assume_zlinear_constraints({*zvar == lb});
+        }
+        return state->assume_zlinear_constraints({*zvar >= lb, *zvar <= ub});
+    }
+
+    // The default edge is taken for none of the single values, the case
+    // ranges are not excluded.
+    llvm::SmallVector< ZLinearConstraint, 8U > constraints;
+    for (const auto* switch_case = switch_stmt->getSwitchCaseList();
+         switch_case != nullptr;
+         switch_case = switch_case->getNextSwitchCase()) {
+        case_stmt = llvm::dyn_cast< clang::CaseStmt >(switch_case);
+        if (case_stmt == nullptr || case_stmt->getRHS() != nullptr) {
+            continue;
+        }
+        ZNum value = get_case_value(case_stmt->getLHS());
+        if (znum && *znum == value) {
+            return m_state_mgr.get_bottom_state();
+        }
+        if (zvar) {
+            constraints.push_back(*zvar != value);
+        }
+    }
+    return state->assume_zlinear_constraints(constraints);
+}
+
+void IntraProceduralFixpointIterator::check_pre(NodeRef node,
+                                                const ProgramStateRef& state) {
+    // The unreachable nodes are still replayed, the checkers may report
+    // them, e.g. `knight_reachable`.
+    if (!m_frame->is_top_frame()) {
+        return;
+    }
     if (node->empty()) {
-        set_loc();
         if (node == ProcCFG::entry(get_cfg())) {
-            auto init_state = get_pre(node);
-            checker_ctx.set_current_state(init_state);
+            CheckerContext checker_ctx(m_ctx,
+                                       m_frame,
+                                       m_symbol_mgr,
+                                       m_location_mgr
+                                           .create_location_context(m_frame,
+                                                                    -1,
+                                                                    node));
+            checker_ctx.set_current_state(state);
             m_checker_mgr.run_checkers_for_begin_function(checker_ctx);
         }
         return;
     }
-    for (const auto& elem : node->Elements) {
-        elem_idx++;
-        auto stmt_opt = elem.getAs< clang::CFGStmt >();
-        if (!stmt_opt) {
-            continue;
-        }
-        const auto* stmt = stmt_opt.value().getStmt();
-        if (stmt == nullptr) {
-            continue;
-        }
 
-        auto it = m_stmt_pre.find(stmt);
-        auto pre_state = it == m_stmt_pre.end() ? m_state_mgr.get_bottom_state()
-                                                : it->second;
+    // Replay the node from the converged invariant so that no per stmt
+    // state needs to be kept during the fixpoint iteration. With the check
+    // workers, the check points are recorded here and checked in parallel
+    // once all the nodes are replayed.
+    StmtCheckPoints* check_points = nullptr;
+    if (!m_check_workers.empty()) {
+        check_points = &m_node_check_points.emplace_back(node,
+                                                         StmtCheckPoints{})
+                            .second;
+    }
+    BlockExecutionEngine engine(get_cfg(),
+                                node,
+                                m_analysis_mgr,
+                                m_symbol_mgr,
+                                m_location_mgr,
+                                state,
+                                m_frame,
+                                &m_checker_mgr,
+                                check_points);
+    engine.exec();
+}
+
+void IntraProceduralFixpointIterator::check_post(NodeRef node,
+                                                 const ProgramStateRef& state) {
+    if (!m_frame->is_top_frame() || !node->empty() ||
+        node != ProcCFG::exit(get_cfg())) {
+        return;
+    }
+    CheckerContext checker_ctx(m_ctx,
+                               m_frame,
+                               m_symbol_mgr,
+                               m_location_mgr.create_location_context(m_frame,
+                                                                      -1,
+                                                                      node));
+    checker_ctx.set_current_state(state);
+    m_checker_mgr.run_checkers_for_end_function(checker_ctx, node);
+}
 
-        knight_log_nl(llvm::outs() << "pre state for stmt: "; stmt->dumpColor();
-                      llvm::outs() << " : ";
-                      pre_state->dump(llvm::outs());
-                      llvm::outs() << "\n";
-                      llvm::outs() << "state in cache: "
-                                   << (it != m_stmt_pre.end()) << "\n";);
+void IntraProceduralFixpointIterator::notify_enter_cycle(NodeRef head) {
+    Stats::count(StatKind::CycleVisits);
+    if (TimeReport::get().is_enabled()) {
+        m_cycle_iterations[head] = 0U;
+    }
+}
 
-        checker_ctx.set_current_state(pre_state);
-        set_loc();
+void IntraProceduralFixpointIterator::notify_each_cycle_iteration(
+    NodeRef head,
+    [[maybe_unused]] unsigned iter_cnt,
+    [[maybe_unused]] IterationKind kind) {
+    Stats::count(StatKind::CycleIterations);
+    if (TimeReport::get().is_enabled()) {
+        ++m_cycle_iterations[head];
+    }
+}
 
-        m_checker_mgr.run_checkers_for_pre_stmt(checker_ctx, stmt);
+void IntraProceduralFixpointIterator::notify_exit_cycle(NodeRef head) {
+    if (!TimeReport::get().is_enabled()) {
+        return;
     }
+    TimeReport::get().add_cycle_iterations(get_function_name() + ":B" +
+                                               std::to_string(
+                                                   head->getBlockID()),
+                                           m_cycle_iterations[head]);
 }
 
-void IntraProceduralFixpointIterator::check_post(
-    NodeRef node, [[maybe_unused]] const ProgramStateRef& state) {
-    CheckerContext checker_ctx(m_ctx, m_frame, m_symbol_mgr, nullptr);
-    int elem_idx = -1;
+ProgramStateRef IntraProceduralFixpointIterator::
+    enlarge_at_head_when_increasing(NodeRef head,
+                                    unsigned iter_cnt,
+                                    const ProgramStateRef& state_before,
+                                    const ProgramStateRef& state_after,
+                                    const LocationContext* loc_ctx,
+                                    std::optional< bool >& is_changed) {
+    const auto op = get_increasing_head_op(head, iter_cnt);
+    auto state = apply_head_op(op,
+                               head,
+                               state_before,
+                               state_after,
+                               loc_ctx,
+                               is_changed);
+    if (iter_cnt == 1U && m_analyzer_opts.accelerate_loops &&
+        !is_budget_exceeded()) {
+        if (auto accelerated = accelerate_counting_loop(head,
+                                                        state_before,
+                                                        state_after,
+                                                        state)) {
+            Stats::count(StatKind::AcceleratedCycles);
+            state = std::move(accelerated);
+            is_changed = true;
+        }
+    }
+    if (WideningTrace::get().is_enabled()) {
+        trace_head_iteration(head,
+                             iter_cnt,
+                             IterationKind::Increasing,
+                             op,
+                             *state_before,
+                             *state);
+    }
+    return state;
+}
 
-    auto set_loc = [&]() {
-        checker_ctx.set_location_context(
-            m_location_mgr.create_location_context(m_frame, elem_idx, node));
-    };
-    if (node->empty()) {
-        set_loc();
-        if (node == ProcCFG::exit(get_cfg())) {
-            auto exit_state = get_post(node);
-            checker_ctx.set_current_state(exit_state);
-            m_checker_mgr.run_checkers_for_end_function(checker_ctx, node);
+ProgramStateRef IntraProceduralFixpointIterator::
+    refine_at_loop_head_when_decreasing(NodeRef head,
+                                        unsigned iter_cnt,
+                                        const ProgramStateRef& state_before,
+                                        const ProgramStateRef& state_after,
+                                        std::optional< bool >& is_changed) {
+    const auto op = get_decreasing_head_op(head);
+    auto state = apply_head_op(op,
+                               head,
+                               state_before,
+                               state_after,
+                               nullptr,
+                               is_changed);
+    if (WideningTrace::get().is_enabled()) {
+        trace_head_iteration(head,
+                             iter_cnt,
+                             IterationKind::Decreasing,
+                             op,
+                             *state_before,
+                             *state);
+    }
+    return state;
+}
+
+ProgramStateRef IntraProceduralFixpointIterator::accelerate_counting_loop(
+    NodeRef head,
+    const ProgramStateRef& state_before,
+    const ProgramStateRef& state_after,
+    const ProgramStateRef& state) const {
+    auto loop = get_counting_loop(head);
+    if (!loop) {
+        return nullptr;
+    }
+    auto before = get_var_interval(*state_before, loop->counter, m_frame);
+    auto after = get_var_interval(*state_after, loop->counter, m_frame);
+    if (!before || !after || before->is_bottom() || after->is_bottom()) {
+        return nullptr;
+    }
+
+    // The bound is a constant or a variable unchanged by the iteration.
+    std::optional< ZInterval > bound;
+    clang::Expr::EvalResult res;
+    if (loop->bound->EvaluateAsInt(res,
+                                   get_cfg()->get_proc()->getASTContext())) {
+        // The unsigned bounds out of int64_t are read with their signedness.
+        const auto& value = res.Val.getInt();
+        if (auto small = value.tryExtValue()) {
+            bound = ZInterval(ZNum(*small));
+        } else {
+            bound = ZInterval(
+                *ZNum::from_string(llvm::toString(value, internal::K10Base)));
+        }
+    } else if (const auto* var = get_integer_var(loop->bound)) {
+        auto bound_before = get_var_interval(*state_before, var, m_frame);
+        bound = get_var_interval(*state_after, var, m_frame);
+        if (!bound_before || !bound || !bound_before->equals(*bound)) {
+            return nullptr;
         }
+    }
+    if (!bound || bound->is_bottom()) {
+        return nullptr;
+    }
+
+    // The step `c` of the counter is its growth over the first iteration,
+    // and its last value at the head is the first one past the bound,
+    // e.g. at most `n - 1 + c` for `i < n`.
+    const auto op = loop->op;
+    const ZNum one(1);
+    std::optional< ZNum > lb;
+    std::optional< ZNum > ub;
+    auto before_lb = before->get_lb().get_num_opt();
+    auto before_ub = before->get_ub().get_num_opt();
+    auto after_lb = after->get_lb().get_num_opt();
+    auto after_ub = after->get_ub().get_num_opt();
+    if (!before_lb || !before_ub || !after_lb || !after_ub) {
+        return nullptr;
+    }
+    if (*after_lb == *before_lb && *before_ub < *after_ub) {
+        auto bound_ub = bound->get_ub().get_num_opt();
+        const auto step = *after_ub - *before_ub;
+        if (!bound_ub ||
+            (op != clang::BO_LT && op != clang::BO_LE &&
+             (op != clang::BO_NE || step != one))) {
+            return nullptr;
+        }
+        lb = *after_lb;
+        ub = std::max(*after_ub,
+                      op == clang::BO_LE ? *bound_ub + step
+                                         : *bound_ub - one + step);
+    } else if (*after_ub == *before_ub && *after_lb < *before_lb) {
+        auto bound_lb = bound->get_lb().get_num_opt();
+        const auto step = *before_lb - *after_lb;
+        if (!bound_lb ||
+            (op != clang::BO_GT && op != clang::BO_GE &&
+             (op != clang::BO_NE || step != one))) {
+            return nullptr;
+        }
+        lb = std::min(*after_lb,
+                      op == clang::BO_GE ? *bound_lb - step
+                                         : *bound_lb + one - step);
+        ub = *after_ub;
+    } else {
+        return nullptr;
+    }
+
+    auto zvar = state->try_get_zvariable(loop->counter, m_frame);
+    if (!zvar) {
+        return nullptr;
+    }
+    auto zdom = state->get_zdom_clone();
+    zdom->forget(*zvar);
+    zdom->assume_predicate_var_num(clang::BO_GE, *zvar, *lb);
+    zdom->assume_predicate_var_num(clang::BO_LE, *zvar, *ub);
+    knight_log(llvm::outs() << "accelerate the counter "
+                            << loop->counter->getName() << " of B"
+                            << head->getBlockID() << " to [" << *lb << ", "
+                            << *ub << "]\n");
+    return state->set_zdom(std::move(zdom));
+}
+
+const std::string& IntraProceduralFixpointIterator::get_function_name() {
+    if (m_function_name.empty()) {
+        m_function_name = llvm::cast< clang::NamedDecl >(m_frame->get_decl())
+                              ->getQualifiedNameAsString();
+    }
+    return m_function_name;
+}
+
+void IntraProceduralFixpointIterator::trace_head_iteration(
+    NodeRef head,
+    unsigned iter_cnt,
+    IterationKind kind,
+    HeadOpKind op,
+    const ProgramState& state_before,
+    const ProgramState& state) {
+    WideningTrace::get().add_iteration(get_function_name(),
+                                       head->getBlockID(),
+                                       iter_cnt,
+                                       kind,
+                                       op,
+                                       state.get_changes(state_before));
+}
+
+void IntraProceduralFixpointIterator::run(ProgramStateRef entry_state) {
+    if (entry_state == nullptr) {
+        entry_state = m_state_mgr.get_default_state();
+    }
+    FixPointIterator::run(std::move(entry_state), m_location_mgr, m_frame);
+    if (is_aborted()) {
+        const auto* decl = m_frame->get_decl();
+        llvm::WithColor::warning()
+            << "memory budget exceeded in function `"
+            << llvm::cast< clang::NamedDecl >(decl)->getQualifiedNameAsString()
+            << "`, the function is skipped\n";
         return;
     }
+    if (is_degraded()) {
+        const auto* decl = m_frame->get_decl();
+        llvm::WithColor::warning()
+            << "analysis budget exceeded in function `"
+            << llvm::cast< clang::NamedDecl >(decl)->getQualifiedNameAsString()
+            << "`, the remaining cycles are widened eagerly\n";
+    }
+    if (!m_node_check_points.empty()) {
+        run_checkers_in_parallel();
+    }
+}
+
+FunctionSummary IntraProceduralFixpointIterator::build_summary() const {
+    FunctionSummary summary;
+    const auto* function =
+        llvm::cast< clang::FunctionDecl >(m_frame->get_decl());
+    const auto ret_type = function->getReturnType();
+    // A skipped function has no invariants to join, so its summary is the
+    // default top, i.e. any return value.
+    if (is_aborted() || !ret_type->isIntegralOrEnumerationType()) {
+        return summary;
+    }
 
-    for (const auto& elem : node->Elements) {
-        elem_idx++;
-        auto stmt_opt = elem.getAs< clang::CFGStmt >();
-        if (!stmt_opt) {
+    // Join the returned values over the blocks returning to the exit.
+    auto values = ZInterval::bottom();
+    for (const auto& pred : ProcCFG::exit(get_cfg())->preds()) {
+        if (pred == nullptr) {
             continue;
         }
-        const auto* stmt = stmt_opt.value().getStmt();
-        if (stmt == nullptr) {
+        const clang::Expr* ret_value = nullptr;
+        for (const auto& elem : llvm::reverse(*pred)) {
+            if (auto cfg_stmt = elem.getAs< clang::CFGStmt >()) {
+                if (const auto* ret = llvm::dyn_cast< clang::ReturnStmt >(
+                        cfg_stmt->getStmt())) {
+                    ret_value = ret->getRetValue();
+                }
+                break;
+            }
+        }
+        auto state = get_post(pred);
+        if (state->is_bottom()) {
             continue;
         }
-        auto it = m_stmt_post.find(stmt);
-        auto post_state = it == m_stmt_post.end()
-                              ? m_state_mgr.get_bottom_state()
-                              : it->second;
-
-        checker_ctx.set_current_state(post_state);
-        set_loc();
+        if (ret_value == nullptr) {
+            return summary;
+        }
 
-        m_checker_mgr.run_checkers_for_post_stmt(checker_ctx, stmt);
+        auto sexpr = state->get_stmt_sexpr(ret_value->IgnoreParens(), m_frame);
+        if (!sexpr) {
+            return summary;
+        }
+        if (auto znum = (*sexpr)->get_as_znum()) {
+            values.join_with(ZInterval(*znum));
+            continue;
+        }
+        auto zvar = (*sexpr)->get_as_zvariable();
+        auto zdom = state->get_zdom_ref();
+        if (!zvar || !zdom) {
+            return summary;
+        }
+        values.join_with((*zdom)->to_interval(*zvar));
     }
+    if (!values.is_bottom()) {
+        summary.return_values = std::move(values);
+    }
+    return summary;
 }
 
-void IntraProceduralFixpointIterator::run() {
-    FixPointIterator::run(m_state_mgr.get_default_state(),
-                          m_location_mgr,
-                          m_frame);
+void IntraProceduralFixpointIterator::run_checkers_in_parallel() {
+    const std::size_t num_nodes = m_node_check_points.size();
+    const std::size_t jobs = std::min(m_check_workers.size(), num_nodes);
+    std::atomic< std::size_t > next_node{0U};
+    std::vector< std::vector< KnightDiagnostic > > node_diags(num_nodes);
+
+    auto worker = [&](const CheckWorker& check_worker) {
+        const trace::ThreadScope trace_scope;
+        // The diagnostic client of a knight context is always a knight
+        // diagnostic consumer.
+        auto& diag_consumer = *static_cast< KnightDiagnosticConsumer* >(
+            check_worker.ctx.get_diagnostic_engine()->getClient());
+        CheckerContext checker_ctx(check_worker.ctx,
+                                   m_frame,
+                                   m_symbol_mgr,
+                                   nullptr);
+        for (auto idx = next_node.fetch_add(1U); idx < num_nodes;
+             idx = next_node.fetch_add(1U)) {
+            for (const auto& point : m_node_check_points[idx].second) {
+                checker_ctx.set_current_state(point.state);
+                checker_ctx.set_location_context(point.loc_ctx);
+                if (point.kind == internal::CheckStmtKind::Pre) {
+                    check_worker.checker_mgr
+                        .run_checkers_for_pre_stmt(checker_ctx, point.stmt);
+                } else {
+                    check_worker.checker_mgr
+                        .run_checkers_for_post_stmt(checker_ctx, point.stmt);
+                }
+            }
+            node_diags[idx] = diag_consumer.take_diags();
+        }
+    };
+
+    // The checkers may query the states concurrently.
+    auto& region_mgr = m_analysis_mgr.get_region_manager();
+    m_state_mgr.set_concurrent(true);
+    m_symbol_mgr.set_concurrent(true);
+    region_mgr.set_concurrent(true);
+    {
+        std::vector< std::thread > workers;
+        workers.reserve(jobs);
+        for (std::size_t worker_id = 0U; worker_id < jobs; ++worker_id) {
+            workers.emplace_back(worker, std::cref(m_check_workers[worker_id]));
+        }
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+    m_state_mgr.set_concurrent(false);
+    m_symbol_mgr.set_concurrent(false);
+    region_mgr.set_concurrent(false);
+    m_node_check_points.clear();
+
+    // One sink per node, so that the output does not depend on the
+    // scheduling of the workers.
+    auto& diag_consumer = *static_cast< KnightDiagnosticConsumer* >(
+        m_ctx.get_diagnostic_engine()->getClient());
+    diag_consumer.add_diags(merge_sorted_diags(std::move(node_diags)));
 }
 
 } // namespace knight::analyzer
\ No newline at end of file
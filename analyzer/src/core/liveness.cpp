@@ -0,0 +1,370 @@
+//===- liveness.cpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the liveness of the local variables and of the
+//  stmt values over a procedural CFG.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/core/liveness.hpp"
+#include "common/util/log.hpp"
+
+#include <clang/AST/Expr.h>
+#include <clang/AST/Stmt.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/TimeProfiler.h>
+
+#define DEBUG_TYPE "liveness"
+
+namespace knight::analyzer {
+
+namespace {
+
+using namespace clang;
+
+using VarSet = llvm::DenseSet< const VarDecl* >;
+using StmtSet = llvm::DenseSet< ProcCFG::StmtRef >;
+
+/// \brief The upward exposed reads of a block and the values it defines.
+struct BlockUses {
+    llvm::SmallVector< const VarDecl*, 8U > vars;
+    llvm::SmallVector< ProcCFG::StmtRef, 8U > stmts;
+    llvm::SmallVector< const VarDecl*, 4U > killed_vars;
+    llvm::SmallVector< ProcCFG::StmtRef, 16U > defined_stmts;
+}; // struct BlockUses
+
+bool is_trackable(const VarDecl* var) {
+    const auto type = var->getType();
+    return var->hasLocalStorage() && !llvm::isa< ParmVarDecl >(var) &&
+           type->isScalarType() && !type.isVolatileQualified();
+}
+
+/// \brief Check if a glvalue child of the stmt cannot alias the variable
+/// it refers to.
+///
+/// The transparent parents, e.g. the parentheses or the C++ assignments
+/// yielding their lhs, are checked at their own parents instead.
+bool is_safe_position(const Stmt* parent, const Stmt* child) {
+    if (const auto* cast = llvm::dyn_cast< CastExpr >(parent)) {
+        return cast->isGLValue() ||
+               cast->getCastKind() == CK_LValueToRValue ||
+               cast->getCastKind() == CK_ToVoid;
+    }
+    if (const auto* binary = llvm::dyn_cast< BinaryOperator >(parent)) {
+        if (binary->isAssignmentOp()) {
+            return child == binary->getLHS();
+        }
+        return binary->isCommaOp() &&
+               (child == binary->getLHS() || binary->isGLValue());
+    }
+    if (const auto* unary = llvm::dyn_cast< UnaryOperator >(parent)) {
+        return unary->isIncrementDecrementOp();
+    }
+    if (const auto* cond =
+            llvm::dyn_cast< AbstractConditionalOperator >(parent)) {
+        return cond->isGLValue();
+    }
+    if (llvm::isa< ParenExpr, FullExpr >(parent)) {
+        return true;
+    }
+    return !llvm::isa< Expr, DeclStmt, ReturnStmt >(parent);
+}
+
+/// \brief Mark the variables the glvalue expression may refer to.
+void mark_escaping(const Expr* expr, VarSet& escaping) {
+    llvm::SmallVector< const Expr*, 4U > worklist{expr};
+    while (!worklist.empty()) {
+        const auto* glvalue = worklist.pop_back_val()->IgnoreParens();
+        if (glvalue == nullptr || !glvalue->isGLValue()) {
+            continue;
+        }
+        if (const auto* ref = llvm::dyn_cast< DeclRefExpr >(glvalue)) {
+            if (const auto* var = llvm::dyn_cast< VarDecl >(ref->getDecl())) {
+                escaping.insert(var);
+            }
+        } else if (const auto* full = llvm::dyn_cast< FullExpr >(glvalue)) {
+            worklist.push_back(full->getSubExpr());
+        } else if (const auto* cast = llvm::dyn_cast< CastExpr >(glvalue)) {
+            worklist.push_back(cast->getSubExpr());
+        } else if (const auto* binary =
+                       llvm::dyn_cast< BinaryOperator >(glvalue)) {
+            if (binary->isAssignmentOp()) {
+                worklist.push_back(binary->getLHS());
+            } else if (binary->isCommaOp()) {
+                worklist.push_back(binary->getRHS());
+            }
+        } else if (const auto* unary =
+                       llvm::dyn_cast< UnaryOperator >(glvalue)) {
+            if (unary->isPrefix() && unary->isIncrementDecrementOp()) {
+                worklist.push_back(unary->getSubExpr());
+            }
+        } else if (const auto* cond =
+                       llvm::dyn_cast< AbstractConditionalOperator >(
+                           glvalue)) {
+            worklist.push_back(cond->getTrueExpr());
+            worklist.push_back(cond->getFalseExpr());
+        } else if (const auto* opaque =
+                       llvm::dyn_cast< OpaqueValueExpr >(glvalue)) {
+            worklist.push_back(opaque->getSourceExpr());
+        }
+    }
+}
+
+/// \brief Collect the local scalar variables of the body which never
+/// escape.
+VarSet collect_tracked_vars(const Stmt* body) {
+    VarSet candidates;
+    VarSet escaping;
+    llvm::SmallVector< const Stmt*, 32U > worklist{body};
+    while (!worklist.empty()) {
+        const auto* stmt = worklist.pop_back_val();
+        if (const auto* ref = llvm::dyn_cast< DeclRefExpr >(stmt)) {
+            const auto* var = llvm::dyn_cast< VarDecl >(ref->getDecl());
+            if (var != nullptr && is_trackable(var)) {
+                candidates.insert(var);
+            }
+        }
+        for (const auto* child : stmt->children()) {
+            if (child == nullptr) {
+                continue;
+            }
+            if (const auto* expr = llvm::dyn_cast< Expr >(child);
+                expr != nullptr && !is_safe_position(stmt, child)) {
+                mark_escaping(expr, escaping);
+            }
+            worklist.push_back(child);
+        }
+    }
+
+    VarSet tracked;
+    for (const auto* var : candidates) {
+        if (!escaping.contains(var)) {
+            tracked.insert(var);
+        }
+    }
+    return tracked;
+}
+
+/// \brief Collect the reads of the block which are not defined earlier
+/// in the block, along with the values it defines.
+class BlockUseCollector {
+  private:
+    const VarSet& m_tracked_vars;
+    BlockUses& m_uses;
+    StmtSet m_visited;
+    StmtSet m_defined;
+    VarSet m_killed;
+
+  public:
+    BlockUseCollector(const VarSet& tracked_vars, BlockUses& uses)
+        : m_tracked_vars(tracked_vars), m_uses(uses) {}
+
+    /// \brief Read the value of `stmt` and its sub-expressions at the
+    /// block start.
+    void read_at_start(ProcCFG::StmtRef stmt) { visit(stmt, false); }
+
+    /// \brief Evaluate the element `stmt` of the block.
+    void evaluate(ProcCFG::StmtRef stmt) {
+        // The element is evaluated from the values of its children.
+        visit(stmt, true);
+        m_defined.insert(stmt);
+        m_uses.defined_stmts.push_back(stmt);
+        if (const auto* decl_stmt = llvm::dyn_cast< DeclStmt >(stmt)) {
+            for (const auto* decl : decl_stmt->decls()) {
+                const auto* var = llvm::dyn_cast< VarDecl >(decl);
+                if (var != nullptr && m_tracked_vars.contains(var) &&
+                    m_killed.insert(var).second) {
+                    m_uses.killed_vars.push_back(var);
+                }
+            }
+        }
+    }
+
+  private:
+    void visit(ProcCFG::StmtRef root, bool is_element) {
+        llvm::SmallVector< ProcCFG::StmtRef, 16U > worklist{root};
+        while (!worklist.empty()) {
+            const auto* stmt = worklist.pop_back_val();
+            const bool is_root = is_element && stmt == root;
+            if (!m_visited.insert(stmt).second && !is_root) {
+                continue;
+            }
+            if (!is_root && !m_defined.contains(stmt) &&
+                !llvm::isa< ParenExpr >(stmt)) {
+                m_uses.stmts.push_back(stmt);
+            }
+            if (const auto* ref = llvm::dyn_cast< DeclRefExpr >(stmt)) {
+                const auto* var = llvm::dyn_cast< VarDecl >(ref->getDecl());
+                if (var != nullptr && m_tracked_vars.contains(var) &&
+                    !m_killed.contains(var)) {
+                    m_uses.vars.push_back(var);
+                }
+            }
+            for (const auto* child : stmt->children()) {
+                if (child != nullptr) {
+                    worklist.push_back(child);
+                }
+            }
+        }
+    }
+
+}; // class BlockUseCollector
+
+BlockUses collect_block_uses(const ProcCFG& cfg,
+                             ProcCFG::NodeRef block,
+                             const VarSet& tracked_vars) {
+    BlockUses uses;
+    BlockUseCollector collector(tracked_vars, uses);
+
+    // The branch conditions of the predecessors are filtered on the edges
+    // into the block, see `IntraProceduralFixpointIterator::transfer_edge`.
+    for (const auto* pred : block->preds()) {
+        if (pred == nullptr) {
+            continue;
+        }
+        if (const auto* cond = pred->getLastCondition()) {
+            collector.read_at_start(cond);
+        }
+    }
+
+    // The returned values are read from the predecessors of the exit to
+    // summarize the function.
+    if (block == &cfg.get_clang_cfg().getExit()) {
+        for (const auto* pred : block->preds()) {
+            if (pred == nullptr) {
+                continue;
+            }
+            for (const auto& elem : *pred) {
+                auto cfg_stmt = elem.getAs< CFGStmt >();
+                if (!cfg_stmt) {
+                    continue;
+                }
+                const auto* ret =
+                    llvm::dyn_cast< ReturnStmt >(cfg_stmt->getStmt());
+                if (ret != nullptr && ret->getRetValue() != nullptr) {
+                    collector.read_at_start(
+                        ret->getRetValue()->IgnoreParens());
+                }
+            }
+        }
+    }
+
+    for (const auto& elem : *block) {
+        if (auto cfg_stmt = elem.getAs< CFGStmt >()) {
+            collector.evaluate(cfg_stmt->getStmt());
+        }
+    }
+    return uses;
+}
+
+} // anonymous namespace
+
+Liveness::Liveness(const ProcCFG& cfg) {
+    const llvm::TimeTraceScope scope("Liveness");
+    const auto& clang_cfg = cfg.get_clang_cfg();
+    const auto num_blocks = clang_cfg.getNumBlockIDs();
+
+    VarSet tracked_vars;
+    if (const auto* body = cfg.get_proc()->getBody()) {
+        tracked_vars = collect_tracked_vars(body);
+    }
+    for (const auto* var : tracked_vars) {
+        m_var_index.try_emplace(var, m_var_index.size());
+    }
+
+    // Only the stmts read by some block are indexed, the other values are
+    // dead at every block exit.
+    std::vector< BlockUses > block_uses(num_blocks);
+    for (const auto* block : clang_cfg) {
+        auto& uses = block_uses[block->getBlockID()];
+        uses = collect_block_uses(cfg, block, tracked_vars);
+        for (const auto* stmt : uses.stmts) {
+            m_stmt_index.try_emplace(stmt, m_stmt_index.size());
+        }
+    }
+
+    const auto num_vars = m_var_index.size();
+    const auto num_stmts = m_stmt_index.size();
+    std::vector< llvm::BitVector > use_vars(num_blocks,
+                                            llvm::BitVector(num_vars));
+    std::vector< llvm::BitVector > kill_vars(num_blocks,
+                                             llvm::BitVector(num_vars));
+    std::vector< llvm::BitVector > use_stmts(num_blocks,
+                                             llvm::BitVector(num_stmts));
+    std::vector< llvm::BitVector > kill_stmts(num_blocks,
+                                              llvm::BitVector(num_stmts));
+    for (unsigned id = 0U; id < num_blocks; ++id) {
+        const auto& uses = block_uses[id];
+        for (const auto* var : uses.vars) {
+            use_vars[id].set(m_var_index.lookup(var));
+        }
+        for (const auto* var : uses.killed_vars) {
+            kill_vars[id].set(m_var_index.lookup(var));
+        }
+        for (const auto* stmt : uses.stmts) {
+            use_stmts[id].set(m_stmt_index.lookup(stmt));
+        }
+        for (const auto* stmt : uses.defined_stmts) {
+            auto it = m_stmt_index.find(stmt);
+            if (it != m_stmt_index.end()) {
+                kill_stmts[id].set(it->second);
+            }
+        }
+    }
+
+    // Backward may analysis to the least fixpoint.
+    m_live_vars.assign(num_blocks, llvm::BitVector(num_vars));
+    m_live_stmts.assign(num_blocks, llvm::BitVector(num_stmts));
+    std::vector< llvm::BitVector > live_in_vars = use_vars;
+    std::vector< llvm::BitVector > live_in_stmts = use_stmts;
+    llvm::SmallVector< ProcCFG::NodeRef, 32U > worklist;
+    llvm::BitVector in_worklist(num_blocks);
+    for (const auto* block : clang_cfg) {
+        worklist.push_back(block);
+        in_worklist.set(block->getBlockID());
+    }
+    while (!worklist.empty()) {
+        const auto* block = worklist.pop_back_val();
+        const auto id = block->getBlockID();
+        in_worklist.reset(id);
+
+        auto& out_vars = m_live_vars[id];
+        auto& out_stmts = m_live_stmts[id];
+        for (const auto* succ : block->succs()) {
+            if (succ != nullptr) {
+                out_vars |= live_in_vars[succ->getBlockID()];
+                out_stmts |= live_in_stmts[succ->getBlockID()];
+            }
+        }
+
+        auto in_vars = out_vars;
+        in_vars.reset(kill_vars[id]);
+        in_vars |= use_vars[id];
+        auto in_stmts = out_stmts;
+        in_stmts.reset(kill_stmts[id]);
+        in_stmts |= use_stmts[id];
+        if (in_vars == live_in_vars[id] && in_stmts == live_in_stmts[id]) {
+            continue;
+        }
+        live_in_vars[id] = std::move(in_vars);
+        live_in_stmts[id] = std::move(in_stmts);
+        for (const auto* pred : block->preds()) {
+            if (pred != nullptr && !in_worklist.test(pred->getBlockID())) {
+                worklist.push_back(pred);
+                in_worklist.set(pred->getBlockID());
+            }
+        }
+    }
+
+    knight_log(llvm::outs() << "liveness: " << num_vars << " tracked vars, "
+                            << num_stmts << " read stmts\n");
+}
+
+} // namespace knight::analyzer
@@ -14,8 +14,12 @@
 #include "analyzer/core/location_manager.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/stack_frame.hpp"
+#include "analyzer/tooling/context.hpp"
+#include "analyzer/tooling/stats.hpp"
 #include "common/support/dumpable.hpp"
 
+#include <mutex>
+
 namespace knight::analyzer {
 
 LocationContext::LocationContext(const LocationManager* manager,
@@ -31,19 +35,6 @@ const LocationManager* LocationContext::get_location_manager() const {
     return m_location_manager;
 }
 
-void LocationContext::profile(llvm::FoldingSetNodeID& id,
-                              const StackFrame* stack_frame,
-                              unsigned element_id,
-                              const clang::CFGBlock* block) {
-    id.AddPointer(stack_frame);
-    id.AddInteger(element_id);
-    id.AddPointer(block);
-}
-
-void LocationContext::Profile(llvm::FoldingSetNodeID& id) const {
-    profile(id, m_stack_frame, m_element_id, m_block);
-}
-
 void LocationContext::dump(llvm::raw_ostream& os) const {
     os << "LocationContext:\n";
     os << "  stack_frame: ";
@@ -61,6 +52,16 @@ void LocationContext::dump(llvm::raw_ostream& os) const {
     m_block->dump();
 }
 
+ProcCFG::GraphRef LocationManager::get_cfg(ProcCFG::DeclRef decl) {
+    auto& cfg = m_decl_to_cfg[decl];
+    if (cfg == nullptr) {
+        const std::lock_guard< std::mutex > lock(
+            KnightContext::get_ast_mutex());
+        cfg = ProcCFG::build(decl, m_cfg_elements);
+    }
+    return cfg.get();
+}
+
 const StackFrame* LocationManager::create_top_frame(ProcCFG::DeclRef decl) {
     llvm::FoldingSetNodeID id;
     StackFrame::profile(id, decl, nullptr, CallSiteInfo());
@@ -70,9 +71,10 @@ const StackFrame* LocationManager::create_top_frame(ProcCFG::DeclRef decl) {
     if (res == nullptr) {
         res = m_allocator.Allocate< StackFrame >();
         new (res) StackFrame(this, decl, nullptr, CallSiteInfo());
+        res->m_dense_id = m_frame_cnt++;
+        m_frames.push_back(res);
         m_stack_frames.InsertNode(res, insert_pos);
     }
-    ensure_cfg_created(decl);
 
     return res;
 }
@@ -93,9 +95,10 @@ const StackFrame* LocationManager::create_from_node(
     if (res == nullptr) {
         res = m_allocator.Allocate< StackFrame >();
         new (res) StackFrame(this, *called_decl_opt, parent, callsite_info);
+        res->m_dense_id = m_frame_cnt++;
+        m_frames.push_back(res);
         m_stack_frames.InsertNode(res, insert_pos);
     }
-    ensure_cfg_created(*called_decl_opt);
 
     return res;
 }
@@ -104,25 +107,49 @@ const LocationContext* LocationManager::create_location_context(
     const StackFrame* stack_frame,
     int element_id,
     const clang::CFGBlock* block) {
-    llvm::FoldingSetNodeID id;
-    LocationContext::profile(id, stack_frame, element_id, block);
-
-    void* insert_pos; // NOLINT
-    auto* res = m_location_contexts.FindNodeOrInsertPos(id, insert_pos);
+    // The encoded location is unique per frame, block and element, so it
+    // interns the contexts without profiling them.
+    auto& res = m_location_contexts[EncodedLocation::get(
+        stack_frame->get_dense_id(), block->getBlockID(), element_id)];
     if (res == nullptr) {
-        res = m_allocator.Allocate< LocationContext >();
-        new (res) LocationContext(this, stack_frame, element_id, block);
-        m_location_contexts.InsertNode(res, insert_pos);
+        auto* loc_ctx = m_allocator.Allocate< LocationContext >();
+        new (loc_ctx) LocationContext(this, stack_frame, element_id, block);
+        loc_ctx->m_dense_id = m_location_cnt++;
+        Stats::count(StatKind::LocationContextsCreated);
+        res = loc_ctx;
     }
 
     return res;
 }
 
-void LocationManager::ensure_cfg_created(ProcCFG::DeclRef decl) {
-    if (m_decl_to_cfg.contains(decl)) {
-        return;
+const LocationContext* LocationManager::get_location_context(
+    EncodedLocation loc) {
+    if (const auto* loc_ctx = m_location_contexts.lookup(loc)) {
+        return loc_ctx;
+    }
+    const auto* frame = get_stack_frame(loc);
+    const auto* block = ProcCFG::get_node(frame->get_cfg(),
+                                          loc.get_block_id());
+    return create_location_context(frame, loc.get_element_id(), block);
+}
+
+llvm::ArrayRef< const LocationContext* > LocationManager::
+    get_block_location_contexts(const StackFrame* stack_frame,
+                                const clang::CFGBlock* block) {
+    auto& loc_ctxs = m_block_location_contexts[{stack_frame, block}];
+    if (!loc_ctxs.empty()) {
+        return loc_ctxs;
+    }
+    const auto num_elements = static_cast< int >(block->size());
+    auto* array = m_allocator.Allocate< const LocationContext* >(
+        static_cast< std::size_t >(num_elements) + 1U);
+    for (int element_id = -1; element_id < num_elements; ++element_id) {
+        array[element_id + 1] =
+            create_location_context(stack_frame, element_id, block);
     }
-    m_decl_to_cfg[decl] = ProcCFG::build(decl);
+    loc_ctxs = llvm::ArrayRef< const LocationContext* >(
+        array, static_cast< std::size_t >(num_elements) + 1U);
+    return loc_ctxs;
 }
 
 } // namespace knight::analyzer
\ No newline at end of file
@@ -16,6 +16,8 @@
 
 #include "common/util/log.hpp"
 
+#include <llvm/Support/TimeProfiler.h>
+
 #include <memory>
 
 namespace knight::analyzer {
@@ -24,16 +26,25 @@ namespace {
 
 using namespace clang;
 
-auto get_default_cfg_build_options() {
+auto get_cfg_build_options(const CFGElementSet& elements) {
     CFG::BuildOptions cfg_opts;
-
-    cfg_opts.AddInitializers = true;
-    cfg_opts.AddImplicitDtors = true;
-    cfg_opts.AddTemporaryDtors = true;
-    cfg_opts.AddCXXDefaultInitExprInCtors = true;
-
-    // cfg_opts.PruneTriviallyFalseEdges = true;
-    cfg_opts.AddLifetime = true;
+    auto has = [&elements](CFGElementKind kind) {
+        return elements.test(static_cast< std::size_t >(kind));
+    };
+
+    cfg_opts.AddInitializers = has(CFGElementKind::Initializer);
+    cfg_opts.AddCXXDefaultInitExprInCtors = has(CFGElementKind::Initializer);
+    cfg_opts.AddScopes = has(CFGElementKind::Scope);
+    cfg_opts.AddLifetime = has(CFGElementKind::LifetimeEnds);
+    cfg_opts.AddImplicitDtors = has(CFGElementKind::ImplicitDtor);
+    cfg_opts.AddTemporaryDtors = has(CFGElementKind::TemporaryDtor);
+    cfg_opts.AddLoopExit = has(CFGElementKind::LoopExit);
+    cfg_opts.AddCXXNewAllocator = has(CFGElementKind::NewAllocator);
+    cfg_opts.AddRichCXXConstructors = has(CFGElementKind::Constructor);
+
+    // The blocks only reached by the constant false conditions, e.g. the
+    // exit of `while (true)`, are left out of the WTO.
+    cfg_opts.PruneTriviallyFalseEdges = true;
 
     cfg_opts.setAllAlwaysAdd();
 
@@ -118,25 +129,32 @@ ProcCFG::NodeRef ProcCFG::exit(GraphRef cfg) {
     return &(cfg->m_cfg->getExit());
 }
 
-ProcCFG::GraphUniqueRef ProcCFG::build(const clang::Decl* function) {
+ProcCFG::GraphUniqueRef ProcCFG::build(const clang::Decl* function,
+                                       const CFGElementSet& elements) {
     knight_assert_msg(function != nullptr, "function provided is null");
     auto* body = function->getBody();
     knight_assert_msg(body != nullptr, "function shall have body");
 
-    return build(function, body, function->getASTContext());
+    return build(function, body, function->getASTContext(), elements);
 }
 
 ProcCFG::GraphUniqueRef ProcCFG::build(FunctionRef function,
                                        clang::Stmt* build_scope,
-                                       clang::ASTContext& ctx) {
+                                       clang::ASTContext& ctx,
+                                       const CFGElementSet& elements) {
     knight_assert_msg(!function->isTemplated(),
                       "templated function not supported");
     knight_assert_msg(!ctx.getLangOpts().ObjC, "objective-c not supported");
 
+    const llvm::TimeTraceScope scope("ProcCFG::build", [function] {
+        const auto* named = llvm::dyn_cast< clang::NamedDecl >(function);
+        return named != nullptr ? named->getQualifiedNameAsString() : "";
+    });
+
     auto cfg = clang::CFG::buildCFG(function,
                                     build_scope,
                                     &ctx,
-                                    get_default_cfg_build_options());
+                                    get_cfg_build_options(elements));
     knight_assert_msg(cfg != nullptr, "failed to build CFG");
 
     auto stmt_block_mapping = construct_stmt_block_mapping(*cfg);
@@ -155,6 +173,18 @@ void ProcCFG::view() const {
     m_cfg->viewCFG(m_proc->getLangOpts());
 }
 
+std::size_t ProcCFG::get_memory_size() const {
+    // The blocks, with their elements and edges, are allocated in the
+    // arena of the clang cfg.
+    constexpr std::size_t StmtToBlockEntrySize =
+        sizeof(StmtToBlockMap::value_type) + sizeof(void*);
+    return sizeof(ProcCFG) + sizeof(clang::CFG) +
+           m_cfg->getAllocator().getTotalMemory() +
+           m_stmt_to_block.size() * StmtToBlockEntrySize +
+           m_reachable_block.getMemorySize() +
+           m_nodes.capacity() * sizeof(NodeRef);
+}
+
 ProcCFG::ProcCFG(FunctionRef proc,
                  ClangCFGRef cfg,
                  StmtToBlockMap stmt_to_block,
@@ -162,6 +192,11 @@ ProcCFG::ProcCFG(FunctionRef proc,
     : m_proc(proc),
       m_cfg(std::move(cfg)),
       m_stmt_to_block(std::move(stmt_to_block)),
-      m_reachable_block(std::move(reachable_block)) {}
+      m_reachable_block(std::move(reachable_block)),
+      m_nodes(m_cfg->getNumBlockIDs(), nullptr) {
+    for (const auto* block : *m_cfg) {
+        m_nodes[block->getBlockID()] = block;
+    }
+}
 
 } // namespace knight::analyzer
\ No newline at end of file
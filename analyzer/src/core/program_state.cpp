@@ -19,11 +19,13 @@
 #include "analyzer/core/domain/dom_base.hpp"
 #include "analyzer/core/domain/domains.hpp"
 #include "analyzer/core/domain/numerical/numerical_base.hpp"
+#include "analyzer/core/domain/registered_domains.hpp"
 #include "analyzer/core/location_context.hpp"
 #include "analyzer/core/region/region.hpp"
 #include "analyzer/core/stack_frame.hpp"
 #include "analyzer/core/symbol.hpp"
 #include "analyzer/core/symbol_manager.hpp"
+#include "analyzer/tooling/stats.hpp"
 #include "common/util/assert.hpp"
 #include "common/util/log.hpp"
 
@@ -40,18 +42,113 @@
 
 namespace knight::analyzer {
 
+namespace {
+
+/// \brief Get the union of two abstract values by the given operation.
+///
+/// The operation is expected to be idempotent and to have bottom as its
+/// identity, so one side is shared instead of being cloned when the result
+/// is known without applying the operation.
+template < typename Op >
+SharedVal union_val(const SharedVal& this_val,
+                    const SharedVal& other_val,
+                    Op op) {
+    if (this_val == other_val || other_val->is_bottom()) {
+        return this_val;
+    }
+    if (this_val->is_bottom()) {
+        return other_val;
+    }
+    SharedVal new_val = this_val->clone_shared();
+    visit_dom(*new_val, [&](auto& val) { op(val, *other_val); });
+    return new_val;
+}
+
+/// \brief Get the union of two abstract values by the given operation,
+/// which tells if the value changed, and set `is_changed` if so.
+///
+/// The value of this side is shared when unchanged, instead of its clone.
+template < typename Op >
+SharedVal union_val(const SharedVal& this_val,
+                    const SharedVal& other_val,
+                    Op op,
+                    bool& is_changed) {
+    if (this_val == other_val || other_val->is_bottom()) {
+        return this_val;
+    }
+    if (this_val->is_bottom()) {
+        is_changed = true;
+        return other_val;
+    }
+    SharedVal new_val = this_val->clone_shared();
+    if (!visit_dom(*new_val, [&](auto& val) { return op(val, *other_val); })) {
+        return this_val;
+    }
+    is_changed = true;
+    return new_val;
+}
+
+/// \brief Get the intersection of two abstract values by the given
+/// operation, which tells if the value may have changed, and set
+/// `is_changed` if so.
+template < typename Op >
+SharedVal intersect_val(const SharedVal& this_val,
+                        const SharedVal& other_val,
+                        Op op,
+                        bool& is_changed) {
+    if (this_val == other_val || this_val->is_bottom()) {
+        return this_val;
+    }
+    if (other_val->is_bottom()) {
+        is_changed = true;
+        return other_val;
+    }
+    SharedVal new_val = this_val->clone_shared();
+    if (!visit_dom(*new_val, [&](auto& val) { return op(val, *other_val); })) {
+        return this_val;
+    }
+    is_changed = true;
+    return new_val;
+}
+
+/// \brief Get the intersection of two abstract values by the given
+/// operation.
+///
+/// The operation is expected to be idempotent and to have bottom as its
+/// absorbing element, so one side is shared instead of being cloned when
+/// the result is known without applying the operation.
+template < typename Op >
+SharedVal intersect_val(const SharedVal& this_val,
+                        const SharedVal& other_val,
+                        Op op) {
+    if (this_val == other_val || this_val->is_bottom()) {
+        return this_val;
+    }
+    if (other_val->is_bottom()) {
+        return other_val;
+    }
+    SharedVal new_val = this_val->clone_shared();
+    visit_dom(*new_val, [&](auto& val) { op(val, *other_val); });
+    return new_val;
+}
+
+} // anonymous namespace
+
 void retain_state(const ProgramState* state) {
+    auto& shard = state->get_state_manager().get_shard(state->m_hash);
+    const std::lock_guard< OptionalMutex > lock(shard.mutex);
     ++const_cast< ProgramState* >(state)->m_ref_cnt;
 }
 
 void release_state(const ProgramState* state) {
+    auto& shard = state->get_state_manager().get_shard(state->m_hash);
+    const std::lock_guard< OptionalMutex > lock(shard.mutex);
     knight_assert(state->m_ref_cnt > 0);
     auto* s = const_cast< ProgramState* >(state);
     if (--s->m_ref_cnt == 0) {
-        auto& mgr = s->get_state_manager();
-        mgr.m_state_set.RemoveNode(s);
+        shard.states.RemoveNode(s);
         s->~ProgramState();
-        mgr.m_free_states.push_back(s);
+        shard.free_states.push_back(s);
     }
 }
 
@@ -64,26 +161,80 @@ ProgramState::ProgramState(ProgramStateManager* state_mgr,
     : m_state_mgr(state_mgr),
       m_region_mgr(region_mgr),
       m_ref_cnt(0),
+      m_hash(0U),
       m_zdom_kind(state_mgr->get_zdom_kind()),
       m_dom_val(std::move(dom_val)),
       m_region_defs(std::move(region_defs)),
       m_stmt_sexpr(std::move(stmt_sexpr)),
-      m_constraint_system(std::move(cst_system)) {}
+      m_constraint_system(std::move(cst_system)) {
+    m_constraint_system.freeze();
+}
 
 ProgramState::ProgramState(ProgramState&& other) noexcept
     : m_state_mgr(other.m_state_mgr),
       m_region_mgr(other.m_region_mgr),
       m_ref_cnt(0),
+      m_hash(0U),
       m_zdom_kind(other.m_state_mgr->get_zdom_kind()),
       m_dom_val(std::move(other.m_dom_val)),
       m_region_defs(std::move(other.m_region_defs)),
       m_stmt_sexpr(std::move(other.m_stmt_sexpr)),
-      m_constraint_system(std::move(other.m_constraint_system)) {}
+      m_constraint_system(std::move(other.m_constraint_system)) {
+    m_constraint_system.freeze();
+}
 
 ProgramStateManager& ProgramState::get_state_manager() const {
     return *m_state_mgr;
 }
 
+std::optional< const ZNumericalDomBase* > ProgramState::get_zdom_ref() const {
+    if (const auto* scratch = m_state_mgr->m_zdom_scratch;
+        scratch != nullptr && *scratch != nullptr) {
+        return scratch->get();
+    }
+    auto it = m_dom_val.find(get_zdom_id());
+    if (it == m_dom_val.end()) {
+        return std::nullopt;
+    }
+    return std::make_optional(
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-static-cast-downcast)
+        static_cast< const ZNumericalDomBase* >(it->second.get()));
+}
+
+SharedZNumericalVal ProgramState::get_zdom_clone() const {
+    auto* scratch = m_state_mgr->m_zdom_scratch;
+    if (scratch != nullptr && *scratch != nullptr) {
+        return *scratch;
+    }
+
+    SharedZNumericalVal zdom;
+    auto it = m_dom_val.find(get_zdom_id());
+    if (it == m_dom_val.end()) {
+        auto default_fn = get_domain_default_val_fn(get_zdom_id());
+        zdom = std::static_pointer_cast< ZNumericalDomBase >((*default_fn)());
+    } else {
+        zdom = std::static_pointer_cast< ZNumericalDomBase >(
+            it->second->clone_shared());
+    }
+    // The scratch value is cloned once per block.
+    if (scratch != nullptr) {
+        *scratch = zdom;
+    }
+    return zdom;
+}
+
+ProgramStateRef ProgramState::set_zdom(SharedZNumericalVal val) const {
+    if (auto* scratch = m_state_mgr->m_zdom_scratch) {
+        *scratch = std::move(val);
+        return this;
+    }
+    auto dom_val = m_dom_val;
+    dom_val[get_zdom_id()] = std::move(val);
+    return get_state_manager()
+        .get_persistent_state_with_copy_and_dom_val_map(*this,
+                                                        std::move(dom_val));
+}
+
 std::optional< RegionRef > ProgramState::get_region(
     ProcCFG::DeclRef decl, const StackFrame* frame) const {
     if (llvm::isa< clang::VarDecl >(decl)) {
@@ -138,33 +289,118 @@ std::optional< RegionRef > ProgramState::get_region(
 ProgramStateRef ProgramState::set_region_def(RegionRef region,
                                              const StackFrame* frame,
                                              const RegionDef* def) const {
-    auto region_defs = m_region_defs;
-    region_defs[{region, frame}] = def;
-    return get_state_manager()
-        .get_persistent_state_with_copy_and_region_defs_map(*this, region_defs);
+    auto& state_mgr = get_state_manager();
+    auto region_defs =
+        state_mgr.get_region_defs_factory().add(m_region_defs,
+                                                {region, frame},
+                                                def);
+    return state_mgr
+        .get_persistent_state_with_copy_and_region_defs_map(*this,
+                                                            std::move(
+                                                                region_defs));
 }
 
 ProgramStateRef ProgramState::set_stmt_sexpr(ProcCFG::StmtRef stmt,
                                              const StackFrame* frame,
                                              SExprRef sexpr) const {
-    auto stmt_sexpr = m_stmt_sexpr;
-    stmt_sexpr[{stmt, frame}] = sexpr;
-    return get_state_manager()
-        .get_persistent_state_with_copy_and_stmt_sexpr_map(*this, stmt_sexpr);
+    auto& state_mgr = get_state_manager();
+    if (auto* scratch = state_mgr.m_stmt_scratch) {
+        (*scratch)[{stmt, frame}] = sexpr;
+        return this;
+    }
+    auto stmt_sexpr = state_mgr.get_stmt_sexpr_factory().add(m_stmt_sexpr,
+                                                             {stmt, frame},
+                                                             sexpr);
+    return state_mgr
+        .get_persistent_state_with_copy_and_stmt_sexpr_map(*this,
+                                                           std::move(
+                                                               stmt_sexpr));
+}
+
+ProgramStateRef ProgramState::set_stmt_sexprs(
+    llvm::ArrayRef< StmtSExprEntry > entries) const {
+    if (entries.empty()) {
+        return this;
+    }
+    auto& state_mgr = get_state_manager();
+    auto& stmt_sexpr_factory = state_mgr.get_stmt_sexpr_factory();
+    StmtSExprMap stmt_sexpr = m_stmt_sexpr;
+    for (const auto& [stmt_frame_pair, sexpr] : entries) {
+        stmt_sexpr = stmt_sexpr_factory.add(stmt_sexpr, stmt_frame_pair, sexpr);
+    }
+    return state_mgr
+        .get_persistent_state_with_copy_and_stmt_sexpr_map(*this,
+                                                           std::move(
+                                                               stmt_sexpr));
 }
 
 ProgramStateRef ProgramState::set_constraint_system(
-    const ConstraintSystem& cst_system) const {
+    ConstraintSystem cst_system) const {
     return get_state_manager()
         .get_persistent_state_with_copy_and_constraint_system(*this,
-                                                              cst_system);
+                                                              std::move(
+                                                                  cst_system));
+}
+
+ProgramStateRef ProgramState::add_zlinear_constraints(
+    llvm::ArrayRef< ZLinearConstraint > constraints) const {
+    if (constraints.empty()) {
+        return this;
+    }
+    auto cst_system = m_constraint_system;
+    for (const auto& constraint : constraints) {
+        cst_system.add_zlinear_constraint(constraint);
+    }
+    return set_constraint_system(std::move(cst_system));
+}
+
+ProgramStateRef ProgramState::assume_zlinear_constraints(
+    llvm::ArrayRef< ZLinearConstraint > constraints) const {
+    if (constraints.empty()) {
+        return this;
+    }
+
+    if (m_state_mgr->m_zdom_scratch != nullptr) {
+        auto zdom = get_zdom_clone();
+        for (const auto& constraint : constraints) {
+            zdom->apply_linear_constraint(constraint);
+            if (zdom->is_bottom()) {
+                return get_state_manager().get_bottom_state();
+            }
+        }
+        return add_zlinear_constraints(constraints);
+    }
+
+    DomValMap dom_val = m_dom_val;
+    auto it = dom_val.find(get_zdom_id());
+    if (it != dom_val.end()) {
+        auto* zdom =
+            llvm::cast< ZNumericalDomBase >(get_unique_val(it->second));
+        for (const auto& constraint : constraints) {
+            zdom->apply_linear_constraint(constraint);
+            if (zdom->is_bottom()) {
+                return get_state_manager().get_bottom_state();
+            }
+        }
+    }
+
+    auto cst_system = m_constraint_system;
+    for (const auto& constraint : constraints) {
+        cst_system.add_zlinear_constraint(constraint);
+    }
+    return get_state_manager()
+        .get_persistent_state_with_copy_and_stateful_member_map(
+            *this,
+            std::move(dom_val),
+            m_region_defs,
+            m_stmt_sexpr,
+            std::move(cst_system));
 }
 
 std::optional< const RegionDef* > ProgramState::get_region_def(
     RegionRef region, const StackFrame* frame) const {
-    auto it = m_region_defs.find({region, frame});
-    if (it != m_region_defs.end()) {
-        return it->second;
+    if (const auto* def = m_region_defs.lookup({region, frame})) {
+        return *def;
     }
     if (region->get_memory_space()->is_stack_arg()) {
         return get_state_manager()
@@ -181,9 +417,14 @@ std::optional< SExprRef > ProgramState::get_stmt_sexpr(
         }
     }
 
-    auto it = m_stmt_sexpr.find({stmt, frame});
-    if (it != m_stmt_sexpr.end()) {
-        return it->second;
+    if (const auto* scratch = m_state_mgr->m_stmt_scratch) {
+        if (auto it = scratch->find({stmt, frame}); it != scratch->end()) {
+            return it->second;
+        }
+    }
+
+    if (const auto* sexpr = m_stmt_sexpr.lookup({stmt, frame})) {
+        return *sexpr;
     }
 
     return std::nullopt;
@@ -202,9 +443,14 @@ SExprRef ProgramState::get_stmt_sexpr_or_conjured(
         }
     }
 
-    auto it = m_stmt_sexpr.find({stmt, frame});
-    if (it != m_stmt_sexpr.end()) {
-        return it->second;
+    if (const auto* scratch = m_state_mgr->m_stmt_scratch) {
+        if (auto it = scratch->find({stmt, frame}); it != scratch->end()) {
+            return it->second;
+        }
+    }
+
+    if (const auto* sexpr = m_stmt_sexpr.lookup({stmt, frame})) {
+        return *sexpr;
     }
 
     if (region_opt) {
@@ -214,10 +460,76 @@ SExprRef ProgramState::get_stmt_sexpr_or_conjured(
     return m_state_mgr->m_symbol_mgr.get_symbol_conjured(stmt, type, frame);
 }
 
+ProgramStateRef ProgramState::remove_dead_values(
+    const StackFrame* frame,
+    const Liveness& liveness,
+    ProcCFG::NodeRef node) const {
+    auto& state_mgr = get_state_manager();
+    bool is_changed = false;
+
+    auto& stmt_sexpr_factory = state_mgr.get_stmt_sexpr_factory();
+    StmtSExprMap stmt_sexpr = m_stmt_sexpr;
+    for (const auto& [stmt_frame_pair, _] : m_stmt_sexpr) {
+        const auto& [stmt, stmt_frame] = stmt_frame_pair;
+        if (stmt_frame == frame && !liveness.is_live_out(node, stmt)) {
+            stmt_sexpr =
+                stmt_sexpr_factory.remove(stmt_sexpr, stmt_frame_pair);
+            is_changed = true;
+        }
+    }
+
+    auto& region_defs_factory = state_mgr.get_region_defs_factory();
+    RegionDefMap region_defs = m_region_defs;
+    llvm::SmallVector< ZVariable, 8U > dead_zvars;
+    for (const auto& [region_frame_pair, def] : m_region_defs) {
+        const auto& [region, region_frame] = region_frame_pair;
+        const auto* var_region = llvm::dyn_cast< VarRegion >(region);
+        if (region_frame != frame || var_region == nullptr ||
+            liveness.is_live_out(node, var_region->get_var_decl())) {
+            continue;
+        }
+        region_defs =
+            region_defs_factory.remove(region_defs, region_frame_pair);
+        if (region->get_value_type()->isIntegralOrEnumerationType()) {
+            dead_zvars.emplace_back(def);
+        }
+        is_changed = true;
+    }
+
+    if (!is_changed) {
+        return this;
+    }
+
+    DomValMap dom_val = m_dom_val;
+    if (auto it = dom_val.find(get_zdom_id());
+        it != dom_val.end() && !dead_zvars.empty()) {
+        auto* zdom =
+            llvm::cast< ZNumericalDomBase >(get_unique_val(it->second));
+        for (const auto& zvar : dead_zvars) {
+            zdom->forget(zvar);
+        }
+    }
+    return state_mgr.get_persistent_state_with_copy_and_stateful_member_map(
+        *this,
+        std::move(dom_val),
+        std::move(region_defs),
+        std::move(stmt_sexpr),
+        m_constraint_system);
+}
+
 ProgramStateRef ProgramState::normalize() const {
+    // Most states are already normalized, do not copy and intern them.
+    if (llvm::all_of(m_dom_val, [](const auto& pair) {
+            return pair.second->is_normalized();
+        })) {
+        return this;
+    }
+
     DomValMap dom_val = m_dom_val;
     for (auto& [id, val] : dom_val) {
-        const_cast< AbsDomBase* >(val.get())->normalize();
+        if (!val->is_normalized()) {
+            get_unique_val(val)->normalize();
+        }
     }
     return get_state_manager()
         .get_persistent_state_with_copy_and_dom_val_map(*this,
@@ -225,6 +537,10 @@ ProgramStateRef ProgramState::normalize() const {
 }
 
 bool ProgramState::is_bottom() const {
+    if (const auto* scratch = m_state_mgr->m_zdom_scratch;
+        scratch != nullptr && *scratch != nullptr && (*scratch)->is_bottom()) {
+        return true;
+    }
     return llvm::any_of(m_dom_val, [](const auto& pair) {
         return pair.second->is_bottom();
     });
@@ -243,111 +559,151 @@ ProgramStateRef ProgramState::set_to_top() const {
     return get_state_manager().get_default_state();
 }
 
+StmtSExprMap ProgramState::merge_stmt_sexprs(const ProgramState& other) const {
+    if (m_stmt_sexpr.getRootWithoutRetain() ==
+            other.m_stmt_sexpr.getRootWithoutRetain() ||
+        other.m_stmt_sexpr.isEmpty()) {
+        return m_stmt_sexpr;
+    }
+    if (m_stmt_sexpr.isEmpty()) {
+        return other.m_stmt_sexpr;
+    }
+
+    // Both maps are sorted by their keys, so the entries of this state are
+    // walked along the ones of the other state instead of being looked up.
+    auto& stmt_sexpr_factory = get_state_manager().get_stmt_sexpr_factory();
+    StmtSExprMap stmt_sexpr = m_stmt_sexpr;
+    auto this_it = m_stmt_sexpr.begin();
+    auto this_end = m_stmt_sexpr.end();
+    for (const auto& [key, sexpr] : other.m_stmt_sexpr) {
+        while (this_it != this_end && (*this_it).first < key) {
+            ++this_it;
+        }
+        if (this_it == this_end || key < (*this_it).first ||
+            (*this_it).second != sexpr) {
+            stmt_sexpr = stmt_sexpr_factory.add(stmt_sexpr, key, sexpr);
+        }
+    }
+    return stmt_sexpr;
+}
+
+RegionDefMap ProgramState::merge_region_defs(
+    const ProgramState& other,
+    const LocationContext* loc_ctx,
+    llvm::SmallVectorImpl< DivergingDef >& diverging_defs) const {
+    if (m_region_defs.getRootWithoutRetain() ==
+            other.m_region_defs.getRootWithoutRetain() ||
+        other.m_region_defs.isEmpty()) {
+        return m_region_defs;
+    }
+    if (m_region_defs.isEmpty()) {
+        return other.m_region_defs;
+    }
+
+    auto& region_defs_factory = get_state_manager().get_region_defs_factory();
+    RegionDefMap region_defs = m_region_defs;
+    auto this_it = m_region_defs.begin();
+    auto this_end = m_region_defs.end();
+    for (const auto& [region_frame_pair, def] : other.m_region_defs) {
+        while (this_it != this_end && (*this_it).first < region_frame_pair) {
+            ++this_it;
+        }
+        if (this_it == this_end || region_frame_pair < (*this_it).first) {
+            region_defs =
+                region_defs_factory.add(region_defs, region_frame_pair, def);
+            continue;
+        }
+
+        const auto* this_def = (*this_it).second;
+        if (this_def == def) {
+            continue;
+        }
+
+        const auto& [region, _] = region_frame_pair;
+        if (!region->get_value_type()->isIntegralOrEnumerationType()) {
+            knight_log(llvm::outs() << "unsupported region type: "
+                                    << region->get_value_type() << "\n");
+            knight_unreachable("unsupported region type");
+        }
+
+        const auto* new_def =
+            get_state_manager().m_symbol_mgr.get_region_def(region, loc_ctx);
+        diverging_defs.push_back({new_def, this_def, def});
+        region_defs =
+            region_defs_factory.add(region_defs, region_frame_pair, new_def);
+
+        knight_log(llvm::outs() << "merged region `" << *region
+                                << "` assigned new def: " << new_def << "\n");
+    }
+    return region_defs;
+}
+
+template < typename Op >
+bool ProgramState::rebind_diverging_defs(
+    DomValMap& dom_val,
+    llvm::ArrayRef< DivergingDef > diverging_defs,
+    Op op) const {
+    auto it = dom_val.find(get_zdom_id());
+    if (diverging_defs.empty() || it == dom_val.end()) {
+        return false;
+    }
+
+    // All the new defs are bound in one copy of the numerical domain per
+    // side, which are merged once.
+    auto* zdom = llvm::cast< ZNumericalDomBase >(get_unique_val(it->second));
+    Stats::count(zdom->kind, DomainOpKind::Clone);
+    std::unique_ptr< ZNumericalDomBase > zdom_cloned(
+        llvm::cast< ZNumericalDomBase >(zdom->clone()));
+    bool is_changed = false;
+    for (const auto& [new_def, this_def, other_def] : diverging_defs) {
+        // From the second iteration of a loop, the head already holds the
+        // new def, which is the same one at every iteration.
+        ZVariable new_def_var(new_def);
+        if (new_def != this_def) {
+            zdom->assign_var(new_def_var, ZVariable(this_def));
+            is_changed = true;
+        }
+        if (new_def != other_def) {
+            zdom_cloned->assign_var(new_def_var, ZVariable(other_def));
+        }
+    }
+    is_changed = op(*zdom, *zdom_cloned) || is_changed;
+    knight_log(llvm::outs() << "merged zdom: "; zdom->dump(llvm::outs());
+               llvm::outs() << "\n");
+    return is_changed;
+}
+
 // NOLINTNEXTLINE
 #define UNION_MAP(OP)                                                          \
     DomValMap new_map;                                                         \
     for (const auto& [other_id, other_val] : other->m_dom_val) {               \
         auto it = m_dom_val.find(other_id);                                    \
         if (it == m_dom_val.end()) {                                           \
-            new_map[other_id] = other_val->clone_shared();                     \
-        } else {                                                               \
-            auto* new_val = it->second->clone();                               \
-            new_val->OP(*other_val);                                           \
-            new_map[other_id] = SharedVal(new_val);                            \
-        }                                                                      \
-    }                                                                          \
-                                                                               \
-    StmtSExprMap stmt_sexpr;                                                   \
-    llvm::for_each(m_stmt_sexpr, [&](const auto& pair) {                       \
-        const auto& [stmt, sexpr] = pair;                                      \
-        auto it = other->m_stmt_sexpr.find(stmt);                              \
-        if (it == other->m_stmt_sexpr.end() || it->second == sexpr) {          \
-            stmt_sexpr[stmt] = sexpr;                                          \
-        }                                                                      \
-    });                                                                        \
-                                                                               \
-    llvm::for_each(other->m_stmt_sexpr, [&](const auto& pair) {                \
-        const auto& [stmt, sexpr] = pair;                                      \
-        if (!stmt_sexpr.contains(stmt)) {                                      \
-            stmt_sexpr[stmt] = sexpr;                                          \
-        }                                                                      \
-    });                                                                        \
-                                                                               \
-    RegionDefMap region_defs = m_region_defs;                                  \
-    std::map< const RegionDef*,                                                \
-              std::pair< const RegionDef*, const RegionDef* > >                \
-        new_zregion_def;                                                       \
-    for (const auto [region_frame_pair, def] : other->m_region_defs) {         \
-        auto it = region_defs.find(region_frame_pair);                         \
-        if (it == region_defs.end() || it->second == def) {                    \
-            region_defs[region_frame_pair] = def;                              \
+            new_map[other_id] = other_val;                                     \
+            is_changed = is_changed || !other_val->is_bottom();                \
         } else {                                                               \
-            const auto& [region, _] = region_frame_pair;                       \
-                                                                               \
-            knight_log_nl(llvm::outs() << "loc ctx#" << loc_ctx << "\n";       \
-                          loc_ctx->dump(llvm::outs()););                       \
-            knight_log_nl(llvm::outs() << "region#" << region << "\n";         \
-                          region->dump(llvm::outs()););                        \
-                                                                               \
-            const auto* new_def =                                              \
-                get_state_manager().m_symbol_mgr.get_region_def(region,        \
-                                                                loc_ctx);      \
-                                                                               \
-            if (region->get_value_type()->isIntegralOrEnumerationType()) {     \
-                new_zregion_def[new_def] = {it->second, def};                  \
-                knight_log(                                                    \
-                    llvm::outs() << "prepare new def: " << new_def << " with " \
-                                 << it->second << " and " << def << "\n";      \
-                    llvm::FoldingSetNodeID id;                                 \
-                    new_def->Profile(id);                                      \
-                    llvm::outs()                                               \
-                    << "new region def id: " << id.ComputeHash() << "\n";      \
-                    id.clear();                                                \
-                    it->second->Profile(id);                                   \
-                    llvm::outs()                                               \
-                    << "this region def id: " << id.ComputeHash() << "\n";     \
-                    id.clear();                                                \
-                    def->Profile(id);                                          \
-                    llvm::outs()                                               \
-                    << "other region def id: " << id.ComputeHash() << "\n";);  \
-            } else {                                                           \
-                knight_log(llvm::outs() << "unsupported region type: "         \
-                                        << region->get_value_type() << "\n");  \
-                knight_unreachable("unsupported region type");                 \
-            }                                                                  \
-            region_defs[region_frame_pair] = new_def;                          \
-                                                                               \
-            knight_log(llvm::outs()                                            \
-                       << #OP " region `" << *region                           \
-                       << "` assigned new def: " << new_def << "\n");          \
+            new_map[other_id] =                                                \
+                union_val(it->second,                                          \
+                          other_val,                                           \
+                          [](auto& val, const AbsDomBase& operand) {           \
+                              return val.OP##_changed(operand);                \
+                          },                                                   \
+                          is_changed);                                         \
         }                                                                      \
     }                                                                          \
                                                                                \
-    if (!new_zregion_def.empty()) {                                            \
-        auto* zdom =                                                           \
-            dynamic_cast< ZNumericalDomBase* >(new_map[get_zdom_id()].get());  \
-        auto* zdom_cloned = dynamic_cast< ZNumericalDomBase* >(                \
-            new_map[get_zdom_id()]->clone());                                  \
-        for (const auto& [new_def, pair] : new_zregion_def) {                  \
-            ZVariable new_def_var(new_def);                                    \
-            knight_log(llvm::outs()                                            \
-                       << #OP " for new def: " << new_def_var << "\n");        \
-            zdom->assign_var(new_def_var, ZVariable(pair.first));              \
-            zdom_cloned->assign_var(new_def_var, ZVariable(pair.second));      \
-        }                                                                      \
-        knight_log(llvm::outs() << "assigned new def zdom: ";                  \
-                   zdom->dump(llvm::outs());                                   \
-                   llvm::outs() << "\n");                                      \
-        knight_log(llvm::outs() << "assigned new def zdom_cloned: ";           \
-                   zdom_cloned->dump(llvm::outs());                            \
-                   llvm::outs() << "\n");                                      \
-                                                                               \
-        zdom->OP(*zdom_cloned);                                                \
-        delete zdom_cloned;                                                    \
-        knight_log(llvm::outs() << "joined zdom: ";                            \
-                   new_map[get_zdom_id()]->dump(llvm::outs());                 \
-                   llvm::outs() << "\n");                                      \
-    }                                                                          \
+    StmtSExprMap stmt_sexpr = merge_stmt_sexprs(*other);                       \
+    llvm::SmallVector< DivergingDef, 8U > diverging_defs;                      \
+    RegionDefMap region_defs =                                                 \
+        merge_region_defs(*other, loc_ctx, diverging_defs);                    \
+    is_changed =                                                               \
+        rebind_diverging_defs(new_map,                                         \
+                              diverging_defs,                                  \
+                              [](ZNumericalDomBase& zdom,                      \
+                                 const ZNumericalDomBase& other_zdom) {        \
+                                  return zdom.OP##_changed(other_zdom);        \
+                              }) ||                                            \
+        is_changed;                                                            \
                                                                                \
     ConstraintSystem cst_system = m_constraint_system;                         \
     cst_system.retain(other->m_constraint_system);                             \
@@ -363,258 +719,77 @@ ProgramStateRef ProgramState::set_to_top() const {
     return res;
 
 ProgramStateRef ProgramState::join(const ProgramStateRef& other,
-                                   const LocationContext* loc_ctx) const {
-    // UNION_MAP(join_with);
-    DomValMap new_map;
-    for (const auto& [other_id, other_val] : other->m_dom_val) {
-        auto it = m_dom_val.find(other_id);
-        if (it == m_dom_val.end()) {
-            new_map[other_id] = other_val->clone_shared();
-        } else {
-            auto* new_val = it->second->clone();
-            new_val->join_with(*other_val);
-            new_map[other_id] = SharedVal(new_val);
-        }
+                                   const LocationContext* loc_ctx,
+                                   bool& is_changed) const {
+    if (other == this || other->is_bottom()) {
+        return this;
     }
-
-    StmtSExprMap stmt_sexpr;
-    llvm::for_each(m_stmt_sexpr, [&](const auto& pair) {
-        const auto& [stmt, sexpr] = pair;
-        auto it = other->m_stmt_sexpr.find(stmt);
-        if (it == other->m_stmt_sexpr.end() || it->second == sexpr) {
-            stmt_sexpr[stmt] = sexpr;
-        }
-    });
-
-    llvm::for_each(other->m_stmt_sexpr, [&](const auto& pair) {
-        const auto& [stmt, sexpr] = pair;
-        if (!stmt_sexpr.contains(stmt)) {
-            stmt_sexpr[stmt] = sexpr;
-        }
-    });
-
-    RegionDefMap region_defs = m_region_defs;
-    std::map< const RegionDef*,
-              std::pair< const RegionDef*, const RegionDef* > >
-        new_zregion_def;
-    for (const auto [region_frame_pair, def] : other->m_region_defs) {
-        auto it = region_defs.find(region_frame_pair);
-        if (it == region_defs.end() || it->second == def) {
-            region_defs[region_frame_pair] = def;
-        } else {
-            const auto& [region, _] = region_frame_pair;
-
-            knight_log_nl(llvm::outs() << "loc ctx#" << loc_ctx << "\n";
-                          loc_ctx->dump(llvm::outs()););
-            knight_log_nl(llvm::outs() << "region#" << region << "\n";
-                          region->dump(llvm::outs()););
-
-            const auto* new_def =
-                get_state_manager().m_symbol_mgr.get_region_def(region,
-                                                                loc_ctx);
-
-            if (region->get_value_type()->isIntegralOrEnumerationType()) {
-                new_zregion_def[new_def] = {it->second, def};
-                knight_log(
-                    llvm::outs() << "prepare new def: " << new_def << " with "
-                                 << it->second << " and " << def << "\n";
-                    llvm::FoldingSetNodeID id;
-                    new_def->Profile(id);
-                    llvm::outs()
-                    << "new region def id: " << id.ComputeHash() << "\n";
-                    id.clear();
-                    it->second->Profile(id);
-                    llvm::outs()
-                    << "this region def id: " << id.ComputeHash() << "\n";
-                    id.clear();
-                    def->Profile(id);
-                    llvm::outs()
-                    << "other region def id: " << id.ComputeHash() << "\n";);
-            } else {
-                knight_log(llvm::outs() << "unsupported region type: "
-                                        << region->get_value_type() << "\n");
-                knight_unreachable("unsupported region type");
-            }
-            region_defs[region_frame_pair] = new_def;
-
-            knight_log(llvm::outs()
-                       << "merged region `" << *region
-                       << "` assigned new def: " << new_def << "\n");
-        }
+    if (is_bottom()) {
+        is_changed = true;
+        return other;
     }
 
-    // Join region definitions
-    if (!new_zregion_def.empty()) {
-        auto* zdom =
-            dynamic_cast< ZNumericalDomBase* >(new_map[get_zdom_id()].get());
-        auto* zdom_cloned =
-            dynamic_cast< ZNumericalDomBase* >(new_map[get_zdom_id()]->clone());
-        for (const auto& [new_def, pair] : new_zregion_def) {
-            ZVariable new_def_var(new_def);
-            knight_log(llvm::outs()
-                       << "join for new def: " << new_def_var << "\n");
-            zdom->assign_var(new_def_var, ZVariable(pair.first));
-            zdom_cloned->assign_var(new_def_var, ZVariable(pair.second));
-        }
-        knight_log(llvm::outs() << "assigned new def zdom: ";
-                   zdom->dump(llvm::outs());
-                   llvm::outs() << "\n");
-        knight_log(llvm::outs() << "assigned new def zdom_cloned: ";
-                   zdom_cloned->dump(llvm::outs());
-                   llvm::outs() << "\n");
-
-        zdom->join_with(*zdom_cloned);
-        delete zdom_cloned;
-        knight_log(llvm::outs() << "joined zdom: ";
-                   new_map[get_zdom_id()]->dump(llvm::outs());
-                   llvm::outs() << "\n");
-    }
-
-    ConstraintSystem cst_system = m_constraint_system;
-    // TODO(constraint-join): handle constraint join more precisely.
-    cst_system.retain(other->m_constraint_system);
-
-    auto res = get_state_manager()
-                   .get_persistent_state_with_copy_and_stateful_member_map(
-                       *this,
-                       std ::move(new_map),
-                       std ::move(region_defs),
-                       std ::move(stmt_sexpr),
-                       std ::move(cst_system));
-    knight_log(llvm::outs() << "joined state: " << *res << "\n");
-    return res;
+    UNION_MAP(join_with);
 }
 
 ProgramStateRef ProgramState::join_at_loop_head(
-    const ProgramStateRef& other, const LocationContext* loc_ctx) const {
+    const ProgramStateRef& other,
+    const LocationContext* loc_ctx,
+    bool& is_changed) const {
     UNION_MAP(join_with_at_loop_head);
 }
 
 ProgramStateRef ProgramState::join_consecutive_iter(
-    const ProgramStateRef& other, const LocationContext* loc_ctx) const {
+    const ProgramStateRef& other,
+    const LocationContext* loc_ctx,
+    bool& is_changed) const {
     UNION_MAP(join_consecutive_iter_with);
 }
 
 ProgramStateRef ProgramState::widen(const ProgramStateRef& other,
-                                    const LocationContext* loc_ctx) const {
+                                    const LocationContext* loc_ctx,
+                                    bool& is_changed) const {
     UNION_MAP(widen_with);
 }
 
 ProgramStateRef ProgramState::widen_with_threshold(
     const ProgramStateRef& other,
     const LocationContext* loc_ctx,
-    const ZNum& threshold) const {
+    llvm::ArrayRef< ZNum > thresholds) const {
     DomValMap new_map;
     for (const auto& [other_id, other_val] : other->m_dom_val) {
         auto it = m_dom_val.find(other_id);
         if (it == m_dom_val.end()) {
-            new_map[other_id] = other_val->clone_shared();
-        } else {
-            auto* new_val = it->second->clone();
-            if (auto* new_zval = llvm::dyn_cast< ZNumericalDomBase >(new_val)) {
-                new_zval
-                    ->widen_with_threshold(*(llvm::cast< ZNumericalDomBase >(
-                                               other_val.get())),
-                                           threshold);
-            } else {
-                new_val->widen_with(*other_val);
-            }
-            new_map[other_id] = SharedVal(new_val);
-        }
-    }
-
-    StmtSExprMap stmt_sexpr;
-    llvm::for_each(m_stmt_sexpr, [&](const auto& pair) {
-        const auto& [stmt, sexpr] = pair;
-        auto it = other->m_stmt_sexpr.find(stmt);
-        if (it == other->m_stmt_sexpr.end() || it->second == sexpr) {
-            stmt_sexpr[stmt] = sexpr;
-        }
-    });
-
-    llvm::for_each(other->m_stmt_sexpr, [&](const auto& pair) {
-        const auto& [stmt, sexpr] = pair;
-        if (!stmt_sexpr.contains(stmt)) {
-            stmt_sexpr[stmt] = sexpr;
-        }
-    });
-
-    RegionDefMap region_defs = m_region_defs;
-    std::map< const RegionDef*,
-              std::pair< const RegionDef*, const RegionDef* > >
-        new_zregion_def;
-    for (const auto [region_frame_pair, def] : other->m_region_defs) {
-        auto it = region_defs.find(region_frame_pair);
-        if (it == region_defs.end() || it->second == def) {
-            region_defs[region_frame_pair] = def;
+            new_map[other_id] = other_val;
         } else {
-            const auto& [region, _] = region_frame_pair;
-
-            knight_log_nl(llvm::outs() << "loc ctx#" << loc_ctx << "\n";
-                          loc_ctx->dump(llvm::outs()););
-            knight_log_nl(llvm::outs() << "region#" << region << "\n";
-                          region->dump(llvm::outs()););
-
-            const auto* new_def =
-                get_state_manager().m_symbol_mgr.get_region_def(region,
-                                                                loc_ctx);
-
-            if (region->get_value_type()->isIntegralOrEnumerationType()) {
-                new_zregion_def[new_def] = {it->second, def};
-                knight_log(
-                    llvm::outs() << "prepare new def: " << new_def << " with "
-                                 << it->second << " and " << def << "\n";
-                    llvm::FoldingSetNodeID id;
-                    new_def->Profile(id);
-                    llvm::outs()
-                    << "new region def id: " << id.ComputeHash() << "\n";
-                    id.clear();
-                    it->second->Profile(id);
-                    llvm::outs()
-                    << "this region def id: " << id.ComputeHash() << "\n";
-                    id.clear();
-                    def->Profile(id);
-                    llvm::outs()
-                    << "other region def id: " << id.ComputeHash() << "\n";);
-            } else {
-                knight_log(llvm::outs() << "unsupported region type: "
-                                        << region->get_value_type() << "\n");
-                knight_unreachable("unsupported region type");
-            }
-            region_defs[region_frame_pair] = new_def;
-
-            knight_log(llvm::outs()
-                       << "widen_with_threshold region `" << *region
-                       << "` assigned new def: " << new_def << "\n");
+            new_map[other_id] = union_val(
+                it->second,
+                other_val,
+                [thresholds](AbsDomBase& val, const AbsDomBase& operand) {
+                    auto* zval = llvm::dyn_cast< ZNumericalDomBase >(&val);
+                    if (zval == nullptr) {
+                        val.widen_with(operand);
+                        return;
+                    }
+                    zval->widen_with_threshold(llvm::cast< ZNumericalDomBase >(
+                                                   operand),
+                                               thresholds);
+                });
         }
     }
 
-    // Join region definitions
-    if (!new_zregion_def.empty()) {
-        auto* zdom =
-            dynamic_cast< ZNumericalDomBase* >(new_map[get_zdom_id()].get());
-        auto* zdom_cloned =
-            dynamic_cast< ZNumericalDomBase* >(new_map[get_zdom_id()]->clone());
-        for (const auto& [new_def, pair] : new_zregion_def) {
-            ZVariable new_def_var(new_def);
-            knight_log(llvm::outs()
-                       << "join for new def: " << new_def_var << "\n");
-            zdom->assign_var(new_def_var, ZVariable(pair.first));
-            zdom_cloned->assign_var(new_def_var, ZVariable(pair.second));
-        }
-        knight_log(llvm::outs() << "assigned new def zdom: ";
-                   zdom->dump(llvm::outs());
-                   llvm::outs() << "\n");
-        knight_log(llvm::outs() << "assigned new def zdom_cloned: ";
-                   zdom_cloned->dump(llvm::outs());
-                   llvm::outs() << "\n");
-
-        zdom->widen_with_threshold(*zdom_cloned, threshold);
-        delete zdom_cloned;
-        knight_log(llvm::outs() << "widen_with_threshold zdom: ";
-                   new_map[get_zdom_id()]->dump(llvm::outs());
-                   llvm::outs() << "\n");
-    }
+    StmtSExprMap stmt_sexpr = merge_stmt_sexprs(*other);
+    llvm::SmallVector< DivergingDef, 8U > diverging_defs;
+    RegionDefMap region_defs =
+        merge_region_defs(*other, loc_ctx, diverging_defs);
+    rebind_diverging_defs(new_map,
+                          diverging_defs,
+                          [thresholds](ZNumericalDomBase& zdom,
+                                       const ZNumericalDomBase& other_zdom) {
+                              zdom.widen_with_threshold(other_zdom,
+                                                        thresholds);
+                              return true;
+                          });
 
     ConstraintSystem cst_system = m_constraint_system;
     // TODO(constraint-join): handle constraint join more precisely.
@@ -632,64 +807,89 @@ ProgramStateRef ProgramState::widen_with_threshold(
 }
 
 ProgramStateRef ProgramState::meet(const ProgramStateRef& other) const {
+    if (other == this || is_bottom()) {
+        return this;
+    }
+    if (other->is_bottom()) {
+        return other;
+    }
+
     DomValMap map;
     for (const auto& [other_id, other_val] : other->m_dom_val) {
         auto it = m_dom_val.find(other_id);
         if (it != m_dom_val.end()) {
-            auto* new_val = it->second->clone();
-            new_val->meet_with(*other_val);
-            map[other_id] = SharedVal(new_val);
+            map[other_id] =
+                intersect_val(it->second,
+                              other_val,
+                              [](auto& val, const AbsDomBase& operand) {
+                                  val.meet_with(operand);
+                              });
         }
     }
     return get_state_manager()
         .get_persistent_state_with_copy_and_dom_val_map(*this, std ::move(map));
 }
 
-ProgramStateRef ProgramState::narrow(const ProgramStateRef& other) const {
+ProgramStateRef ProgramState::narrow(const ProgramStateRef& other,
+                                     bool& is_changed) const {
     DomValMap map;
     for (const auto& [other_id, other_val] : other->m_dom_val) {
         auto it = m_dom_val.find(other_id);
         if (it != m_dom_val.end()) {
-            auto* new_val = it->second->clone();
-            new_val->narrow_with(*other_val);
-            map[other_id] = SharedVal(new_val);
+            map[other_id] =
+                intersect_val(it->second,
+                              other_val,
+                              [](auto& val, const AbsDomBase& operand) {
+                                  return val.narrow_with_changed(operand);
+                              },
+                              is_changed);
         }
     }
+    // The values of the domains missing in the other state are dropped.
+    is_changed = is_changed || map.size() != m_dom_val.size();
     return get_state_manager()
         .get_persistent_state_with_copy_and_dom_val_map(*this, std ::move(map));
 }
 
 ProgramStateRef ProgramState::narrow_with_threshold(
-    const ProgramStateRef& other, const ZNum& threshold) const {
+    const ProgramStateRef& other, llvm::ArrayRef< ZNum > thresholds) const {
     DomValMap map;
     for (const auto& [other_id, other_val] : other->m_dom_val) {
         auto it = m_dom_val.find(other_id);
-        if (it != m_dom_val.end()) {
-            auto* new_val = it->second->clone();
-            if (auto* new_zval = llvm::dyn_cast< ZNumericalDomBase >(new_val)) {
-                knight_log_nl(llvm::outs() << "before narrow with threshold :"
-                                           << threshold << "\n"
-                                           << *new_val << "\n";);
-                new_zval
-                    ->narrow_with_threshold(*(llvm::cast< ZNumericalDomBase >(
-                                                other_val.get())),
-                                            threshold);
-
-                knight_log_nl(llvm::outs() << "after narrow with threshold :"
-                                           << threshold << "\n"
-                                           << *new_val << "\n";);
-            } else {
-                new_val->narrow_with(*other_val);
-            }
-
-            map[other_id] = SharedVal(new_val);
+        if (it == m_dom_val.end()) {
+            continue;
         }
+        map[other_id] = intersect_val(
+            it->second,
+            other_val,
+            [thresholds](AbsDomBase& val, const AbsDomBase& operand) {
+                auto* zval = llvm::dyn_cast< ZNumericalDomBase >(&val);
+                if (zval == nullptr) {
+                    val.narrow_with(operand);
+                    return;
+                }
+                knight_log_nl(llvm::outs() << "before narrow with "
+                                           << thresholds.size()
+                                           << " thresholds:\n"
+                                           << val << "\n";);
+                zval->narrow_with_threshold(llvm::cast< ZNumericalDomBase >(
+                                                operand),
+                                            thresholds);
+
+                knight_log_nl(llvm::outs() << "after narrow with "
+                                           << thresholds.size()
+                                           << " thresholds:\n"
+                                           << val << "\n";);
+            });
     }
     return get_state_manager()
         .get_persistent_state_with_copy_and_dom_val_map(*this, std ::move(map));
 }
 
 bool ProgramState::leq(const ProgramState& other) const {
+    if (this == &other) {
+        return true;
+    }
     knight_log_nl(llvm::outs() << "leq this state: " << *this << "\n"
                                << "leq other state: " << other << "\n");
 
@@ -701,7 +901,10 @@ bool ProgramState::leq(const ProgramState& other) const {
                                     << get_domain_name_by_id(id) << "\n");
             return !val->is_bottom();
         }
-        return !val->leq(*(it->second));
+        return val != it->second &&
+               !visit_dom(*val, [&](const auto& dom) {
+                   return dom.leq(*(it->second));
+               });
     });
 }
 
@@ -727,7 +930,9 @@ bool ProgramState::equals(const ProgramState& other) const {
             return false;
         }
 
-        if (!val->equals(*(it->second))) {
+        if (val != it->second && !visit_dom(*val, [&](const auto& dom) {
+                return dom.equals(*(it->second));
+            })) {
             return false;
         }
     }
@@ -742,6 +947,95 @@ bool ProgramState::equals(const ProgramState& other) const {
     return true;
 }
 
+unsigned ProgramState::get_similarity(const ProgramState& other) const {
+    unsigned similarity = 0U;
+    for (const auto& [id, val] : m_dom_val) {
+        auto it = other.m_dom_val.find(id);
+        if (it == other.m_dom_val.end()) {
+            continue;
+        }
+        if (val == it->second || visit_dom(*val, [&](const auto& dom) {
+                return dom.equals(*(it->second));
+            })) {
+            ++similarity;
+        }
+    }
+    if (m_region_defs.getRootWithoutRetain() ==
+        other.m_region_defs.getRootWithoutRetain()) {
+        ++similarity;
+    }
+    if (m_stmt_sexpr.getRootWithoutRetain() ==
+        other.m_stmt_sexpr.getRootWithoutRetain()) {
+        ++similarity;
+    }
+    return similarity;
+}
+
+StateChanges ProgramState::get_changes(const ProgramState& previous) const {
+    StateChanges changes;
+    for (const auto& [id, val] : m_dom_val) {
+        auto it = previous.m_dom_val.find(id);
+        if (it == previous.m_dom_val.end() ||
+            (val != it->second && !visit_dom(*val, [&](const auto& dom) {
+                return dom.equals(*(it->second));
+            }))) {
+            changes.domains.push_back(id);
+        }
+    }
+    llvm::sort(changes.domains);
+
+    const auto get_zdom =
+        [](const ProgramState& state) -> const ZNumericalDomBase* {
+        auto it = state.m_dom_val.find(state.get_zdom_id());
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-static-cast-downcast)
+        return it != state.m_dom_val.end()
+                   ? static_cast< const ZNumericalDomBase* >(it->second.get())
+                   : nullptr;
+    };
+    const auto get_value = [](const ZNumericalDomBase* zdom,
+                              const RegionDef* def) {
+        return zdom != nullptr ? zdom->to_interval(ZVariable(def))
+                               : ZInterval::top();
+    };
+    const auto* zdom = get_zdom(*this);
+    const auto* previous_zdom = get_zdom(previous);
+    for (const auto& [region_frame_pair, def] : m_region_defs) {
+        const auto* const* previous_def =
+            previous.m_region_defs.lookup(region_frame_pair);
+        auto value = get_value(zdom, def);
+        auto previous_value = previous_def != nullptr
+                                  ? get_value(previous_zdom, *previous_def)
+                                  : ZInterval::bottom();
+        if (previous_def == nullptr || !value.equals(previous_value) ||
+            (value.is_top() && *previous_def != def)) {
+            changes.regions.push_back({region_frame_pair.first,
+                                       region_frame_pair.second,
+                                       std::move(previous_value),
+                                       std::move(value)});
+        }
+    }
+    return changes;
+}
+
+std::vector< StateChanges::RegionChange > ProgramState::get_region_values()
+    const {
+    std::vector< StateChanges::RegionChange > values;
+    auto it = m_dom_val.find(get_zdom_id());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-static-cast-downcast)
+    const auto* zdom = it != m_dom_val.end()
+                           ? static_cast< const ZNumericalDomBase* >(
+                                 it->second.get())
+                           : nullptr;
+    for (const auto& [region_frame_pair, def] : m_region_defs) {
+        values.push_back({region_frame_pair.first,
+                          region_frame_pair.second,
+                          ZInterval::bottom(),
+                          zdom != nullptr ? zdom->to_interval(ZVariable(def))
+                                          : ZInterval::top()});
+    }
+    return values;
+}
+
 void ProgramState::dump(llvm::raw_ostream& os) const {
     os << "State:{\n";
 
@@ -753,7 +1047,7 @@ void ProgramState::dump(llvm::raw_ostream& os) const {
         os << " @" << frame << ": ";
         def->dump(os);
     }
-    if (!m_region_defs.empty()) {
+    if (!m_region_defs.isEmpty()) {
         os << "\n";
     }
     os << "},\n";
@@ -773,7 +1067,7 @@ void ProgramState::dump(llvm::raw_ostream& os) const {
         os << " @" << frame << ": ";
         sexpr->dump(os);
     }
-    if (!m_stmt_sexpr.empty()) {
+    if (!m_stmt_sexpr.isEmpty()) {
         os << "\n";
     }
     os << "},\n";
@@ -798,16 +1092,16 @@ ProgramStateRef ProgramStateManager::get_default_state() {
     for (auto analysis_id : m_analysis_mgr.get_required_analyses()) {
         for (auto dom_id :
              m_analysis_mgr.get_registered_domains_in(analysis_id)) {
-            if (auto default_fn = get_domain_default_val_fn(dom_id)) {
-                dom_val[dom_id] = std::move((*default_fn)());
+            if (auto val = get_domain_shared_default_val(dom_id)) {
+                dom_val[dom_id] = std::move(val);
             }
         }
     }
     ProgramState state(this,
                        &m_region_mgr,
                        std::move(dom_val),
-                       RegionDefMap{},
-                       StmtSExprMap{},
+                       m_region_defs_factory->getEmptyMap(),
+                       m_stmt_sexpr_factory->getEmptyMap(),
                        ConstraintSystem{});
 
     return get_persistent_state(state);
@@ -818,40 +1112,95 @@ ProgramStateRef ProgramStateManager::get_bottom_state() {
     for (auto analysis_id : m_analysis_mgr.get_required_analyses()) {
         for (auto dom_id :
              m_analysis_mgr.get_registered_domains_in(analysis_id)) {
-            if (auto bottom_fn = get_domain_bottom_val_fn(dom_id)) {
-                dom_val[dom_id] = std::move((*bottom_fn)());
+            if (auto val = get_domain_shared_bottom_val(dom_id)) {
+                dom_val[dom_id] = std::move(val);
             }
         }
     }
     ProgramState state(this,
                        &m_region_mgr,
                        std::move(dom_val),
-                       RegionDefMap{},
-                       StmtSExprMap{},
+                       m_region_defs_factory->getEmptyMap(),
+                       m_stmt_sexpr_factory->getEmptyMap(),
                        ConstraintSystem{});
 
     return get_persistent_state(state);
 }
 
+std::size_t ProgramStateManager::get_arena_size() const {
+    return get_state_arena_size() + m_symbol_mgr.get_arena_size() +
+           m_region_mgr.get_arena_size();
+}
+
+std::size_t ProgramStateManager::get_state_arena_size() const {
+    std::size_t size = m_alloc.getTotalMemory();
+    for (const auto& shard : m_shards) {
+        size += shard.alloc.getTotalMemory();
+    }
+    return size;
+}
+
+std::size_t ProgramStateManager::get_num_states() {
+    std::size_t num_states = 0U;
+    for (auto& shard : m_shards) {
+        const std::lock_guard< OptionalMutex > lock(shard.mutex);
+        num_states += shard.states.size();
+    }
+    return num_states;
+}
+
+void ProgramStateManager::reset() {
+    if (auto num_states = get_num_states(); num_states > 0U) {
+        knight_log(llvm::outs() << "skip resetting the state arena with "
+                                << num_states << " alive states\n");
+        return;
+    }
+
+    // The factories cache the tree nodes allocated in the arena.
+    m_region_defs_factory.reset();
+    m_stmt_sexpr_factory.reset();
+    for (auto& shard : m_shards) {
+        shard.free_states.clear();
+        shard.states.clear();
+        shard.alloc.Reset();
+    }
+    m_alloc.Reset();
+
+    m_region_defs_factory = std::make_unique< RegionDefMap::Factory >(m_alloc);
+    m_stmt_sexpr_factory = std::make_unique< StmtSExprMap::Factory >(m_alloc);
+}
+
 ProgramStateRef ProgramStateManager::get_persistent_state(ProgramState& state) {
     llvm::FoldingSetNodeID id;
     state.Profile(id);
+    const unsigned hash = id.ComputeHash();
     void* insert_pos; // NOLINT
 
+    // Only the shard of the hash is locked. The returned reference retains
+    // the state before being unlocked, so that the state cannot be released
+    // by other threads meanwhile.
+    auto& shard = get_shard(hash);
+    const std::lock_guard< OptionalMutex > lock(shard.mutex);
+
     if (ProgramState* existed =
-            m_state_set.FindNodeOrInsertPos(id, insert_pos)) {
+            shard.states.FindNodeOrInsertPos(id, insert_pos)) {
+        Stats::count(StatKind::StatesReused);
         return existed;
     }
+    Stats::count(StatKind::StatesInterned);
 
     ProgramState* new_state = nullptr;
-    if (!m_free_states.empty()) {
-        new_state = m_free_states.back();
-        m_free_states.pop_back();
+    if (!shard.free_states.empty()) {
+        new_state = shard.free_states.back();
+        shard.free_states.pop_back();
     } else {
-        new_state = m_alloc.Allocate< ProgramState >();
+        new_state = shard.alloc.Allocate< ProgramState >();
     }
     new (new_state) ProgramState(std::move(state));
-    m_state_set.InsertNode(new_state, insert_pos);
+    // The hash selects the shard on release, and is needed by the state
+    // set if it grows on insertion.
+    new_state->m_hash = hash;
+    shard.states.InsertNode(new_state, insert_pos);
     return new_state;
 }
 
@@ -938,4 +1287,87 @@ ProgramStateRef internal::get_persistent_state_with_copy_and_dom_val_map(
                                                                       dom_val));
 }
 
+ProgramStateBuilder::ProgramStateBuilder(ProgramStateRef base)
+    : m_base(std::move(base)),
+      m_region_defs(m_base->m_region_defs),
+      m_stmt_sexpr(m_base->m_stmt_sexpr) {}
+
+ProgramStateBuilder& ProgramStateBuilder::set_region_def(
+    RegionRef region, const StackFrame* frame, const RegionDef* def) {
+    m_region_defs = get_state_manager()
+                        .get_region_defs_factory()
+                        .add(m_region_defs, {region, frame}, def);
+    m_is_changed = true;
+    return *this;
+}
+
+ProgramStateBuilder& ProgramStateBuilder::set_stmt_sexpr(
+    ProcCFG::StmtRef stmt, const StackFrame* frame, SExprRef sexpr) {
+    auto& state_mgr = get_state_manager();
+    if (auto* scratch = state_mgr.m_stmt_scratch) {
+        (*scratch)[{stmt, frame}] = sexpr;
+        return *this;
+    }
+    m_stmt_sexpr = state_mgr.get_stmt_sexpr_factory().add(m_stmt_sexpr,
+                                                          {stmt, frame},
+                                                          sexpr);
+    m_is_changed = true;
+    return *this;
+}
+
+ProgramStateBuilder& ProgramStateBuilder::add_zlinear_constraints(
+    llvm::ArrayRef< ZLinearConstraint > constraints) {
+    if (constraints.empty()) {
+        return *this;
+    }
+    if (!m_constraint_system) {
+        m_constraint_system = m_base->m_constraint_system;
+    }
+    for (const auto& constraint : constraints) {
+        m_constraint_system->add_zlinear_constraint(constraint);
+    }
+    m_is_changed = true;
+    return *this;
+}
+
+ProgramStateBuilder& ProgramStateBuilder::set_zdom(SharedZNumericalVal val) {
+    if (auto* scratch = get_state_manager().m_zdom_scratch) {
+        *scratch = std::move(val);
+        return *this;
+    }
+    get_dom_val()[m_base->get_zdom_id()] = std::move(val);
+    return *this;
+}
+
+DomValMap& ProgramStateBuilder::get_dom_val() {
+    if (!m_dom_val) {
+        m_dom_val = m_base->m_dom_val;
+    }
+    m_is_changed = true;
+    return *m_dom_val;
+}
+
+ProgramStateRef ProgramStateBuilder::freeze() {
+    if (!m_is_changed) {
+        return m_base;
+    }
+    if (!m_dom_val) {
+        m_dom_val = m_base->m_dom_val;
+    }
+    if (!m_constraint_system) {
+        m_constraint_system = m_base->m_constraint_system;
+    }
+    m_base = get_state_manager()
+                 .get_persistent_state_with_copy_and_stateful_member_map(
+                     *m_base,
+                     std::move(*m_dom_val),
+                     m_region_defs,
+                     m_stmt_sexpr,
+                     std::move(*m_constraint_system));
+    m_dom_val.reset();
+    m_constraint_system.reset();
+    m_is_changed = false;
+    return m_base;
+}
+
 } // namespace knight::analyzer
\ No newline at end of file
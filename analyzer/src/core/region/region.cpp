@@ -13,13 +13,17 @@
 
 #include "analyzer/core/region/region.hpp"
 #include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/tooling/context.hpp"
 
 #include <clang/AST/Decl.h>
 #include <clang/AST/DeclCXX.h>
 #include <clang/AST/Expr.h>
+#include <clang/AST/RecordLayout.h>
 #include <clang/AST/Type.h>
 #include <llvm/Support/Casting.h>
 
+#include <mutex>
+
 namespace knight::analyzer {
 
 namespace {
@@ -67,16 +71,32 @@ clang::QualType TypedRegion::get_location_type() const {
 
 const StackLocalSpaceRegion* RegionManager::get_stack_local_space_region(
     const StackFrame* frame) {
+    const std::lock_guard< OptionalMutex > lock(m_mutex);
     const StackLocalSpaceRegion*& region = m_stack_local_space_regions[frame];
     return region = get_persistent_space(region, frame);
 }
 
 const StackArgSpaceRegion* RegionManager::get_stack_arg_space_region(
     const StackFrame* frame) {
+    const std::lock_guard< OptionalMutex > lock(m_mutex);
     const StackArgSpaceRegion*& region = m_stack_arg_space_regions[frame];
     return region = get_persistent_space(region, frame);
 }
 
+void RegionManager::reset() {
+    m_region_set.clear();
+    m_code_space_region = nullptr;
+    m_global_internal_space_region = nullptr;
+    m_global_external_space_region = nullptr;
+    m_heap_space_region = nullptr;
+    m_unknown_space_region = nullptr;
+    m_stack_local_space_regions.clear();
+    m_stack_arg_space_regions.clear();
+    m_var_regions.clear();
+    m_region_cnt = 0U;
+    m_allocator.Reset();
+}
+
 const CodeSpaceRegion* RegionManager::get_code_space() {
     return get_persistent_space(m_code_space_region);
 }
@@ -160,6 +180,46 @@ const FieldRegion* RegionManager::get_field_region(
     return get_persistent_region< FieldRegion >(field_decl, space, parent);
 }
 
+llvm::ArrayRef< FieldLayout > RegionManager::get_record_layout(
+    const clang::RecordDecl* record) {
+    const std::lock_guard< OptionalMutex > lock(m_mutex);
+    auto [it, inserted] = m_record_layouts.try_emplace(record);
+    if (!inserted) {
+        return it->second;
+    }
+
+    const auto* def = record->getDefinition();
+    if (def == nullptr || def->isInvalidDecl()) {
+        return it->second;
+    }
+    // The layouts are memoized in the AST context.
+    const std::lock_guard< std::mutex > ast_lock(
+        KnightContext::get_ast_mutex());
+    const auto& layout = get_ast_ctx().getASTRecordLayout(def);
+    for (const auto* field : def->fields()) {
+        it->second.push_back({field,
+                              layout.getFieldOffset(field->getFieldIndex()),
+                              field->getType()});
+    }
+    return it->second;
+}
+
+llvm::SmallVector< const FieldRegion*, 4U > RegionManager::get_field_regions(
+    RegionRef record_region) {
+    llvm::SmallVector< const FieldRegion*, 4U > regions;
+    const auto* record = record_region->get_value_type()->getAsRecordDecl();
+    if (record == nullptr) {
+        return regions;
+    }
+    for (const auto& field_layout : get_record_layout(record)) {
+        regions.push_back(
+            get_field_region(field_layout.field,
+                             record_region->get_memory_space(),
+                             record_region));
+    }
+    return regions;
+}
+
 const ArgumentRegion* RegionManager::get_argument_region(
     const StackFrame* frame,
     const clang::ParmVarDecl* param_decl,
@@ -184,8 +244,18 @@ const CXXThisRegion* RegionManager::get_cxx_this_region(
 
 RegionRef RegionManager::get_region(const clang::VarDecl* var_decl,
                                     const StackFrame* frame) {
-    // TODO(var-region): impl
     knight_assert(var_decl != nullptr);
+    const std::lock_guard< OptionalMutex > lock(m_mutex);
+    auto [it, inserted] = m_var_regions.try_emplace({var_decl, frame});
+    if (inserted) {
+        it->second = resolve_region(var_decl, frame);
+    }
+    return it->second;
+}
+
+RegionRef RegionManager::resolve_region(const clang::VarDecl* var_decl,
+                                        const StackFrame* frame) {
+    // TODO(var-region): impl
     var_decl = var_decl->getCanonicalDecl();
     if (var_decl == nullptr) {
         return nullptr;
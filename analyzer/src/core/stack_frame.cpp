@@ -24,6 +24,13 @@ std::optional< ProcCFG::DeclRef > get_called_decl(
     const ProcCFG::StmtRef& call) {
     if (const auto* call_expr = dyn_cast< const clang::CallExpr >(call)) {
         if (const auto* callee = call_expr->getCalleeDecl()) {
+            // The frame of a callee is analyzed from its body.
+            if (const auto* function =
+                    llvm::dyn_cast< clang::FunctionDecl >(callee)) {
+                if (const auto* definition = function->getDefinition()) {
+                    return definition;
+                }
+            }
             return callee;
         }
     }
@@ -72,6 +79,10 @@ ProcCFG::GraphRef StackFrame::get_cfg() const {
     return m_manager->get_cfg(m_decl);
 }
 
+const Wto< ProcCFG >& StackFrame::get_wto() const {
+    return m_manager->get_wto(m_decl);
+}
+
 const LocationContext* StackFrame::get_entry_location() const {
     ProcCFG::NodeRef entry = ProcCFG::entry(get_cfg());
     knight_assert_msg(entry, "entry cannot be null");
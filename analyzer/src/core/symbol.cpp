@@ -200,28 +200,36 @@ std::optional< ZLinearExpr > SymExpr::get_as_zexpr() const {
     }
 
     if (const auto* binary = dyn_cast< BinarySymExpr >(this)) {
-        auto lhs = binary->get_lhs()->get_as_zexpr();
-        auto rhs = binary->get_rhs()->get_as_zexpr();
-        if (!lhs || !rhs) {
-            return std::nullopt;
-        }
-        switch (binary->get_opcode()) {
-            using enum clang::BinaryOperatorKind;
-            case clang::BO_Add:
-                return lhs.value() + rhs.value();
-            case clang::BO_Sub:
-                return lhs.value() - rhs.value();
-            case clang::BO_Mul:
-                if (lhs->is_constant()) {
-                    return lhs.value().get_constant_term() * rhs.value();
-                } else if (rhs->is_constant()) {
-                    return lhs.value() * rhs.value().get_constant_term();
-                } else {
-                    return std::nullopt;
-                }
-            default:
-                break;
-        }
+        return BinarySymExpr::fold_zexpr(binary->get_opcode(),
+                                         binary->get_lhs()->get_as_zexpr(),
+                                         binary->get_rhs()->get_as_zexpr());
+    }
+    return std::nullopt;
+}
+
+std::optional< ZLinearExpr > BinarySymExpr::fold_zexpr(
+    clang::BinaryOperator::Opcode opcode,
+    const std::optional< ZLinearExpr >& lhs,
+    const std::optional< ZLinearExpr >& rhs) {
+    if (!lhs || !rhs) {
+        return std::nullopt;
+    }
+    switch (opcode) {
+        using enum clang::BinaryOperatorKind;
+        case clang::BO_Add:
+            return lhs.value() + rhs.value();
+        case clang::BO_Sub:
+            return lhs.value() - rhs.value();
+        case clang::BO_Mul:
+            if (lhs->is_constant()) {
+                return lhs.value().get_constant_term() * rhs.value();
+            } else if (rhs->is_constant()) {
+                return lhs.value() * rhs.value().get_constant_term();
+            } else {
+                return std::nullopt;
+            }
+        default:
+            break;
     }
     return std::nullopt;
 }
@@ -275,6 +283,16 @@ std::optional< ZLinearConstraint > SymExpr::get_as_zconstraint() const {
 }
 
 std::optional< ZNum > SymExpr::get_as_znum() const {
+    // Leaves are answered without building their linear expression.
+    if (const auto* scalar_int = dyn_cast< ScalarInt >(this)) {
+        if (get_type()->isIntegralOrEnumerationType()) {
+            return scalar_int->get_value();
+        }
+        return std::nullopt;
+    }
+    if (!isa< BinarySymExpr >(this)) {
+        return std::nullopt;
+    }
     if (auto zexpr_opt = get_as_zexpr()) {
         if (zexpr_opt->is_constant()) {
             return zexpr_opt.value().get_constant_term();
@@ -285,6 +303,15 @@ std::optional< ZNum > SymExpr::get_as_znum() const {
 }
 
 std::optional< ZVariable > SymExpr::get_as_zvariable() const {
+    if (const auto* sym = dyn_cast< Sym >(this)) {
+        if (get_type()->isIntegralOrEnumerationType()) {
+            return ZVariable(sym);
+        }
+        return std::nullopt;
+    }
+    if (!isa< BinarySymExpr >(this)) {
+        return std::nullopt;
+    }
     if (auto zexpr_opt = get_as_zexpr()) {
         return zexpr_opt->get_as_single_variable();
     }
@@ -0,0 +1,435 @@
+//===- cache.cpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the persistent per-function analysis result cache.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/cache.hpp"
+#include "analyzer/tooling/context.hpp"
+#include "cg/core/andersen.hpp"
+#include "common/util/log.hpp"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Type.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Tooling/DiagnosticsYaml.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Support/YAMLTraits.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include <mutex>
+#include <stdexcept>
+#include <variant>
+
+#define DEBUG_TYPE "analysis-cache"
+
+namespace knight {
+
+namespace {
+
+std::string serialize_bound(const analyzer::ZBound& bound) {
+    if (bound.is_finite()) {
+        return bound.get_num().str();
+    }
+    return bound.is_pinf() ? "+oo" : "-oo";
+}
+
+std::optional< analyzer::ZBound > deserialize_bound(const std::string& text) {
+    if (text == "+oo") {
+        return analyzer::ZBound::pinf();
+    }
+    if (text == "-oo") {
+        return analyzer::ZBound::ninf();
+    }
+    if (auto num = analyzer::ZNum::from_string(text)) {
+        return analyzer::ZBound(*num);
+    }
+    return std::nullopt;
+}
+
+} // anonymous namespace
+
+AnalysisCache::AnalysisCache(const std::string& knight_dir,
+                             int busy_time_mills) noexcept(false)
+    : m_db(sqlite::Database(knight_dir + "/analysis_cache.db",
+                            sqlite::OpenMode::READWRITE |
+                                sqlite::OpenMode::CREATE,
+                            busy_time_mills)) {
+    create_table_if_not_exist();
+}
+
+std::unique_ptr< AnalysisCache > AnalysisCache::open(
+    const std::string& knight_dir) {
+    try {
+        return std::make_unique< AnalysisCache >(knight_dir);
+    } catch (const std::runtime_error& err) {
+        llvm::WithColor::error() << "Failed to open the analysis cache in `"
+                                 << knight_dir << "`: " << err.what() << "\n";
+    }
+    return nullptr;
+}
+
+void AnalysisCache::create_table_if_not_exist() const noexcept {
+    if (!m_db.table_exists("function_result")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE IF NOT EXISTS function_result (key TEXT PRIMARY "
+            "KEY, diags TEXT)");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create "
+                          "table 'function_result'");
+    }
+    if (!m_db.table_exists("function_summary")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE IF NOT EXISTS function_summary (key TEXT PRIMARY "
+            "KEY, return_lb TEXT, return_ub TEXT)");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create "
+                          "table 'function_summary'");
+    }
+}
+
+std::string AnalysisCache::get_key(const clang::FunctionDecl* function,
+                                   const KnightOptions& opts) {
+    const auto& src_mgr = function->getASTContext().getSourceManager();
+    auto [begin_fid, begin_offset] =
+        src_mgr.getDecomposedExpansionLoc(function->getBeginLoc());
+    auto end_offset =
+        src_mgr.getDecomposedExpansionLoc(function->getEndLoc()).second;
+
+    unsigned odr_hash = 0U;
+    {
+        // The ODR hash is computed lazily and memoized in the declaration.
+        const std::lock_guard< std::mutex > lock(
+            KnightContext::get_ast_mutex());
+        odr_hash =
+            const_cast< clang::FunctionDecl* >(function) // NOLINT
+                ->getODRHash();
+    }
+
+    std::string key;
+    llvm::raw_string_ostream os(key);
+    if (auto file_entry = src_mgr.getFileEntryRefForID(begin_fid)) {
+        os << file_entry->getName();
+    }
+    os << ":" << begin_offset << "-" << end_offset << ":"
+       << function->getQualifiedNameAsString() << ":" << odr_hash << "|"
+       << get_options_key(opts);
+    return os.str();
+}
+
+std::string AnalysisCache::get_options_key(const KnightOptions& opts) {
+    std::string key;
+    llvm::raw_string_ostream os(key);
+    os << opts.checkers << "|" << opts.analyses << "|"
+       << static_cast< unsigned >(opts.zdom);
+
+    const auto& analyzer_opts = opts.analyzer_opts;
+    os << "|" << analyzer_opts.widening_delay << ","
+       << analyzer_opts.max_widening_iterations << ","
+       << analyzer_opts.max_narrowing_iterations << ","
+       << analyzer_opts.analyze_with_threshold << ","
+       << analyzer_opts.max_function_millis << ","
+       << analyzer_opts.max_function_transfers << ","
+       << analyzer_opts.max_call_depth << ","
+       << analyzer_opts.sparse_fixpoint << ","
+       << analyzer_opts.prune_dead_values << ","
+       << analyzer_opts.max_memory_mb << ","
+       << analyzer_opts.max_disjuncts << ","
+       << analyzer_opts.alias_classes << ","
+       << analyzer_opts.accelerate_loops << ",";
+    // The results depend on the content of the points-to facts.
+    if (opts.points_to != nullptr) {
+        os << llvm::utohexstr(opts.points_to->get_hash());
+    } else {
+        os << "-";
+    }
+
+    for (const auto& [name, value] : opts.check_opts) {
+        os << "|" << name << "=";
+        std::visit([&os](const auto& val) { os << val; }, value);
+    }
+    return os.str();
+}
+
+std::string AnalysisCache::serialize_diags(
+    const std::vector< KnightDiagnostic >& diags) {
+    clang::tooling::TranslationUnitDiagnostics tu_diags;
+    tu_diags.Diagnostics.assign(diags.begin(), diags.end());
+
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    llvm::yaml::Output yaml_out(os);
+    yaml_out << tu_diags;
+    return os.str();
+}
+
+std::optional< std::vector< KnightDiagnostic > >
+AnalysisCache::deserialize_diags(llvm::StringRef text) {
+    clang::tooling::TranslationUnitDiagnostics tu_diags;
+    llvm::yaml::Input yaml_in(text);
+    yaml_in >> tu_diags;
+    if (yaml_in.error()) {
+        return std::nullopt;
+    }
+
+    std::vector< KnightDiagnostic > diags;
+    diags.reserve(tu_diags.Diagnostics.size());
+    for (const auto& diag : tu_diags.Diagnostics) {
+        KnightDiagnostic& knight_diag =
+            diags.emplace_back(diag.DiagnosticName,
+                               diag.DiagLevel,
+                               diag.BuildDirectory);
+        static_cast< clang::tooling::Diagnostic& >(knight_diag) = diag;
+    }
+    return diags;
+}
+
+std::optional< std::vector< KnightDiagnostic > > AnalysisCache::lookup(
+    const std::string& key) const {
+    sqlite::PreparedStmt stmt(m_db,
+                              "SELECT diags FROM function_result WHERE key = "
+                              "?");
+    stmt.bind(1, key);
+    if (!stmt.execute_step()) {
+        return std::nullopt;
+    }
+    return deserialize_diags(stmt.get_column(0).get_as_string());
+}
+
+void AnalysisCache::store(const std::string& key,
+                          const std::vector< KnightDiagnostic >& diags) {
+    sqlite::PreparedStmt stmt(m_db,
+                              "INSERT OR REPLACE INTO function_result (key, "
+                              "diags) VALUES (?,?)");
+    stmt.bind(1, key);
+    stmt.bind(2, serialize_diags(diags));
+    const auto ret = stmt.execute();
+    knight_assert_msg(ret == 1, "Failed to insert function_result");
+}
+
+std::optional< analyzer::FunctionSummary > AnalysisCache::lookup_summary(
+    const std::string& key) const {
+    sqlite::PreparedStmt stmt(m_db,
+                              "SELECT return_lb, return_ub FROM "
+                              "function_summary WHERE key = ?");
+    stmt.bind(1, key);
+    if (!stmt.execute_step()) {
+        return std::nullopt;
+    }
+    auto lb = deserialize_bound(stmt.get_column(0).get_as_string());
+    auto ub = deserialize_bound(stmt.get_column(1).get_as_string());
+    if (!lb || !ub) {
+        return std::nullopt;
+    }
+    return analyzer::FunctionSummary{analyzer::ZInterval(*lb, *ub)};
+}
+
+void AnalysisCache::store_summary(const std::string& key,
+                                  const analyzer::FunctionSummary& summary) {
+    sqlite::PreparedStmt stmt(m_db,
+                              "INSERT OR REPLACE INTO function_summary (key, "
+                              "return_lb, return_ub) VALUES (?,?,?)");
+    stmt.bind(1, key);
+    stmt.bind(2, serialize_bound(summary.return_values.get_lb()));
+    stmt.bind(3, serialize_bound(summary.return_values.get_ub()));
+    const auto ret = stmt.execute();
+    knight_assert_msg(ret == 1, "Failed to insert function_summary");
+}
+
+RunCheckpoint::RunCheckpoint(const std::string& knight_dir,
+                             int busy_time_mills) noexcept(false)
+    : m_db(sqlite::Database(knight_dir + "/checkpoint.db",
+                            sqlite::OpenMode::READWRITE |
+                                sqlite::OpenMode::CREATE,
+                            busy_time_mills)) {
+    if (m_db.exec_and_get_first("PRAGMA user_version").get_as_int() <
+        CheckpointSchemaVersion) {
+        auto ret = m_db.try_execute(
+            "DROP TABLE IF EXISTS completed_unit; PRAGMA user_version = " +
+            std::to_string(CheckpointSchemaVersion));
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to drop the outdated checkpoint");
+    }
+    if (!m_db.table_exists("completed_unit")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE IF NOT EXISTS completed_unit (file TEXT PRIMARY "
+            "KEY, key TEXT, dependencies TEXT, diags TEXT)");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create "
+                          "table 'completed_unit'");
+    }
+}
+
+std::unique_ptr< RunCheckpoint > RunCheckpoint::open(
+    const std::string& knight_dir) {
+    try {
+        return std::make_unique< RunCheckpoint >(knight_dir);
+    } catch (const std::runtime_error& err) {
+        llvm::WithColor::error() << "Failed to open the checkpoint in `"
+                                 << knight_dir << "`: " << err.what() << "\n";
+    }
+    return nullptr;
+}
+
+std::optional< std::string > RunCheckpoint::get_stamp(
+    const std::string& file) {
+    llvm::sys::fs::file_status status;
+    if (llvm::sys::fs::status(file, status)) {
+        return std::nullopt;
+    }
+    return std::to_string(
+               status.getLastModificationTime().time_since_epoch().count()) +
+           ":" + std::to_string(status.getSize());
+}
+
+std::optional< std::string > RunCheckpoint::get_key(
+    const std::string& file,
+    const std::string& command,
+    const KnightOptions& opts) {
+    auto stamp = get_stamp(file);
+    if (!stamp) {
+        return std::nullopt;
+    }
+    return *stamp + "|" + llvm::utohexstr(llvm::xxHash64(command)) + "|" +
+           AnalysisCache::get_options_key(opts);
+}
+
+void RunCheckpoint::clear() {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    auto ret = m_db.try_execute("DELETE FROM completed_unit");
+    knight_assert_msg(ret == sqlite::SqliteOK,
+                      "Failed to clear completed_unit");
+}
+
+std::optional< std::vector< KnightDiagnostic > > RunCheckpoint::lookup(
+    const std::string& file,
+    const std::string& command,
+    const KnightOptions& opts) {
+    auto key = get_key(file, command, opts);
+    if (!key) {
+        return std::nullopt;
+    }
+
+    std::string dependencies;
+    std::string diags;
+    {
+        const std::lock_guard< std::mutex > lock(m_mutex);
+        sqlite::PreparedStmt stmt(m_db,
+                                  "SELECT key, dependencies, diags FROM "
+                                  "completed_unit WHERE file = ?");
+        stmt.bind(1, file);
+        if (!stmt.execute_step() ||
+            stmt.get_column(0).get_as_string() != *key) {
+            return std::nullopt;
+        }
+        dependencies = stmt.get_column(1).get_as_string();
+        diags = stmt.get_column(2).get_as_string();
+    }
+
+    // Each line is the stamp of an include then its path.
+    llvm::SmallVector< llvm::StringRef > lines;
+    llvm::StringRef(dependencies).split(lines, '\n', -1, false);
+    for (auto line : lines) {
+        auto [stamp, path] = line.split(' ');
+        auto current_stamp = get_stamp(path.str());
+        if (!current_stamp || *current_stamp != stamp) {
+            return std::nullopt;
+        }
+    }
+    return AnalysisCache::deserialize_diags(diags);
+}
+
+void RunCheckpoint::complete(const std::string& file,
+                             const std::string& command,
+                             const std::vector< std::string >& dependencies,
+                             const KnightOptions& opts,
+                             const std::vector< KnightDiagnostic >& diags) {
+    auto key = get_key(file, command, opts);
+    std::string stamps;
+    for (const auto& dependency : dependencies) {
+        auto stamp = get_stamp(dependency);
+        if (!stamp) {
+            key = std::nullopt;
+            break;
+        }
+        stamps += *stamp + " " + dependency + "\n";
+    }
+
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    if (!key) {
+        // The TU cannot be checked on resume, so it runs again.
+        sqlite::PreparedStmt stmt(m_db,
+                                  "DELETE FROM completed_unit WHERE file = ?");
+        stmt.bind(1, file);
+        (void)stmt.execute();
+        return;
+    }
+    sqlite::PreparedStmt stmt(m_db,
+                              "INSERT OR REPLACE INTO completed_unit (file, "
+                              "key, dependencies, diags) VALUES (?,?,?,?)");
+    stmt.bind(1, file);
+    stmt.bind(2, *key);
+    stmt.bind(3, stamps);
+    stmt.bind(4, AnalysisCache::serialize_diags(diags));
+    const auto ret = stmt.execute();
+    knight_assert_msg(ret == 1, "Failed to insert completed_unit");
+}
+
+AnalyzedDefinitions& AnalyzedDefinitions::get() {
+    static AnalyzedDefinitions definitions;
+    return definitions;
+}
+
+bool AnalyzedDefinitions::is_shared(const clang::FunctionDecl* function) {
+    const auto& src_mgr = function->getASTContext().getSourceManager();
+    return !src_mgr.isInMainFile(
+        src_mgr.getExpansionLoc(function->getLocation()));
+}
+
+std::string AnalyzedDefinitions::get_key(const clang::FunctionDecl* function,
+                                         const KnightOptions& opts) {
+    auto key = AnalysisCache::get_key(function, opts);
+    if (const auto* args = function->getTemplateSpecializationArgs()) {
+        const std::lock_guard< std::mutex > lock(
+            KnightContext::get_ast_mutex());
+        llvm::raw_string_ostream os(key);
+        clang::printTemplateArgumentList(os,
+                                         args->asArray(),
+                                         function->getASTContext()
+                                             .getPrintingPolicy());
+    }
+    return key;
+}
+
+DefinitionClaim AnalyzedDefinitions::try_claim(
+    const std::string& key, std::vector< KnightDiagnostic >& diags) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    auto [it, is_new] = m_diags.try_emplace(key);
+    if (is_new) {
+        return DefinitionClaim::Claimed;
+    }
+    if (!it->second) {
+        return DefinitionClaim::Pending;
+    }
+    diags = *it->second;
+    return DefinitionClaim::Published;
+}
+
+void AnalyzedDefinitions::publish(const std::string& key,
+                                  std::vector< KnightDiagnostic > diags) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    m_diags[key] = std::move(diags);
+}
+
+} // namespace knight
@@ -31,6 +31,11 @@ KnightContext::KnightContext(
 
 KnightContext::~KnightContext() = default;
 
+std::mutex& KnightContext::get_ast_mutex() {
+    static std::mutex ast_mutex;
+    return ast_mutex;
+}
+
 void KnightContext::set_diagnostic_engine(
     clang::DiagnosticsEngine* external_diag_engine) {
     this->m_diag_engine = external_diag_engine;
@@ -42,11 +47,13 @@ KnightOptions KnightContext::get_options_for(llvm::StringRef file) const {
 
 void KnightContext::set_current_file(llvm::StringRef file) {
     m_current_file = file.str();
-    m_current_options = get_options_for(file);
-    m_current_check_matcher =
-        std::make_unique< Globs >(m_current_options.checkers);
-    m_current_analysis_matcher =
-        std::make_unique< Globs >(m_current_options.analyses);
+    m_current_dependencies.reset();
+    auto& resolved =
+        m_resolved_options[m_opts_provider->get_config_key(m_current_file)];
+    if (resolved == nullptr) {
+        resolved = std::make_unique< ResolvedOptions >(get_options_for(file));
+    }
+    m_current_options = resolved.get();
 }
 
 clang::DiagnosticBuilder KnightContext::diagnose(
@@ -72,16 +79,20 @@ void KnightContext::set_current_ast_context(clang::ASTContext* ast_ctx) {
 }
 
 bool KnightContext::is_check_enabled(llvm::StringRef checker) const {
-    knight_assert_msg(m_current_check_matcher != nullptr,
-                      "checker matcher is null");
-    return m_current_check_matcher->matches(checker);
+    return m_current_options->check_matcher.matches(checker);
 }
 
 bool KnightContext::is_analysis_directly_enabled(
     llvm::StringRef analysis) const {
-    knight_assert_msg(m_current_analysis_matcher != nullptr,
-                      "analysis matcher is null");
-    return m_current_analysis_matcher->matches(analysis);
+    return m_current_options->analysis_matcher.matches(analysis);
+}
+
+bool KnightContext::is_function_included(llvm::StringRef function) const {
+    return m_current_options->function_matcher.matches(function);
+}
+
+bool KnightContext::is_path_excluded(llvm::StringRef file) const {
+    return m_current_options->excluded_path_matcher.matches(file);
 }
 
 bool KnightContext::is_core_analysis_enabled(llvm::StringRef analysis) const {
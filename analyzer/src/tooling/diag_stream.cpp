@@ -0,0 +1,130 @@
+//===- diag_stream.cpp ------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the streaming writer of the knight diagnostics.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/diag_stream.hpp"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/WithColor.h>
+
+namespace knight {
+
+namespace {
+
+constexpr unsigned DiagLineMaxLen = 512U;
+
+llvm::StringRef get_level_name(KnightDiagnostic::Level level) {
+    switch (level) {
+        case KnightDiagnostic::Error:
+            return "error";
+        case KnightDiagnostic::Remark:
+            return "remark";
+        default:
+            return "warning";
+    }
+}
+
+llvm::json::Object to_json(const clang::tooling::DiagnosticMessage& msg) {
+    return llvm::json::Object{{"file", msg.FilePath},
+                              {"offset", msg.FileOffset},
+                              {"message", msg.Message}};
+}
+
+} // anonymous namespace
+
+std::unique_ptr< DiagnosticStreamWriter > DiagnosticStreamWriter::open(
+    const std::string& file) {
+    std::error_code ec;
+    auto os = std::make_unique< llvm::raw_fd_ostream >(file, ec);
+    if (ec) {
+        llvm::WithColor::error() << "Failed to open the diagnostic stream `"
+                                 << file << "`: " << ec.message() << "\n";
+        return nullptr;
+    }
+    return std::make_unique< DiagnosticStreamWriter >(std::move(os));
+}
+
+void DiagnosticStreamWriter::write(
+    const std::vector< KnightDiagnostic >& diags) {
+    if (diags.empty()) {
+        return;
+    }
+
+    // Serialize without the lock, so that the workers only contend on the
+    // write itself.
+    auto lines = to_json_lines(diags);
+
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    *m_os << lines;
+    m_os->flush();
+}
+
+bool DiagnosticStreamWriter::merge(const std::vector< std::string >& files) {
+    // The diagnostics of the headers analyzed by several shards are the
+    // same lines.
+    llvm::StringSet<> seen;
+    std::string lines;
+    bool is_read = true;
+    for (const auto& file : files) {
+        auto buffer = llvm::MemoryBuffer::getFile(file, /*IsText=*/true);
+        if (!buffer) {
+            llvm::WithColor::error()
+                << "Failed to read the diagnostic stream `" << file
+                << "`: " << buffer.getError().message() << "\n";
+            is_read = false;
+            continue;
+        }
+        llvm::SmallVector< llvm::StringRef, 0U > file_lines;
+        (*buffer)->getBuffer().split(file_lines, '\n', -1, false);
+        for (auto line : file_lines) {
+            line = line.rtrim('\r');
+            if (!line.empty() && seen.insert(line).second) {
+                lines += line;
+                lines += '\n';
+            }
+        }
+    }
+
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    *m_os << lines;
+    m_os->flush();
+    return is_read;
+}
+
+std::string DiagnosticStreamWriter::to_json_lines(
+    const std::vector< KnightDiagnostic >& diags) {
+    std::string lines;
+    for (const auto& diag : diags) {
+        llvm::json::Object line = to_json(diag.Message);
+        line["check"] = diag.DiagnosticName;
+        line["level"] = get_level_name(diag.DiagLevel);
+        line["build_dir"] = diag.BuildDirectory;
+        llvm::json::Array notes;
+        for (const auto& note : diag.Notes) {
+            notes.push_back(to_json(note));
+        }
+        line["notes"] = std::move(notes);
+
+        llvm::SmallString< DiagLineMaxLen > text;
+        llvm::raw_svector_ostream os(text);
+        os << llvm::json::Value(std::move(line));
+        lines += text;
+        lines += '\n';
+    }
+    return lines;
+}
+
+} // namespace knight
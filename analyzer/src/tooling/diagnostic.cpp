@@ -19,9 +19,14 @@
 #include <clang/Basic/Diagnostic.h>
 #include <clang/Lex/Lexer.h>
 #include <clang/Tooling/Core/Diagnostic.h>
+#include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/STLExtras.h>
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
 
 namespace knight {
 
@@ -29,19 +34,27 @@ namespace {
 
 constexpr unsigned DiagMsgMaxLen = 256U;
 
+/// \brief Minimal number of diagnostics of a pair of runs to be merged on
+/// its own thread.
+constexpr std::size_t ParallelMergeThreshold = 4096U;
+
 struct Less {
     bool operator()(const KnightDiagnostic& lhs,
                     const KnightDiagnostic& rhs) const {
         const auto& l = lhs.Message;
         const auto& r = rhs.Message;
 
+        // The level breaks the ties of the duplicates, so that the kept
+        // one does not depend on the order of the runs.
         return std::tie(l.FilePath,
                         l.FileOffset,
                         lhs.DiagnosticName,
-                        l.Message) < std::tie(r.FilePath,
-                                              r.FileOffset,
-                                              rhs.DiagnosticName,
-                                              r.Message);
+                        l.Message,
+                        lhs.DiagLevel) < std::tie(r.FilePath,
+                                                  r.FileOffset,
+                                                  rhs.DiagnosticName,
+                                                  r.Message,
+                                                  rhs.DiagLevel);
     }
 };
 struct Equal {
@@ -52,6 +65,25 @@ struct Equal {
     }
 };
 
+void merge_two_runs(std::vector< KnightDiagnostic >& lhs,
+                    std::vector< KnightDiagnostic >& rhs) {
+    if (rhs.empty()) {
+        return;
+    }
+    std::vector< KnightDiagnostic > merged;
+    merged.reserve(lhs.size() + rhs.size());
+    std::merge(std::make_move_iterator(lhs.begin()),
+               std::make_move_iterator(lhs.end()),
+               std::make_move_iterator(rhs.begin()),
+               std::make_move_iterator(rhs.end()),
+               std::back_inserter(merged),
+               Less());
+    merged.erase(std::unique(merged.begin(), merged.end(), Equal()),
+                 merged.end());
+    lhs = std::move(merged);
+    rhs.clear();
+}
+
 } // end anonymous namespace
 
 KnightDiagnostic::KnightDiagnostic(llvm::StringRef checker,
@@ -66,6 +98,9 @@ void KnightDiagnosticConsumer::HandleDiagnostic(
     clang::DiagnosticsEngine::Level diag_level,
     const clang::Diagnostic& diagnostic) {
     using namespace clang;
+    // Rendering queries the caches of the source manager, which may be
+    // shared by the function workers of a translation unit.
+    const std::lock_guard< std::mutex > lock(KnightContext::get_ast_mutex());
     DiagnosticConsumer::HandleDiagnostic(diag_level, diagnostic);
     if (diag_level == DiagnosticsEngine::Note) {
         knight_assert_msg(!m_diags.empty(),
@@ -111,7 +146,9 @@ void KnightDiagnosticConsumer::HandleDiagnostic(
 
         m_diags.emplace_back(*check, level, m_context.get_cuurent_build_dir());
     }
-    KnightDiagnosticRenderer renderer(m_context.get_lang_options(),
+    KnightDiagnosticRenderer renderer(m_lang_opts != nullptr
+                                          ? *m_lang_opts
+                                          : m_context.get_lang_options(),
                                       &m_context.get_diagnostic_engine()
                                            ->getDiagnosticOptions(),
                                       m_diags.back());
@@ -133,10 +170,101 @@ void KnightDiagnosticConsumer::HandleDiagnostic(
                             diagnostic.getFixItHints());
 }
 
+void KnightDiagnosticConsumer::BeginSourceFile(
+    const clang::LangOptions& lang_opts, const clang::Preprocessor* pp) {
+    m_lang_opts = &lang_opts;
+    DiagnosticConsumer::BeginSourceFile(lang_opts, pp);
+}
+
+void KnightDiagnosticConsumer::EndSourceFile() {
+    m_lang_opts = nullptr;
+    // The file is analyzed, so no function is capturing its diagnostics.
+    drop_reported_diags();
+    DiagnosticConsumer::EndSourceFile();
+}
+
+void KnightDiagnosticConsumer::drop_reported_diags() {
+    if (m_reported == nullptr) {
+        return;
+    }
+    auto first = m_diags.begin() + static_cast< std::ptrdiff_t >(m_num_checked);
+    m_diags.erase(std::remove_if(first,
+                                 m_diags.end(),
+                                 [this](const KnightDiagnostic& diag) {
+                                     return !m_reported->insert(diag);
+                                 }),
+                  m_diags.end());
+    m_num_checked = m_diags.size();
+}
+
+std::size_t ReportedDiagnostics::KeyHash::operator()(const Key& key) const {
+    return llvm::hash_combine(key.check_hash,
+                              key.file_hash,
+                              key.message_hash,
+                              key.offset,
+                              key.level);
+}
+
+bool ReportedDiagnostics::insert(const KnightDiagnostic& diag) {
+    const auto& msg = diag.Message;
+    const Key key{llvm::hash_value(llvm::StringRef(diag.DiagnosticName)),
+                  llvm::hash_value(llvm::StringRef(msg.FilePath)),
+                  llvm::hash_value(llvm::StringRef(msg.Message)),
+                  msg.FileOffset,
+                  static_cast< unsigned >(diag.DiagLevel)};
+    auto& shard = m_shards[KeyHash()(key) & (ReportedDiagShardNum - 1U)];
+    const std::lock_guard< std::mutex > lock(shard.mutex);
+    return shard.keys.insert(key).second;
+}
+
+void ReportedDiagnostics::clear() {
+    for (auto& shard : m_shards) {
+        const std::lock_guard< std::mutex > lock(shard.mutex);
+        shard.keys.clear();
+    }
+}
+
+void sort_and_unique_diags(std::vector< KnightDiagnostic >& diags) {
+    std::stable_sort(diags.begin(), diags.end(), Less());
+    auto last = std::unique(diags.begin(), diags.end(), Equal());
+    diags.erase(last, diags.end());
+}
+
+std::vector< KnightDiagnostic > merge_sorted_diags(
+    std::vector< std::vector< KnightDiagnostic > > runs) {
+    if (runs.empty()) {
+        return {};
+    }
+    for (std::size_t step = 1U; step < runs.size(); step *= 2U) {
+        std::vector< std::thread > mergers;
+        for (std::size_t idx = 0U; idx + step < runs.size();
+             idx += 2U * step) {
+            auto& lhs = runs[idx];
+            auto& rhs = runs[idx + step];
+            if (lhs.size() + rhs.size() >= ParallelMergeThreshold) {
+                mergers.emplace_back(merge_two_runs,
+                                     std::ref(lhs),
+                                     std::ref(rhs));
+            } else {
+                merge_two_runs(lhs, rhs);
+            }
+        }
+        for (auto& merger : mergers) {
+            merger.join();
+        }
+    }
+    return std::move(runs.front());
+}
+
+void KnightDiagnosticConsumer::add_diags(
+    std::vector< KnightDiagnostic > diags) {
+    std::move(diags.begin(), diags.end(), std::back_inserter(m_diags));
+}
+
 std::vector< KnightDiagnostic > KnightDiagnosticConsumer::take_diags() {
-    std::stable_sort(m_diags.begin(), m_diags.end(), Less());
-    auto last = std::unique(m_diags.begin(), m_diags.end(), Equal());
-    m_diags.erase(last, m_diags.end());
+    drop_reported_diags();
+    m_num_checked = 0U;
+    sort_and_unique_diags(m_diags);
     return std::move(m_diags);
 }
 
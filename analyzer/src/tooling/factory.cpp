@@ -16,12 +16,23 @@
 #include "analyzer/core/analysis_manager.hpp"
 #include "analyzer/core/checker_manager.hpp"
 #include "analyzer/tooling/context.hpp"
+#include "analyzer/tooling/module.hpp"
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SmallVector.h>
 
 namespace knight {
 
-KnightFactory::KnightFactory(analyzer::AnalysisManager& analysis_mgr,
-                             analyzer::CheckerManager& checker_mgr)
-    : m_analysis_mgr(analysis_mgr), m_checker_mgr(checker_mgr) {}
+const KnightFactory& KnightFactory::get_module_factory() {
+    static const KnightFactory factory = [] {
+        KnightFactory module_factory;
+        for (auto entry : KnightModuleRegistry::entries()) {
+            entry.instantiate()->add_to_factory(module_factory);
+        }
+        return module_factory;
+    }();
+    return factory;
+}
 
 void KnightFactory::add_analysis_create_fn(analyzer::AnalysisID id,
                                            llvm::StringRef name,
@@ -35,15 +46,47 @@ void KnightFactory::add_checker_create_fn(analyzer::AnalysisID id,
     m_checker_registry[{id, name}] = std::move(registry);
 }
 
+void KnightFactory::add_checker_dependencies(
+    analyzer::CheckerManager& mgr) const {
+    for (const auto& [id, add_dependencies] : m_checker_dependency_fns) {
+        if (mgr.is_checker_required(id)) {
+            add_dependencies(mgr);
+        }
+    }
+}
+
+void KnightFactory::add_analysis_dependencies(
+    analyzer::AnalysisManager& mgr) const {
+    llvm::SmallVector< analyzer::AnalysisID > worklist;
+    for (const auto& [analysis, registry] : m_analysis_registry) {
+        if (mgr.is_analysis_required(analysis.first)) {
+            worklist.push_back(analysis.first);
+        }
+    }
+    llvm::DenseSet< analyzer::AnalysisID > visited;
+    while (!worklist.empty()) {
+        auto id = worklist.pop_back_val();
+        if (!visited.insert(id).second) {
+            continue;
+        }
+        auto it = m_analysis_dependency_fns.find(id);
+        if (it != m_analysis_dependency_fns.end()) {
+            it->second(mgr);
+        }
+        for (auto dep_id : mgr.get_analysis_dependencies(id)) {
+            worklist.push_back(dep_id);
+        }
+    }
+}
+
 KnightFactory::AnalysisRefs KnightFactory::create_analyses(
     analyzer::AnalysisManager& mgr, KnightContext* context) const {
     AnalysisRefs analyses;
-    const auto& lo = context->get_lang_options();
     for (const auto& [analysis, registry] : m_analysis_registry) {
-        if (m_analysis_mgr.is_analysis_required(analysis.first)) {
+        if (mgr.is_analysis_required(analysis.first)) {
             auto analysis = registry(mgr, *context);
             analyses.push_back(analysis.get());
-            m_analysis_mgr.enable_analysis(std::move(analysis));
+            mgr.enable_analysis(std::move(analysis));
         }
     }
     return analyses;
@@ -52,12 +95,11 @@ KnightFactory::AnalysisRefs KnightFactory::create_analyses(
 KnightFactory::CheckerRefs KnightFactory::create_checkers(
     analyzer::CheckerManager& mgr, KnightContext* context) const {
     CheckerRefs checkers;
-    const auto& lo = context->get_lang_options();
     for (const auto& [checker, registry] : m_checker_registry) {
-        if (m_checker_mgr.is_checker_required(checker.first)) {
+        if (mgr.is_checker_required(checker.first)) {
             auto checker = registry(mgr, *context);
             checkers.push_back(checker.get());
-            m_checker_mgr.enable_checker(std::move(checker));
+            mgr.enable_checker(std::move(checker));
         }
     }
     return checkers;
@@ -0,0 +1,308 @@
+//===- invariant_store.cpp --------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the store of the converged per-block invariants
+//  and its lazy reader.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/invariant_store.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+namespace knight {
+
+namespace {
+
+constexpr llvm::StringLiteral InvariantStoreMagic = "KINV";
+constexpr uint32_t InvariantStoreVersion = 1U;
+constexpr uint64_t HeaderSize = 12U;
+constexpr uint64_t FunctionEntrySize = 24U;
+constexpr uint64_t BlockEntrySize = 20U;
+constexpr unsigned InvariantStorePathMaxLen = 256U;
+
+llvm::SmallString< InvariantStorePathMaxLen > get_store_path(
+    llvm::StringRef knight_dir) {
+    llvm::SmallString< InvariantStorePathMaxLen > path(knight_dir);
+    llvm::sys::path::append(path, InvariantStoreFile);
+    return path;
+}
+
+void append_u32(std::string& buf, uint64_t value) {
+    char bytes[sizeof(uint32_t)];
+    llvm::support::endian::write32le(bytes, static_cast< uint32_t >(value));
+    buf.append(bytes, sizeof(bytes));
+}
+
+void set_u32(std::string& buf, uint64_t pos, uint64_t value) {
+    llvm::support::endian::write32le(&buf[pos],
+                                     static_cast< uint32_t >(value));
+}
+
+/// \brief Append the field, the separators of the records replaced.
+void append_field(std::string& buf, llvm::StringRef field) {
+    for (const char c : field) {
+        buf.push_back(c == '\t' || c == '\n' ? ' ' : c);
+    }
+}
+
+void append_values(std::string& buf,
+                   llvm::StringRef kind,
+                   const BlockInvariants::Values& values) {
+    for (const auto& [region, value] : values) {
+        buf += kind;
+        buf.push_back('\t');
+        append_field(buf, region);
+        buf.push_back('\t');
+        append_field(buf, value);
+        buf.push_back('\n');
+    }
+}
+
+} // anonymous namespace
+
+InvariantStore& InvariantStore::get() {
+    static InvariantStore store;
+    return store;
+}
+
+void InvariantStore::add_function(FunctionInvariants function) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    m_functions.push_back(std::move(function));
+}
+
+std::string InvariantStore::write(llvm::StringRef knight_dir) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    llvm::sort(m_functions, [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.file, lhs.begin_offset) <
+               std::tie(rhs.file, rhs.begin_offset);
+    });
+    m_functions.erase(std::unique(m_functions.begin(),
+                                  m_functions.end(),
+                                  [](const auto& lhs, const auto& rhs) {
+                                      return lhs.file == rhs.file &&
+                                             lhs.begin_offset ==
+                                                 rhs.begin_offset;
+                                  }),
+                      m_functions.end());
+
+    std::string index(InvariantStoreMagic);
+    append_u32(index, InvariantStoreVersion);
+    append_u32(index, m_functions.size());
+    const uint64_t base = HeaderSize + (m_functions.size() * FunctionEntrySize);
+    std::string data;
+    for (auto& function : m_functions) {
+        llvm::sort(function.blocks, [](const auto& lhs, const auto& rhs) {
+            return lhs.block_id < rhs.block_id;
+        });
+        append_u32(index, base + data.size());
+        append_u32(index, function.file.size());
+        append_u32(index, function.begin_offset);
+        append_u32(index, function.end_offset);
+        data += function.file;
+        const auto entries = data.size();
+        append_u32(index, base + entries);
+        append_u32(index, function.blocks.size());
+        data.resize(entries + (function.blocks.size() * BlockEntrySize));
+        for (const auto& [idx, block] : llvm::enumerate(function.blocks)) {
+            const auto record = data.size();
+            append_values(data, "pre", block.pre);
+            append_values(data, "post", block.post);
+            const auto entry = entries + (idx * BlockEntrySize);
+            set_u32(data, entry, block.block_id);
+            set_u32(data, entry + 4U, block.begin_offset);
+            set_u32(data, entry + 8U, block.end_offset);
+            set_u32(data, entry + 12U, base + record);
+            set_u32(data, entry + 16U, data.size() - record);
+        }
+    }
+    if (base + data.size() > std::numeric_limits< uint32_t >::max()) {
+        return "the invariant store exceeds 4GB";
+    }
+
+    // The file is replaced at once, so that a reader mapping the previous
+    // one is never torn.
+    const auto path = get_store_path(knight_dir);
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        std::error_code err;
+        llvm::raw_fd_ostream os(tmp_path, err, llvm::sys::fs::OF_None);
+        if (err) {
+            return "cannot open the invariant store `" + tmp_path.str().str() +
+                   "`: " + err.message();
+        }
+        os << index << data;
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            return "cannot write the invariant store `" +
+                   tmp_path.str().str() + "`";
+        }
+    }
+    if (auto err = llvm::sys::fs::rename(tmp_path, path)) {
+        return "cannot write the invariant store `" + path.str().str() +
+               "`: " + err.message();
+    }
+    return {};
+}
+
+std::unique_ptr< InvariantStoreReader > InvariantStoreReader::open(
+    llvm::StringRef knight_dir) {
+    auto buffer_or_err =
+        llvm::MemoryBuffer::getFile(get_store_path(knight_dir),
+                                    /*IsText=*/false,
+                                    /*RequiresNullTerminator=*/false);
+    if (!buffer_or_err) {
+        return nullptr;
+    }
+    std::unique_ptr< InvariantStoreReader > reader(
+        new InvariantStoreReader(std::move(*buffer_or_err)));
+    const auto bytes = reader->m_buffer->getBuffer();
+    if (bytes.size() < HeaderSize || !bytes.starts_with(InvariantStoreMagic) ||
+        reader->read(4U) != InvariantStoreVersion) {
+        return nullptr;
+    }
+    const auto num_functions = reader->read(8U);
+    if (HeaderSize + (num_functions * FunctionEntrySize) > bytes.size()) {
+        return nullptr;
+    }
+    reader->m_num_functions = num_functions;
+    return reader;
+}
+
+uint32_t InvariantStoreReader::read(uint64_t pos) const {
+    const auto bytes = m_buffer->getBuffer();
+    if (pos + sizeof(uint32_t) > bytes.size()) {
+        return 0U;
+    }
+    return llvm::support::endian::read32le(bytes.data() + pos);
+}
+
+uint64_t InvariantStoreReader::get_function_entry(unsigned idx) const {
+    return HeaderSize + (static_cast< uint64_t >(idx) * FunctionEntrySize);
+}
+
+llvm::StringRef InvariantStoreReader::get_function_file(unsigned idx) const {
+    const auto entry = get_function_entry(idx);
+    return m_buffer->getBuffer().substr(read(entry), read(entry + 4U));
+}
+
+std::optional< BlockInvariants > InvariantStoreReader::lookup(
+    llvm::StringRef file, unsigned offset) const {
+    // The first function of the file beginning after the offset, the
+    // innermost one covering it being the last covering one before.
+    unsigned lo = 0U;
+    unsigned hi = m_num_functions;
+    while (lo < hi) {
+        const auto mid = lo + ((hi - lo) / 2U);
+        const auto mid_file = get_function_file(mid);
+        if (mid_file < file ||
+            (mid_file == file &&
+             read(get_function_entry(mid) + 8U) <= offset)) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    for (auto idx = lo; idx-- > 0U && get_function_file(idx) == file;) {
+        const auto entry = get_function_entry(idx);
+        if (read(entry + 12U) < offset) {
+            continue;
+        }
+        // The smallest block covering the offset.
+        std::optional< uint64_t > best;
+        uint64_t best_size = 0U;
+        const auto blocks = read(entry + 16U);
+        const auto num_blocks = read(entry + 20U);
+        for (uint64_t block = 0U; block < num_blocks; ++block) {
+            const auto block_entry = blocks + (block * BlockEntrySize);
+            const auto begin = read(block_entry + 4U);
+            const auto end = read(block_entry + 8U);
+            if (begin <= offset && offset <= end &&
+                (!best || end - begin < best_size)) {
+                best = block_entry;
+                best_size = end - begin;
+            }
+        }
+        return best ? decode_block(*best) : std::nullopt;
+    }
+    return std::nullopt;
+}
+
+std::optional< BlockInvariants > InvariantStoreReader::lookup_block(
+    llvm::StringRef file, unsigned function_begin, unsigned block_id) const {
+    unsigned lo = 0U;
+    unsigned hi = m_num_functions;
+    while (lo < hi) {
+        const auto mid = lo + ((hi - lo) / 2U);
+        const auto mid_file = get_function_file(mid);
+        if (mid_file < file ||
+            (mid_file == file &&
+             read(get_function_entry(mid) + 8U) < function_begin)) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == m_num_functions || get_function_file(lo) != file ||
+        read(get_function_entry(lo) + 8U) != function_begin) {
+        return std::nullopt;
+    }
+    const auto entry = get_function_entry(lo);
+    const uint64_t blocks = read(entry + 16U);
+    uint64_t block_lo = 0U;
+    uint64_t block_hi = read(entry + 20U);
+    while (block_lo < block_hi) {
+        const auto mid = block_lo + ((block_hi - block_lo) / 2U);
+        if (read(blocks + (mid * BlockEntrySize)) < block_id) {
+            block_lo = mid + 1U;
+        } else {
+            block_hi = mid;
+        }
+    }
+    const auto block_entry = blocks + (block_lo * BlockEntrySize);
+    if (block_lo == read(entry + 20U) || read(block_entry) != block_id) {
+        return std::nullopt;
+    }
+    return decode_block(block_entry);
+}
+
+std::optional< BlockInvariants > InvariantStoreReader::decode_block(
+    uint64_t entry) const {
+    const auto bytes = m_buffer->getBuffer();
+    const uint64_t record_begin = read(entry + 12U);
+    const uint64_t record_size = read(entry + 16U);
+    if (entry + BlockEntrySize > bytes.size() ||
+        record_begin + record_size > bytes.size()) {
+        return std::nullopt;
+    }
+    BlockInvariants block{read(entry), read(entry + 4U), read(entry + 8U)};
+    auto record = bytes.substr(record_begin, record_size);
+    while (!record.empty()) {
+        auto [line, rest] = record.split('\n');
+        record = rest;
+        auto [kind, values] = line.split('\t');
+        auto [region, value] = values.split('\t');
+        auto& target = kind == "pre" ? block.pre : block.post;
+        target.emplace_back(region.str(), value.str());
+    }
+    return block;
+}
+
+} // namespace knight
@@ -15,11 +15,40 @@
 #include "analyzer/core/analysis_manager.hpp"
 #include "analyzer/tooling/diagnostic.hpp"
 #include "analyzer/tooling/factory.hpp"
+#include "analyzer/tooling/invariant_store.hpp"
+#include "analyzer/tooling/mem_report.hpp"
 #include "analyzer/tooling/module.hpp"
 #include "analyzer/tooling/reporter.hpp"
+#include "analyzer/tooling/time_report.hpp"
+#include "analyzer/tooling/trace.hpp"
+#include "cg/core/impact.hpp"
+#include "common/util/clang.hpp"
+#include "common/util/pch.hpp"
+#include "common/util/progress.hpp"
+#include "common/util/tu_costs.hpp"
 #include "common/util/vfs.hpp"
 
+#include <clang/Analysis/CallGraph.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Frontend/MultiplexConsumer.h>
 #include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/SCCIterator.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/TimeProfiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #define DEBUG_TYPE "Knight"
 
@@ -29,17 +58,130 @@ namespace knight {
 
 namespace {
 
+/// \brief Get the memory used by the managers of a function analysis.
+MemUsage get_mem_usage(const analyzer::AnalysisManager& analysis_mgr,
+                       const analyzer::LocationManager& location_mgr,
+                       std::size_t domain_values) {
+    MemUsage usage{};
+    usage[static_cast< unsigned >(MemKind::States)] =
+        analysis_mgr.get_state_manager().get_state_arena_size();
+    usage[static_cast< unsigned >(MemKind::Symbols)] =
+        analysis_mgr.get_symbol_manager().get_arena_size();
+    usage[static_cast< unsigned >(MemKind::Regions)] =
+        analysis_mgr.get_region_manager().get_arena_size();
+    usage[static_cast< unsigned >(MemKind::Locations)] =
+        location_mgr.get_arena_size();
+    usage[static_cast< unsigned >(MemKind::CFGs)] =
+        location_mgr.get_cfg_memory_size();
+    usage[static_cast< unsigned >(MemKind::DomainValues)] = domain_values;
+    return usage;
+}
+
+/// \brief Get the main file of the unit of the function.
+llvm::StringRef get_unit_file(const clang::FunctionDecl* function) {
+    const auto& src_mgr = function->getASTContext().getSourceManager();
+    const auto* file = src_mgr.getFileEntryForID(src_mgr.getMainFileID());
+    return file == nullptr ? llvm::StringRef() : file->getName();
+}
+
+/// \brief Get the printed values of the regions of the state.
+BlockInvariants::Values get_invariant_values(
+    const analyzer::ProgramStateRef& state) {
+    BlockInvariants::Values values;
+    for (const auto& value : state->get_region_values()) {
+        std::string str;
+        llvm::raw_string_ostream os(str);
+        os << value.value;
+        values.emplace_back(value.region->to_string(), std::move(os.str()));
+    }
+    return values;
+}
+
+/// \brief Get the converged invariants of the reached blocks of the
+/// function, located by the expansion offsets of their stmts.
+FunctionInvariants get_function_invariants(
+    const clang::FunctionDecl* function,
+    const analyzer::IntraProceduralFixpointIterator& engine) {
+    const auto& src_mgr = function->getASTContext().getSourceManager();
+    const auto range = src_mgr.getExpansionRange(function->getSourceRange());
+    const auto file_id = src_mgr.getFileID(range.getBegin());
+    FunctionInvariants invariants{
+        fs::make_absolute(src_mgr.getFilename(range.getBegin()).str()),
+        src_mgr.getFileOffset(range.getBegin()),
+        src_mgr.getFileOffset(range.getEnd())};
+
+    auto* cfg = engine.get_cfg();
+    for (unsigned id = 0U; id < analyzer::ProcCFG::num_nodes(cfg); ++id) {
+        const auto* node = analyzer::ProcCFG::get_node(cfg, id);
+        if (node == nullptr) {
+            continue;
+        }
+        const auto& pre = engine.get_pre(node);
+        const auto& post = engine.get_post(node);
+        if (pre->is_bottom() && post->is_bottom()) {
+            continue;
+        }
+        // The blocks without stmts of the file are never looked up.
+        BlockInvariants block{id,
+                              std::numeric_limits< unsigned >::max(),
+                              0U,
+                              get_invariant_values(pre),
+                              get_invariant_values(post)};
+        for (const auto& elem : *node) {
+            auto stmt = elem.getAs< clang::CFGStmt >();
+            if (!stmt) {
+                continue;
+            }
+            const auto stmt_range = src_mgr.getExpansionRange(
+                stmt->getStmt()->getSourceRange());
+            if (src_mgr.getFileID(stmt_range.getBegin()) != file_id) {
+                continue;
+            }
+            block.begin_offset =
+                std::min(block.begin_offset,
+                         src_mgr.getFileOffset(stmt_range.getBegin()));
+            block.end_offset =
+                std::max(block.end_offset,
+                         src_mgr.getFileOffset(stmt_range.getEnd()));
+        }
+        invariants.blocks.push_back(std::move(block));
+    }
+    return invariants;
+}
+
+/// \brief Run the consumer of the extra factory, if any, next to the
+/// analyzer consumer.
+std::unique_ptr< clang::ASTConsumer > attach_extra_consumer(
+    std::unique_ptr< clang::ASTConsumer > consumer,
+    const ExtraConsumerFactory* extra_factory,
+    clang::ASTContext& ast_ctx,
+    llvm::StringRef file) {
+    if (extra_factory == nullptr || !*extra_factory) {
+        return consumer;
+    }
+    std::vector< std::unique_ptr< clang::ASTConsumer > > consumers;
+    consumers.push_back(std::move(consumer));
+    consumers.push_back((*extra_factory)(ast_ctx, file));
+    return std::make_unique< clang::MultiplexConsumer >(std::move(consumers));
+}
+
 class KnightAction : public clang::ASTFrontendAction {
   public:
-    explicit KnightAction(KnightASTConsumerFactory* ast_factory)
-        : m_ast_factory(ast_factory) {}
+    KnightAction(KnightASTConsumerFactory* ast_factory,
+                 const ExtraConsumerFactory* extra_factory)
+        : m_ast_factory(ast_factory), m_extra_factory(extra_factory) {}
     std::unique_ptr< clang::ASTConsumer > CreateASTConsumer(
         clang::CompilerInstance& ci, llvm::StringRef file) override {
-        return m_ast_factory->create_ast_consumer(ci, file);
+        return attach_extra_consumer(m_ast_factory->create_ast_consumer(ci,
+                                                                        file),
+                                     m_extra_factory,
+                                     ci.getASTContext(),
+                                     file);
     }
 
   private:
     KnightASTConsumerFactory* m_ast_factory;
+    const ExtraConsumerFactory* m_extra_factory;
 }; // class KnightAction
 
 class KnightActionFactory : public clang::tooling::FrontendActionFactory {
@@ -49,25 +191,75 @@ class KnightActionFactory : public clang::tooling::FrontendActionFactory {
         std::unique_ptr< analyzer::AnalysisManager > external_analysis_manager =
             nullptr,
         std::unique_ptr< analyzer::CheckerManager > external_checker_manager =
-            nullptr)
+            nullptr,
+        const ExtraConsumerFactory* extra_factory = nullptr)
         : m_ast_factory(ctx,
                         std::move(external_analysis_manager),
-                        std::move(external_checker_manager)) {}
+                        std::move(external_checker_manager)),
+          m_extra_factory(extra_factory) {}
     std::unique_ptr< clang::FrontendAction > create() override {
-        return std::make_unique< KnightAction >(&m_ast_factory);
+        return std::make_unique< KnightAction >(&m_ast_factory,
+                                                m_extra_factory);
     }
 
   private:
     KnightASTConsumerFactory m_ast_factory;
+    const ExtraConsumerFactory* m_extra_factory;
 }; // class KnightActionFactory
 
+/// \brief A TU parsed ahead of its analysis in the pipelined mode.
+struct ParsedUnit {
+    std::size_t file_idx;
+    /// \brief The AST, null if the TU could not be parsed.
+    std::unique_ptr< clang::ASTUnit > ast;
+    /// \brief The compiler diagnostics of the parsing.
+    std::vector< KnightDiagnostic > diags;
+    std::chrono::microseconds parse_time;
+}; // struct ParsedUnit
+
 } // anonymous namespace
 
+/// \brief The context, diagnostic consumer and checkers owned by a check
+/// worker.
+// NOLINTNEXTLINE(altera-struct-pack-align)
+struct CheckWorkerEnv {
+    KnightContext ctx;
+    KnightDiagnosticConsumer diag_consumer;
+    clang::DiagnosticsEngine diag_engine;
+    KnightASTConsumerFactory factory;
+    std::unique_ptr< KnightASTConsumer > consumer;
+
+    CheckWorkerEnv(const KnightContext& parent_ctx, clang::ASTContext& ast_ctx)
+        : ctx(parent_ctx.clone_options_provider()),
+          diag_consumer(ctx),
+          diag_engine(new clang::DiagnosticIDs(),
+                      new clang::DiagnosticOptions(),
+                      &diag_consumer,
+                      false),
+          factory(ctx) {
+        ctx.set_diagnostic_engine(&diag_engine);
+        ctx.set_current_build_dir(parent_ctx.get_cuurent_build_dir());
+        consumer =
+            factory.create_ast_consumer(ast_ctx, parent_ctx.get_current_file());
+    }
+}; // struct CheckWorkerEnv
+
+/// \brief A strongly connected component of the call graph of the TU.
+struct CallSCC {
+    std::vector< const clang::FunctionDecl* > functions;
+
+    /// \brief The SCCs calling into this one.
+    std::vector< std::size_t > callers;
+
+    /// \brief The number of call edges from this SCC to the other ones.
+    unsigned num_callees = 0U;
+}; // struct CallSCC
+
 KnightASTConsumerFactory::KnightASTConsumerFactory(
     KnightContext& ctx,
     std::unique_ptr< analyzer::AnalysisManager > external_analysis_manager,
     std::unique_ptr< analyzer::CheckerManager > external_checker_manager)
-    : m_ctx(ctx) {
+    : m_ctx(ctx), m_factory(&KnightFactory::get_module_factory()) {
     if (external_analysis_manager != nullptr) {
         m_analysis_manager = std::move(external_analysis_manager);
     } else {
@@ -82,20 +274,569 @@ KnightASTConsumerFactory::KnightASTConsumerFactory(
                                                          *m_analysis_manager);
     }
 
-    m_factory = std::make_unique< KnightFactory >(*m_analysis_manager,
-                                                  *m_checker_manager);
-    for (auto entry : KnightModuleRegistry::entries()) {
-        entry.instantiate()->add_to_factory(*m_factory);
+    const auto& knight_dir = m_ctx.get_current_options().knight_dir;
+    if (!knight_dir.empty()) {
+        m_cache = AnalysisCache::open(knight_dir);
+    }
+}
+
+KnightASTConsumer::~KnightASTConsumer() {
+    if (m_call_inliner != nullptr) {
+        m_ctx.set_call_inliner(nullptr);
+    }
+}
+
+void KnightASTConsumer::print_processing_function(
+    const clang::FunctionDecl* function) const {
+    ProgressReporter::get().add_function(
+        [function](llvm::raw_ostream& os) { function->printName(os); },
+        llvm::raw_ostream::Colors::GREEN);
+}
+
+void KnightASTConsumer::record_dependencies(
+    const clang::SourceManager& src_mgr) const {
+    std::vector< std::string > files;
+    for (auto it = src_mgr.fileinfo_begin(); it != src_mgr.fileinfo_end();
+         ++it) {
+        // The includes are found relative to the build directory.
+        llvm::SmallString< 256 > path(it->first.getName());
+        llvm::sys::fs::make_absolute(m_ctx.get_cuurent_build_dir(), path);
+        files.emplace_back(path.str());
+    }
+    llvm::sort(files);
+    m_ctx.set_current_dependencies(std::move(files));
+}
+
+void KnightASTConsumer::show_cfg(analyzer::ProcCFG::GraphRef cfg) const {
+    const auto& opts = m_ctx.get_current_options();
+    if (opts.view_cfg || opts.dump_cfg) {
+        // Keep the CFGs after their function in the output.
+        ProgressReporter::get().flush();
+    }
+    if (m_ctx.get_current_options().view_cfg) {
+        if (m_ctx.get_current_options().use_color) {
+            llvm::outs().changeColor(llvm::raw_ostream::Colors::RED);
+        }
+        llvm::outs() << "viewing CFG:\n";
+        llvm::outs().resetColor();
+        cfg->view();
+    }
+
+    if (m_ctx.get_current_options().dump_cfg) {
+        if (m_ctx.get_current_options().use_color) {
+            llvm::outs().changeColor(llvm::raw_ostream::Colors::RED);
+        }
+        llvm::outs() << "dumping CFG:\n";
+        llvm::outs().resetColor();
+
+        cfg->dump(llvm::outs(), m_ctx.get_current_options().use_color);
+    }
+}
+
+void KnightASTConsumer::analyze_function(const clang::FunctionDecl* function) {
+    print_processing_function(function);
+    if (replay_cached_diags(function)) {
+        return;
+    }
+    std::optional< StructuralDedup::Shape > shape;
+    if (m_ctx.get_current_options().dedup_structural &&
+        m_ctx.get_summary_manager() == nullptr) {
+        shape = StructuralDedup::compute(function, m_ctx.get_lang_options());
+    }
+    if (shape) {
+        if (auto diags = m_structural_dedup.lookup(*shape)) {
+            knight_log(llvm::outs() << "reuse " << diags->size()
+                                    << " diagnostics of the same "
+                                       "structure\n";);
+            get_diag_consumer().add_diags(std::move(*diags));
+            return;
+        }
+    }
+
+    const auto* frame = m_location_manager.create_top_frame(function);
+    show_cfg(frame->get_cfg());
+    auto& diag_consumer = get_diag_consumer();
+    const auto num_diags = diag_consumer.get_num_diags();
+    run_fixpoint(function);
+    if (shape) {
+        m_structural_dedup.record(std::move(*shape),
+                                  diag_consumer.get_diags_from(num_diags));
+    }
+}
+
+KnightDiagnosticConsumer& KnightASTConsumer::get_diag_consumer() const {
+    // The diagnostic client of a knight context is always a knight
+    // diagnostic consumer.
+    return *static_cast< KnightDiagnosticConsumer* >(
+        m_ctx.get_diagnostic_engine()->getClient());
+}
+
+std::string KnightASTConsumer::get_cache_key(
+    const clang::FunctionDecl* function) const {
+    auto key = AnalysisCache::get_key(function, m_ctx.get_current_options());
+    if (const auto* summary_mgr = m_ctx.get_summary_manager()) {
+        key += "|" + summary_mgr->get_callee_digest(function);
+    }
+    return key;
+}
+
+bool KnightASTConsumer::is_selected(
+    const clang::FunctionDecl* function) const {
+    const auto& opts = m_ctx.get_current_options();
+    if (opts.skip_implicit_code && function->isImplicit()) {
+        return false;
+    }
+    const auto& src_mgr = function->getASTContext().getSourceManager();
+    const auto loc = src_mgr.getExpansionLoc(function->getLocation());
+    if (opts.skip_system_header && src_mgr.isInSystemHeader(loc)) {
+        return false;
+    }
+    if (!opts.exclude_paths.empty() &&
+        m_ctx.is_path_excluded(src_mgr.getFilename(loc))) {
+        return false;
+    }
+    // The names are only printed when filtered.
+    return opts.include_functions == "*" ||
+           m_ctx.is_function_included(function->getQualifiedNameAsString());
+}
+
+bool KnightASTConsumer::is_impacted(const clang::FunctionDecl* function) {
+    const auto& impact = m_ctx.get_current_options().change_impact;
+    if (impact == nullptr) {
+        return true;
+    }
+    if (m_mangler == nullptr) {
+        m_mangler.reset(function->getASTContext().createMangleContext());
+    }
+    return impact->is_function_impacted(fs::make_absolute(
+                                            m_ctx.get_current_file()),
+                                        clang_util::get_mangled_name(
+                                            function,
+                                            *m_mangler));
+}
+
+bool KnightASTConsumer::is_deduplicated(
+    const clang::FunctionDecl* function) const {
+    return m_ctx.get_current_options().dedup_definitions &&
+           m_ctx.get_summary_manager() == nullptr &&
+           AnalyzedDefinitions::is_shared(function);
+}
+
+bool KnightASTConsumer::replay_cached_diags(
+    const clang::FunctionDecl* function) {
+    std::string definition_key;
+    if (is_deduplicated(function)) {
+        definition_key =
+            AnalyzedDefinitions::get_key(function, m_ctx.get_current_options());
+        std::vector< KnightDiagnostic > diags;
+        if (AnalyzedDefinitions::get().try_claim(definition_key, diags) ==
+            DefinitionClaim::Published) {
+            knight_log(llvm::outs() << "reuse " << diags.size()
+                                    << " diagnostics of the definition\n";);
+            get_diag_consumer().add_diags(std::move(diags));
+            return true;
+        }
+    }
+    if (m_cache == nullptr) {
+        return false;
+    }
+    const auto key = get_cache_key(function);
+    auto diags = m_cache->lookup(key);
+    if (!diags) {
+        return false;
+    }
+    if (!definition_key.empty()) {
+        AnalyzedDefinitions::get().publish(definition_key, *diags);
+    }
+    if (auto* summary_mgr = m_ctx.get_summary_manager()) {
+        auto summary = m_cache->lookup_summary(key);
+        if (!summary) {
+            return false;
+        }
+        summary_mgr->set_summary(function, std::move(*summary));
+    }
+    knight_log(llvm::outs() << "replay " << diags->size()
+                            << " cached diagnostics\n";);
+    get_diag_consumer().add_diags(std::move(*diags));
+    return true;
+}
+
+void KnightASTConsumer::run_fixpoint(const clang::FunctionDecl* function) {
+    auto& diag_consumer = get_diag_consumer();
+    const auto num_diags = diag_consumer.get_num_diags();
+
+    const bool is_mem_reported = MemReport::get().is_enabled();
+    std::string function_name;
+    if (TimeReport::get().is_enabled() || is_mem_reported) {
+        function_name = function->getQualifiedNameAsString();
+    }
+    if (is_mem_reported) {
+        MemReport::begin_function();
+    }
+    const TimeReport::Scope scope(TimeReportKind::Function, function_name);
+    const llvm::TimeTraceScope trace_scope("analyze function", [function] {
+        return function->getQualifiedNameAsString();
+    });
+
+    // The key depends on the summaries of the callees, which includes
+    // the function itself when it is recursive.
+    std::string key;
+    if (m_cache != nullptr) {
+        key = get_cache_key(function);
+    }
+
+    if (m_call_inliner == nullptr &&
+        m_ctx.get_current_options().analyzer_opts.max_call_depth > 0U) {
+        // The memoized calls are kept across the top-level functions.
+        m_call_inliner =
+            std::make_unique< analyzer::CallInliner >(m_ctx,
+                                                      m_analysis_manager,
+                                                      m_checker_manager,
+                                                      m_location_manager);
+        m_ctx.set_call_inliner(m_call_inliner.get());
+    }
+
+    const auto* frame = m_location_manager.create_top_frame(function);
+    auto& state_mgr = m_analysis_manager.get_state_manager();
+    bool is_skipped = false;
+    // The results past a budget depend on it, and are not cached.
+    bool is_degraded = false;
+    MemUsage mem_peak{};
+    {
+        analyzer::IntraProceduralFixpointIterator engine(m_ctx,
+                                                         m_analysis_manager,
+                                                         m_checker_manager,
+                                                         m_location_manager,
+                                                         state_mgr,
+                                                         frame,
+                                                         get_check_workers());
+        engine.run();
+        is_skipped = engine.is_aborted();
+        is_degraded = engine.is_degraded();
+        if (m_ctx.get_current_options().store_invariants && !is_skipped) {
+            InvariantStore::get().add_function(
+                get_function_invariants(function, engine));
+        }
+        if (auto* summary_mgr = m_ctx.get_summary_manager()) {
+            auto summary = engine.build_summary();
+            if (m_cache != nullptr && !is_degraded) {
+                m_cache->store_summary(key, summary);
+            }
+            summary_mgr->set_summary(function, std::move(summary));
+        }
+        // The arenas only grow until they are reset below.
+        if (is_mem_reported) {
+            mem_peak =
+                get_mem_usage(m_analysis_manager,
+                              m_location_manager,
+                              MemReport::get_function_domain_values().first);
+        }
+    }
+    // All the states of the function are released with the engine.
+    state_mgr.reset();
+    if (!m_ctx.get_current_options().retain_symbols) {
+        m_analysis_manager.get_symbol_manager().reset();
+        m_analysis_manager.get_region_manager().reset();
+        m_location_manager.reset();
+    }
+    if (is_mem_reported) {
+        MemReport::get().add_function(
+            get_unit_file(function),
+            function_name,
+            mem_peak,
+            get_mem_usage(m_analysis_manager,
+                          m_location_manager,
+                          MemReport::get_function_domain_values().second));
+    }
+
+    // A skipped function is analyzed again by the next run, and by the
+    // other TUs reaching its definition.
+    if (is_skipped) {
+        return;
+    }
+    if (m_cache != nullptr && !is_degraded) {
+        m_cache->store(key, diag_consumer.get_diags_from(num_diags));
+    }
+    if (is_deduplicated(function)) {
+        AnalyzedDefinitions::get()
+            .publish(AnalyzedDefinitions::get_key(function,
+                                                  m_ctx.get_current_options()),
+                     diag_consumer.get_diags_from(num_diags));
+    }
+}
+
+std::vector< analyzer::CheckWorker > KnightASTConsumer::get_check_workers() {
+    const unsigned jobs = m_ctx.get_current_options().check_jobs;
+    if (jobs <= 1U) {
+        return {};
+    }
+    while (m_check_worker_envs.size() < jobs) {
+        m_check_worker_envs.push_back(
+            std::make_unique< CheckWorkerEnv >(m_ctx,
+                                               *m_ctx.get_ast_context()));
+    }
+
+    std::vector< analyzer::CheckWorker > workers;
+    workers.reserve(jobs);
+    for (const auto& env : m_check_worker_envs) {
+        workers.push_back({env->ctx, env->consumer->m_checker_manager});
+    }
+    return workers;
+}
+
+void KnightASTConsumer::analyze_functions_in_parallel(
+    clang::ASTContext& ast_ctx) {
+    std::vector< const clang::FunctionDecl* > functions;
+    std::vector< analyzer::ProcCFG::GraphUniqueRef > cfgs;
+    functions.reserve(m_functions.size());
+    cfgs.reserve(m_functions.size());
+    for (const auto* function : m_functions) {
+        print_processing_function(function);
+        if (replay_cached_diags(function)) {
+            continue;
+        }
+        functions.push_back(function);
+        auto cfg = analyzer::ProcCFG::build(
+            function, m_analysis_manager.get_required_cfg_elements());
+        show_cfg(cfg.get());
+        cfgs.push_back(std::move(cfg));
+    }
+
+    m_functions.clear();
+    if (functions.empty()) {
+        return;
+    }
+
+    const auto jobs = static_cast< unsigned >(
+        std::min< std::size_t >(m_ctx.get_current_options().function_jobs,
+                                functions.size()));
+    std::atomic< std::size_t > next_function{0U};
+    std::vector< std::vector< KnightDiagnostic > > function_diags(
+        functions.size());
+
+    auto worker = [&]() {
+        const trace::ThreadScope trace_scope;
+        KnightContext worker_ctx(m_ctx.clone_options_provider());
+        KnightDiagnosticConsumer diag_consumer(worker_ctx);
+        clang::DiagnosticsEngine diag_engine(new clang::DiagnosticIDs(),
+                                             new clang::DiagnosticOptions(),
+                                             &diag_consumer,
+                                             false);
+        worker_ctx.set_diagnostic_engine(&diag_engine);
+        worker_ctx.set_current_build_dir(m_ctx.get_cuurent_build_dir());
+
+        KnightASTConsumerFactory factory(worker_ctx);
+        auto consumer =
+            factory.create_ast_consumer(ast_ctx, m_ctx.get_current_file());
+        for (auto idx = next_function.fetch_add(1U); idx < functions.size();
+             idx = next_function.fetch_add(1U)) {
+            consumer->m_location_manager.add_cfg(functions[idx],
+                                                 std::move(cfgs[idx]));
+            consumer->run_fixpoint(functions[idx]);
+            function_diags[idx] = diag_consumer.take_diags();
+        }
+    };
+
+    std::vector< std::thread > workers;
+    workers.reserve(jobs);
+    for (unsigned worker_id = 0U; worker_id < jobs; ++worker_id) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    get_diag_consumer().add_diags(
+        merge_sorted_diags(std::move(function_diags)));
+}
+
+void KnightASTConsumer::analyze_functions_bottom_up(
+    clang::ASTContext& ast_ctx) {
+    std::unordered_map< const clang::Decl*, const clang::FunctionDecl* >
+        definitions;
+    clang::CallGraph call_graph;
+    for (const auto* function : m_functions) {
+        definitions.emplace(function->getCanonicalDecl(), function);
+        // The call graph builder only reads the declarations.
+        call_graph.addToCallGraph(const_cast< clang::FunctionDecl* >(function));
+    }
+
+    // The SCCs are visited in post order, i.e., callees first. The root
+    // node calls every function and has no declaration.
+    std::vector< CallSCC > sccs;
+    std::unordered_map< const clang::Decl*, std::size_t > scc_of;
+    for (auto scc = llvm::scc_begin(&call_graph); !scc.isAtEnd(); ++scc) {
+        CallSCC call_scc;
+        for (const clang::CallGraphNode* node : *scc) {
+            auto it = definitions.find(node->getDecl());
+            if (it == definitions.end()) {
+                continue;
+            }
+            call_scc.functions.push_back(it->second);
+            scc_of.emplace(it->first, sccs.size());
+            definitions.erase(it);
+        }
+        if (!call_scc.functions.empty()) {
+            sccs.push_back(std::move(call_scc));
+        }
+    }
+    m_summary_manager.reset();
+    for (std::size_t idx = 0U; idx < sccs.size(); ++idx) {
+        for (const auto* function : sccs[idx].functions) {
+            const auto* node = call_graph.getNode(function->getCanonicalDecl());
+            std::vector< const clang::FunctionDecl* > callees;
+            for (const clang::CallGraphNode* callee : *node) {
+                auto it = scc_of.find(callee->getDecl());
+                if (it == scc_of.end()) {
+                    continue;
+                }
+                callees.push_back(
+                    llvm::cast< clang::FunctionDecl >(callee->getDecl()));
+                if (it->second != idx) {
+                    sccs[it->second].callers.push_back(idx);
+                    ++sccs[idx].num_callees;
+                }
+            }
+            m_summary_manager.set_callees(function, std::move(callees));
+        }
+    }
+    // The functions left out of the call graph, e.g., the dependent ones.
+    for (const auto* function : m_functions) {
+        if (definitions.contains(function->getCanonicalDecl())) {
+            sccs.push_back(CallSCC{{function}, {}, 0U});
+        }
+    }
+    m_functions.clear();
+
+    m_ctx.set_summary_manager(&m_summary_manager);
+    if (m_ctx.get_current_options().function_jobs > 1U) {
+        analyze_sccs_in_parallel(ast_ctx, sccs);
+    } else {
+        for (const auto& scc : sccs) {
+            for (const auto* function : scc.functions) {
+                analyze_function(function);
+            }
+        }
     }
+    m_ctx.set_summary_manager(nullptr);
+    m_summary_manager.reset();
+}
+
+void KnightASTConsumer::analyze_sccs_in_parallel(
+    clang::ASTContext& ast_ctx, const std::vector< CallSCC >& sccs) {
+    // The functions of the SCCs flattened in the post order, only the
+    // analyzed ones have a CFG.
+    std::vector< const clang::FunctionDecl* > functions;
+    std::vector< analyzer::ProcCFG::GraphUniqueRef > cfgs;
+    std::vector< std::size_t > scc_offsets;
+    scc_offsets.reserve(sccs.size() + 1U);
+    for (const auto& scc : sccs) {
+        scc_offsets.push_back(functions.size());
+        for (const auto* function : scc.functions) {
+            print_processing_function(function);
+            if (replay_cached_diags(function)) {
+                continue;
+            }
+            functions.push_back(function);
+            auto cfg = analyzer::ProcCFG::build(
+                function, m_analysis_manager.get_required_cfg_elements());
+            show_cfg(cfg.get());
+            cfgs.push_back(std::move(cfg));
+        }
+    }
+    scc_offsets.push_back(functions.size());
+
+    std::vector< std::atomic< unsigned > > num_pending_callees(sccs.size());
+    std::vector< std::size_t > ready;
+    for (std::size_t idx = 0U; idx < sccs.size(); ++idx) {
+        num_pending_callees[idx].store(sccs[idx].num_callees,
+                                       std::memory_order_relaxed);
+        if (sccs[idx].num_callees == 0U) {
+            ready.push_back(idx);
+        }
+    }
+    // The leaves are picked up from the back, in the post order.
+    std::reverse(ready.begin(), ready.end());
+
+    std::mutex ready_mutex;
+    std::condition_variable ready_cv;
+    std::size_t num_remaining_sccs = sccs.size();
+    std::vector< std::vector< KnightDiagnostic > > function_diags(
+        functions.size());
+
+    const auto jobs = static_cast< unsigned >(
+        std::min< std::size_t >(m_ctx.get_current_options().function_jobs,
+                                sccs.size()));
+    auto worker = [&]() {
+        const trace::ThreadScope trace_scope;
+        CheckWorkerEnv env(m_ctx, ast_ctx);
+        env.ctx.set_summary_manager(&m_summary_manager);
+        while (true) {
+            std::size_t scc_idx = 0U;
+            {
+                std::unique_lock< std::mutex > lock(ready_mutex);
+                ready_cv.wait(lock, [&] {
+                    return !ready.empty() || num_remaining_sccs == 0U;
+                });
+                if (ready.empty()) {
+                    return;
+                }
+                scc_idx = ready.back();
+                ready.pop_back();
+            }
+
+            const auto end_idx = scc_offsets[scc_idx + 1U];
+            for (auto idx = scc_offsets[scc_idx]; idx < end_idx; ++idx) {
+                env.consumer->m_location_manager.add_cfg(functions[idx],
+                                                         std::move(cfgs[idx]));
+                env.consumer->run_fixpoint(functions[idx]);
+                function_diags[idx] = env.diag_consumer.take_diags();
+            }
+
+            // Publish the summaries to the callers, the last callee makes
+            // the caller ready.
+            std::vector< std::size_t > new_ready;
+            for (auto caller : sccs[scc_idx].callers) {
+                if (num_pending_callees[caller].fetch_sub(
+                        1U, std::memory_order_acq_rel) == 1U) {
+                    new_ready.push_back(caller);
+                }
+            }
+            bool is_done = false;
+            {
+                const std::lock_guard< std::mutex > lock(ready_mutex);
+                ready.insert(ready.end(), new_ready.begin(), new_ready.end());
+                is_done = --num_remaining_sccs == 0U;
+            }
+            if (is_done || new_ready.size() > 1U) {
+                ready_cv.notify_all();
+            } else if (!new_ready.empty()) {
+                ready_cv.notify_one();
+            }
+        }
+    };
+
+    m_summary_manager.set_concurrent(true);
+    {
+        std::vector< std::thread > workers;
+        workers.reserve(jobs);
+        for (unsigned worker_id = 0U; worker_id < jobs; ++worker_id) {
+            workers.emplace_back(worker);
+        }
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+    m_summary_manager.set_concurrent(false);
+
+    get_diag_consumer().add_diags(
+        merge_sorted_diags(std::move(function_diags)));
 }
 
 std::unique_ptr< clang::ASTConsumer > KnightASTConsumerFactory::
     create_ast_consumer(clang::CompilerInstance& ci, llvm::StringRef file) {
     auto& source_mgr = ci.getSourceManager();
     auto& file_mgr = source_mgr.getFileManager();
-    m_ctx.set_current_file(file);
-    m_ctx.set_current_ast_context(&ci.getASTContext());
-    m_analysis_manager->set_ast_context(ci.getASTContext());
 
     auto working_dir =
         file_mgr.getVirtualFileSystem().getCurrentWorkingDirectory();
@@ -103,35 +844,92 @@ std::unique_ptr< clang::ASTConsumer > KnightASTConsumerFactory::
         m_ctx.set_current_build_dir(working_dir.get());
     }
 
-    for (const auto& [id, _] : get_enabled_checks()) {
-        m_checker_manager->add_required_checker(id);
+    return create_ast_consumer(ci.getASTContext(), file);
+}
+
+std::unique_ptr< KnightASTConsumer > KnightASTConsumerFactory::
+    create_ast_consumer(clang::ASTContext& ast_ctx, llvm::StringRef file) {
+    m_ctx.set_current_file(file);
+    m_ctx.set_current_ast_context(&ast_ctx);
+    const auto* options = &m_ctx.get_current_options();
+    if (options != m_setup_options) {
+        if (m_setup_options != nullptr) {
+            // The managers hold the dependency closure of the previous
+            // configuration, start over on fresh ones.
+            m_checker_manager.reset();
+            // The arenas are empty after the last TU, reuse their slabs.
+            m_analysis_manager = std::make_unique< analyzer::AnalysisManager >(
+                m_ctx, m_analysis_manager->get_arenas());
+            m_checker_manager = std::make_unique< analyzer::CheckerManager >(
+                m_ctx, *m_analysis_manager);
+        }
+        set_up_modules();
+        m_setup_options = options;
     }
-    auto checkers = m_factory->create_checkers(*m_checker_manager, &m_ctx);
-    m_checker_manager->add_all_required_analyses_by_checker_dependencies();
+    // The instances only depend on the configuration, only the AST is
+    // specific to the TU.
+    m_analysis_manager->set_ast_context(ast_ctx);
+
+    return std::make_unique< KnightASTConsumer >(m_ctx,
+                                                 *m_analysis_manager,
+                                                 *m_checker_manager,
+                                                 m_checkers,
+                                                 m_analyses,
+                                                 m_cache.get());
+}
 
-    for (const auto& [id, _] : get_directly_enabled_analyses()) {
-        knight_log(llvm::outs()
-                       << "add required by directly enabled: "
-                       << analyzer::get_analysis_name_by_id(id) << "\n";);
-        m_analysis_manager->add_required_analysis(id);
+void KnightASTConsumerFactory::set_up_modules() {
+    const auto& modules = get_enabled_modules();
+    for (std::size_t id = 0U; id < KnightContext::MaxModuleIDs; ++id) {
+        if (modules.checkers.test(id)) {
+            m_checker_manager->add_required_checker(
+                static_cast< analyzer::CheckerID >(id));
+        }
     }
+    // Only the enabled checkers and analyses set up their dependencies.
+    m_factory->add_checker_dependencies(*m_checker_manager);
+    m_checkers = m_factory->create_checkers(*m_checker_manager, &m_ctx);
+    m_checker_manager->add_all_required_analyses_by_checker_dependencies();
 
-    for (const auto& [id, _] : get_enabled_core_analyses()) {
-        knight_log(llvm::outs()
-                       << "add required by core enabled: "
-                       << analyzer::get_analysis_name_by_id(id) << "\n";);
-        m_analysis_manager->add_required_analysis(id);
+    for (std::size_t idx = 0U; idx < KnightContext::MaxModuleIDs; ++idx) {
+        auto id = static_cast< analyzer::AnalysisID >(idx);
+        if (modules.directly_enabled_analyses.test(idx)) {
+            knight_log(llvm::outs()
+                           << "add required by directly enabled: "
+                           << analyzer::get_analysis_name_by_id(id) << "\n";);
+            m_analysis_manager->add_required_analysis(id);
+        }
+        if (modules.core_analyses.test(idx)) {
+            knight_log(llvm::outs()
+                           << "add required by core enabled: "
+                           << analyzer::get_analysis_name_by_id(id) << "\n";);
+            m_analysis_manager->add_required_analysis(id);
+        }
     }
 
+    m_factory->add_analysis_dependencies(*m_analysis_manager);
     m_analysis_manager->compute_all_required_analyses_by_dependencies();
-    auto analyses = m_factory->create_analyses(*m_analysis_manager, &m_ctx);
+    m_analyses = m_factory->create_analyses(*m_analysis_manager, &m_ctx);
     m_analysis_manager->compute_full_order_analyses_after_registry();
+}
 
-    return std::make_unique< KnightASTConsumer >(m_ctx,
-                                                 *m_analysis_manager,
-                                                 *m_checker_manager,
-                                                 std::move(checkers),
-                                                 std::move(analyses));
+const KnightContext::EnabledModules& KnightASTConsumerFactory::
+    get_enabled_modules() {
+    auto& resolved = m_ctx.get_current_resolved_options();
+    if (!resolved.enabled_modules) {
+        KnightContext::EnabledModules modules;
+        for (const auto& [id, _] : get_enabled_checks()) {
+            modules.checkers.set(id);
+        }
+        for (const auto& [id, _] : get_directly_enabled_analyses()) {
+            modules.directly_enabled_analyses.set(id);
+        }
+        for (const auto& [id, _] : get_enabled_core_analyses()) {
+            modules.core_analyses.set(id);
+        }
+        resolved.enabled_modules = modules;
+    }
+    return *resolved.enabled_modules;
 }
 
 std::vector< std::pair< analyzer::CheckerID, llvm::StringRef > >
@@ -170,34 +968,397 @@ KnightASTConsumerFactory::get_enabled_core_analyses() const {
     return enabled_analyses;
 }
 
+void KnightDriver::prepare_pch() {
+    const auto& opts = m_ctx.get_current_options();
+    if (opts.pch_header.empty()) {
+        return;
+    }
+
+    llvm::SmallString< 128 > pch_dir; // NOLINT
+    if (!opts.knight_dir.empty()) {
+        pch_dir = opts.knight_dir;
+    } else {
+        llvm::sys::path::system_temp_directory(true, pch_dir);
+    }
+    llvm::sys::path::append(pch_dir, "pch");
+
+    m_pch_adjuster = pch::build_pch_adjuster(m_cdb,
+                                             m_input_files,
+                                             opts.pch_header,
+                                             pch_dir.str().str(),
+                                             m_base_fs);
+}
+
+KnightDriver::~KnightDriver() = default;
+
 std::vector< KnightDiagnostic > KnightDriver::run() {
+    m_reported_diags.clear();
+
+    const auto& diag_stream = m_ctx.get_current_options().diag_stream;
+    if (!diag_stream.empty()) {
+        m_diag_stream = DiagnosticStreamWriter::open(diag_stream);
+    }
+    // The completed TUs are dropped before building the PCHs of the rest.
+    auto replayed = resume_from_checkpoint();
+    prepare_pch();
+    if (replayed.empty()) {
+        return run_on_input_files();
+    }
+    std::vector< std::vector< KnightDiagnostic > > runs;
+    runs.push_back(std::move(replayed));
+    runs.push_back(run_on_input_files());
+    return merge_sorted_diags(std::move(runs));
+}
+
+std::vector< KnightDiagnostic > KnightDriver::run_on_input_files() {
+    if (m_input_files.empty()) {
+        return {};
+    }
+    unsigned jobs = m_jobs == 0U ? std::thread::hardware_concurrency() : m_jobs;
+    jobs = std::min(jobs, static_cast< unsigned >(m_input_files.size()));
+    if (const unsigned depth = m_ctx.get_current_options().pipeline_depth;
+        depth > 0U) {
+        return run_pipelined(std::max(jobs, 1U), depth);
+    }
+    if (jobs > 1U) {
+        return run_in_parallel(jobs);
+    }
+    if (m_diag_stream == nullptr && m_checkpoint == nullptr) {
+        return run_on_files(m_ctx, m_input_files, m_base_fs);
+    }
+
+    // Run the TUs one by one to stream their diagnostics and mark them
+    // completed.
+    std::vector< std::vector< KnightDiagnostic > > file_diags;
+    file_diags.reserve(m_input_files.size());
+    for (const auto& file : m_input_files) {
+        file_diags.push_back(
+            finish_unit(m_ctx,
+                        file,
+                        run_on_files(m_ctx, {file}, m_base_fs)));
+    }
+    return merge_sorted_diags(std::move(file_diags));
+}
+
+std::vector< KnightDiagnostic > KnightDriver::resume_from_checkpoint() {
+    const auto& opts = m_ctx.get_current_options();
+    if (opts.knight_dir.empty()) {
+        return {};
+    }
+    m_checkpoint = RunCheckpoint::open(opts.knight_dir);
+    if (m_checkpoint == nullptr) {
+        return {};
+    }
+    if (!opts.resume) {
+        m_checkpoint->clear();
+        return {};
+    }
+
+    std::vector< std::vector< KnightDiagnostic > > replayed;
+    std::vector< std::string > remaining_files;
+    for (auto& file : m_input_files) {
+        if (auto diags =
+                m_checkpoint->lookup(file, get_compile_command(file), opts)) {
+            replayed.push_back(stream_diags(std::move(*diags)));
+        } else {
+            remaining_files.push_back(std::move(file));
+        }
+    }
+    m_input_files = std::move(remaining_files);
+    return merge_sorted_diags(std::move(replayed));
+}
+
+std::vector< KnightDiagnostic > KnightDriver::finish_unit(
+    KnightContext& ctx,
+    const std::string& file,
+    std::vector< KnightDiagnostic > diags) {
+    auto dependencies = ctx.take_current_dependencies();
+    // A TU which was not parsed, e.g. missing a header, runs again.
+    if (m_checkpoint != nullptr && dependencies) {
+        m_checkpoint->complete(file,
+                               get_compile_command(file),
+                               *dependencies,
+                               ctx.get_current_options(),
+                               diags);
+    }
+    return stream_diags(std::move(diags));
+}
+
+std::string KnightDriver::get_compile_command(const std::string& file) const {
+    std::string command;
+    for (const auto& cmd : m_cdb.getCompileCommands(file)) {
+        command += cmd.Directory;
+        for (const auto& arg : cmd.CommandLine) {
+            command += '\0';
+            command += arg;
+        }
+        command += '\n';
+    }
+    return command;
+}
+
+std::vector< KnightDiagnostic > KnightDriver::stream_diags(
+    std::vector< KnightDiagnostic > diags) {
+    if (m_diag_stream == nullptr) {
+        return diags;
+    }
+    m_diag_stream->write(diags);
+    llvm::erase_if(diags, [](const KnightDiagnostic& diag) {
+        return diag.DiagLevel != KnightDiagnostic::Error;
+    });
+    return diags;
+}
+
+std::vector< KnightDiagnostic > KnightDriver::run_warm(
+    const std::vector< std::string >& files) {
+    if (m_warm_factory == nullptr) {
+        prepare_pch();
+        auto analysis_manager =
+            std::make_unique< analyzer::AnalysisManager >(m_ctx);
+        auto checker_manager =
+            std::make_unique< analyzer::CheckerManager >(m_ctx,
+                                                         *analysis_manager);
+        m_warm_factory =
+            std::make_unique< KnightActionFactory >(m_ctx,
+                                                    std::move(analysis_manager),
+                                                    std::move(checker_manager));
+    }
+    // The files may have been changed since the last request.
+    fs::FileCache::get().clear();
+    m_reported_diags.clear();
+    return run_on_files(m_ctx, files, m_base_fs, m_warm_factory.get());
+}
+
+std::vector< KnightDiagnostic > KnightDriver::run_on_files(
+    KnightContext& ctx,
+    const std::vector< std::string >& files,
+    llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > fs,
+    clang::tooling::FrontendActionFactory* action_factory) {
     using namespace clang;
     using namespace clang::tooling;
     ClangTool clang_tool(m_cdb,
-                         m_input_files,
+                         files,
                          std::make_shared< PCHContainerOperations >(),
-                         m_base_fs);
+                         std::move(fs));
+    if (m_pch_adjuster) {
+        clang_tool.appendArgumentsAdjuster(m_pch_adjuster);
+    }
 
-    KnightDiagnosticConsumer diag_consumer(m_ctx);
+    KnightDiagnosticConsumer diag_consumer(ctx);
+    diag_consumer.set_reported_diags(&m_reported_diags);
     DiagnosticsEngine diag_engine(new DiagnosticIDs(),
                                   new DiagnosticOptions(),
                                   &diag_consumer,
                                   false);
-    m_ctx.set_diagnostic_engine(&diag_engine);
+    ctx.set_diagnostic_engine(&diag_engine);
     clang_tool.setDiagnosticConsumer(&diag_consumer);
 
-    auto analysis_manager =
-        std::make_unique< analyzer::AnalysisManager >(m_ctx);
+    if (action_factory != nullptr) {
+        clang_tool.run(action_factory);
+        return diag_consumer.take_diags();
+    }
+
+    auto analysis_manager = std::make_unique< analyzer::AnalysisManager >(ctx);
     auto checker_manager =
-        std::make_unique< analyzer::CheckerManager >(m_ctx, *analysis_manager);
+        std::make_unique< analyzer::CheckerManager >(ctx, *analysis_manager);
 
-    KnightActionFactory action_factory(m_ctx,
-                                       std::move(analysis_manager),
-                                       std::move(checker_manager));
-    clang_tool.run(&action_factory);
+    KnightActionFactory local_factory(ctx,
+                                      std::move(analysis_manager),
+                                      std::move(checker_manager),
+                                      &m_extra_consumer_factory);
+    clang_tool.run(&local_factory);
     return diag_consumer.take_diags();
 }
 
+std::vector< KnightDiagnostic > KnightDriver::run_in_parallel(unsigned jobs) {
+    std::atomic< std::size_t > next_file{0U};
+    // One sink per file, so that the merged result does not depend on
+    // which worker analyzed which file.
+    std::vector< std::vector< KnightDiagnostic > > file_diags(
+        m_input_files.size());
+    TUCosts costs(m_ctx.get_current_options().knight_dir,
+                  AnalyzerTUCostsFile);
+    const auto schedule = costs.get_schedule(m_input_files, m_base_fs);
+
+    auto worker = [&]() {
+        // Each worker owns its context and managers, so nothing but the
+        // compilation database and the options are shared between them.
+        const trace::ThreadScope trace_scope;
+        KnightContext worker_ctx(m_ctx.clone_options_provider());
+        auto worker_fs = fs::create_isolated_vfs(m_base_fs);
+        for (auto next = next_file.fetch_add(1U); next < schedule.size();
+             next = next_file.fetch_add(1U)) {
+            auto idx = schedule[next];
+            auto start = std::chrono::steady_clock::now();
+            file_diags[idx] = finish_unit(
+                worker_ctx,
+                m_input_files[idx],
+                run_on_files(worker_ctx, {m_input_files[idx]}, worker_fs));
+            costs.record(m_input_files[idx],
+                         std::chrono::duration_cast<
+                             std::chrono::microseconds >(
+                             std::chrono::steady_clock::now() - start));
+        }
+    };
+
+    std::vector< std::thread > workers;
+    workers.reserve(jobs);
+    for (unsigned worker_id = 0U; worker_id < jobs; ++worker_id) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    (void)costs.save();
+
+    return merge_sorted_diags(std::move(file_diags));
+}
+
+std::vector< KnightDiagnostic > KnightDriver::run_pipelined(unsigned jobs,
+                                                            unsigned depth) {
+    std::atomic< std::size_t > next_file{0U};
+    std::vector< std::vector< KnightDiagnostic > > file_diags(
+        m_input_files.size());
+    TUCosts costs(m_ctx.get_current_options().knight_dir,
+                  AnalyzerTUCostsFile);
+    const auto schedule = costs.get_schedule(m_input_files, m_base_fs);
+
+    std::mutex queue_mutex;
+    std::condition_variable not_full_cv;
+    std::condition_variable not_empty_cv;
+    std::deque< ParsedUnit > queue;
+    unsigned running_parsers = jobs;
+
+    auto parser = [&]() {
+        const trace::ThreadScope trace_scope;
+        KnightContext parse_ctx(m_ctx.clone_options_provider());
+        KnightDiagnosticConsumer diag_consumer(parse_ctx);
+        diag_consumer.set_reported_diags(&m_reported_diags);
+        clang::DiagnosticsEngine diag_engine(new clang::DiagnosticIDs(),
+                                             new clang::DiagnosticOptions(),
+                                             &diag_consumer,
+                                             false);
+        parse_ctx.set_diagnostic_engine(&diag_engine);
+        auto parse_fs = fs::create_isolated_vfs(m_base_fs);
+        for (auto next = next_file.fetch_add(1U); next < schedule.size();
+             next = next_file.fetch_add(1U)) {
+            const auto idx = schedule[next];
+            const auto& file = m_input_files[idx];
+            auto start = std::chrono::steady_clock::now();
+            auto commands = m_cdb.getCompileCommands(file);
+            if (!commands.empty()) {
+                parse_ctx.set_current_build_dir(commands.front().Directory);
+            }
+            clang::tooling::ClangTool clang_tool(
+                m_cdb,
+                {file},
+                std::make_shared< clang::PCHContainerOperations >(),
+                parse_fs);
+            if (m_pch_adjuster) {
+                clang_tool.appendArgumentsAdjuster(m_pch_adjuster);
+            }
+            clang_tool.setDiagnosticConsumer(&diag_consumer);
+            std::vector< std::unique_ptr< clang::ASTUnit > > asts;
+            (void)clang_tool.buildASTs(asts);
+            if (!asts.empty()) {
+                // The AST outlives the consumer of this thread.
+                asts.front()->getDiagnostics().setClient(
+                    new clang::IgnoringDiagConsumer(), true);
+            }
+
+            ParsedUnit unit{idx,
+                            asts.empty() ? nullptr : std::move(asts.front()),
+                            diag_consumer.take_diags(),
+                            std::chrono::duration_cast<
+                                std::chrono::microseconds >(
+                                std::chrono::steady_clock::now() - start)};
+            std::unique_lock< std::mutex > lock(queue_mutex);
+            not_full_cv.wait(lock, [&] { return queue.size() < depth; });
+            queue.push_back(std::move(unit));
+            not_empty_cv.notify_one();
+        }
+        const std::lock_guard< std::mutex > lock(queue_mutex);
+        if (--running_parsers == 0U) {
+            not_empty_cv.notify_all();
+        }
+    };
+
+    auto analyzer = [&]() {
+        const trace::ThreadScope trace_scope;
+        KnightContext worker_ctx(m_ctx.clone_options_provider());
+        KnightDiagnosticConsumer diag_consumer(worker_ctx);
+        diag_consumer.set_reported_diags(&m_reported_diags);
+        clang::DiagnosticsEngine diag_engine(new clang::DiagnosticIDs(),
+                                             new clang::DiagnosticOptions(),
+                                             &diag_consumer,
+                                             false);
+        worker_ctx.set_diagnostic_engine(&diag_engine);
+        KnightASTConsumerFactory factory(worker_ctx);
+        while (true) {
+            std::unique_lock< std::mutex > lock(queue_mutex);
+            not_empty_cv.wait(lock, [&] {
+                return !queue.empty() || running_parsers == 0U;
+            });
+            if (queue.empty()) {
+                return;
+            }
+            ParsedUnit unit = std::move(queue.front());
+            queue.pop_front();
+            not_full_cv.notify_one();
+            lock.unlock();
+
+            const auto& file = m_input_files[unit.file_idx];
+            auto start = std::chrono::steady_clock::now();
+            if (unit.ast != nullptr) {
+                auto& ast_ctx = unit.ast->getASTContext();
+                auto working_dir = unit.ast->getFileManager()
+                                       .getVirtualFileSystem()
+                                       .getCurrentWorkingDirectory();
+                if (working_dir) {
+                    worker_ctx.set_current_build_dir(working_dir.get());
+                }
+                // Feed the consumer as the parser would have.
+                auto consumer = attach_extra_consumer(
+                    factory.create_ast_consumer(ast_ctx, file),
+                    &m_extra_consumer_factory,
+                    ast_ctx,
+                    file);
+                for (auto* decl : ast_ctx.getTranslationUnitDecl()->decls()) {
+                    consumer->HandleTopLevelDecl(clang::DeclGroupRef(decl));
+                }
+                consumer->HandleTranslationUnit(ast_ctx);
+                consumer.reset();
+                unit.ast.reset();
+            }
+            std::vector< std::vector< KnightDiagnostic > > runs;
+            runs.push_back(std::move(unit.diags));
+            runs.push_back(diag_consumer.take_diags());
+            file_diags[unit.file_idx] =
+                finish_unit(worker_ctx,
+                            file,
+                            merge_sorted_diags(std::move(runs)));
+            costs.record(file,
+                         unit.parse_time +
+                             std::chrono::duration_cast<
+                                 std::chrono::microseconds >(
+                                 std::chrono::steady_clock::now() - start));
+        }
+    };
+
+    std::vector< std::thread > workers;
+    workers.reserve(2U * jobs);
+    for (unsigned worker_id = 0U; worker_id < jobs; ++worker_id) {
+        workers.emplace_back(parser);
+        workers.emplace_back(analyzer);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    (void)costs.save();
+
+    return merge_sorted_diags(std::move(file_diags));
+}
+
 void KnightDriver::handle_diagnostics(
     const std::vector< KnightDiagnostic >& diagnostics, bool try_fix) {
     const FixKind fix = try_fix ? FixKind::FixIt : FixKind::None;
@@ -209,13 +1370,20 @@ void KnightDriver::handle_diagnostics(
     auto origin_cwd = vfs.getCurrentWorkingDirectory();
     knight_assert_msg(origin_cwd, "failed to get current working directory");
 
+    // The diagnostics are sorted by file, so the working directory only
+    // changes when switching to the files of another build directory.
+    std::string current_dir = *origin_cwd;
     for (const auto& diagnostic : diagnostics) {
-        if (!diagnostic.BuildDirectory.empty()) {
-            (void)vfs.setCurrentWorkingDirectory(diagnostic.BuildDirectory);
+        const std::string& dir = diagnostic.BuildDirectory.empty()
+                                     ? *origin_cwd
+                                     : diagnostic.BuildDirectory;
+        if (dir != current_dir) {
+            (void)vfs.setCurrentWorkingDirectory(dir);
+            current_dir = dir;
         }
         reporter.report(diagnostic);
-        (void)vfs.setCurrentWorkingDirectory(*origin_cwd);
     }
+    (void)vfs.setCurrentWorkingDirectory(*origin_cwd);
     reporter.apply_fixes();
 }
 
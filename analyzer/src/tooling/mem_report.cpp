@@ -0,0 +1,217 @@
+//===- mem_report.cpp -------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the memory report of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/mem_report.hpp"
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace knight {
+
+namespace {
+
+constexpr double BytesPerKiB = 1024.0;
+
+/// \brief The domain values of a thread. They are signed since a value
+/// may be destroyed by another thread than the one which constructed it.
+struct DomainValueBytes {
+    int64_t current = 0;
+    int64_t base = 0;
+    int64_t peak = 0;
+}; // struct DomainValueBytes
+
+thread_local DomainValueBytes domain_value_bytes; // NOLINT
+
+llvm::StringRef get_kind_name(MemKind kind) {
+    switch (kind) {
+        case MemKind::States:
+            return "states";
+        case MemKind::Symbols:
+            return "symbols";
+        case MemKind::Regions:
+            return "regions";
+        case MemKind::Locations:
+            return "locations";
+        case MemKind::CFGs:
+            return "cfgs";
+        case MemKind::DomainValues:
+            return "domain_values";
+    }
+    return "";
+}
+
+double to_kib(std::size_t bytes) {
+    return static_cast< double >(bytes) / BytesPerKiB;
+}
+
+std::size_t get_total(const MemUsage& usage) {
+    return std::accumulate(usage.begin(), usage.end(), std::size_t{0U});
+}
+
+std::vector< const llvm::StringMapEntry< MemReport::MemEntry >* > get_sorted(
+    const llvm::StringMap< MemReport::MemEntry >& map) {
+    std::vector< const llvm::StringMapEntry< MemReport::MemEntry >* > entries;
+    entries.reserve(map.size());
+    for (const auto& entry : map) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const auto* lhs, const auto* rhs) {
+                  const auto lhs_total = get_total(lhs->second.peak);
+                  const auto rhs_total = get_total(rhs->second.peak);
+                  if (lhs_total != rhs_total) {
+                      return lhs_total > rhs_total;
+                  }
+                  return lhs->getKey() < rhs->getKey();
+              });
+    return entries;
+}
+
+void record(MemReport::MemEntry& entry,
+            const MemUsage& peak,
+            const MemUsage& current) {
+    for (unsigned kind = 0U; kind < NumMemKinds; ++kind) {
+        entry.peak[kind] = std::max(entry.peak[kind], peak[kind]);
+    }
+    entry.current = current;
+    ++entry.count;
+}
+
+void print_table_entries(llvm::raw_ostream& os,
+                         llvm::StringRef title,
+                         const llvm::StringMap< MemReport::MemEntry >& map) {
+    os << "\n" << title << " (peak KiB / current KiB):\n";
+    for (unsigned kind = 0U; kind < NumMemKinds; ++kind) {
+        os << llvm::format("%21s ",
+                           get_kind_name(static_cast< MemKind >(kind))
+                               .str()
+                               .c_str());
+    }
+    os << "     Count  Name\n";
+    for (const auto* entry : get_sorted(map)) {
+        const auto& mem = entry->second;
+        for (unsigned kind = 0U; kind < NumMemKinds; ++kind) {
+            os << llvm::format("%10.1f/%10.1f ",
+                               to_kib(mem.peak[kind]),
+                               to_kib(mem.current[kind]));
+        }
+        os << llvm::format("%10llu  ",
+                           static_cast< unsigned long long >(mem.count))
+           << entry->getKey() << "\n";
+    }
+}
+
+llvm::json::Array get_json_entries(
+    const llvm::StringMap< MemReport::MemEntry >& map) {
+    llvm::json::Array entries;
+    for (const auto* entry : get_sorted(map)) {
+        const auto& mem = entry->second;
+        llvm::json::Object peak;
+        llvm::json::Object current;
+        for (unsigned kind = 0U; kind < NumMemKinds; ++kind) {
+            const auto name = get_kind_name(static_cast< MemKind >(kind));
+            peak[name] = static_cast< int64_t >(mem.peak[kind]);
+            current[name] = static_cast< int64_t >(mem.current[kind]);
+        }
+        entries.push_back(llvm::json::Object{{"name", entry->getKey()},
+                                             {"peak_bytes", std::move(peak)},
+                                             {"current_bytes",
+                                              std::move(current)},
+                                             {"count", mem.count}});
+    }
+    return entries;
+}
+
+} // anonymous namespace
+
+MemReport& MemReport::get() {
+    static MemReport report;
+    return report;
+}
+
+void MemReport::add_domain_value(std::size_t size) {
+    if (!get().is_enabled()) {
+        return;
+    }
+    auto& bytes = domain_value_bytes;
+    bytes.current += static_cast< int64_t >(size);
+    bytes.peak = std::max(bytes.peak, bytes.current);
+}
+
+void MemReport::remove_domain_value(std::size_t size) {
+    if (get().is_enabled()) {
+        domain_value_bytes.current -= static_cast< int64_t >(size);
+    }
+}
+
+void MemReport::begin_function() {
+    auto& bytes = domain_value_bytes;
+    bytes.base = bytes.current;
+    bytes.peak = bytes.current;
+}
+
+std::pair< std::size_t, std::size_t > MemReport::
+    get_function_domain_values() {
+    const auto& bytes = domain_value_bytes;
+    return {static_cast< std::size_t >(std::max(bytes.peak - bytes.base,
+                                                int64_t{0})),
+            static_cast< std::size_t >(std::max(bytes.current - bytes.base,
+                                                int64_t{0}))};
+}
+
+void MemReport::add_function(llvm::StringRef unit,
+                             llvm::StringRef function,
+                             const MemUsage& peak,
+                             const MemUsage& current) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    record(m_functions[function], peak, current);
+    record(m_units[unit], peak, current);
+}
+
+void MemReport::print(llvm::raw_ostream& os, MemReportFormat format) const {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    switch (format) {
+        case MemReportFormat::Table:
+            print_table(os);
+            break;
+        case MemReportFormat::Json:
+            print_json(os);
+            break;
+        case MemReportFormat::None:
+            break;
+    }
+}
+
+void MemReport::print_table(llvm::raw_ostream& os) const {
+    os << "===-------------------------------------------------------===\n"
+       << "                   Knight memory report\n"
+       << "===-------------------------------------------------------===\n";
+    print_table_entries(os, "units", m_units);
+    print_table_entries(os, "functions", m_functions);
+    os.flush();
+}
+
+void MemReport::print_json(llvm::raw_ostream& os) const {
+    llvm::json::Object report{{"units", get_json_entries(m_units)},
+                              {"functions", get_json_entries(m_functions)}};
+    os << llvm::formatv("{0:2}", llvm::json::Value(std::move(report))) << "\n";
+    os.flush();
+}
+
+} // namespace knight
@@ -46,6 +46,11 @@ KnightOptions KnightOptionsDefaultProvider::get_options_for(
     return options;
 }
 
+std::unique_ptr< KnightOptionsProvider > KnightOptionsDefaultProvider::clone()
+    const {
+    return std::make_unique< KnightOptionsDefaultProvider >(*this);
+}
+
 OptionSource KnightOptionsCommandLineProvider::get_checker_option_source(
     const std::string& option) const {
     if (m_cmd_override_opts.contains(option)) {
@@ -60,6 +65,11 @@ void KnightOptionsCommandLineProvider::set_checker_option(
     m_cmd_override_opts.insert(option);
 }
 
+std::unique_ptr< KnightOptionsProvider > KnightOptionsCommandLineProvider::
+    clone() const {
+    return std::make_unique< KnightOptionsCommandLineProvider >(*this);
+}
+
 KnightOptionsConfigFileProvider::KnightOptionsConfigFileProvider(
     [[maybe_unused]] std::string config_file) { // NOLINT
     // TODO(config): Implement this.
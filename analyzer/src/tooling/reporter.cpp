@@ -21,12 +21,19 @@
 #include <clang/Basic/SourceLocation.h>
 #include <clang/Format/Format.h>
 #include <clang/Frontend/TextDiagnosticPrinter.h>
-#include <clang/Rewrite/Core/Rewriter.h>
 #include <clang/Tooling/Core/Replacement.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Process.h>
 #include "common/util/log.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace knight {
 
 namespace {
@@ -200,9 +207,7 @@ void DiagnosticReporter::report(const KnightDiagnostic& diagnostic) {
                                                      replacement
                                                          .getReplacementText());
 
-                        auto& [build_dir, replaces] =
-                            m_file_to_build_dir_and_replaces
-                                [replacement.getFilePath()];
+                        auto& replaces = m_file_to_replaces[abs_path_fix];
 
                         llvm::Error err = replaces.add(replace);
                         if (err) {
@@ -240,7 +245,6 @@ void DiagnosticReporter::report(const KnightDiagnostic& diagnostic) {
                                                    replacement.getOffset());
                         fix_locs.push_back(
                             std::make_pair(fix_loc, can_be_applied));
-                        build_dir = diagnostic.BuildDirectory;
                     }
                 }
             }
@@ -265,58 +269,41 @@ void DiagnosticReporter::apply_fixes() {
         return;
     }
 
-    auto& vfs = m_file_manager.getVirtualFileSystem();
-    auto origin_cwd = vfs.getCurrentWorkingDirectory();
-
-    bool any_not_written = false;
-    for (const auto& [file, pair] : m_file_to_build_dir_and_replaces) {
-        const auto& [build_dir, replaces] = pair;
-
-        Rewriter rewriter(m_source_manager, m_lang_opts);
-
-        (void)vfs.setCurrentWorkingDirectory(build_dir);
-
-        auto buffer = m_source_manager.getFileManager().getBufferForFile(file);
-        if (!buffer) {
-            llvm::WithColor::error()
-                << "error when accessing file: " << file << ": "
-                << buffer.getError().message() << "\n";
-            continue;
-        }
-        auto code = buffer.get()->getBuffer();
-
-        auto fmt = format::getStyle("none", file, "none");
-        if (!fmt) {
-            llvm::WithColor::error() << llvm::toString(fmt.takeError()) << "\n";
-            continue;
-        }
-
-        auto replacements_expected =
-            format::cleanupAroundReplacements(code, replaces, *fmt);
-        if (!replacements_expected) {
-            llvm::WithColor::error()
-                << "error when applying replacements: "
-                << llvm::toString(replacements_expected.takeError()) << "\n";
-            continue;
-        }
-
-        if (auto replacements_formatted =
-                format::formatReplacements(code, replaces, *fmt)) {
-            replacements_expected = std::move(replacements_formatted);
-            knight_assert_msg(replacements_expected,
-                              "format replacements failed");
-        } else {
-            llvm::WithColor::error()
-                << "error when formatting replacements: "
-                << llvm::toString(replacements_formatted.takeError()) << "\n";
-            continue;
+    std::vector< const llvm::StringMapEntry< tooling::Replacements >* > files;
+    files.reserve(m_file_to_replaces.size());
+    for (const auto& entry : m_file_to_replaces) {
+        files.push_back(&entry);
+    }
+    // The errors are reported by the file order after all the files are
+    // rewritten, which keeps the output stable.
+    std::vector< std::string > errors(files.size());
+
+    std::atomic< std::size_t > next_file{0U};
+    auto worker = [&]() {
+        for (auto idx = next_file.fetch_add(1U); idx < files.size();
+             idx = next_file.fetch_add(1U)) {
+            errors[idx] = rewrite_file(files[idx]->getKey(),
+                                       files[idx]->getValue());
         }
+    };
+
+    const auto jobs = static_cast< std::size_t >(
+        std::max(1U, std::thread::hardware_concurrency()));
+    std::vector< std::thread > workers;
+    workers.reserve(std::min(jobs, files.size()));
+    for (std::size_t i = 0U; i < std::min(jobs, files.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
 
-        if (!clang::tooling::applyAllReplacements(replacements_expected.get(),
-                                                  rewriter)) {
-            llvm::WithColor::error() << "error when applying replacements\n";
+    bool any_not_written = false;
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            llvm::WithColor::error() << error << "\n";
+            any_not_written = true;
         }
-        any_not_written |= rewriter.overwriteChangedFiles();
     }
 
     if (any_not_written) {
@@ -325,10 +312,72 @@ void DiagnosticReporter::apply_fixes() {
         llvm::outs() << "applied " << m_applied_fixes << " out of "
                      << m_total_fixes << " suggested fixes.\n";
     }
+}
+
+std::string DiagnosticReporter::rewrite_file(
+    llvm::StringRef file, const clang::tooling::Replacements& replaces) {
+    using namespace clang;
+
+    // Reuse the contents read for the analysis and the snippets.
+    auto buffer = m_file_manager.getVirtualFileSystem().getBufferForFile(file);
+    if (!buffer) {
+        return "error when accessing file: " + file.str() + ": " +
+               buffer.getError().message();
+    }
+    auto code = buffer.get()->getBuffer();
 
-    if (origin_cwd) {
-        (void)vfs.setCurrentWorkingDirectory(*origin_cwd);
+    auto fmt = format::getStyle("none", file, "none");
+    if (!fmt) {
+        return llvm::toString(fmt.takeError());
+    }
+
+    auto replacements_expected =
+        format::cleanupAroundReplacements(code, replaces, *fmt);
+    if (!replacements_expected) {
+        return "error when applying replacements: " +
+               llvm::toString(replacements_expected.takeError());
+    }
+
+    auto replacements_formatted =
+        format::formatReplacements(code, *replacements_expected, *fmt);
+    if (!replacements_formatted) {
+        return "error when formatting replacements: " +
+               llvm::toString(replacements_formatted.takeError());
+    }
+
+    auto new_code =
+        tooling::applyAllReplacements(code, *replacements_formatted);
+    if (!new_code) {
+        return "error when applying replacements: " +
+               llvm::toString(new_code.takeError());
+    }
+
+    // Write aside and rename over the file instead of truncating it, as its
+    // old contents may still be mapped by the file cache.
+    auto tmp_file = file.str() + ".knight-fix";
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(tmp_file, ec);
+        if (ec) {
+            return "error when writing file: " + tmp_file + ": " +
+                   ec.message();
+        }
+        os << *new_code;
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            (void)llvm::sys::fs::remove(tmp_file);
+            return "error when writing file: " + tmp_file;
+        }
+    }
+    if (auto perms = llvm::sys::fs::getPermissions(file)) {
+        (void)llvm::sys::fs::setPermissions(tmp_file, *perms);
+    }
+    if (auto ec = llvm::sys::fs::rename(tmp_file, file)) {
+        (void)llvm::sys::fs::remove(tmp_file);
+        return "error when writing file: " + file.str() + ": " + ec.message();
     }
+    return {};
 }
 
 } // namespace knight
\ No newline at end of file
@@ -0,0 +1,344 @@
+//===- sarif.cpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the SARIF writer of the knight diagnostics.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/sarif.hpp"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace knight {
+
+namespace {
+
+constexpr unsigned SarifPathMaxLen = 256U;
+constexpr llvm::StringLiteral SarifVersion = "2.1.0";
+constexpr llvm::StringLiteral SarifSchema =
+    "https://json.schemastore.org/sarif-2.1.0.json";
+constexpr llvm::StringLiteral KnightUri =
+    "https://github.com/shenjunjiekoda/knight";
+
+/// \brief A mapped source file and the offsets of its lines.
+struct SourceFile {
+    std::unique_ptr< llvm::MemoryBuffer > buffer;
+    std::vector< unsigned > line_offsets;
+
+    void load(const std::string& path) {
+        // Large files are mapped instead of read.
+        auto buffer_or_err =
+            llvm::MemoryBuffer::getFile(path,
+                                        /*IsText=*/false,
+                                        /*RequiresNullTerminator=*/false);
+        if (!buffer_or_err) {
+            return;
+        }
+        buffer = std::move(*buffer_or_err);
+        const auto text = buffer->getBuffer();
+        line_offsets.push_back(0U);
+        for (auto pos = text.find('\n'); pos != llvm::StringRef::npos;
+             pos = text.find('\n', pos + 1U)) {
+            line_offsets.push_back(static_cast< unsigned >(pos + 1U));
+        }
+    }
+
+    /// \brief Get the 1-based line of the offset.
+    [[nodiscard]] unsigned get_line(unsigned offset) const {
+        return static_cast< unsigned >(std::upper_bound(line_offsets.begin(),
+                                                        line_offsets.end(),
+                                                        offset) -
+                                       line_offsets.begin());
+    }
+
+    /// \brief Get the text of the 1-based line, without its newline.
+    [[nodiscard]] llvm::StringRef get_line_text(unsigned line) const {
+        const auto text = buffer->getBuffer();
+        const auto begin = line_offsets[line - 1U];
+        const auto end = line < line_offsets.size() ? line_offsets[line]
+                                                    : text.size();
+        return text.slice(begin, end).rtrim("\r\n");
+    }
+}; // struct SourceFile
+
+/// \brief The sources of the diagnostics, by their absolute paths.
+class SourceFiles {
+  private:
+    llvm::StringMap< unsigned > m_ids;
+    std::vector< std::string > m_paths;
+    std::vector< SourceFile > m_files;
+
+  public:
+    [[nodiscard]] static std::string get_path(
+        llvm::StringRef file, llvm::StringRef build_dir) {
+        llvm::SmallString< SarifPathMaxLen > path;
+        if (!build_dir.empty() && llvm::sys::path::is_relative(file)) {
+            path = build_dir;
+        }
+        llvm::sys::path::append(path, file);
+        llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+        return path.str().str();
+    }
+
+    void add(const std::string& path) {
+        if (m_ids.try_emplace(path, m_paths.size()).second) {
+            m_paths.push_back(path);
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const { return m_paths.size(); }
+
+    /// \brief Allocate the files before the parallel loading.
+    void prepare() { m_files.resize(m_paths.size()); }
+
+    /// \brief Map the file, once all are added and prepared.
+    void load(std::size_t idx) { m_files[idx].load(m_paths[idx]); }
+
+    [[nodiscard]] const SourceFile* get(const std::string& path) const {
+        auto it = m_ids.find(path);
+        if (it == m_ids.end() || m_files[it->second].buffer == nullptr) {
+            return nullptr;
+        }
+        return &m_files[it->second];
+    }
+}; // class SourceFiles
+
+/// \brief Run `fn` on the indexes below `size` on `jobs` threads.
+template < typename Fn >
+void run_in_parallel(std::size_t size, unsigned jobs, Fn fn) {
+    std::atomic< std::size_t > next{0U};
+    auto worker = [&]() {
+        for (auto idx = next.fetch_add(1U); idx < size;
+             idx = next.fetch_add(1U)) {
+            fn(idx);
+        }
+    };
+    const auto num_workers =
+        std::min(static_cast< std::size_t >(jobs), size);
+    if (num_workers <= 1U) {
+        worker();
+        return;
+    }
+    std::vector< std::thread > workers;
+    workers.reserve(num_workers);
+    for (std::size_t i = 0U; i < num_workers; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+[[nodiscard]] llvm::StringRef get_level_name(KnightDiagnostic::Level level) {
+    switch (level) {
+        case KnightDiagnostic::Error:
+            return "error";
+        case KnightDiagnostic::Remark:
+            return "note";
+        case KnightDiagnostic::Ignored:
+            return "none";
+        default:
+            return "warning";
+    }
+}
+
+/// \brief Get the `file` URI of the absolute path, escaping the
+/// characters other than the unreserved ones and the separators.
+[[nodiscard]] std::string get_file_uri(llvm::StringRef path) {
+    std::string uri = "file://";
+    llvm::raw_string_ostream os(uri);
+    for (const char c : path) {
+        if (llvm::isAlnum(c) || llvm::StringRef("-._~/").contains(c)) {
+            os << c;
+        } else {
+            const auto byte = static_cast< unsigned char >(c);
+            os << '%' << llvm::hexdigit(byte >> 4U)
+               << llvm::hexdigit(byte & 0xFU);
+        }
+    }
+    return uri;
+}
+
+[[nodiscard]] llvm::json::Object get_location(
+    const clang::tooling::DiagnosticMessage& msg,
+    llvm::StringRef build_dir,
+    const SourceFiles& sources) {
+    const auto path = SourceFiles::get_path(msg.FilePath, build_dir);
+    llvm::json::Object region{{"charOffset", msg.FileOffset}};
+    if (const auto* source = sources.get(path)) {
+        const auto line = source->get_line(msg.FileOffset);
+        region["startLine"] = line;
+        region["startColumn"] =
+            msg.FileOffset - source->line_offsets[line - 1U] + 1U;
+        // The sources may not be in UTF-8, unlike the JSON strings.
+        const auto text = source->get_line_text(line);
+        region["snippet"] = llvm::json::Object{
+            {"text",
+             llvm::json::isUTF8(text) ? text.str()
+                                      : llvm::json::fixUTF8(text)}};
+    }
+    return llvm::json::Object{
+        {"physicalLocation",
+         llvm::json::Object{{"artifactLocation",
+                             llvm::json::Object{{"uri", get_file_uri(path)}}},
+                            {"region", std::move(region)}}}};
+}
+
+[[nodiscard]] llvm::json::Object get_result(const KnightDiagnostic& diag,
+                                            const SourceFiles& sources) {
+    llvm::json::Object result{
+        {"ruleId", diag.DiagnosticName},
+        {"level", get_level_name(diag.DiagLevel)},
+        {"message", llvm::json::Object{{"text", diag.Message.Message}}}};
+    if (!diag.Message.FilePath.empty()) {
+        result["locations"] = llvm::json::Array{
+            get_location(diag.Message, diag.BuildDirectory, sources)};
+    }
+    llvm::json::Array related;
+    for (const auto& note : diag.Notes) {
+        if (note.FilePath.empty()) {
+            continue;
+        }
+        auto location = get_location(note, diag.BuildDirectory, sources);
+        location["id"] = related.size();
+        location["message"] = llvm::json::Object{{"text", note.Message}};
+        related.push_back(std::move(location));
+    }
+    if (!related.empty()) {
+        result["relatedLocations"] = std::move(related);
+    }
+    return result;
+}
+
+[[nodiscard]] std::string get_header(
+    const std::vector< KnightDiagnostic >& diags) {
+    llvm::StringSet<> rule_set;
+    for (const auto& diag : diags) {
+        rule_set.insert(diag.DiagnosticName);
+    }
+    std::vector< llvm::StringRef > rule_names;
+    rule_names.reserve(rule_set.size());
+    for (const auto& rule : rule_set) {
+        rule_names.push_back(rule.getKey());
+    }
+    llvm::sort(rule_names);
+    llvm::json::Array rules;
+    for (auto rule : rule_names) {
+        rules.push_back(llvm::json::Object{{"id", rule}});
+    }
+
+    llvm::json::Object driver{{"name", "knight"},
+                              {"informationUri", KnightUri},
+                              {"rules", std::move(rules)}};
+    std::string header;
+    llvm::raw_string_ostream os(header);
+    os << R"({"version":")" << SarifVersion << R"(","$schema":")"
+       << SarifSchema << R"(","runs":[{"tool":)"
+       << llvm::json::Value(
+              llvm::json::Object{{"driver", std::move(driver)}})
+       << R"(,"results":[)";
+    return header;
+}
+
+} // anonymous namespace
+
+std::string SarifWriter::write(const std::string& file,
+                               const std::vector< KnightDiagnostic >& diags,
+                               unsigned jobs) {
+    if (jobs == 0U) {
+        jobs = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(file, ec);
+    if (ec) {
+        return "cannot open the SARIF file `" + file + "`: " + ec.message();
+    }
+
+    SourceFiles sources;
+    for (const auto& diag : diags) {
+        if (!diag.Message.FilePath.empty()) {
+            sources.add(SourceFiles::get_path(diag.Message.FilePath,
+                                              diag.BuildDirectory));
+        }
+        for (const auto& note : diag.Notes) {
+            if (!note.FilePath.empty()) {
+                sources.add(SourceFiles::get_path(note.FilePath,
+                                                  diag.BuildDirectory));
+            }
+        }
+    }
+    sources.prepare();
+    run_in_parallel(sources.size(), jobs, [&sources](std::size_t idx) {
+        sources.load(idx);
+    });
+
+    os << get_header(diags);
+
+    // The workers render the chunks while this thread streams the rendered
+    // ones in order, so that only the chunks ahead of the output are kept.
+    const auto num_chunks = (diags.size() + ChunkSize - 1U) / ChunkSize;
+    std::vector< std::string > chunks(num_chunks);
+    std::vector< bool > is_ready(num_chunks, false);
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::thread renderer([&]() {
+        run_in_parallel(num_chunks, jobs, [&](std::size_t idx) {
+            std::string text;
+            llvm::raw_string_ostream chunk_os(text);
+            const auto end = std::min(diags.size(), (idx + 1U) * ChunkSize);
+            for (auto diag_idx = idx * ChunkSize; diag_idx < end;
+                 ++diag_idx) {
+                if (diag_idx != 0U) {
+                    chunk_os << ',';
+                }
+                chunk_os << llvm::json::Value(
+                    get_result(diags[diag_idx], sources));
+            }
+            const std::lock_guard< std::mutex > lock(mutex);
+            chunks[idx] = std::move(text);
+            is_ready[idx] = true;
+            ready_cv.notify_all();
+        });
+    });
+    for (std::size_t idx = 0U; idx < num_chunks; ++idx) {
+        std::string text;
+        {
+            std::unique_lock< std::mutex > lock(mutex);
+            ready_cv.wait(lock, [&is_ready, idx] { return is_ready[idx]; });
+            text = std::move(chunks[idx]);
+        }
+        os << text;
+    }
+    renderer.join();
+
+    os << "]}]}\n";
+    os.close();
+    if (os.has_error()) {
+        os.clear_error();
+        return "cannot write the SARIF file `" + file + "`";
+    }
+    return {};
+}
+
+} // namespace knight
@@ -0,0 +1,161 @@
+//===- server.cpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the server mode of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/server.hpp"
+#include "analyzer/tooling/diag_stream.hpp"
+#include "common/util/vfs.hpp"
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/WithColor.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+namespace knight {
+
+namespace {
+
+constexpr unsigned ReadChunkSize = 4096U;
+constexpr llvm::StringRef RequestEnd = "\n\n";
+
+#ifndef _WIN32
+
+/// \brief Read a request from the client, up to its end marker.
+///
+/// \returns false if the client disconnected before ending the request.
+bool read_request(int fd, std::string& request) {
+    std::array< char, ReadChunkSize > chunk{};
+    while (llvm::StringRef(request).find(RequestEnd) ==
+           llvm::StringRef::npos) {
+        auto size = ::read(fd, chunk.data(), chunk.size());
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            return false;
+        }
+        request.append(chunk.data(), static_cast< std::size_t >(size));
+    }
+    return true;
+}
+
+bool write_all(int fd, llvm::StringRef data) {
+    while (!data.empty()) {
+        auto size = ::write(fd, data.data(), data.size());
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            return false;
+        }
+        data = data.drop_front(static_cast< std::size_t >(size));
+    }
+    return true;
+}
+
+#endif
+
+} // anonymous namespace
+
+std::string KnightServer::handle(llvm::StringRef request) {
+    request = request.take_front(request.find(RequestEnd));
+    if (request.trim() == ShutdownRequest) {
+        return {};
+    }
+
+    llvm::SmallVector< llvm::StringRef, 8U > lines;
+    request.split(lines, '\n', -1, false);
+    std::vector< std::string > files;
+    for (auto line : lines) {
+        if (!line.trim().empty()) {
+            files.push_back(fs::make_absolute(line.trim().str()));
+        }
+    }
+    auto response =
+        DiagnosticStreamWriter::to_json_lines(m_driver.run_warm(files));
+    response += '\n';
+    return response;
+}
+
+bool KnightServer::serve(const std::string& socket_path) {
+#ifdef _WIN32
+    (void)socket_path;
+    llvm::WithColor::error() << "The server mode needs unix sockets.\n";
+    return false;
+#else
+    sockaddr_un addr{};
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        llvm::WithColor::error()
+            << "The socket path `" << socket_path << "` is too long.\n";
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+    int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        llvm::WithColor::error()
+            << "Cannot create the socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    (void)::unlink(socket_path.c_str());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (::bind(server_fd, reinterpret_cast< sockaddr* >(&addr), sizeof(addr)) !=
+            0 ||
+        ::listen(server_fd, SOMAXCONN) != 0) {
+        llvm::WithColor::error() << "Cannot listen on `" << socket_path
+                                 << "`: " << std::strerror(errno) << "\n";
+        ::close(server_fd);
+        return false;
+    }
+    llvm::WithColor::note() << "Serving on `" << socket_path << "`\n";
+
+    bool is_shutdown = false;
+    while (!is_shutdown) {
+        int client_fd = ::accept(server_fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // A connection may send several requests in a row.
+        std::string request;
+        while (read_request(client_fd, request)) {
+            auto response = handle(request);
+            if (response.empty()) {
+                is_shutdown = true;
+                break;
+            }
+            if (!write_all(client_fd, response)) {
+                break;
+            }
+            request.erase(0, request.find(RequestEnd) + RequestEnd.size());
+        }
+        ::close(client_fd);
+    }
+
+    ::close(server_fd);
+    (void)::unlink(socket_path.c_str());
+    return true;
+#endif
+}
+
+} // namespace knight
@@ -0,0 +1,152 @@
+//===- stats.cpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the hot path statistics of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/stats.hpp"
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+
+namespace knight {
+
+namespace {
+
+llvm::StringRef get_stat_name(StatKind kind) {
+    switch (kind) {
+        case StatKind::StatesInterned:
+            return "states_interned";
+        case StatKind::StatesReused:
+            return "states_reused";
+        case StatKind::SymbolsCreated:
+            return "symbols_created";
+        case StatKind::RegionsCreated:
+            return "regions_created";
+        case StatKind::LocationContextsCreated:
+            return "location_contexts_created";
+        case StatKind::CycleVisits:
+            return "cycle_visits";
+        case StatKind::CycleIterations:
+            return "cycle_iterations";
+        case StatKind::NonLinearQueries:
+            return "non_linear_queries";
+        case StatKind::NonLinearCacheHits:
+            return "non_linear_cache_hits";
+        case StatKind::CheckerQueries:
+            return "checker_queries";
+        case StatKind::CheckerQueryCacheHits:
+            return "checker_query_cache_hits";
+        case StatKind::AcceleratedCycles:
+            return "accelerated_cycles";
+    }
+    return "";
+}
+
+llvm::StringRef get_domain_op_name(DomainOpKind kind) {
+    switch (kind) {
+        case DomainOpKind::Clone:
+            return "clones";
+        case DomainOpKind::Join:
+            return "joins";
+        case DomainOpKind::Widen:
+            return "widens";
+        case DomainOpKind::Narrow:
+            return "narrows";
+    }
+    return "";
+}
+
+} // anonymous namespace
+
+Stats& Stats::get() {
+    static Stats stats;
+    return stats;
+}
+
+void Stats::print(llvm::raw_ostream& os, StatsFormat format) const {
+    switch (format) {
+        case StatsFormat::Table:
+            print_table(os);
+            break;
+        case StatsFormat::Json:
+            print_json(os);
+            break;
+        case StatsFormat::None:
+            break;
+    }
+}
+
+void Stats::print_table(llvm::raw_ostream& os) const {
+    os << "===-------------------------------------------------------===\n"
+       << "                    Knight statistics\n"
+       << "===-------------------------------------------------------===\n";
+    for (unsigned kind = 0U; kind < NumStatKinds; ++kind) {
+        os << llvm::format("%14llu  ",
+                           static_cast< unsigned long long >(
+                               m_counters[kind].load(
+                                   std::memory_order_relaxed)))
+           << get_stat_name(static_cast< StatKind >(kind)) << "\n";
+    }
+
+    os << "\ndomains:\n"
+       << "        Clones          Joins         Widens        Narrows"
+          "  Name\n";
+    for (unsigned id = 0U; id < analyzer::NumDomains; ++id) {
+        const auto& ops = m_domain_ops[id];
+        uint64_t total = 0U;
+        for (const auto& op : ops) {
+            total += op.load(std::memory_order_relaxed);
+        }
+        if (total == 0U) {
+            continue;
+        }
+        for (const auto& op : ops) {
+            os << llvm::format("%14llu ",
+                               static_cast< unsigned long long >(
+                                   op.load(std::memory_order_relaxed)));
+        }
+        os << " " << analyzer::get_domain_name_by_id(
+                  static_cast< analyzer::DomID >(id)) << "\n";
+    }
+    os.flush();
+}
+
+void Stats::print_json(llvm::raw_ostream& os) const {
+    llvm::json::Object report;
+    for (unsigned kind = 0U; kind < NumStatKinds; ++kind) {
+        report[get_stat_name(static_cast< StatKind >(kind))] =
+            m_counters[kind].load(std::memory_order_relaxed);
+    }
+
+    llvm::json::Object domains;
+    for (unsigned id = 0U; id < analyzer::NumDomains; ++id) {
+        llvm::json::Object ops;
+        uint64_t total = 0U;
+        for (unsigned kind = 0U; kind < NumDomainOpKinds; ++kind) {
+            const auto count =
+                m_domain_ops[id][kind].load(std::memory_order_relaxed);
+            ops[get_domain_op_name(static_cast< DomainOpKind >(kind))] =
+                count;
+            total += count;
+        }
+        if (total != 0U) {
+            domains[analyzer::get_domain_name_by_id(
+                static_cast< analyzer::DomID >(id))] = std::move(ops);
+        }
+    }
+    report["domains"] = std::move(domains);
+
+    os << llvm::formatv("{0:2}", llvm::json::Value(std::move(report))) << "\n";
+    os.flush();
+}
+
+} // namespace knight
@@ -0,0 +1,293 @@
+//===- structural_dedup.cpp -------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the deduplication of the structurally identical
+//  functions of a translation unit.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/structural_dedup.hpp"
+#include "analyzer/tooling/context.hpp"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/ODRHash.h>
+#include <clang/AST/Stmt.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Lex/Lexer.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/FoldingSet.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/Casting.h>
+
+#include <iterator>
+#include <mutex>
+
+namespace knight {
+
+namespace {
+
+/// \brief The offset of the invalid locations, which are not moved.
+constexpr unsigned InvalidOffset = ~0U;
+
+/// \brief Builder of the shape of a function.
+///
+/// The stmts are profiled by clang's ODR hashing, which covers their
+/// kinds, operators, constants and the names they refer to, along with
+/// the types of the expressions and the referenced declarations: the
+/// parameters and locals by their order of appearance, the others by
+/// identity.
+class ShapeBuilder {
+  private:
+    const clang::FunctionDecl* m_function;
+    const clang::SourceManager& m_src_mgr;
+    const clang::LangOptions& m_lang_opts;
+    clang::FileID m_file_id;
+    llvm::FoldingSetNodeID m_id;
+    llvm::DenseMap< const clang::Decl*, unsigned > m_locals;
+    std::vector< unsigned > m_offsets;
+    bool m_is_valid = true;
+
+  public:
+    ShapeBuilder(const clang::FunctionDecl* function,
+                 const clang::LangOptions& lang_opts)
+        : m_function(function),
+          m_src_mgr(function->getASTContext().getSourceManager()),
+          m_lang_opts(lang_opts) {}
+
+    [[nodiscard]] std::optional< StructuralDedup::Shape > build() {
+        const auto* body = m_function->getBody();
+        auto begin_loc = body->getBeginLoc();
+        if (begin_loc.isInvalid() || begin_loc.isMacroID()) {
+            return std::nullopt;
+        }
+        m_file_id = m_src_mgr.getFileID(begin_loc);
+
+        m_id.AddPointer(
+            m_function->getType().getCanonicalType().getAsOpaquePtr());
+        if (const auto* method =
+                llvm::dyn_cast< clang::CXXMethodDecl >(m_function)) {
+            m_id.AddPointer(method->getParent()->getCanonicalDecl());
+        }
+        for (const auto* param : m_function->parameters()) {
+            add_decl(param);
+        }
+        add_stmt(body);
+        clang::ODRHash odr_hash;
+        body->ProcessODRHash(m_id, odr_hash);
+        if (!m_is_valid) {
+            return std::nullopt;
+        }
+
+        llvm::BumpPtrAllocator alloc;
+        auto id_ref = m_id.Intern(alloc);
+        StructuralDedup::Shape shape;
+        shape.key.assign(reinterpret_cast< const char* >( // NOLINT
+                             id_ref.getData()),
+                         id_ref.getSize() * sizeof(unsigned));
+        shape.file = m_src_mgr.getFilename(begin_loc).str();
+        shape.offsets = std::move(m_offsets);
+        return shape;
+    }
+
+  private:
+    [[nodiscard]] bool is_local(const clang::Decl* decl) const {
+        return decl->getDeclContext() == m_function;
+    }
+
+    void add_decl(const clang::Decl* decl) {
+        if (decl == nullptr) {
+            m_id.AddInteger(0U);
+            return;
+        }
+        if (!is_local(decl)) {
+            m_id.AddInteger(1U);
+            m_id.AddPointer(decl->getCanonicalDecl());
+            return;
+        }
+        auto index = static_cast< unsigned >(m_locals.size());
+        auto [it, is_new] = m_locals.try_emplace(decl, index);
+        m_id.AddInteger(2U);
+        m_id.AddInteger(it->second);
+        if (!is_new) {
+            return;
+        }
+        if (const auto* value = llvm::dyn_cast< clang::ValueDecl >(decl)) {
+            m_id.AddPointer(
+                value->getType().getCanonicalType().getAsOpaquePtr());
+        }
+        add_loc(decl->getLocation());
+    }
+
+    void add_loc(clang::SourceLocation loc) {
+        if (loc.isInvalid()) {
+            m_offsets.push_back(InvalidOffset);
+            return;
+        }
+        auto [file_id, offset] = m_src_mgr.getDecomposedLoc(loc);
+        if (loc.isMacroID() || file_id != m_file_id) {
+            m_is_valid = false;
+            return;
+        }
+        m_offsets.push_back(offset);
+    }
+
+    void add_referenced_decls(const clang::Stmt* stmt) {
+        using namespace clang;
+        if (const auto* ref = llvm::dyn_cast< DeclRefExpr >(stmt)) {
+            add_decl(ref->getDecl());
+        } else if (const auto* member = llvm::dyn_cast< MemberExpr >(stmt)) {
+            add_decl(member->getMemberDecl());
+        } else if (const auto* decl_stmt = llvm::dyn_cast< DeclStmt >(stmt)) {
+            for (const auto* decl : decl_stmt->decls()) {
+                add_decl(decl);
+            }
+        } else if (const auto* label = llvm::dyn_cast< LabelStmt >(stmt)) {
+            add_decl(label->getDecl());
+        } else if (const auto* go_to = llvm::dyn_cast< GotoStmt >(stmt)) {
+            add_decl(go_to->getLabel());
+        } else if (const auto* addr = llvm::dyn_cast< AddrLabelExpr >(stmt)) {
+            add_decl(addr->getLabel());
+        } else if (const auto* ctor =
+                       llvm::dyn_cast< CXXConstructExpr >(stmt)) {
+            add_decl(ctor->getConstructor());
+        } else if (const auto* new_expr = llvm::dyn_cast< CXXNewExpr >(stmt)) {
+            add_decl(new_expr->getOperatorNew());
+        } else if (const auto* del = llvm::dyn_cast< CXXDeleteExpr >(stmt)) {
+            add_decl(del->getOperatorDelete());
+        } else if (const auto* arg =
+                       llvm::dyn_cast< CXXDefaultArgExpr >(stmt)) {
+            add_decl(arg->getParam());
+        } else if (const auto* init =
+                       llvm::dyn_cast< CXXDefaultInitExpr >(stmt)) {
+            add_decl(init->getField());
+        }
+    }
+
+    void add_stmt(const clang::Stmt* stmt) {
+        if (stmt == nullptr) {
+            m_id.AddInteger(0U);
+            return;
+        }
+        m_id.AddInteger(static_cast< unsigned >(stmt->getStmtClass()) + 1U);
+        add_loc(stmt->getBeginLoc());
+        add_loc(stmt->getEndLoc());
+        add_loc(clang::Lexer::getLocForEndOfToken(stmt->getEndLoc(),
+                                                  0,
+                                                  m_src_mgr,
+                                                  m_lang_opts));
+        if (const auto* expr = llvm::dyn_cast< clang::Expr >(stmt)) {
+            m_id.AddPointer(
+                expr->getType().getCanonicalType().getAsOpaquePtr());
+            m_id.AddInteger(static_cast< unsigned >(expr->getValueKind()));
+            add_loc(expr->getExprLoc());
+        }
+        add_referenced_decls(stmt);
+
+        auto children = stmt->children();
+        m_id.AddInteger(static_cast< unsigned >(
+            std::distance(children.begin(), children.end())));
+        for (const auto* child : children) {
+            add_stmt(child);
+        }
+    }
+
+}; // class ShapeBuilder
+
+/// \brief Move the location of the message from the offsets of `from` to
+/// the ones of `to`.
+///
+/// \returns false if the location is not one of the shape.
+bool move_message(clang::tooling::DiagnosticMessage& msg,
+                  const llvm::DenseMap< unsigned, std::size_t >& indices,
+                  const StructuralDedup::Shape& from,
+                  const StructuralDedup::Shape& to) {
+    auto move_offset = [&](unsigned& offset) {
+        auto it = indices.find(offset);
+        if (it == indices.end()) {
+            return false;
+        }
+        offset = to.offsets[it->second];
+        return true;
+    };
+
+    if (!msg.Fix.empty()) {
+        return false;
+    }
+    if (msg.FilePath.empty()) {
+        return msg.Ranges.empty();
+    }
+    if (msg.FilePath != from.file || !move_offset(msg.FileOffset)) {
+        return false;
+    }
+    msg.FilePath = to.file;
+    for (auto& range : msg.Ranges) {
+        unsigned end = range.FileOffset + range.Length;
+        if (range.FilePath != from.file || !move_offset(range.FileOffset) ||
+            !move_offset(end) || end < range.FileOffset) {
+            return false;
+        }
+        range.FilePath = to.file;
+        range.Length = end - range.FileOffset;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+std::optional< StructuralDedup::Shape > StructuralDedup::compute(
+    const clang::FunctionDecl* function, const clang::LangOptions& lang_opts) {
+    if (!function->hasBody()) {
+        return std::nullopt;
+    }
+    const std::lock_guard< std::mutex > lock(KnightContext::get_ast_mutex());
+    return ShapeBuilder(function, lang_opts).build();
+}
+
+std::optional< std::vector< KnightDiagnostic > > StructuralDedup::lookup(
+    const Shape& shape) const {
+    auto it = m_functions.find(shape.key);
+    if (it == m_functions.end()) {
+        return std::nullopt;
+    }
+    const auto& [from, diags] = it->second;
+    if (from.offsets.size() != shape.offsets.size()) {
+        return std::nullopt;
+    }
+    llvm::DenseMap< unsigned, std::size_t > indices;
+    for (std::size_t idx = 0U; idx < from.offsets.size(); ++idx) {
+        if (from.offsets[idx] != InvalidOffset) {
+            indices.try_emplace(from.offsets[idx], idx);
+        }
+    }
+
+    std::vector< KnightDiagnostic > moved_diags = diags;
+    for (auto& diag : moved_diags) {
+        if (!move_message(diag.Message, indices, from, shape)) {
+            return std::nullopt;
+        }
+        for (auto& note : diag.Notes) {
+            if (!move_message(note, indices, from, shape)) {
+                return std::nullopt;
+            }
+        }
+    }
+    return moved_diags;
+}
+
+void StructuralDedup::record(Shape shape,
+                             std::vector< KnightDiagnostic > diags) {
+    auto key = shape.key;
+    m_functions.try_emplace(std::move(key),
+                            std::move(shape),
+                            std::move(diags));
+}
+
+} // namespace knight
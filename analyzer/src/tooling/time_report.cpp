@@ -0,0 +1,243 @@
+//===- time_report.cpp ------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the time report of the knight analyzer.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/time_report.hpp"
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+namespace knight {
+
+namespace {
+
+constexpr double NanosPerMilli = 1e6;
+
+llvm::StringRef get_kind_name(TimeReportKind kind) {
+    switch (kind) {
+        case TimeReportKind::Function:
+            return "functions";
+        case TimeReportKind::Analysis:
+            return "analyses";
+        case TimeReportKind::Checker:
+            return "checkers";
+    }
+    return "";
+}
+
+double to_millis(std::chrono::nanoseconds time) {
+    return static_cast< double >(time.count()) / NanosPerMilli;
+}
+
+template < typename Entry, typename Less >
+std::vector< const llvm::StringMapEntry< Entry >* > get_sorted(
+    const llvm::StringMap< Entry >& map, Less less) {
+    std::vector< const llvm::StringMapEntry< Entry >* > entries;
+    entries.reserve(map.size());
+    for (const auto& entry : map) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(),
+              entries.end(),
+              [&less](const auto* lhs, const auto* rhs) {
+                  if (less(rhs->second, lhs->second)) {
+                      return true;
+                  }
+                  if (less(lhs->second, rhs->second)) {
+                      return false;
+                  }
+                  return lhs->getKey() < rhs->getKey();
+              });
+    return entries;
+}
+
+bool time_less(const TimeReport::TimeEntry& lhs,
+               const TimeReport::TimeEntry& rhs) {
+    return lhs.wall < rhs.wall;
+}
+
+bool cycle_less(const TimeReport::CycleEntry& lhs,
+                const TimeReport::CycleEntry& rhs) {
+    return lhs.iterations < rhs.iterations;
+}
+
+} // anonymous namespace
+
+TimeReport::Scope::Scope(TimeReportKind kind, llvm::StringRef name)
+    : m_kind(kind), m_name(name), m_is_enabled(TimeReport::get().is_enabled()) {
+    if (m_is_enabled) {
+        if (TimeReport::get().is_perf_enabled()) {
+            m_perf_start = PerfCounters::get_thread_counters().read();
+        }
+        m_wall_start = std::chrono::steady_clock::now();
+        m_cpu_start = get_thread_cpu_time();
+    }
+}
+
+TimeReport::Scope::~Scope() {
+    if (!m_is_enabled) {
+        return;
+    }
+    const auto wall = std::chrono::steady_clock::now() - m_wall_start;
+    const auto cpu = get_thread_cpu_time() - m_cpu_start;
+    PerfCounterValues perf{};
+    if (TimeReport::get().is_perf_enabled()) {
+        perf = PerfCounters::get_thread_counters().read() - m_perf_start;
+    }
+    TimeReport::get().add_time(m_kind, m_name, wall, cpu, perf);
+}
+
+TimeReport& TimeReport::get() {
+    static TimeReport report;
+    return report;
+}
+
+std::chrono::nanoseconds TimeReport::get_thread_cpu_time() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec time{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0) {
+        return std::chrono::seconds(time.tv_sec) +
+               std::chrono::nanoseconds(time.tv_nsec);
+    }
+#endif
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+        std::chrono::duration< double >(static_cast< double >(std::clock()) /
+                                        CLOCKS_PER_SEC));
+}
+
+void TimeReport::add_time(TimeReportKind kind,
+                          llvm::StringRef name,
+                          std::chrono::nanoseconds wall,
+                          std::chrono::nanoseconds cpu,
+                          const PerfCounterValues& perf) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    auto& entry = m_times[static_cast< std::size_t >(kind)][name];
+    entry.wall += wall;
+    entry.cpu += cpu;
+    for (unsigned counter = 0U; counter < NumPerfCounterKinds; ++counter) {
+        entry.perf[counter] += perf[counter];
+    }
+    ++entry.count;
+}
+
+void TimeReport::add_cycle_iterations(llvm::StringRef cycle,
+                                      uint64_t iterations) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    auto& entry = m_cycles[cycle];
+    entry.iterations += iterations;
+    ++entry.visits;
+}
+
+void TimeReport::print(llvm::raw_ostream& os, TimeReportFormat format) const {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    switch (format) {
+        case TimeReportFormat::Table:
+            print_table(os);
+            break;
+        case TimeReportFormat::Json:
+            print_json(os);
+            break;
+        case TimeReportFormat::None:
+            break;
+    }
+}
+
+void TimeReport::print_table(llvm::raw_ostream& os) const {
+    os << "===-------------------------------------------------------===\n"
+       << "                    Knight time report\n"
+       << "===-------------------------------------------------------===\n";
+    const bool is_perf_enabled = this->is_perf_enabled();
+    for (unsigned kind = 0U; kind < NumTimeReportKinds; ++kind) {
+        os << "\n"
+           << get_kind_name(static_cast< TimeReportKind >(kind)) << ":\n"
+           << "   Wall (ms)     CPU (ms)      Count  ";
+        if (is_perf_enabled) {
+            os << "Instructions       Cycles CacheMisses  BranchMisses  ";
+        }
+        os << "Name\n";
+        for (const auto* entry : get_sorted(m_times[kind], time_less)) {
+            const auto& time = entry->second;
+            os << llvm::format("%12.3f %12.3f %10llu  ",
+                               to_millis(time.wall),
+                               to_millis(time.cpu),
+                               static_cast< unsigned long long >(time.count));
+            if (is_perf_enabled) {
+                os << llvm::format("%12llu %12llu %11llu %13llu  ",
+                                   static_cast< unsigned long long >(
+                                       time.perf[0U]),
+                                   static_cast< unsigned long long >(
+                                       time.perf[1U]),
+                                   static_cast< unsigned long long >(
+                                       time.perf[2U]),
+                                   static_cast< unsigned long long >(
+                                       time.perf[3U]));
+            }
+            os << entry->getKey() << "\n";
+        }
+    }
+
+    os << "\ncycles:\n"
+       << "  Iterations     Visits  Head\n";
+    for (const auto* entry : get_sorted(m_cycles, cycle_less)) {
+        const auto& cycle = entry->second;
+        os << llvm::format("%12llu %10llu  ",
+                           static_cast< unsigned long long >(cycle.iterations),
+                           static_cast< unsigned long long >(cycle.visits))
+           << entry->getKey() << "\n";
+    }
+    os.flush();
+}
+
+void TimeReport::print_json(llvm::raw_ostream& os) const {
+    llvm::json::Object report;
+    const bool is_perf_enabled = this->is_perf_enabled();
+    for (unsigned kind = 0U; kind < NumTimeReportKinds; ++kind) {
+        llvm::json::Array entries;
+        for (const auto* entry : get_sorted(m_times[kind], time_less)) {
+            const auto& time = entry->second;
+            llvm::json::Object json_entry{{"name", entry->getKey()},
+                                          {"wall_ms", to_millis(time.wall)},
+                                          {"cpu_ms", to_millis(time.cpu)},
+                                          {"count", time.count}};
+            if (is_perf_enabled) {
+                for (unsigned counter = 0U; counter < NumPerfCounterKinds;
+                     ++counter) {
+                    json_entry[PerfCounters::get_name(
+                        static_cast< PerfCounterKind >(counter))] =
+                        time.perf[counter];
+                }
+            }
+            entries.push_back(std::move(json_entry));
+        }
+        report[get_kind_name(static_cast< TimeReportKind >(kind))] =
+            std::move(entries);
+    }
+
+    llvm::json::Array cycles;
+    for (const auto* entry : get_sorted(m_cycles, cycle_less)) {
+        cycles.push_back(llvm::json::Object{{"head", entry->getKey()},
+                                            {"iterations",
+                                             entry->second.iterations},
+                                            {"visits", entry->second.visits}});
+    }
+    report["cycles"] = std::move(cycles);
+
+    os << llvm::formatv("{0:2}", llvm::json::Value(std::move(report))) << "\n";
+    os.flush();
+}
+
+} // namespace knight
@@ -0,0 +1,76 @@
+//===- trace.cpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the helpers of the Chrome trace export.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/trace.hpp"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <atomic>
+
+namespace knight::trace {
+
+namespace {
+
+constexpr llvm::StringLiteral ProcName = "knight";
+
+std::atomic< bool > IsEnabled{false};      // NOLINT
+std::atomic< unsigned > GranularityUs{0U}; // NOLINT
+
+} // anonymous namespace
+
+void initialize(unsigned granularity_us) {
+    GranularityUs.store(granularity_us);
+    IsEnabled.store(true);
+    llvm::timeTraceProfilerInitialize(granularity_us, ProcName);
+}
+
+bool is_enabled() {
+    return IsEnabled.load(std::memory_order_relaxed);
+}
+
+bool finish(llvm::StringRef file) {
+    if (!is_enabled()) {
+        return true;
+    }
+    IsEnabled.store(false);
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(file, ec, llvm::sys::fs::OF_Text);
+    if (ec) {
+        llvm::WithColor::error() << "Failed to open the trace file `" << file
+                                 << "`: " << ec.message() << "\n";
+        llvm::timeTraceProfilerCleanup();
+        return false;
+    }
+    llvm::timeTraceProfilerWrite(os);
+    llvm::timeTraceProfilerCleanup();
+    return true;
+}
+
+ThreadScope::ThreadScope() {
+    if (is_enabled() && llvm::getTimeTraceProfilerInstance() == nullptr) {
+        llvm::timeTraceProfilerInitialize(GranularityUs.load(), ProcName);
+        m_is_started = true;
+    }
+}
+
+ThreadScope::~ThreadScope() {
+    if (m_is_started) {
+        llvm::timeTraceProfilerFinishThread();
+    }
+}
+
+} // namespace knight::trace
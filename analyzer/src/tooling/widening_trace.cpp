@@ -0,0 +1,117 @@
+//===- widening_trace.cpp ---------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the trace of the fixpoint iterations at the cycle
+//  heads.
+//
+//===------------------------------------------------------------------===//
+
+#include "analyzer/tooling/widening_trace.hpp"
+#include "analyzer/core/domain/domains.hpp"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+
+namespace knight {
+
+namespace {
+
+llvm::StringRef get_kind_name(analyzer::IterationKind kind) {
+    switch (kind) {
+        case analyzer::IterationKind::Increasing:
+            return "increasing";
+        case analyzer::IterationKind::Decreasing:
+            return "decreasing";
+    }
+    return "";
+}
+
+llvm::StringRef get_op_name(analyzer::HeadOpKind op) {
+    switch (op) {
+        case analyzer::HeadOpKind::Join:
+            return "join";
+        case analyzer::HeadOpKind::Widen:
+            return "widen";
+        case analyzer::HeadOpKind::WidenWithThreshold:
+            return "widen_with_threshold";
+        case analyzer::HeadOpKind::Narrow:
+            return "narrow";
+        case analyzer::HeadOpKind::NarrowWithThreshold:
+            return "narrow_with_threshold";
+    }
+    return "";
+}
+
+std::string to_string(const analyzer::ZInterval& value) {
+    std::string str;
+    llvm::raw_string_ostream os(str);
+    os << value;
+    return os.str();
+}
+
+} // anonymous namespace
+
+WideningTrace& WideningTrace::get() {
+    static WideningTrace trace;
+    return trace;
+}
+
+std::string WideningTrace::open(llvm::StringRef file) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    std::error_code err;
+    auto os = std::make_unique< llvm::raw_fd_ostream >(file,
+                                                       err,
+                                                       llvm::sys::fs::OF_Text);
+    if (err) {
+        return err.message();
+    }
+    m_os = std::move(os);
+    m_is_enabled.store(true, std::memory_order_relaxed);
+    return "";
+}
+
+void WideningTrace::close() {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    m_is_enabled.store(false, std::memory_order_relaxed);
+    m_os.reset();
+}
+
+void WideningTrace::add_iteration(llvm::StringRef function,
+                                  unsigned head,
+                                  unsigned iteration,
+                                  analyzer::IterationKind kind,
+                                  analyzer::HeadOpKind op,
+                                  const analyzer::StateChanges& changes) {
+    llvm::json::Array domains;
+    for (const auto id : changes.domains) {
+        domains.push_back(analyzer::get_domain_name_by_id(id));
+    }
+    llvm::json::Array changed;
+    for (const auto& change : changes.regions) {
+        changed.push_back(
+            llvm::json::Object{{"region", change.region->to_string()},
+                               {"previous", to_string(change.previous)},
+                               {"value", to_string(change.value)}});
+    }
+    llvm::json::Value line(llvm::json::Object{{"function", function},
+                                              {"head", head},
+                                              {"iteration", iteration},
+                                              {"kind", get_kind_name(kind)},
+                                              {"op", get_op_name(op)},
+                                              {"domains", std::move(domains)},
+                                              {"changed",
+                                               std::move(changed)}});
+
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    if (m_os != nullptr) {
+        *m_os << line << "\n";
+    }
+}
+
+} // namespace knight
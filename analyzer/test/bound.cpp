@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "analyzer/core/domain/bound.hpp"
+#include "analyzer/core/domain/interval.hpp"
+
+namespace knight::analyzer {
+
+void PrintTo(const SmallBound& b, std::ostream* os) { // NOLINT
+    std::string str;
+    llvm::raw_string_ostream sos(str);
+    b.dump(sos);
+    *os << sos.str();
+}
+
+} // namespace knight::analyzer
+
+using namespace knight::analyzer;
+
+namespace {
+
+constexpr int64_t Int64Min = std::numeric_limits< int64_t >::min();
+constexpr int64_t Int64Max = std::numeric_limits< int64_t >::max();
+
+const SmallBound PInf = SmallBound::pinf();
+const SmallBound NInf = SmallBound::ninf();
+const SmallBound MaxFinite = SmallBound::max_finite();
+const SmallBound MinFinite = SmallBound::min_finite();
+
+} // anonymous namespace
+
+TEST(SmallBound, ExtremesReadAsInfinities) {
+    EXPECT_EQ(PInf, SmallBound(Int64Max));
+    EXPECT_EQ(NInf, SmallBound(Int64Min));
+    EXPECT_TRUE(SmallBound(Int64Max).is_pinf());
+    EXPECT_TRUE(SmallBound(Int64Min).is_ninf());
+    EXPECT_FALSE(SmallBound(Int64Max).get_num_opt().has_value());
+    EXPECT_FALSE(SmallBound(Int64Max).is_num(Int64Max));
+
+    EXPECT_TRUE(MaxFinite.is_finite());
+    EXPECT_TRUE(MinFinite.is_finite());
+    EXPECT_EQ(Int64Max - 1, MaxFinite.get_num());
+    EXPECT_EQ(Int64Min + 1, MinFinite.get_num());
+
+    SmallBound b(0);
+    b = Int64Max;
+    EXPECT_TRUE(b.is_pinf());
+}
+
+TEST(SmallBound, OrderAsWords) {
+    EXPECT_LT(NInf, MinFinite);
+    EXPECT_LT(MinFinite, SmallBound(0));
+    EXPECT_LT(SmallBound(0), MaxFinite);
+    EXPECT_LT(MaxFinite, PInf);
+    EXPECT_EQ(NInf, min(PInf, NInf, MinFinite));
+    EXPECT_EQ(PInf, max(MaxFinite, PInf, NInf));
+}
+
+TEST(SmallBound, NegateSaturatesTheSmallestFinite) {
+    EXPECT_EQ(NInf, -PInf);
+    EXPECT_EQ(PInf, -NInf);
+    EXPECT_EQ(SmallBound(Int64Min + 2), -MaxFinite);
+    EXPECT_EQ(MaxFinite, -(-MaxFinite));
+    // -(INT64_MIN + 1) is the exact INT64_MAX, which reads as +oo.
+    EXPECT_EQ(PInf, -MinFinite);
+    EXPECT_EQ(PInf, abs(NInf));
+}
+
+TEST(SmallBound, AddSaturates) {
+    EXPECT_EQ(SmallBound(3), SmallBound(1) + SmallBound(2));
+    // Lands on the sentinel without overflowing.
+    EXPECT_EQ(PInf, MaxFinite + SmallBound(1));
+    EXPECT_EQ(NInf, MinFinite + SmallBound(-1));
+    // Overflows.
+    EXPECT_EQ(PInf, MaxFinite + MaxFinite);
+    EXPECT_EQ(NInf, MinFinite + MinFinite);
+    EXPECT_EQ(SmallBound(-1), MaxFinite + MinFinite);
+    EXPECT_EQ(PInf, PInf + SmallBound(-5));
+    EXPECT_EQ(NInf, MaxFinite + NInf);
+
+    SmallBound b = MaxFinite;
+    b += SmallBound(1);
+    EXPECT_TRUE(b.is_pinf());
+}
+
+TEST(SmallBound, SubSaturates) {
+    EXPECT_EQ(NInf, MinFinite - SmallBound(1));
+    EXPECT_EQ(PInf, SmallBound(0) - MinFinite);
+    EXPECT_EQ(NInf, SmallBound(-2) - MaxFinite);
+    EXPECT_EQ(PInf, MaxFinite - MinFinite);
+    EXPECT_EQ(NInf, MinFinite - MaxFinite);
+    EXPECT_EQ(NInf, SmallBound(7) - PInf);
+    EXPECT_EQ(PInf, PInf - NInf);
+}
+
+TEST(SmallBound, MulSaturates) {
+    const SmallBound pow31(int64_t{1} << 31);
+    const SmallBound pow32(int64_t{1} << 32);
+
+    EXPECT_EQ(PInf, MaxFinite * SmallBound(2));
+    EXPECT_EQ(NInf, MaxFinite * SmallBound(-2));
+    EXPECT_EQ(PInf, pow32 * pow31);
+    // -2^63 is exact, and reads as -oo.
+    EXPECT_EQ(NInf, -pow32 * pow31);
+    EXPECT_EQ(NInf, PInf * SmallBound(-1));
+    EXPECT_EQ(PInf, NInf * NInf);
+    EXPECT_EQ(SmallBound(0), PInf * SmallBound(0));
+    EXPECT_EQ(SmallBound(Int64Min + 2), MaxFinite * SmallBound(-1));
+    EXPECT_EQ(PInf, MinFinite * SmallBound(-1));
+}
+
+TEST(SmallBound, DivSaturates) {
+    EXPECT_EQ(PInf, MinFinite / SmallBound(-1));
+    EXPECT_EQ(SmallBound(-3), SmallBound(-7) / SmallBound(2));
+    EXPECT_EQ(SmallBound(0), SmallBound(7) / PInf);
+    EXPECT_EQ(PInf, NInf / SmallBound(-3));
+    EXPECT_EQ(NInf, PInf / SmallBound(-3));
+}
+
+TEST(SmallBound, ShiftSaturates) {
+    EXPECT_EQ(SmallBound(int64_t{1} << 62), SmallBound(1) << SmallBound(62));
+    EXPECT_EQ(PInf, SmallBound(1) << SmallBound(63));
+    EXPECT_EQ(NInf, SmallBound(-1) << SmallBound(63));
+    EXPECT_EQ(PInf, SmallBound(2) << SmallBound(62));
+    EXPECT_EQ(NInf, SmallBound(-2) << SmallBound(62));
+    EXPECT_EQ(PInf, SmallBound(1) << PInf);
+    EXPECT_EQ(SmallBound(-1), SmallBound(-1) >> PInf);
+    EXPECT_EQ(SmallBound(0), MaxFinite >> SmallBound(63));
+    EXPECT_EQ(SmallBound(-2), MinFinite >> SmallBound(62));
+}
+
+TEST(SmallInterval, RoundSaturatedBounds) {
+    // The exact INT64_MAX is +oo, so the singleton is widened up.
+    const SmallInterval singleton(Int64Max, Int64Max);
+    EXPECT_EQ(MaxFinite, singleton.get_lb());
+    EXPECT_EQ(PInf, singleton.get_ub());
+    EXPECT_FALSE(singleton.is_bottom());
+
+    SmallInterval up(MaxFinite, MaxFinite);
+    up += SmallInterval(int64_t{1});
+    EXPECT_EQ(MaxFinite, up.get_lb());
+    EXPECT_EQ(PInf, up.get_ub());
+
+    SmallInterval down(MinFinite, MinFinite);
+    down -= SmallInterval(int64_t{1});
+    EXPECT_EQ(NInf, down.get_lb());
+    EXPECT_EQ(MinFinite, down.get_ub());
+
+    SmallInterval mixed(SmallBound(-1), MaxFinite);
+    mixed += SmallInterval(int64_t{1});
+    EXPECT_EQ(SmallBound(0), mixed.get_lb());
+    EXPECT_EQ(PInf, mixed.get_ub());
+
+    const SmallInterval negated = -SmallInterval(NInf, MinFinite);
+    EXPECT_EQ(MaxFinite, negated.get_lb());
+    EXPECT_EQ(PInf, negated.get_ub());
+}
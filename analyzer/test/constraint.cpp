@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "analyzer/core/constraint/constraint.hpp"
+#include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/core/domain/num/znum.hpp"
+#include "test_env.hpp"
+
+using namespace knight::analyzer;
+using knight::test::AnalyzerEnv;
+
+namespace {
+
+constexpr const char* Code = "void f(void) {}";
+
+ZLinearConstraint le(const ZVariable& var, int bound) {
+    return var <= ZNum(bound);
+}
+
+bool contains(const ZLinearConstraintSystem& system,
+              const ZLinearConstraint& cst) {
+    for (const auto& other : system) {
+        if (other.equals(cst)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+TEST(LinearConstraintSystem, RetainKeepsCommonConstraints) {
+    AnalyzerEnv env(Code);
+    const auto vars = env.make_vars("f", 3U);
+    const auto& x = vars[0];
+    const auto& y = vars[1];
+    const auto& z = vars[2];
+
+    ZLinearConstraintSystem lhs{le(x, 3), le(y, 1)};
+    const ZLinearConstraintSystem rhs{le(z, 2), le(x, 3)};
+    lhs.retain_common_linear_constraint_system(rhs);
+    ASSERT_EQ(1U, lhs.size());
+    EXPECT_TRUE(contains(lhs, le(x, 3)));
+
+    ZLinearConstraintSystem disjoint{le(y, 1)};
+    disjoint.retain_common_linear_constraint_system(rhs);
+    EXPECT_TRUE(disjoint.is_empty());
+}
+
+TEST(ConstraintSystem, JoinKeepsSharedConstraint) {
+    AnalyzerEnv env(Code);
+    const auto vars = env.make_vars("f", 2U);
+    const auto& x = vars[0];
+    const auto& y = vars[1];
+
+    ConstraintSystem then_branch;
+    then_branch.add_zlinear_constraint(le(x, 3));
+    then_branch.add_zlinear_constraint(le(y, 1));
+    ConstraintSystem else_branch;
+    else_branch.add_zlinear_constraint(le(y, 2));
+    else_branch.add_zlinear_constraint(le(x, 3));
+
+    // Only the equal constraints are kept, `y <= 2` is dropped though
+    // implied by both sides, which only loses precision.
+    then_branch.retain(else_branch);
+    const auto& joined = then_branch.get_zlinear_constraint_system();
+    ASSERT_EQ(1U, joined.size());
+    EXPECT_TRUE(contains(joined, le(x, 3)));
+
+    ConstraintSystem same;
+    same.add_zlinear_constraint(le(x, 3));
+    same.retain(then_branch);
+    EXPECT_TRUE(same == then_branch);
+}
+
+TEST(LinearConstraintSystem, InsertKeepsTighterBound) {
+    AnalyzerEnv env(Code);
+    const auto vars = env.make_vars("f", 2U);
+    const auto& x = vars[0];
+    const auto& y = vars[1];
+
+    ZLinearConstraintSystem system;
+    system.insert_linear_constraint(le(x, 5));
+    system.insert_linear_constraint(le(x, 3));
+    ASSERT_EQ(1U, system.size());
+    EXPECT_TRUE(contains(system, le(x, 3)));
+
+    system.insert_linear_constraint(le(x, 4));
+    system.insert_linear_constraint(le(x, 3));
+    ASSERT_EQ(1U, system.size());
+    EXPECT_TRUE(contains(system, le(x, 3)));
+
+    // A lower bound is over other terms, and is kept aside.
+    system.insert_linear_constraint(x >= ZNum(2));
+    system.insert_linear_constraint(ZLinearExpr(ZNum(0)) <= ZNum(1));
+    EXPECT_EQ(2U, system.size());
+
+    // The constraint hit by a looser one becomes the most recent.
+    system.insert_linear_constraint(le(y, 1));
+    system.insert_linear_constraint(le(x, 7));
+    const auto& csts = system.get_linear_constraints();
+    ASSERT_EQ(3U, csts.size());
+    EXPECT_TRUE(csts[1].equals(le(y, 1)));
+    EXPECT_TRUE(csts[2].equals(le(x, 3)));
+}
+
+TEST(ConstraintSystem, CapLinearConstraints) {
+    constexpr unsigned num_vars = MaxZLinearConstraints + 6U;
+    AnalyzerEnv env(Code);
+    const auto vars = env.make_vars("f", num_vars);
+
+    ConstraintSystem system;
+    for (unsigned i = 0U; i < num_vars; ++i) {
+        system.add_zlinear_constraint(le(vars[i], static_cast< int >(i)));
+    }
+    const auto& linear = system.get_zlinear_constraint_system();
+    ASSERT_EQ(MaxZLinearConstraints, linear.size());
+    // The least recently inserted ones are evicted.
+    EXPECT_FALSE(contains(linear, le(vars[5], 5)));
+    EXPECT_TRUE(contains(linear, le(vars[6], 6)));
+    EXPECT_TRUE(contains(linear,
+                         le(vars[num_vars - 1U],
+                            static_cast< int >(num_vars - 1U))));
+
+    // Hitting a constraint again saves it from the next eviction.
+    system.add_zlinear_constraint(le(vars[6], 6));
+    system.add_zlinear_constraint(le(vars[0], 0));
+    ASSERT_EQ(MaxZLinearConstraints, linear.size());
+    EXPECT_TRUE(contains(linear, le(vars[6], 6)));
+    EXPECT_FALSE(contains(linear, le(vars[7], 7)));
+    EXPECT_TRUE(contains(linear, le(vars[0], 0)));
+
+    // The merges are capped as well.
+    ConstraintSystem other;
+    for (unsigned i = 0U; i < num_vars; ++i) {
+        other.add_zlinear_constraint(le(vars[i], -static_cast< int >(i)));
+    }
+    system.merge(other);
+    EXPECT_EQ(MaxZLinearConstraints, linear.size());
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "analyzer/core/domain/set/discrete_domain.hpp"
+
+using namespace knight::analyzer;
+
+namespace {
+
+constexpr DenseID NumElements = 48U;
+
+/// \brief An element with a dense ID, of which the large sets are indexed
+/// by a bitset.
+struct Element {
+    DenseID id;
+
+    [[nodiscard]] DenseID get_dense_id() const { return id; }
+    void dump(llvm::raw_ostream& os) const { os << id; }
+}; // struct Element
+
+/// \brief An element without dense ID, of which the sets always stay on
+/// the sorted vector. They are ordered by their addresses, i.e., by their
+/// index in the pool.
+struct PlainElement {
+    DenseID id;
+
+    void dump(llvm::raw_ostream& os) const { os << id; }
+}; // struct PlainElement
+
+using IndexedSet = DiscreteDom< const Element*, DomainKind::PointToSetDomain >;
+using VectorSet =
+    DiscreteDom< const PlainElement*, DomainKind::PointToSetDomain >;
+using Oracle = std::set< DenseID >;
+
+static_assert(IndexedSet::IsIndexable);
+static_assert(!VectorSet::IsIndexable);
+
+/// \brief The pools, the IDs of the indexed elements being in the
+/// reverse order of their addresses.
+const std::vector< Element >& get_elements() {
+    static const std::vector< Element > elements = [] {
+        std::vector< Element > elements;
+        for (DenseID id = NumElements; id > 0U; --id) {
+            elements.push_back({id - 1U});
+        }
+        return elements;
+    }();
+    return elements;
+}
+
+const Element* get_element(DenseID id) {
+    return &get_elements()[NumElements - 1U - id];
+}
+
+const std::vector< PlainElement >& get_plain_elements() {
+    static const std::vector< PlainElement > elements = [] {
+        std::vector< PlainElement > elements;
+        for (DenseID id = 0U; id < NumElements; ++id) {
+            elements.push_back({id});
+        }
+        return elements;
+    }();
+    return elements;
+}
+
+const PlainElement* get_plain_element(DenseID id) {
+    return &get_plain_elements()[id];
+}
+
+template < typename Set >
+std::vector< DenseID > get_ids(const Set& set) {
+    std::vector< DenseID > ids;
+    for (const auto* element : set.get_set()) {
+        ids.push_back(element->id);
+    }
+    return ids;
+}
+
+std::vector< DenseID > get_ids(const Oracle& oracle) {
+    return {oracle.begin(), oracle.end()};
+}
+
+bool intersects(const Oracle& lhs, const Oracle& rhs) {
+    return std::any_of(lhs.begin(), lhs.end(), [&](DenseID id) {
+        return rhs.count(id) != 0U;
+    });
+}
+
+Oracle get_union(const Oracle& lhs, const Oracle& rhs) {
+    Oracle result = lhs;
+    result.insert(rhs.begin(), rhs.end());
+    return result;
+}
+
+Oracle get_intersection(const Oracle& lhs, const Oracle& rhs) {
+    Oracle result;
+    std::set_intersection(lhs.begin(),
+                          lhs.end(),
+                          rhs.begin(),
+                          rhs.end(),
+                          std::inserter(result, result.end()));
+    return result;
+}
+
+Oracle get_difference(const Oracle& lhs, const Oracle& rhs) {
+    Oracle result;
+    std::set_difference(lhs.begin(),
+                        lhs.end(),
+                        rhs.begin(),
+                        rhs.end(),
+                        std::inserter(result, result.end()));
+    return result;
+}
+
+} // anonymous namespace
+
+TEST(DiscreteDom, IndexAboveThreshold) {
+    IndexedSet large = IndexedSet::bottom();
+    for (DenseID id = 0U; id <= DiscreteSetIndexThreshold; ++id) {
+        large.add(get_element(id));
+    }
+    EXPECT_EQ(DiscreteSetIndexThreshold + 1U, large.size());
+    for (DenseID id = 0U; id < NumElements; ++id) {
+        EXPECT_EQ(id <= DiscreteSetIndexThreshold,
+                  large.contains(get_element(id)));
+    }
+
+    // A small set is compared to an indexed one by the vector.
+    IndexedSet small{get_element(3U), get_element(40U)};
+    EXPECT_TRUE(small.intersects(large));
+    EXPECT_TRUE(large.intersects(small));
+    EXPECT_FALSE(small.leq(large));
+    small.remove(get_element(40U));
+    EXPECT_TRUE(small.leq(large));
+
+    // The set is back on the vector at the threshold.
+    large.remove(get_element(0U));
+    EXPECT_EQ(DiscreteSetIndexThreshold, large.size());
+    EXPECT_FALSE(large.contains(get_element(0U)));
+    EXPECT_TRUE(large.contains(get_element(DiscreteSetIndexThreshold)));
+    large.add(get_element(0U));
+    EXPECT_TRUE(large.contains(get_element(0U)));
+
+    // Two indexed sets are compared by their bitsets.
+    IndexedSet other = IndexedSet::bottom();
+    for (DenseID id = NumElements - 20U; id < NumElements; ++id) {
+        other.add(get_element(id));
+    }
+    EXPECT_FALSE(large.intersects(other));
+    other.add(get_element(DiscreteSetIndexThreshold));
+    EXPECT_TRUE(large.intersects(other));
+    EXPECT_FALSE(large.leq(other));
+
+    IndexedSet joined = large;
+    EXPECT_TRUE(joined.join_with_changed(other));
+    EXPECT_TRUE(large.leq(joined));
+    EXPECT_TRUE(other.leq(joined));
+    EXPECT_FALSE(joined.join_with_changed(large));
+}
+
+TEST(DiscreteDom, BitsetAndVectorAgree) {
+    constexpr unsigned NumSets = 3U;
+    constexpr unsigned NumSteps = 4000U;
+    std::mt19937 rng(7U);
+    std::vector< IndexedSet > indexed(NumSets, IndexedSet::bottom());
+    std::vector< VectorSet > plain(NumSets, VectorSet::bottom());
+    std::vector< Oracle > oracles(NumSets);
+
+    for (unsigned step = 0U; step < NumSteps; ++step) {
+        const auto dst = rng() % NumSets;
+        const auto src = rng() % NumSets;
+        const auto id = static_cast< DenseID >(rng() % NumElements);
+        bool is_changed = false;
+        bool is_oracle_changed = false;
+        // The additions are the most frequent, so that the sets often
+        // cross the threshold both ways.
+        switch (rng() % 8U) {
+            case 0U:
+            case 1U:
+            case 2U:
+                indexed[dst].add(get_element(id));
+                plain[dst].add(get_plain_element(id));
+                oracles[dst].insert(id);
+                break;
+            case 3U:
+            case 4U:
+                indexed[dst].remove(get_element(id));
+                plain[dst].remove(get_plain_element(id));
+                oracles[dst].erase(id);
+                break;
+            case 5U: {
+                is_changed = indexed[dst].join_with_changed(indexed[src]);
+                EXPECT_EQ(is_changed,
+                          plain[dst].join_with_changed(plain[src]));
+                auto joined = get_union(oracles[dst], oracles[src]);
+                is_oracle_changed = joined != oracles[dst];
+                oracles[dst] = std::move(joined);
+                break;
+            }
+            case 6U: {
+                is_changed = indexed[dst].meet_with_changed(indexed[src]);
+                EXPECT_EQ(is_changed,
+                          plain[dst].meet_with_changed(plain[src]));
+                auto met = get_intersection(oracles[dst], oracles[src]);
+                is_oracle_changed = met != oracles[dst];
+                oracles[dst] = std::move(met);
+                break;
+            }
+            default:
+                indexed[dst].diff_with(indexed[src]);
+                plain[dst].diff_with(plain[src]);
+                oracles[dst] = get_difference(oracles[dst], oracles[src]);
+                break;
+        }
+        ASSERT_EQ(is_oracle_changed, is_changed) << "step " << step;
+
+        for (unsigned lhs = 0U; lhs < NumSets; ++lhs) {
+            ASSERT_EQ(get_ids(oracles[lhs]), get_ids(indexed[lhs]))
+                << "step " << step;
+            ASSERT_EQ(get_ids(oracles[lhs]), get_ids(plain[lhs]))
+                << "step " << step;
+            for (DenseID elem = 0U; elem < NumElements; ++elem) {
+                const bool is_in = oracles[lhs].count(elem) != 0U;
+                ASSERT_EQ(is_in, indexed[lhs].contains(get_element(elem)));
+                ASSERT_EQ(is_in,
+                          plain[lhs].contains(get_plain_element(elem)));
+            }
+            for (unsigned rhs = 0U; rhs < NumSets; ++rhs) {
+                const bool is_subset = std::includes(oracles[rhs].begin(),
+                                                     oracles[rhs].end(),
+                                                     oracles[lhs].begin(),
+                                                     oracles[lhs].end());
+                ASSERT_EQ(is_subset, indexed[lhs].leq(indexed[rhs]));
+                ASSERT_EQ(is_subset, plain[lhs].leq(plain[rhs]));
+                const bool is_shared =
+                    intersects(oracles[lhs], oracles[rhs]);
+                ASSERT_EQ(is_shared, indexed[lhs].intersects(indexed[rhs]));
+                ASSERT_EQ(is_shared, plain[lhs].intersects(plain[rhs]));
+                ASSERT_EQ(oracles[lhs] == oracles[rhs],
+                          indexed[lhs].equals(indexed[rhs]));
+            }
+        }
+    }
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+
+#include "analyzer/core/domain/num/fixed_machine_znum.hpp"
+
+namespace knight::analyzer {
+
+template < unsigned Bits, Signedness Sign >
+void PrintTo(FixedMachineZNum< Bits, Sign > n, std::ostream* os) { // NOLINT
+    *os << n.str();
+}
+
+} // namespace knight::analyzer
+
+using namespace knight::analyzer;
+
+namespace {
+
+template < typename T >
+class SignedFixedMachineZNum : public ::testing::Test {};
+
+using SignedTypes =
+    ::testing::Types< MachineInt8, MachineInt16, MachineInt32, MachineInt64 >;
+
+template < typename T >
+class UnsignedFixedMachineZNum : public ::testing::Test {};
+
+using UnsignedTypes = ::testing::Types< MachineUInt8,
+                                        MachineUInt16,
+                                        MachineUInt32,
+                                        MachineUInt64 >;
+
+} // anonymous namespace
+
+TYPED_TEST_SUITE(SignedFixedMachineZNum, SignedTypes);
+TYPED_TEST_SUITE(UnsignedFixedMachineZNum, UnsignedTypes);
+
+TYPED_TEST(SignedFixedMachineZNum, MinDivMinusOneWraps) {
+    const TypeParam min = TypeParam::min();
+    const TypeParam minus_one(-1);
+
+    EXPECT_EQ(min, min / minus_one);
+    EXPECT_EQ(TypeParam::zero(), min % minus_one);
+    EXPECT_EQ(min, -min);
+    EXPECT_EQ(min, abs(min));
+    EXPECT_TRUE((min / minus_one).is_negative());
+}
+
+TYPED_TEST(SignedFixedMachineZNum, DivRoundsTowardsZero) {
+    const TypeParam seven(7);
+    const TypeParam minus_seven(-7);
+    const TypeParam two(2);
+    const TypeParam minus_two(-2);
+
+    EXPECT_EQ(TypeParam(-3), minus_seven / two);
+    EXPECT_EQ(TypeParam(-1), minus_seven % two);
+    EXPECT_EQ(TypeParam(-3), seven / minus_two);
+    EXPECT_EQ(TypeParam(1), seven % minus_two);
+    EXPECT_EQ(TypeParam(3), minus_seven / minus_two);
+    EXPECT_EQ(TypeParam(-1), minus_seven % minus_two);
+}
+
+TYPED_TEST(SignedFixedMachineZNum, AddSubOverflowAtEdges) {
+    const TypeParam min = TypeParam::min();
+    const TypeParam max = TypeParam::max();
+    const TypeParam one(1);
+    bool overflow = false;
+
+    EXPECT_EQ(min, TypeParam::add(max, one, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(max, TypeParam::sub(min, one, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(max, TypeParam::add(max - one, one, overflow));
+    EXPECT_FALSE(overflow);
+    EXPECT_EQ(TypeParam(-1), TypeParam::add(min, max, overflow));
+    EXPECT_FALSE(overflow);
+    EXPECT_EQ(TypeParam(-1), TypeParam::sub(max, min, overflow));
+    EXPECT_TRUE(overflow);
+}
+
+TYPED_TEST(SignedFixedMachineZNum, MulOverflowAtEdges) {
+    const TypeParam min = TypeParam::min();
+    const TypeParam minus_one(-1);
+    bool overflow = false;
+
+    EXPECT_EQ(min, TypeParam::mul(min, minus_one, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(TypeParam::max(),
+              TypeParam::mul(TypeParam::max(), TypeParam(1), overflow));
+    EXPECT_FALSE(overflow);
+    EXPECT_EQ(TypeParam::zero(), TypeParam::mul(min, TypeParam(2), overflow));
+    EXPECT_TRUE(overflow);
+}
+
+TYPED_TEST(SignedFixedMachineZNum, OrderIsSigned) {
+    EXPECT_LT(TypeParam::min(), TypeParam(-1));
+    EXPECT_LT(TypeParam(-1), TypeParam::zero());
+    EXPECT_LT(TypeParam::zero(), TypeParam::max());
+    EXPECT_EQ(TypeParam::min(), min(TypeParam::min(), TypeParam::max()));
+    EXPECT_EQ(TypeParam::max(), max(TypeParam(-1), TypeParam::max()));
+}
+
+TYPED_TEST(SignedFixedMachineZNum, ShiftsAtEdges) {
+    constexpr uint64_t top = TypeParam::BitWidth - 1U;
+
+    EXPECT_EQ(TypeParam::min(), TypeParam::shl(TypeParam(1), top));
+    EXPECT_EQ(TypeParam(-1), TypeParam::ashr(TypeParam::min(), top));
+    EXPECT_EQ(TypeParam(1), TypeParam::lshr(TypeParam::min(), top));
+    EXPECT_EQ(TypeParam::zero(), TypeParam::shl(TypeParam(2), top));
+}
+
+TYPED_TEST(UnsignedFixedMachineZNum, WrapAtEdges) {
+    const TypeParam max = TypeParam::max();
+    const TypeParam one(1);
+    bool overflow = false;
+
+    EXPECT_EQ(TypeParam::ones(), max);
+    EXPECT_EQ(TypeParam::zero(), TypeParam::add(max, one, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(max, TypeParam::sub(TypeParam::zero(), one, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(one, TypeParam::mul(max, max, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_EQ(max, -one);
+    EXPECT_LT(TypeParam::zero(), max);
+    EXPECT_EQ(TypeParam::zero(), max / max - one);
+    EXPECT_EQ(max, TypeParam(-1));
+}
+
+TEST(FixedMachineZNum, MaskAt8Bits) {
+    EXPECT_EQ(0x2CU, MachineUInt8(300).get_bits());
+    EXPECT_EQ(0xC8U, MachineInt8(200).get_bits());
+    EXPECT_EQ(-56, MachineInt8(200).get_signed_value());
+    EXPECT_EQ("-56", MachineInt8(200).str());
+    EXPECT_EQ("200", MachineUInt8(200).str());
+    EXPECT_EQ(MachineInt8(-128), MachineInt8(128));
+    EXPECT_EQ(MachineInt8(127), MachineInt8(-129));
+    EXPECT_EQ(MachineInt8(127), MachineInt8(ZNum(-129)));
+    EXPECT_EQ(MachineUInt8(1), MachineUInt8(ZNum(257)));
+    EXPECT_EQ(MachineUInt8(255), MachineUInt8(ZNum(-1)));
+    EXPECT_EQ(MachineInt8(100), MachineInt8(-56) + MachineInt8(-100));
+    EXPECT_EQ(MachineInt8::min(), MachineInt8(16) * MachineInt8(8));
+}
+
+TEST(FixedMachineZNum, MaskAt16Bits) {
+    EXPECT_EQ(0x2345U, MachineUInt16(0x12345).get_bits());
+    EXPECT_EQ(0x2345, MachineInt16(0x12345).get_signed_value());
+    EXPECT_EQ(-1, MachineInt16(0xFFFF).get_signed_value());
+    EXPECT_EQ(0xFFFFU, MachineInt16(-1).get_bits());
+    EXPECT_EQ(MachineInt16::min(), MachineInt16(ZNum(32768)));
+    EXPECT_EQ(MachineUInt16::zero(), MachineUInt16(256) * MachineUInt16(256));
+    EXPECT_EQ(MachineInt16(-2), ~MachineInt16(1));
+    EXPECT_EQ(MachineUInt16(0xFFFE), ~MachineUInt16(1));
+}
+
+TEST(FixedMachineZNum, MaskAt32Bits) {
+    constexpr int64_t int32_min = std::numeric_limits< int32_t >::min();
+    constexpr int64_t int32_max = std::numeric_limits< int32_t >::max();
+
+    EXPECT_EQ(int32_min, MachineInt32(int64_t{0x180000000}).get_signed_value());
+    EXPECT_EQ(0x80000000U, MachineUInt32(int64_t{0x180000000}).get_bits());
+    EXPECT_EQ(int32_min, MachineInt32::min().get_signed_value());
+    EXPECT_EQ(int32_max, MachineInt32::max().get_signed_value());
+    EXPECT_EQ(ZNum(int32_min), MachineInt32::min().to_z_number());
+    EXPECT_EQ(ZNum(uint64_t{0xFFFFFFFF}), MachineUInt32::max().to_z_number());
+    EXPECT_TRUE(MachineInt32::max().fits< int32_t >());
+    EXPECT_FALSE(MachineInt32::min().fits< uint32_t >());
+    EXPECT_FALSE(MachineUInt32::max().fits< int32_t >());
+    EXPECT_EQ(MachineInt32(-1), MachineInt32(ZNum(uint64_t{0xFFFFFFFF})));
+}
+
+TEST(FixedMachineZNum, MachineZNumRoundTrip) {
+    for (int64_t n : {-129, -128, -1, 0, 1, 127, 128, 255, 256}) {
+        const MachineInt8 s(n);
+        const MachineUInt8 u(n);
+
+        EXPECT_EQ(s, MachineInt8(s.to_machine_znum())) << n;
+        EXPECT_EQ(u, MachineUInt8(u.to_machine_znum())) << n;
+        EXPECT_EQ(s.get_bits(), u.get_bits()) << n;
+    }
+}
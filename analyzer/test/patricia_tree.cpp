@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "analyzer/util/patricia_tree.hpp"
+
+using namespace knight;
+
+namespace {
+
+using Tree = PatriciaTree< uint64_t, int >;
+using Map = std::map< uint64_t, int >;
+using Bindings = std::vector< std::pair< uint64_t, int > >;
+
+constexpr unsigned NumOps = 4000U;
+constexpr uint64_t TopBit = static_cast< uint64_t >(1) << 63U;
+
+/// \brief Draw the keys from a small range, half of them with the top bit
+/// set, so that the keys collide often and branch on every bit.
+uint64_t random_key(std::mt19937_64& rng) {
+    const uint64_t low = rng() % 256U;
+    return (rng() % 2U == 0U) ? low : (low | TopBit);
+}
+
+Bindings get_bindings(const Tree& tree) {
+    Bindings bindings;
+    tree.for_each([&bindings](uint64_t key, int value) {
+        bindings.emplace_back(key, value);
+    });
+    return bindings;
+}
+
+Bindings get_bindings(const Map& map) {
+    return {map.begin(), map.end()};
+}
+
+/// \brief Build a tree and its oracle by random insertions and removals.
+std::pair< Tree, Map > random_tree(std::mt19937_64& rng, unsigned num_ops) {
+    Tree tree;
+    Map map;
+    for (unsigned i = 0U; i < num_ops; ++i) {
+        const uint64_t key = random_key(rng);
+        if (rng() % 3U == 0U) {
+            tree.erase(key);
+            map.erase(key);
+        } else {
+            const int value = static_cast< int >(rng() % 100U);
+            tree.insert_or_assign(key, value);
+            map.insert_or_assign(key, value);
+        }
+    }
+    return {tree, map};
+}
+
+/// \brief Apply a few random updates on a copy, which shares the most of
+/// its nodes with the original tree.
+std::pair< Tree, Map > random_update(std::mt19937_64& rng,
+                                     const Tree& tree,
+                                     const Map& map,
+                                     unsigned num_ops) {
+    Tree new_tree = tree;
+    Map new_map = map;
+    for (unsigned i = 0U; i < num_ops; ++i) {
+        const uint64_t key = random_key(rng);
+        if (rng() % 2U == 0U) {
+            new_tree.erase(key);
+            new_map.erase(key);
+        } else {
+            const int value = static_cast< int >(rng() % 100U);
+            new_tree.insert_or_assign(key, value);
+            new_map.insert_or_assign(key, value);
+        }
+    }
+    return {new_tree, new_map};
+}
+
+std::optional< int > join_values(uint64_t /*key*/, int lhs, int rhs) {
+    if (lhs >= rhs) {
+        return std::nullopt;
+    }
+    return rhs;
+}
+
+bool is_subset(const Map& lhs, const Map& rhs) {
+    return std::all_of(lhs.begin(), lhs.end(), [&rhs](const auto& binding) {
+        auto it = rhs.find(binding.first);
+        return it != rhs.end() && binding.second <= it->second;
+    });
+}
+
+} // anonymous namespace
+
+TEST(PatriciaTree, InsertEraseAgainstMap) {
+    std::mt19937_64 rng(42U);
+    Tree tree;
+    Map map;
+    for (unsigned i = 0U; i < NumOps; ++i) {
+        const uint64_t key = random_key(rng);
+        if (rng() % 3U == 0U) {
+            tree.erase(key);
+            map.erase(key);
+        } else {
+            const int value = static_cast< int >(rng() % 100U);
+            tree.insert_or_assign(key, value);
+            map.insert_or_assign(key, value);
+        }
+
+        const uint64_t probe = random_key(rng);
+        const int* found = tree.find(probe);
+        auto it = map.find(probe);
+        ASSERT_EQ(it != map.end(), found != nullptr) << probe;
+        if (found != nullptr) {
+            ASSERT_EQ(it->second, *found) << probe;
+        }
+        ASSERT_EQ(map.empty(), tree.empty());
+    }
+    // The bindings are visited in the increasing order of the keys.
+    EXPECT_EQ(get_bindings(map), get_bindings(tree));
+
+    for (const auto& binding : map) {
+        tree.erase(binding.first);
+    }
+    EXPECT_TRUE(tree.empty());
+}
+
+TEST(PatriciaTree, CopiesArePersistent) {
+    std::mt19937_64 rng(7U);
+    auto [tree, map] = random_tree(rng, NumOps);
+
+    Tree copy = tree;
+    EXPECT_TRUE(copy.is_identical(tree));
+
+    auto [updated, updated_map] = random_update(rng, copy, map, 50U);
+    EXPECT_EQ(get_bindings(map), get_bindings(tree));
+    EXPECT_EQ(get_bindings(map), get_bindings(copy));
+    EXPECT_EQ(get_bindings(updated_map), get_bindings(updated));
+
+    // Erasing an absent key keeps the root.
+    Tree same = tree;
+    same.erase(TopBit | 1000U);
+    EXPECT_TRUE(same.is_identical(tree));
+}
+
+TEST(PatriciaTree, MergeAgainstMap) {
+    std::mt19937_64 rng(1234U);
+    for (unsigned round = 0U; round < 50U; ++round) {
+        auto [base, base_map] = random_tree(rng, 300U);
+        // Merge both a derived tree, sharing the most of its nodes, and an
+        // unrelated one.
+        auto [derived, derived_map] = random_update(rng, base, base_map, 10U);
+        auto [other, other_map] = random_tree(rng, 300U);
+
+        for (const auto* rhs : {&derived, &other}) {
+            const Map& rhs_map = (rhs == &derived) ? derived_map : other_map;
+
+            Map expected = base_map;
+            for (const auto& [key, value] : rhs_map) {
+                auto [it, inserted] = expected.emplace(key, value);
+                if (!inserted) {
+                    it->second = std::max(it->second, value);
+                }
+            }
+
+            Tree merged = base;
+            merged.merge_with(*rhs, join_values);
+            ASSERT_EQ(get_bindings(expected), get_bindings(merged)) << round;
+            ASSERT_EQ(get_bindings(base_map), get_bindings(base)) << round;
+
+            ASSERT_TRUE(base.is_subset_of(merged, std::less_equal<>()));
+            ASSERT_TRUE(rhs->is_subset_of(merged, std::less_equal<>()));
+            ASSERT_EQ(is_subset(base_map, rhs_map),
+                      base.is_subset_of(*rhs, std::less_equal<>()))
+                << round;
+            ASSERT_EQ(is_subset(rhs_map, base_map),
+                      rhs->is_subset_of(base, std::less_equal<>()))
+                << round;
+        }
+
+        Tree self = base;
+        self.merge_with(base, join_values);
+        ASSERT_TRUE(self.is_identical(base));
+    }
+}
+
+TEST(PatriciaTree, TransformKeepsUnchangedSubtrees) {
+    std::mt19937_64 rng(99U);
+    auto [tree, map] = random_tree(rng, NumOps);
+
+    Tree unchanged = tree;
+    unchanged.transform(
+        [](uint64_t /*key*/, int /*value*/) -> std::optional< int > {
+            return std::nullopt;
+        });
+    EXPECT_TRUE(unchanged.is_identical(tree));
+
+    Tree incremented = tree;
+    incremented.transform(
+        [](uint64_t key, int value) -> std::optional< int > {
+            if ((key & TopBit) == 0U) {
+                return std::nullopt;
+            }
+            return value + 1;
+        });
+    for (auto& [key, value] : map) {
+        if ((key & TopBit) != 0U) {
+            ++value;
+        }
+    }
+    EXPECT_EQ(get_bindings(map), get_bindings(incremented));
+}
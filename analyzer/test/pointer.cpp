@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "analyzer/core/domain/pointer.hpp"
+#include "test_env.hpp"
+
+using namespace knight::analyzer;
+using knight::test::AnalyzerEnv;
+
+namespace {
+
+constexpr unsigned NumGlobals = 40U;
+
+std::string get_code() {
+    std::string code = "int *p, *q, *r, *s;\n";
+    for (unsigned idx = 0U; idx < NumGlobals; ++idx) {
+        code += "int g" + std::to_string(idx) + ";\n";
+    }
+    return code + "void f(void) {}\n";
+}
+
+} // anonymous namespace
+
+TEST(PointerInfo, MayPointToSame) {
+    AnalyzerEnv env(get_code());
+    const auto* frame = env.get_top_frame("f");
+    const auto* loc_ctx = env.get_entry_location(frame);
+    auto get_def = [&](unsigned idx) {
+        return env.get_symbol_manager()
+            .get_region_def(env.get_region("g" + std::to_string(idx), frame),
+                            loc_ctx);
+    };
+    auto get_set = [&](unsigned begin, unsigned end) {
+        PointToSet set = PointToSet::bottom();
+        for (unsigned idx = begin; idx < end; ++idx) {
+            set.add(get_def(idx));
+        }
+        return set;
+    };
+
+    const auto* p = env.get_region("p", frame);
+    const auto* q = env.get_region("q", frame);
+    const auto* r = env.get_region("r", frame);
+    const auto* s = env.get_region("s", frame);
+
+    constexpr unsigned Large = DiscreteSetIndexThreshold + 1U;
+
+    // `p` is indexed, `q` and `r` are below the threshold.
+    PointerInfo info;
+    auto& point_to = info.get_region_point_to_ref();
+    point_to.set_value(p, get_set(0U, Large));
+    point_to.set_value(q, get_set(Large - 1U, Large + 3U));
+    point_to.set_value(r, get_set(Large, Large + 3U));
+
+    EXPECT_TRUE(info.may_point_to_same(p, q));
+    EXPECT_TRUE(info.may_point_to_same(q, r));
+    EXPECT_FALSE(info.may_point_to_same(p, r));
+    EXPECT_FALSE(info.may_point_to_same(r, p));
+
+    // All the sets indexed.
+    point_to.set_value(q, get_set(Large, NumGlobals));
+    point_to.set_value(r, get_set(1U, Large + 2U));
+    EXPECT_FALSE(info.may_point_to_same(q, p));
+    EXPECT_TRUE(info.may_point_to_same(q, r));
+    EXPECT_TRUE(info.may_point_to_same(p, r));
+
+    // A pointer of unknown point-to set may point to anything.
+    EXPECT_TRUE(info.may_point_to_same(s, p));
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <clang/AST/RecordLayout.h>
+
+#include "analyzer/core/region/region.hpp"
+#include "test_env.hpp"
+
+using namespace knight::analyzer;
+using knight::test::AnalyzerEnv;
+
+namespace {
+
+constexpr const char* Code = R"(
+struct S { char c; int i; long l; };
+struct T;
+struct S s;
+extern struct T t;
+int n;
+void f(void) {}
+)";
+
+} // anonymous namespace
+
+TEST(RegionManager, RecordLayout) {
+    AnalyzerEnv env(Code);
+    auto& mgr = env.get_region_manager();
+    const auto* record = env.find_decl< clang::RecordDecl >("S");
+    ASSERT_NE(nullptr, record);
+
+    auto layout = mgr.get_record_layout(record);
+    ASSERT_EQ(3U, layout.size());
+    const auto& ast_layout = env.get_ast_ctx().getASTRecordLayout(record);
+    unsigned idx = 0U;
+    for (const auto* field : record->fields()) {
+        EXPECT_EQ(field, layout[idx].field);
+        EXPECT_EQ(ast_layout.getFieldOffset(idx), layout[idx].offset);
+        EXPECT_EQ(field->getType(), layout[idx].type);
+        ++idx;
+    }
+    EXPECT_EQ(0U, layout[0].offset);
+    EXPECT_LT(layout[0].offset, layout[1].offset);
+    EXPECT_LT(layout[1].offset, layout[2].offset);
+
+    // The layout is queried once.
+    EXPECT_EQ(layout.data(), mgr.get_record_layout(record).data());
+}
+
+TEST(RegionManager, FieldRegions) {
+    AnalyzerEnv env(Code);
+    auto& mgr = env.get_region_manager();
+    const auto* frame = env.get_top_frame("f");
+
+    const auto* s = env.get_region("s", frame);
+    auto regions = mgr.get_field_regions(s);
+    ASSERT_EQ(3U, regions.size());
+    const auto* record = s->get_value_type()->getAsRecordDecl();
+    unsigned idx = 0U;
+    for (const auto* field : record->fields()) {
+        EXPECT_EQ(field, regions[idx]->get_field_decl());
+        EXPECT_EQ(s, regions[idx]->get_parent());
+        EXPECT_EQ(s->get_memory_space(), regions[idx]->get_memory_space());
+        EXPECT_EQ(mgr.get_field_region(field, s->get_memory_space(), s),
+                  regions[idx]);
+        ++idx;
+    }
+
+    // The field regions are interned.
+    auto again = mgr.get_field_regions(s);
+    ASSERT_EQ(regions.size(), again.size());
+    for (idx = 0U; idx < regions.size(); ++idx) {
+        EXPECT_EQ(regions[idx], again[idx]);
+    }
+
+    // The incomplete records and the scalars have no fields.
+    EXPECT_TRUE(mgr.get_field_regions(env.get_region("t", frame)).empty());
+    EXPECT_TRUE(mgr.get_field_regions(env.get_region("n", frame)).empty());
+}
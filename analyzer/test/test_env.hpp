@@ -0,0 +1,119 @@
+//===- test_env.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the environment shared by the analyzer tests.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "analyzer/core/constraint/linear.hpp"
+#include "analyzer/core/location_manager.hpp"
+#include "analyzer/core/region/region.hpp"
+#include "analyzer/core/symbol_manager.hpp"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace knight::test {
+
+/// \brief A parsed translation unit with the managers of the regions, the
+/// symbols and the locations of its declarations.
+class AnalyzerEnv {
+  private:
+    std::unique_ptr< clang::ASTUnit > m_ast;
+    llvm::BumpPtrAllocator m_alloc;
+    analyzer::RegionManager m_region_mgr{m_alloc};
+    analyzer::SymbolManager m_sym_mgr{m_alloc};
+    analyzer::LocationManager m_loc_mgr;
+    /// \brief The tags of the conjured variables, which keep them apart
+    /// since a statement conjures a single symbol per frame and tag.
+    std::deque< unsigned > m_var_tags;
+
+  public:
+    explicit AnalyzerEnv(const std::string& code,
+                         const std::string& file = "test.c")
+        : m_ast(clang::tooling::buildASTFromCode(code, file)) {
+        m_region_mgr.set_ast_ctx(m_ast->getASTContext());
+    }
+
+    [[nodiscard]] clang::ASTContext& get_ast_ctx() {
+        return m_ast->getASTContext();
+    }
+    [[nodiscard]] analyzer::RegionManager& get_region_manager() {
+        return m_region_mgr;
+    }
+    [[nodiscard]] analyzer::SymbolManager& get_symbol_manager() {
+        return m_sym_mgr;
+    }
+
+    /// \brief Find the top-level declaration of the name, null if none.
+    template < typename Decl >
+    [[nodiscard]] const Decl* find_decl(llvm::StringRef name) {
+        const auto* unit = get_ast_ctx().getTranslationUnitDecl();
+        for (const auto* decl : unit->decls()) {
+            const auto* named = llvm::dyn_cast< Decl >(decl);
+            if (named != nullptr && named->getName() == name) {
+                return named;
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] const analyzer::StackFrame* get_top_frame(
+        llvm::StringRef function) {
+        return m_loc_mgr.create_top_frame(
+            find_decl< clang::FunctionDecl >(function));
+    }
+
+    /// \brief Get the location at the entry of the frame.
+    [[nodiscard]] const analyzer::LocationContext* get_entry_location(
+        const analyzer::StackFrame* frame) {
+        return m_loc_mgr.create_location_context(frame,
+                                                 &frame->get_cfg()->getEntry());
+    }
+
+    /// \brief Get the region of the top-level variable of the name.
+    [[nodiscard]] analyzer::RegionRef get_region(
+        llvm::StringRef var, const analyzer::StackFrame* frame) {
+        return m_region_mgr.get_region(find_decl< clang::VarDecl >(var),
+                                       frame);
+    }
+
+    /// \brief Conjure \p num fresh integer variables on the body of the
+    /// function.
+    [[nodiscard]] std::vector< analyzer::ZVariable > make_vars(
+        llvm::StringRef function, unsigned num) {
+        const auto* decl = find_decl< clang::FunctionDecl >(function);
+        const auto* frame = get_top_frame(function);
+        const auto int_ty = get_ast_ctx().IntTy;
+        std::vector< analyzer::ZVariable > vars;
+        vars.reserve(num);
+        for (unsigned i = 0U; i < num; ++i) {
+            m_var_tags.push_back(static_cast< unsigned >(m_var_tags.size()));
+            vars.emplace_back(
+                m_sym_mgr.get_symbol_conjured(decl->getBody(),
+                                              int_ty,
+                                              frame,
+                                              &m_var_tags.back()));
+        }
+        return vars;
+    }
+
+}; // class AnalyzerEnv
+
+} // namespace knight::test
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "analyzer/util/wto.hpp"
+
+using namespace knight;
+
+namespace {
+
+struct TestNode {
+    unsigned id;
+    std::vector< const TestNode* > preds;
+    std::vector< const TestNode* > succs;
+
+    void dump(llvm::raw_ostream& os) const { os << "B" << id; }
+}; // struct TestNode
+
+class TestCFG {
+  public:
+    using GraphRef = const TestCFG*;
+    using NodeRef = const TestNode*;
+    using SuccNodeIterator = std::vector< NodeRef >::const_iterator;
+    using PredNodeIterator = std::vector< NodeRef >::const_iterator;
+
+  private:
+    std::vector< std::unique_ptr< TestNode > > m_nodes;
+
+  public:
+    explicit TestCFG(unsigned num_nodes) {
+        m_nodes.reserve(num_nodes);
+        for (unsigned i = 0U; i < num_nodes; ++i) {
+            m_nodes.push_back(std::make_unique< TestNode >());
+            m_nodes.back()->id = i;
+        }
+    }
+
+    void add_edge(unsigned src, unsigned dst) {
+        m_nodes[src]->succs.push_back(m_nodes[dst].get());
+        m_nodes[dst]->preds.push_back(m_nodes[src].get());
+    }
+
+    [[nodiscard]] NodeRef get_node(unsigned id) const {
+        return m_nodes[id].get();
+    }
+
+    [[nodiscard]] unsigned size() const {
+        return static_cast< unsigned >(m_nodes.size());
+    }
+
+    static NodeRef entry(GraphRef graph) { return graph->m_nodes[0].get(); }
+    static SuccNodeIterator succ_begin(NodeRef node) {
+        return node->succs.begin();
+    }
+    static SuccNodeIterator succ_end(NodeRef node) { return node->succs.end(); }
+    static PredNodeIterator pred_begin(NodeRef node) {
+        return node->preds.begin();
+    }
+    static PredNodeIterator pred_end(NodeRef node) { return node->preds.end(); }
+    static unsigned get_node_id(NodeRef node) { return node->id; }
+    static unsigned num_nodes(GraphRef graph) { return graph->size(); }
+}; // class TestCFG
+
+/// \brief Trait of `TestCFG` hiding its node IDs, so that the order keeps
+/// the depth-first numbers in its hash map.
+struct TestCFGWithoutIdTrait {
+    using GraphRef = TestCFG::GraphRef;
+    using NodeRef = TestCFG::NodeRef;
+    using SuccNodeIterator = TestCFG::SuccNodeIterator;
+    using PredNodeIterator = TestCFG::PredNodeIterator;
+
+    static NodeRef entry(GraphRef graph) { return TestCFG::entry(graph); }
+    static SuccNodeIterator succ_begin(NodeRef node) {
+        return TestCFG::succ_begin(node);
+    }
+    static SuccNodeIterator succ_end(NodeRef node) {
+        return TestCFG::succ_end(node);
+    }
+    static PredNodeIterator pred_begin(NodeRef node) {
+        return TestCFG::pred_begin(node);
+    }
+    static PredNodeIterator pred_end(NodeRef node) {
+        return TestCFG::pred_end(node);
+    }
+}; // struct TestCFGWithoutIdTrait
+
+static_assert(graph_with_node_id< GraphTrait< TestCFG > >);
+static_assert(!graph_with_node_id< TestCFGWithoutIdTrait >);
+
+/// \brief Random graph of `num_nodes` nodes reachable from the entry,
+/// with `num_extra_edges` random edges, self loops and back edges
+/// included, and the successors in a random order.
+TestCFG random_cfg(std::mt19937& rng,
+                   unsigned num_nodes,
+                   unsigned num_extra_edges) {
+    std::vector< std::pair< unsigned, unsigned > > edges;
+    for (unsigned dst = 1U; dst < num_nodes; ++dst) {
+        edges.emplace_back(rng() % dst, dst);
+    }
+    for (unsigned i = 0U; i < num_extra_edges; ++i) {
+        edges.emplace_back(rng() % num_nodes, rng() % num_nodes);
+    }
+    std::shuffle(edges.begin(), edges.end(), rng);
+
+    TestCFG cfg(num_nodes);
+    for (const auto& [src, dst] : edges) {
+        cfg.add_edge(src, dst);
+    }
+    return cfg;
+}
+
+using Nestings = std::unordered_map< const TestNode*, std::vector< unsigned > >;
+
+/// \brief Component of the reference order.
+struct RefComponent {
+    const TestNode* node;
+    bool is_cycle;
+    std::vector< RefComponent > body;
+}; // struct RefComponent
+
+/// \brief The recursive Bourdoncle's algorithm, which the order was built
+/// with before it became iterative.
+class RecursiveWto {
+  private:
+    std::unordered_map< const TestNode*, int > m_dfn;
+    int m_num = 0;
+    std::vector< const TestNode* > m_stack;
+    std::vector< RefComponent > m_components;
+
+  public:
+    explicit RecursiveWto(const TestCFG& cfg) {
+        (void)visit(TestCFG::entry(&cfg), m_components);
+        std::reverse(m_components.begin(), m_components.end());
+    }
+
+    [[nodiscard]] std::string str() const {
+        std::string res;
+        llvm::raw_string_ostream os(res);
+        for (auto it = m_components.begin(); it != m_components.end(); ++it) {
+            if (it != m_components.begin()) {
+                os << " ";
+            }
+            dump(os, *it);
+        }
+        return os.str();
+    }
+
+    /// \brief Collect the heads of the cycles containing each node.
+    [[nodiscard]] Nestings get_nestings() const {
+        Nestings nestings;
+        std::vector< unsigned > nesting;
+        for (const auto& c : m_components) {
+            collect_nestings(c, nesting, nestings);
+        }
+        return nestings;
+    }
+
+  private:
+    [[nodiscard]] int get_dfn(const TestNode* node) const {
+        auto it = m_dfn.find(node);
+        return it == m_dfn.end() ? 0 : it->second;
+    }
+
+    const TestNode* pop() {
+        const TestNode* top = m_stack.back();
+        m_stack.pop_back();
+        return top;
+    }
+
+    RefComponent component(const TestNode* vertex) {
+        RefComponent cycle{vertex, true, {}};
+        for (const auto* succ : vertex->succs) {
+            if (get_dfn(succ) == 0) {
+                (void)visit(succ, cycle.body);
+            }
+        }
+        std::reverse(cycle.body.begin(), cycle.body.end());
+        return cycle;
+    }
+
+    int visit(const TestNode* vertex, std::vector< RefComponent >& partition) {
+        m_stack.push_back(vertex);
+        int head = ++m_num;
+        m_dfn[vertex] = head;
+        bool loop = false;
+        for (const auto* succ : vertex->succs) {
+            int succ_dfn = get_dfn(succ);
+            int min = succ_dfn == 0 ? visit(succ, partition) : succ_dfn;
+            if (min <= head) {
+                head = min;
+                loop = true;
+            }
+        }
+        if (head == get_dfn(vertex)) {
+            m_dfn[vertex] = INT_MAX;
+            const TestNode* element = pop();
+            if (loop) {
+                while (element != vertex) {
+                    m_dfn[element] = 0;
+                    element = pop();
+                }
+                partition.push_back(component(vertex));
+            } else {
+                partition.push_back(RefComponent{vertex, false, {}});
+            }
+        }
+        return head;
+    }
+
+    static void dump(llvm::raw_ostream& os, const RefComponent& c) {
+        if (!c.is_cycle) {
+            c.node->dump(os);
+            return;
+        }
+        os << "(";
+        c.node->dump(os);
+        for (const auto& sub : c.body) {
+            os << " ";
+            dump(os, sub);
+        }
+        os << ")";
+    }
+
+    static void collect_nestings(const RefComponent& c,
+                                 std::vector< unsigned >& nesting,
+                                 Nestings& nestings) {
+        nestings[c.node] = nesting;
+        if (!c.is_cycle) {
+            return;
+        }
+        nesting.push_back(c.node->id);
+        for (const auto& sub : c.body) {
+            collect_nestings(sub, nesting, nestings);
+        }
+        nesting.pop_back();
+    }
+
+}; // class RecursiveWto
+
+/// \brief Collect the top-level cycles of the order.
+class CycleCollector final : public WtoComponentVisitor< TestCFG > {
+  private:
+    std::vector< const WtoCycle< TestCFG >* > m_cycles;
+
+  public:
+    void visit(const WtoVertex< TestCFG >& /*vertex*/) override {}
+    void visit(const WtoCycle< TestCFG >& cycle) override {
+        m_cycles.push_back(&cycle);
+    }
+
+    [[nodiscard]] const std::vector< const WtoCycle< TestCFG >* >& get_cycles()
+        const {
+        return m_cycles;
+    }
+}; // class CycleCollector
+
+template < typename WtoT >
+std::string get_str(const WtoT& wto) {
+    std::string str;
+    llvm::raw_string_ostream os(str);
+    wto.dump(os);
+    return os.str();
+}
+
+template < typename WtoT >
+std::vector< unsigned > get_nesting(const WtoT& wto, const TestNode* node) {
+    std::vector< unsigned > heads;
+    for (const auto* head : wto.get_nesting(node)) {
+        heads.push_back(head->id);
+    }
+    return heads;
+}
+
+} // anonymous namespace
+
+TEST(Wto, SameAsRecursiveOnRandomGraphs) {
+    std::mt19937 rng(42U);
+    for (unsigned round = 0U; round < 500U; ++round) {
+        const unsigned num_nodes = 1U + (rng() % 40U);
+        const unsigned num_extra_edges = rng() % (2U * num_nodes);
+        const TestCFG cfg = random_cfg(rng, num_nodes, num_extra_edges);
+
+        const RecursiveWto expected(cfg);
+        const Wto< TestCFG > wto(&cfg);
+        const Wto< TestCFG, TestCFGWithoutIdTrait > wto_without_id(&cfg);
+        ASSERT_EQ(expected.str(), get_str(wto)) << round;
+        ASSERT_EQ(expected.str(), get_str(wto_without_id)) << round;
+
+        const auto nestings = expected.get_nestings();
+        // The nodes are all reachable from the entry.
+        ASSERT_EQ(cfg.size(), nestings.size()) << round;
+        for (const auto& [node, nesting] : nestings) {
+            ASSERT_EQ(nesting, get_nesting(wto, node)) << round;
+            ASSERT_EQ(nesting, get_nesting(wto_without_id, node)) << round;
+        }
+    }
+}
+
+TEST(Wto, NestedLoops) {
+    // 0 -> 1 -> 2 -> 3 -> 2, 3 -> 1, 1 -> 4
+    TestCFG cfg(5U);
+    cfg.add_edge(0U, 1U);
+    cfg.add_edge(1U, 2U);
+    cfg.add_edge(2U, 3U);
+    cfg.add_edge(3U, 2U);
+    cfg.add_edge(3U, 1U);
+    cfg.add_edge(1U, 4U);
+
+    const Wto< TestCFG > wto(&cfg);
+    EXPECT_EQ("B0 (B1 (B2 B3)) B4", get_str(wto));
+    EXPECT_EQ(std::vector< unsigned >{}, get_nesting(wto, cfg.get_node(1U)));
+    EXPECT_EQ(std::vector< unsigned >{1U},
+              get_nesting(wto, cfg.get_node(2U)));
+    EXPECT_EQ((std::vector< unsigned >{1U, 2U}),
+              get_nesting(wto, cfg.get_node(3U)));
+    EXPECT_EQ(std::vector< unsigned >{}, get_nesting(wto, cfg.get_node(4U)));
+}
+
+TEST(Wto, DeepChainWithoutNativeStack) {
+    // Deep enough to overflow the native stack with the recursive visit.
+    constexpr unsigned num_nodes = 200000U;
+    TestCFG cfg(num_nodes);
+    for (unsigned i = 1U; i < num_nodes; ++i) {
+        cfg.add_edge(i - 1U, i);
+    }
+    cfg.add_edge(num_nodes - 1U, 1U);
+
+    const Wto< TestCFG > wto(&cfg);
+    ASSERT_EQ(2, std::distance(wto.begin(), wto.end()));
+
+    CycleCollector collector;
+    wto.accept(collector);
+    ASSERT_EQ(1U, collector.get_cycles().size());
+    const auto* cycle = collector.get_cycles().front();
+    EXPECT_EQ(cfg.get_node(1U), cycle->get_head());
+    EXPECT_EQ(num_nodes - 2U, cycle->components().size());
+    EXPECT_EQ(std::vector< unsigned >{1U},
+              get_nesting(wto, cfg.get_node(num_nodes - 1U)));
+}
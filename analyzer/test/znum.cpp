@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+
+#include "analyzer/core/domain/num/znum.hpp"
+
+namespace knight::analyzer {
+
+void PrintTo(const ZNum& n, std::ostream* os) { // NOLINT
+    *os << n.str();
+}
+
+} // namespace knight::analyzer
+
+using namespace knight::analyzer;
+
+namespace {
+
+constexpr int64_t Int64Min = std::numeric_limits< int64_t >::min();
+constexpr int64_t Int64Max = std::numeric_limits< int64_t >::max();
+
+/// \brief 2^63, the smallest positive number out of the inline range.
+constexpr const char* Pow63 = "9223372036854775808";
+/// \brief -2^63 - 1, the largest negative number out of the inline range.
+constexpr const char* NegPow63Minus1 = "-9223372036854775809";
+constexpr const char* Pow64 = "18446744073709551616";
+
+ZNum make(const char* str) {
+    auto n = ZNum::from_string(str);
+    EXPECT_TRUE(n.has_value()) << str;
+    return n.value_or(ZNum(0));
+}
+
+} // anonymous namespace
+
+TEST(ZNum, InlineFromConstruction) {
+    EXPECT_TRUE(ZNum(Int64Max).is_small());
+    EXPECT_TRUE(ZNum(Int64Min).is_small());
+    EXPECT_TRUE(ZNum(static_cast< uint64_t >(Int64Max)).is_small());
+    EXPECT_FALSE(ZNum(static_cast< uint64_t >(Int64Max) + 1U).is_small());
+    EXPECT_EQ(make(Pow63), ZNum(static_cast< uint64_t >(Int64Max) + 1U));
+
+    // The GMP integers are normalized on construction.
+    EXPECT_TRUE(ZNum(mpz_class(42)).is_small());
+    EXPECT_TRUE(make("-9223372036854775808").is_small());
+    EXPECT_FALSE(make(Pow63).is_small());
+    EXPECT_FALSE(make(NegPow63Minus1).is_small());
+    EXPECT_EQ(Pow63, make(Pow63).str());
+    EXPECT_EQ("-9223372036854775808", ZNum(Int64Min).str());
+    EXPECT_EQ("-ff", ZNum(-255).str(16));
+}
+
+TEST(ZNum, AddSubAtEdges) {
+    auto n = ZNum(Int64Max) + ZNum(1);
+    EXPECT_FALSE(n.is_small());
+    EXPECT_EQ(make(Pow63), n);
+    n -= 1;
+    EXPECT_TRUE(n.is_small());
+    EXPECT_EQ(ZNum(Int64Max), n);
+
+    auto m = ZNum(Int64Min) - ZNum(1);
+    EXPECT_FALSE(m.is_small());
+    EXPECT_EQ(make(NegPow63Minus1), m);
+    m += 1;
+    EXPECT_TRUE(m.is_small());
+    EXPECT_EQ(ZNum(Int64Min), m);
+
+    EXPECT_EQ(make("-1"), ZNum(Int64Max) + ZNum(Int64Min));
+    EXPECT_EQ(make("18446744073709551615"), ZNum(Int64Max) - ZNum(Int64Min));
+    EXPECT_EQ(ZNum(Int64Max), make(Pow64) - make(Pow63) - ZNum(1));
+
+    auto inc = ZNum(Int64Max);
+    ++inc;
+    EXPECT_EQ(make(Pow63), inc);
+    --inc;
+    EXPECT_TRUE(inc.is_small());
+    auto dec = ZNum(Int64Min);
+    dec--;
+    EXPECT_EQ(make(NegPow63Minus1), dec);
+    dec++;
+    EXPECT_TRUE(dec.is_small());
+
+    EXPECT_EQ(make(Pow63), -ZNum(Int64Min));
+    EXPECT_EQ(ZNum(Int64Min), -make(Pow63));
+    EXPECT_TRUE((-make(Pow63)).is_small());
+}
+
+TEST(ZNum, MulDivAtEdges) {
+    EXPECT_EQ(make(Pow63), ZNum(Int64Min) * ZNum(-1));
+    EXPECT_EQ(make("18446744073709551614"), ZNum(Int64Max) * ZNum(2));
+    EXPECT_EQ(make(Pow63), ZNum(int64_t{1} << 32) * ZNum(int64_t{1} << 31));
+    EXPECT_TRUE((ZNum(int64_t{1} << 32) * ZNum(int64_t{1} << 30)).is_small());
+    EXPECT_EQ(ZNum(Int64Min),
+              ZNum(int64_t{1} << 32) * ZNum(-(int64_t{1} << 31)));
+    EXPECT_TRUE((make(Pow64) * ZNum(0)).is_small());
+    EXPECT_EQ(make(Pow64), make(Pow63) * ZNum(2));
+
+    EXPECT_EQ(make(Pow63), ZNum(Int64Min) / ZNum(-1));
+    EXPECT_EQ(ZNum(0), ZNum(Int64Min) % ZNum(-1));
+    EXPECT_EQ(ZNum(Int64Min), make(Pow64) / ZNum(-2));
+    EXPECT_TRUE((make(Pow64) / ZNum(-2)).is_small());
+    // The division truncates towards zero, the remainder has the sign of
+    // the dividend.
+    EXPECT_EQ(ZNum(-2), ZNum(-7) / ZNum(3));
+    EXPECT_EQ(ZNum(-1), ZNum(-7) % ZNum(3));
+    EXPECT_EQ(ZNum(1), ZNum(7) % ZNum(-3));
+}
+
+TEST(ZNum, ShiftAtEdges) {
+    EXPECT_EQ(ZNum(int64_t{1} << 62), ZNum(1) << 62);
+    EXPECT_TRUE((ZNum(1) << 62).is_small());
+    EXPECT_EQ(make(Pow63), ZNum(1) << 63);
+    EXPECT_EQ(ZNum(Int64Min), ZNum(-1) << 63);
+    EXPECT_TRUE((ZNum(-1) << 63).is_small());
+    EXPECT_EQ(make("-18446744073709551616"), ZNum(-1) << 64);
+    EXPECT_EQ(make(Pow64), ZNum(Int64Min) * ZNum(-2));
+    EXPECT_EQ(make("-18446744073709551616"), ZNum(Int64Min) << 1);
+    EXPECT_EQ(make(Pow64), ZNum(1) << ZNum(64));
+    EXPECT_EQ(ZNum(0), ZNum(0) << 100);
+
+    EXPECT_EQ(make(Pow63), make(Pow64) >> 1);
+    EXPECT_EQ(ZNum(int64_t{1} << 62), make(Pow64) >> 2);
+    EXPECT_TRUE((make(Pow64) >> 2).is_small());
+    EXPECT_EQ(ZNum(Int64Min), make("-18446744073709551616") >> 1);
+    EXPECT_TRUE((make("-18446744073709551616") >> 1).is_small());
+    // The right shifts round towards negative infinity.
+    EXPECT_EQ(ZNum(-3), ZNum(-5) >> 1);
+    EXPECT_EQ(ZNum(-1), ZNum(-1) >> 100);
+    EXPECT_EQ(ZNum(0), ZNum(Int64Max) >> 64);
+    EXPECT_EQ(ZNum(-1), ZNum(Int64Min) >> 64);
+    EXPECT_EQ(ZNum(-1), make(NegPow63Minus1) >> 64);
+}
+
+TEST(ZNum, CompareAcrossRepresentations) {
+    EXPECT_LT(ZNum(Int64Max), make(Pow63));
+    EXPECT_GT(ZNum(Int64Min), make(NegPow63Minus1));
+    EXPECT_LT(make(NegPow63Minus1), make(Pow63));
+    EXPECT_LT(make(Pow63), make(Pow64));
+    EXPECT_NE(ZNum(0), make(Pow63));
+    EXPECT_EQ(make(Pow63), make(Pow63));
+    EXPECT_EQ(1, make(Pow63).sign());
+    EXPECT_EQ(-1, make(NegPow63Minus1).sign());
+
+    EXPECT_TRUE(make(Pow63).fits< uint64_t >());
+    EXPECT_FALSE(make(Pow63).fits< int64_t >());
+    EXPECT_EQ(uint64_t{1} << 63, make(Pow63).to< uint64_t >());
+    EXPECT_FALSE(make(Pow64).fits< uint64_t >());
+    EXPECT_FALSE(ZNum(-1).fits< uint64_t >());
+    EXPECT_TRUE(ZNum(Int64Min).fits< int64_t >());
+    EXPECT_FALSE(ZNum(int64_t{1} << 31).fits< int32_t >());
+}
+
+TEST(ZNum, ModWithNegatives) {
+    // The modulo is the non-negative remainder of the floor division by
+    // the absolute value of the divisor.
+    EXPECT_EQ(ZNum(2), mod(ZNum(-7), ZNum(3)));
+    EXPECT_EQ(ZNum(2), mod(ZNum(-7), ZNum(-3)));
+    EXPECT_EQ(ZNum(1), mod(ZNum(7), ZNum(-3)));
+    EXPECT_EQ(ZNum(0), mod(ZNum(-6), ZNum(3)));
+    EXPECT_EQ(ZNum(0), mod(ZNum(Int64Min), ZNum(-1)));
+    EXPECT_EQ(ZNum(Int64Max - 1), mod(ZNum(Int64Min), ZNum(Int64Max)));
+    EXPECT_EQ(ZNum(Int64Max), mod(ZNum(-1), ZNum(Int64Min)));
+    // 2^64 + 4 = 3k + 2, so that -(2^64 + 4) = -3(k + 1) + 1.
+    EXPECT_EQ(ZNum(1), mod(make("-18446744073709551620"), ZNum(3)));
+    EXPECT_EQ(ZNum(1), mod(make("-18446744073709551620"), ZNum(-3)));
+    EXPECT_EQ(ZNum(Int64Max), mod(make(Pow63) - ZNum(1), make(Pow63)));
+    EXPECT_EQ(make(Pow63) - ZNum(1), mod(ZNum(-1), make(Pow63)));
+}
+
+TEST(ZNum, GcdWithNegatives) {
+    EXPECT_EQ(ZNum(6), gcd(ZNum(-12), ZNum(18)));
+    EXPECT_EQ(ZNum(6), gcd(ZNum(-12), ZNum(-18)));
+    EXPECT_EQ(ZNum(5), gcd(ZNum(0), ZNum(-5)));
+    EXPECT_EQ(ZNum(0), gcd(ZNum(0), ZNum(0)));
+    EXPECT_EQ(ZNum(2), gcd(ZNum(Int64Min), ZNum(6)));
+    EXPECT_EQ(make(Pow63), gcd(ZNum(Int64Min), ZNum(Int64Min)));
+    EXPECT_EQ(ZNum(1), gcd(ZNum(Int64Min), ZNum(Int64Max)));
+    EXPECT_EQ(ZNum(int64_t{1} << 32),
+              gcd(make(Pow64), ZNum(-(int64_t{1} << 32))));
+    EXPECT_EQ(ZNum(4), gcd(ZNum(-8), ZNum(12), ZNum(-20)));
+    EXPECT_EQ(ZNum(12), lcm(ZNum(-4), ZNum(6)));
+
+    ZNum g;
+    ZNum u;
+    ZNum v;
+    gcd_extended(ZNum(-12), ZNum(18), g, u, v);
+    EXPECT_EQ(ZNum(6), g);
+    EXPECT_EQ(g, ZNum(-12) * u + ZNum(18) * v);
+
+    EXPECT_EQ(make(Pow63), abs(ZNum(Int64Min)));
+    EXPECT_EQ(ZNum(Int64Max), abs(ZNum(-Int64Max)));
+}
@@ -13,23 +13,44 @@
 
 #include "analyzer/core/analyzer_options.hpp"
 #include "analyzer/core/domain/domains.hpp"
+#include "analyzer/core/domain/num/gmp_pool.hpp"
 #include "analyzer/tooling/cl_opts.hpp"
 #include "analyzer/tooling/context.hpp"
+#include "analyzer/tooling/diag_stream.hpp"
 #include "analyzer/tooling/diagnostic.hpp"
+#include "analyzer/tooling/invariant_store.hpp"
 #include "analyzer/tooling/knight.hpp"
+#include "analyzer/tooling/mem_report.hpp"
 #include "analyzer/tooling/options.hpp"
+#include "analyzer/tooling/sarif.hpp"
+#include "analyzer/tooling/server.hpp"
+#include "analyzer/tooling/stats.hpp"
+#include "analyzer/tooling/time_report.hpp"
+#include "analyzer/tooling/trace.hpp"
+#include "analyzer/tooling/widening_trace.hpp"
+#include "cg/core/andersen.hpp"
+#include "cg/core/impact.hpp"
+#include "cg/db/db.hpp"
+#include "cg/tooling/driver.hpp"
+#include "common/util/compdb.hpp"
 #include "common/util/log.hpp"
+#include "common/util/perf_counters.hpp"
+#include "common/util/progress.hpp"
+#include "common/util/shard.hpp"
+#include "common/util/tu_costs.hpp"
 #include "common/util/vfs.hpp"
 
-#include <clang/Tooling/CommonOptionsParser.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/InitLLVM.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Process.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/WithColor.h>
 #include <llvm/Support/raw_ostream.h>
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #define DEBUG_TYPE "main"
@@ -48,6 +69,15 @@ constexpr ErrCode VfsFileFailure = 3U;
 constexpr ErrCode NoInputFiles = 4U;
 constexpr ErrCode InputNotExists = 5U;
 constexpr ErrCode CompileErrorFound = 6U;
+constexpr ErrCode ServeFailure = 7U;
+constexpr ErrCode MergeFailure = 8U;
+constexpr ErrCode ChangesFailure = 9U;
+constexpr ErrCode PointsToFailure = 10U;
+constexpr ErrCode SarifFailure = 11U;
+
+/// \brief Busy timeout of the call graph database in the `--cg` mode, the
+/// default of knight-cg.
+constexpr unsigned CGDBBusyTimeoutMs = 5000U;
 
 llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > get_vfs(
     ErrCode& code) {
@@ -76,7 +106,16 @@ analyzer::AnalyzerOptions forward_to_knight_analyzer_options(
     return analyzer::AnalyzerOptions{widening_delay,
                                      max_widening_iterations,
                                      max_narrowing_iterations,
-                                     analyze_with_threshold};
+                                     analyze_with_threshold,
+                                     max_function_millis,
+                                     max_function_transfers,
+                                     max_call_depth,
+                                     sparse_fixpoint,
+                                     prune_dead_values,
+                                     max_memory_per_worker,
+                                     max_disjuncts,
+                                     alias_classes,
+                                     accelerate_loops};
 }
 
 /// \brief  Resolve -Xc options
@@ -102,7 +141,7 @@ analyzer::AnalyzerOptions get_analyzer_options() {
                                               analyzer_argv.data());
 }
 
-std::unique_ptr< KnightOptionsProvider > get_opts_provider() {
+std::unique_ptr< KnightOptionsCommandLineProvider > get_opts_provider() {
     auto opts_provider = std::make_unique< KnightOptionsCommandLineProvider >();
     if (analyses.getNumOccurrences() > 0) {
         opts_provider->options.analyses = analyses; // NOLINT
@@ -110,6 +149,18 @@ std::unique_ptr< KnightOptionsProvider > get_opts_provider() {
     if (checkers.getNumOccurrences() > 0) {
         opts_provider->options.checkers = checkers; // NOLINT
     }
+    if (include_functions.getNumOccurrences() > 0) {
+        opts_provider->options.include_functions = include_functions;
+    }
+    if (exclude_paths.getNumOccurrences() > 0) {
+        opts_provider->options.exclude_paths = exclude_paths;
+    }
+    if (skip_system_header.getNumOccurrences() > 0) {
+        opts_provider->options.skip_system_header = skip_system_header;
+    }
+    if (skip_implicit_code.getNumOccurrences() > 0) {
+        opts_provider->options.skip_implicit_code = skip_implicit_code;
+    }
     if (use_color.getNumOccurrences() > 0) {
         opts_provider->options.use_color = use_color;
     } else {
@@ -122,6 +173,46 @@ std::unique_ptr< KnightOptionsProvider > get_opts_provider() {
     if (dump_cfg.getNumOccurrences() > 0) {
         opts_provider->options.dump_cfg = dump_cfg;
     }
+    if (knight_dir.getNumOccurrences() > 0) {
+        opts_provider->options.knight_dir = fs::make_absolute(knight_dir);
+    }
+    if (pch_header.getNumOccurrences() > 0) {
+        opts_provider->options.pch_header = fs::make_absolute(pch_header);
+    }
+    if (diag_stream.getNumOccurrences() > 0) {
+        opts_provider->options.diag_stream = diag_stream;
+    }
+    if (state_dump_dir.getNumOccurrences() > 0) {
+        opts_provider->options.state_dump_dir =
+            fs::make_absolute(state_dump_dir);
+    }
+    if (store_invariants.getNumOccurrences() > 0) {
+        opts_provider->options.store_invariants = store_invariants;
+    }
+    if (resume.getNumOccurrences() > 0) {
+        opts_provider->options.resume = resume;
+    }
+    if (pipeline_depth.getNumOccurrences() > 0) {
+        opts_provider->options.pipeline_depth = pipeline_depth;
+    }
+    if (function_jobs.getNumOccurrences() > 0) {
+        opts_provider->options.function_jobs = function_jobs;
+    }
+    if (check_jobs.getNumOccurrences() > 0) {
+        opts_provider->options.check_jobs = check_jobs;
+    }
+    if (retain_symbols.getNumOccurrences() > 0) {
+        opts_provider->options.retain_symbols = retain_symbols;
+    }
+    if (dedup_definitions.getNumOccurrences() > 0) {
+        opts_provider->options.dedup_definitions = dedup_definitions;
+    }
+    if (dedup_structural.getNumOccurrences() > 0) {
+        opts_provider->options.dedup_structural = dedup_structural;
+    }
+    if (bottom_up.getNumOccurrences() > 0) {
+        opts_provider->options.bottom_up = bottom_up;
+    }
     if (zdomain.getNumOccurrences() > 0) {
         opts_provider->options.zdom = zdomain;
     }
@@ -164,6 +255,73 @@ bool ensure_input_files_exist(const std::vector< std::string >& files,
     });
 }
 
+/// \brief Keep the files of the `--shard`, taken from all the files of the
+/// compilation database if none is given, balanced by the cost model.
+bool select_shard_files(std::vector< std::string >& files,
+                        const CompilationDatabase& cdb,
+                        const fs::FileSystemRef& vfs,
+                        const TUCosts& costs) {
+    auto shard = shard::parse_shard(shard_spec);
+    if (!shard) {
+        llvm::WithColor::error() << "Invalid shard `" << shard_spec
+                                 << "`, expected `i/N` with 0 <= i < N.\n";
+        return false;
+    }
+    if (files.empty()) {
+        files = cdb.getAllFiles();
+    }
+    llvm::transform(files, files.begin(), fs::make_absolute);
+    auto estimates = costs.estimate(files, vfs);
+    llvm::StringMap< uint64_t > file_costs;
+    for (std::size_t idx = 0U; idx < files.size(); ++idx) {
+        file_costs[files[idx]] = estimates[idx];
+    }
+    files = shard::select_files(std::move(files),
+                                *shard,
+                                [&file_costs](const std::string& file) {
+                                    return file_costs.lookup(file);
+                                });
+    return true;
+}
+
+/// \brief Compute the impact of the `--changes` on the given units from
+/// the call graph database of the knight directory.
+std::shared_ptr< const cg::ChangeImpact > get_change_impact(
+    const std::string& knight_dir, llvm::ArrayRef< std::string > units) {
+    auto buffer = llvm::MemoryBuffer::getFileOrSTDIN(changes);
+    if (!buffer) {
+        llvm::WithColor::error() << "Cannot read the changes `" << changes
+                                 << "`: " << buffer.getError().message()
+                                 << "\n";
+        return nullptr;
+    }
+    if (!llvm::sys::fs::exists(knight_dir + "/cg.db")) {
+        llvm::WithColor::error() << "`--changes` requires the call graph "
+                                    "database of knight-cg in `--dir`.\n";
+        return nullptr;
+    }
+    const cg::Database db(knight_dir, static_cast< int >(CGDBBusyTimeoutMs));
+    return std::make_shared< const cg::ChangeImpact >(
+        cg::ChangeImpact::compute(db,
+                                  cg::parse_changed_lines(
+                                      (*buffer)->getBuffer()),
+                                  units));
+}
+
+/// \brief Load the whole-program points-to sets from the call graph
+/// database of the knight directory.
+std::shared_ptr< const cg::PointsToFacts > get_points_to(
+    const std::string& knight_dir) {
+    if (!llvm::sys::fs::exists(knight_dir + "/cg.db")) {
+        llvm::WithColor::error() << "`--points-to` requires the call graph "
+                                    "database of knight-cg in `--dir`.\n";
+        return nullptr;
+    }
+    const cg::Database db(knight_dir, static_cast< int >(CGDBBusyTimeoutMs));
+    return std::make_shared< const cg::PointsToFacts >(
+        cg::PointsToFacts::load(db));
+}
+
 void print_enabled_checkers(
     const std::vector< std::string >& enabled_checkers) {
     auto size = enabled_checkers.size();
@@ -195,27 +353,61 @@ void print_enabled_analyses(
     }
 }
 
+/// \brief Print the time report, the statistics and the memory report to
+/// the `--report-file`, or to the stderr if none is given.
+void print_reports() {
+    std::unique_ptr< llvm::raw_fd_ostream > report_os;
+    if (!report_file.empty()) {
+        std::error_code err;
+        report_os = std::make_unique< llvm::raw_fd_ostream >(report_file,
+                                                             err,
+                                                             sys::fs::OF_Text);
+        if (err) {
+            llvm::WithColor::warning()
+                << "Cannot open the report file `" << report_file
+                << "`: " << err.message() << ", printing to the stderr.\n";
+            report_os.reset();
+        }
+    }
+    auto& os = report_os != nullptr ? *report_os : llvm::errs();
+    TimeReport::get().print(os, time_report);
+    Stats::get().print(os, analyzer_stats);
+    MemReport::get().print(os, mem_report);
+}
+
 int main(int argc, const char** argv) {
     const llvm::InitLLVM llvm_setup(argc, argv);
+    analyzer::install_gmp_pool();
     ErrCode code = NormalExit;
     auto base_vfs = get_vfs(code);
     if (!base_vfs) {
         return code;
     }
 
-    auto opts_parser = CommonOptionsParser::create(argc,
-                                                   argv,
-                                                   knight_category,
-                                                   cl::ZeroOrMore);
+    // The compilation database is loaded through its index in the knight
+    // directory.
+    auto opts_parser = compdb::OptionsParser::create(argc,
+                                                     argv,
+                                                     knight_category,
+                                                     cl::ZeroOrMore,
+                                                     knight_dir);
 
     if (!opts_parser) {
         WithColor::error() << toString(opts_parser.takeError());
         return OptParseFailure;
     }
 
+    if (!merge_diags.empty()) {
+        auto writer =
+            DiagnosticStreamWriter::open(diag_stream.empty() ? "-"
+                                                             : diag_stream);
+        return writer && writer->merge(merge_diags) ? NormalExit
+                                                    : MergeFailure;
+    }
+
     auto opts_provider = get_opts_provider();
     auto input_path = std::string("dummy");
-    auto src_path_lst = opts_parser->getSourcePathList();
+    auto src_path_lst = opts_parser->get_source_path_list();
     if (!src_path_lst.empty()) {
         input_path = fs::make_absolute(src_path_lst.front());
     }
@@ -238,7 +430,21 @@ int main(int argc, const char** argv) {
         return NormalExit;
     }
 
-    if (src_path_lst.empty()) {
+    if (!shard_spec.empty()) {
+        const TUCosts costs(opts.knight_dir, AnalyzerTUCostsFile);
+        if (!select_shard_files(src_path_lst,
+                                opts_parser->get_compilations(),
+                                base_vfs,
+                                costs)) {
+            return OptParseFailure;
+        }
+        if (src_path_lst.empty()) {
+            llvm::WithColor::note() << "No input files in the shard.\n";
+            return NormalExit;
+        }
+    }
+
+    if (src_path_lst.empty() && serve_socket.empty()) {
         llvm::WithColor::error() << "No input files provided.\n";
         llvm::cl::PrintHelpMessage(false, true);
         return NoInputFiles;
@@ -249,18 +455,137 @@ int main(int argc, const char** argv) {
         return InputNotExists;
     }
 
+    if (with_cg && opts.knight_dir.empty()) {
+        llvm::WithColor::error() << "`--cg` requires `--dir`.\n";
+        return OptParseFailure;
+    }
+    if (opts.store_invariants && opts.knight_dir.empty()) {
+        llvm::WithColor::error()
+            << "`--store-invariants` requires `--dir`.\n";
+        return OptParseFailure;
+    }
+    if (opts.resume && opts.knight_dir.empty()) {
+        llvm::WithColor::error() << "`--resume` requires `--dir`.\n";
+        return OptParseFailure;
+    }
+
+    if (!changes.empty()) {
+        auto impact = get_change_impact(opts.knight_dir, src_path_lst);
+        if (impact == nullptr) {
+            return ChangesFailure;
+        }
+        llvm::erase_if(src_path_lst, [&impact](const std::string& file) {
+            return !impact->is_unit_impacted(file);
+        });
+        if (src_path_lst.empty()) {
+            llvm::WithColor::note()
+                << "No input files impacted by the changes.\n";
+            return NormalExit;
+        }
+        opts_provider->options.change_impact = std::move(impact);
+    }
+
+    if (points_to) {
+        auto facts = get_points_to(opts.knight_dir);
+        if (facts == nullptr) {
+            return PointsToFailure;
+        }
+        opts_provider->options.points_to = std::move(facts);
+    }
+
     if (enabled_analyses.empty() && enabled_checkers.empty()) {
         llvm::WithColor::error() << "No analyses or checkers are enabled.\n";
         return NormalExit;
     }
 
+    TimeReport::get().set_enabled(time_report != TimeReportFormat::None);
+    if (time_report_perf_counters) {
+        if (PerfCounters::get_thread_counters().is_available()) {
+            TimeReport::get().set_perf_enabled(true);
+        } else {
+            llvm::WithColor::warning()
+                << "The hardware counters are not available, see "
+                   "/proc/sys/kernel/perf_event_paranoid.\n";
+        }
+    }
+    Stats::get().set_enabled(analyzer_stats != StatsFormat::None);
+    MemReport::get().set_enabled(mem_report != MemReportFormat::None);
+    if (!trace_file.empty()) {
+        trace::initialize(trace_granularity);
+    }
+    if (!widening_trace_file.empty()) {
+        if (auto err = WideningTrace::get().open(widening_trace_file);
+            !err.empty()) {
+            llvm::WithColor::warning()
+                << "Cannot open the widening trace `" << widening_trace_file
+                << "`: " << err << "\n";
+        }
+    }
+
+    ProgressReporter::get().start(quiet ? ProgressMode::Quiet
+                                        : progress.getValue(),
+                                  opts.use_color,
+                                  src_path_lst.size());
     KnightContext ctx(std::move(opts_provider));
     KnightDriver driver(ctx,
-                        opts_parser->getCompilations(),
+                        opts_parser->get_compilations(),
                         src_path_lst,
-                        base_vfs);
+                        base_vfs,
+                        jobs);
+    if (!serve_socket.empty()) {
+        auto is_served = KnightServer(driver).serve(serve_socket);
+        ProgressReporter::get().finish();
+        return is_served ? NormalExit : ServeFailure;
+    }
+
+    // The call graph is extracted by consumers next to the analyzer ones.
+    std::unique_ptr< CGContext > cg_ctx;
+    std::unique_ptr< KnightCGBuilder > cg_builder;
+    if (with_cg) {
+        cg_ctx = std::make_unique< CGContext >(opts.use_color,
+                                               false,
+                                               false,
+                                               false,
+                                               base_vfs,
+                                               &opts_parser->get_compilations(),
+                                               src_path_lst,
+                                               opts.knight_dir,
+                                               CGDBBusyTimeoutMs);
+        cg_ctx->report_progress = false;
+        cg_builder = std::make_unique< KnightCGBuilder >(*cg_ctx);
+        cg_builder->begin_extraction(jobs != 1U || opts.pipeline_depth > 0U);
+        driver.set_extra_consumer_factory(
+            [&builder = *cg_builder](clang::ASTContext& ast_ctx,
+                                     llvm::StringRef file) {
+                return builder.create_ast_consumer(ast_ctx, file);
+            });
+    }
     const auto& diags = driver.run();
-    driver.handle_diagnostics(diags, try_fix);
+    if (cg_builder != nullptr) {
+        cg_builder->finish_extraction();
+    }
+    ProgressReporter::get().finish();
+    // The SARIF log replaces the rendering of the diagnostics, which is
+    // still needed to apply the fixes.
+    if (sarif_file.empty() || try_fix) {
+        driver.handle_diagnostics(diags, try_fix);
+    }
+    if (!sarif_file.empty()) {
+        if (auto err = SarifWriter::write(sarif_file, diags, jobs);
+            !err.empty()) {
+            llvm::WithColor::error() << err << "\n";
+            code = SarifFailure;
+        }
+    }
+    if (opts.store_invariants) {
+        if (auto err = InvariantStore::get().write(opts.knight_dir);
+            !err.empty()) {
+            llvm::WithColor::warning() << err << "\n";
+        }
+    }
+    print_reports();
+    (void)trace::finish(trace_file);
+    WideningTrace::get().close();
 
     if (const bool compile_error_found =
             llvm::any_of(diags, [](const auto& diag) {
@@ -0,0 +1,105 @@
+//===- andersen.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the whole-program inclusion-based pointer analysis
+//  over the points-to constraints of the call graph database.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "cg/core/cg.hpp"
+#include "cg/db/db.hpp"
+
+#include <llvm/ADT/SparseBitVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace knight::cg {
+
+/// \brief The points-to sets of the Andersen analysis of the whole
+/// program, i.e., the least solution of the points-to constraints of all
+/// the extracted units.
+///
+/// The constraints are solved by wave propagation: the cycles of the copy
+/// edges are collapsed, the new points-to facts are pushed along the
+/// copy edges in topological order, and the loads and the stores of the
+/// new pointees add new copy edges, until none is added. The third step
+/// runs on `jobs` threads, each over a slice of the nodes.
+///
+/// The nodes without any constraint are unknown, e.g., the parameters of
+/// the functions not called by the extracted code, and conservatively
+/// alias everything.
+class PointsToFacts {
+  public:
+    using NodeID = unsigned;
+    using PointsToSet = llvm::SparseBitVector<>;
+
+  private:
+    llvm::StringMap< NodeID > m_ids;
+    std::vector< llvm::StringRef > m_names;
+    /// \brief The node holding the points-to set of each node, the nodes
+    /// of a cycle sharing the set of their representative.
+    std::vector< NodeID > m_reps;
+    std::vector< PointsToSet > m_points_to;
+    /// \brief The hash of the points-to sets of the named nodes, see
+    /// `get_hash`.
+    uint64_t m_hash = 0U;
+
+  public:
+    /// \brief Solve the constraints on `jobs` threads, 0 for one per
+    /// hardware thread.
+    [[nodiscard]] static PointsToFacts solve(
+        const std::vector< PointsToConstraint >& constraints, unsigned jobs);
+
+    /// \brief Load the points-to sets saved in the database.
+    [[nodiscard]] static PointsToFacts load(const Database& db);
+
+    /// \brief Save the points-to sets of the named nodes, the temporaries
+    /// of the expressions being dropped.
+    void save(Database& db) const;
+
+  public:
+    /// \brief Check if the pointers held by the nodes `p` and `q` may
+    /// point to a common location.
+    [[nodiscard]] bool may_alias(llvm::StringRef p, llvm::StringRef q) const;
+
+    /// \brief Check if the pointer held by the node `p` may point to the
+    /// node `pointee`.
+    [[nodiscard]] bool may_point_to(llvm::StringRef p,
+                                    llvm::StringRef pointee) const;
+
+    /// \brief Get the nodes the pointer held by the node `p` may point to,
+    /// none if unknown.
+    [[nodiscard]] std::vector< llvm::StringRef > get_points_to(
+        llvm::StringRef p) const;
+
+    /// \brief Check if the node has constraints.
+    [[nodiscard]] bool is_known(llvm::StringRef node) const {
+        return m_ids.count(node) != 0U;
+    }
+
+    [[nodiscard]] std::size_t size() const { return m_names.size(); }
+
+    /// \brief Get the hash of the points-to sets of the named nodes, i.e.
+    /// of the saved sets, which does not depend on the order of the nodes.
+    [[nodiscard]] uint64_t get_hash() const { return m_hash; }
+
+  private:
+    [[nodiscard]] NodeID get_or_create_id(llvm::StringRef name);
+    [[nodiscard]] uint64_t compute_hash() const;
+    [[nodiscard]] const PointsToSet* get_set(llvm::StringRef node) const;
+
+}; // class PointsToFacts
+
+} // namespace knight::cg
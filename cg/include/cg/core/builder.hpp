@@ -13,14 +13,22 @@
 
 #pragma once
 
+#include <clang/AST/Mangle.h>
 #include <clang/AST/RecursiveASTVisitor.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
 
 #include "cg/core/cg.hpp"
+#include "cg/core/points_to.hpp"
 #include "cg/db/db.hpp"
 #include "common/util/log.hpp"
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 namespace knight {
 
@@ -28,15 +36,49 @@ class CGContext;
 
 namespace cg {
 
+/// \brief The header function definitions already extracted by the
+/// process, shared by the extraction workers so that a header body is
+/// only traversed by the first translation unit reaching it.
+class ExtractedDefinitions {
+  private:
+    std::mutex m_mutex;
+    std::unordered_set< std::string > m_keys;
+
+  public:
+    /// \brief Mark the definition at the given location as extracted.
+    ///
+    /// \return true if it was not extracted yet.
+    [[nodiscard]] bool try_mark(std::string key) {
+        const std::lock_guard< std::mutex > lock(m_mutex);
+        return m_keys.insert(std::move(key)).second;
+    }
+}; // class ExtractedDefinitions
+
 class CGBuilder : public clang::RecursiveASTVisitor< CGBuilder > {
   public:
     using Base = clang::RecursiveASTVisitor< CGBuilder >;
 
   private:
     knight::CGContext& m_ctx;
-    Database m_db;
+    Records m_records;
 
-    std::string m_current_function_name;
+    llvm::StringRef m_current_function_name;
+    llvm::StringRef m_current_file;
+
+    /// \brief The caches of the translation unit, as the builder is only
+    /// used for one. The strings are interned in the arena of the records,
+    /// which the cg nodes and the call sites view.
+    /// @{
+    std::unique_ptr< clang::MangleContext > m_mangler;
+    llvm::DenseMap< const clang::NamedDecl*, llvm::StringRef > m_mangled_names;
+    llvm::DenseMap< const clang::CXXRecordDecl*, llvm::StringRef >
+        m_class_names;
+    llvm::StringMap< llvm::StringRef > m_absolute_paths;
+    /// @}
+
+    /// \brief The extractor of the points-to constraints, only used for
+    /// the whole-program pointer analysis.
+    PointsToExtractor m_points_to;
 
   public:
     explicit CGBuilder(knight::CGContext& ctx);
@@ -54,6 +96,44 @@ class CGBuilder : public clang::RecursiveASTVisitor< CGBuilder > {
     [[nodiscard]] bool VisitCXXConstructExpr(
         const clang::CXXConstructExpr* ctor_call);
     [[nodiscard]] bool VisitFunctionDecl(const clang::FunctionDecl* function);
+
+    /// \brief Record the source files of the translation unit, with their
+    /// content hashes and their `#include`s.
+    void collect_files(const clang::SourceManager& sm);
+
+    /// \brief Record the class hierarchy and the points-to constraints of
+    /// the global initializers declared in the translation unit, out of
+    /// the function bodies.
+    void collect_hierarchy(clang::TranslationUnitDecl* tu);
+
+    /// \brief Record the bases and the virtual methods of the class, once
+    /// per process for the classes of the headers.
+    void add_class(const clang::CXXRecordDecl* record);
+
+    /// \brief Record the points-to constraints of the initializer of the
+    /// global variable, once per process for the globals of the headers.
+    void add_global(const clang::VarDecl* var);
+
+  private:
+    [[nodiscard]] bool visit_call(const clang::Decl* decl,
+                                  const clang::SourceLocation& loc,
+                                  bool is_virtual = false);
+
+    [[nodiscard]] llvm::StringRef get_mangled_name(
+        const clang::NamedDecl* named_decl);
+
+    [[nodiscard]] llvm::StringRef get_absolute_path(llvm::StringRef file);
+
+    /// \brief Get the mangled RTTI name of the class.
+    [[nodiscard]] llvm::StringRef get_class_name(
+        const clang::CXXRecordDecl* record);
+
+  public:
+    /// \brief Take the records visited so far, along with the arena of
+    /// their strings, once the translation unit is visited.
+    [[nodiscard]] Records take_records() {
+        return std::exchange(m_records, Records{});
+    }
 }; // class CGBuilder
 
 } // namespace cg
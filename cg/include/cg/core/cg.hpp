@@ -13,30 +13,77 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
+#include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/StringSaver.h>
 #include <llvm/Support/raw_ostream.h>
 
 namespace knight::cg {
 
 constexpr unsigned CSToStringMaxSize = 256U;
 
+/// \brief The arena of the strings of the call sites and the cg nodes,
+/// where each distinct string is stored once, so that the records only
+/// view them. The mangled names of the template-heavy code are thus not
+/// copied for each of their call sites.
+///
+/// The views stay valid as long as the arena, which may be moved.
+class StringArena {
+  private:
+    std::unique_ptr< llvm::BumpPtrAllocator > m_alloc =
+        std::make_unique< llvm::BumpPtrAllocator >();
+    std::unique_ptr< llvm::UniqueStringSaver > m_saver =
+        std::make_unique< llvm::UniqueStringSaver >(*m_alloc);
+
+  public:
+    [[nodiscard]] llvm::StringRef intern(llvm::StringRef str) {
+        return m_saver->save(str);
+    }
+}; // class StringArena
+
+/// \brief A call site, of which the strings are viewed from the arena of
+/// its builder or of the database it is read from.
 struct CallSite {
     unsigned line;
     unsigned col;
-    std::string caller;
-    std::string callee;
+    llvm::StringRef caller;
+    llvm::StringRef callee;
+    /// \brief The file of the definition of the caller, which owns the
+    /// call site in the database, empty if unknown.
+    llvm::StringRef file;
+    /// \brief Whether the call is dispatched on the dynamic type of the
+    /// object, the callee being the statically resolved method.
+    bool is_virtual = false;
 
     CallSite() = default;
     CallSite(unsigned line,
              unsigned col,
-             std::string caller,
-             std::string callee)
+             llvm::StringRef caller,
+             llvm::StringRef callee,
+             llvm::StringRef file = {},
+             bool is_virtual = false)
         : line(line),
           col(col),
-          caller(std::move(caller)),
-          callee(std::move(callee)) {}
+          caller(caller),
+          callee(callee),
+          file(file),
+          is_virtual(is_virtual) {}
+
+    /// \brief Get the call site with its strings interned in the arena.
+    [[nodiscard]] CallSite intern(StringArena& arena) const {
+        return {line,
+                col,
+                arena.intern(caller),
+                arena.intern(callee),
+                arena.intern(file),
+                is_virtual};
+    }
 
     bool operator==(const CallSite& other) const {
         return line == other.line && col == other.col &&
@@ -69,28 +116,45 @@ struct CallSite {
     }
 }; // struct CallSite
 
+/// \brief A function definition, of which the strings are viewed from
+/// the arena of its builder or of the database it is read from.
 struct CallGraphNode {
     unsigned line;
     unsigned col;
-    std::string name;
-    std::string mangled_name;
-    std::string file;
+    llvm::StringRef name;
+    llvm::StringRef mangled_name;
+    llvm::StringRef file;
+    /// \brief The last line of the definition, 0 if unknown.
+    unsigned end_line = 0U;
 
     CallGraphNode() = default;
     CallGraphNode(unsigned line,
                   unsigned col,
-                  std::string name,
-                  std::string mangled_name,
-                  std::string file)
+                  llvm::StringRef name,
+                  llvm::StringRef mangled_name,
+                  llvm::StringRef file,
+                  unsigned end_line = 0U)
         : line(line),
           col(col),
-          name(std::move(name)),
-          mangled_name(std::move(mangled_name)),
-          file(std::move(file)) {}
+          name(name),
+          mangled_name(mangled_name),
+          file(file),
+          end_line(end_line) {}
+
+    /// \brief Get the node with its strings interned in the arena.
+    [[nodiscard]] CallGraphNode intern(StringArena& arena) const {
+        return {line,
+                col,
+                arena.intern(name),
+                arena.intern(mangled_name),
+                arena.intern(file),
+                end_line};
+    }
 
     bool operator==(const CallGraphNode& other) const {
         return line == other.line && col == other.col && name == other.name &&
-               mangled_name == other.mangled_name && file == other.file;
+               mangled_name == other.mangled_name && file == other.file &&
+               end_line == other.end_line;
     }
     bool operator!=(const CallGraphNode& other) const {
         return !(*this == other);
@@ -112,8 +176,8 @@ struct CallGraphNode {
     }
 
     void dump(llvm::raw_ostream& os) const {
-        os << "CallGraphNode: " << line << ":" << col << " " << name << " "
-           << mangled_name << " " << file;
+        os << "CallGraphNode: " << line << ":" << col << "-" << end_line
+           << " " << name << " " << mangled_name << " " << file;
     }
 
     [[nodiscard]] std::string to_string() const {
@@ -124,6 +188,129 @@ struct CallGraphNode {
     }
 }; // struct CallGraphNode
 
+/// \brief The content hash of a source file of a translation unit.
+struct FileHash {
+    std::string path;
+    uint64_t hash;
+}; // struct FileHash
+
+/// \brief An `#include` of a file by another one.
+struct Include {
+    std::string includer;
+    std::string included;
+
+    Include() = default;
+    Include(std::string includer, std::string included)
+        : includer(std::move(includer)), included(std::move(included)) {}
+
+    bool operator==(const Include& other) const {
+        return includer == other.includer && included == other.included;
+    }
+    bool operator!=(const Include& other) const { return !(*this == other); }
+
+    void dump(llvm::raw_ostream& os) const {
+        os << "Include: " << includer << " -> " << included;
+    }
+}; // struct Include
+
+/// \brief The class hierarchy records, the classes being named by their
+/// mangled RTTI names and the methods by their mangled names. Each record
+/// is owned by the file of the class defining it.
+/// @{
+struct ClassBase {
+    std::string derived;
+    std::string base;
+    std::string file;
+    bool is_virtual;
+}; // struct ClassBase
+
+struct VirtualMethod {
+    std::string method;
+    std::string record;
+    std::string file;
+}; // struct VirtualMethod
+
+struct MethodOverride {
+    std::string method;
+    std::string overridden;
+    std::string file;
+}; // struct MethodOverride
+
+/// \brief A class constructed by a function, owned by the file of the
+/// function.
+struct ClassInstance {
+    std::string record;
+    std::string file;
+}; // struct ClassInstance
+/// @}
+
+/// \brief The kinds of the inclusion constraints of the points-to sets,
+/// `pts(n)` being the set of the nodes the node `n` may point to.
+enum class PointsToKind : uint8_t {
+    /// \brief `dst = &src`, i.e., `src` is in `pts(dst)`.
+    AddressOf,
+    /// \brief `dst = src`, i.e., `pts(src)` is in `pts(dst)`.
+    Copy,
+    /// \brief `dst = *src`, i.e., `pts(o)` is in `pts(dst)` for each `o`
+    /// in `pts(src)`.
+    Load,
+    /// \brief `*dst = src`, i.e., `pts(src)` is in `pts(o)` for each `o`
+    /// in `pts(dst)`.
+    Store
+}; // enum class PointsToKind
+
+/// \brief An inclusion constraint of the whole-program pointer analysis,
+/// owned by the file of the function it is extracted from.
+///
+/// The nodes are the functions and the global variables by their mangled
+/// names, and the parameters, the return values, the local variables, the
+/// allocations and the temporaries of the functions, named after the
+/// mangled name of their function.
+struct PointsToConstraint {
+    PointsToKind kind;
+    std::string dst;
+    std::string src;
+    std::string file;
+}; // struct PointsToConstraint
+
+/// \brief The names of the nodes of the points-to constraints local to a
+/// function, after the mangled name of the function. The functions and
+/// the globals are named by their mangled names.
+/// @{
+[[nodiscard]] inline std::string get_param_node(llvm::StringRef function,
+                                                unsigned index) {
+    return function.str() + "#" + std::to_string(index);
+}
+
+[[nodiscard]] inline std::string get_this_node(llvm::StringRef function) {
+    return function.str() + "#this";
+}
+
+[[nodiscard]] inline std::string get_return_node(llvm::StringRef function) {
+    return function.str() + "#ret";
+}
+
+[[nodiscard]] inline std::string get_local_node(llvm::StringRef function,
+                                                llvm::StringRef name,
+                                                unsigned line,
+                                                unsigned col) {
+    return function.str() + "%" + name.str() + ":" + std::to_string(line) +
+           ":" + std::to_string(col);
+}
+
+[[nodiscard]] inline std::string get_allocation_node(
+    llvm::StringRef function, unsigned line, unsigned col) {
+    return function.str() + "@" + std::to_string(line) + ":" +
+           std::to_string(col);
+}
+
+/// \brief Check if the node is a temporary of an expression, of which the
+/// points-to set is not kept once solved.
+[[nodiscard]] inline bool is_temporary_node(llvm::StringRef node) {
+    return node.contains('$');
+}
+/// @}
+
 } // namespace knight::cg
 
 namespace std {
@@ -131,24 +318,27 @@ namespace std {
 template <>
 struct hash< knight::cg::CallSite > {
     std::size_t operator()(const knight::cg::CallSite& cs) const noexcept {
-        std::size_t h1 = std::hash< unsigned >{}(cs.line);
-        std::size_t h2 = std::hash< unsigned >{}(cs.col);
-        std::size_t h3 = std::hash< std::string >{}(cs.caller);
-        std::size_t h4 = std::hash< std::string >{}(cs.callee);
-        return h1 ^ (h2 << 1) ^ (h3 << 2) ^ (h4 << 3); // NOLINT
+        return llvm::hash_combine(cs.line, cs.col, cs.caller, cs.callee);
     }
 };
 
+/// \brief The mangled name and the location identify a node, so that its
+/// printed signature is not hashed again.
 template <>
 struct hash< knight::cg::CallGraphNode > {
     std::size_t operator()(
         const knight::cg::CallGraphNode& cgn) const noexcept {
-        std::size_t h1 = std::hash< unsigned >{}(cgn.line);
-        std::size_t h2 = std::hash< unsigned >{}(cgn.col);
-        std::size_t h3 = std::hash< std::string >{}(cgn.name);
-        std::size_t h4 = std::hash< std::string >{}(cgn.mangled_name);
-        std::size_t h5 = std::hash< std::string >{}(cgn.file);
-        return h1 ^ (h2 << 1) ^ (h3 << 2) ^ (h4 << 3) ^ (h5 << 4); // NOLINT
+        return llvm::hash_combine(cgn.line,
+                                  cgn.col,
+                                  cgn.mangled_name,
+                                  cgn.file);
+    }
+};
+
+template <>
+struct hash< knight::cg::Include > {
+    std::size_t operator()(const knight::cg::Include& inc) const noexcept {
+        return llvm::hash_combine(inc.includer, inc.included);
     }
 };
 
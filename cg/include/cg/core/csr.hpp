@@ -0,0 +1,174 @@
+//===- csr.hpp --------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the compact binary call graph, stored as the
+//  compressed sparse rows of the callees and of the callers.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "cg/core/cg.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace knight::cg {
+
+/// \brief The on-disk layout of the binary call graph.
+///
+/// The file is a header followed by the sections it locates, each one
+/// aligned to `CSRAlignment`:
+/// - the nodes, sorted by their mangled names,
+/// - the edge offsets and the edges of the callees of each node,
+/// - the edge offsets and the edges of the callers of each node,
+/// - the string pool the nodes refer to.
+///
+/// The integers are in the byte order of the host which wrote the file.
+namespace csr {
+
+constexpr std::array< char, 8U > Magic =
+    {'K', 'N', 'C', 'G', 'C', 'S', 'R', '\0'};
+constexpr uint32_t Version = 1U;
+constexpr uint64_t CSRAlignment = 8U;
+
+struct String {
+    uint32_t offset;
+    uint32_t size;
+}; // struct String
+
+struct Node {
+    String name;
+    String mangled_name;
+    /// \brief Empty if the node has no definition, i.e. it is only called.
+    String file;
+    uint32_t line;
+    uint32_t col;
+}; // struct Node
+
+struct Edge {
+    /// \brief The callee in the callee rows, the caller in the caller rows.
+    uint32_t node;
+    uint32_t line;
+    uint32_t col;
+}; // struct Edge
+
+struct Header {
+    std::array< char, 8U > magic;
+    uint32_t version;
+    uint32_t num_nodes;
+    uint64_t num_edges;
+    uint64_t nodes_offset;
+    uint64_t callee_offsets_offset;
+    uint64_t callee_edges_offset;
+    uint64_t caller_offsets_offset;
+    uint64_t caller_edges_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+}; // struct Header
+
+} // namespace csr
+
+/// \brief Write the binary call graph of the nodes and the call sites.
+///
+/// The functions which are only called get a node without definition.
+/// The file is written next to `path` and renamed over it once complete.
+///
+/// \return false if the file cannot be written or the strings exceed the
+/// 4GiB of the pool.
+[[nodiscard]] bool write_csr_graph(llvm::ArrayRef< CallGraphNode > cg_nodes,
+                                   llvm::ArrayRef< CallSite > callsites,
+                                   llvm::StringRef path);
+
+/// \brief Read-only call graph mapped from a file written by
+/// `write_csr_graph`, without copying or parsing the records.
+class CSRGraph {
+  public:
+    using NodeID = uint32_t;
+    using Edge = csr::Edge;
+
+  private:
+    std::unique_ptr< llvm::MemoryBuffer > m_buffer;
+    const csr::Header* m_header = nullptr;
+    const csr::Node* m_nodes = nullptr;
+    const uint64_t* m_callee_offsets = nullptr;
+    const Edge* m_callee_edges = nullptr;
+    const uint64_t* m_caller_offsets = nullptr;
+    const Edge* m_caller_edges = nullptr;
+    const char* m_strings = nullptr;
+
+  public:
+    /// \returns nullptr if the file cannot be mapped or is not a valid
+    /// binary call graph.
+    [[nodiscard]] static std::unique_ptr< CSRGraph > open(llvm::StringRef path);
+
+    [[nodiscard]] NodeID get_num_nodes() const { return m_header->num_nodes; }
+    [[nodiscard]] uint64_t get_num_edges() const {
+        return m_header->num_edges;
+    }
+
+    /// \brief Find the node of the mangled name by a binary search.
+    [[nodiscard]] std::optional< NodeID > find(
+        llvm::StringRef mangled_name) const;
+
+    [[nodiscard]] llvm::StringRef get_name(NodeID id) const {
+        return get_string(m_nodes[id].name);
+    }
+    [[nodiscard]] llvm::StringRef get_mangled_name(NodeID id) const {
+        return get_string(m_nodes[id].mangled_name);
+    }
+    [[nodiscard]] llvm::StringRef get_file(NodeID id) const {
+        return get_string(m_nodes[id].file);
+    }
+    [[nodiscard]] unsigned get_line(NodeID id) const {
+        return m_nodes[id].line;
+    }
+    [[nodiscard]] unsigned get_col(NodeID id) const {
+        return m_nodes[id].col;
+    }
+    [[nodiscard]] bool has_definition(NodeID id) const {
+        return m_nodes[id].file.size != 0U;
+    }
+
+    /// \brief The call sites in the node, ordered by their locations.
+    [[nodiscard]] llvm::ArrayRef< Edge > get_callees(NodeID id) const {
+        return get_row(m_callee_offsets, m_callee_edges, id);
+    }
+
+    /// \brief The call sites of the node, ordered by their callers.
+    [[nodiscard]] llvm::ArrayRef< Edge > get_callers(NodeID id) const {
+        return get_row(m_caller_offsets, m_caller_edges, id);
+    }
+
+  private:
+    explicit CSRGraph(std::unique_ptr< llvm::MemoryBuffer > buffer)
+        : m_buffer(std::move(buffer)) {}
+
+    /// \brief Locate the sections, and check that the nodes, the rows and
+    /// the edge targets stay within the file.
+    [[nodiscard]] bool map();
+
+    [[nodiscard]] llvm::StringRef get_string(csr::String str) const {
+        return {m_strings + str.offset, str.size};
+    }
+
+    [[nodiscard]] static llvm::ArrayRef< Edge > get_row(
+        const uint64_t* offsets, const Edge* edges, NodeID id) {
+        return {edges + offsets[id], edges + offsets[id + 1U]};
+    }
+
+}; // class CSRGraph
+
+} // namespace knight::cg
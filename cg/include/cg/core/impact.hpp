@@ -0,0 +1,90 @@
+//===- impact.hpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the impact of a change on the translation units and
+//  the functions of the call graph.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "cg/db/db.hpp"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace knight::cg {
+
+/// \brief The changed lines `[first, last]` of a file.
+struct LineRange {
+    unsigned first;
+    unsigned last;
+}; // struct LineRange
+
+/// \brief The changed lines of each changed file, by absolute path. A file
+/// without lines is changed as a whole, e.g., a deleted file.
+using ChangedLines = std::map< std::string, std::vector< LineRange > >;
+
+/// \brief Parse the changed lines, either from a unified diff such as the
+/// output of `git diff -U0`, with the lines of the new files, or from a
+/// list of `file`, `file:line` or `file:first-last` lines.
+///
+/// The relative paths are resolved against the working directory, and the
+/// `a/` and `b/` prefixes of the git diffs are dropped.
+[[nodiscard]] ChangedLines parse_changed_lines(llvm::StringRef text);
+
+/// \brief The functions and the translation units impacted by a change.
+///
+/// A function is impacted if one of its lines changed, or if it calls an
+/// impacted function, transitively. A change out of the functions, e.g.,
+/// to a type or a global variable, impacts all the functions of the files
+/// and of the units including the file. A unit is impacted if it includes,
+/// transitively, a changed file or the definition of an impacted function.
+///
+/// The change is mapped on the call graph and the include graph of the
+/// database, which shall cover all the units.
+class ChangeImpact {
+  private:
+    /// \brief The mangled names of the impacted functions.
+    llvm::StringSet<> m_functions;
+    /// \brief The impacted units.
+    llvm::StringSet<> m_units;
+    /// \brief The impacted units of which all the functions are impacted.
+    llvm::StringSet<> m_full_units;
+
+  public:
+    [[nodiscard]] static ChangeImpact compute(
+        const Database& db,
+        const ChangedLines& changes,
+        llvm::ArrayRef< std::string > units);
+
+    [[nodiscard]] bool is_unit_impacted(llvm::StringRef unit) const {
+        return m_units.count(unit) != 0U;
+    }
+
+    /// \brief Check if the function of the given mangled name, defined or
+    /// used in the given unit, is impacted.
+    [[nodiscard]] bool is_function_impacted(
+        llvm::StringRef unit, llvm::StringRef mangled_name) const {
+        return m_full_units.count(unit) != 0U ||
+               m_functions.count(mangled_name) != 0U;
+    }
+
+    [[nodiscard]] std::size_t get_num_functions() const {
+        return m_functions.size();
+    }
+
+}; // class ChangeImpact
+
+} // namespace knight::cg
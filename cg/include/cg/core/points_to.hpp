@@ -0,0 +1,120 @@
+//===- points_to.hpp --------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the extraction of the points-to constraints of the
+//  functions of a translation unit.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "cg/core/cg.hpp"
+
+#include <clang/AST/Decl.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/ExprCXX.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace knight::cg {
+
+/// \brief Flatten the pointer assignments of the function bodies into the
+/// inclusion constraints of the Andersen analysis.
+///
+/// The extraction is field-insensitive: a field is its object, and an
+/// element is its array. A call binds the arguments to the parameters of
+/// the callee and its result to the return value of the callee, so that
+/// the constraints of the units link through the mangled names. The
+/// references are pointers dereferenced on each use.
+///
+/// Only the values of the pointer, array, reference and record types are
+/// followed, and the indirect calls are not resolved.
+class PointsToExtractor {
+  public:
+    using NameFn = std::function< llvm::StringRef(const clang::NamedDecl*) >;
+
+  private:
+    /// \brief A location of an lvalue: the node itself, or the nodes the
+    /// node points to if indirect.
+    struct Location {
+        std::string node;
+        bool is_indirect;
+    }; // struct Location
+
+    NameFn m_get_name;
+    std::vector< PointsToConstraint >& m_constraints;
+
+    /// \brief The mangled name of the function or of the global variable
+    /// of which the constraints are extracted, and its file.
+    std::string m_owner;
+    std::string m_file;
+    bool m_returns_reference = false;
+    unsigned m_num_temps = 0U;
+
+  public:
+    PointsToExtractor(NameFn get_name,
+                      std::vector< PointsToConstraint >& constraints)
+        : m_get_name(std::move(get_name)), m_constraints(constraints) {}
+
+  public:
+    /// \brief Extract the constraints of the body of the function.
+    void add_function(const clang::FunctionDecl* function,
+                      llvm::StringRef mangled_name,
+                      llvm::StringRef file);
+
+    /// \brief Extract the constraints of the initializer of the global
+    /// variable.
+    void add_global(const clang::VarDecl* var,
+                    llvm::StringRef mangled_name,
+                    llvm::StringRef file);
+
+  private:
+    void add(PointsToKind kind, std::string dst, std::string src);
+    void add_stmt(const clang::Stmt* stmt);
+    void add_assign(const clang::Expr* lhs, const clang::Expr* rhs);
+    void add_var(const clang::VarDecl* var);
+    void add_call(const clang::CallExpr* call);
+    void add_construct(const clang::CXXConstructExpr* construct);
+
+    /// \brief Bind the value of the argument to the parameter.
+    void add_argument(const clang::ParmVarDecl* param,
+                      std::string param_node,
+                      const clang::Expr* arg);
+
+    [[nodiscard]] std::string create_temp();
+    [[nodiscard]] std::string get_var_node(const clang::VarDecl* var);
+
+    /// \brief Get a node pointing to the location.
+    [[nodiscard]] std::string get_address(Location location);
+
+    /// \brief Get the node of which the points-to set over-approximates
+    /// the one of the value of the expression, none if it holds no
+    /// pointer.
+    [[nodiscard]] std::optional< std::string > get_value(
+        const clang::Expr* expr);
+
+    [[nodiscard]] std::optional< std::string > get_call_value(
+        const clang::CallExpr* call);
+
+    /// \brief Get the location the glvalue designates.
+    [[nodiscard]] std::optional< Location > get_location(
+        const clang::Expr* expr);
+
+    /// \brief Get a node of which the points-to set includes the ones of
+    /// both values.
+    [[nodiscard]] std::optional< std::string > merge(
+        std::optional< std::string > lhs, std::optional< std::string > rhs);
+
+}; // class PointsToExtractor
+
+} // namespace knight::cg
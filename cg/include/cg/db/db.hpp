@@ -15,17 +15,85 @@
 
 #include "cg/core/cg.hpp"
 #include "common/util/sqlite3.hpp"
+#include "common/util/sqlite3_pool.hpp"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/xxhash.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace knight::cg {
 
 constexpr unsigned DefaultWriterElemSize = 512U;
 
+/// \brief The number of rows inserted by one multi-row INSERT.
+constexpr unsigned InsertBatchRows = 64U;
+
+/// \brief The version of the layout of the cg tables, stored as the
+/// `user_version` of the database. Older tables are rebuilt.
+constexpr int CGSchemaVersion = 6;
+
+/// \brief Get the hash of the content of a source file.
+[[nodiscard]] inline uint64_t get_content_hash(llvm::StringRef content) {
+    return llvm::xxHash64(content);
+}
+
+/// \brief The cg records extracted from a translation unit.
+struct Records {
+    /// \brief The strings viewed by the cg nodes and the call sites.
+    StringArena strings;
+    std::vector< CallGraphNode > cg_nodes;
+    std::vector< CallSite > callsites;
+    std::vector< Include > includes;
+    /// \brief The source files of the unit, the records of the changed
+    /// ones being replaced by the ones of the unit.
+    std::vector< FileHash > files;
+    /// \brief The class hierarchy of the unit.
+    /// @{
+    std::vector< ClassBase > class_bases;
+    std::vector< VirtualMethod > virtual_methods;
+    std::vector< MethodOverride > method_overrides;
+    std::vector< ClassInstance > class_instances;
+    /// @}
+    /// \brief The points-to constraints of the functions of the unit,
+    /// only extracted for the whole-program pointer analysis.
+    std::vector< PointsToConstraint > points_to_constraints;
+
+    [[nodiscard]] bool has_hierarchy() const {
+        return !class_bases.empty() || !virtual_methods.empty() ||
+               !method_overrides.empty() || !class_instances.empty();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return cg_nodes.empty() && callsites.empty() && includes.empty() &&
+               files.empty() && !has_hierarchy() &&
+               points_to_constraints.empty();
+    }
+}; // struct Records
+
 class Database {
   public:
-    explicit Database(
-        const std::string& knight_dir,
-        int busy_time_mills,
-        int writer_elem_size = DefaultWriterElemSize) noexcept(false);
+    /// \param is_bulk_load whether to drop the lookup indexes while the
+    /// records are inserted, and to build them once by `end_bulk_load()`.
+    /// \param is_in_memory whether to build the database in memory, from
+    /// the content of the one on disk if any, and to write it back to disk
+    /// in one go by `end_bulk_load()`, which saves the journaling and the
+    /// page writes of the inserts.
+    explicit Database(const std::string& knight_dir,
+                      int busy_time_mills,
+                      int writer_elem_size = DefaultWriterElemSize,
+                      bool is_bulk_load = false,
+                      bool is_in_memory = false) noexcept(false);
     ~Database();
 
     Database(const Database&) = delete;
@@ -37,23 +105,227 @@ class Database {
   public:
     void insert_callsite(const CallSite& callsite) noexcept(false);
     void insert_cg_node(const CallGraphNode& cg_node) noexcept(false);
+    void insert_include(const Include& include) noexcept(false);
+    /// \brief Insert the records of a translation unit.
+    ///
+    /// The records owned by the files of the unit which changed since they
+    /// were recorded, i.e., their definitions, call sites and includes, are
+    /// deleted first, in the same transaction. Each file is only refreshed
+    /// by the first unit written with it.
+    void insert_records(const Records& records) noexcept(false);
+    /// \brief Write the buffered records into the database.
+    void flush() noexcept(false);
+    /// \brief The connection, e.g. to group the writes in a transaction
+    /// opened by the caller, which the inserts then join.
+    [[nodiscard]] sqlite::Database& get_connection() { return m_db; }
+    /// \brief Write the buffered records and build the lookup indexes if
+    /// they were dropped for the bulk load. In the in-memory mode, the
+    /// database is then written to disk if it changed since the last time.
+    void end_bulk_load() noexcept(false);
+
+    /// \brief Merge the records of another cg database, e.g. the one of
+    /// another shard of the same project.
+    ///
+    /// \return false if the database does not exist or has another layout.
+    [[nodiscard]] bool merge(const std::string& db_file) noexcept(false);
+
+    /// \brief The queries of the cg nodes and the call sites, of which the
+    /// strings live as long as the database.
     [[nodiscard]] std::vector< CallGraphNode > get_all_cg_nodes()
         const noexcept;
     [[nodiscard]] std::vector< CallSite > get_all_callsites() const noexcept;
 
+    /// \brief The indexed point queries.
+    /// @{
+    [[nodiscard]] std::optional< CallGraphNode > get_node(
+        const std::string& mangled_name) const noexcept;
+    [[nodiscard]] std::vector< CallSite > get_callees(
+        const std::string& mangled_name) const noexcept;
+    [[nodiscard]] std::vector< CallSite > get_callers(
+        const std::string& mangled_name) const noexcept;
+    [[nodiscard]] std::vector< CallGraphNode > get_nodes_in_file(
+        const std::string& path) const noexcept;
+    /// \brief Get the files including the given one directly.
+    [[nodiscard]] std::vector< std::string > get_includers(
+        const std::string& path) const noexcept;
+    /// @}
+
+    /// \brief The class hierarchy queries.
+    /// @{
+    /// \brief Get the methods a virtual call to the given method may
+    /// dispatch to: the method and its overriders, transitively.
+    ///
+    /// \param is_rta whether to only keep the methods of the classes of
+    /// which an instance may be constructed, i.e., the bases of the
+    /// constructed classes, as by the rapid type analysis. Otherwise, all
+    /// the overriders are kept, as by the class hierarchy analysis.
+    [[nodiscard]] std::vector< std::string > get_virtual_targets(
+        const std::string& mangled_name, bool is_rta = false) const noexcept;
+    /// \brief Get the classes derived from the given one, transitively.
+    [[nodiscard]] std::vector< std::string > get_derived_classes(
+        const std::string& record) const noexcept;
+    /// @}
+
+    /// \brief The whole-program pointer analysis, see `andersen.hpp`.
+    /// @{
+    [[nodiscard]] std::vector< PointsToConstraint >
+    get_all_points_to_constraints() const noexcept;
+    /// \brief Get the solved points-to sets as `(pointer, pointee)` rows.
+    [[nodiscard]] std::vector< std::pair< std::string, std::string > >
+    get_all_points_to_sets() const noexcept;
+    /// \brief Replace the solved points-to sets by the given rows.
+    void replace_points_to_sets(
+        const std::vector< std::pair< std::string, std::string > >& rows)
+        noexcept(false);
+    /// @}
+
+    /// \brief Check if the records of the given unit are up to date, i.e.,
+    /// if the unit and the files it includes are all recorded with their
+    /// current content.
+    [[nodiscard]] bool is_up_to_date(const std::string& unit,
+                                     llvm::vfs::FileSystem& fs) const noexcept;
+
   private:
     void create_table_if_not_exist() const noexcept;
+    void create_indexes() const noexcept;
+    void drop_indexes() const noexcept;
     void flush_cg_nodes();
     void flush_callsites();
+    void flush_includes();
+
+    /// \brief Insert the class hierarchy of a unit, in the transaction of
+    /// the unit.
+    void insert_hierarchy(const Records& records);
+
+    /// \brief Insert the points-to constraints of a unit, in the
+    /// transaction of the unit.
+    void insert_points_to_constraints(const Records& records);
+
+    /// \brief Delete the records owned by the file if it changed, and
+    /// record its new hash.
+    void refresh_file(const FileHash& file);
+
+    /// \brief Get the ID of the symbol of the mangled name, inserting it
+    /// on its first use.
+    [[nodiscard]] int64_t get_symbol_id(llvm::StringRef mangled_name);
+
+    /// \brief Get the ID of the file of the path, inserting it on its
+    /// first use.
+    [[nodiscard]] int64_t get_file_id(llvm::StringRef path);
+
+    [[nodiscard]] llvm::StringRef intern_string(llvm::StringRef str) const;
 
   private:
     sqlite::Database m_db;
 
     int m_writer_elem_size;
+    bool m_is_bulk_load;
+
+    /// \brief The file the in-memory database is written to, empty if the
+    /// database is on disk.
+    std::string m_snapshot_file;
+    /// \brief The total changes of the connection when the database was
+    /// last written to disk, none before the first time.
+    std::optional< int > m_snapshot_changes;
+
+    /// \brief The strings of the buffered and inserted records, which
+    /// outlive the records of the units, and of the read ones.
+    mutable StringArena m_strings;
 
     std::vector< CallGraphNode > m_cg_nodes;
     std::vector< CallSite > m_callsites;
+    std::vector< Include > m_includes;
+
+    /// \brief The interned symbol and file IDs, so that each string is
+    /// only looked up in the database once.
+    llvm::StringMap< int64_t > m_symbol_ids;
+    llvm::StringMap< int64_t > m_file_ids;
+
+    /// \brief The records inserted so far, so that the ones of the headers
+    /// shared by several translation units are only written once.
+    std::unordered_set< CallGraphNode > m_inserted_cg_nodes;
+    std::unordered_set< CallSite > m_inserted_callsites;
+    std::unordered_set< Include > m_inserted_includes;
+
+    /// \brief The files refreshed by the units written so far.
+    std::unordered_set< std::string > m_refreshed_files;
+
+    /// \brief The statements prepared once for the lifetime of the
+    /// database, which is why they are destroyed first.
+    struct Statements {
+        sqlite::PreparedStmt insert_cg_node_batch;
+        sqlite::PreparedStmt insert_cg_node;
+        sqlite::PreparedStmt insert_callsite_batch;
+        sqlite::PreparedStmt insert_callsite;
+        sqlite::PreparedStmt insert_include_batch;
+        sqlite::PreparedStmt insert_include;
+        sqlite::PreparedStmt insert_symbol;
+        sqlite::PreparedStmt select_symbol;
+        sqlite::PreparedStmt insert_file;
+        sqlite::PreparedStmt select_file;
+        sqlite::PreparedStmt select_file_hash;
+        sqlite::PreparedStmt update_file_hash;
+        sqlite::PreparedStmt delete_file_cg_nodes;
+        sqlite::PreparedStmt delete_file_callsites;
+        sqlite::PreparedStmt delete_file_includes;
+        sqlite::PreparedStmt insert_class_base;
+        sqlite::PreparedStmt insert_virtual_method;
+        sqlite::PreparedStmt insert_method_override;
+        sqlite::PreparedStmt insert_class_instance;
+        sqlite::PreparedStmt delete_file_class_bases;
+        sqlite::PreparedStmt delete_file_virtual_methods;
+        sqlite::PreparedStmt delete_file_method_overrides;
+        sqlite::PreparedStmt delete_file_class_instances;
+        sqlite::PreparedStmt insert_points_to_constraint;
+        sqlite::PreparedStmt delete_file_points_to_constraints;
+    }; // struct Statements
+    std::unique_ptr< Statements > m_stmts;
 
 }; // class Database
 
+/// \brief The point queries of a cg database from concurrent threads.
+///
+/// Each query leases a read-only connection of a pool, on which its
+/// statement is prepared once, so that the parallel workers neither share
+/// a connection nor contend on one.
+class DatabaseReader {
+  private:
+    mutable sqlite::ConnectionPool m_pool;
+
+    /// \brief The strings of the read records, shared by the queries.
+    mutable std::mutex m_strings_mutex;
+    mutable StringArena m_strings;
+
+  public:
+    /// \throw std::runtime_error if the database cannot be opened.
+    DatabaseReader(const std::string& knight_dir,
+                   std::size_t max_connections,
+                   int busy_time_mills) noexcept(false);
+
+  public:
+    /// \see Database for the queries, the strings of the read records
+    /// living as long as the reader.
+    /// @{
+    [[nodiscard]] std::optional< CallGraphNode > get_node(
+        const std::string& mangled_name) const noexcept(false);
+    [[nodiscard]] std::vector< CallSite > get_callees(
+        const std::string& mangled_name) const noexcept(false);
+    [[nodiscard]] std::vector< CallSite > get_callers(
+        const std::string& mangled_name) const noexcept(false);
+    [[nodiscard]] std::vector< CallGraphNode > get_nodes_in_file(
+        const std::string& path) const noexcept(false);
+    [[nodiscard]] std::vector< std::string > get_includers(
+        const std::string& path) const noexcept(false);
+    [[nodiscard]] std::vector< std::string > get_virtual_targets(
+        const std::string& mangled_name, bool is_rta = false) const
+        noexcept(false);
+    [[nodiscard]] std::vector< std::string > get_derived_classes(
+        const std::string& record) const noexcept(false);
+    /// @}
+
+  private:
+    [[nodiscard]] llvm::StringRef intern_string(llvm::StringRef str) const;
+
+}; // class DatabaseReader
+
 } // namespace knight::cg
\ No newline at end of file
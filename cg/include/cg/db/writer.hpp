@@ -0,0 +1,60 @@
+//===- writer.hpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file defines the single writer of the cg database.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "cg/db/db.hpp"
+#include "common/util/sqlite3_writer.hpp"
+
+#include <memory>
+#include <string>
+
+namespace knight::cg {
+
+/// \brief The only owner of the connection to the cg database.
+///
+/// In the threaded mode, the records pushed by the extraction workers are
+/// queued to an asynchronous writer, which commits the units queued
+/// meanwhile in one transaction, so that the workers never wait on the
+/// database lock. Otherwise, they are written on the calling thread. The
+/// lookup indexes are built once all the records are written. In the
+/// in-memory mode, the database is then written to disk in one go.
+class DatabaseWriter {
+  private:
+    Database m_db;
+
+    /// \brief The writer thread, null unless in the threaded mode.
+    std::unique_ptr< sqlite::AsyncWriter > m_async_writer;
+
+  public:
+    DatabaseWriter(const std::string& knight_dir,
+                   int busy_time_mills,
+                   bool is_threaded,
+                   bool is_in_memory = false) noexcept(false);
+    ~DatabaseWriter();
+
+    DatabaseWriter(const DatabaseWriter&) = delete;
+    DatabaseWriter& operator=(const DatabaseWriter&) = delete;
+    DatabaseWriter(DatabaseWriter&&) = delete;
+    DatabaseWriter& operator=(DatabaseWriter&&) = delete;
+
+  public:
+    /// \brief Write the records of a translation unit.
+    void push(Records records);
+
+    /// \brief Write all the pushed records and stop the writer thread.
+    void finish();
+
+}; // class DatabaseWriter
+
+} // namespace knight::cg
@@ -19,6 +19,8 @@
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Debug.h>
 
+#include "common/util/progress.hpp"
+
 namespace knight::cg::cl_opts {
 
 using namespace llvm;
@@ -50,6 +52,8 @@ Overlay the vfs described by overlay file on the real fs.
 inline cl::opt< std::string > knight_dir("dir",
                                          desc(R"(
 The directory to store the knight intermediate files.
+When set, the compilation database is indexed there, so
+that the later runs do not parse its JSON again.
 )"),
                                          cl::value_desc("directory"),
                                          cl::cat(knight_cg_category));
@@ -62,6 +66,78 @@ The timeout for waiting for the database to become available.
                                            cl::init(5000),
                                            cl::cat(knight_cg_category));
 
+inline cl::opt< unsigned > jobs("j",
+                                desc(R"(
+Number of translation units extracted in parallel.
+Use 0 to run one worker per hardware thread.
+)"),
+                                cl::init(1U),
+                                cl::value_desc("N"),
+                                cl::cat(knight_cg_category));
+
+inline cl::opt< std::string > shard_spec("shard",
+                                         desc(R"(
+Only extract the i-th of N shards of the input files, or
+of all the files of the compilation database if none is
+given, with 0 <= i < N. The shards are balanced by the
+file sizes and are the same on every machine.
+)"),
+                                         cl::value_desc("i/N"),
+                                         cl::cat(knight_cg_category));
+
+inline cl::list< std::string > merge_db("merge-db",
+                                        desc(R"(
+Merge the cg.db files of the shards into the one of
+the knight directory, and exit.
+)"),
+                                        cl::CommaSeparated,
+                                        cl::value_desc("files"),
+                                        cl::cat(knight_cg_category));
+
+inline cl::opt< std::string > pch_header("pch-header",
+                                         desc(R"(
+Precompile the given header once for each group of TUs
+sharing a compile command, and reuse it when parsing
+them. The TUs are expected to include it first.
+)"),
+                                         cl::value_desc("header"),
+                                         cl::cat(knight_cg_category));
+
+inline cl::opt< std::string > export_csr("export-csr",
+                                         desc(R"(
+Export the call graph to the given file in a binary format of
+compressed sparse rows, which cg::CSRGraph maps without parsing.
+)"),
+                                         cl::value_desc("filename"),
+                                         cl::cat(knight_cg_category));
+
+inline cl::opt< bool > incremental("incremental",
+                                   desc(R"(
+Skip the TUs of which the records in cg.db are up to date,
+by the content hashes of the files they include, and
+replace the records of the changed files.
+)"),
+                                   cl::init(true),
+                                   cl::cat(knight_cg_category));
+
+inline cl::opt< bool > in_memory_db("in-memory-db",
+                                    desc(R"(
+Build cg.db in memory and write it to disk once, with its
+indexes, when all the TUs are extracted, e.g. for one-shot
+CI runs. An existing cg.db is loaded into memory first.
+)"),
+                                    cl::init(false),
+                                    cl::cat(knight_cg_category));
+
+inline cl::opt< bool > points_to("points-to",
+                                 desc(R"(
+Extract the points-to constraints of the functions and
+solve the whole-program Andersen pointer analysis into
+cg.db, for the analyzer option --points-to.
+)"),
+                                 cl::init(false),
+                                 cl::cat(knight_cg_category));
+
 inline cl::opt< bool > use_color("use-color",
                                  desc(R"(
 Use colors in output.
@@ -69,6 +145,27 @@ Use colors in output.
                                  cl::init(true),
                                  cl::cat(knight_cg_category));
 
+inline cl::opt< ProgressMode > progress(
+    "progress",
+    desc(R"(
+How to report the processed functions on the stdout.
+)"),
+    cl::values(clEnumValN(ProgressMode::List, "list", "list every function"),
+               clEnumValN(ProgressMode::Summary,
+                          "summary",
+                          "refresh a status line with the functions/sec, "
+                          "the TUs done and the ETA"),
+               clEnumValN(ProgressMode::Quiet, "quiet", "print nothing")),
+    cl::init(ProgressMode::List),
+    cl::cat(knight_cg_category));
+
+inline cl::opt< bool > quiet("quiet",
+                             desc(R"(
+Do not report the processed functions, same as --progress=quiet.
+)"),
+                             cl::init(false),
+                             cl::cat(knight_cg_category));
+
 inline cl::opt< bool > show_process_sys_function("show-process-sys-function",
                                                  desc(R"(
 Show processing system functions.
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "cg/core/builder.hpp"
+#include "cg/db/writer.hpp"
 #include "clang/AST/ASTContext.h"
 #include "common/util/vfs.hpp"
 
@@ -22,6 +23,7 @@
 #include <clang/Basic/Diagnostic.h>
 #include <clang/Basic/LLVM.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
 #include <clang/Tooling/CompilationDatabase.h>
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/raw_ostream.h>
@@ -44,6 +46,29 @@ struct CGContext { // NOLINT
 
     std::string knight_dir;
     unsigned db_busy_timeout;
+    /// header precompiled once per compile command group, empty if none
+    std::string pch_header;
+    /// file to export the binary call graph to, empty if none
+    std::string csr_file;
+    /// number of translation units extracted in parallel, 0 for one per
+    /// hardware thread
+    unsigned jobs = 1U;
+    /// whether to skip the translation units of which the records are up
+    /// to date in the database
+    bool incremental = true;
+    /// whether to build the database in memory and write it to disk once
+    /// when the extraction finishes
+    bool in_memory_db = false;
+    /// whether to extract the points-to constraints and solve the
+    /// whole-program pointer analysis when the extraction finishes
+    bool points_to = false;
+    /// the writer of the records of the extracted translation units
+    cg::DatabaseWriter* writer = nullptr;
+    /// the header definitions already extracted by the process
+    cg::ExtractedDefinitions* extracted_defs = nullptr;
+    /// whether the extracted units and functions are reported to the
+    /// progress, false when another tool reports the units it parses
+    bool report_progress = true;
     clang::ASTContext* ast_ctx = nullptr;
     std::string file;
 
@@ -72,16 +97,34 @@ struct CGContext { // NOLINT
           file(std::move(file)) {}
 };
 
-class KnightASTConsumer : public clang::ASTConsumer {
+class CGASTConsumer : public clang::ASTConsumer {
   public:
-    explicit KnightASTConsumer(CGContext& ctx) : m_ctx(ctx), m_builder(ctx) {}
+    explicit CGASTConsumer(CGContext& ctx) : m_ctx(ctx), m_builder(ctx) {}
+
+    /// \brief Create a consumer owning its context, so that consumers of
+    /// several threads do not share the current TU of the context.
+    explicit CGASTConsumer(std::unique_ptr< CGContext > ctx)
+        : m_owned_ctx(std::move(ctx)),
+          m_ctx(*m_owned_ctx),
+          m_builder(*m_owned_ctx) {}
 
     bool HandleTopLevelDecl(clang::DeclGroupRef decl_group) override;
+    void HandleTranslationUnit(clang::ASTContext& ast_ctx) override;
 
   private:
+    /// \brief Check if the function is defined in a header and was
+    /// already extracted, by this or another translation unit.
+    [[nodiscard]] bool is_extracted(const clang::FunctionDecl* function);
+
+    /// \brief Report the extracted function to the progress.
+    void report_progress(const clang::FunctionDecl* function,
+                         bool is_system_function) const;
+
+  private:
+    std::unique_ptr< CGContext > m_owned_ctx;
     CGContext& m_ctx;
     cg::CGBuilder m_builder;
-}; // class KnightASTConsumer
+}; // class CGASTConsumer
 
 class KnightIRConsumer {
   private:
@@ -98,12 +141,46 @@ class KnightIRConsumer {
 class KnightCGBuilder {
   private:
     CGContext& m_ctx;
+    std::unique_ptr< cg::ExtractedDefinitions > m_extracted_defs;
+    std::unique_ptr< cg::DatabaseWriter > m_writer;
 
   public:
     explicit KnightCGBuilder(CGContext& ctx) : m_ctx(ctx) {}
 
   public:
     void build();
+
+    /// \brief Open the database writer of the extraction.
+    ///
+    /// \param concurrent whether the records are pushed by several threads.
+    void begin_extraction(bool concurrent);
+
+    /// \brief Flush the records, and export the call graph and solve the
+    /// points-to sets if required.
+    void finish_extraction();
+
+    /// \brief Create a consumer extracting the call graph of the given
+    /// TU, e.g., next to the consumer of another tool parsing the TU.
+    ///
+    /// Can be called on any thread between `begin_extraction` and
+    /// `finish_extraction`.
+    [[nodiscard]] std::unique_ptr< clang::ASTConsumer > create_ast_consumer(
+        clang::ASTContext& ast_ctx, llvm::StringRef file) const;
+
+  private:
+    /// \brief Drop the input files of which the records are up to date.
+    void skip_up_to_date_files();
+
+    void run_on_files(CGContext& ctx,
+                      const std::vector< std::string >& files,
+                      const clang::tooling::ArgumentsAdjuster& pch_adjuster);
+
+    /// \brief Extract the input files on `jobs` worker threads.
+    ///
+    /// Each worker owns its context and file system, and the records are
+    /// only shared through the writer of the context.
+    void run_in_parallel(unsigned jobs,
+                         const clang::tooling::ArgumentsAdjuster& pch_adjuster);
 }; // class KnightDriver
 
 } // namespace knight
@@ -0,0 +1,449 @@
+//===- andersen.cpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the whole-program inclusion-based pointer analysis
+//  over the points-to constraints of the call graph database.
+//
+//===------------------------------------------------------------------===//
+
+#include "cg/core/andersen.hpp"
+#include "common/util/log.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#define DEBUG_TYPE "cg-andersen"
+
+namespace knight::cg {
+
+namespace {
+
+using NodeID = PointsToFacts::NodeID;
+using PointsToSet = PointsToFacts::PointsToSet;
+
+/// \brief The fewest nodes with loads or stores worth a thread.
+constexpr std::size_t MinNodesPerThread = 1024U;
+
+/// \brief The wave propagation solver, over the representatives of the
+/// collapsed cycles.
+class WaveSolver {
+  private:
+    std::vector< NodeID > m_parents;
+    std::vector< PointsToSet > m_points_to;
+    /// \brief The part of the points-to set already pushed along the copy
+    /// edges, and the part of which the loads and the stores are added.
+    /// @{
+    std::vector< PointsToSet > m_propagated;
+    std::vector< PointsToSet > m_processed;
+    /// @}
+    /// \brief The copy edges `pts(n) <= pts(s)` of each node `n`.
+    std::vector< PointsToSet > m_succs;
+    /// \brief The `dst` of the loads `dst = *n` of each node `n`.
+    std::vector< PointsToSet > m_loads;
+    /// \brief The `src` of the stores `*n = src` of each node `n`.
+    std::vector< PointsToSet > m_stores;
+    unsigned m_jobs;
+
+  public:
+    WaveSolver(std::size_t num_nodes, unsigned jobs)
+        : m_parents(num_nodes), m_points_to(num_nodes),
+          m_propagated(num_nodes), m_processed(num_nodes),
+          m_succs(num_nodes), m_loads(num_nodes), m_stores(num_nodes),
+          m_jobs(jobs) {
+        for (NodeID node = 0U; node < num_nodes; ++node) {
+            m_parents[node] = node;
+        }
+    }
+
+    void add(PointsToKind kind, NodeID dst, NodeID src) {
+        switch (kind) {
+            case PointsToKind::AddressOf:
+                m_points_to[dst].set(src);
+                break;
+            case PointsToKind::Copy:
+                m_succs[src].set(dst);
+                break;
+            case PointsToKind::Load:
+                m_loads[src].set(dst);
+                break;
+            case PointsToKind::Store:
+                m_stores[dst].set(src);
+                break;
+        }
+    }
+
+    void solve() {
+        unsigned num_rounds = 0U;
+        bool is_changed = true;
+        while (is_changed) {
+            ++num_rounds;
+            propagate(collapse_cycles());
+            is_changed = add_complex_edges();
+        }
+        knight_log_nl(llvm::outs() << "andersen solved in " << num_rounds
+                                   << " rounds\n");
+    }
+
+    [[nodiscard]] std::vector< NodeID > take_reps() {
+        for (NodeID node = 0U; node < m_parents.size(); ++node) {
+            (void)find(node);
+        }
+        return std::move(m_parents);
+    }
+
+    [[nodiscard]] std::vector< PointsToSet > take_points_to() {
+        return std::move(m_points_to);
+    }
+
+  private:
+    [[nodiscard]] NodeID find(NodeID node) {
+        auto root = node;
+        while (m_parents[root] != root) {
+            root = m_parents[root];
+        }
+        while (m_parents[node] != root) {
+            node = std::exchange(m_parents[node], root);
+        }
+        return root;
+    }
+
+    /// \brief Find without the path compression, for the worker threads.
+    [[nodiscard]] NodeID find_const(NodeID node) const {
+        while (m_parents[node] != node) {
+            node = m_parents[node];
+        }
+        return node;
+    }
+
+    /// \brief Merge the node `src` into the representative `dst`.
+    void unite(NodeID dst, NodeID src) {
+        m_parents[src] = dst;
+        m_points_to[dst] |= m_points_to[src];
+        m_succs[dst] |= m_succs[src];
+        m_loads[dst] |= m_loads[src];
+        m_stores[dst] |= m_stores[src];
+        // Only what both nodes pushed is pushed by the merged one.
+        m_propagated[dst] &= m_propagated[src];
+        m_processed[dst] &= m_processed[src];
+        for (auto* sets : {&m_points_to,
+                           &m_propagated,
+                           &m_processed,
+                           &m_succs,
+                           &m_loads,
+                           &m_stores}) {
+            (*sets)[src].clear();
+        }
+    }
+
+    /// \brief Collapse the cycles of the copy edges by the iterative
+    /// Tarjan algorithm.
+    ///
+    /// \return the representatives in topological order.
+    [[nodiscard]] std::vector< NodeID > collapse_cycles() {
+        constexpr unsigned Unvisited = ~0U;
+        const auto num_nodes = static_cast< NodeID >(m_parents.size());
+        std::vector< unsigned > indexes(num_nodes, Unvisited);
+        std::vector< unsigned > lowlinks(num_nodes, 0U);
+        std::vector< bool > is_on_stack(num_nodes, false);
+        std::vector< NodeID > stack;
+        std::vector< std::vector< NodeID > > sccs;
+        struct Frame {
+            NodeID node;
+            PointsToSet::iterator it;
+        }; // struct Frame
+        std::vector< Frame > frames;
+        unsigned next_index = 0U;
+
+        auto enter = [&](NodeID node) {
+            indexes[node] = lowlinks[node] = next_index++;
+            stack.push_back(node);
+            is_on_stack[node] = true;
+            frames.push_back(Frame{node, m_succs[node].begin()});
+        };
+
+        for (NodeID root = 0U; root < num_nodes; ++root) {
+            if (find(root) != root || indexes[root] != Unvisited) {
+                continue;
+            }
+            enter(root);
+            while (!frames.empty()) {
+                auto& frame = frames.back();
+                const auto node = frame.node;
+                if (frame.it != m_succs[node].end()) {
+                    const auto succ = find(*frame.it);
+                    ++frame.it;
+                    if (indexes[succ] == Unvisited) {
+                        enter(succ);
+                    } else if (is_on_stack[succ]) {
+                        lowlinks[node] =
+                            std::min(lowlinks[node], indexes[succ]);
+                    }
+                    continue;
+                }
+                frames.pop_back();
+                if (!frames.empty()) {
+                    auto& parent = frames.back().node;
+                    lowlinks[parent] =
+                        std::min(lowlinks[parent], lowlinks[node]);
+                }
+                if (lowlinks[node] != indexes[node]) {
+                    continue;
+                }
+                auto& scc = sccs.emplace_back();
+                NodeID member = 0U;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    is_on_stack[member] = false;
+                    scc.push_back(member);
+                } while (member != node);
+            }
+        }
+
+        // The components complete after their successors.
+        std::vector< NodeID > order;
+        order.reserve(sccs.size());
+        for (auto it = sccs.rbegin(); it != sccs.rend(); ++it) {
+            const auto rep = it->front();
+            for (std::size_t idx = 1U; idx < it->size(); ++idx) {
+                unite(rep, (*it)[idx]);
+            }
+            order.push_back(rep);
+        }
+        return order;
+    }
+
+    /// \brief Push the new points-to facts along the copy edges.
+    void propagate(const std::vector< NodeID >& order) {
+        PointsToSet delta;
+        for (const auto node : order) {
+            delta.intersectWithComplement(m_points_to[node],
+                                          m_propagated[node]);
+            if (delta.empty()) {
+                continue;
+            }
+            m_propagated[node] = m_points_to[node];
+            for (const auto succ : m_succs[node]) {
+                const auto rep = find(succ);
+                if (rep != node) {
+                    m_points_to[rep] |= delta;
+                }
+            }
+        }
+    }
+
+    /// \brief Collect the copy edges of the loads and the stores of the
+    /// new pointees of the given nodes.
+    void collect_complex_edges(
+        llvm::ArrayRef< NodeID > nodes,
+        std::vector< std::pair< NodeID, NodeID > >& edges) {
+        PointsToSet delta;
+        for (const auto node : nodes) {
+            delta.intersectWithComplement(m_points_to[node],
+                                          m_processed[node]);
+            m_processed[node] = m_points_to[node];
+            for (const auto pointee : delta) {
+                const auto obj = find_const(pointee);
+                for (const auto dst : m_loads[node]) {
+                    edges.emplace_back(obj, find_const(dst));
+                }
+                for (const auto src : m_stores[node]) {
+                    edges.emplace_back(find_const(src), obj);
+                }
+            }
+        }
+    }
+
+    /// \brief Add the copy edges of the loads and the stores.
+    ///
+    /// \return true if an edge was added.
+    [[nodiscard]] bool add_complex_edges() {
+        std::vector< NodeID > nodes;
+        for (NodeID node = 0U; node < m_parents.size(); ++node) {
+            if (m_parents[node] == node &&
+                (!m_loads[node].empty() || !m_stores[node].empty())) {
+                nodes.push_back(node);
+            }
+        }
+        auto num_threads = static_cast< std::size_t >(m_jobs);
+        num_threads = std::max< std::size_t >(
+            1U, std::min(num_threads, nodes.size() / MinNodesPerThread));
+
+        // The workers only write the processed sets of their own nodes.
+        std::vector< std::vector< std::pair< NodeID, NodeID > > > edges(
+            num_threads);
+        const llvm::ArrayRef< NodeID > all_nodes(nodes);
+        const auto chunk = (nodes.size() + num_threads - 1U) / num_threads;
+        auto slice = [&](std::size_t thread_id) {
+            const auto begin = std::min(thread_id * chunk, nodes.size());
+            const auto end = std::min(begin + chunk, nodes.size());
+            return all_nodes.slice(begin, end - begin);
+        };
+        if (num_threads == 1U) {
+            collect_complex_edges(all_nodes, edges.front());
+        } else {
+            std::vector< std::thread > workers;
+            workers.reserve(num_threads);
+            for (std::size_t thread_id = 0U; thread_id < num_threads;
+                 ++thread_id) {
+                workers.emplace_back([&, thread_id]() {
+                    collect_complex_edges(slice(thread_id), edges[thread_id]);
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        bool is_changed = false;
+        for (const auto& thread_edges : edges) {
+            for (auto [src, dst] : thread_edges) {
+                src = find(src);
+                dst = find(dst);
+                if (src == dst || !m_succs[src].test_and_set(dst)) {
+                    continue;
+                }
+                // The new edge also carries the facts already pushed.
+                m_points_to[dst] |= m_points_to[src];
+                is_changed = true;
+            }
+        }
+        return is_changed;
+    }
+
+}; // class WaveSolver
+
+} // anonymous namespace
+
+PointsToFacts::NodeID PointsToFacts::get_or_create_id(llvm::StringRef name) {
+    auto [it, inserted] =
+        m_ids.try_emplace(name, static_cast< NodeID >(m_names.size()));
+    if (inserted) {
+        m_names.push_back(it->getKey());
+    }
+    return it->second;
+}
+
+PointsToFacts PointsToFacts::solve(
+    const std::vector< PointsToConstraint >& constraints, unsigned jobs) {
+    PointsToFacts facts;
+    std::vector< std::pair< NodeID, NodeID > > nodes;
+    nodes.reserve(constraints.size());
+    for (const auto& constraint : constraints) {
+        const auto dst = facts.get_or_create_id(constraint.dst);
+        nodes.emplace_back(dst, facts.get_or_create_id(constraint.src));
+    }
+
+    WaveSolver solver(facts.m_names.size(),
+                      jobs == 0U ? std::thread::hardware_concurrency()
+                                 : jobs);
+    for (std::size_t idx = 0U; idx < constraints.size(); ++idx) {
+        solver.add(constraints[idx].kind, nodes[idx].first, nodes[idx].second);
+    }
+    solver.solve();
+    facts.m_reps = solver.take_reps();
+    facts.m_points_to = solver.take_points_to();
+    facts.m_hash = facts.compute_hash();
+    return facts;
+}
+
+PointsToFacts PointsToFacts::load(const Database& db) {
+    PointsToFacts facts;
+    std::vector< std::pair< NodeID, NodeID > > rows;
+    for (const auto& [pointer, pointee] : db.get_all_points_to_sets()) {
+        const auto pointer_id = facts.get_or_create_id(pointer);
+        rows.emplace_back(pointer_id, facts.get_or_create_id(pointee));
+    }
+    facts.m_points_to.resize(facts.m_names.size());
+    for (const auto& [pointer_id, pointee_id] : rows) {
+        facts.m_points_to[pointer_id].set(pointee_id);
+    }
+    facts.m_reps.resize(facts.m_names.size());
+    for (NodeID node = 0U; node < facts.m_reps.size(); ++node) {
+        facts.m_reps[node] = node;
+    }
+    facts.m_hash = facts.compute_hash();
+    return facts;
+}
+
+void PointsToFacts::save(Database& db) const {
+    std::vector< std::pair< std::string, std::string > > rows;
+    for (NodeID node = 0U; node < m_names.size(); ++node) {
+        if (is_temporary_node(m_names[node])) {
+            continue;
+        }
+        for (const auto pointee : m_points_to[m_reps[node]]) {
+            rows.emplace_back(m_names[node].str(), m_names[pointee].str());
+        }
+    }
+    db.replace_points_to_sets(rows);
+}
+
+uint64_t PointsToFacts::compute_hash() const {
+    // The sum of the hashes of the saved pairs is the same in any order.
+    uint64_t hash = 0U;
+    std::string pair;
+    for (NodeID node = 0U; node < m_names.size(); ++node) {
+        if (is_temporary_node(m_names[node])) {
+            continue;
+        }
+        for (const auto pointee : m_points_to[m_reps[node]]) {
+            pair.assign(m_names[node]);
+            pair.push_back('\0');
+            pair.append(m_names[pointee]);
+            hash += llvm::xxHash64(pair);
+        }
+    }
+    return hash;
+}
+
+const PointsToFacts::PointsToSet* PointsToFacts::get_set(
+    llvm::StringRef node) const {
+    auto it = m_ids.find(node);
+    if (it == m_ids.end()) {
+        return nullptr;
+    }
+    return &m_points_to[m_reps[it->second]];
+}
+
+bool PointsToFacts::may_alias(llvm::StringRef p, llvm::StringRef q) const {
+    const auto* p_set = get_set(p);
+    const auto* q_set = get_set(q);
+    if (p_set == nullptr || q_set == nullptr) {
+        return true;
+    }
+    return p_set->intersects(*q_set);
+}
+
+bool PointsToFacts::may_point_to(llvm::StringRef p,
+                                 llvm::StringRef pointee) const {
+    const auto* set = get_set(p);
+    if (set == nullptr) {
+        return true;
+    }
+    auto it = m_ids.find(pointee);
+    return it != m_ids.end() && set->test(it->second);
+}
+
+std::vector< llvm::StringRef > PointsToFacts::get_points_to(
+    llvm::StringRef p) const {
+    std::vector< llvm::StringRef > pointees;
+    if (const auto* set = get_set(p)) {
+        for (const auto pointee : *set) {
+            pointees.push_back(m_names[pointee]);
+        }
+    }
+    return pointees;
+}
+
+} // namespace knight::cg
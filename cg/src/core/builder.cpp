@@ -21,7 +21,11 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/ExprCXX.h>
 #include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/StringSet.h>
 #include <llvm/Support/Casting.h>
 
 #define DEBUG_TYPE "cg-builder"
@@ -30,20 +34,68 @@ namespace knight::cg {
 
 namespace {
 
-using namespace clang;
+/// \brief Check if the call is dispatched on the dynamic type of the
+/// object.
+bool is_virtual_call(const clang::CallExpr* call) {
+    const auto* member_call = llvm::dyn_cast< clang::CXXMemberCallExpr >(call);
+    if (member_call == nullptr) {
+        return false;
+    }
+    const auto* method = member_call->getMethodDecl();
+    if (method == nullptr || !method->isVirtual()) {
+        return false;
+    }
+    // A qualified call such as `Base::f()` is not dispatched.
+    const auto* member = llvm::dyn_cast< clang::MemberExpr >(
+        member_call->getCallee()->IgnoreParens());
+    return member != nullptr && !member->hasQualifier();
+}
+
+/// \brief Visitor of the classes declared out of the function bodies.
+class HierarchyVisitor : public clang::RecursiveASTVisitor< HierarchyVisitor > {
+  private:
+    CGBuilder& m_builder;
+
+  public:
+    explicit HierarchyVisitor(CGBuilder& builder) : m_builder(builder) {}
+
+    [[nodiscard]] bool shouldVisitTemplateInstantiations() const { // NOLINT
+        return true;
+    }
+    [[nodiscard]] bool shouldWalkTypesOfTypeLocs() const { // NOLINT
+        return false;
+    }
+
+    bool TraverseStmt(clang::Stmt* stmt, // NOLINT
+                      DataRecursionQueue* queue = nullptr) {
+        (void)stmt;
+        (void)queue;
+        return true;
+    }
+
+    bool VisitCXXRecordDecl(const clang::CXXRecordDecl* record) { // NOLINT
+        m_builder.add_class(record);
+        return true;
+    }
 
-bool visit_call(const Decl* decl,
-                const SourceLocation& loc,
-                const std::string& cur_function_name,
-                bool skip_system_header,
-                Database& db) {
+    bool VisitVarDecl(const clang::VarDecl* var) { // NOLINT
+        m_builder.add_global(var);
+        return true;
+    }
+}; // class HierarchyVisitor
+
+} // anonymous namespace
+
+bool CGBuilder::visit_call(const clang::Decl* decl,
+                           const clang::SourceLocation& loc,
+                           bool is_virtual) {
     auto& sm = decl->getASTContext().getSourceManager();
     const auto* named_decl = llvm::dyn_cast_or_null< clang::NamedDecl >(decl);
     if (named_decl == nullptr) {
         return true;
     }
 
-    if (skip_system_header && sm.isInSystemHeader(loc)) {
+    if (m_ctx.skip_system_header && sm.isInSystemHeader(loc)) {
         return true;
     }
 
@@ -54,34 +106,156 @@ bool visit_call(const Decl* decl,
 
     auto line = presumed_loc.getLine();
     auto col = presumed_loc.getColumn();
-    auto file = knight::fs::make_absolute(presumed_loc.getFilename());
-
-    auto callee_name = knight::clang_util::get_mangled_name(named_decl);
-    CallSite cs(line, col, cur_function_name, callee_name);
-    db.insert_callsite(cs);
+    auto& cs = m_records.callsites.emplace_back(line,
+                                                col,
+                                                m_current_function_name,
+                                                get_mangled_name(named_decl),
+                                                m_current_file,
+                                                is_virtual);
 
     knight_log_nl(llvm::outs() << "find callsite: " << cs.to_string());
 
     return true;
 }
 
-} // anonymous namespace
+llvm::StringRef CGBuilder::get_mangled_name(
+    const clang::NamedDecl* named_decl) {
+    auto [it, inserted] = m_mangled_names.try_emplace(named_decl);
+    if (!inserted) {
+        return it->second;
+    }
+    if (m_mangler == nullptr) {
+        m_mangler.reset(named_decl->getASTContext().createMangleContext());
+    }
+    it->second = m_records.strings.intern(
+        knight::clang_util::get_mangled_name(named_decl, *m_mangler));
+    return it->second;
+}
+
+llvm::StringRef CGBuilder::get_absolute_path(llvm::StringRef file) {
+    auto [it, inserted] = m_absolute_paths.try_emplace(file);
+    if (inserted) {
+        it->second = m_records.strings.intern(knight::fs::make_absolute(file));
+    }
+    return it->second;
+}
+
+llvm::StringRef CGBuilder::get_class_name(
+    const clang::CXXRecordDecl* record) {
+    record = record->getCanonicalDecl();
+    auto [it, inserted] = m_class_names.try_emplace(record);
+    if (!inserted) {
+        return it->second;
+    }
+    auto& ast_ctx = record->getASTContext();
+    if (m_mangler == nullptr) {
+        m_mangler.reset(ast_ctx.createMangleContext());
+    }
+    llvm::SmallString< CSToStringMaxSize > name;
+    llvm::raw_svector_ostream os(name);
+    m_mangler->mangleCXXRTTIName(ast_ctx.getRecordType(record), os);
+    it->second = m_records.strings.intern(name.str());
+    return it->second;
+}
 
 bool CGBuilder::VisitCallExpr(const clang::CallExpr* call) {
     return visit_call(call->getCalleeDecl(),
                       call->getExprLoc(),
-                      m_current_function_name,
-                      m_ctx.skip_system_header,
-                      m_db);
+                      is_virtual_call(call));
 }
 
 bool CGBuilder::VisitCXXConstructExpr(
     const clang::CXXConstructExpr* ctor_call) {
-    return visit_call(ctor_call->getConstructor(),
-                      ctor_call->getExprLoc(),
-                      m_current_function_name,
-                      m_ctx.skip_system_header,
-                      m_db);
+    const auto* ctor = ctor_call->getConstructor();
+    if (ctor != nullptr && ctor->getParent()->isPolymorphic() &&
+        !m_current_file.empty()) {
+        m_records.class_instances.push_back(
+            ClassInstance{get_class_name(ctor->getParent()).str(),
+                          m_current_file.str()});
+    }
+    return visit_call(ctor, ctor_call->getExprLoc());
+}
+
+void CGBuilder::collect_hierarchy(clang::TranslationUnitDecl* tu) {
+    HierarchyVisitor(*this).TraverseDecl(tu);
+}
+
+void CGBuilder::add_class(const clang::CXXRecordDecl* record) {
+    if (!record->isThisDeclarationADefinition() ||
+        record->isDependentContext()) {
+        return;
+    }
+    auto& sm = record->getASTContext().getSourceManager();
+    if (m_ctx.skip_system_header &&
+        sm.isInSystemHeader(record->getLocation())) {
+        return;
+    }
+    auto loc = sm.getExpansionLoc(record->getLocation());
+    auto presumed_loc = sm.getPresumedLoc(loc);
+    if (presumed_loc.isInvalid()) {
+        return;
+    }
+    auto file = get_absolute_path(presumed_loc.getFilename());
+    if (!sm.isInMainFile(loc) && m_ctx.extracted_defs != nullptr &&
+        !m_ctx.extracted_defs->try_mark(
+            "class " + file.str() + ":" +
+            std::to_string(presumed_loc.getLine()) + ":" +
+            std::to_string(presumed_loc.getColumn()))) {
+        return;
+    }
+
+    auto name = get_class_name(record);
+    for (const auto& base : record->bases()) {
+        const auto* base_record = base.getType()->getAsCXXRecordDecl();
+        if (base_record == nullptr) {
+            continue;
+        }
+        m_records.class_bases.push_back(
+            ClassBase{name.str(),
+                      get_class_name(base_record).str(),
+                      file.str(),
+                      base.isVirtual()});
+    }
+    for (const auto* method : record->methods()) {
+        if (!method->isVirtual()) {
+            continue;
+        }
+        auto method_name = get_mangled_name(method).str();
+        m_records.virtual_methods.push_back(
+            VirtualMethod{method_name, name.str(), file.str()});
+        for (const auto* overridden : method->overridden_methods()) {
+            m_records.method_overrides.push_back(
+                MethodOverride{method_name,
+                               get_mangled_name(overridden).str(),
+                               file.str()});
+        }
+    }
+}
+
+void CGBuilder::add_global(const clang::VarDecl* var) {
+    if (!m_ctx.points_to || !var->hasGlobalStorage() ||
+        var->isStaticLocal() || var->getInit() == nullptr ||
+        var->getDeclContext()->isDependentContext()) {
+        return;
+    }
+    auto& sm = var->getASTContext().getSourceManager();
+    if (m_ctx.skip_system_header && sm.isInSystemHeader(var->getLocation())) {
+        return;
+    }
+    auto loc = sm.getExpansionLoc(var->getLocation());
+    auto presumed_loc = sm.getPresumedLoc(loc);
+    if (presumed_loc.isInvalid()) {
+        return;
+    }
+    auto file = get_absolute_path(presumed_loc.getFilename());
+    if (!sm.isInMainFile(loc) && m_ctx.extracted_defs != nullptr &&
+        !m_ctx.extracted_defs->try_mark(
+            "global " + file.str() + ":" +
+            std::to_string(presumed_loc.getLine()) + ":" +
+            std::to_string(presumed_loc.getColumn()))) {
+        return;
+    }
+    m_points_to.add_global(var, get_mangled_name(var), file);
 }
 
 bool CGBuilder::VisitFunctionDecl(const clang::FunctionDecl* function) {
@@ -95,7 +269,7 @@ bool CGBuilder::VisitFunctionDecl(const clang::FunctionDecl* function) {
         return true;
     }
 
-    auto mangled_name = knight::clang_util::get_mangled_name(function);
+    auto mangled_name = get_mangled_name(function);
     m_current_function_name = mangled_name;
     auto name = function->getQualifiedNameAsString() + " " +
                 function->getType().getAsString();
@@ -107,19 +281,80 @@ bool CGBuilder::VisitFunctionDecl(const clang::FunctionDecl* function) {
 
     auto line = presumed_loc.getLine();
     auto col = presumed_loc.getColumn();
-    auto file = knight::fs::make_absolute(presumed_loc.getFilename());
+    auto file = get_absolute_path(presumed_loc.getFilename());
+    m_current_file = file;
+    auto end_loc = sm.getPresumedLoc(sm.getExpansionLoc(function->getEndLoc()));
+    auto end_line = end_loc.isValid() ? end_loc.getLine() : 0U;
 
-    CallGraphNode node(line, col, name, mangled_name, file);
-    m_db.insert_cg_node(node);
+    auto& node = m_records.cg_nodes.emplace_back(line,
+                                                 col,
+                                                 m_records.strings.intern(name),
+                                                 mangled_name,
+                                                 file,
+                                                 end_line);
 
     knight_log_nl(llvm::outs() << "find cg node: " << node.to_string());
 
+    if (m_ctx.points_to) {
+        m_points_to.add_function(function, mangled_name, file);
+    }
+
     return true;
 }
 
+void CGBuilder::collect_files(const clang::SourceManager& sm) {
+    llvm::StringSet<> hashed_files;
+    for (unsigned idx = 0U; idx < sm.local_sloc_entry_size(); ++idx) {
+        const auto& entry = sm.getLocalSLocEntry(idx);
+        if (!entry.isFile()) {
+            continue;
+        }
+        const auto& file_info = entry.getFile();
+        if (m_ctx.skip_system_header &&
+            clang::SrcMgr::isSystem(file_info.getFileCharacteristic())) {
+            continue;
+        }
+        auto file_loc =
+            clang::SourceLocation::getFromRawEncoding(entry.getOffset());
+        auto file = sm.getFilename(file_loc);
+        // The predefines have no file.
+        if (file.empty()) {
+            continue;
+        }
+        auto path = get_absolute_path(file);
+        if (hashed_files.insert(path).second) {
+            bool is_invalid = false;
+            auto content =
+                sm.getBufferData(sm.getFileID(file_loc), &is_invalid);
+            if (!is_invalid) {
+                m_records.files.push_back(
+                    FileHash{path.str(), get_content_hash(content)});
+            }
+        }
+
+        // The main file is not included.
+        auto include_loc = file_info.getIncludeLoc();
+        auto includer = include_loc.isValid() ? sm.getFilename(include_loc)
+                                              : llvm::StringRef();
+        if (includer.empty()) {
+            continue;
+        }
+        auto& include =
+            m_records.includes.emplace_back(get_absolute_path(includer).str(),
+                                            path.str());
+
+        knight_log_nl(llvm::outs() << "find include: ";
+                      include.dump(llvm::outs()));
+    }
+}
+
 CGBuilder::CGBuilder(knight::CGContext& ctx)
     : m_ctx(ctx),
-      m_db(ctx.knight_dir, static_cast< int >(ctx.db_busy_timeout)) {}
+      m_points_to(
+          [this](const clang::NamedDecl* named_decl) {
+              return get_mangled_name(named_decl);
+          },
+          m_records.points_to_constraints) {}
 
 bool CGBuilder::shouldVisitImplicitCode() const { // NOLINT
     return m_ctx.skip_implicit_code;
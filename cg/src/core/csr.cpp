@@ -0,0 +1,349 @@
+//===- csr.cpp --------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the compact binary call graph.
+//
+//===------------------------------------------------------------------===//
+
+#include "cg/core/csr.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace knight::cg {
+
+namespace {
+
+constexpr uint64_t MaxStringPoolSize = std::numeric_limits< uint32_t >::max();
+
+/// \brief The string pool of the nodes, where each string is stored once.
+class StringPool {
+  private:
+    llvm::StringMap< uint32_t > m_offsets;
+    std::string m_pool;
+    bool m_is_overflow = false;
+
+  public:
+    [[nodiscard]] csr::String intern(llvm::StringRef str) {
+        auto [it, inserted] =
+            m_offsets.try_emplace(str, static_cast< uint32_t >(m_pool.size()));
+        if (inserted) {
+            if (m_pool.size() + str.size() > MaxStringPoolSize) {
+                m_is_overflow = true;
+                return {0U, 0U};
+            }
+            m_pool.append(str.data(), str.size());
+        }
+        return {it->second, static_cast< uint32_t >(str.size())};
+    }
+
+    [[nodiscard]] bool is_overflow() const { return m_is_overflow; }
+    [[nodiscard]] const std::string& get_pool() const { return m_pool; }
+}; // class StringPool
+
+/// \brief Fill the rows of `edges` grouped by the `row` of each of them,
+/// keeping their relative order within a row.
+template < typename RowOf, typename EdgeOf >
+void fill_rows(std::size_t num_rows,
+               llvm::ArrayRef< std::size_t > order,
+               RowOf row_of,
+               EdgeOf edge_of,
+               std::vector< uint64_t >& offsets,
+               std::vector< csr::Edge >& edges) {
+    offsets.assign(num_rows + 1U, 0U);
+    for (auto idx : order) {
+        ++offsets[row_of(idx) + 1U];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    edges.resize(order.size());
+    std::vector< uint64_t > next(offsets.begin(), offsets.end() - 1);
+    for (auto idx : order) {
+        edges[next[row_of(idx)]++] = edge_of(idx);
+    }
+}
+
+template < typename T >
+void write_section(llvm::raw_fd_ostream& os,
+                   uint64_t offset,
+                   const T* data,
+                   std::size_t count) {
+    os.write_zeros(offset - os.tell());
+    os.write(reinterpret_cast< const char* >(data), sizeof(T) * count);
+}
+
+} // anonymous namespace
+
+bool write_csr_graph(llvm::ArrayRef< CallGraphNode > cg_nodes,
+                     llvm::ArrayRef< CallSite > callsites,
+                     llvm::StringRef path) {
+    struct Symbol {
+        const CallGraphNode* definition = nullptr;
+        uint32_t id = 0U;
+    }; // struct Symbol
+
+    llvm::StringMap< Symbol > symbols;
+    for (const auto& cg_node : cg_nodes) {
+        symbols.try_emplace(cg_node.mangled_name, Symbol{&cg_node});
+    }
+    for (const auto& callsite : callsites) {
+        symbols.try_emplace(callsite.caller);
+        symbols.try_emplace(callsite.callee);
+    }
+    if (symbols.size() > std::numeric_limits< uint32_t >::max()) {
+        return false;
+    }
+
+    std::vector< llvm::StringMapEntry< Symbol >* > sorted;
+    sorted.reserve(symbols.size());
+    for (auto& entry : symbols) {
+        sorted.push_back(&entry);
+    }
+    llvm::sort(sorted, [](const auto* lhs, const auto* rhs) {
+        return lhs->getKey() < rhs->getKey();
+    });
+
+    StringPool strings;
+    std::vector< csr::Node > nodes;
+    nodes.reserve(sorted.size());
+    for (auto* entry : sorted) {
+        entry->second.id = static_cast< uint32_t >(nodes.size());
+        csr::Node node{};
+        node.mangled_name = strings.intern(entry->getKey());
+        if (const auto* definition = entry->second.definition) {
+            node.name = strings.intern(definition->name);
+            node.file = strings.intern(definition->file);
+            node.line = definition->line;
+            node.col = definition->col;
+        }
+        nodes.push_back(node);
+    }
+    if (strings.is_overflow()) {
+        return false;
+    }
+
+    std::vector< uint32_t > callers(callsites.size());
+    std::vector< uint32_t > callees(callsites.size());
+    for (std::size_t idx = 0U; idx < callsites.size(); ++idx) {
+        callers[idx] = symbols.find(callsites[idx].caller)->second.id;
+        callees[idx] = symbols.find(callsites[idx].callee)->second.id;
+    }
+
+    // Order the call sites by their callers then locations, so that both
+    // the callee and the caller rows are sorted.
+    std::vector< std::size_t > order(callsites.size());
+    std::iota(order.begin(), order.end(), 0U);
+    llvm::sort(order, [&](std::size_t lhs, std::size_t rhs) {
+        const auto& l = callsites[lhs];
+        const auto& r = callsites[rhs];
+        return std::tie(callers[lhs], l.line, l.col, callees[lhs]) <
+               std::tie(callers[rhs], r.line, r.col, callees[rhs]);
+    });
+
+    std::vector< uint64_t > callee_offsets;
+    std::vector< csr::Edge > callee_edges;
+    fill_rows(
+        nodes.size(),
+        order,
+        [&](std::size_t idx) { return callers[idx]; },
+        [&](std::size_t idx) {
+            return csr::Edge{callees[idx],
+                             callsites[idx].line,
+                             callsites[idx].col};
+        },
+        callee_offsets,
+        callee_edges);
+
+    std::vector< uint64_t > caller_offsets;
+    std::vector< csr::Edge > caller_edges;
+    fill_rows(
+        nodes.size(),
+        order,
+        [&](std::size_t idx) { return callees[idx]; },
+        [&](std::size_t idx) {
+            return csr::Edge{callers[idx],
+                             callsites[idx].line,
+                             callsites[idx].col};
+        },
+        caller_offsets,
+        caller_edges);
+
+    const auto& pool = strings.get_pool();
+    csr::Header header{};
+    header.magic = csr::Magic;
+    header.version = csr::Version;
+    header.num_nodes = static_cast< uint32_t >(nodes.size());
+    header.num_edges = callsites.size();
+    uint64_t offset = sizeof(csr::Header);
+    auto place = [&offset](uint64_t size) {
+        offset = llvm::alignTo(offset, csr::CSRAlignment);
+        auto section = offset;
+        offset += size;
+        return section;
+    };
+    header.nodes_offset = place(sizeof(csr::Node) * nodes.size());
+    header.callee_offsets_offset =
+        place(sizeof(uint64_t) * callee_offsets.size());
+    header.callee_edges_offset = place(sizeof(csr::Edge) * callee_edges.size());
+    header.caller_offsets_offset =
+        place(sizeof(uint64_t) * caller_offsets.size());
+    header.caller_edges_offset = place(sizeof(csr::Edge) * caller_edges.size());
+    header.strings_offset = place(pool.size());
+    header.strings_size = pool.size();
+
+    auto tmp_path = path.str() + ".tmp";
+    {
+        std::error_code err;
+        llvm::raw_fd_ostream os(tmp_path, err, llvm::sys::fs::OF_None);
+        if (err) {
+            return false;
+        }
+        write_section(os, 0U, &header, 1U);
+        write_section(os, header.nodes_offset, nodes.data(), nodes.size());
+        write_section(os,
+                      header.callee_offsets_offset,
+                      callee_offsets.data(),
+                      callee_offsets.size());
+        write_section(os,
+                      header.callee_edges_offset,
+                      callee_edges.data(),
+                      callee_edges.size());
+        write_section(os,
+                      header.caller_offsets_offset,
+                      caller_offsets.data(),
+                      caller_offsets.size());
+        write_section(os,
+                      header.caller_edges_offset,
+                      caller_edges.data(),
+                      caller_edges.size());
+        write_section(os, header.strings_offset, pool.data(), pool.size());
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            (void)llvm::sys::fs::remove(tmp_path);
+            return false;
+        }
+    }
+    return !llvm::sys::fs::rename(tmp_path, path);
+}
+
+std::unique_ptr< CSRGraph > CSRGraph::open(llvm::StringRef path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path,
+                                              /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/
+                                              false);
+    if (!buffer) {
+        return nullptr;
+    }
+    std::unique_ptr< CSRGraph > graph(new CSRGraph(std::move(*buffer)));
+    if (!graph->map()) {
+        return nullptr;
+    }
+    return graph;
+}
+
+bool CSRGraph::map() {
+    const char* start = m_buffer->getBufferStart();
+    uint64_t size = m_buffer->getBufferSize();
+    if (size < sizeof(csr::Header) ||
+        reinterpret_cast< uintptr_t >(start) % csr::CSRAlignment != 0U) {
+        return false;
+    }
+    m_header = reinterpret_cast< const csr::Header* >(start);
+    if (m_header->magic != csr::Magic || m_header->version != csr::Version) {
+        return false;
+    }
+
+    auto is_in_file = [size](uint64_t offset, uint64_t count, uint64_t elem) {
+        return offset % csr::CSRAlignment == 0U && offset <= size &&
+               count <= (size - offset) / elem;
+    };
+    uint64_t num_nodes = m_header->num_nodes;
+    uint64_t num_edges = m_header->num_edges;
+    if (!is_in_file(m_header->nodes_offset, num_nodes, sizeof(csr::Node)) ||
+        !is_in_file(m_header->callee_offsets_offset,
+                    num_nodes + 1U,
+                    sizeof(uint64_t)) ||
+        !is_in_file(m_header->callee_edges_offset,
+                    num_edges,
+                    sizeof(csr::Edge)) ||
+        !is_in_file(m_header->caller_offsets_offset,
+                    num_nodes + 1U,
+                    sizeof(uint64_t)) ||
+        !is_in_file(m_header->caller_edges_offset,
+                    num_edges,
+                    sizeof(csr::Edge)) ||
+        !is_in_file(m_header->strings_offset, m_header->strings_size, 1U)) {
+        return false;
+    }
+    m_nodes = reinterpret_cast< const csr::Node* >(start +
+                                                   m_header->nodes_offset);
+    m_callee_offsets = reinterpret_cast< const uint64_t* >(
+        start + m_header->callee_offsets_offset);
+    m_callee_edges = reinterpret_cast< const Edge* >(
+        start + m_header->callee_edges_offset);
+    m_caller_offsets = reinterpret_cast< const uint64_t* >(
+        start + m_header->caller_offsets_offset);
+    m_caller_edges = reinterpret_cast< const Edge* >(
+        start + m_header->caller_edges_offset);
+    m_strings = start + m_header->strings_offset;
+
+    // The edges are only read through the rows, which are checked here
+    // along with the edge targets and the strings, so that the accessors
+    // need no checks.
+    auto is_valid_rows = [num_nodes, num_edges](const uint64_t* offsets) {
+        return offsets[0] == 0U && offsets[num_nodes] == num_edges &&
+               std::is_sorted(offsets, offsets + num_nodes + 1U);
+    };
+    auto is_valid_edges = [num_nodes, num_edges](const Edge* edges) {
+        return std::all_of(edges, edges + num_edges, [&](const Edge& edge) {
+            return edge.node < num_nodes;
+        });
+    };
+    auto is_in_pool = [this](csr::String str) {
+        return str.offset <= m_header->strings_size &&
+               str.size <= m_header->strings_size - str.offset;
+    };
+    return is_valid_rows(m_callee_offsets) && is_valid_rows(m_caller_offsets) &&
+           is_valid_edges(m_callee_edges) && is_valid_edges(m_caller_edges) &&
+           std::all_of(m_nodes, m_nodes + num_nodes, [&](const auto& node) {
+               return is_in_pool(node.name) && is_in_pool(node.mangled_name) &&
+                      is_in_pool(node.file);
+           });
+}
+
+std::optional< CSRGraph::NodeID > CSRGraph::find(
+    llvm::StringRef mangled_name) const {
+    NodeID low = 0U;
+    NodeID high = get_num_nodes();
+    while (low < high) {
+        NodeID mid = low + (high - low) / 2U;
+        if (get_mangled_name(mid) < mangled_name) {
+            low = mid + 1U;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < get_num_nodes() && get_mangled_name(low) == mangled_name) {
+        return low;
+    }
+    return std::nullopt;
+}
+
+} // namespace knight::cg
@@ -0,0 +1,236 @@
+//===- impact.cpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the impact of a change on the translation units
+//  and the functions of the call graph.
+//
+//===------------------------------------------------------------------===//
+
+#include "cg/core/impact.hpp"
+#include "common/util/vfs.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <algorithm>
+#include <optional>
+
+namespace knight::cg {
+
+namespace {
+
+constexpr llvm::StringLiteral DevNull = "/dev/null";
+
+/// \brief Parse the `first` or `first-last` lines.
+std::optional< LineRange > parse_line_range(llvm::StringRef text) {
+    auto [first_text, last_text] = text.split('-');
+    unsigned first = 0U;
+    unsigned last = 0U;
+    if (first_text.getAsInteger(10, first)) {
+        return std::nullopt;
+    }
+    if (last_text.empty()) {
+        last = first;
+    } else if (last_text.getAsInteger(10, last) || last < first) {
+        return std::nullopt;
+    }
+    return LineRange{first, last};
+}
+
+/// \brief Get the path of a `---` or `+++` line of a diff.
+llvm::StringRef get_diff_path(llvm::StringRef line) {
+    auto path = line.drop_front(4).split('\t').first.rtrim();
+    if (path != DevNull &&
+        (path.startswith("a/") || path.startswith("b/"))) {
+        path = path.drop_front(2);
+    }
+    return path;
+}
+
+/// \brief Get the new lines of a `@@ -a,b +c,d @@` hunk header.
+std::optional< LineRange > parse_hunk_header(llvm::StringRef line) {
+    auto pos = line.find(" +");
+    if (pos == llvm::StringRef::npos) {
+        return std::nullopt;
+    }
+    auto [first_text, count_text] =
+        line.drop_front(pos + 2).split(' ').first.split(',');
+    unsigned first = 0U;
+    unsigned count = 1U;
+    if (first_text.getAsInteger(10, first) ||
+        (!count_text.empty() && count_text.getAsInteger(10, count))) {
+        return std::nullopt;
+    }
+    // The lines are removed after the `first` one.
+    if (count == 0U) {
+        return LineRange{std::max(first, 1U), first + 1U};
+    }
+    return LineRange{first, first + count - 1U};
+}
+
+using Lines = llvm::ArrayRef< llvm::StringRef >;
+
+ChangedLines parse_diff(Lines lines) {
+    ChangedLines changes;
+    std::string old_path;
+    std::vector< LineRange >* current = nullptr;
+    for (auto line : lines) {
+        line = line.rtrim('\r');
+        if (line.startswith("--- ")) {
+            old_path = get_diff_path(line).str();
+            current = nullptr;
+        } else if (line.startswith("+++ ")) {
+            auto path = get_diff_path(line);
+            if (path == DevNull) {
+                // A deleted file is changed as a whole.
+                changes[fs::make_absolute(old_path)].clear();
+                current = nullptr;
+                continue;
+            }
+            current = &changes[fs::make_absolute(path)];
+        } else if (line.startswith("@@ ") && current != nullptr) {
+            if (auto range = parse_hunk_header(line)) {
+                current->push_back(*range);
+            }
+        }
+    }
+    return changes;
+}
+
+ChangedLines parse_file_list(Lines lines) {
+    ChangedLines changes;
+    for (auto line : lines) {
+        line = line.trim();
+        if (line.empty()) {
+            continue;
+        }
+        auto [path, lines_text] = line.rsplit(':');
+        auto range = parse_line_range(lines_text);
+        if (!range) {
+            changes[fs::make_absolute(line)].clear();
+            continue;
+        }
+        auto& ranges = changes[fs::make_absolute(path)];
+        ranges.push_back(*range);
+    }
+    return changes;
+}
+
+/// \brief Check if the lines of the range are all in the given
+/// definitions.
+bool is_covered(const LineRange& range,
+                std::vector< const CallGraphNode* > nodes) {
+    llvm::sort(nodes, [](const auto* lhs, const auto* rhs) {
+        return lhs->line < rhs->line;
+    });
+    unsigned next = range.first;
+    for (const auto* node : nodes) {
+        if (node->line > next) {
+            return false;
+        }
+        next = std::max(next, std::max(node->line, node->end_line) + 1U);
+        if (next > range.last) {
+            return true;
+        }
+    }
+    return next > range.last;
+}
+
+/// \brief Add the files including the given ones, transitively.
+void add_includers(const Database& db, llvm::StringSet<>& files) {
+    std::vector< std::string > worklist;
+    for (const auto& file : files) {
+        worklist.push_back(file.getKey().str());
+    }
+    while (!worklist.empty()) {
+        auto file = std::move(worklist.back());
+        worklist.pop_back();
+        for (auto& includer : db.get_includers(file)) {
+            if (files.insert(includer).second) {
+                worklist.push_back(std::move(includer));
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+ChangedLines parse_changed_lines(llvm::StringRef text) {
+    llvm::SmallVector< llvm::StringRef, 0 > lines;
+    text.split(lines, '\n');
+    const bool is_diff = llvm::any_of(lines, [](llvm::StringRef line) {
+        return line.startswith("+++ ") || line.startswith("diff --git ");
+    });
+    return is_diff ? parse_diff(lines) : parse_file_list(lines);
+}
+
+ChangeImpact ChangeImpact::compute(const Database& db,
+                                   const ChangedLines& changes,
+                                   llvm::ArrayRef< std::string > units) {
+    ChangeImpact impact;
+    std::vector< std::string > worklist;
+    const auto add_function = [&](llvm::StringRef mangled_name) {
+        if (impact.m_functions.insert(mangled_name).second) {
+            worklist.push_back(mangled_name.str());
+        }
+    };
+
+    llvm::StringSet<> impacted_files;
+    llvm::StringSet<> full_files;
+    for (const auto& [file, ranges] : changes) {
+        impacted_files.insert(file);
+        const auto nodes = db.get_nodes_in_file(file);
+        bool is_full = ranges.empty();
+        for (const auto& range : ranges) {
+            std::vector< const CallGraphNode* > changed_nodes;
+            for (const auto& node : nodes) {
+                // A definition of unknown extent only covers its first line.
+                if (node.line <= range.last &&
+                    range.first <= std::max(node.line, node.end_line)) {
+                    changed_nodes.push_back(&node);
+                    add_function(node.mangled_name);
+                }
+            }
+            is_full = is_full || !is_covered(range, std::move(changed_nodes));
+        }
+        if (is_full) {
+            full_files.insert(file);
+            for (const auto& node : nodes) {
+                add_function(node.mangled_name);
+            }
+        }
+    }
+
+    while (!worklist.empty()) {
+        auto mangled_name = std::move(worklist.back());
+        worklist.pop_back();
+        for (const auto& callsite : db.get_callers(mangled_name)) {
+            add_function(callsite.caller);
+        }
+    }
+    for (const auto& function : impact.m_functions) {
+        if (auto node = db.get_node(function.getKey().str())) {
+            impacted_files.insert(node->file);
+        }
+    }
+
+    add_includers(db, impacted_files);
+    add_includers(db, full_files);
+    for (const auto& unit : units) {
+        if (impacted_files.count(unit) != 0U) {
+            impact.m_units.insert(unit);
+        }
+        if (full_files.count(unit) != 0U) {
+            impact.m_full_units.insert(unit);
+        }
+    }
+    return impact;
+}
+
+} // namespace knight::cg
@@ -0,0 +1,521 @@
+//===- points_to.cpp --------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the extraction of the points-to constraints of
+//  the functions of a translation unit.
+//
+//===------------------------------------------------------------------===//
+
+#include "cg/core/points_to.hpp"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/Stmt.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringSwitch.h>
+
+namespace knight::cg {
+
+namespace {
+
+using namespace clang;
+
+/// \brief Check if the values of the type may hold a pointer.
+bool is_tracked(QualType type) {
+    return type->isAnyPointerType() || type->isArrayType() ||
+           type->isReferenceType() || type->isRecordType() ||
+           type->isMemberPointerType() || type->isBlockPointerType();
+}
+
+/// \brief Check if the call returns a fresh allocation.
+bool is_allocation(const FunctionDecl* callee) {
+    if (!callee->getDeclName().isIdentifier()) {
+        return false;
+    }
+    return llvm::StringSwitch< bool >(callee->getName())
+        .Cases("malloc", "calloc", "realloc", "aligned_alloc", true)
+        .Cases("strdup", "strndup", "valloc", "memalign", true)
+        .Default(false);
+}
+
+/// \brief Get the node of the allocation at the location.
+std::string get_allocation(llvm::StringRef owner,
+                           const SourceManager& sm,
+                           SourceLocation loc) {
+    auto presumed_loc = sm.getPresumedLoc(loc);
+    if (presumed_loc.isInvalid()) {
+        return get_allocation_node(owner, 0U, 0U);
+    }
+    return get_allocation_node(owner,
+                               presumed_loc.getLine(),
+                               presumed_loc.getColumn());
+}
+
+} // anonymous namespace
+
+void PointsToExtractor::add_function(const clang::FunctionDecl* function,
+                                     llvm::StringRef mangled_name,
+                                     llvm::StringRef file) {
+    if (function->isDependentContext() || !function->hasBody()) {
+        return;
+    }
+    m_owner = mangled_name.str();
+    m_file = file.str();
+    m_returns_reference = function->getReturnType()->isReferenceType();
+    m_num_temps = 0U;
+
+    llvm::SmallVector< const Stmt*, 32U > worklist{function->getBody()};
+    if (const auto* ctor = llvm::dyn_cast< CXXConstructorDecl >(function)) {
+        for (const auto* init : ctor->inits()) {
+            worklist.push_back(init->getInit());
+        }
+    }
+    while (!worklist.empty()) {
+        const auto* stmt = worklist.pop_back_val();
+        if (stmt == nullptr) {
+            continue;
+        }
+        add_stmt(stmt);
+        for (const auto* child : stmt->children()) {
+            worklist.push_back(child);
+        }
+    }
+}
+
+void PointsToExtractor::add_global(const clang::VarDecl* var,
+                                   llvm::StringRef mangled_name,
+                                   llvm::StringRef file) {
+    if (var->getInit() == nullptr || !is_tracked(var->getType())) {
+        return;
+    }
+    m_owner = mangled_name.str();
+    m_file = file.str();
+    m_num_temps = 0U;
+    add_var(var);
+}
+
+void PointsToExtractor::add(PointsToKind kind,
+                            std::string dst,
+                            std::string src) {
+    if (kind == PointsToKind::Copy && dst == src) {
+        return;
+    }
+    m_constraints.push_back(
+        PointsToConstraint{kind, std::move(dst), std::move(src), m_file});
+}
+
+void PointsToExtractor::add_stmt(const clang::Stmt* stmt) {
+    if (const auto* binary = llvm::dyn_cast< BinaryOperator >(stmt)) {
+        if (binary->getOpcode() == BO_Assign) {
+            add_assign(binary->getLHS(), binary->getRHS());
+        }
+    } else if (const auto* decl_stmt = llvm::dyn_cast< DeclStmt >(stmt)) {
+        for (const auto* decl : decl_stmt->decls()) {
+            if (const auto* var = llvm::dyn_cast< VarDecl >(decl)) {
+                add_var(var);
+            }
+        }
+    } else if (const auto* call = llvm::dyn_cast< CallExpr >(stmt)) {
+        add_call(call);
+    } else if (const auto* construct =
+                   llvm::dyn_cast< CXXConstructExpr >(stmt)) {
+        add_construct(construct);
+    } else if (const auto* ret = llvm::dyn_cast< ReturnStmt >(stmt)) {
+        const auto* value = ret->getRetValue();
+        if (value == nullptr) {
+            return;
+        }
+        if (m_returns_reference) {
+            if (auto location = get_location(value)) {
+                add(PointsToKind::Copy,
+                    get_return_node(m_owner),
+                    get_address(std::move(*location)));
+            }
+        } else if (is_tracked(value->getType())) {
+            if (auto node = get_value(value)) {
+                add(PointsToKind::Copy, get_return_node(m_owner), *node);
+            }
+        }
+    }
+}
+
+void PointsToExtractor::add_assign(const clang::Expr* lhs,
+                                   const clang::Expr* rhs) {
+    if (!is_tracked(lhs->getType())) {
+        return;
+    }
+    auto value = get_value(rhs);
+    if (!value) {
+        return;
+    }
+    auto location = get_location(lhs);
+    if (!location) {
+        return;
+    }
+    add(location->is_indirect ? PointsToKind::Store : PointsToKind::Copy,
+        std::move(location->node),
+        std::move(*value));
+}
+
+void PointsToExtractor::add_var(const clang::VarDecl* var) {
+    const auto* init = var->getInit();
+    if (init == nullptr || !is_tracked(var->getType())) {
+        return;
+    }
+    if (var->getType()->isReferenceType()) {
+        if (auto location = get_location(init)) {
+            add(PointsToKind::Copy,
+                get_var_node(var),
+                get_address(std::move(*location)));
+        }
+        return;
+    }
+    if (auto value = get_value(init)) {
+        add(PointsToKind::Copy, get_var_node(var), std::move(*value));
+    }
+}
+
+void PointsToExtractor::add_argument(const clang::ParmVarDecl* param,
+                                     std::string param_node,
+                                     const clang::Expr* arg) {
+    if (param->getType()->isReferenceType()) {
+        if (auto location = get_location(arg)) {
+            add(PointsToKind::Copy,
+                std::move(param_node),
+                get_address(std::move(*location)));
+        }
+    } else if (is_tracked(param->getType())) {
+        if (auto value = get_value(arg)) {
+            add(PointsToKind::Copy, std::move(param_node), std::move(*value));
+        }
+    }
+}
+
+void PointsToExtractor::add_call(const clang::CallExpr* call) {
+    const auto* callee = call->getDirectCallee();
+    if (callee == nullptr || is_allocation(callee)) {
+        return;
+    }
+    auto callee_name = m_get_name(callee);
+    unsigned first_arg = 0U;
+    if (const auto* member_call = llvm::dyn_cast< CXXMemberCallExpr >(call)) {
+        if (const auto* object = member_call->getImplicitObjectArgument()) {
+            auto location = object->isGLValue() ? get_location(object)
+                                                : std::nullopt;
+            if (location) {
+                add(PointsToKind::Copy,
+                    get_this_node(callee_name),
+                    get_address(std::move(*location)));
+            } else if (auto value = get_value(object)) {
+                add(PointsToKind::Copy, get_this_node(callee_name), *value);
+            }
+        }
+    } else if (llvm::isa< CXXOperatorCallExpr >(call) &&
+               llvm::isa< CXXMethodDecl >(callee) && call->getNumArgs() > 0U) {
+        // The object of a member operator is its first argument.
+        if (auto location = get_location(call->getArg(0U))) {
+            add(PointsToKind::Copy,
+                get_this_node(callee_name),
+                get_address(std::move(*location)));
+        }
+        first_arg = 1U;
+    }
+    for (unsigned idx = first_arg; idx < call->getNumArgs(); ++idx) {
+        const auto param_idx = idx - first_arg;
+        if (param_idx >= callee->getNumParams()) {
+            break;
+        }
+        add_argument(callee->getParamDecl(param_idx),
+                     get_param_node(callee_name, param_idx),
+                     call->getArg(idx));
+    }
+}
+
+void PointsToExtractor::add_construct(
+    const clang::CXXConstructExpr* construct) {
+    const auto* ctor = construct->getConstructor();
+    if (ctor == nullptr) {
+        return;
+    }
+    auto ctor_name = m_get_name(ctor);
+    for (unsigned idx = 0U;
+         idx < construct->getNumArgs() && idx < ctor->getNumParams();
+         ++idx) {
+        add_argument(ctor->getParamDecl(idx),
+                     get_param_node(ctor_name, idx),
+                     construct->getArg(idx));
+    }
+}
+
+std::string PointsToExtractor::create_temp() {
+    return m_owner + "$" + std::to_string(m_num_temps++);
+}
+
+std::string PointsToExtractor::get_var_node(const clang::VarDecl* var) {
+    if (!var->hasLocalStorage() && !var->isStaticLocal()) {
+        return m_get_name(var).str();
+    }
+    if (const auto* param = llvm::dyn_cast< ParmVarDecl >(var)) {
+        return get_param_node(m_owner, param->getFunctionScopeIndex());
+    }
+    auto& sm = var->getASTContext().getSourceManager();
+    auto presumed_loc = sm.getPresumedLoc(var->getLocation());
+    if (presumed_loc.isInvalid()) {
+        return get_local_node(m_owner, var->getNameAsString(), 0U, 0U);
+    }
+    return get_local_node(m_owner,
+                          var->getNameAsString(),
+                          presumed_loc.getLine(),
+                          presumed_loc.getColumn());
+}
+
+std::string PointsToExtractor::get_address(Location location) {
+    if (location.is_indirect) {
+        return std::move(location.node);
+    }
+    auto temp = create_temp();
+    add(PointsToKind::AddressOf, temp, std::move(location.node));
+    return temp;
+}
+
+std::optional< std::string > PointsToExtractor::merge(
+    std::optional< std::string > lhs, std::optional< std::string > rhs) {
+    if (!lhs || !rhs) {
+        return lhs ? std::move(lhs) : std::move(rhs);
+    }
+    auto temp = create_temp();
+    add(PointsToKind::Copy, temp, std::move(*lhs));
+    add(PointsToKind::Copy, temp, std::move(*rhs));
+    return temp;
+}
+
+std::optional< PointsToExtractor::Location > PointsToExtractor::get_location(
+    const clang::Expr* expr) {
+    expr = expr->IgnoreParens();
+    if (const auto* ref = llvm::dyn_cast< DeclRefExpr >(expr)) {
+        if (const auto* var = llvm::dyn_cast< VarDecl >(ref->getDecl())) {
+            // A reference holds the address of its referee.
+            return Location{get_var_node(var),
+                            var->getType()->isReferenceType()};
+        }
+        if (const auto* function =
+                llvm::dyn_cast< FunctionDecl >(ref->getDecl())) {
+            return Location{m_get_name(function).str(), false};
+        }
+        return std::nullopt;
+    }
+    if (const auto* unary = llvm::dyn_cast< UnaryOperator >(expr)) {
+        if (unary->getOpcode() == UO_Deref) {
+            if (auto value = get_value(unary->getSubExpr())) {
+                return Location{std::move(*value), true};
+            }
+            return std::nullopt;
+        }
+        if (unary->isPrefix() && unary->isIncrementDecrementOp()) {
+            return get_location(unary->getSubExpr());
+        }
+        return std::nullopt;
+    }
+    if (const auto* member = llvm::dyn_cast< MemberExpr >(expr)) {
+        if (!member->isArrow()) {
+            return get_location(member->getBase());
+        }
+        if (auto value = get_value(member->getBase())) {
+            return Location{std::move(*value), true};
+        }
+        return std::nullopt;
+    }
+    if (const auto* subscript = llvm::dyn_cast< ArraySubscriptExpr >(expr)) {
+        if (auto value = get_value(subscript->getBase())) {
+            return Location{std::move(*value), true};
+        }
+        return std::nullopt;
+    }
+    if (const auto* binary = llvm::dyn_cast< BinaryOperator >(expr)) {
+        if (binary->isAssignmentOp()) {
+            return get_location(binary->getLHS());
+        }
+        if (binary->isCommaOp()) {
+            return get_location(binary->getRHS());
+        }
+        return std::nullopt;
+    }
+    if (const auto* cond =
+            llvm::dyn_cast< AbstractConditionalOperator >(expr)) {
+        auto get_branch_address =
+            [this](const Expr* branch) -> std::optional< std::string > {
+            if (auto location = get_location(branch)) {
+                return get_address(std::move(*location));
+            }
+            return std::nullopt;
+        };
+        auto address = merge(get_branch_address(cond->getTrueExpr()),
+                             get_branch_address(cond->getFalseExpr()));
+        if (address) {
+            return Location{std::move(*address), true};
+        }
+        return std::nullopt;
+    }
+    if (const auto* call = llvm::dyn_cast< CallExpr >(expr)) {
+        // The call returns a reference, i.e., the address of its referee.
+        if (auto value = get_call_value(call)) {
+            return Location{std::move(*value), true};
+        }
+        return std::nullopt;
+    }
+    if (const auto* cast = llvm::dyn_cast< CastExpr >(expr)) {
+        return get_location(cast->getSubExpr());
+    }
+    if (const auto* full = llvm::dyn_cast< FullExpr >(expr)) {
+        return get_location(full->getSubExpr());
+    }
+    if (const auto* temporary =
+            llvm::dyn_cast< MaterializeTemporaryExpr >(expr)) {
+        return get_location(temporary->getSubExpr());
+    }
+    if (const auto* opaque = llvm::dyn_cast< OpaqueValueExpr >(expr)) {
+        if (const auto* source = opaque->getSourceExpr()) {
+            return get_location(source);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional< std::string > PointsToExtractor::get_call_value(
+    const clang::CallExpr* call) {
+    const auto* callee = call->getDirectCallee();
+    if (callee == nullptr) {
+        return std::nullopt;
+    }
+    if (is_allocation(callee)) {
+        auto temp = create_temp();
+        add(PointsToKind::AddressOf,
+            temp,
+            get_allocation(m_owner,
+                           callee->getASTContext().getSourceManager(),
+                           call->getExprLoc()));
+        return temp;
+    }
+    if (!is_tracked(callee->getReturnType())) {
+        return std::nullopt;
+    }
+    return get_return_node(m_get_name(callee));
+}
+
+std::optional< std::string > PointsToExtractor::get_value(
+    const clang::Expr* expr) {
+    expr = expr->IgnoreParens();
+    if (expr->isGLValue()) {
+        auto location = get_location(expr);
+        if (!location) {
+            return std::nullopt;
+        }
+        if (!location->is_indirect) {
+            return std::move(location->node);
+        }
+        auto temp = create_temp();
+        add(PointsToKind::Load, temp, std::move(location->node));
+        return temp;
+    }
+    if (const auto* cast = llvm::dyn_cast< CastExpr >(expr)) {
+        switch (cast->getCastKind()) {
+            case CK_ArrayToPointerDecay:
+            case CK_FunctionToPointerDecay:
+                if (auto location = get_location(cast->getSubExpr())) {
+                    return get_address(std::move(*location));
+                }
+                return std::nullopt;
+            case CK_NullToPointer:
+            case CK_IntegralToPointer:
+            case CK_PointerToBoolean:
+                return std::nullopt;
+            default:
+                return get_value(cast->getSubExpr());
+        }
+    }
+    if (const auto* unary = llvm::dyn_cast< UnaryOperator >(expr)) {
+        if (unary->getOpcode() == UO_AddrOf) {
+            if (auto location = get_location(unary->getSubExpr())) {
+                return get_address(std::move(*location));
+            }
+            return std::nullopt;
+        }
+        if (unary->isIncrementDecrementOp()) {
+            return get_value(unary->getSubExpr());
+        }
+        return std::nullopt;
+    }
+    if (const auto* binary = llvm::dyn_cast< BinaryOperator >(expr)) {
+        if (binary->isAssignmentOp()) {
+            return get_value(binary->getLHS());
+        }
+        if (binary->isCommaOp()) {
+            return get_value(binary->getRHS());
+        }
+        if (binary->isComparisonOp() || binary->isLogicalOp()) {
+            return std::nullopt;
+        }
+        // The pointer arithmetic stays in the object of its pointer.
+        std::optional< std::string > lhs;
+        std::optional< std::string > rhs;
+        if (is_tracked(binary->getLHS()->getType())) {
+            lhs = get_value(binary->getLHS());
+        }
+        if (is_tracked(binary->getRHS()->getType())) {
+            rhs = get_value(binary->getRHS());
+        }
+        return merge(std::move(lhs), std::move(rhs));
+    }
+    if (const auto* cond =
+            llvm::dyn_cast< AbstractConditionalOperator >(expr)) {
+        return merge(get_value(cond->getTrueExpr()),
+                     get_value(cond->getFalseExpr()));
+    }
+    if (const auto* call = llvm::dyn_cast< CallExpr >(expr)) {
+        return get_call_value(call);
+    }
+    if (const auto* new_expr = llvm::dyn_cast< CXXNewExpr >(expr)) {
+        const auto* allocator = new_expr->getOperatorNew();
+        if (allocator == nullptr) {
+            return std::nullopt;
+        }
+        auto temp = create_temp();
+        add(PointsToKind::AddressOf,
+            temp,
+            get_allocation(m_owner,
+                           allocator->getASTContext().getSourceManager(),
+                           new_expr->getBeginLoc()));
+        return temp;
+    }
+    if (llvm::isa< CXXThisExpr >(expr)) {
+        return get_this_node(m_owner);
+    }
+    if (const auto* init_list = llvm::dyn_cast< InitListExpr >(expr)) {
+        std::optional< std::string > value;
+        for (const auto* init : init_list->inits()) {
+            if (is_tracked(init->getType())) {
+                value = merge(std::move(value), get_value(init));
+            }
+        }
+        return value;
+    }
+    if (const auto* full = llvm::dyn_cast< FullExpr >(expr)) {
+        return get_value(full->getSubExpr());
+    }
+    if (const auto* opaque = llvm::dyn_cast< OpaqueValueExpr >(expr)) {
+        if (const auto* source = opaque->getSourceExpr()) {
+            return get_value(source);
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace knight::cg
@@ -13,16 +13,272 @@
 
 #include "cg/db/db.hpp"
 #include "cg/core/cg.hpp"
-#include "llvm/ADT/STLExtras.h"
+
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+
+#include <optional>
+#include <string_view>
+#include <unordered_set>
 
 namespace knight::cg {
 
+namespace {
+
+constexpr int CGNodeColumns = 6;
+constexpr int CallSiteColumns = 6;
+constexpr int IncludeColumns = 2;
+
+/// \brief Get the ID of `key` in the table interning it, given the
+/// statements inserting it if missing and selecting its ID.
+int64_t intern(sqlite::Database& db,
+               llvm::StringMap< int64_t >& ids,
+               llvm::StringRef key,
+               sqlite::PreparedStmt& insert,
+               sqlite::PreparedStmt& select) {
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    int64_t id = 0;
+    insert.bind_no_copy(1, key);
+    const bool is_inserted = insert.execute() == 1;
+    insert.reset();
+    if (is_inserted) {
+        id = db.get_last_insert_rowid();
+    } else {
+        // Already interned by a previous run.
+        select.bind_no_copy(1, key);
+        const bool found = select.execute_step();
+        knight_assert_msg(found, "Failed to intern the key");
+        id = select.get_column(0).get_as_int64();
+        select.reset();
+    }
+    ids.try_emplace(key, id);
+    return id;
+}
+
+/// \brief Get the INSERT of `rows` rows of `columns` columns.
+std::string get_insert_sql(const char* prefix, int columns, unsigned rows) {
+    std::string row = "(?";
+    for (int col = 1; col < columns; ++col) {
+        row += ",?";
+    }
+    row += ")";
+
+    std::string sql = prefix;
+    sql += " VALUES ";
+    for (unsigned idx = 0U; idx < rows; ++idx) {
+        if (idx != 0U) {
+            sql += ",";
+        }
+        sql += row;
+    }
+    return sql;
+}
+
+/// \brief Insert the records by batches of `InsertBatchRows` rows, and
+/// the remaining ones one by one.
+///
+/// \param bind binds a record to the statement after the given number of
+/// already bound parameters.
+template < typename Record, typename BindFn >
+void insert_batched(const std::vector< Record >& records,
+                    int columns,
+                    sqlite::PreparedStmt& batch_stmt,
+                    sqlite::PreparedStmt& single_stmt,
+                    BindFn bind) {
+    const auto execute = [](sqlite::PreparedStmt& stmt, unsigned rows) {
+        const auto ret = stmt.execute();
+        // Records of a previous run are ignored.
+        knight_assert_msg(ret >= 0 && static_cast< unsigned >(ret) <= rows,
+                          "Failed to insert the records");
+        stmt.reset();
+        stmt.clear_bindings();
+    };
+
+    std::size_t idx = 0U;
+    for (; idx + InsertBatchRows <= records.size(); idx += InsertBatchRows) {
+        for (unsigned row = 0U; row < InsertBatchRows; ++row) {
+            bind(batch_stmt,
+                 static_cast< int >(row) * columns,
+                 records[idx + row]);
+        }
+        execute(batch_stmt, InsertBatchRows);
+    }
+    for (; idx < records.size(); ++idx) {
+        bind(single_stmt, 0, records[idx]);
+        execute(single_stmt, 1U);
+    }
+}
+
+constexpr const char* CGNodeSelect =
+    "SELECT n.line, n.col, n.name, s.mangled_name, f.path, n.end_line "
+    "FROM cg_node n JOIN symbol s ON s.id = n.symbol "
+    "JOIN file f ON f.id = n.file";
+
+constexpr const char* CallSiteSelect =
+    "SELECT c.line, c.col, caller.mangled_name, callee.mangled_name, "
+    "c.is_virtual FROM callsite c JOIN symbol caller ON caller.id = c.caller "
+    "JOIN symbol callee ON callee.id = c.callee";
+
+/// \brief The interning of the strings of the read rows, which outlive
+/// the steps of the statement.
+using InternFn = llvm::function_ref< llvm::StringRef(llvm::StringRef) >;
+
+/// \brief Read the remaining cg node rows of the statement.
+std::vector< CallGraphNode > read_cg_nodes(sqlite::PreparedStmt& stmt,
+                                           InternFn intern_str) {
+    std::vector< CallGraphNode > result;
+    for (const auto& [line, col, name, mangled_name, file, end_line] :
+         stmt.rows< int32_t,
+                    int32_t,
+                    std::string_view,
+                    std::string_view,
+                    std::string_view,
+                    int32_t >()) {
+        result.emplace_back(static_cast< unsigned >(line),
+                            static_cast< unsigned >(col),
+                            intern_str(name),
+                            intern_str(mangled_name),
+                            intern_str(file),
+                            static_cast< unsigned >(end_line));
+    }
+    return result;
+}
+
+/// \brief Read the remaining callsite rows of the statement.
+std::vector< CallSite > read_callsites(sqlite::PreparedStmt& stmt,
+                                       InternFn intern_str) {
+    std::vector< CallSite > result;
+    for (const auto& [line, col, caller, callee, is_virtual] :
+         stmt.rows< int32_t,
+                    int32_t,
+                    std::string_view,
+                    std::string_view,
+                    int32_t >()) {
+        result.emplace_back(static_cast< unsigned >(line),
+                            static_cast< unsigned >(col),
+                            intern_str(caller),
+                            intern_str(callee),
+                            llvm::StringRef(),
+                            is_virtual != 0);
+    }
+    return result;
+}
+
+/// \brief Read the remaining rows of a statement selecting one text.
+std::vector< std::string > read_texts(sqlite::PreparedStmt& stmt) {
+    std::vector< std::string > result;
+    for (const auto& [text] : stmt.rows< std::string_view >()) {
+        result.emplace_back(text);
+    }
+    return result;
+}
+
+/// \brief Read the first cg node row of the statement, if any.
+std::optional< CallGraphNode > read_cg_node(sqlite::PreparedStmt& stmt,
+                                           InternFn intern_str) {
+    auto nodes = read_cg_nodes(stmt, intern_str);
+    if (nodes.empty()) {
+        return std::nullopt;
+    }
+    return std::move(nodes.front());
+}
+
+/// \brief The SQL of the point queries, bound to the queried name.
+/// @{
+const std::string NodeByNameSql =
+    std::string(CGNodeSelect) + " WHERE s.mangled_name = ? LIMIT 1";
+const std::string NodesInFileSql =
+    std::string(CGNodeSelect) + " WHERE f.path = ?";
+const std::string CalleesSql =
+    std::string(CallSiteSelect) + " WHERE caller.mangled_name = ?";
+const std::string CallersSql =
+    std::string(CallSiteSelect) + " WHERE callee.mangled_name = ?";
+constexpr const char* IncludersSql = "SELECT r.path FROM include_edge i "
+                                     "JOIN file r ON r.id = i.includer "
+                                     "JOIN file d ON d.id = i.included "
+                                     "WHERE d.path = ?";
+constexpr const char* DerivedClassesSql =
+    "WITH RECURSIVE derived(id) AS ("
+    "SELECT b.derived FROM class_base b "
+    "JOIN symbol s ON s.id = b.base "
+    "WHERE s.mangled_name = ? UNION "
+    "SELECT b.derived FROM class_base b "
+    "JOIN derived d ON b.base = d.id) "
+    "SELECT s.mangled_name FROM derived d "
+    "JOIN symbol s ON s.id = d.id";
+/// @}
+
+std::string get_virtual_targets_sql(bool is_rta) {
+    std::string sql =
+        "WITH RECURSIVE target(id) AS ("
+        "SELECT id FROM symbol WHERE mangled_name = ?1 UNION "
+        "SELECT o.method FROM method_override o "
+        "JOIN target t ON o.overridden = t.id)";
+    if (is_rta) {
+        // A class is live if it or one of its derived classes is
+        // constructed.
+        sql += ", live(id) AS (SELECT record FROM class_instance UNION "
+               "SELECT b.base FROM class_base b "
+               "JOIN live l ON b.derived = l.id) "
+               "SELECT s.mangled_name FROM target t "
+               "JOIN symbol s ON s.id = t.id "
+               "JOIN virtual_method m ON m.method = t.id "
+               "WHERE m.record IN (SELECT id FROM live)";
+    } else {
+        sql += " SELECT s.mangled_name FROM target t "
+               "JOIN symbol s ON s.id = t.id";
+    }
+    return sql;
+}
+
+} // anonymous namespace
+
 void Database::create_table_if_not_exist() const noexcept {
+    if (m_db.exec_and_get_first("PRAGMA user_version").get_as_int() <
+        CGSchemaVersion) {
+        auto ret = m_db.try_execute(
+            "DROP TABLE IF EXISTS callsite; DROP TABLE IF EXISTS cg_node; "
+            "DROP TABLE IF EXISTS include_edge; "
+            "DROP TABLE IF EXISTS class_base; "
+            "DROP TABLE IF EXISTS virtual_method; "
+            "DROP TABLE IF EXISTS method_override; "
+            "DROP TABLE IF EXISTS class_instance; "
+            "DROP TABLE IF EXISTS points_to_constraint; "
+            "DROP TABLE IF EXISTS points_to_set; "
+            "DROP TABLE IF EXISTS symbol; DROP TABLE IF EXISTS file; "
+            "PRAGMA user_version = " +
+            std::to_string(CGSchemaVersion));
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to drop the outdated cg tables");
+    }
+    if (!m_db.table_exists("symbol")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE symbol (id INTEGER PRIMARY KEY, "
+            "mangled_name TEXT NOT NULL UNIQUE)");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create "
+                          "table 'symbol'");
+    }
+    if (!m_db.table_exists("file")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE file (id INTEGER PRIMARY KEY, "
+            "path TEXT NOT NULL UNIQUE, hash INTEGER)");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create "
+                          "table 'file'");
+    }
     if (!m_db.table_exists("cg_node")) {
         auto ret = m_db.try_execute(
             "CREATE TABLE cg_node (id INTEGER PRIMARY KEY AUTOINCREMENT, "
-            "line INTEGER, col INTEGER, name TEXT, mangled_name TEXT, file "
-            "TEXT)");
+            "line INTEGER, col INTEGER, name TEXT, "
+            "symbol INTEGER REFERENCES symbol(id), "
+            "file INTEGER REFERENCES file(id), end_line INTEGER, "
+            "UNIQUE (symbol, file, line, col))");
         knight_assert_msg(ret == sqlite::SqliteOK,
                           "Failed to create "
                           "table 'cg_node'");
@@ -30,95 +286,667 @@ void Database::create_table_if_not_exist() const noexcept {
     if (!m_db.table_exists("callsite")) {
         auto ret = m_db.try_execute(
             "CREATE TABLE callsite (id INTEGER PRIMARY KEY AUTOINCREMENT, "
-            "line INTEGER, col INTEGER, caller TEXT, callee TEXT)");
+            "line INTEGER, col INTEGER, "
+            "caller INTEGER REFERENCES symbol(id), "
+            "callee INTEGER REFERENCES symbol(id), "
+            "file INTEGER REFERENCES file(id), is_virtual INTEGER, "
+            "UNIQUE (caller, callee, line, col))");
         knight_assert_msg(ret == sqlite::SqliteOK,
                           "Failed to create "
                           "table 'callsite'");
     }
+    if (!m_db.table_exists("include_edge")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE include_edge ("
+            "includer INTEGER REFERENCES file(id), "
+            "included INTEGER REFERENCES file(id), "
+            "UNIQUE (includer, included))");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create "
+                          "table 'include_edge'");
+    }
+    if (!m_db.table_exists("class_base")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE class_base ("
+            "derived INTEGER REFERENCES symbol(id), "
+            "base INTEGER REFERENCES symbol(id), is_virtual INTEGER, "
+            "file INTEGER REFERENCES file(id), UNIQUE (derived, base)); "
+            "CREATE TABLE virtual_method ("
+            "method INTEGER REFERENCES symbol(id), "
+            "record INTEGER REFERENCES symbol(id), "
+            "file INTEGER REFERENCES file(id), UNIQUE (method)); "
+            "CREATE TABLE method_override ("
+            "method INTEGER REFERENCES symbol(id), "
+            "overridden INTEGER REFERENCES symbol(id), "
+            "file INTEGER REFERENCES file(id), UNIQUE (method, overridden)); "
+            "CREATE TABLE class_instance ("
+            "record INTEGER REFERENCES symbol(id), "
+            "file INTEGER REFERENCES file(id), UNIQUE (record, file))");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create the class hierarchy tables");
+    }
+    if (!m_db.table_exists("points_to_constraint")) {
+        auto ret = m_db.try_execute(
+            "CREATE TABLE points_to_constraint (kind INTEGER, "
+            "dst INTEGER REFERENCES symbol(id), "
+            "src INTEGER REFERENCES symbol(id), "
+            "file INTEGER REFERENCES file(id), UNIQUE (kind, dst, src, file)); "
+            "CREATE TABLE points_to_set ("
+            "pointer INTEGER REFERENCES symbol(id), "
+            "pointee INTEGER REFERENCES symbol(id), "
+            "UNIQUE (pointer, pointee))");
+        knight_assert_msg(ret == sqlite::SqliteOK,
+                          "Failed to create the points-to tables");
+    }
+    if (m_is_bulk_load) {
+        drop_indexes();
+    } else {
+        create_indexes();
+    }
+}
+
+void Database::create_indexes() const noexcept {
+    // The mangled names are already indexed by their UNIQUE constraint.
+    auto ret = m_db.try_execute(
+        "CREATE INDEX IF NOT EXISTS callsite_caller ON callsite (caller); "
+        "CREATE INDEX IF NOT EXISTS callsite_callee ON callsite (callee); "
+        "CREATE INDEX IF NOT EXISTS cg_node_symbol ON cg_node (symbol); "
+        "CREATE INDEX IF NOT EXISTS cg_node_file ON cg_node (file); "
+        "CREATE INDEX IF NOT EXISTS include_edge_included "
+        "ON include_edge (included); "
+        "CREATE INDEX IF NOT EXISTS callsite_file ON callsite (file); "
+        "CREATE INDEX IF NOT EXISTS class_base_base ON class_base (base); "
+        "CREATE INDEX IF NOT EXISTS method_override_overridden "
+        "ON method_override (overridden); "
+        "CREATE INDEX IF NOT EXISTS points_to_constraint_file "
+        "ON points_to_constraint (file)");
+    knight_assert_msg(ret == sqlite::SqliteOK, "Failed to create the indexes");
+}
+
+void Database::drop_indexes() const noexcept {
+    auto ret = m_db.try_execute("DROP INDEX IF EXISTS callsite_caller; "
+                                "DROP INDEX IF EXISTS callsite_callee; "
+                                "DROP INDEX IF EXISTS cg_node_symbol; "
+                                "DROP INDEX IF EXISTS cg_node_file; "
+                                "DROP INDEX IF EXISTS include_edge_included; "
+                                "DROP INDEX IF EXISTS callsite_file; "
+                                "DROP INDEX IF EXISTS class_base_base; "
+                                "DROP INDEX IF EXISTS "
+                                "method_override_overridden; "
+                                "DROP INDEX IF EXISTS "
+                                "points_to_constraint_file");
+    knight_assert_msg(ret == sqlite::SqliteOK, "Failed to drop the indexes");
+}
+
+int64_t Database::get_symbol_id(llvm::StringRef mangled_name) {
+    return intern(m_db,
+                  m_symbol_ids,
+                  mangled_name,
+                  m_stmts->insert_symbol,
+                  m_stmts->select_symbol);
+}
+
+int64_t Database::get_file_id(llvm::StringRef path) {
+    return intern(m_db,
+                  m_file_ids,
+                  path,
+                  m_stmts->insert_file,
+                  m_stmts->select_file);
 }
 
 Database::Database(const std::string& knight_dir,
                    const int busy_time_mills,
-                   const int writer_elem_size) noexcept(false)
-    : m_db(sqlite::Database(knight_dir + "/cg.db",
+                   const int writer_elem_size,
+                   const bool is_bulk_load,
+                   const bool is_in_memory) noexcept(false)
+    : m_db(sqlite::Database(is_in_memory ? ":memory:" : knight_dir + "/cg.db",
                             sqlite::OpenMode::READWRITE |
                                 sqlite::OpenMode::CREATE,
-                            busy_time_mills)),
-      m_writer_elem_size(writer_elem_size) {
+                            busy_time_mills,
+                            is_bulk_load ? sqlite::OpenOptions::bulk_load()
+                                         : sqlite::OpenOptions::read_mostly())),
+      m_writer_elem_size(writer_elem_size),
+      m_is_bulk_load(is_bulk_load) {
+    if (is_in_memory) {
+        m_snapshot_file = knight_dir + "/cg.db";
+        // Keep the records of the previous runs, of which the unchanged
+        // units are skipped.
+        if (llvm::sys::fs::exists(m_snapshot_file)) {
+            m_db.restore_from(m_snapshot_file);
+        }
+    }
     create_table_if_not_exist();
+
+    constexpr const char* InsertCGNode =
+        "INSERT OR IGNORE INTO cg_node "
+        "(line, col, name, symbol, file, end_line)";
+    constexpr const char* InsertCallSite =
+        "INSERT OR IGNORE INTO callsite "
+        "(line, col, caller, callee, file, is_virtual)";
+    constexpr const char* InsertInclude =
+        "INSERT OR IGNORE INTO include_edge (includer, included)";
+    m_stmts = std::make_unique< Statements >(Statements{
+        {m_db, get_insert_sql(InsertCGNode, CGNodeColumns, InsertBatchRows)},
+        {m_db, get_insert_sql(InsertCGNode, CGNodeColumns, 1U)},
+        {m_db,
+         get_insert_sql(InsertCallSite, CallSiteColumns, InsertBatchRows)},
+        {m_db, get_insert_sql(InsertCallSite, CallSiteColumns, 1U)},
+        {m_db, get_insert_sql(InsertInclude, IncludeColumns, InsertBatchRows)},
+        {m_db, get_insert_sql(InsertInclude, IncludeColumns, 1U)},
+        {m_db, "INSERT OR IGNORE INTO symbol (mangled_name) VALUES (?)"},
+        {m_db, "SELECT id FROM symbol WHERE mangled_name = ?"},
+        {m_db, "INSERT OR IGNORE INTO file (path) VALUES (?)"},
+        {m_db, "SELECT id FROM file WHERE path = ?"},
+        {m_db, "SELECT hash FROM file WHERE path = ?"},
+        {m_db, "UPDATE file SET hash = ? WHERE id = ?"},
+        {m_db, "DELETE FROM cg_node WHERE file = ?"},
+        {m_db, "DELETE FROM callsite WHERE file = ?"},
+        {m_db, "DELETE FROM include_edge WHERE includer = ?"},
+        {m_db,
+         "INSERT OR IGNORE INTO class_base (derived, base, is_virtual, file) "
+         "VALUES (?, ?, ?, ?)"},
+        {m_db,
+         "INSERT OR IGNORE INTO virtual_method (method, record, file) "
+         "VALUES (?, ?, ?)"},
+        {m_db,
+         "INSERT OR IGNORE INTO method_override (method, overridden, file) "
+         "VALUES (?, ?, ?)"},
+        {m_db,
+         "INSERT OR IGNORE INTO class_instance (record, file) VALUES (?, ?)"},
+        {m_db, "DELETE FROM class_base WHERE file = ?"},
+        {m_db, "DELETE FROM virtual_method WHERE file = ?"},
+        {m_db, "DELETE FROM method_override WHERE file = ?"},
+        {m_db, "DELETE FROM class_instance WHERE file = ?"},
+        {m_db,
+         "INSERT OR IGNORE INTO points_to_constraint (kind, dst, src, file) "
+         "VALUES (?, ?, ?, ?)"},
+        {m_db, "DELETE FROM points_to_constraint WHERE file = ?"}});
+
     m_cg_nodes.reserve(m_writer_elem_size);
     m_callsites.reserve(m_writer_elem_size);
+    m_includes.reserve(m_writer_elem_size);
 }
 
 Database::~Database() {
-    flush_cg_nodes();
-    flush_callsites();
+    end_bulk_load();
+}
+
+llvm::StringRef Database::intern_string(llvm::StringRef str) const {
+    return m_strings.intern(str);
 }
 
 void Database::insert_callsite(const CallSite& callsite) noexcept(false) {
-    m_callsites.emplace_back(callsite);
+    // The call site is only copied to the arena once it is new.
+    if (m_inserted_callsites.contains(callsite)) {
+        return;
+    }
+    const auto interned = callsite.intern(m_strings);
+    m_inserted_callsites.insert(interned);
+    m_callsites.push_back(interned);
     if (m_callsites.size() >= m_writer_elem_size) {
         flush_callsites();
     }
 }
 
 void Database::insert_cg_node(const CallGraphNode& cg_node) noexcept(false) {
-    m_cg_nodes.emplace_back(cg_node);
+    if (m_inserted_cg_nodes.contains(cg_node)) {
+        return;
+    }
+    const auto interned = cg_node.intern(m_strings);
+    m_inserted_cg_nodes.insert(interned);
+    m_cg_nodes.push_back(interned);
     if (m_cg_nodes.size() >= m_writer_elem_size) {
         flush_cg_nodes();
     }
 }
 
+void Database::insert_include(const Include& include) noexcept(false) {
+    if (!m_inserted_includes.insert(include).second) {
+        return;
+    }
+    m_includes.emplace_back(include);
+    if (m_includes.size() >= m_writer_elem_size) {
+        flush_includes();
+    }
+}
+
+void Database::insert_records(const Records& records) noexcept(false) {
+    // The rows of the unit are written atomically with the deletion of the
+    // stale ones.
+    const bool is_atomic = !records.files.empty() ||
+                           records.has_hierarchy() ||
+                           !records.points_to_constraints.empty();
+    std::optional< sqlite::Transaction > transaction;
+    if (is_atomic) {
+        flush();
+        // The unit joins the transaction of the caller if any.
+        if (!m_db.is_in_transaction()) {
+            transaction.emplace(m_db);
+        }
+    }
+
+    for (const auto& file : records.files) {
+        refresh_file(file);
+    }
+    for (const auto& cg_node : records.cg_nodes) {
+        insert_cg_node(cg_node);
+    }
+    for (const auto& callsite : records.callsites) {
+        insert_callsite(callsite);
+    }
+    for (const auto& include : records.includes) {
+        insert_include(include);
+    }
+    insert_hierarchy(records);
+    insert_points_to_constraints(records);
+    if (is_atomic) {
+        flush();
+    }
+    if (transaction) {
+        transaction->commit();
+    }
+}
+
+void Database::insert_hierarchy(const Records& records) {
+    const auto execute = [](sqlite::PreparedStmt& stmt) {
+        (void)stmt.execute();
+        stmt.reset();
+    };
+    auto& stmts = *m_stmts;
+    for (const auto& base : records.class_bases) {
+        stmts.insert_class_base.bind(1, get_symbol_id(base.derived));
+        stmts.insert_class_base.bind(2, get_symbol_id(base.base));
+        stmts.insert_class_base.bind(3,
+                                     static_cast< int32_t >(base.is_virtual));
+        stmts.insert_class_base.bind(4, get_file_id(base.file));
+        execute(stmts.insert_class_base);
+    }
+    for (const auto& method : records.virtual_methods) {
+        stmts.insert_virtual_method.bind(1, get_symbol_id(method.method));
+        stmts.insert_virtual_method.bind(2, get_symbol_id(method.record));
+        stmts.insert_virtual_method.bind(3, get_file_id(method.file));
+        execute(stmts.insert_virtual_method);
+    }
+    for (const auto& overriding : records.method_overrides) {
+        stmts.insert_method_override.bind(1, get_symbol_id(overriding.method));
+        stmts.insert_method_override.bind(2,
+                                          get_symbol_id(overriding.overridden));
+        stmts.insert_method_override.bind(3, get_file_id(overriding.file));
+        execute(stmts.insert_method_override);
+    }
+    for (const auto& instance : records.class_instances) {
+        stmts.insert_class_instance.bind(1, get_symbol_id(instance.record));
+        stmts.insert_class_instance.bind(2, get_file_id(instance.file));
+        execute(stmts.insert_class_instance);
+    }
+}
+
+void Database::insert_points_to_constraints(const Records& records) {
+    auto& stmt = m_stmts->insert_points_to_constraint;
+    for (const auto& constraint : records.points_to_constraints) {
+        stmt.bind(1, static_cast< int32_t >(constraint.kind));
+        stmt.bind(2, get_symbol_id(constraint.dst));
+        stmt.bind(3, get_symbol_id(constraint.src));
+        stmt.bind(4, get_file_id(constraint.file));
+        (void)stmt.execute();
+        stmt.reset();
+    }
+}
+
+void Database::refresh_file(const FileHash& file) {
+    if (!m_refreshed_files.insert(file.path).second) {
+        return;
+    }
+    const auto hash = static_cast< int64_t >(file.hash);
+    auto& select = m_stmts->select_file_hash;
+    select.bind_no_copy(1, file.path);
+    std::optional< int64_t > stored_hash;
+    if (select.execute_step() && !select.get_column(0).is_null()) {
+        stored_hash = select.get_column(0).get_as_int64();
+    }
+    select.reset();
+    if (stored_hash == hash) {
+        return;
+    }
+
+    const auto file_id = get_file_id(file.path);
+    // A file without hash has no records yet.
+    if (stored_hash) {
+        for (auto* stmt : {&m_stmts->delete_file_cg_nodes,
+                           &m_stmts->delete_file_callsites,
+                           &m_stmts->delete_file_includes,
+                           &m_stmts->delete_file_class_bases,
+                           &m_stmts->delete_file_virtual_methods,
+                           &m_stmts->delete_file_method_overrides,
+                           &m_stmts->delete_file_class_instances,
+                           &m_stmts->delete_file_points_to_constraints}) {
+            stmt->bind(1, file_id);
+            (void)stmt->execute();
+            stmt->reset();
+        }
+        // The records of the file are inserted again by this run.
+        std::erase_if(m_inserted_cg_nodes, [&file](const auto& cg_node) {
+            return cg_node.file == file.path;
+        });
+        std::erase_if(m_inserted_callsites, [&file](const auto& callsite) {
+            return callsite.file == file.path;
+        });
+        std::erase_if(m_inserted_includes, [&file](const auto& include) {
+            return include.includer == file.path;
+        });
+    }
+    auto& update = m_stmts->update_file_hash;
+    update.bind(1, hash);
+    update.bind(2, file_id);
+    (void)update.execute();
+    update.reset();
+}
+
+void Database::flush() noexcept(false) {
+    flush_cg_nodes();
+    flush_callsites();
+    flush_includes();
+}
+
+void Database::end_bulk_load() noexcept(false) {
+    flush();
+    if (m_is_bulk_load) {
+        create_indexes();
+        m_is_bulk_load = false;
+    }
+    if (!m_snapshot_file.empty() &&
+        m_snapshot_changes != m_db.get_total_dml_changes()) {
+        m_db.backup_to(m_snapshot_file);
+        m_snapshot_changes = m_db.get_total_dml_changes();
+    }
+}
+
+bool Database::merge(const std::string& db_file) noexcept(false) {
+    // Attaching a missing file would create an empty database.
+    if (!llvm::sys::fs::exists(db_file)) {
+        return false;
+    }
+    flush();
+
+    // The IDs differ between the databases, so the records are remapped
+    // through the mangled names and the paths.
+    sqlite::PreparedStmt attach(m_db, "ATTACH DATABASE ? AS shard");
+    attach.bind(1, db_file);
+    (void)attach.execute();
+    bool is_merged = false;
+    if (m_db.exec_and_get_first("PRAGMA shard.user_version").get_as_int() ==
+        CGSchemaVersion) {
+        sqlite::Transaction transaction(m_db);
+        (void)m_db.execute(
+            "INSERT OR IGNORE INTO main.symbol (mangled_name) "
+            "SELECT mangled_name FROM shard.symbol; "
+            "INSERT OR IGNORE INTO main.file (path, hash) "
+            "SELECT path, hash FROM shard.file; "
+            "INSERT OR IGNORE INTO main.cg_node "
+            "(line, col, name, symbol, file, end_line) "
+            "SELECT n.line, n.col, n.name, s.id, f.id, n.end_line "
+            "FROM shard.cg_node n "
+            "JOIN shard.symbol ss ON ss.id = n.symbol "
+            "JOIN main.symbol s ON s.mangled_name = ss.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = n.file "
+            "LEFT JOIN main.file f ON f.path = sf.path; "
+            "INSERT OR IGNORE INTO main.include_edge (includer, included) "
+            "SELECT r.id, d.id FROM shard.include_edge i "
+            "JOIN shard.file sr ON sr.id = i.includer "
+            "JOIN main.file r ON r.path = sr.path "
+            "JOIN shard.file sd ON sd.id = i.included "
+            "JOIN main.file d ON d.path = sd.path; "
+            "INSERT OR IGNORE INTO main.callsite "
+            "(line, col, caller, callee, file) "
+            "SELECT c.line, c.col, r.id, e.id, f.id FROM shard.callsite c "
+            "JOIN shard.symbol sr ON sr.id = c.caller "
+            "JOIN main.symbol r ON r.mangled_name = sr.mangled_name "
+            "JOIN shard.symbol se ON se.id = c.callee "
+            "JOIN main.symbol e ON e.mangled_name = se.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = c.file "
+            "LEFT JOIN main.file f ON f.path = sf.path; "
+            "INSERT OR IGNORE INTO main.class_base "
+            "(derived, base, is_virtual, file) "
+            "SELECT d.id, b.id, c.is_virtual, f.id FROM shard.class_base c "
+            "JOIN shard.symbol sd ON sd.id = c.derived "
+            "JOIN main.symbol d ON d.mangled_name = sd.mangled_name "
+            "JOIN shard.symbol sb ON sb.id = c.base "
+            "JOIN main.symbol b ON b.mangled_name = sb.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = c.file "
+            "LEFT JOIN main.file f ON f.path = sf.path; "
+            "INSERT OR IGNORE INTO main.virtual_method (method, record, file) "
+            "SELECT m.id, r.id, f.id FROM shard.virtual_method v "
+            "JOIN shard.symbol sm ON sm.id = v.method "
+            "JOIN main.symbol m ON m.mangled_name = sm.mangled_name "
+            "JOIN shard.symbol sr ON sr.id = v.record "
+            "JOIN main.symbol r ON r.mangled_name = sr.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = v.file "
+            "LEFT JOIN main.file f ON f.path = sf.path; "
+            "INSERT OR IGNORE INTO main.method_override "
+            "(method, overridden, file) "
+            "SELECT m.id, o.id, f.id FROM shard.method_override v "
+            "JOIN shard.symbol sm ON sm.id = v.method "
+            "JOIN main.symbol m ON m.mangled_name = sm.mangled_name "
+            "JOIN shard.symbol so ON so.id = v.overridden "
+            "JOIN main.symbol o ON o.mangled_name = so.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = v.file "
+            "LEFT JOIN main.file f ON f.path = sf.path; "
+            "INSERT OR IGNORE INTO main.class_instance (record, file) "
+            "SELECT r.id, f.id FROM shard.class_instance i "
+            "JOIN shard.symbol sr ON sr.id = i.record "
+            "JOIN main.symbol r ON r.mangled_name = sr.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = i.file "
+            "LEFT JOIN main.file f ON f.path = sf.path; "
+            "INSERT OR IGNORE INTO main.points_to_constraint "
+            "(kind, dst, src, file) "
+            "SELECT c.kind, d.id, s.id, f.id FROM shard.points_to_constraint c "
+            "JOIN shard.symbol sd ON sd.id = c.dst "
+            "JOIN main.symbol d ON d.mangled_name = sd.mangled_name "
+            "JOIN shard.symbol ss ON ss.id = c.src "
+            "JOIN main.symbol s ON s.mangled_name = ss.mangled_name "
+            "LEFT JOIN shard.file sf ON sf.id = c.file "
+            "LEFT JOIN main.file f ON f.path = sf.path");
+        transaction.commit();
+        is_merged = true;
+    }
+    (void)m_db.execute("DETACH DATABASE shard");
+    return is_merged;
+}
+
 std::vector< CallGraphNode > Database::get_all_cg_nodes() const noexcept {
-    std::vector< CallGraphNode > result;
-    sqlite::PreparedStmt stmt(m_db, "SELECT * FROM cg_node");
-    while (stmt.execute_step()) {
-        const auto id = stmt.get_column(0).get_as_int();
-        const auto line = stmt.get_column(1).get_as_int();
-        const auto col = stmt.get_column(2).get_as_int();
-        const auto* name = stmt.get_column(3).get_as_text();
-        const auto* mangled_name = stmt.get_column(4).get_as_text();
-        const auto* file = stmt.get_column(5).get_as_text();
-        result.emplace_back(line, col, name, mangled_name, file);
+    sqlite::PreparedStmt stmt(m_db, CGNodeSelect);
+    return read_cg_nodes(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< CallSite > Database::get_all_callsites() const noexcept {
+    sqlite::PreparedStmt stmt(m_db, CallSiteSelect);
+    return read_callsites(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::optional< CallGraphNode > Database::get_node(
+    const std::string& mangled_name) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, NodeByNameSql);
+    stmt.bind(1, mangled_name);
+    return read_cg_node(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< CallGraphNode > Database::get_nodes_in_file(
+    const std::string& path) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, NodesInFileSql);
+    stmt.bind(1, path);
+    return read_cg_nodes(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< std::string > Database::get_includers(
+    const std::string& path) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, IncludersSql);
+    stmt.bind(1, path);
+    return read_texts(stmt);
+}
+
+std::vector< std::string > Database::get_virtual_targets(
+    const std::string& mangled_name, const bool is_rta) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, get_virtual_targets_sql(is_rta));
+    stmt.bind(1, mangled_name);
+    return read_texts(stmt);
+}
+
+std::vector< std::string > Database::get_derived_classes(
+    const std::string& record) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, DerivedClassesSql);
+    stmt.bind(1, record);
+    return read_texts(stmt);
+}
+
+std::vector< PointsToConstraint > Database::get_all_points_to_constraints()
+    const noexcept {
+    sqlite::PreparedStmt stmt(m_db,
+                              "SELECT c.kind, d.mangled_name, s.mangled_name "
+                              "FROM points_to_constraint c "
+                              "JOIN symbol d ON d.id = c.dst "
+                              "JOIN symbol s ON s.id = c.src");
+    std::vector< PointsToConstraint > result;
+    for (const auto& [kind, dst, src] :
+         stmt.rows< int32_t, std::string_view, std::string_view >()) {
+        result.push_back(PointsToConstraint{static_cast< PointsToKind >(kind),
+                                            std::string(dst),
+                                            std::string(src),
+                                            ""});
     }
     return result;
 }
 
-std::vector< CallSite > Database::get_all_callsites() const noexcept {
-    std::vector< CallSite > result;
-    sqlite::PreparedStmt stmt(m_db, "SELECT * FROM callsite");
-    while (stmt.execute_step()) {
-        const auto id = stmt.get_column(0).get_as_int();
-        const auto line = stmt.get_column(1).get_as_int();
-        const auto col = stmt.get_column(2).get_as_int();
-        const auto* caller = stmt.get_column(3).get_as_text();
-        const auto* callee = stmt.get_column(4).get_as_text();
-        result.emplace_back(line, col, caller, callee);
+std::vector< std::pair< std::string, std::string > > Database::
+    get_all_points_to_sets() const noexcept {
+    sqlite::PreparedStmt stmt(m_db,
+                              "SELECT p.mangled_name, o.mangled_name "
+                              "FROM points_to_set t "
+                              "JOIN symbol p ON p.id = t.pointer "
+                              "JOIN symbol o ON o.id = t.pointee");
+    std::vector< std::pair< std::string, std::string > > result;
+    for (const auto& [pointer, pointee] :
+         stmt.rows< std::string_view, std::string_view >()) {
+        result.emplace_back(std::string(pointer), std::string(pointee));
     }
     return result;
 }
 
+void Database::replace_points_to_sets(
+    const std::vector< std::pair< std::string, std::string > >& rows) noexcept(
+    false) {
+    flush();
+    std::optional< sqlite::Transaction > transaction;
+    if (!m_db.is_in_transaction()) {
+        transaction.emplace(m_db);
+    }
+    (void)m_db.execute("DELETE FROM points_to_set");
+    sqlite::PreparedStmt insert(m_db,
+                                "INSERT OR IGNORE INTO points_to_set "
+                                "(pointer, pointee) VALUES (?, ?)");
+    for (const auto& [pointer, pointee] : rows) {
+        insert.bind(1, get_symbol_id(pointer));
+        insert.bind(2, get_symbol_id(pointee));
+        (void)insert.execute();
+        insert.reset();
+    }
+    if (transaction) {
+        transaction->commit();
+    }
+}
+
+bool Database::is_up_to_date(const std::string& unit,
+                             llvm::vfs::FileSystem& fs) const noexcept {
+    sqlite::PreparedStmt select_hash(m_db,
+                                     "SELECT hash FROM file WHERE path = ?");
+    sqlite::PreparedStmt select_included(m_db,
+                                         "SELECT d.path FROM include_edge i "
+                                         "JOIN file r ON r.id = i.includer "
+                                         "JOIN file d ON d.id = i.included "
+                                         "WHERE r.path = ?");
+    std::unordered_set< std::string > visited{unit};
+    std::vector< std::string > worklist{unit};
+    while (!worklist.empty()) {
+        auto file = std::move(worklist.back());
+        worklist.pop_back();
+
+        select_hash.bind(1, file);
+        const bool is_recorded =
+            select_hash.execute_step() && !select_hash.get_column(0).is_null();
+        const auto stored_hash =
+            is_recorded ? select_hash.get_column(0).get_as_int64() : 0;
+        select_hash.reset();
+        auto buffer = fs.getBufferForFile(file);
+        if (!is_recorded || !buffer ||
+            static_cast< int64_t >(get_content_hash(
+                (*buffer)->getBuffer())) != stored_hash) {
+            return false;
+        }
+
+        select_included.bind(1, file);
+        while (select_included.execute_step()) {
+            auto included = select_included.get_column(0).get_as_text();
+            if (visited.insert(included).second) {
+                worklist.push_back(std::move(included));
+            }
+        }
+        select_included.reset();
+    }
+    return true;
+}
+
+std::vector< CallSite > Database::get_callees(
+    const std::string& mangled_name) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, CalleesSql);
+    stmt.bind(1, mangled_name);
+    return read_callsites(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< CallSite > Database::get_callers(
+    const std::string& mangled_name) const noexcept {
+    sqlite::PreparedStmt stmt(m_db, CallersSql);
+    stmt.bind(1, mangled_name);
+    return read_callsites(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
 void Database::flush_cg_nodes() {
     if (m_cg_nodes.empty()) {
         return;
     }
-    sqlite::Transaction transaction((m_db));
-    sqlite::PreparedStmt stmt(m_db,
-                              "INSERT INTO cg_node (line, col, name, "
-                              "mangled_name, file) VALUES (?,?,?,?,?)");
-    const auto insert = [&](const CallGraphNode& cg_node) {
-        stmt.bind(1, cg_node.line);
-        stmt.bind(2, cg_node.col);
-        stmt.bind(3, cg_node.name);
-        stmt.bind(4, cg_node.mangled_name);
-        stmt.bind(5, cg_node.file);
-        const auto ret = stmt.execute();
-        knight_assert_msg(ret == 1, "Failed to insert cg_node");
-        stmt.reset();
-        stmt.clear_bindings();
+    std::optional< sqlite::Transaction > transaction;
+    if (!m_db.is_in_transaction()) {
+        transaction.emplace(m_db);
+    }
+    // The strings are bound without copy, they outlive the execution.
+    const auto bind = [this](sqlite::PreparedStmt& stmt,
+                             int offset,
+                             const CallGraphNode& cg_node) {
+        stmt.bind(offset + 1, cg_node.line);
+        stmt.bind(offset + 2, cg_node.col);
+        stmt.bind_no_copy(offset + 3, cg_node.name);
+        stmt.bind(offset + 4, get_symbol_id(cg_node.mangled_name));
+        stmt.bind(offset + 5, get_file_id(cg_node.file));
+        stmt.bind(offset + 6, cg_node.end_line);
     };
-    llvm::for_each(m_cg_nodes, insert);
-    transaction.commit();
+    insert_batched(m_cg_nodes,
+                   CGNodeColumns,
+                   m_stmts->insert_cg_node_batch,
+                   m_stmts->insert_cg_node,
+                   bind);
+    if (transaction) {
+        transaction->commit();
+    }
     m_cg_nodes.clear();
 }
 
@@ -126,23 +954,132 @@ void Database::flush_callsites() {
     if (m_callsites.empty()) {
         return;
     }
-    sqlite::Transaction transaction((m_db));
-    sqlite::PreparedStmt stmt(m_db,
-                              "INSERT INTO callsite (line, col, caller, "
-                              "callee) VALUES (?,?,?,?)");
-    const auto insert = [&](const CallSite& callsite) {
-        stmt.bind(1, callsite.line);
-        stmt.bind(2, callsite.col);
-        stmt.bind(3, callsite.caller);
-        stmt.bind(4, callsite.callee);
-        const auto ret = stmt.execute();
-        knight_assert_msg(ret == 1, "Failed to insert callsite");
-        stmt.reset();
-        stmt.clear_bindings();
+    std::optional< sqlite::Transaction > transaction;
+    if (!m_db.is_in_transaction()) {
+        transaction.emplace(m_db);
+    }
+    const auto bind = [this](sqlite::PreparedStmt& stmt,
+                             int offset,
+                             const CallSite& callsite) {
+        stmt.bind(offset + 1, callsite.line);
+        stmt.bind(offset + 2, callsite.col);
+        stmt.bind(offset + 3, get_symbol_id(callsite.caller));
+        stmt.bind(offset + 4, get_symbol_id(callsite.callee));
+        if (callsite.file.empty()) {
+            stmt.bind_null(offset + 5);
+        } else {
+            stmt.bind(offset + 5, get_file_id(callsite.file));
+        }
+        stmt.bind(offset + 6, static_cast< int32_t >(callsite.is_virtual));
     };
-    llvm::for_each(m_callsites, insert);
-    transaction.commit();
+    insert_batched(m_callsites,
+                   CallSiteColumns,
+                   m_stmts->insert_callsite_batch,
+                   m_stmts->insert_callsite,
+                   bind);
+    if (transaction) {
+        transaction->commit();
+    }
     m_callsites.clear();
 }
 
+void Database::flush_includes() {
+    if (m_includes.empty()) {
+        return;
+    }
+    std::optional< sqlite::Transaction > transaction;
+    if (!m_db.is_in_transaction()) {
+        transaction.emplace(m_db);
+    }
+    const auto bind = [this](sqlite::PreparedStmt& stmt,
+                             int offset,
+                             const Include& include) {
+        stmt.bind(offset + 1, get_file_id(include.includer));
+        stmt.bind(offset + 2, get_file_id(include.included));
+    };
+    insert_batched(m_includes,
+                   IncludeColumns,
+                   m_stmts->insert_include_batch,
+                   m_stmts->insert_include,
+                   bind);
+    if (transaction) {
+        transaction->commit();
+    }
+    m_includes.clear();
+}
+
+DatabaseReader::DatabaseReader(const std::string& knight_dir,
+                               const std::size_t max_connections,
+                               const int busy_time_mills) noexcept(false)
+    : m_pool(knight_dir + "/cg.db", max_connections, busy_time_mills) {}
+
+llvm::StringRef DatabaseReader::intern_string(llvm::StringRef str) const {
+    const std::lock_guard< std::mutex > lock(m_strings_mutex);
+    return m_strings.intern(str);
+}
+
+std::optional< CallGraphNode > DatabaseReader::get_node(
+    const std::string& mangled_name) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(NodeByNameSql);
+    stmt.bind(1, mangled_name);
+    return read_cg_node(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< CallSite > DatabaseReader::get_callees(
+    const std::string& mangled_name) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(CalleesSql);
+    stmt.bind(1, mangled_name);
+    return read_callsites(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< CallSite > DatabaseReader::get_callers(
+    const std::string& mangled_name) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(CallersSql);
+    stmt.bind(1, mangled_name);
+    return read_callsites(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< CallGraphNode > DatabaseReader::get_nodes_in_file(
+    const std::string& path) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(NodesInFileSql);
+    stmt.bind(1, path);
+    return read_cg_nodes(stmt, [this](llvm::StringRef str) {
+        return intern_string(str);
+    });
+}
+
+std::vector< std::string > DatabaseReader::get_includers(
+    const std::string& path) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(IncludersSql);
+    stmt.bind(1, path);
+    return read_texts(stmt);
+}
+
+std::vector< std::string > DatabaseReader::get_virtual_targets(
+    const std::string& mangled_name, const bool is_rta) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(get_virtual_targets_sql(is_rta));
+    stmt.bind(1, mangled_name);
+    return read_texts(stmt);
+}
+
+std::vector< std::string > DatabaseReader::get_derived_classes(
+    const std::string& record) const noexcept(false) {
+    auto conn = m_pool.acquire();
+    auto& stmt = conn->get_stmt(DerivedClassesSql);
+    stmt.bind(1, record);
+    return read_texts(stmt);
+}
+
 } // namespace knight::cg
\ No newline at end of file
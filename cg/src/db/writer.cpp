@@ -0,0 +1,57 @@
+//===- writer.cpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the single writer of the cg database.
+//
+//===------------------------------------------------------------------===//
+
+#include "cg/db/writer.hpp"
+
+namespace knight::cg {
+
+DatabaseWriter::DatabaseWriter(const std::string& knight_dir,
+                               int busy_time_mills,
+                               bool is_threaded,
+                               bool is_in_memory) noexcept(false)
+    : m_db(knight_dir,
+           busy_time_mills,
+           DefaultWriterElemSize,
+           true,
+           is_in_memory) {
+    if (is_threaded) {
+        m_async_writer =
+            std::make_unique< sqlite::AsyncWriter >(m_db.get_connection());
+    }
+}
+
+DatabaseWriter::~DatabaseWriter() {
+    finish();
+}
+
+void DatabaseWriter::push(Records records) {
+    if (m_async_writer == nullptr) {
+        m_db.insert_records(records);
+        return;
+    }
+    m_async_writer->push(
+        [this, records = std::move(records)]() {
+            m_db.insert_records(records);
+        });
+}
+
+void DatabaseWriter::finish() {
+    if (m_async_writer != nullptr) {
+        // The writer is stopped even if a group failed.
+        auto async_writer = std::move(m_async_writer);
+        async_writer->finish();
+    }
+    m_db.end_bulk_load();
+}
+
+} // namespace knight::cg
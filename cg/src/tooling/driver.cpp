@@ -12,22 +12,37 @@
 //===------------------------------------------------------------------===//
 
 #include "cg/tooling/driver.hpp"
+#include "cg/core/andersen.hpp"
 #include "cg/core/builder.hpp"
+#include "cg/core/csr.hpp"
 #include "cg/db/db.hpp"
 #include "common/util/clang.hpp"
 #include "common/util/log.hpp"
+#include "common/util/pch.hpp"
+#include "common/util/progress.hpp"
+#include "common/util/tu_costs.hpp"
 #include "common/util/vfs.hpp"
 
 #include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/Statistic.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/WithColor.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #define DEBUG_TYPE "cg-driver"
 
 STATISTIC(NumSystemFunctions, "The # of times system functions are processed");
 STATISTIC(NumImplicitFunctions,
           "The # of times implicit functions are processed");
 STATISTIC(NumTotalFunctions, "The # of times total functions are processed");
+STATISTIC(NumExtractedFunctions,
+          "The # of times header functions are skipped as already extracted");
 
 namespace knight {
 
@@ -68,16 +83,122 @@ std::unique_ptr< clang::ASTConsumer > KnightIRConsumer::create_ast_consumer(
     m_ctx.file = file;
     m_ctx.ast_ctx = &ci.getASTContext();
 
-    return std::make_unique< KnightASTConsumer >(m_ctx);
+    return std::make_unique< CGASTConsumer >(m_ctx);
 }
 
 void KnightCGBuilder::build() {
+    if (m_ctx.incremental) {
+        skip_up_to_date_files();
+    }
+    unsigned jobs =
+        m_ctx.jobs == 0U ? std::thread::hardware_concurrency() : m_ctx.jobs;
+    jobs = std::min(jobs, static_cast< unsigned >(m_ctx.input_files.size()));
+
+    clang::tooling::ArgumentsAdjuster pch_adjuster;
+    if (!m_ctx.pch_header.empty()) {
+        pch_adjuster = pch::build_pch_adjuster(*m_ctx.cdb,
+                                               m_ctx.input_files,
+                                               m_ctx.pch_header,
+                                               m_ctx.knight_dir + "/pch",
+                                               m_ctx.overlay_fs);
+    }
+
+    begin_extraction(jobs > 1U);
+    if (jobs > 1U) {
+        run_in_parallel(jobs, pch_adjuster);
+    } else if (!m_ctx.input_files.empty()) {
+        run_on_files(m_ctx, m_ctx.input_files, pch_adjuster);
+    }
+    finish_extraction();
+}
+
+void KnightCGBuilder::skip_up_to_date_files() {
+    if (!llvm::sys::fs::exists(m_ctx.knight_dir + "/cg.db")) {
+        return;
+    }
+    const cg::Database db(m_ctx.knight_dir,
+                          static_cast< int >(m_ctx.db_busy_timeout));
+    const auto num_files = m_ctx.input_files.size();
+    llvm::erase_if(m_ctx.input_files, [&](const std::string& file) {
+        return db.is_up_to_date(file, *m_ctx.overlay_fs);
+    });
+    const auto num_skipped = num_files - m_ctx.input_files.size();
+    if (m_ctx.report_progress) {
+        for (std::size_t idx = 0U; idx < num_skipped; ++idx) {
+            ProgressReporter::get().add_unit();
+        }
+    }
+    knight_log_nl(llvm::outs() << "skip " << num_skipped
+                               << " up to date units\n");
+}
+
+void KnightCGBuilder::begin_extraction(bool concurrent) {
+    m_extracted_defs = std::make_unique< cg::ExtractedDefinitions >();
+    m_ctx.extracted_defs = m_extracted_defs.get();
+    m_writer = std::make_unique<
+        cg::DatabaseWriter >(m_ctx.knight_dir,
+                             static_cast< int >(m_ctx.db_busy_timeout),
+                             concurrent,
+                             m_ctx.in_memory_db);
+    m_ctx.writer = m_writer.get();
+}
+
+std::unique_ptr< clang::ASTConsumer > KnightCGBuilder::create_ast_consumer(
+    clang::ASTContext& ast_ctx, llvm::StringRef file) const {
+    auto ctx = std::make_unique< CGContext >(m_ctx);
+    ctx->ast_ctx = &ast_ctx;
+    ctx->file = file;
+    return std::make_unique< CGASTConsumer >(std::move(ctx));
+}
+
+void KnightCGBuilder::finish_extraction() {
+    m_writer->finish();
+    m_ctx.writer = nullptr;
+    m_ctx.extracted_defs = nullptr;
+    m_writer.reset();
+    m_extracted_defs.reset();
+
+    if (!m_ctx.csr_file.empty()) {
+        const cg::Database db(m_ctx.knight_dir,
+                              static_cast< int >(m_ctx.db_busy_timeout));
+        if (!cg::write_csr_graph(db.get_all_cg_nodes(),
+                                 db.get_all_callsites(),
+                                 m_ctx.csr_file)) {
+            llvm::WithColor::error() << "Cannot export the call graph to `"
+                                     << m_ctx.csr_file << "`.\n";
+        }
+    }
+
+    if (m_ctx.points_to) {
+        // The constraints of the up to date units are still in the
+        // database, so that the whole program is solved again.
+        cg::Database db(m_ctx.knight_dir,
+                        static_cast< int >(m_ctx.db_busy_timeout));
+        cg::PointsToFacts::solve(db.get_all_points_to_constraints(),
+                                 m_ctx.jobs)
+            .save(db);
+    }
+
+    knight_log_nl(
+        llvm::outs() << "dump db: " << "\n";
+        cg::Database db(m_ctx.knight_dir, m_ctx.db_busy_timeout);
+        for (const auto& cs
+             : db.get_all_callsites()) {
+            cs.dump(llvm::outs());
+        } for (const auto& node
+               : db.get_all_cg_nodes()) { node.dump(llvm::outs()); });
+}
+
+void KnightCGBuilder::run_on_files(
+    CGContext& ctx,
+    const std::vector< std::string >& files,
+    const clang::tooling::ArgumentsAdjuster& pch_adjuster) {
     using namespace clang;
     using namespace clang::tooling;
-    ClangTool clang_tool(*m_ctx.cdb,
-                         m_ctx.input_files,
+    ClangTool clang_tool(*ctx.cdb,
+                         files,
                          std::make_shared< PCHContainerOperations >(),
-                         m_ctx.overlay_fs);
+                         ctx.overlay_fs);
     clang::tooling::CommandLineArguments clang_include{
         clang_util::get_clang_include_dir()};
     knight_log_nl(llvm::outs()
@@ -87,21 +208,92 @@ void KnightCGBuilder::build() {
             getInsertArgumentAdjuster(clang_include,
                                       clang::tooling::ArgumentInsertPosition::
                                           END));
+    if (pch_adjuster) {
+        clang_tool.appendArgumentsAdjuster(pch_adjuster);
+    }
 
-    KnightActionFactory action_factory(m_ctx);
+    KnightActionFactory action_factory(ctx);
     clang_tool.run(&action_factory);
+}
 
-    knight_log_nl(
-        llvm::outs() << "dump db: " << "\n";
-        cg::Database db(m_ctx.knight_dir, m_ctx.db_busy_timeout);
-        for (const auto& cs
-             : db.get_all_callsites()) {
-            cs.dump(llvm::outs());
-        } for (const auto& node
-               : db.get_all_cg_nodes()) { node.dump(llvm::outs()); });
+void KnightCGBuilder::run_in_parallel(
+    unsigned jobs, const clang::tooling::ArgumentsAdjuster& pch_adjuster) {
+    std::atomic< std::size_t > next_file{0U};
+    const auto& files = m_ctx.input_files;
+    TUCosts costs(m_ctx.knight_dir, CGTUCostsFile);
+    const auto schedule = costs.get_schedule(files, m_ctx.overlay_fs);
+
+    auto worker = [&]() {
+        CGContext worker_ctx = m_ctx;
+        worker_ctx.overlay_fs = fs::create_isolated_vfs(m_ctx.overlay_fs);
+        for (auto next = next_file.fetch_add(1U); next < schedule.size();
+             next = next_file.fetch_add(1U)) {
+            const auto& file = files[schedule[next]];
+            auto start = std::chrono::steady_clock::now();
+            run_on_files(worker_ctx, {file}, pch_adjuster);
+            costs.record(file,
+                         std::chrono::duration_cast<
+                             std::chrono::microseconds >(
+                             std::chrono::steady_clock::now() - start));
+        }
+    };
+
+    std::vector< std::thread > workers;
+    workers.reserve(jobs);
+    for (unsigned worker_id = 0U; worker_id < jobs; ++worker_id) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    (void)costs.save();
 }
 
-bool KnightASTConsumer::HandleTopLevelDecl(clang::DeclGroupRef decl_group) {
+bool CGASTConsumer::is_extracted(const clang::FunctionDecl* function) {
+    auto& sm = m_ctx.ast_ctx->getSourceManager();
+    auto loc = sm.getExpansionLoc(function->getLocation());
+    // The main file definitions are only seen by their own TU.
+    if (sm.isInMainFile(loc)) {
+        return false;
+    }
+    auto presumed_loc = sm.getPresumedLoc(loc);
+    if (presumed_loc.isInvalid()) {
+        return false;
+    }
+    auto key = fs::make_absolute(presumed_loc.getFilename()) + ":" +
+               std::to_string(presumed_loc.getLine()) + ":" +
+               std::to_string(presumed_loc.getColumn());
+    return !m_ctx.extracted_defs->try_mark(std::move(key));
+}
+
+void CGASTConsumer::HandleTranslationUnit(clang::ASTContext& ast_ctx) {
+    m_builder.collect_files(ast_ctx.getSourceManager());
+    m_builder.collect_hierarchy(ast_ctx.getTranslationUnitDecl());
+    auto records = m_builder.take_records();
+    if (!records.empty()) {
+        m_ctx.writer->push(std::move(records));
+    }
+    if (m_ctx.report_progress) {
+        ProgressReporter::get().add_unit();
+    }
+}
+
+void CGASTConsumer::report_progress(const clang::FunctionDecl* function,
+                                    bool is_system_function) const {
+    auto& progress = ProgressReporter::get();
+    if (!is_system_function || m_ctx.show_process_sys_function) {
+        auto color = is_system_function ? llvm::raw_ostream::Colors::RED
+                                        : llvm::raw_ostream::Colors::GREEN;
+        progress.add_function(
+            [function](llvm::raw_ostream& os) { function->printName(os); },
+            color,
+            function->isImplicit() ? " (implicit)" : "");
+    } else {
+        progress.add_function();
+    }
+}
+
+bool CGASTConsumer::HandleTopLevelDecl(clang::DeclGroupRef decl_group) {
     for (auto* decl : decl_group) {
         auto* function = llvm::dyn_cast_or_null< clang::FunctionDecl >(decl);
         if (function == nullptr || !function->hasBody()) {
@@ -119,32 +311,18 @@ bool KnightASTConsumer::HandleTopLevelDecl(clang::DeclGroupRef decl_group) {
             }
             NumImplicitFunctions++;
         }
-        if (!is_system_function || m_ctx.show_process_sys_function) {
-            llvm::outs() << "[*] Processing function: ";
+        if (is_extracted(function)) {
+            NumExtractedFunctions++;
+            continue;
         }
-
         if (is_system_function) {
             NumSystemFunctions++;
         }
 
         NumTotalFunctions++;
 
-        if (m_ctx.use_color) {
-            if (is_system_function) {
-                if (m_ctx.show_process_sys_function) {
-                    llvm::outs().changeColor(llvm::raw_ostream::Colors::RED);
-                }
-            } else {
-                llvm::outs().changeColor(llvm::raw_ostream::Colors::GREEN);
-            }
-        }
-        if (!is_system_function || m_ctx.show_process_sys_function) {
-            function->printName(llvm::outs());
-            llvm::outs().resetColor();
-            if (function->isImplicit()) {
-                llvm::outs() << " (implicit)";
-            }
-            llvm::outs() << "\n";
+        if (m_ctx.report_progress) {
+            report_progress(function, is_system_function);
         }
         m_builder.TraverseDecl(function);
     }
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+
+#include "cg/core/andersen.hpp"
+
+using namespace knight::cg;
+
+#define TestFile "a.cpp"
+
+PointsToConstraint make_constraint(PointsToKind kind,
+                                   const std::string& dst,
+                                   const std::string& src) {
+    return PointsToConstraint{kind, dst, src, TestFile};
+}
+
+std::vector< std::string > get_points_to(const PointsToFacts& facts,
+                                         llvm::StringRef p) {
+    std::vector< std::string > pointees;
+    for (const auto pointee : facts.get_points_to(p)) {
+        pointees.push_back(pointee.str());
+    }
+    return pointees;
+}
+
+TEST(PointsToFacts, CollapseCopyCycle) {
+    // a = &x; b = a; c = b; a = c; d = &y; b = d; e = &z;
+    const std::vector< PointsToConstraint > constraints{
+        make_constraint(PointsToKind::AddressOf, "a", "x"),
+        make_constraint(PointsToKind::Copy, "b", "a"),
+        make_constraint(PointsToKind::Copy, "c", "b"),
+        make_constraint(PointsToKind::Copy, "a", "c"),
+        make_constraint(PointsToKind::AddressOf, "d", "y"),
+        make_constraint(PointsToKind::Copy, "b", "d"),
+        make_constraint(PointsToKind::AddressOf, "e", "z"),
+    };
+    auto facts = PointsToFacts::solve(constraints, 1U);
+
+    // The nodes of the cycle share the facts entering any of them.
+    const std::vector< std::string > cycle_pointees{"x", "y"};
+    EXPECT_EQ(cycle_pointees, get_points_to(facts, "a"));
+    EXPECT_EQ(cycle_pointees, get_points_to(facts, "b"));
+    EXPECT_EQ(cycle_pointees, get_points_to(facts, "c"));
+    EXPECT_EQ(std::vector< std::string >{"y"}, get_points_to(facts, "d"));
+
+    EXPECT_TRUE(facts.may_alias("a", "c"));
+    EXPECT_TRUE(facts.may_alias("d", "a"));
+    EXPECT_FALSE(facts.may_alias("e", "a"));
+    EXPECT_TRUE(facts.may_point_to("c", "y"));
+    EXPECT_FALSE(facts.may_point_to("d", "x"));
+}
+
+TEST(PointsToFacts, CloseLoadsAndStores) {
+    // p = &x; q = &y; *p = q; r = *p;
+    // s = &p; t = *s; w = &z; *t = w;
+    const std::vector< PointsToConstraint > constraints{
+        make_constraint(PointsToKind::AddressOf, "p", "x"),
+        make_constraint(PointsToKind::AddressOf, "q", "y"),
+        make_constraint(PointsToKind::Store, "p", "q"),
+        make_constraint(PointsToKind::Load, "r", "p"),
+        make_constraint(PointsToKind::AddressOf, "s", "p"),
+        make_constraint(PointsToKind::Load, "t", "s"),
+        make_constraint(PointsToKind::AddressOf, "w", "z"),
+        make_constraint(PointsToKind::Store, "t", "w"),
+    };
+    auto facts = PointsToFacts::solve(constraints, 1U);
+
+    EXPECT_EQ(std::vector< std::string >{"x"}, get_points_to(facts, "t"));
+    // The store through `t` is only known after the load of `s`, and
+    // reaches `r` through the load of `p` in a later round.
+    const std::vector< std::string > x_pointees{"y", "z"};
+    EXPECT_EQ(x_pointees, get_points_to(facts, "x"));
+    EXPECT_EQ(x_pointees, get_points_to(facts, "r"));
+    EXPECT_TRUE(facts.may_alias("r", "q"));
+    EXPECT_FALSE(facts.may_alias("r", "p"));
+}
+
+TEST(PointsToFacts, UnknownNodeMayAliasEverything) {
+    const std::vector< PointsToConstraint > constraints{
+        make_constraint(PointsToKind::AddressOf, "p", "x"),
+    };
+    auto facts = PointsToFacts::solve(constraints, 1U);
+
+    EXPECT_FALSE(facts.is_known("unknown"));
+    EXPECT_TRUE(facts.may_alias("unknown", "p"));
+    EXPECT_TRUE(facts.may_point_to("unknown", "x"));
+    EXPECT_TRUE(get_points_to(facts, "unknown").empty());
+}
+
+TEST(PointsToFacts, DeterministicAcrossJobs) {
+    // Enough nodes with loads or stores to split them over the threads.
+    constexpr unsigned NumPointers = 5000U;
+    constexpr unsigned NumObjects = 256U;
+    std::mt19937 rng(42U);
+    auto pointer = [&]() {
+        return "p" + std::to_string(rng() % NumPointers);
+    };
+    auto object = [&]() {
+        return "o" + std::to_string(rng() % NumObjects);
+    };
+
+    std::vector< PointsToConstraint > constraints;
+    for (unsigned idx = 0U; idx < NumPointers; ++idx) {
+        const auto node = "p" + std::to_string(idx);
+        constraints.push_back(
+            make_constraint(PointsToKind::AddressOf, node, object()));
+        if (idx % 2U == 0U) {
+            constraints.push_back(
+                make_constraint(PointsToKind::Load, pointer(), node));
+        } else {
+            constraints.push_back(
+                make_constraint(PointsToKind::Store, node, pointer()));
+        }
+        if (idx % 3U == 0U) {
+            constraints.push_back(
+                make_constraint(PointsToKind::Copy, pointer(), node));
+        }
+    }
+
+    auto sequential = PointsToFacts::solve(constraints, 1U);
+    for (const unsigned jobs : {2U, 4U, 0U}) {
+        auto parallel = PointsToFacts::solve(constraints, jobs);
+        ASSERT_EQ(sequential.size(), parallel.size());
+        for (unsigned idx = 0U; idx < NumPointers; ++idx) {
+            const auto node = "p" + std::to_string(idx);
+            EXPECT_EQ(get_points_to(sequential, node),
+                      get_points_to(parallel, node))
+                << node << " with " << jobs << " jobs";
+        }
+        for (unsigned idx = 0U; idx < NumObjects; ++idx) {
+            const auto node = "o" + std::to_string(idx);
+            EXPECT_EQ(get_points_to(sequential, node),
+                      get_points_to(parallel, node))
+                << node << " with " << jobs << " jobs";
+        }
+    }
+}
+
+TEST(PointsToFacts, HashOfTheSavedSets) {
+    // p = &x; $t = &y; q = $t; r = p;
+    std::vector< PointsToConstraint > constraints{
+        make_constraint(PointsToKind::AddressOf, "p", "x"),
+        make_constraint(PointsToKind::AddressOf, "$t", "y"),
+        make_constraint(PointsToKind::Copy, "q", "$t"),
+        make_constraint(PointsToKind::Copy, "r", "p"),
+    };
+    const auto hash = PointsToFacts::solve(constraints, 1U).get_hash();
+
+    // The order of the nodes does not matter.
+    std::vector< PointsToConstraint > reversed(constraints.rbegin(),
+                                               constraints.rend());
+    EXPECT_EQ(hash, PointsToFacts::solve(reversed, 1U).get_hash());
+
+    // Neither do the sets of the temporaries, which are not saved.
+    constraints.push_back(make_constraint(PointsToKind::AddressOf, "$t", "x"));
+    constraints.push_back(make_constraint(PointsToKind::AddressOf, "q", "x"));
+    auto with_temporary = PointsToFacts::solve(constraints, 1U);
+    constraints.pop_back();
+    constraints.pop_back();
+    constraints.push_back(make_constraint(PointsToKind::AddressOf, "q", "x"));
+    EXPECT_EQ(PointsToFacts::solve(constraints, 1U).get_hash(),
+              with_temporary.get_hash());
+
+    // A new points-to fact changes the hash.
+    EXPECT_NE(hash, with_temporary.get_hash());
+    EXPECT_NE(hash, PointsToFacts().get_hash());
+}
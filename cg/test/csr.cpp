@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+
+#include "cg/core/csr.hpp"
+
+using namespace knight::cg;
+
+#define GraphFile "knight_csr_graph"
+#define CorruptedFile "knight_csr_corrupted"
+
+std::vector< CallGraphNode > get_nodes() {
+    return {CallGraphNode(1U, 5U, "main", "main", "a.c"),
+            CallGraphNode(6U, 6U, "foo", "_Z3foov", "b.cpp")};
+}
+
+std::vector< CallSite > get_callsites() {
+    return {CallSite(4U, 5U, "main", "_Z3foov"),
+            CallSite(2U, 5U, "main", "_Z3foov"),
+            CallSite(7U, 3U, "_Z3foov", "_Z3barv"),
+            CallSite(3U, 5U, "main", "_Z3barv")};
+}
+
+std::string read_file(const char* path) {
+    std::ifstream is(path, std::ios::binary);
+    return {std::istreambuf_iterator< char >(is),
+            std::istreambuf_iterator< char >()};
+}
+
+void write_file(const char* path, const std::string& data) {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    os.write(data.data(), static_cast< std::streamsize >(data.size()));
+}
+
+template < typename T >
+T read_at(const std::string& data, uint64_t offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+template < typename T >
+void write_at(std::string& data, uint64_t offset, const T& value) {
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+/// \brief Write the graph, then check that the corrupted copy of its file
+/// is rejected.
+template < typename Corrupt >
+void expect_rejected(Corrupt corrupt) {
+    ASSERT_TRUE(write_csr_graph(get_nodes(), get_callsites(), GraphFile));
+    auto data = read_file(GraphFile);
+    ASSERT_NE(nullptr, CSRGraph::open(GraphFile));
+
+    auto header = read_at< csr::Header >(data, 0U);
+    corrupt(data, header);
+    write_file(CorruptedFile, data);
+    EXPECT_EQ(nullptr, CSRGraph::open(CorruptedFile));
+
+    (void)std::remove(GraphFile);
+    (void)std::remove(CorruptedFile);
+}
+
+TEST(CSRGraph, RoundTrip) {
+    ASSERT_TRUE(write_csr_graph(get_nodes(), get_callsites(), GraphFile));
+    auto graph = CSRGraph::open(GraphFile);
+    ASSERT_NE(nullptr, graph);
+    EXPECT_EQ(3U, graph->get_num_nodes());
+    EXPECT_EQ(4U, graph->get_num_edges());
+
+    // The nodes are sorted by their mangled names.
+    auto bar = graph->find("_Z3barv");
+    auto foo = graph->find("_Z3foov");
+    auto main_id = graph->find("main");
+    ASSERT_TRUE(bar && foo && main_id);
+    EXPECT_EQ(0U, *bar);
+    EXPECT_EQ(1U, *foo);
+    EXPECT_EQ(2U, *main_id);
+    EXPECT_FALSE(graph->find("_Z3bazv"));
+    EXPECT_FALSE(graph->find(""));
+    EXPECT_FALSE(graph->find("zzz"));
+
+    EXPECT_FALSE(graph->has_definition(*bar));
+    EXPECT_TRUE(graph->get_file(*bar).empty());
+    EXPECT_TRUE(graph->has_definition(*foo));
+    EXPECT_EQ("foo", graph->get_name(*foo));
+    EXPECT_EQ("_Z3foov", graph->get_mangled_name(*foo));
+    EXPECT_EQ("b.cpp", graph->get_file(*foo));
+    EXPECT_EQ(6U, graph->get_line(*foo));
+    EXPECT_EQ(6U, graph->get_col(*foo));
+    EXPECT_EQ("a.c", graph->get_file(*main_id));
+
+    // The callees are ordered by the locations of the call sites.
+    auto main_callees = graph->get_callees(*main_id);
+    ASSERT_EQ(3U, main_callees.size());
+    EXPECT_EQ(*foo, main_callees[0].node);
+    EXPECT_EQ(2U, main_callees[0].line);
+    EXPECT_EQ(*bar, main_callees[1].node);
+    EXPECT_EQ(3U, main_callees[1].line);
+    EXPECT_EQ(*foo, main_callees[2].node);
+    EXPECT_EQ(4U, main_callees[2].line);
+    EXPECT_EQ(5U, main_callees[2].col);
+    ASSERT_EQ(1U, graph->get_callees(*foo).size());
+    EXPECT_EQ(*bar, graph->get_callees(*foo)[0].node);
+    EXPECT_TRUE(graph->get_callees(*bar).empty());
+
+    // The callers are ordered by the callers.
+    auto bar_callers = graph->get_callers(*bar);
+    ASSERT_EQ(2U, bar_callers.size());
+    EXPECT_EQ(*foo, bar_callers[0].node);
+    EXPECT_EQ(7U, bar_callers[0].line);
+    EXPECT_EQ(3U, bar_callers[0].col);
+    EXPECT_EQ(*main_id, bar_callers[1].node);
+    ASSERT_EQ(2U, graph->get_callers(*foo).size());
+    EXPECT_TRUE(graph->get_callers(*main_id).empty());
+
+    // The file is replaced in place.
+    ASSERT_TRUE(write_csr_graph({}, {}, GraphFile));
+    auto empty = CSRGraph::open(GraphFile);
+    ASSERT_NE(nullptr, empty);
+    EXPECT_EQ(0U, empty->get_num_nodes());
+    EXPECT_EQ(0U, empty->get_num_edges());
+    EXPECT_FALSE(empty->find("main"));
+
+    (void)std::remove(GraphFile);
+}
+
+TEST(CSRGraph, RejectMissingFile) {
+    (void)std::remove(GraphFile);
+    EXPECT_EQ(nullptr, CSRGraph::open(GraphFile));
+}
+
+TEST(CSRGraph, RejectTruncatedFile) {
+    expect_rejected([](std::string& data, const csr::Header&) {
+        data.resize(sizeof(csr::Header) - 1U);
+    });
+    // The string pool is the last section.
+    expect_rejected(
+        [](std::string& data, const csr::Header&) { data.pop_back(); });
+}
+
+TEST(CSRGraph, RejectBadHeader) {
+    expect_rejected([](std::string& data, const csr::Header&) {
+        data[0] = 'X';
+    });
+    expect_rejected([](std::string& data, csr::Header header) {
+        ++header.version;
+        write_at(data, 0U, header);
+    });
+    // The sections are aligned.
+    expect_rejected([](std::string& data, csr::Header header) {
+        header.nodes_offset += 4U;
+        write_at(data, 0U, header);
+    });
+    expect_rejected([](std::string& data, csr::Header header) {
+        header.strings_offset = data.size() + csr::CSRAlignment;
+        write_at(data, 0U, header);
+    });
+    expect_rejected([](std::string& data, csr::Header header) {
+        ++header.num_edges;
+        write_at(data, 0U, header);
+    });
+    expect_rejected([](std::string& data, csr::Header header) {
+        header.num_nodes = ~0U;
+        write_at(data, 0U, header);
+    });
+}
+
+TEST(CSRGraph, RejectBadRows) {
+    // The callee offsets of `bar`, `foo` and `main` are 0, 0, 1 and 4.
+    expect_rejected([](std::string& data, const csr::Header& header) {
+        write_at< uint64_t >(data,
+                             header.callee_offsets_offset + sizeof(uint64_t),
+                             4U);
+    });
+    expect_rejected([](std::string& data, const csr::Header& header) {
+        write_at< uint64_t >(data, header.caller_offsets_offset, 1U);
+    });
+}
+
+TEST(CSRGraph, RejectBadEdgeTarget) {
+    expect_rejected([](std::string& data, const csr::Header& header) {
+        auto edge = read_at< csr::Edge >(data, header.callee_edges_offset);
+        edge.node = header.num_nodes;
+        write_at(data, header.callee_edges_offset, edge);
+    });
+    expect_rejected([](std::string& data, const csr::Header& header) {
+        const auto offset = header.caller_edges_offset +
+                            sizeof(csr::Edge) * (header.num_edges - 1U);
+        auto edge = read_at< csr::Edge >(data, offset);
+        edge.node = ~0U;
+        write_at(data, offset, edge);
+    });
+}
+
+TEST(CSRGraph, RejectBadString) {
+    expect_rejected([](std::string& data, const csr::Header& header) {
+        auto node = read_at< csr::Node >(data, header.nodes_offset);
+        node.mangled_name.offset =
+            static_cast< uint32_t >(header.strings_size);
+        write_at(data, header.nodes_offset, node);
+    });
+    expect_rejected([](std::string& data, const csr::Header& header) {
+        auto node = read_at< csr::Node >(data, header.nodes_offset);
+        node.file.size = ~0U;
+        write_at(data, header.nodes_offset, node);
+    });
+}
@@ -11,12 +11,17 @@
 //
 //===------------------------------------------------------------------===//
 
+#include "cg/core/andersen.hpp"
+#include "cg/db/db.hpp"
 #include "cg/tooling/cl_opts.hpp"
 #include "cg/tooling/driver.hpp"
+#include "common/util/compdb.hpp"
 #include "common/util/log.hpp"
+#include "common/util/progress.hpp"
+#include "common/util/shard.hpp"
+#include "common/util/tu_costs.hpp"
 #include "common/util/vfs.hpp"
 
-#include <clang/Tooling/CommonOptionsParser.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/InitLLVM.h>
 #include <llvm/Support/Process.h>
@@ -44,6 +49,7 @@ constexpr ErrCode VfsFileFailure = 3U;
 constexpr ErrCode NoInputFiles = 4U;
 constexpr ErrCode InputNotExists = 5U;
 constexpr ErrCode CompileErrorFound = 6U;
+constexpr ErrCode MergeFailure = 7U;
 
 llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem > get_vfs(
     ErrCode& code) {
@@ -77,6 +83,53 @@ bool ensure_input_files_exist(const std::vector< std::string >& files,
     });
 }
 
+/// \brief Keep the files of the `--shard`, taken from all the files of the
+/// compilation database if none is given, balanced by the cost model.
+bool select_shard_files(std::vector< std::string >& files,
+                        const CompilationDatabase& cdb,
+                        const fs::FileSystemRef& vfs,
+                        const TUCosts& costs) {
+    auto shard = shard::parse_shard(shard_spec);
+    if (!shard) {
+        llvm::WithColor::error() << "Invalid shard `" << shard_spec
+                                 << "`, expected `i/N` with 0 <= i < N.\n";
+        return false;
+    }
+    if (files.empty()) {
+        files = cdb.getAllFiles();
+    }
+    llvm::transform(files, files.begin(), fs::make_absolute);
+    auto estimates = costs.estimate(files, vfs);
+    llvm::StringMap< uint64_t > file_costs;
+    for (std::size_t idx = 0U; idx < files.size(); ++idx) {
+        file_costs[files[idx]] = estimates[idx];
+    }
+    files = shard::select_files(std::move(files),
+                                *shard,
+                                [&file_costs](const std::string& file) {
+                                    return file_costs.lookup(file);
+                                });
+    return true;
+}
+
+bool merge_databases() {
+    cg::Database db(knight_dir, static_cast< int >(db_busy_timeout));
+    bool is_merged = llvm::all_of(merge_db, [&db](const auto& file) {
+        bool res = db.merge(file);
+        if (!res) {
+            llvm::WithColor::error()
+                << "Cannot merge the call graph database `" << file << "`.\n";
+        }
+        return res;
+    });
+    // The points-to sets of the shards only cover their own units.
+    if (is_merged && points_to) {
+        cg::PointsToFacts::solve(db.get_all_points_to_constraints(), jobs)
+            .save(db);
+    }
+    return is_merged;
+}
+
 int main(int argc, const char** argv) {
     const llvm::InitLLVM llvm_setup(argc, argv);
     ErrCode code = NormalExit;
@@ -85,18 +138,25 @@ int main(int argc, const char** argv) {
         return code;
     }
 
-    auto opts_parser = CommonOptionsParser::create(argc,
-                                                   argv,
-                                                   knight_cg_category,
-                                                   cl::ZeroOrMore);
+    // The compilation database is loaded through its index in the knight
+    // directory.
+    auto opts_parser = compdb::OptionsParser::create(argc,
+                                                     argv,
+                                                     knight_cg_category,
+                                                     cl::ZeroOrMore,
+                                                     knight_dir);
 
     if (!opts_parser) {
         WithColor::error() << toString(opts_parser.takeError());
         return OptParseFailure;
     }
 
+    if (!merge_db.empty()) {
+        return merge_databases() ? NormalExit : MergeFailure;
+    }
+
     auto input_path = std::string("dummy");
-    auto src_path_lst = opts_parser->getSourcePathList();
+    auto src_path_lst = opts_parser->get_source_path_list();
     if (!src_path_lst.empty()) {
         input_path = fs::make_absolute(src_path_lst.front());
     }
@@ -105,6 +165,20 @@ int main(int argc, const char** argv) {
     llvm::InitializeAllTargetMCs();
     llvm::InitializeAllAsmParsers();
 
+    if (!shard_spec.empty()) {
+        const TUCosts costs(knight_dir, CGTUCostsFile);
+        if (!select_shard_files(src_path_lst,
+                                opts_parser->get_compilations(),
+                                base_vfs,
+                                costs)) {
+            return OptParseFailure;
+        }
+        if (src_path_lst.empty()) {
+            llvm::WithColor::note() << "No input files in the shard.\n";
+            return NormalExit;
+        }
+    }
+
     if (src_path_lst.empty()) {
         llvm::WithColor::error() << "No input files provided.\n\n";
         llvm::cl::PrintHelpMessage(false, true);
@@ -120,11 +194,26 @@ int main(int argc, const char** argv) {
                   skip_system_header,
                   skip_implicit_code,
                   base_vfs,
-                  &opts_parser->getCompilations(),
+                  &opts_parser->get_compilations(),
                   src_path_lst,
                   knight_dir, // NOLINT
                   db_busy_timeout);
+    if (!pch_header.empty()) {
+        ctx.pch_header = fs::make_absolute(pch_header);
+    }
+    if (!export_csr.empty()) {
+        ctx.csr_file = fs::make_absolute(export_csr);
+    }
+    ctx.jobs = jobs;
+    ctx.incremental = incremental;
+    ctx.in_memory_db = in_memory_db;
+    ctx.points_to = points_to;
+    ProgressReporter::get().start(quiet ? ProgressMode::Quiet
+                                        : progress.getValue(),
+                                  use_color,
+                                  src_path_lst.size());
     KnightCGBuilder builder(ctx);
     builder.build();
+    ProgressReporter::get().finish();
     return code;
 }
\ No newline at end of file
@@ -0,0 +1,14 @@
+find_package(benchmark REQUIRED)
+
+if(benchmark_FOUND)
+    set(BENCHMARK_LIBS benchmark::benchmark benchmark::benchmark_main)
+else()
+    message(FATAL_ERROR "Could not find Google Benchmark library")
+endif()
+
+function(add_benchmark target_name sources extra_libs)
+    add_executable(${target_name} ${sources})
+    target_link_libraries(${target_name} PRIVATE ${extra_libs} ${BENCHMARK_LIBS})
+    set_target_properties(${target_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY
+        "${CMAKE_BINARY_DIR}/bin")
+endfunction()
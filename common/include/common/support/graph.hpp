@@ -76,8 +76,29 @@ struct GraphTrait {
     static PredNodeIterator pred_end(NodeRef nodeRef) {
         return T::pred_end(nodeRef);
     }
+
+    // Optional dense node IDs, in `[0, num_nodes(graph))`.
+    static unsigned get_node_id(NodeRef nodeRef)
+        requires requires { T::get_node_id(nodeRef); }
+    {
+        return T::get_node_id(nodeRef);
+    }
+    static unsigned num_nodes(GraphRef graph)
+        requires requires { T::num_nodes(graph); }
+    {
+        return T::num_nodes(graph);
+    }
 }; // struct GraphTrait
 
+/// \brief Graph traits whose nodes have dense IDs, below
+/// `num_nodes(graph)`.
+template < typename GraphTrait >
+concept graph_with_node_id = requires(typename GraphTrait::GraphRef graph,
+                                      typename GraphTrait::NodeRef node) {
+    { GraphTrait::get_node_id(node) } -> std::convertible_to< unsigned >;
+    { GraphTrait::num_nodes(graph) } -> std::convertible_to< unsigned >;
+}; // concept graph_with_node_id
+
 template < typename T >
 struct isa_graph :                                      // NOLINT
                    std::bool_constant< graph< T > > {}; // struct isa_graph
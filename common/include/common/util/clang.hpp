@@ -17,6 +17,7 @@
 #include <string>
 
 #include <clang/AST/Decl.h>
+#include <clang/AST/Mangle.h>
 #include <clang/Basic/TargetInfo.h>
 
 #include "common/util/log.hpp"
@@ -28,4 +29,9 @@ std::string get_clang_include_dir();
 std::string get_mangled_name(const clang::NamedDecl* named_decl,
                              const clang::TargetInfo* target_info = nullptr);
 
+/// \brief Get the mangled name with the given mangle context, to be reused
+/// for all the decls of a translation unit.
+std::string get_mangled_name(const clang::NamedDecl* named_decl,
+                             clang::MangleContext& mangler);
+
 } // namespace knight::clang_util
\ No newline at end of file
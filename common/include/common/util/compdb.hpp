@@ -0,0 +1,133 @@
+//===- compdb.hpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the compilation database indexed in the knight
+//  directory, and the parser of the tool options loading it.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace knight::compdb {
+
+/// \brief The version of the layout of the index files.
+constexpr uint32_t IndexVersion = 1U;
+
+/// \brief The compile commands of a `compile_commands.json`, indexed once
+/// in a binary file of the cache directory, so that the later runs map the
+/// index instead of parsing the JSON, and only decode the commands of the
+/// files they look up.
+///
+/// The index is keyed by the modification time, the size and the content
+/// hash of the JSON: a touched but unchanged JSON is only hashed again,
+/// and a changed one is parsed and indexed again.
+///
+///   header:  "KCDB", version, mtime, size and hash of the JSON, number
+///            of files
+///   files:   offset and size of the path, offset and size of the block
+///            of its commands, sorted by the path
+///   data:    the paths, and the blocks of the commands, each command
+///            being the number of arguments, then the directory, the file,
+///            the output and the arguments, as sized strings
+///
+/// The integers are little-endian, the sizes and offsets 32-bit.
+class IndexedCompilationDatabase : public clang::tooling::CompilationDatabase {
+  private:
+    std::unique_ptr< llvm::MemoryBuffer > m_buffer;
+    uint32_t m_num_files = 0U;
+
+  public:
+    /// \brief Load the JSON database through its index in the cache
+    /// directory, indexing it first if missing or stale. The database is
+    /// wrapped as the JSON ones of clang, i.e., with the response files
+    /// expanded and the commands of the missing files inferred.
+    ///
+    /// \param cache_dir the directory of the index, empty to parse the
+    /// JSON without indexing it.
+    /// \return null if the JSON cannot be loaded, with the error message.
+    [[nodiscard]] static std::unique_ptr< clang::tooling::CompilationDatabase >
+    load(llvm::StringRef json_file,
+         llvm::StringRef cache_dir,
+         std::string& error_msg);
+
+    /// \brief Load the database of the directory or of its closest parent
+    /// having one, as `CompilationDatabase::autoDetectFromDirectory`, the
+    /// JSON ones being loaded through their index.
+    [[nodiscard]] static std::unique_ptr< clang::tooling::CompilationDatabase >
+    load_from_directory_tree(llvm::StringRef dir,
+                             llvm::StringRef cache_dir,
+                             std::string& error_msg);
+
+    [[nodiscard]] std::vector< clang::tooling::CompileCommand >
+    getCompileCommands(llvm::StringRef file) const override;
+    [[nodiscard]] std::vector< std::string > getAllFiles() const override;
+    [[nodiscard]] std::vector< clang::tooling::CompileCommand >
+    getAllCompileCommands() const override;
+
+  private:
+    explicit IndexedCompilationDatabase(
+        std::unique_ptr< llvm::MemoryBuffer > buffer, uint32_t num_files)
+        : m_buffer(std::move(buffer)), m_num_files(num_files) {}
+
+    [[nodiscard]] uint32_t read(uint64_t pos) const;
+    [[nodiscard]] llvm::StringRef get_file(uint32_t idx) const;
+    void decode_commands(
+        uint32_t idx,
+        std::vector< clang::tooling::CompileCommand >& commands) const;
+
+}; // class IndexedCompilationDatabase
+
+/// \brief The parser of the options of the tools, as the
+/// `CommonOptionsParser` of clang, but loading the JSON databases through
+/// their index in the given cache directory.
+///
+/// The database is loaded from `--` if given, else from the `-p` build
+/// path or from the directory of the first source, or of their closest
+/// parent having one. It is also loaded without a source if `-p` is
+/// given, e.g. to take all its files.
+class OptionsParser {
+  private:
+    std::unique_ptr< clang::tooling::CompilationDatabase > m_compilations;
+    std::vector< std::string > m_source_paths;
+
+  public:
+    /// \param cache_dir the option of the cache directory, e.g. the knight
+    /// directory, read once the command line is parsed.
+    [[nodiscard]] static llvm::Expected< OptionsParser > create(
+        int& argc,
+        const char** argv,
+        llvm::cl::OptionCategory& category,
+        llvm::cl::NumOccurrencesFlag occurrences,
+        const llvm::cl::opt< std::string >& cache_dir);
+
+    /// \brief Get the database, which exists if a source or a build path
+    /// is given.
+    [[nodiscard]] clang::tooling::CompilationDatabase& get_compilations() {
+        return *m_compilations;
+    }
+
+    [[nodiscard]] const std::vector< std::string >& get_source_path_list()
+        const {
+        return m_source_paths;
+    }
+
+}; // class OptionsParser
+
+} // namespace knight::compdb
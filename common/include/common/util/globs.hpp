@@ -13,35 +13,39 @@
 
 #pragma once
 
-#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
-#include <llvm/Support/Regex.h>
 
+#include <string>
 #include <vector>
 
 namespace knight {
 
-constexpr unsigned GlobAlignment = 32U;
-
 /// \brief A utility class for matching comma-separated
 /// strings against globs.
 ///
 /// negative glob starts with '-'
+///
+/// The globs are split into their literal parts around the `*` wildcards
+/// when constructed, and the matcher is immutable afterwards, so that it
+/// can be shared by concurrent workers without locks.
 class Globs {
   public:
-    struct alignas(GlobAlignment) Glob {
+    struct Glob {
         bool is_negative;
-        llvm::Regex regex;
+        /// \brief The literal parts separated by the `*` wildcards, at
+        /// least one, empty ones included.
+        std::vector< std::string > parts;
+
+        [[nodiscard]] bool matches(llvm::StringRef str) const;
     }; // struct Glob
 
   private:
     std::vector< Glob > m_globs;
-    mutable llvm::StringMap< bool > m_cache;
 
   public:
     explicit Globs(llvm::StringRef globs);
-    bool matches(llvm::StringRef str) const;
+    [[nodiscard]] bool matches(llvm::StringRef str) const;
 
 }; // class Globs
 
-} // namespace knight
\ No newline at end of file
+} // namespace knight
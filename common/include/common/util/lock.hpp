@@ -0,0 +1,47 @@
+//===- lock.hpp -------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines some locking related utilities.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>
+
+namespace knight {
+
+/// \brief A recursive mutex which is only locked in the concurrent mode,
+/// so that the single-threaded paths do not pay for the locking.
+///
+/// \note The mode shall only be switched when no other thread is using
+/// the mutex, e.g., before spawning the workers and after joining them.
+class OptionalMutex {
+  private:
+    std::recursive_mutex m_mutex;
+    bool m_is_concurrent = false;
+
+  public:
+    [[nodiscard]] bool is_concurrent() const { return m_is_concurrent; }
+    void set_concurrent(bool is_concurrent) { m_is_concurrent = is_concurrent; }
+
+    void lock() {
+        if (m_is_concurrent) {
+            m_mutex.lock();
+        }
+    }
+
+    void unlock() {
+        if (m_is_concurrent) {
+            m_mutex.unlock();
+        }
+    }
+}; // class OptionalMutex
+
+} // namespace knight
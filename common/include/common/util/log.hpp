@@ -33,6 +33,11 @@ inline void print_source_location(
     llvm::outs().resetColor();
 }
 
+/// The logs are only compiled in with `KNIGHT_ENABLE_LOGGING`. Otherwise
+/// they are discarded at compile time, though still type-checked so that
+/// they keep building, and the hot paths pay no runtime check for them.
+/// The `--trace` spans are the tracing meant for the production builds.
+#ifdef KNIGHT_ENABLE_LOGGING
 #define log_with_type(TYPE, PRINT_SRC, NEW_LINE, X)                      \
     do {                                                                 \
         using namespace llvm;                                            \
@@ -43,6 +48,15 @@ inline void print_source_location(
             { X; }                                                       \
         }                                                                \
     } while (false)
+#else
+#define log_with_type(TYPE, PRINT_SRC, NEW_LINE, X) \
+    do {                                            \
+        using namespace llvm;                       \
+        if constexpr (false) {                      \
+            { X; }                                  \
+        }                                           \
+    } while (false)
+#endif
 
 #define knight_log(X) log_with_type(DEBUG_TYPE, true, false, X)
 #define knight_log_nl(X) log_with_type(DEBUG_TYPE, true, true, X)
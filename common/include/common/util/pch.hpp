@@ -0,0 +1,42 @@
+//===- pch.hpp --------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the precompiled header reuse across TUs.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/util/vfs.hpp"
+
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+
+#include <string>
+#include <vector>
+
+namespace knight::pch {
+
+/// \brief Build a PCH of \p header for each group of the \p files sharing
+/// the same compile command, and get the arguments adjuster making each
+/// file use the PCH of its group through `-include-pch`.
+///
+/// The header is expected to be included first by the files, so that
+/// using its PCH does not change their meaning. Groups whose PCH fails to
+/// be built still parse the header from scratch.
+///
+/// \param output_dir the directory to store the built PCHs.
+clang::tooling::ArgumentsAdjuster build_pch_adjuster(
+    const clang::tooling::CompilationDatabase& cdb,
+    const std::vector< std::string >& files,
+    const std::string& header,
+    const std::string& output_dir,
+    const fs::OverlayFileSystemRef& base_fs);
+
+} // namespace knight::pch
@@ -0,0 +1,84 @@
+//===- perf_counters.hpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the hardware performance counters of a thread.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+
+#include <array>
+#include <cstdint>
+
+namespace knight {
+
+enum class PerfCounterKind { Instructions, Cycles, CacheMisses, BranchMisses };
+
+constexpr unsigned NumPerfCounterKinds = 4U;
+
+using PerfCounterValues = std::array< uint64_t, NumPerfCounterKinds >;
+
+/// \brief The hardware counters of the instructions, cycles, cache misses
+/// and branch misses of the calling thread, in the user space.
+///
+/// The counters are opened as one group by `perf_event_open`, so that they
+/// are scheduled together, and read by one system call. They are only
+/// available on linux, when allowed by `perf_event_paranoid`, and the
+/// counters the CPU lacks read as zero.
+///
+/// They are less noisy than the wall time on the shared hosts, e.g. to
+/// compare two data layouts of a domain.
+class PerfCounters {
+  private:
+    int m_group_fd = -1;
+    std::array< int, NumPerfCounterKinds > m_fds{};
+    /// \brief The index of each counter in the values read from the group,
+    /// -1 if the counter could not be opened.
+    std::array< int, NumPerfCounterKinds > m_indexes{};
+    unsigned m_num_opened = 0U;
+
+  public:
+    /// \brief Open and start the counters of the calling thread.
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters(PerfCounters&&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    PerfCounters& operator=(PerfCounters&&) = delete;
+
+  public:
+    /// \brief Get the counters of the calling thread, opened on its first
+    /// call.
+    [[nodiscard]] static PerfCounters& get_thread_counters();
+
+    [[nodiscard]] static llvm::StringRef get_name(PerfCounterKind kind);
+
+    /// \brief Whether any counter could be opened.
+    [[nodiscard]] bool is_available() const { return m_num_opened > 0U; }
+
+    /// \brief Read the counts since the counters were opened, zero for the
+    /// counters not available.
+    [[nodiscard]] PerfCounterValues read() const;
+
+}; // class PerfCounters
+
+/// \brief Get the counts from `start` to `end`.
+[[nodiscard]] inline PerfCounterValues operator-(
+    const PerfCounterValues& end, const PerfCounterValues& start) {
+    PerfCounterValues values{};
+    for (unsigned kind = 0U; kind < NumPerfCounterKinds; ++kind) {
+        values[kind] = end[kind] - start[kind];
+    }
+    return values;
+}
+
+} // namespace knight
@@ -0,0 +1,107 @@
+//===- progress.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the progress reporter of the knight tools.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace knight {
+
+enum class ProgressMode {
+    /// \brief List every processed function.
+    List,
+    /// \brief Refresh one status line with the throughput, the processed
+    /// TUs and the ETA.
+    Summary,
+    /// \brief Print nothing.
+    Quiet
+};
+
+/// \brief Process-wide reporter of the processed functions and TUs.
+///
+/// The output is held in a buffer written to the stdout at most once per
+/// refresh interval, or when the buffer is full, instead of one unbuffered
+/// write per function on a terminal.
+///
+/// \note The reporter is thread-safe.
+class ProgressReporter {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using NamePrinter = llvm::function_ref< void(llvm::raw_ostream&) >;
+
+    static constexpr std::chrono::milliseconds RefreshInterval{250};
+    static constexpr std::size_t MaxBufferSize = 64U * 1024U;
+
+  private:
+    mutable std::mutex m_mutex;
+    ProgressMode m_mode = ProgressMode::List;
+    bool m_use_color = false;
+    bool m_is_terminal = false;
+    std::size_t m_total_units = 0U;
+    std::size_t m_done_units = 0U;
+    uint64_t m_functions = 0U;
+    Clock::time_point m_start;
+    Clock::time_point m_last_flush;
+    std::string m_buffer;
+    llvm::raw_string_ostream m_os{m_buffer};
+
+  public:
+    /// \brief Get the process-wide reporter.
+    [[nodiscard]] static ProgressReporter& get();
+
+    /// \brief Reset the counters and start reporting `total_units` TUs.
+    void start(ProgressMode mode, bool use_color, std::size_t total_units);
+
+    [[nodiscard]] ProgressMode get_mode() const {
+        const std::lock_guard< std::mutex > lock(m_mutex);
+        return m_mode;
+    }
+
+    /// \brief Count a processed function without listing it.
+    void add_function();
+
+    /// \brief Count a processed function, listed with `color` and the
+    /// `note` suffix in the list mode.
+    ///
+    /// \param print_name only called if the function is listed.
+    void add_function(NamePrinter print_name,
+                      std::optional< llvm::raw_ostream::Colors > color,
+                      llvm::StringRef note = "");
+
+    /// \brief Count a processed TU.
+    void add_unit();
+
+    /// \brief Write the buffered output, e.g. before other writes to the
+    /// stdout which shall keep their order.
+    void flush();
+
+    /// \brief Print the final status and write the buffered output.
+    void finish();
+
+  private:
+    void print_status();
+    void flush_if_needed();
+    void write_buffer();
+
+}; // class ProgressReporter
+
+} // namespace knight
@@ -0,0 +1,47 @@
+//===- shard.hpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the sharding of the input files across the
+//  machines running the knight tools.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace knight::shard {
+
+struct Shard {
+    /// \brief In [0, count).
+    unsigned index = 0U;
+    unsigned count = 1U;
+}; // struct Shard
+
+using CostFn = llvm::function_ref< uint64_t(const std::string&) >;
+
+/// \brief Parse a shard given as `i/N`.
+[[nodiscard]] std::optional< Shard > parse_shard(llvm::StringRef spec);
+
+/// \brief Select the files of the shard.
+///
+/// The files are assigned from the most to the least costly one, each to
+/// the least loaded shard so far. The partition only depends on the set of
+/// the files and their costs, so every machine computes the same one from
+/// the same compilation database, whatever the order of the files.
+[[nodiscard]] std::vector< std::string > select_files(
+    std::vector< std::string > files, Shard shard, CostFn get_cost);
+
+} // namespace knight::shard
@@ -11,14 +11,22 @@
 //
 //===------------------------------------------------------------------===//
 
+#pragma once
+
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <iosfwd>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 
@@ -36,6 +44,8 @@ constexpr unsigned DBHeaderPaddingSize = 20U;
 
 class Database;
 class PreparedStmt;
+template < typename... Ts >
+class RowRange;
 using PreparedInternStmt = sqlite3_stmt;
 using PreparedInternStmtRef = std::shared_ptr< PreparedInternStmt >;
 
@@ -112,6 +122,44 @@ KNIGHT_API inline llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
 
 const char* column_type_str(knight::sqlite::ResColumn::ColumnKind type);
 
+namespace internal {
+
+template < typename T >
+constexpr bool IsColumnType =
+    std::is_same_v< T, int32_t > || std::is_same_v< T, int64_t > ||
+    std::is_same_v< T, double > || std::is_same_v< T, std::string_view > ||
+    std::is_same_v< T, std::string >;
+
+/// \brief Decode the column of the current row as `T`.
+///
+/// A `std::string_view` points into the row buffer of SQLite, and is only
+/// valid until the next step or reset of the statement. A NULL text is
+/// decoded as an empty one.
+template < typename T >
+[[nodiscard]] T decode_column(PreparedInternStmt* stmt, int idx) noexcept {
+    static_assert(IsColumnType< T >, "unsupported column type");
+    if constexpr (std::is_same_v< T, int32_t >) {
+        return sqlite3_column_int(stmt, idx);
+    } else if constexpr (std::is_same_v< T, int64_t >) {
+        return sqlite3_column_int64(stmt, idx);
+    } else if constexpr (std::is_same_v< T, double >) {
+        return sqlite3_column_double(stmt, idx);
+    } else if constexpr (std::is_same_v< T, std::string_view >) {
+        // The size shall be queried after the text is converted.
+        const auto* text =
+            reinterpret_cast< const char* >(sqlite3_column_text(stmt, idx));
+        if (text == nullptr) {
+            return {};
+        }
+        return {text,
+                static_cast< std::size_t >(sqlite3_column_bytes(stmt, idx))};
+    } else {
+        return std::string(decode_column< std::string_view >(stmt, idx));
+    }
+}
+
+} // namespace internal
+
 /// \brief SQLite prepared statement wrapper.
 class KNIGHT_API PreparedStmt {
   public:
@@ -168,6 +216,8 @@ class KNIGHT_API PreparedStmt {
     void bind_null(int idx);
     void bind_no_copy(int idx, const std::string& val);
     void bind_no_copy(int idx, std::string&& val) = delete;
+    /// \brief Bind the viewed text, which shall outlive the execution.
+    void bind_no_copy(int idx, std::string_view val);
     void bind_no_copy(int idx, const void* val, int size);
 
     void bind(const std::string& name, int32_t val) {
@@ -306,6 +356,38 @@ class KNIGHT_API PreparedStmt {
     ///
     [[nodiscard]] ResColumn get_column(const std::string& name) const;
 
+    ///
+    /// \brief Decode the current row into a tuple of the given column types,
+    /// among `int32_t`, `int64_t`, `double`, `std::string_view` and
+    /// `std::string`.
+    ///
+    ///  use after the execute_step() method returns true. The string views
+    /// are only valid until the next step or reset of the statement.
+    ///
+    /// \throw std::runtime_error if there is no row or too few columns.
+    ///
+    template < typename... Ts >
+    [[nodiscard]] std::tuple< Ts... > get_row() const {
+        validate_row_to_fetched();
+        validate_col_idx(static_cast< int >(sizeof...(Ts)) - 1);
+        return get_row< Ts... >(std::index_sequence_for< Ts... >{});
+    }
+
+    ///
+    /// \brief Iterate over the remaining rows of the statement, decoded as
+    /// by get_row().
+    ///
+    /// PreparedStmt stmt(db, "SELECT id, name FROM tableX");
+    /// for (auto [id, name] : stmt.rows< int64_t, std::string_view >()) {
+    ///     // ...
+    /// }
+    ///
+    /// No column object nor string is created for the string views, so a
+    /// bulk read does no allocation per row.
+    ///
+    template < typename... Ts >
+    [[nodiscard]] RowRange< Ts... > rows();
+
     template < typename Cols, int N >
     [[nodiscard]] Cols get_columns_as() {
         validate_row_to_fetched();
@@ -356,6 +438,9 @@ class KNIGHT_API PreparedStmt {
 
     mutable std::unordered_map< std::string, int > m_col_name_idx_cache;
 
+    /// \brief The indexes of the named parameters, resolved once.
+    mutable std::unordered_map< std::string, int > m_param_idx_cache;
+
   private:
     PreparedInternStmtRef get_prepare_intern_statement_ref();
     PreparedInternStmt* get_prepare_intern_statement() const;
@@ -371,8 +456,71 @@ class KNIGHT_API PreparedStmt {
         return T{ResColumn(m_prepared_intern_stmt, Is)...};
     }
 
+    template < typename... Ts, std::size_t... Is >
+    [[nodiscard]] std::tuple< Ts... > get_row(
+        std::index_sequence< Is... > /*indices*/) const {
+        auto* stmt = m_prepared_intern_stmt.get();
+        return std::tuple< Ts... >{
+            internal::decode_column< Ts >(stmt, static_cast< int >(Is))...};
+    }
+
 }; // class PreparedQueryStmt
 
+/// \brief An input range over the rows of a prepared statement, each
+/// decoded into a tuple of `Ts...` at dereference.
+///
+/// The first row is fetched by begin(), and every increment steps the
+/// statement, which invalidates the string views of the previous row.
+template < typename... Ts >
+class RowRange {
+  private:
+    PreparedStmt& m_stmt;
+
+  public:
+    class Iterator {
+      private:
+        /// \brief Null once the rows are exhausted.
+        PreparedStmt* m_stmt;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::tuple< Ts... >;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        explicit Iterator(PreparedStmt* stmt) : m_stmt(stmt) {}
+
+        [[nodiscard]] value_type operator*() const {
+            return m_stmt->get_row< Ts... >();
+        }
+
+        Iterator& operator++() {
+            if (!m_stmt->execute_step()) {
+                m_stmt = nullptr;
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool operator==(const Iterator& other) const {
+            return m_stmt == other.m_stmt;
+        }
+    }; // class Iterator
+
+  public:
+    explicit RowRange(PreparedStmt& stmt) : m_stmt(stmt) {}
+
+    [[nodiscard]] Iterator begin() {
+        return Iterator(m_stmt.execute_step() ? &m_stmt : nullptr);
+    }
+    [[nodiscard]] Iterator end() { return Iterator(nullptr); }
+}; // class RowRange
+
+template < typename... Ts >
+RowRange< Ts... > PreparedStmt::rows() {
+    return RowRange< Ts... >(*this);
+}
+
 enum class TransactionMode {
     DEFERRED,
     IMMEDIATE,
@@ -437,6 +585,39 @@ enum KNIGHT_API OpenMode : unsigned {
     // NOFOLLOW = SQLITE_OPEN_NOFOLLOW
 };
 
+/// \brief SQLite journal modes, see `PRAGMA journal_mode`.
+enum class JournalMode { Delete, Truncate, Persist, Memory, WAL, Off };
+
+/// \brief SQLite synchronous modes, see `PRAGMA synchronous`.
+enum class SyncMode { Off, Normal, Full, Extra };
+
+/// \brief The pragmas applied to a database connection once opened.
+///
+/// The unset ones are left to the SQLite defaults.
+struct KNIGHT_API OpenOptions {
+    std::optional< JournalMode > journal_mode;
+    std::optional< SyncMode > synchronous;
+    /// \brief The page cache size in KiB.
+    std::optional< int64_t > cache_size_kib;
+    /// \brief The maximum number of bytes memory-mapped for reading.
+    std::optional< int64_t > mmap_size;
+    /// \brief Whether to keep the temporary tables and indexes in memory.
+    bool temp_store_memory = false;
+
+    /// \brief Profile for writing a lot of rows into a regenerable
+    /// database: WAL without syncing, a large page cache and the
+    /// temporary data in memory.
+    [[nodiscard]] static OpenOptions bulk_load();
+
+    /// \brief Profile for a database mostly queried: WAL so that the
+    /// readers do not block the writer, and memory-mapped reads.
+    [[nodiscard]] static OpenOptions read_mostly();
+
+    /// \brief Profile for a read-only connection: memory-mapped reads and
+    /// a page cache, the journal mode being the one of the database.
+    [[nodiscard]] static OpenOptions read_only();
+}; // struct OpenOptions
+
 const char* get_lib_version() noexcept;
 int get_lib_version_number() noexcept;
 
@@ -534,6 +715,18 @@ class KNIGHT_API Database {
                       int busy_timeout_milliseconds = 0,
                       const std::string& vfs = "") noexcept(false);
 
+    ///
+    /// \brief Open the database and apply the given options.
+    ///
+    /// \throws std::runtime_error if error occurs during opening the
+    /// database or applying the options.
+    ///
+    Database(const std::string& file,
+             int flags,
+             int busy_timeout_milliseconds,
+             const OpenOptions& options,
+             const std::string& vfs = "") noexcept(false);
+
     Database(const Database&) = delete;
     Database& operator=(const Database&) = delete;
 
@@ -551,6 +744,13 @@ class KNIGHT_API Database {
     ///
     void set_busy_timeout(int milliseconds) const noexcept(false);
 
+    ///
+    /// \brief Apply the pragmas of the options to the connection.
+    ///
+    /// \throw std::runtime_error if a pragma fails.
+    ///
+    void apply_options(const OpenOptions& options) const noexcept(false);
+
     ///
     /// \brief execute one or multiple non-query statements.
     ///
@@ -653,6 +853,20 @@ class KNIGHT_API Database {
 
     [[nodiscard]] int get_total_dml_changes() const noexcept;
 
+    /// \brief Whether a transaction is open on the connection, i.e., it is
+    /// not in the autocommit mode.
+    [[nodiscard]] bool is_in_transaction() const noexcept;
+
+    /// \brief Copy the whole database into the given file, replacing its
+    /// content, by the online backup API.
+    ///
+    /// This is how a database built in memory is written to disk at once.
+    void backup_to(const std::string& file) const noexcept(false);
+
+    /// \brief Replace the content of the database by the one of the given
+    /// file, e.g. to load an existing database into memory.
+    void restore_from(const std::string& file) const noexcept(false);
+
     [[nodiscard]] DBHeader parse_header(const std::string& file) const
         noexcept(false);
 
@@ -679,6 +893,10 @@ class KNIGHT_API Database {
   private:
     void validate_return(int ret) const noexcept(false);
 
+    /// \brief Copy the main database of `src` into the one of `dst`.
+    static void copy(const Database& src, const Database& dst) noexcept(
+        false);
+
 }; // class Database
 
 } // namespace knight::sqlite
\ No newline at end of file
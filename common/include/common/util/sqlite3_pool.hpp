@@ -0,0 +1,118 @@
+//===- sqlite3_pool.hpp -----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the pool of read-only SQLite3 connections.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/util/export.hpp"
+#include "common/util/sqlite3.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace knight::sqlite {
+
+/// \brief A read-only connection of a pool, with the statements prepared
+/// on it.
+///
+/// A connection is only used by the thread leasing it, so it is opened
+/// without the SQLite mutexes and its statements are not guarded.
+class KNIGHT_API PooledConnection {
+  private:
+    Database m_db;
+    std::unordered_map< std::string, std::unique_ptr< PreparedStmt > >
+        m_stmts;
+
+  public:
+    PooledConnection(const std::string& file,
+                     int busy_timeout_milliseconds) noexcept(false);
+
+  public:
+    [[nodiscard]] Database& get_db() { return m_db; }
+
+    /// \brief Get the statement of the SQL, prepared on its first use,
+    /// reset and with its bindings cleared.
+    [[nodiscard]] PreparedStmt& get_stmt(const std::string& sql) noexcept(
+        false);
+}; // class PooledConnection
+
+/// \brief A pool of read-only connections to one database, for the
+/// queries of concurrent threads.
+///
+/// The connections are opened lazily up to the maximum size, and a thread
+/// waits for a released one beyond. The readers do not block each other
+/// nor the writer as long as the database is in the WAL journal mode.
+class KNIGHT_API ConnectionPool {
+  public:
+    /// \brief A connection leased to the current thread, given back to the
+    /// pool on destruction.
+    class KNIGHT_API Lease {
+      private:
+        ConnectionPool* m_pool;
+        std::unique_ptr< PooledConnection > m_conn;
+
+      public:
+        Lease(ConnectionPool& pool, std::unique_ptr< PooledConnection > conn)
+            : m_pool(&pool), m_conn(std::move(conn)) {}
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&&) noexcept = default;
+        Lease& operator=(Lease&&) = delete;
+
+        PooledConnection* operator->() const { return m_conn.get(); }
+        PooledConnection& operator*() const { return *m_conn; }
+    }; // class Lease
+
+  private:
+    std::string m_file;
+    std::size_t m_max_size;
+    int m_busy_timeout_milliseconds;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    /// \brief The released connections, the last released being reused
+    /// first for its statements.
+    std::vector< std::unique_ptr< PooledConnection > > m_idle;
+    std::size_t m_num_opened = 0U;
+
+  public:
+    /// \throw std::runtime_error if the database cannot be opened.
+    ConnectionPool(std::string file,
+                   std::size_t max_size,
+                   int busy_timeout_milliseconds = 0) noexcept(false);
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  public:
+    /// \brief Lease a connection, waiting if all of them are leased.
+    ///
+    /// \throw std::runtime_error if a new connection cannot be opened.
+    [[nodiscard]] Lease acquire() noexcept(false);
+
+    [[nodiscard]] const std::string& get_file() const { return m_file; }
+    [[nodiscard]] std::size_t get_max_size() const { return m_max_size; }
+
+  private:
+    void release(std::unique_ptr< PooledConnection > conn);
+
+}; // class ConnectionPool
+
+} // namespace knight::sqlite
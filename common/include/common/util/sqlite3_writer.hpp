@@ -0,0 +1,93 @@
+//===- sqlite3_writer.hpp ---------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the asynchronous writer of a SQLite3 database.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/util/export.hpp"
+#include "common/util/sqlite3.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace knight::sqlite {
+
+constexpr std::size_t DefaultWriterQueueCapacity = 64U;
+constexpr std::size_t DefaultWriterGroupSize = 16U;
+
+/// \brief A background thread serializing the writes to a connection.
+///
+/// The producers only enqueue their write jobs, and block when the queue
+/// is full so that the memory of the pending rows stays bounded. The
+/// writer thread commits the jobs queued meanwhile in one transaction, up
+/// to the group size, so that a commit is paid once per group instead of
+/// once per job.
+///
+/// The jobs run on the writer thread, which shall be the only user of the
+/// connection until finish(). They see the group transaction as already
+/// open, see Database::is_in_transaction().
+class KNIGHT_API AsyncWriter {
+  public:
+    using Job = std::function< void() >;
+
+  private:
+    Database& m_db;
+    std::size_t m_capacity;
+    std::size_t m_group_size;
+
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque< Job > m_queue;
+    bool m_is_finished = false;
+
+    /// \brief The first error of a job, rethrown by finish(). The groups
+    /// queued after it are dropped.
+    std::exception_ptr m_error;
+
+    std::thread m_thread;
+
+  public:
+    explicit AsyncWriter(Database& db,
+                         std::size_t capacity = DefaultWriterQueueCapacity,
+                         std::size_t group_size = DefaultWriterGroupSize);
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+    AsyncWriter(AsyncWriter&&) = delete;
+    AsyncWriter& operator=(AsyncWriter&&) = delete;
+
+  public:
+    /// \brief Enqueue a write job, waiting while the queue is full.
+    void push(Job job);
+
+    /// \brief Commit all the queued jobs and stop the writer thread.
+    ///
+    /// \throw the first error of the jobs, if any.
+    void finish() noexcept(false);
+
+  private:
+    void run();
+
+    /// \brief Run a group of jobs in one transaction.
+    void commit_group(std::vector< Job >& group);
+
+}; // class AsyncWriter
+
+} // namespace knight::sqlite
@@ -0,0 +1,77 @@
+//===- tu_costs.hpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This header defines the cost model of the translation units, used to
+//  schedule and shard them.
+//
+//===------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/util/vfs.hpp"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace knight {
+
+/// \brief The files of the recorded times, one per tool.
+/// @{
+constexpr llvm::StringRef AnalyzerTUCostsFile = "analyzer_tu_times.tsv";
+constexpr llvm::StringRef CGTUCostsFile = "cg_tu_times.tsv";
+/// @}
+
+/// \brief The processing times of the translation units recorded by the
+/// previous runs, in `<knight_dir>/<name>`.
+///
+/// A TU without a recorded time is estimated from its source size, scaled
+/// by the time per byte of the recorded TUs.
+///
+/// \note The recording is thread-safe.
+class TUCosts {
+  private:
+    std::string m_file;
+    mutable std::mutex m_mutex;
+    /// \brief The times in microseconds, keyed by the absolute paths.
+    llvm::StringMap< uint64_t > m_times;
+    bool m_is_changed = false;
+
+  public:
+    /// \brief Load the recorded times, none if `knight_dir` is empty or no
+    /// times were recorded yet.
+    TUCosts(llvm::StringRef knight_dir, llvm::StringRef name);
+
+    /// \brief Estimate the cost of each file, in microseconds.
+    [[nodiscard]] std::vector< uint64_t > estimate(
+        const std::vector< std::string >& files,
+        const fs::FileSystemRef& fs) const;
+
+    /// \brief The order processing the most costly files first, so that
+    /// no long TU starts last and leaves the other workers idle.
+    [[nodiscard]] std::vector< std::size_t > get_schedule(
+        const std::vector< std::string >& files,
+        const fs::FileSystemRef& fs) const;
+
+    void record(const std::string& file, std::chrono::microseconds time);
+
+    /// \brief Write the recorded times back if they changed.
+    ///
+    /// \returns false if the file cannot be written.
+    [[nodiscard]] bool save() const;
+
+}; // class TUCosts
+
+} // namespace knight
@@ -14,21 +14,104 @@
 #pragma once
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/VirtualFileSystem.h>
 
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <system_error>
+
 namespace knight::fs {
 
 using FileSystemRef = llvm::IntrusiveRefCntPtr< llvm::vfs::FileSystem >;
 using OverlayFileSystemRef =
     llvm::IntrusiveRefCntPtr< llvm::vfs::OverlayFileSystem >;
 
-/// \brief Create a new VFS overlay from a YAML file.
+/// \brief Process-wide cache of the stats and the contents of the files
+/// read through the knight file systems, keyed by their absolute paths.
+///
+/// The TUs, the PCH builds and the diagnostic reporter share it, so that a
+/// header included by every TU is only stat-ed and read once per run.
+///
+/// The contents are read without being marked volatile, so the large
+/// files are memory-mapped and their pages are shared with the page cache
+/// instead of being copied to the heap of every TU.
+///
+/// \note The cache is thread-safe. The contents are shared with the buffers
+/// handed out, so clearing the cache never invalidates them.
+class FileCache {
+  public:
+    struct Entry {
+        /// \brief The stat of the file, unset if the stat failed.
+        std::optional< llvm::vfs::Status > status;
+        std::error_code error;
+        /// \brief Null until the file is read.
+        std::shared_ptr< const llvm::MemoryBuffer > contents;
+    }; // struct Entry
+
+  private:
+    mutable std::shared_mutex m_mutex;
+    llvm::StringMap< Entry > m_entries;
+
+  public:
+    [[nodiscard]] static FileCache& get();
+
+    [[nodiscard]] std::optional< Entry > lookup(llvm::StringRef path) const;
+
+    void add_status(llvm::StringRef path,
+                    const llvm::ErrorOr< llvm::vfs::Status >& status);
+
+    /// \returns the contents kept by the cache, the ones of the first call
+    /// if several threads read the file concurrently.
+    std::shared_ptr< const llvm::MemoryBuffer > add_contents(
+        llvm::StringRef path,
+        const llvm::vfs::Status& status,
+        std::unique_ptr< llvm::MemoryBuffer > contents);
+
+    /// \brief Forget the files, e.g. once they may have been changed.
+    void clear();
+
+}; // class FileCache
+
+/// \brief File system serving the stats and the contents of the files of
+/// the underlying one from a `FileCache`.
+///
+/// The failed lookups are cached as well, as the header search probes
+/// every include directory for each include.
+class CachingFileSystem : public llvm::vfs::ProxyFileSystem {
+  private:
+    FileCache& m_cache;
+
+  public:
+    CachingFileSystem(FileSystemRef fs, FileCache& cache)
+        : ProxyFileSystem(std::move(fs)), m_cache(cache) {}
+
+    llvm::ErrorOr< llvm::vfs::Status > status(const llvm::Twine& path) override;
+
+    llvm::ErrorOr< std::unique_ptr< llvm::vfs::File > > openFileForRead(
+        const llvm::Twine& path) override;
+
+  private:
+    [[nodiscard]] std::string get_key(const llvm::Twine& path) const;
+
+}; // class CachingFileSystem
+
+/// \brief Create a new VFS overlay from a YAML file, whose redirected files
+/// are read through the `FileCache`.
 FileSystemRef get_vfs_from_yaml(const std::string& overlay_yaml_file,
                                 const FileSystemRef& base_fs);
 
-/// \brief Create a base VFS from RFS.
+/// \brief Create a base VFS from RFS, cached by the `FileCache`.
 OverlayFileSystemRef create_base_vfs();
 
+/// \brief Create a vfs with the same overlays as \p base_fs but backed by
+/// its own physical file system, so that changing the working directory
+/// does not affect the other threads. The file system shares the
+/// `FileCache` of the base one.
+OverlayFileSystemRef create_isolated_vfs(const OverlayFileSystemRef& base_fs);
+
 /// \brief Make path an absolute path.
 ///
 /// Makes path absolute using the current directory if it is not already. An
@@ -53,8 +53,13 @@ std::string get_mangled_name(const clang::NamedDecl* named_decl,
     auto& ast_ctx = named_decl->getASTContext();
     std::unique_ptr< clang::MangleContext > mangler;
     mangler.reset(ast_ctx.createMangleContext(target_info));
+    return get_mangled_name(named_decl, *mangler);
+}
 
-    if (!mangler->shouldMangleDeclName(named_decl)) {
+std::string get_mangled_name(const clang::NamedDecl* named_decl,
+                             clang::MangleContext& mangler) {
+    using namespace clang;
+    if (!mangler.shouldMangleDeclName(named_decl)) {
         return std::string(named_decl->getIdentifier()->getName());
     }
     SmallString< MangleBufSize > buffer;
@@ -71,7 +76,7 @@ std::string get_mangled_name(const clang::NamedDecl* named_decl,
     } else {
         global_decl = GlobalDecl(named_decl);
     }
-    mangler->mangleName(global_decl, os);
+    mangler.mangleName(global_decl, os);
 
     if (!buffer.empty() && buffer.front() == '\01') {
         return std::string(buffer.substr(1));
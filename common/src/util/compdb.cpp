@@ -0,0 +1,470 @@
+//===- compdb.cpp -----------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the compilation database indexed in the knight
+//  directory, and the parser of the tool options loading it.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/compdb.hpp"
+
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/JSONCompilationDatabase.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace knight::compdb {
+
+namespace {
+
+constexpr llvm::StringLiteral IndexMagic = "KCDB";
+constexpr llvm::StringLiteral JSONFileName = "compile_commands.json";
+constexpr uint64_t HeaderSize = 40U;
+constexpr uint64_t FileEntrySize = 16U;
+constexpr unsigned CompDBPathMaxLen = 256U;
+
+/// \brief The key of the JSON the index is built from.
+struct JSONKey {
+    uint64_t mtime = 0U;
+    uint64_t size = 0U;
+    uint64_t hash = 0U;
+}; // struct JSONKey
+
+void append_u32(std::string& buf, uint64_t value) {
+    char bytes[sizeof(uint32_t)];
+    llvm::support::endian::write32le(bytes, static_cast< uint32_t >(value));
+    buf.append(bytes, sizeof(bytes));
+}
+
+void append_u64(std::string& buf, uint64_t value) {
+    char bytes[sizeof(uint64_t)];
+    llvm::support::endian::write64le(bytes, value);
+    buf.append(bytes, sizeof(bytes));
+}
+
+void set_u32(std::string& buf, uint64_t pos, uint64_t value) {
+    llvm::support::endian::write32le(&buf[pos],
+                                     static_cast< uint32_t >(value));
+}
+
+void append_string(std::string& buf, llvm::StringRef str) {
+    append_u32(buf, str.size());
+    buf += str;
+}
+
+[[nodiscard]] uint64_t read_u64(llvm::StringRef bytes, uint64_t pos) {
+    if (pos + sizeof(uint64_t) > bytes.size()) {
+        return 0U;
+    }
+    return llvm::support::endian::read64le(bytes.data() + pos);
+}
+
+/// \brief Get the path of the index of the JSON in the cache directory,
+/// named after the hash of the absolute path of the JSON.
+[[nodiscard]] llvm::SmallString< CompDBPathMaxLen > get_index_path(
+    llvm::StringRef json_file, llvm::StringRef cache_dir) {
+    llvm::SmallString< CompDBPathMaxLen > json_path(json_file);
+    (void)llvm::sys::fs::make_absolute(json_path);
+    llvm::sys::path::remove_dots(json_path, /*remove_dot_dot=*/true);
+    llvm::SmallString< CompDBPathMaxLen > path(cache_dir);
+    llvm::sys::path::append(path,
+                            "compile_commands-" +
+                                llvm::utohexstr(llvm::xxHash64(json_path)) +
+                                ".idx");
+    return path;
+}
+
+/// \brief Serialize the index of the commands of the database.
+///
+/// \return an empty string if the index exceeds 4GB.
+[[nodiscard]] std::string build_index(
+    const clang::tooling::CompilationDatabase& json_db, const JSONKey& key) {
+    auto files = json_db.getAllFiles();
+    llvm::sort(files);
+
+    std::string index(IndexMagic);
+    append_u32(index, IndexVersion);
+    append_u64(index, key.mtime);
+    append_u64(index, key.size);
+    append_u64(index, key.hash);
+    append_u32(index, files.size());
+    append_u32(index, 0U);
+    const uint64_t base = HeaderSize + (files.size() * FileEntrySize);
+    index.resize(base);
+
+    std::string data;
+    for (const auto& [idx, file] : llvm::enumerate(files)) {
+        const auto entry = HeaderSize + (idx * FileEntrySize);
+        set_u32(index, entry, base + data.size());
+        set_u32(index, entry + 4U, file.size());
+        data += file;
+        const auto block = data.size();
+        for (const auto& command : json_db.getCompileCommands(file)) {
+            append_u32(data, command.CommandLine.size());
+            append_string(data, command.Directory);
+            append_string(data, command.Filename);
+            append_string(data, command.Output);
+            for (const auto& arg : command.CommandLine) {
+                append_string(data, arg);
+            }
+        }
+        set_u32(index, entry + 8U, base + block);
+        set_u32(index, entry + 12U, data.size() - block);
+    }
+    if (base + data.size() > std::numeric_limits< uint32_t >::max()) {
+        return {};
+    }
+    return index + data;
+}
+
+/// \brief Write the index at once, so that a concurrent run mapping the
+/// previous one is never torn.
+void write_index(llvm::StringRef path, llvm::StringRef index) {
+    if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(path))) {
+        return;
+    }
+    llvm::SmallString< CompDBPathMaxLen > tmp_path(path);
+    tmp_path += ".tmp";
+    {
+        std::error_code err;
+        llvm::raw_fd_ostream os(tmp_path, err, llvm::sys::fs::OF_None);
+        if (err) {
+            return;
+        }
+        os << index;
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            (void)llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    if (llvm::sys::fs::rename(tmp_path, path)) {
+        (void)llvm::sys::fs::remove(tmp_path);
+    }
+}
+
+/// \brief Wrap the database as the JSON plugin of clang does.
+[[nodiscard]] std::unique_ptr< clang::tooling::CompilationDatabase > wrap(
+    std::unique_ptr< clang::tooling::CompilationDatabase > db) {
+    return clang::tooling::inferTargetAndDriverMode(
+        clang::tooling::inferMissingCompileCommands(
+            clang::tooling::expandResponseFiles(std::move(db),
+                                                llvm::vfs::
+                                                    getRealFileSystem())));
+}
+
+} // anonymous namespace
+
+std::unique_ptr< clang::tooling::CompilationDatabase >
+IndexedCompilationDatabase::load(llvm::StringRef json_file,
+                                 llvm::StringRef cache_dir,
+                                 std::string& error_msg) {
+    using clang::tooling::JSONCommandLineSyntax;
+    using clang::tooling::JSONCompilationDatabase;
+    if (cache_dir.empty()) {
+        auto json_db =
+            JSONCompilationDatabase::loadFromFile(json_file,
+                                                  error_msg,
+                                                  JSONCommandLineSyntax::
+                                                      AutoDetect);
+        return json_db ? wrap(std::move(json_db)) : nullptr;
+    }
+
+    llvm::sys::fs::file_status status;
+    if (auto err = llvm::sys::fs::status(json_file, status)) {
+        error_msg = "cannot stat `" + json_file.str() + "`: " + err.message();
+        return nullptr;
+    }
+    JSONKey key;
+    key.mtime = static_cast< uint64_t >(
+        status.getLastModificationTime().time_since_epoch().count());
+    key.size = status.getSize();
+
+    const auto index_path = get_index_path(json_file, cache_dir);
+    auto index_or_err =
+        llvm::MemoryBuffer::getFile(index_path,
+                                    /*IsText=*/false,
+                                    /*RequiresNullTerminator=*/false);
+    std::unique_ptr< llvm::MemoryBuffer > index;
+    if (index_or_err) {
+        const auto bytes = (*index_or_err)->getBuffer();
+        if (bytes.size() >= HeaderSize && bytes.starts_with(IndexMagic) &&
+            llvm::support::endian::read32le(bytes.data() + 4U) ==
+                IndexVersion) {
+            index = std::move(*index_or_err);
+        }
+    }
+
+    // The modification time and the size only spare the hashing.
+    bool is_fresh = false;
+    if (index != nullptr) {
+        const auto bytes = index->getBuffer();
+        is_fresh = read_u64(bytes, 8U) == key.mtime &&
+                   read_u64(bytes, 16U) == key.size;
+    }
+    if (!is_fresh) {
+        auto json_or_err =
+            llvm::MemoryBuffer::getFile(json_file,
+                                        /*IsText=*/false,
+                                        /*RequiresNullTerminator=*/false);
+        if (!json_or_err) {
+            error_msg = "cannot read `" + json_file.str() +
+                        "`: " + json_or_err.getError().message();
+            return nullptr;
+        }
+        key.hash = llvm::xxHash64((*json_or_err)->getBuffer());
+        is_fresh = index != nullptr &&
+                   read_u64(index->getBuffer(), 24U) == key.hash;
+        if (is_fresh) {
+            // The JSON was only touched, so that the next runs need not
+            // hash it again.
+            std::string touched(index->getBuffer());
+            llvm::support::endian::write64le(&touched[8U], key.mtime);
+            write_index(index_path, touched);
+        }
+    }
+
+    if (!is_fresh) {
+        auto json_db =
+            JSONCompilationDatabase::loadFromFile(json_file,
+                                                  error_msg,
+                                                  JSONCommandLineSyntax::
+                                                      AutoDetect);
+        if (json_db == nullptr) {
+            return nullptr;
+        }
+        // This run uses the parsed database, the next ones the index.
+        if (auto built = build_index(*json_db, key); !built.empty()) {
+            write_index(index_path, built);
+        }
+        return wrap(std::move(json_db));
+    }
+
+    const auto bytes = index->getBuffer();
+    const auto num_files =
+        llvm::support::endian::read32le(bytes.data() + 32U);
+    if (HeaderSize + (static_cast< uint64_t >(num_files) * FileEntrySize) >
+        bytes.size()) {
+        error_msg = "malformed index `" + index_path.str().str() + "`";
+        return nullptr;
+    }
+    return wrap(std::unique_ptr< IndexedCompilationDatabase >(
+        new IndexedCompilationDatabase(std::move(index), num_files)));
+}
+
+std::unique_ptr< clang::tooling::CompilationDatabase >
+IndexedCompilationDatabase::load_from_directory_tree(
+    llvm::StringRef dir, llvm::StringRef cache_dir, std::string& error_msg) {
+    llvm::SmallString< CompDBPathMaxLen > abs_dir(dir);
+    (void)llvm::sys::fs::make_absolute(abs_dir);
+    llvm::sys::path::remove_dots(abs_dir, /*remove_dot_dot=*/true);
+
+    // The closest directory having a database wins, whichever its kind.
+    for (llvm::StringRef cur = abs_dir; !cur.empty();
+         cur = llvm::sys::path::parent_path(cur)) {
+        llvm::SmallString< CompDBPathMaxLen > json_file(cur);
+        llvm::sys::path::append(json_file, JSONFileName);
+        if (llvm::sys::fs::exists(json_file)) {
+            return load(json_file, cache_dir, error_msg);
+        }
+        std::string load_error;
+        if (auto db = clang::tooling::CompilationDatabase::loadFromDirectory(
+                cur, load_error)) {
+            return db;
+        }
+    }
+    error_msg = "No compilation database found in `" + abs_dir.str().str() +
+                "` or any parent directory";
+    return nullptr;
+}
+
+uint32_t IndexedCompilationDatabase::read(uint64_t pos) const {
+    const auto bytes = m_buffer->getBuffer();
+    if (pos + sizeof(uint32_t) > bytes.size()) {
+        return 0U;
+    }
+    return llvm::support::endian::read32le(bytes.data() + pos);
+}
+
+llvm::StringRef IndexedCompilationDatabase::get_file(uint32_t idx) const {
+    const auto entry = HeaderSize + (static_cast< uint64_t >(idx) *
+                                     FileEntrySize);
+    return m_buffer->getBuffer().substr(read(entry), read(entry + 4U));
+}
+
+void IndexedCompilationDatabase::decode_commands(
+    uint32_t idx,
+    std::vector< clang::tooling::CompileCommand >& commands) const {
+    const auto bytes = m_buffer->getBuffer();
+    const auto entry = HeaderSize + (static_cast< uint64_t >(idx) *
+                                     FileEntrySize);
+    uint64_t pos = read(entry + 8U);
+    const uint64_t end = std::min< uint64_t >(pos + read(entry + 12U),
+                                              bytes.size());
+    auto next_string = [&]() {
+        const auto size = read(pos);
+        auto str = bytes.substr(pos + sizeof(uint32_t), size);
+        pos += sizeof(uint32_t) + size;
+        return str;
+    };
+    while (pos < end) {
+        const auto num_args = read(pos);
+        pos += sizeof(uint32_t);
+        auto directory = next_string();
+        auto filename = next_string();
+        auto output = next_string();
+        std::vector< std::string > args;
+        for (uint32_t arg = 0U; arg < num_args && pos < end; ++arg) {
+            args.push_back(next_string().str());
+        }
+        commands.emplace_back(directory, filename, std::move(args), output);
+    }
+}
+
+std::vector< clang::tooling::CompileCommand >
+IndexedCompilationDatabase::getCompileCommands(llvm::StringRef file) const {
+    // The files are indexed by their native absolute paths.
+    llvm::SmallString< CompDBPathMaxLen > path(file);
+    (void)llvm::sys::fs::make_absolute(path);
+    llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+    llvm::sys::path::native(path);
+
+    uint32_t lo = 0U;
+    uint32_t hi = m_num_files;
+    while (lo < hi) {
+        const auto mid = lo + ((hi - lo) / 2U);
+        if (get_file(mid) < path.str()) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    std::vector< clang::tooling::CompileCommand > commands;
+    if (lo < m_num_files && get_file(lo) == path.str()) {
+        decode_commands(lo, commands);
+    }
+    return commands;
+}
+
+std::vector< std::string > IndexedCompilationDatabase::getAllFiles() const {
+    std::vector< std::string > files;
+    files.reserve(m_num_files);
+    for (uint32_t idx = 0U; idx < m_num_files; ++idx) {
+        files.push_back(get_file(idx).str());
+    }
+    return files;
+}
+
+std::vector< clang::tooling::CompileCommand >
+IndexedCompilationDatabase::getAllCompileCommands() const {
+    std::vector< clang::tooling::CompileCommand > commands;
+    for (uint32_t idx = 0U; idx < m_num_files; ++idx) {
+        decode_commands(idx, commands);
+    }
+    return commands;
+}
+
+llvm::Expected< OptionsParser > OptionsParser::create(
+    int& argc,
+    const char** argv,
+    llvm::cl::OptionCategory& category,
+    llvm::cl::NumOccurrencesFlag occurrences,
+    const llvm::cl::opt< std::string >& cache_dir) {
+    namespace cl = llvm::cl;
+    using namespace clang::tooling;
+
+    // The options of clang's parser, which is not used.
+    static cl::opt< std::string > build_path("p",
+                                             cl::desc("Build path"),
+                                             cl::Optional,
+                                             cl::cat(category));
+    static cl::list< std::string > source_paths(
+        cl::Positional,
+        cl::desc("<source0> [... <sourceN>]"),
+        occurrences,
+        cl::cat(category));
+    static cl::list< std::string > args_after(
+        "extra-arg",
+        cl::desc("Additional argument to append to the compiler command "
+                 "line"),
+        cl::cat(category));
+    static cl::list< std::string > args_before(
+        "extra-arg-before",
+        cl::desc("Additional argument to prepend to the compiler command "
+                 "line"),
+        cl::cat(category));
+
+    cl::ResetAllOptionOccurrences();
+    cl::HideUnrelatedOptions(category);
+
+    OptionsParser parser;
+    std::string error_msg;
+    parser.m_compilations =
+        FixedCompilationDatabase::loadFromCommandLine(argc, argv, error_msg);
+    if (!error_msg.empty()) {
+        error_msg.append("\n");
+    }
+    llvm::raw_string_ostream os(error_msg);
+    if (!cl::ParseCommandLineOptions(argc, argv, "", &os)) {
+        os.flush();
+        return llvm::make_error< llvm::StringError >(
+            error_msg, llvm::inconvertibleErrorCode());
+    }
+    cl::PrintOptionValues();
+
+    parser.m_source_paths = source_paths;
+    if ((occurrences == cl::ZeroOrMore || occurrences == cl::Optional) &&
+        parser.m_source_paths.empty() && build_path.empty() &&
+        parser.m_compilations == nullptr) {
+        return parser;
+    }
+    if (parser.m_compilations == nullptr) {
+        std::string load_error;
+        llvm::SmallString< CompDBPathMaxLen > dir(build_path.getValue());
+        if (dir.empty()) {
+            dir = parser.m_source_paths.front();
+            (void)llvm::sys::fs::make_absolute(dir);
+            llvm::sys::path::remove_filename(dir);
+        }
+        parser.m_compilations =
+            IndexedCompilationDatabase::load_from_directory_tree(
+                dir, cache_dir.getValue(), load_error);
+        if (parser.m_compilations == nullptr) {
+            llvm::errs() << "Error while trying to load a compilation "
+                            "database:\n"
+                         << load_error << "\nRunning without flags.\n";
+            parser.m_compilations =
+                std::make_unique< FixedCompilationDatabase >(
+                    ".", std::vector< std::string >());
+        }
+    }
+
+    auto adjusting = std::make_unique< ArgumentsAdjustingCompilations >(
+        std::move(parser.m_compilations));
+    adjusting->appendArgumentsAdjuster(combineAdjusters(
+        getInsertArgumentAdjuster(args_before,
+                                  ArgumentInsertPosition::BEGIN),
+        getInsertArgumentAdjuster(args_after, ArgumentInsertPosition::END)));
+    parser.m_compilations = std::move(adjusting);
+    return parser;
+}
+
+} // namespace knight::compdb
@@ -1,4 +1,4 @@
-//===- globs.hpp ------------------------------------------------------===//
+//===- globs.cpp ------------------------------------------------------===//
 //
 // Copyright (c) 2024 Junjie Shen
 //
@@ -14,60 +14,68 @@
 #include "common/util/globs.hpp"
 
 #include <llvm/ADT/STLExtras.h>
-#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
 
 namespace knight {
 
 namespace {
 
-constexpr unsigned GlobPatternMaxLen = 256U;
-
-llvm::Regex create_regex_for(llvm::StringRef Glob) {
-    llvm::SmallString< GlobPatternMaxLen > pattern("^");
-    for (const char c : Glob) {
-        if (c == '*') {
-            pattern.append(".*");
-        } else if (std::ispunct(c) != 0) {
-            pattern.append("\\");
-            pattern.push_back(c);
-        } else {
-            pattern.push_back(c);
-        }
+Globs::Glob compile_glob(bool is_negative, llvm::StringRef glob) {
+    Globs::Glob g{is_negative, {}};
+    llvm::SmallVector< llvm::StringRef, 4U > parts;
+    glob.split(parts, '*');
+    for (auto part : parts) {
+        g.parts.push_back(part.str());
     }
-
-    pattern.push_back('$');
-    return {pattern.str()};
+    return g;
 }
 
 } // anonymous namespace
 
+bool Globs::Glob::matches(llvm::StringRef str) const {
+    if (parts.size() == 1U) {
+        return str == parts.front();
+    }
+    // The first part is anchored at the start and the last one at the
+    // end, the middle ones are matched leftmost in between.
+    const auto& first = parts.front();
+    const auto& last = parts.back();
+    if (str.size() < first.size() + last.size() || !str.starts_with(first) ||
+        !str.ends_with(last)) {
+        return false;
+    }
+    str = str.drop_front(first.size()).drop_back(last.size());
+    for (const auto& part : llvm::drop_begin(parts)) {
+        if (&part == &last) {
+            break;
+        }
+        auto pos = str.find(part);
+        if (pos == llvm::StringRef::npos) {
+            return false;
+        }
+        str = str.drop_front(pos + part.size());
+    }
+    return true;
+}
+
 Globs::Globs(llvm::StringRef globs) {
     while (!globs.empty()) {
         const bool is_negative = globs.consume_front("-");
         auto current = globs.split(',').first.trim();
         if (!current.empty()) {
-            Glob g{is_negative, create_regex_for(current)};
-            m_globs.push_back(std::move(g));
+            m_globs.push_back(compile_glob(is_negative, current));
         }
         globs = globs.split(',').second;
     }
 }
 
 bool Globs::matches(llvm::StringRef str) const {
-    auto catch_it = m_cache.find(str);
-    if (catch_it != m_cache.end()) {
-        return catch_it->second;
-    }
-
-    bool res = false;
     for (const auto& g : llvm::reverse(m_globs)) {
-        if (g.regex.match(str)) {
-            res = !g.is_negative;
-            break;
+        if (g.matches(str)) {
+            return !g.is_negative;
         }
     }
-
-    return m_cache[str] = res;
+    return false;
 }
 
-} // namespace knight
\ No newline at end of file
+} // namespace knight
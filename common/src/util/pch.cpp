@@ -0,0 +1,167 @@
+//===- pch.cpp --------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the precompiled header reuse across TUs.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/pch.hpp"
+#include "common/util/log.hpp"
+
+#include <clang/Basic/FileManager.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Support/xxhash.h>
+
+#include <memory>
+
+#define DEBUG_TYPE "pch"
+
+namespace knight::pch {
+
+namespace {
+
+/// \brief Get the compile command of the file without the file itself and
+/// the output, which is shared by the TUs of a group.
+clang::tooling::CommandLineArguments get_group_arguments(
+    const clang::tooling::CompileCommand& cmd) {
+    auto args = clang::tooling::getClangStripOutputAdjuster()(cmd.CommandLine,
+                                                              cmd.Filename);
+    clang::tooling::CommandLineArguments group_args;
+    group_args.reserve(args.size());
+    for (auto& arg : args) {
+        if (arg == cmd.Filename || arg == "-c" || arg == "-fsyntax-only") {
+            continue;
+        }
+        group_args.push_back(std::move(arg));
+    }
+    return group_args;
+}
+
+std::string get_group_key(const clang::tooling::CompileCommand& cmd,
+                          const clang::tooling::CommandLineArguments& args) {
+    std::string key = cmd.Directory;
+    for (const auto& arg : args) {
+        key += '\0';
+        key += arg;
+    }
+    return key;
+}
+
+bool build_pch(const clang::tooling::CompileCommand& cmd,
+               clang::tooling::CommandLineArguments args,
+               const std::string& header,
+               const std::string& pch_file,
+               const fs::OverlayFileSystemRef& base_fs) {
+    const bool is_c = llvm::sys::path::extension(cmd.Filename) == ".c";
+    args.emplace_back("-x");
+    args.emplace_back(is_c ? "c-header" : "c++-header");
+    args.push_back(header);
+    args.emplace_back("-o");
+    args.push_back(pch_file);
+
+    auto vfs = fs::create_isolated_vfs(base_fs);
+    (void)vfs->setCurrentWorkingDirectory(cmd.Directory);
+    llvm::IntrusiveRefCntPtr< clang::FileManager >
+        file_mgr(new clang::FileManager(clang::FileSystemOptions(), vfs));
+
+    clang::tooling::ToolInvocation
+        invocation(std::move(args),
+                   std::make_unique< clang::GeneratePCHAction >(),
+                   file_mgr.get());
+    clang::IgnoringDiagConsumer diag_consumer;
+    invocation.setDiagnosticConsumer(&diag_consumer);
+    return invocation.run();
+}
+
+} // anonymous namespace
+
+clang::tooling::ArgumentsAdjuster build_pch_adjuster(
+    const clang::tooling::CompilationDatabase& cdb,
+    const std::vector< std::string >& files,
+    const std::string& header,
+    const std::string& output_dir,
+    const fs::OverlayFileSystemRef& base_fs) {
+    const std::string abs_header = fs::make_absolute(header);
+    if (auto ec = llvm::sys::fs::create_directories(output_dir)) {
+        llvm::WithColor::error() << "Failed to create the PCH directory `"
+                                 << output_dir << "`: " << ec.message()
+                                 << "\n";
+        return [](const clang::tooling::CommandLineArguments& args,
+                  llvm::StringRef /*file*/) { return args; };
+    }
+
+    // group key -> built pch file, empty if failed
+    llvm::StringMap< std::string > group_to_pch;
+    // file -> its pch file
+    auto file_to_pch = std::make_shared< llvm::StringMap< std::string > >();
+    for (const auto& file : files) {
+        auto cmds = cdb.getCompileCommands(file);
+        if (cmds.empty()) {
+            continue;
+        }
+        const auto& cmd = cmds.front();
+        auto group_args = get_group_arguments(cmd);
+        auto key = get_group_key(cmd, group_args);
+
+        auto [it, inserted] = group_to_pch.try_emplace(key);
+        if (inserted) {
+            llvm::SmallString< 128 > pch_file(output_dir); // NOLINT
+            llvm::sys::path::append(pch_file,
+                                    llvm::utohexstr(llvm::xxHash64(key)) +
+                                        ".pch");
+            if (build_pch(cmd,
+                          std::move(group_args),
+                          abs_header,
+                          pch_file.str().str(),
+                          base_fs)) {
+                it->second = pch_file.str().str();
+                knight_log_nl(llvm::outs() << "built pch " << it->second
+                                           << " for " << file << "\n";);
+            } else {
+                llvm::WithColor::warning()
+                    << "Failed to build the PCH of `" << header << "` for `"
+                    << file << "`, parse it from scratch instead.\n";
+            }
+        }
+        if (!it->second.empty()) {
+            // The tool adjusts the arguments with the file name recorded in
+            // the compile command, which may differ from the input path.
+            (*file_to_pch)[file] = it->second;
+            (*file_to_pch)[cmd.Filename] = it->second;
+        }
+    }
+
+    // The PCH files were just written, drop their stale stats.
+    fs::FileCache::get().clear();
+
+    return [file_to_pch](const clang::tooling::CommandLineArguments& args,
+                         llvm::StringRef file) {
+        auto it = file_to_pch->find(file);
+        if (it == file_to_pch->end() || args.empty()) {
+            return args;
+        }
+        clang::tooling::CommandLineArguments adjusted_args;
+        adjusted_args.reserve(args.size() + 2U);
+        adjusted_args.push_back(args.front());
+        adjusted_args.emplace_back("-include-pch");
+        adjusted_args.push_back(it->second);
+        adjusted_args.insert(adjusted_args.end(),
+                             std::next(args.begin()),
+                             args.end());
+        return adjusted_args;
+    };
+}
+
+} // namespace knight::pch
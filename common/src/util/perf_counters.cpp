@@ -0,0 +1,127 @@
+//===- perf_counters.cpp ----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the hardware performance counters of a thread.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/perf_counters.hpp"
+
+#ifdef __linux__
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace knight {
+
+namespace {
+
+#ifdef __linux__
+
+constexpr std::array< uint64_t, NumPerfCounterKinds > PerfEventConfigs{
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+/// \brief Open the counter of the calling thread, in the group of
+/// `group_fd` or as the leader of a new group if -1.
+int open_counter(uint64_t config, int group_fd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1U;
+    attr.exclude_hv = 1U;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // pid 0 and cpu -1 count the calling thread on any cpu.
+    return static_cast< int >(
+        syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0UL));
+}
+
+#endif
+
+} // anonymous namespace
+
+PerfCounters::PerfCounters() {
+    m_fds.fill(-1);
+    m_indexes.fill(-1);
+#ifdef __linux__
+    for (unsigned kind = 0U; kind < NumPerfCounterKinds; ++kind) {
+        const int fd = open_counter(PerfEventConfigs[kind], m_group_fd);
+        if (fd < 0) {
+            continue;
+        }
+        if (m_group_fd < 0) {
+            m_group_fd = fd;
+        }
+        m_fds[kind] = fd;
+        m_indexes[kind] = static_cast< int >(m_num_opened++);
+    }
+    if (m_group_fd >= 0) {
+        (void)ioctl(m_group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        (void)ioctl(m_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (const int fd : m_fds) {
+        if (fd >= 0) {
+            (void)close(fd);
+        }
+    }
+#endif
+}
+
+PerfCounters& PerfCounters::get_thread_counters() {
+    thread_local PerfCounters counters;
+    return counters;
+}
+
+llvm::StringRef PerfCounters::get_name(PerfCounterKind kind) {
+    switch (kind) {
+        case PerfCounterKind::Instructions:
+            return "instructions";
+        case PerfCounterKind::Cycles:
+            return "cycles";
+        case PerfCounterKind::CacheMisses:
+            return "cache_misses";
+        case PerfCounterKind::BranchMisses:
+            return "branch_misses";
+    }
+    return "";
+}
+
+PerfCounterValues PerfCounters::read() const {
+    PerfCounterValues values{};
+#ifdef __linux__
+    if (m_group_fd < 0) {
+        return values;
+    }
+    // The group reads as the number of counters followed by their values.
+    std::array< uint64_t, NumPerfCounterKinds + 1U > buf{};
+    const auto size = static_cast< ssize_t >(sizeof(uint64_t) *
+                                             (m_num_opened + 1U));
+    if (::read(m_group_fd, buf.data(), size) != size) {
+        return values;
+    }
+    for (unsigned kind = 0U; kind < NumPerfCounterKinds; ++kind) {
+        if (m_indexes[kind] >= 0) {
+            values[kind] = buf[static_cast< unsigned >(m_indexes[kind]) + 1U];
+        }
+    }
+#endif
+    return values;
+}
+
+} // namespace knight
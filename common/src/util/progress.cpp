@@ -0,0 +1,154 @@
+//===- progress.cpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the progress reporter of the knight tools.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/progress.hpp"
+
+#include <llvm/Support/Format.h>
+
+namespace knight {
+
+namespace {
+
+constexpr uint64_t SecondsPerMinute = 60U;
+constexpr uint64_t SecondsPerHour = 3600U;
+
+void print_duration(llvm::raw_ostream& os, uint64_t seconds) {
+    if (seconds >= SecondsPerHour) {
+        os << seconds / SecondsPerHour << "h";
+        seconds %= SecondsPerHour;
+    }
+    if (seconds >= SecondsPerMinute) {
+        os << seconds / SecondsPerMinute << "m";
+        seconds %= SecondsPerMinute;
+    }
+    os << seconds << "s";
+}
+
+} // anonymous namespace
+
+ProgressReporter& ProgressReporter::get() {
+    static ProgressReporter reporter;
+    return reporter;
+}
+
+void ProgressReporter::start(ProgressMode mode,
+                             bool use_color,
+                             std::size_t total_units) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    m_mode = mode;
+    m_use_color = use_color;
+    m_is_terminal = llvm::outs().is_displayed();
+    m_total_units = total_units;
+    m_done_units = 0U;
+    m_functions = 0U;
+    m_start = m_last_flush = Clock::now();
+    m_buffer.clear();
+    m_buffer.reserve(MaxBufferSize);
+    m_os.enable_colors(use_color);
+}
+
+void ProgressReporter::add_function() {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    ++m_functions;
+    flush_if_needed();
+}
+
+void ProgressReporter::add_function(
+    NamePrinter print_name,
+    std::optional< llvm::raw_ostream::Colors > color,
+    llvm::StringRef note) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    ++m_functions;
+    if (m_mode == ProgressMode::List) {
+        m_os << "[*] Processing function: ";
+        if (color) {
+            m_os.changeColor(*color);
+        }
+        print_name(m_os);
+        m_os.resetColor();
+        m_os << note << "\n";
+    }
+    flush_if_needed();
+}
+
+void ProgressReporter::add_unit() {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    ++m_done_units;
+    flush_if_needed();
+}
+
+void ProgressReporter::flush() {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    write_buffer();
+}
+
+void ProgressReporter::finish() {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    if (m_mode == ProgressMode::Summary) {
+        print_status();
+        if (m_is_terminal) {
+            m_os << "\n";
+        }
+    }
+    write_buffer();
+}
+
+void ProgressReporter::print_status() {
+    using namespace std::chrono;
+    auto elapsed = duration_cast< duration< double > >(Clock::now() - m_start)
+                       .count();
+    auto rate = elapsed > 0.0 ? static_cast< double >(m_functions) / elapsed
+                              : 0.0;
+
+    // Overwrite the status line in place on a terminal.
+    m_os << (m_is_terminal ? "\r" : "") << "[*] " << m_functions
+         << " functions (" << llvm::format("%.1f", rate) << "/s), "
+         << m_done_units << "/" << m_total_units << " TUs, ETA ";
+    if (m_done_units == 0U || m_done_units > m_total_units) {
+        m_os << "--";
+    } else {
+        auto remaining = elapsed *
+                         static_cast< double >(m_total_units - m_done_units) /
+                         static_cast< double >(m_done_units);
+        print_duration(m_os, static_cast< uint64_t >(remaining));
+    }
+    // Clear the rest of a longer previous status line.
+    m_os << (m_is_terminal ? "\x1b[K" : "\n");
+}
+
+void ProgressReporter::flush_if_needed() {
+    if (m_mode == ProgressMode::Quiet) {
+        return;
+    }
+    auto now = Clock::now();
+    if (m_buffer.size() < MaxBufferSize &&
+        now - m_last_flush < RefreshInterval) {
+        return;
+    }
+    if (m_mode == ProgressMode::Summary) {
+        print_status();
+    }
+    write_buffer();
+    m_last_flush = now;
+}
+
+void ProgressReporter::write_buffer() {
+    if (m_buffer.empty()) {
+        return;
+    }
+    llvm::outs() << m_buffer;
+    llvm::outs().flush();
+    m_buffer.clear();
+}
+
+} // namespace knight
@@ -0,0 +1,80 @@
+//===- shard.cpp ------------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the sharding of the input files.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/shard.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace knight::shard {
+
+std::optional< Shard > parse_shard(llvm::StringRef spec) {
+    auto [index, count] = spec.split('/');
+    Shard shard;
+    if (index.trim().getAsInteger(10, shard.index) ||
+        count.trim().getAsInteger(10, shard.count) || shard.count == 0U ||
+        shard.index >= shard.count) {
+        return std::nullopt;
+    }
+    return shard;
+}
+
+std::vector< std::string > select_files(std::vector< std::string > files,
+                                        Shard shard,
+                                        CostFn get_cost) {
+    llvm::sort(files);
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    if (shard.count == 1U) {
+        return files;
+    }
+
+    std::vector< std::pair< uint64_t, std::size_t > > costs;
+    costs.reserve(files.size());
+    for (std::size_t idx = 0U; idx < files.size(); ++idx) {
+        costs.emplace_back(get_cost(files[idx]), idx);
+    }
+    // The most costly first, the ties in the order of the paths.
+    llvm::sort(costs, [](const auto& lhs, const auto& rhs) {
+        return lhs.first != rhs.first ? lhs.first > rhs.first
+                                      : lhs.second < rhs.second;
+    });
+
+    // (load, shard), the least loaded then lowest shard on top.
+    using Load = std::pair< uint64_t, unsigned >;
+    std::priority_queue< Load, std::vector< Load >, std::greater<> > loads;
+    for (unsigned idx = 0U; idx < shard.count; ++idx) {
+        loads.emplace(0U, idx);
+    }
+    std::vector< bool > is_selected(files.size(), false);
+    for (const auto& [cost, file_idx] : costs) {
+        auto [load, shard_idx] = loads.top();
+        loads.pop();
+        is_selected[file_idx] = shard_idx == shard.index;
+        // Count the empty files too, so that they still spread.
+        loads.emplace(load + std::max< uint64_t >(cost, 1U), shard_idx);
+    }
+
+    std::vector< std::string > selected;
+    for (std::size_t idx = 0U; idx < files.size(); ++idx) {
+        if (is_selected[idx]) {
+            selected.push_back(std::move(files[idx]));
+        }
+    }
+    return selected;
+}
+
+} // namespace knight::shard
@@ -180,6 +180,81 @@ Database::Database(const std::string& file,
     }
 }
 
+Database::Database(const std::string& file,
+                   const int flags,
+                   const int busy_timeout_milliseconds,
+                   const OpenOptions& options,
+                   const std::string& vfs) noexcept(false)
+    : Database(file, flags, busy_timeout_milliseconds, vfs) {
+    apply_options(options);
+}
+
+OpenOptions OpenOptions::bulk_load() {
+    constexpr int64_t CacheSizeKiB = 256LL * 1024LL;
+    constexpr int64_t MmapSize = 1024LL * 1024LL * 1024LL;
+    OpenOptions options;
+    options.journal_mode = JournalMode::WAL;
+    options.synchronous = SyncMode::Off;
+    options.cache_size_kib = CacheSizeKiB;
+    options.mmap_size = MmapSize;
+    options.temp_store_memory = true;
+    return options;
+}
+
+OpenOptions OpenOptions::read_mostly() {
+    constexpr int64_t CacheSizeKiB = 64LL * 1024LL;
+    constexpr int64_t MmapSize = 1024LL * 1024LL * 1024LL;
+    OpenOptions options;
+    options.journal_mode = JournalMode::WAL;
+    options.synchronous = SyncMode::Normal;
+    options.cache_size_kib = CacheSizeKiB;
+    options.mmap_size = MmapSize;
+    return options;
+}
+
+OpenOptions OpenOptions::read_only() {
+    constexpr int64_t CacheSizeKiB = 16LL * 1024LL;
+    constexpr int64_t MmapSize = 1024LL * 1024LL * 1024LL;
+    OpenOptions options;
+    options.cache_size_kib = CacheSizeKiB;
+    options.mmap_size = MmapSize;
+    return options;
+}
+
+void Database::apply_options(const OpenOptions& options) const
+    noexcept(false) {
+    if (options.journal_mode) {
+        static constexpr std::array< const char*, 6U > JournalModeNames{
+            "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+        const auto mode = static_cast< std::size_t >(*options.journal_mode);
+        // The journal mode pragma returns the mode it switched to.
+        (void)exec_and_get_first(std::string("PRAGMA journal_mode = ") +
+                                 JournalModeNames[mode]);
+    }
+    if (options.synchronous) {
+        static constexpr std::array< const char*, 4U > SyncModeNames{"OFF",
+                                                                     "NORMAL",
+                                                                     "FULL",
+                                                                     "EXTRA"};
+        const auto mode = static_cast< std::size_t >(*options.synchronous);
+        (void)execute(std::string("PRAGMA synchronous = ") +
+                      SyncModeNames[mode]);
+    }
+    if (options.cache_size_kib) {
+        // A negative cache size is in KiB rather than in pages.
+        (void)execute("PRAGMA cache_size = -" +
+                      std::to_string(*options.cache_size_kib));
+    }
+    if (options.mmap_size) {
+        // The pragma returns no row on an in-memory database.
+        (void)execute("PRAGMA mmap_size = " +
+                      std::to_string(*options.mmap_size));
+    }
+    if (options.temp_store_memory) {
+        (void)execute("PRAGMA temp_store = MEMORY");
+    }
+}
+
 void Database::set_busy_timeout(const int milliseconds) const noexcept(false) {
     validate_return(sqlite3_busy_timeout(get_handle(), milliseconds));
 }
@@ -232,7 +307,8 @@ PreparedStmt::PreparedStmt(PreparedStmt&& aStatement) noexcept
       m_res_col_cnt(aStatement.m_res_col_cnt),
       m_row_to_fetched(aStatement.m_row_to_fetched),
       m_rows_done(aStatement.m_rows_done),
-      m_col_name_idx_cache(std::move(aStatement.m_col_name_idx_cache)) {
+      m_col_name_idx_cache(std::move(aStatement.m_col_name_idx_cache)),
+      m_param_idx_cache(std::move(aStatement.m_param_idx_cache)) {
     aStatement.m_handle = nullptr;
     aStatement.m_res_col_cnt = 0;
     aStatement.m_row_to_fetched = false;
@@ -287,8 +363,12 @@ void PreparedStmt::clear_bindings() {
 
 KNIGHT_PURE_FUNC
 int PreparedStmt::get_idx(const std::string& name) const {
-    return sqlite3_bind_parameter_index(get_prepare_intern_statement(),
-                                        name.c_str());
+    auto [it, inserted] = m_param_idx_cache.try_emplace(name, 0);
+    if (inserted) {
+        it->second = sqlite3_bind_parameter_index(
+            get_prepare_intern_statement(), name.c_str());
+    }
+    return it->second;
 }
 
 void PreparedStmt::bind(const int idx, const int32_t val) {
@@ -349,6 +429,14 @@ void PreparedStmt::bind_no_copy(const int idx, const std::string& val) {
                                       SQLITE_STATIC));
 }
 
+void PreparedStmt::bind_no_copy(const int idx, std::string_view val) {
+    validate_return(sqlite3_bind_text(get_prepare_intern_statement(),
+                                      idx,
+                                      val.data(),
+                                      static_cast< int >(val.size()),
+                                      SQLITE_STATIC));
+}
+
 void PreparedStmt::bind_no_copy(const int idx,
                                 const void* val,
                                 const int size) {
@@ -608,6 +696,37 @@ DBHeader Database::parse_header(const std::string& file) const noexcept(false) {
 }
 // NOLINTEND
 
+void Database::copy(const Database& src, const Database& dst) noexcept(
+    false) {
+    sqlite3_backup* backup =
+        sqlite3_backup_init(dst.get_handle(), "main", src.get_handle(), "main");
+    if (backup == nullptr) {
+        dst.validate_return(dst.get_error_code());
+    }
+    // Copy all the pages in one step, as no other connection writes the
+    // source meanwhile.
+    const int ret = sqlite3_backup_step(backup, -1);
+    const int finish_ret = sqlite3_backup_finish(backup);
+    if (ret != SQLITE_DONE) {
+        dst.validate_return(ret);
+    }
+    dst.validate_return(finish_ret);
+}
+
+void Database::backup_to(const std::string& file) const noexcept(false) {
+    const Database dst(file, OpenMode::READWRITE | OpenMode::CREATE);
+    copy(*this, dst);
+}
+
+void Database::restore_from(const std::string& file) const noexcept(false) {
+    const Database src(file, OpenMode::READONLY);
+    copy(src, *this);
+}
+
+bool Database::is_in_transaction() const noexcept {
+    return sqlite3_get_autocommit(get_handle()) == 0;
+}
+
 int Database::get_error_code() const noexcept {
     return sqlite3_errcode(get_handle());
 }
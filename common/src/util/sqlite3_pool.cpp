@@ -0,0 +1,93 @@
+//===- sqlite3_pool.cpp -----------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the pool of read-only SQLite3 connections.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/sqlite3_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace knight::sqlite {
+
+PooledConnection::PooledConnection(
+    const std::string& file, int busy_timeout_milliseconds) noexcept(false)
+    : m_db(file,
+           OpenMode::READONLY | OpenMode::NOMUTEX,
+           busy_timeout_milliseconds,
+           OpenOptions::read_only()) {}
+
+PreparedStmt& PooledConnection::get_stmt(const std::string& sql) noexcept(
+    false) {
+    auto& stmt = m_stmts[sql];
+    if (stmt == nullptr) {
+        stmt = std::make_unique< PreparedStmt >(m_db, sql);
+        return *stmt;
+    }
+    stmt->reset();
+    stmt->clear_bindings();
+    return *stmt;
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (m_conn != nullptr) {
+        m_pool->release(std::move(m_conn));
+    }
+}
+
+ConnectionPool::ConnectionPool(std::string file,
+                               std::size_t max_size,
+                               int busy_timeout_milliseconds) noexcept(false)
+    : m_file(std::move(file)),
+      m_max_size(std::max< std::size_t >(max_size, 1U)),
+      m_busy_timeout_milliseconds(busy_timeout_milliseconds) {
+    // Fail early if the database cannot be read.
+    m_idle.push_back(
+        std::make_unique< PooledConnection >(m_file,
+                                             m_busy_timeout_milliseconds));
+    m_num_opened = 1U;
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() noexcept(false) {
+    std::unique_lock< std::mutex > lock(m_mutex);
+    m_cv.wait(lock, [this]() {
+        return !m_idle.empty() || m_num_opened < m_max_size;
+    });
+    if (!m_idle.empty()) {
+        auto conn = std::move(m_idle.back());
+        m_idle.pop_back();
+        return {*this, std::move(conn)};
+    }
+    ++m_num_opened;
+    // The connection is opened out of the lock.
+    lock.unlock();
+    try {
+        return {*this,
+                std::make_unique< PooledConnection >(
+                    m_file, m_busy_timeout_milliseconds)};
+    } catch (...) {
+        lock.lock();
+        --m_num_opened;
+        lock.unlock();
+        m_cv.notify_one();
+        throw;
+    }
+}
+
+void ConnectionPool::release(std::unique_ptr< PooledConnection > conn) {
+    {
+        const std::lock_guard< std::mutex > lock(m_mutex);
+        m_idle.push_back(std::move(conn));
+    }
+    m_cv.notify_one();
+}
+
+} // namespace knight::sqlite
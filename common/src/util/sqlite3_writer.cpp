@@ -0,0 +1,101 @@
+//===- sqlite3_writer.cpp ---------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the asynchronous writer of a SQLite3 database.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/sqlite3_writer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace knight::sqlite {
+
+AsyncWriter::AsyncWriter(Database& db,
+                         std::size_t capacity,
+                         std::size_t group_size)
+    : m_db(db),
+      m_capacity(std::max< std::size_t >(capacity, 1U)),
+      m_group_size(std::max< std::size_t >(group_size, 1U)) {
+    m_thread = std::thread([this]() { run(); });
+}
+
+AsyncWriter::~AsyncWriter() {
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+void AsyncWriter::push(Job job) {
+    {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_not_full.wait(lock, [this]() {
+            return m_queue.size() < m_capacity;
+        });
+        m_queue.push_back(std::move(job));
+    }
+    m_not_empty.notify_one();
+}
+
+void AsyncWriter::finish() noexcept(false) {
+    if (m_thread.joinable()) {
+        {
+            const std::lock_guard< std::mutex > lock(m_mutex);
+            m_is_finished = true;
+        }
+        m_not_empty.notify_one();
+        m_thread.join();
+    }
+    if (m_error) {
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+}
+
+void AsyncWriter::run() {
+    std::vector< Job > group;
+    group.reserve(m_group_size);
+    std::unique_lock< std::mutex > lock(m_mutex);
+    while (true) {
+        m_not_empty.wait(lock, [this]() {
+            return m_is_finished || !m_queue.empty();
+        });
+        if (m_queue.empty()) {
+            break;
+        }
+        while (!m_queue.empty() && group.size() < m_group_size) {
+            group.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+        // The producers keep queueing while the group is written.
+        lock.unlock();
+        m_not_full.notify_all();
+        commit_group(group);
+        group.clear();
+        lock.lock();
+    }
+}
+
+void AsyncWriter::commit_group(std::vector< Job >& group) {
+    if (m_error) {
+        return;
+    }
+    try {
+        Transaction transaction(m_db);
+        for (auto& job : group) {
+            job();
+        }
+        transaction.commit();
+    } catch (...) {
+        m_error = std::current_exception();
+    }
+}
+
+} // namespace knight::sqlite
@@ -0,0 +1,144 @@
+//===- tu_costs.cpp ---------------------------------------------------===//
+//
+// Copyright (c) 2024 Junjie Shen
+//
+// see https://github.com/shenjunjiekoda/knight/blob/main/LICENSE for
+// license information.
+//
+//===------------------------------------------------------------------===//
+//
+//  This file implements the cost model of the translation units.
+//
+//===------------------------------------------------------------------===//
+
+#include "common/util/tu_costs.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace knight {
+
+TUCosts::TUCosts(llvm::StringRef knight_dir, llvm::StringRef name) {
+    if (knight_dir.empty()) {
+        return;
+    }
+    llvm::SmallString< 128 > file(knight_dir); // NOLINT
+    llvm::sys::path::append(file, name);
+    m_file = file.str().str();
+
+    // One `<microseconds>\t<path>` line per TU.
+    auto buffer = llvm::MemoryBuffer::getFile(m_file, /*IsText=*/true);
+    if (!buffer) {
+        return;
+    }
+    llvm::SmallVector< llvm::StringRef, 0U > lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (auto line : lines) {
+        auto [time, path] = line.split('\t');
+        uint64_t micros = 0U;
+        if (!path.empty() && !time.getAsInteger(10, micros)) {
+            m_times[path] = micros;
+        }
+    }
+}
+
+std::vector< uint64_t > TUCosts::estimate(
+    const std::vector< std::string >& files,
+    const fs::FileSystemRef& fs) const {
+    std::vector< uint64_t > costs(files.size(), 0U);
+    std::vector< uint64_t > sizes(files.size(), 0U);
+    uint64_t recorded_time = 0U;
+    uint64_t recorded_size = 0U;
+    {
+        const std::lock_guard< std::mutex > lock(m_mutex);
+        for (std::size_t idx = 0U; idx < files.size(); ++idx) {
+            auto status = fs->status(files[idx]);
+            sizes[idx] = status ? status->getSize() : 0U;
+            auto it = m_times.find(files[idx]);
+            if (it != m_times.end()) {
+                costs[idx] = it->second;
+                recorded_time += it->second;
+                recorded_size += sizes[idx];
+            }
+        }
+    }
+
+    for (std::size_t idx = 0U; idx < files.size(); ++idx) {
+        if (costs[idx] != 0U) {
+            continue;
+        }
+        // Without any recorded time, the sizes alone still rank the files.
+        costs[idx] = recorded_size == 0U
+                         ? sizes[idx]
+                         : static_cast< uint64_t >(
+                               static_cast< double >(sizes[idx]) *
+                               static_cast< double >(recorded_time) /
+                               static_cast< double >(recorded_size));
+    }
+    return costs;
+}
+
+std::vector< std::size_t > TUCosts::get_schedule(
+    const std::vector< std::string >& files,
+    const fs::FileSystemRef& fs) const {
+    auto costs = estimate(files, fs);
+    std::vector< std::size_t > order(files.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(),
+                     order.end(),
+                     [&costs](std::size_t lhs, std::size_t rhs) {
+                         return costs[lhs] > costs[rhs];
+                     });
+    return order;
+}
+
+void TUCosts::record(const std::string& file, std::chrono::microseconds time) {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    // Zero stands for no record.
+    m_times[file] = std::max< uint64_t >(time.count(), 1U);
+    m_is_changed = true;
+}
+
+bool TUCosts::save() const {
+    const std::lock_guard< std::mutex > lock(m_mutex);
+    if (m_file.empty() || !m_is_changed) {
+        return true;
+    }
+
+    std::vector< const llvm::StringMapEntry< uint64_t >* > entries;
+    entries.reserve(m_times.size());
+    for (const auto& entry : m_times) {
+        entries.push_back(&entry);
+    }
+    llvm::sort(entries, [](const auto* lhs, const auto* rhs) {
+        return lhs->getKey() < rhs->getKey();
+    });
+
+    auto tmp_file = m_file + ".tmp";
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(tmp_file, ec, llvm::sys::fs::OF_Text);
+        if (ec) {
+            return false;
+        }
+        for (const auto* entry : entries) {
+            os << entry->second << '\t' << entry->getKey() << '\n';
+        }
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            (void)llvm::sys::fs::remove(tmp_file);
+            return false;
+        }
+    }
+    return !llvm::sys::fs::rename(tmp_file, m_file);
+}
+
+} // namespace knight
@@ -13,16 +13,182 @@
 
 #include "common/util/vfs.hpp"
 
+#include <llvm/Support/Path.h>
 #include <llvm/Support/WithColor.h>
 
+#include <mutex>
+
 namespace knight::fs {
 
 namespace {
 
 constexpr unsigned PathMaxLen = 256U;
 
+/// \brief Buffer viewing the contents kept by the `FileCache`, under the
+/// name the file was opened with.
+class SharedMemoryBuffer final : public llvm::MemoryBuffer {
+  private:
+    std::shared_ptr< const llvm::MemoryBuffer > m_contents;
+    std::string m_name;
+
+  public:
+    SharedMemoryBuffer(std::shared_ptr< const llvm::MemoryBuffer > contents,
+                       llvm::StringRef name,
+                       bool requires_null_terminator)
+        : m_contents(std::move(contents)), m_name(name.str()) {
+        init(m_contents->getBufferStart(),
+             m_contents->getBufferEnd(),
+             requires_null_terminator);
+    }
+
+    [[nodiscard]] llvm::StringRef getBufferIdentifier() const override {
+        return m_name;
+    }
+
+    [[nodiscard]] BufferKind getBufferKind() const override {
+        return m_contents->getBufferKind();
+    }
+}; // class SharedMemoryBuffer
+
+class CachedFile final : public llvm::vfs::File {
+  private:
+    llvm::vfs::Status m_status;
+    std::shared_ptr< const llvm::MemoryBuffer > m_contents;
+
+  public:
+    CachedFile(llvm::vfs::Status status,
+               std::shared_ptr< const llvm::MemoryBuffer > contents)
+        : m_status(std::move(status)), m_contents(std::move(contents)) {}
+
+    llvm::ErrorOr< llvm::vfs::Status > status() override { return m_status; }
+
+    llvm::ErrorOr< std::unique_ptr< llvm::MemoryBuffer > > getBuffer(
+        const llvm::Twine& name,
+        int64_t /*file_size*/,
+        bool requires_null_terminator,
+        bool /*is_volatile*/) override {
+        return std::make_unique< SharedMemoryBuffer >(m_contents,
+                                                      name.str(),
+                                                      requires_null_terminator);
+    }
+
+    std::error_code close() override { return {}; }
+}; // class CachedFile
+
 } // anonymous namespace
 
+FileCache& FileCache::get() {
+    static FileCache cache;
+    return cache;
+}
+
+std::optional< FileCache::Entry > FileCache::lookup(
+    llvm::StringRef path) const {
+    std::shared_lock< std::shared_mutex > lock(m_mutex);
+    auto it = m_entries.find(path);
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void FileCache::add_status(llvm::StringRef path,
+                           const llvm::ErrorOr< llvm::vfs::Status >& status) {
+    std::unique_lock< std::shared_mutex > lock(m_mutex);
+    auto& entry = m_entries[path];
+    if (entry.contents != nullptr) {
+        return;
+    }
+    if (status) {
+        entry.status = *status;
+        entry.error = {};
+    } else {
+        entry.status = std::nullopt;
+        entry.error = status.getError();
+    }
+}
+
+std::shared_ptr< const llvm::MemoryBuffer > FileCache::add_contents(
+    llvm::StringRef path,
+    const llvm::vfs::Status& status,
+    std::unique_ptr< llvm::MemoryBuffer > contents) {
+    std::unique_lock< std::shared_mutex > lock(m_mutex);
+    auto& entry = m_entries[path];
+    if (entry.contents == nullptr) {
+        entry.status = status;
+        entry.error = {};
+        entry.contents = std::move(contents);
+    }
+    return entry.contents;
+}
+
+void FileCache::clear() {
+    std::unique_lock< std::shared_mutex > lock(m_mutex);
+    m_entries.clear();
+}
+
+std::string CachingFileSystem::get_key(const llvm::Twine& path) const {
+    llvm::SmallString< PathMaxLen > key;
+    path.toVector(key);
+    (void)makeAbsolute(key);
+    llvm::sys::path::remove_dots(key, /*remove_dot_dot=*/false);
+    return key.str().str();
+}
+
+llvm::ErrorOr< llvm::vfs::Status > CachingFileSystem::status(
+    const llvm::Twine& path) {
+    auto key = get_key(path);
+    if (auto entry = m_cache.lookup(key)) {
+        if (!entry->status) {
+            return entry->error;
+        }
+        return llvm::vfs::Status::copyWithNewName(*entry->status, path);
+    }
+    auto status = getUnderlyingFS().status(path);
+    m_cache.add_status(key, status);
+    return status;
+}
+
+llvm::ErrorOr< std::unique_ptr< llvm::vfs::File > > CachingFileSystem::
+    openFileForRead(const llvm::Twine& path) {
+    auto key = get_key(path);
+    auto entry = m_cache.lookup(key);
+    if (entry && !entry->status) {
+        return entry->error;
+    }
+    if (entry && entry->contents != nullptr) {
+        return std::make_unique< CachedFile >(
+            llvm::vfs::Status::copyWithNewName(*entry->status, path),
+            entry->contents);
+    }
+
+    auto file = getUnderlyingFS().openFileForRead(path);
+    if (!file) {
+        // Other errors, e.g. opening a directory, say nothing of the stat.
+        if (file.getError() == std::errc::no_such_file_or_directory) {
+            m_cache.add_status(key, file.getError());
+        }
+        return file.getError();
+    }
+    auto status = (*file)->status();
+    if (!status) {
+        return status.getError();
+    }
+    // Not volatile, so that the large files are memory-mapped rather than
+    // copied to the heap, and shared by all the TUs and the reporter.
+    auto buffer = (*file)->getBuffer(path,
+                                     static_cast< int64_t >(status->getSize()),
+                                     /*RequiresNullTerminator=*/true,
+                                     /*IsVolatile=*/false);
+    (void)(*file)->close();
+    if (!buffer) {
+        return buffer.getError();
+    }
+    auto contents = m_cache.add_contents(key, *status, std::move(*buffer));
+    return std::make_unique< CachedFile >(std::move(*status),
+                                          std::move(contents));
+}
+
 FileSystemRef get_vfs_from_yaml(const std::string& overlay_yaml_file,
                                 const FileSystemRef& base_fs) {
     auto buffer = base_fs->getBufferForFile(overlay_yaml_file);
@@ -34,9 +200,16 @@ FileSystemRef get_vfs_from_yaml(const std::string& overlay_yaml_file,
         return nullptr;
     }
 
+    // Read the redirected files through the cache as well, instead of the
+    // default real file system.
+    FileSystemRef external_fs(
+        new CachingFileSystem(llvm::vfs::getRealFileSystem(),
+                              FileCache::get()));
     FileSystemRef fs = llvm::vfs::getVFSFromYAML(std::move(buffer.get()),
                                                  nullptr,
-                                                 overlay_yaml_file);
+                                                 overlay_yaml_file,
+                                                 nullptr,
+                                                 std::move(external_fs));
     if (!fs) {
         llvm::WithColor::error()
             << "Yaml error: invalid virtual filesystem overlay file '"
@@ -47,7 +220,27 @@ FileSystemRef get_vfs_from_yaml(const std::string& overlay_yaml_file,
 }
 
 OverlayFileSystemRef create_base_vfs() {
-    return {new llvm::vfs::OverlayFileSystem(llvm::vfs::getRealFileSystem())};
+    FileSystemRef real_fs(new CachingFileSystem(llvm::vfs::getRealFileSystem(),
+                                                FileCache::get()));
+    return {new llvm::vfs::OverlayFileSystem(std::move(real_fs))};
+}
+
+OverlayFileSystemRef create_isolated_vfs(const OverlayFileSystemRef& base_fs) {
+    FileSystemRef physical_fs(
+        new CachingFileSystem(llvm::vfs::createPhysicalFileSystem(),
+                              FileCache::get()));
+    OverlayFileSystemRef fs(
+        new llvm::vfs::OverlayFileSystem(std::move(physical_fs)));
+    auto it = base_fs->overlays_rbegin();
+    if (it == base_fs->overlays_rend()) {
+        return fs;
+    }
+    // Skip the bottom real file system, whose working directory is the
+    // process-wide one.
+    for (++it; it != base_fs->overlays_rend(); ++it) {
+        fs->pushOverlay(*it);
+    }
+    return fs;
 }
 
 std::string make_absolute(llvm::StringRef file) {
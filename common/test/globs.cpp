@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <llvm/ADT/StringRef.h>
+
+#include "common/util/globs.hpp"
+
+using namespace knight;
+
+namespace {
+
+bool matches(llvm::StringRef glob, llvm::StringRef str) {
+    return Globs(glob).matches(str);
+}
+
+} // anonymous namespace
+
+TEST(Globs, Literal) {
+    EXPECT_TRUE(matches("core-dump", "core-dump"));
+    EXPECT_FALSE(matches("core-dump", "core-dum"));
+    EXPECT_FALSE(matches("core-dump", "core-dumps"));
+    EXPECT_FALSE(matches("core-dump", ""));
+    // The punctuation is literal.
+    EXPECT_TRUE(matches("a.b", "a.b"));
+    EXPECT_FALSE(matches("a.b", "axb"));
+    EXPECT_FALSE(matches("a?", "ab"));
+}
+
+TEST(Globs, LeadingStar) {
+    EXPECT_TRUE(matches("*-dump", "core-dump"));
+    EXPECT_TRUE(matches("*-dump", "-dump"));
+    EXPECT_FALSE(matches("*-dump", "core-dumps"));
+    EXPECT_FALSE(matches("*-dump", "dump"));
+}
+
+TEST(Globs, TrailingStar) {
+    EXPECT_TRUE(matches("core-*", "core-dump"));
+    EXPECT_TRUE(matches("core-*", "core-"));
+    EXPECT_FALSE(matches("core-*", "core"));
+    EXPECT_FALSE(matches("core-*", "xcore-dump"));
+}
+
+TEST(Globs, OnlyStars) {
+    EXPECT_TRUE(matches("*", ""));
+    EXPECT_TRUE(matches("*", "anything"));
+    EXPECT_TRUE(matches("**", ""));
+    EXPECT_TRUE(matches("***", "anything"));
+}
+
+TEST(Globs, MultipleStars) {
+    EXPECT_TRUE(matches("a*b*c", "abc"));
+    EXPECT_TRUE(matches("a*b*c", "aXbYc"));
+    EXPECT_TRUE(matches("a*b*c", "abbbc"));
+    EXPECT_FALSE(matches("a*b*c", "acb"));
+    EXPECT_FALSE(matches("a*b*c", "aXc"));
+    EXPECT_TRUE(matches("*a*b*", "xaybz"));
+    EXPECT_FALSE(matches("*a*b*", "xbyaz"));
+    // The middle parts are matched leftmost, without backtracking.
+    EXPECT_TRUE(matches("a*bc*bc", "abcbc"));
+    EXPECT_TRUE(matches("a*bc*bc", "abcXbcbc"));
+    EXPECT_FALSE(matches("a*bc*bc", "abc"));
+}
+
+TEST(Globs, AdjacentStars) {
+    EXPECT_TRUE(matches("a**b", "ab"));
+    EXPECT_TRUE(matches("a**b", "aXYb"));
+    EXPECT_FALSE(matches("a**b", "aXY"));
+    EXPECT_TRUE(matches("**a**", "a"));
+    EXPECT_FALSE(matches("**a**", "b"));
+}
+
+TEST(Globs, PartsDoNotOverlap) {
+    // The prefix and the suffix cannot share characters.
+    EXPECT_FALSE(matches("ab*ba", "aba"));
+    EXPECT_TRUE(matches("ab*ba", "abba"));
+    EXPECT_FALSE(matches("a*a", "a"));
+    EXPECT_TRUE(matches("a*a", "aa"));
+    EXPECT_FALSE(matches("a*b*b", "ab"));
+}
+
+TEST(Globs, LastMatchingGlobWins) {
+    const Globs globs("core-*,-core-dump, unix-* ,-*-debug");
+    EXPECT_TRUE(globs.matches("core-null"));
+    EXPECT_FALSE(globs.matches("core-dump"));
+    EXPECT_TRUE(globs.matches("unix-stream"));
+    EXPECT_FALSE(globs.matches("unix-debug"));
+    EXPECT_FALSE(globs.matches("debug"));
+
+    EXPECT_TRUE(Globs("-*,core-dump").matches("core-dump"));
+    EXPECT_FALSE(Globs("core-dump,-*").matches("core-dump"));
+    // No glob matches nothing.
+    EXPECT_FALSE(Globs("").matches("core-dump"));
+    EXPECT_FALSE(Globs(",,").matches(""));
+}
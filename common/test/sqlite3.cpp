@@ -3,10 +3,13 @@
 #include <cstdint>
 #include <cstdio>
 #include <stdexcept>
+#include <string_view>
 
 #include <llvm/ADT/StringRef.h>
 
 #include "common/util/sqlite3.hpp"
+#include "common/util/sqlite3_pool.hpp"
+#include "common/util/sqlite3_writer.hpp"
 
 using namespace knight::sqlite;
 
@@ -80,6 +83,32 @@ TEST(Database, TempTableInMemory) {
     }
 }
 
+TEST(Database, BackupAndRestore) {
+    (void)remove(DBName);
+    {
+        CreateMemoryDB;
+        EXPECT_EQ(0, db.execute(CreateTableDefaultSql));
+        EXPECT_EQ(1, db.execute(InsertDefaultTableWithValue("first")));
+        db.backup_to(DBName);
+    }
+    {
+        CreateMemoryDB;
+        db.restore_from(DBName);
+        ASSERT_TRUE(db.table_exists(TableName));
+        EXPECT_EQ("first",
+                  db.exec_and_get_first("SELECT value FROM " TableName)
+                      .get_as_string());
+    }
+    {
+        // The backup replaces the content of an existing file.
+        CreateMemoryDB;
+        db.backup_to(DBName);
+        const Database reopened = get_rw_and_create_db(DBName);
+        EXPECT_FALSE(reopened.table_exists(TableName));
+    }
+    EXPECT_EQ(0, remove(DBName));
+}
+
 TEST(Database, DBSetBusyTimeout) {
     {
         Database db(MemoryDB);
@@ -113,6 +142,33 @@ TEST(Database, DBSetBusyTimeout) {
     }
 }
 
+TEST(Database, OpenOptionsProfiles) {
+    (void)remove(DBName);
+    {
+        Database db(DBName,
+                    OpenMode::READWRITE | OpenMode::CREATE,
+                    0,
+                    OpenOptions::bulk_load());
+        EXPECT_EQ("wal",
+                  db.exec_and_get_first("PRAGMA journal_mode").get_as_string());
+        EXPECT_EQ(0, db.exec_and_get_first("PRAGMA synchronous").get_as_int());
+        EXPECT_EQ(2, db.exec_and_get_first("PRAGMA temp_store").get_as_int());
+        EXPECT_GT(0, db.exec_and_get_first("PRAGMA cache_size").get_as_int());
+    }
+    {
+        Database db(DBName,
+                    OpenMode::READWRITE,
+                    0,
+                    OpenOptions::read_mostly());
+        EXPECT_EQ("wal",
+                  db.exec_and_get_first("PRAGMA journal_mode").get_as_string());
+        EXPECT_EQ(1, db.exec_and_get_first("PRAGMA synchronous").get_as_int());
+    }
+    EXPECT_EQ(0, remove(DBName));
+    (void)remove(DBName "-wal");
+    (void)remove(DBName "-shm");
+}
+
 TEST(Database, DBExecute) {
     CreateMemoryDB;
 
@@ -843,6 +899,125 @@ TEST(Database, PreparedStmtGetColumnByName) {
     EXPECT_EQ(0, query.get_bind_parameter_count());
 }
 
+TEST(Database, PreparedStmtTypedRows) {
+    CreateMemoryDB;
+    EXPECT_EQ(0,
+              db.execute("CREATE TABLE " TableName
+                         " (id INTEGER PRIMARY KEY, msg TEXT, double REAL)"));
+    EXPECT_EQ(1,
+              db.execute("INSERT INTO " TableName
+                         " VALUES (NULL, 'first', 0.5)"));
+    EXPECT_EQ(1,
+              db.execute("INSERT INTO " TableName
+                         " VALUES (NULL, NULL, 1.5)"));
+
+    PreparedStmt query(db, "SELECT id, msg, double FROM " TableName);
+    int64_t num_rows = 0;
+    for (const auto& [id, msg, value] :
+         query.rows< int64_t, std::string_view, double >()) {
+        ++num_rows;
+        EXPECT_EQ(num_rows, id);
+        EXPECT_EQ(num_rows == 1 ? "first" : "", msg);
+        EXPECT_DOUBLE_EQ(static_cast< double >(num_rows) - 0.5, value);
+    }
+    EXPECT_EQ(2, num_rows);
+    EXPECT_TRUE(query.does_rows_fetched_done());
+
+    query.reset();
+    EXPECT_TRUE(query.execute_step());
+    auto [id, msg] = query.get_row< int32_t, std::string >();
+    EXPECT_EQ(1, id);
+    EXPECT_EQ("first", msg);
+    EXPECT_THROW(
+        (void)(query.get_row< int32_t, int32_t, int32_t, int32_t >()),
+        std::runtime_error);
+
+    PreparedStmt insert(db,
+                        "INSERT INTO " TableName
+                        " VALUES (NULL, :msg, :value)");
+    EXPECT_EQ(insert.get_idx(":msg"), insert.get_idx(":msg"));
+    insert.bind(":msg", std::string("third"));
+    insert.bind(":value", 2.5);
+    EXPECT_EQ(1, insert.execute());
+}
+
+TEST(Database, PreparedStmtBindTextView) {
+    CreateMemoryDB;
+    EXPECT_EQ(0, db.execute(CreateTableDefaultSql));
+
+    // The view of a larger buffer is bound as a text of its size.
+    const std::string buffer = "first,second";
+    PreparedStmt insert(db, "INSERT INTO " TableName " VALUES (NULL, ?)");
+    insert.bind_no_copy(1, std::string_view(buffer).substr(0U, 5U));
+    EXPECT_EQ(1, insert.execute());
+
+    PreparedStmt query(db,
+                       "SELECT id FROM " TableName " WHERE value = 'first'");
+    EXPECT_TRUE(query.execute_step());
+    EXPECT_EQ(1, query.get_column(0).get_as_int());
+}
+
+TEST(Database, AsyncWriterGroupCommit) {
+    CreateMemoryDB;
+    EXPECT_EQ(0, db.execute(CreateTableDefaultSql));
+
+    constexpr int NumJobs = 100;
+    {
+        AsyncWriter writer(db, 4U, 8U);
+        for (int i = 0; i < NumJobs; ++i) {
+            writer.push([&db]() {
+                EXPECT_TRUE(db.is_in_transaction());
+                (void)db.execute(InsertDefaultTableWithValue("row"));
+            });
+        }
+        writer.finish();
+    }
+    EXPECT_FALSE(db.is_in_transaction());
+    EXPECT_EQ(NumJobs,
+              db.exec_and_get_first("SELECT COUNT(*) FROM " TableName)
+                  .get_as_int());
+
+    AsyncWriter failing_writer(db);
+    failing_writer.push(
+        [&db]() { (void)db.execute("INSERT INTO unknown VALUES (1)"); });
+    EXPECT_THROW(failing_writer.finish(), std::runtime_error);
+    EXPECT_FALSE(db.is_in_transaction());
+}
+
+TEST(Database, ConnectionPoolReadOnly) {
+    (void)remove(DBName);
+    {
+        auto db = get_rw_and_create_db(DBName);
+        EXPECT_EQ(0, db.execute(CreateTableDefaultSql));
+        EXPECT_EQ(1, db.execute(InsertDefaultTableWithValue("first")));
+    }
+
+    ConnectionPool pool(DBName, 2U);
+    {
+        auto first = pool.acquire();
+        auto second = pool.acquire();
+        auto& stmt = first->get_stmt("SELECT value FROM " TableName
+                                     " WHERE id = ?");
+        stmt.bind(1, 1);
+        ASSERT_TRUE(stmt.execute_step());
+        EXPECT_EQ("first", stmt.get_column(0).get_as_string());
+        EXPECT_THROW((void)second->get_db().execute(
+                         InsertDefaultTableWithValue("second")),
+                     std::runtime_error);
+    }
+    {
+        // The statement is reused, reset and without its bindings.
+        auto conn = pool.acquire();
+        auto& stmt =
+            conn->get_stmt("SELECT value FROM " TableName " WHERE id = ?");
+        EXPECT_FALSE(stmt.execute_step());
+        stmt.reset();
+        stmt.bind(1, 1);
+        EXPECT_TRUE(stmt.execute_step());
+    }
+    EXPECT_EQ(0, remove(DBName));
+}
+
 TEST(Database, PreparedStmtTransaction) {
     CreateMemoryDB;
     EXPECT_EQ(SqliteOK, db.get_error_code());
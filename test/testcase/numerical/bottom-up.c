@@ -0,0 +1,41 @@
+// checker=debug-inspection
+// arg=--bottom-up
+
+// The callees are analyzed first, and the join of their returned values
+// bounds the calls in the callers: a singleton is the returned scalar.
+
+void knight_dump_zval(int);
+void knight_reachable();
+
+int clamp(int x) {
+    if (x < 0) {
+        return 0;
+    }
+    if (x > 10) {
+        return 10;
+    }
+    return x;
+}
+
+int seven(void) {
+    return 7;
+}
+
+void bounded_call(int x) {
+    int c = clamp(x);
+    knight_dump_zval(c);
+    // warning:-1:22:-1:22: [0, 10] [debug-inspection]
+    if (c > 10) {
+        knight_reachable();
+        // warning:-1:9:-1:9: Unreachable [debug-inspection]
+    }
+}
+
+void singleton_call(void) {
+    int s = seven();
+    knight_dump_zval(s);
+    // warning:-1:22:-1:22: 7 [debug-inspection]
+    int t = seven() + clamp(s);
+    knight_dump_zval(t);
+    // warning:-1:22:-1:22: [7, 17] [debug-inspection]
+}
@@ -39,4 +39,20 @@ void bar(int x) {
         knight_dump_zval(x);
         // warning:-1:26:-1:26: [-oo, 0] [debug-inspection]
     }
-}
\ No newline at end of file
+}
+void constant_condition(int x) {
+    if (0) {
+        knight_reachable();
+    } else {
+        knight_reachable();
+        // warning:-1:9:-1:9: Reachable [debug-inspection]
+    }
+    x = 0;
+    if (x) {
+        knight_reachable();
+        // warning:-1:9:-1:9: Unreachable [debug-inspection]
+    } else {
+        knight_reachable();
+        // warning:-1:9:-1:9: Reachable [debug-inspection]
+    }
+}
@@ -0,0 +1,133 @@
+// checker=debug-inspection
+
+// The counting loops of accelerate-loops.c, bounded by the widening then
+// the narrowing instead. The head range is the join of the entry value and
+// the latch one.
+
+void knight_dump_zval(int);
+
+void increasing_lt() {
+    int i = 0;
+    while (i < 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+        i++;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [1, 10] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+}
+
+void increasing_le() {
+    int i = 0;
+    while (i <= 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 10] [debug-inspection]
+        i++;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [1, 11] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 11 [debug-inspection]
+}
+
+void increasing_lt_step() {
+    int i = 0;
+    while (i < 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+        i += 3;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [3, 12] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: [10, 12] [debug-inspection]
+}
+
+void increasing_le_step() {
+    int i = 0;
+    while (i <= 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 10] [debug-inspection]
+        i += 3;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [3, 13] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: [11, 13] [debug-inspection]
+}
+
+void decreasing_gt() {
+    int i = 10;
+    while (i > 0) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [1, 10] [debug-inspection]
+        i--;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 0 [debug-inspection]
+}
+
+void decreasing_ge_step() {
+    int i = 10;
+    while (i >= 0) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 10] [debug-inspection]
+        i -= 2;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [-2, 8] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: [-2, -1] [debug-inspection]
+}
+
+// The `!=` condition only refines the counter at the bound, which the
+// widening crossed.
+void not_equal() {
+    int i = 0;
+    while (i != 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, +oo] [debug-inspection]
+        i++;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [1, +oo] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+}
+
+void variable_bound(int n) {
+    if (n > 100) {
+        return;
+    }
+    int i = 0;
+    while (i < n) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 99] [debug-inspection]
+        i++;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [1, 100] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: [0, 100] [debug-inspection]
+}
+
+// The bound changes over the first iteration, so the loop is not
+// accelerated.
+void modified_bound() {
+    int i = 0;
+    int n = 10;
+    while (i < n) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+        i++;
+        n--;
+        knight_dump_zval(n);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: [0, 10] [debug-inspection]
+}
@@ -0,0 +1,42 @@
+// checker=debug-inspection
+// arg=-Xc
+// arg=-max-call-depth=1
+
+// The direct callees are analyzed at the call sites from the values of the
+// arguments, and their returned values flow back to the callers. The
+// callees of the callees are beyond the call depth.
+
+void knight_dump_zval(int);
+
+int add_one(int x) {
+    return x + 1;
+}
+
+int add_two(int x) {
+    return add_one(x) + 1;
+}
+
+void singleton_argument(void) {
+    int a = add_one(2);
+    knight_dump_zval(a);
+    // warning:-1:22:-1:22: 3 [debug-inspection]
+    int b = add_one(2);
+    knight_dump_zval(b);
+    // warning:-1:22:-1:22: 3 [debug-inspection]
+}
+
+void interval_argument(int x) {
+    if (x >= 0) {
+        if (x <= 4) {
+            int a = add_one(x);
+            knight_dump_zval(a);
+            // warning:-1:30:-1:30: [1, 5] [debug-inspection]
+        }
+    }
+}
+
+void beyond_call_depth(void) {
+    int a = add_two(2);
+    knight_dump_zval(a);
+    // warning:-1:22:-1:22: [-oo, +oo] [debug-inspection]
+}
@@ -0,0 +1,55 @@
+// checker=debug-inspection
+
+void knight_dump_zval(int);
+void knight_reachable();
+
+void lor(int a) {
+    if (a == 1 || a == 2) {
+        knight_dump_zval(a);
+        // warning:-1:26:-1:26: [1, 2] [debug-inspection]
+    } else {
+        knight_dump_zval(a);
+        // warning:-1:26:-1:26: [-oo, +oo] [debug-inspection]
+    }
+}
+
+void lor_vars(int a, int b) {
+    if (a > 0 || b > 0) {
+        knight_reachable();
+        // warning:-1:9:-1:9: Reachable [debug-inspection]
+    } else {
+        knight_dump_zval(a);
+        // warning:-1:26:-1:26: [-oo, 0] [debug-inspection]
+        knight_dump_zval(b);
+        // warning:-1:26:-1:26: [-oo, 0] [debug-inspection]
+    }
+}
+
+void land(int a) {
+    if (a > 10 && a > 15) {
+        knight_dump_zval(a);
+        // warning:-1:26:-1:26: [16, +oo] [debug-inspection]
+    } else {
+        knight_dump_zval(a);
+        // warning:-1:26:-1:26: [-oo, 15] [debug-inspection]
+    }
+}
+
+void land_vars(int a, int b) {
+    if (a > 0 && b > 0) {
+        knight_dump_zval(a);
+        // warning:-1:26:-1:26: [1, +oo] [debug-inspection]
+        knight_dump_zval(b);
+        // warning:-1:26:-1:26: [1, +oo] [debug-inspection]
+    }
+}
+
+void land_infeasible(int a) {
+    if (a > 0 && a < 0) {
+        knight_reachable();
+        // warning:-1:9:-1:9: Unreachable [debug-inspection]
+    } else {
+        knight_reachable();
+        // warning:-1:9:-1:9: Reachable [debug-inspection]
+    }
+}
@@ -0,0 +1,29 @@
+// checker=debug-inspection
+// arg=-zdom=dbm
+
+// The dead variables are dropped at the block exits, the pruning being on
+// by default. The live variables keep the facts implied by the dropped
+// ones, e.g. `y - x <= 2` through `t`.
+
+void knight_dump_zval(int);
+
+void implied_relation(int x) {
+    int t = x + 1;
+    int y = t + 1;
+    if (x < 5) {
+        knight_dump_zval(y);
+        // warning:-1:26:-1:26: [-oo, 6] [debug-inspection]
+    }
+}
+
+void implied_value(int c) {
+    int x = 0;
+    if (c) {
+        int t = 2;
+        x = t + 3;
+    } else {
+        x = 7;
+    }
+    knight_dump_zval(x);
+    // warning:-1:22:-1:22: [5, 7] [debug-inspection]
+}
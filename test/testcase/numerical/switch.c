@@ -0,0 +1,78 @@
+// checker=debug-inspection
+
+void knight_dump_zval(int);
+
+int single_cases(int x) {
+    int r = 0;
+    switch (x) {
+        case 1:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: 1 [debug-inspection]
+            r = 10;
+            break;
+        case 2:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: 2 [debug-inspection]
+            r = 20;
+            break;
+        default:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: [-oo, +oo] [debug-inspection]
+            r = 30;
+            break;
+    }
+    knight_dump_zval(r);
+    // warning:-1:22:-1:22: [10, 30] [debug-inspection]
+    return r;
+}
+
+void case_range(int x) {
+    switch (x) {
+        case 1 ... 5:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: [1, 5] [debug-inspection]
+            break;
+        case 7:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: 7 [debug-inspection]
+            break;
+        default:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: [-oo, +oo] [debug-inspection]
+            break;
+    }
+}
+
+void bounded_default(int x) {
+    if (x < 0 || x > 2) {
+        return;
+    }
+    switch (x) {
+        case 0:
+            break;
+        case 2:
+            break;
+        default:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: 1 [debug-inspection]
+            break;
+    }
+}
+
+void no_default(int x) {
+    if (x < 1 || x > 3) {
+        return;
+    }
+    switch (x) {
+        case 1:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: 1 [debug-inspection]
+            return;
+        case 3:
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: 3 [debug-inspection]
+            return;
+    }
+    knight_dump_zval(x);
+    // warning:-1:22:-1:22: 2 [debug-inspection]
+}
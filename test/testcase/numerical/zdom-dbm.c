@@ -0,0 +1,40 @@
+// checker=debug-inspection
+// arg=-zdom=dbm
+
+// The zones keep the differences `x - y <= c` between the variables.
+
+void knight_dump_zval(int);
+
+void assign(int x) {
+    int y = x + 2;
+    if (x < 5) {
+        knight_dump_zval(x);
+        // warning:-1:26:-1:26: [-oo, 4] [debug-inspection]
+        knight_dump_zval(y);
+        // warning:-1:26:-1:26: [-oo, 6] [debug-inspection]
+    }
+}
+
+void condition(int x, int y) {
+    if (x <= y + 3) {
+        if (y <= 0) {
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: [-oo, 3] [debug-inspection]
+            knight_dump_zval(y);
+            // warning:-1:30:-1:30: [-oo, 0] [debug-inspection]
+        }
+    }
+}
+
+void loop() {
+    int i = 0;
+    int j = 0;
+    while (i < 10) {
+        i++;
+        j++;
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+    knight_dump_zval(j);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+}
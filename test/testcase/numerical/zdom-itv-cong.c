@@ -0,0 +1,42 @@
+// checker=debug-inspection
+// arg=-zdom=itv-cong
+
+// The congruences keep the strides, which tighten the interval bounds.
+
+void knight_dump_zval(int);
+
+void assign(int x) {
+    int y = x * 4 + 1;
+    if (y >= 2) {
+        if (y <= 8) {
+            knight_dump_zval(y);
+            // warning:-1:30:-1:30: 5 [debug-inspection]
+        }
+    }
+}
+
+void condition(int c) {
+    int y;
+    if (c) {
+        y = 2;
+    } else {
+        y = 8;
+    }
+    if (y > 2) {
+        knight_dump_zval(y);
+        // warning:-1:26:-1:26: 8 [debug-inspection]
+    }
+}
+
+void loop() {
+    int i = 0;
+    while (i < 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 8] [debug-inspection]
+        i += 2;
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [2, 10] [debug-inspection]
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+}
@@ -0,0 +1,35 @@
+// checker=debug-inspection
+// arg=-zdom=machine-itv
+
+// The unsigned arithmetic wraps around.
+
+void knight_dump_zval(unsigned int);
+
+void assign(unsigned int x) {
+    if (x == 4294967295U) {
+        unsigned int y = x + 1U;
+        knight_dump_zval(y);
+        // warning:-1:26:-1:26: 0 [debug-inspection]
+    }
+}
+
+void condition(unsigned int x) {
+    if (x >= 4294967290U) {
+        if (x < 4294967295U) {
+            unsigned int y = x + 10U;
+            knight_dump_zval(y);
+            // warning:-1:30:-1:30: [4, 8] [debug-inspection]
+        }
+    }
+}
+
+void loop() {
+    unsigned int i = 0U;
+    while (i < 10U) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+        i++;
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+}
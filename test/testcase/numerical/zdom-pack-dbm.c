@@ -0,0 +1,39 @@
+// checker=debug-inspection
+// arg=-zdom=pack-dbm
+
+// The variables related by an assignment or a condition share a zone,
+// the other ones are intervals.
+
+void knight_dump_zval(int);
+
+void assign(int x) {
+    int y = x + 2;
+    if (x < 5) {
+        knight_dump_zval(x);
+        // warning:-1:26:-1:26: [-oo, 4] [debug-inspection]
+        knight_dump_zval(y);
+        // warning:-1:26:-1:26: [-oo, 6] [debug-inspection]
+    }
+}
+
+void condition(int x, int y) {
+    if (x <= y + 3) {
+        if (y <= 0) {
+            knight_dump_zval(x);
+            // warning:-1:30:-1:30: [-oo, 3] [debug-inspection]
+            knight_dump_zval(y);
+            // warning:-1:30:-1:30: [-oo, 0] [debug-inspection]
+        }
+    }
+}
+
+void loop() {
+    int i = 0;
+    while (i < 10) {
+        knight_dump_zval(i);
+        // warning:-1:26:-1:26: [0, 9] [debug-inspection]
+        i++;
+    }
+    knight_dump_zval(i);
+    // warning:-1:22:-1:22: 10 [debug-inspection]
+}
@@ -0,0 +1,51 @@
+// checker=debug-inspection
+// arg=-Xc
+// arg=-alias-classes
+
+// The alias classes unify the two sides of the assignments, so that the
+// pointers to unrelated locals stay apart, and the locations out of the
+// function or passed to a callee are in the external class.
+
+int knight_may_alias(const void*, const void*) __attribute__((pure));
+void escape(int*);
+
+void distinct(void) {
+    int a = 0;
+    int b = 0;
+    int* p = &a;
+    int* q = &b;
+    (void)knight_may_alias(p, q);
+    // warning:-1:11:-1:11: NoAlias [debug-inspection]
+}
+
+void copied(int c) {
+    int a = 0;
+    int b = 0;
+    int* p = &a;
+    int* q = &b;
+    if (c) {
+        q = p;
+    }
+    (void)knight_may_alias(p, q);
+    // warning:-1:11:-1:11: MayAlias [debug-inspection]
+}
+
+void params(int* p, int* q) {
+    (void)knight_may_alias(p, q);
+    // warning:-1:11:-1:11: MayAlias [debug-inspection]
+}
+
+void param_and_local(int* p) {
+    int a = 0;
+    int* q = &a;
+    (void)knight_may_alias(p, q);
+    // warning:-1:11:-1:11: NoAlias [debug-inspection]
+}
+
+void escaped(int* p) {
+    int a = 0;
+    int* q = &a;
+    escape(q);
+    (void)knight_may_alias(p, q);
+    // warning:-1:11:-1:11: MayAlias [debug-inspection]
+}